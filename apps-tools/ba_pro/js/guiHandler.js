@@ -179,6 +179,13 @@ var logic1Click = function(event){
 }
 
 
+//Logic button 2 set (multi-tone)
+var logic2Click = function(event){
+	CLIENT.parametersCache["BA_LOGIC_MODE"] = { value: 2 };
+	CLIENT.sendParameters();
+}
+
+
 //Gain button 0 set
 var gain0Click = function(event){
 	CLIENT.parametersCache["BA_IN_GAIN"] = { value: 0 };
@@ -255,6 +262,7 @@ clickCallbacks["BA_SCALE0"] = scale0Click;
 clickCallbacks["BA_SCALE1"] = scale1Click;
 clickCallbacks["BA_LOGIC_MODE0"] = logic0Click;
 clickCallbacks["BA_LOGIC_MODE1"] = logic1Click;
+clickCallbacks["BA_LOGIC_MODE2"] = logic2Click;
 clickCallbacks["calib_btn"] = calibrateClick;
 clickCallbacks["calib_reset_btn"] = calibrateResetClick;
 clickCallbacks["BA_IN_GAIN"] = gain0Click;
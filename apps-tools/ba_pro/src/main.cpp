@@ -450,48 +450,62 @@ void updateParametersByConfig() {
     CDataManager::GetInstance()->SendAllParams();
 }
 
-void threadLoop() {
-    g_exit_flag = false;
-    rp_ba_buffer_t buffer(ADC_BUFFER_SIZE);
-    int cur_step = 0;
+// Runs a whole sweep, returns false if it was interrupted by the user
+auto runSweep(int process_status, bool calib, const rp_ba_sweep_settings_t& settings, float start_freq, float end_freq, int steps) -> bool {
+    auto freqs = rpApp_BaSweepFrequencies(start_freq, end_freq, steps, ba_scale.NewValue());
+    uint32_t done = 0;
+    float points_per_sec = 0;
+    auto callback = [&](const rp_ba_sweep_point_t& point) -> bool {
+        ba_current_step.SendValue(point.index + 1);
+        ba_current_freq.SendValue(point.freq);
 
-    int avaraging = 0;
+        std::lock_guard lock(g_signalMutex);
+        if (calib) {
+            rpApp_BaWriteCalib(point.freq, point.amplitude, point.phase);
+        }
+        signal.push_back(rpApp_BaCalibGain(point.freq, point.amplitude));
+        phase.push_back(rpApp_BaCalibPhase(point.freq, point.phase));
+        bad_signal.push_back(point.status != RP_OK ? 1 : 0);
+        g_request_show = true;
+        done++;
+        return !g_exit_flag && ba_status.Value() == process_status;
+    };
+    auto ret = rpApp_BaSweep(settings, freqs, callback, &points_per_sec);
+    if (ret != RP_OK) {
+        ERROR_LOG("Sweep stopped at point %u: %d", done, ret);
+    }
+    TRACE_SHORT("Sweep %u of %d points, %f points/s", done, steps, points_per_sec);
+    return !g_exit_flag && ba_status.Value() == process_status;
+}
 
-    float start_freq = 0;
-    float end_freq = 0;
-    float steps = 0;
-    float threshold = 0;
-    float per_number = 0;
-    float gen_ampl = 0;
-    float dc_bias = 0;
-    float probe = 0;
-    rp_ba_logic_t logic_mode = RP_BA_LOGIC_TRAP;
+void threadLoop() {
+    g_exit_flag = false;
+    rp_ba_sweep_settings_t settings;
 
     while (!g_exit_flag) {
         usleep(100);
 
         int status = ba_status.Value();
         // user start calibration
-        if (status == BA_START_CALIB || status == BA_START_CALIB_PROCESS) {
-            if (status == BA_START_CALIB) {
-                bode_ResetCalib();
+        if (status == BA_START_CALIB) {
+            bode_ResetCalib();
+            float start_freq = 100;
+            float end_freq = getMaxADC();
+            int steps = 500;
+            {
                 std::lock_guard lock(g_signalMutex);
                 signal.clear();
                 phase.clear();
                 bad_signal.clear();
                 signal_parameters.clear();
-                cur_step = 0;
-
-                avaraging = 1;
-                start_freq = 100;
-                end_freq = getMaxADC();
-                steps = 500;
-                threshold = ba_input_threshold.Value();
-                logic_mode = (rp_ba_logic_t)ba_logic_mode.Value();
-                per_number = ba_periods_number.Value();
-                gen_ampl = ba_amplitude.Value();
-                dc_bias = ba_dc_bias.Value();
-                probe = inProbe.Value();
+
+                settings.averaging = 1;
+                settings.input_threshold = ba_input_threshold.Value();
+                settings.mode = (rp_ba_logic_t)ba_logic_mode.Value();
+                settings.periods = ba_periods_number.Value();
+                settings.amplitude = ba_amplitude.Value();
+                settings.dc_bias = ba_dc_bias.Value();
+                settings.probe = inProbe.Value();
                 signal_parameters.push_back(start_freq);
                 signal_parameters.push_back(end_freq);
                 signal_parameters.push_back(steps);
@@ -508,91 +522,31 @@ void threadLoop() {
                 g_request_show = true;
             }
 
-            if (cur_step < steps) {
-
-                float amplitude = 0, phase_out = 0;
-                float current_freq = 0.;
-                float freq_step = 0;
-                float next_freq = 0.;
-                bool low_signal = false;
-
-                if (ba_scale.NewValue()) {
-                    // Log
-                    auto a = log10f(start_freq);
-                    auto b = log10f(end_freq);
-                    auto c = (b - a) / (steps - 1);
-
-                    current_freq = pow(10.f, c * cur_step + a);
-                    next_freq = pow(10.f, c * (cur_step + 1) + a);
-                } else {
-                    // Linear
-                    freq_step = (end_freq - start_freq) / (steps - 1);
-                    current_freq = start_freq + freq_step * cur_step;
-                    next_freq = start_freq + freq_step * (cur_step - 1);
-                }
-
-                for (int i = 0; i < avaraging; ++i) {
-                    float ampl_step = 0;
-                    float phase_step = 0;
-                    rpApp_BaSafeThreadAcqPrepare();
-                    auto ret = rpApp_BaGetAmplPhase(logic_mode, gen_ampl, dc_bias, per_number, buffer, &ampl_step, &phase_step, current_freq, probe, threshold);
-                    if (ret == RP_EOOR) {  // isnan && isinf
-                        low_signal = true;
-                        ampl_step = 0;
-                        phase_step = 0;
-                    }
-                    if (ret == RP_EIPV) {
-                        low_signal = true;
-                    }
-
-                    amplitude += ampl_step;
-                    phase_out += phase_step;
-                }
-
-                amplitude /= (int)avaraging;
-                phase_out /= (int)avaraging;
-
-                cur_step++;
-                ba_current_step.SendValue(cur_step);
-                ba_current_freq.SendValue(current_freq);
-
-                std::lock_guard lock(g_signalMutex);
-                rpApp_BaWriteCalib(current_freq, amplitude, phase_out);
-                signal.push_back(rpApp_BaCalibGain(next_freq, amplitude));
-                phase.push_back(rpApp_BaCalibPhase(next_freq, phase_out));
-
-                if (low_signal) {
-                    bad_signal.push_back(1);
-                } else {
-                    bad_signal.push_back(0);
-                }
-                g_request_show = true;
-            } else {
+            if (runSweep(BA_START_CALIB_PROCESS, true, settings, start_freq, end_freq, steps)) {
                 rpApp_BaReadCalibration();
                 ba_calibrate_enable.SendValue(rpApp_BaGetCalibStatus());
                 ba_status.SendValue(BA_START_CALIB_DONE);
             }
         }
 
-        if (status == BA_START || status == BA_START_PROCESS) {
-            if (status == BA_START) {
+        if (status == BA_START) {
+            float start_freq = ba_start_freq.Value();
+            float end_freq = ba_end_freq.Value();
+            int steps = ba_steps.Value();
+            {
                 std::lock_guard lock(g_signalMutex);
                 signal.clear();
                 phase.clear();
                 bad_signal.clear();
                 signal_parameters.clear();
-                cur_step = 0;
-
-                avaraging = ba_averaging.Value();
-                start_freq = ba_start_freq.Value();
-                end_freq = ba_end_freq.Value();
-                steps = ba_steps.Value();
-                threshold = ba_input_threshold.Value();
-                logic_mode = (rp_ba_logic_t)ba_logic_mode.Value();
-                per_number = ba_periods_number.Value();
-                gen_ampl = ba_amplitude.Value();
-                dc_bias = ba_dc_bias.Value();
-                probe = inProbe.Value();
+
+                settings.averaging = ba_averaging.Value();
+                settings.input_threshold = ba_input_threshold.Value();
+                settings.mode = (rp_ba_logic_t)ba_logic_mode.Value();
+                settings.periods = ba_periods_number.Value();
+                settings.amplitude = ba_amplitude.Value();
+                settings.dc_bias = ba_dc_bias.Value();
+                settings.probe = inProbe.Value();
 
                 signal_parameters.push_back(start_freq);
                 signal_parameters.push_back(end_freq);
@@ -611,71 +565,11 @@ void threadLoop() {
                 ba_status.SendValue(BA_START_PROCESS);
                 TRACE_SHORT("start_freq %f", start_freq);
                 TRACE_SHORT("end_freq %f", end_freq);
-                TRACE_SHORT("steps %f", steps);
+                TRACE_SHORT("steps %d", steps);
                 g_request_show = true;
             }
 
-            if (cur_step < (int)steps) {
-
-                float amplitude = 0, phase_out = 0;
-                float current_freq = 0.;
-                float freq_step = 0;
-                float next_freq = 0.;
-                bool low_signal = false;
-
-                if (ba_scale.NewValue()) {
-                    // Log
-                    auto a = log10f(start_freq);
-                    auto b = log10f(end_freq);
-                    auto c = (b - a) / (steps - 1);
-
-                    current_freq = pow(10.f, c * cur_step + a);
-                    next_freq = pow(10.f, c * (cur_step + 1) + a);
-                } else {
-                    // Linear
-                    freq_step = (end_freq - start_freq) / (steps - 1);
-                    current_freq = start_freq + freq_step * cur_step;
-                    next_freq = start_freq + freq_step * (cur_step - 1);
-                }
-
-                for (int i = 0; i < avaraging; ++i) {
-                    float ampl_step = 0;
-                    float phase_step = 0;
-                    rpApp_BaSafeThreadAcqPrepare();
-                    auto ret = rpApp_BaGetAmplPhase(logic_mode, gen_ampl, dc_bias, per_number, buffer, &ampl_step, &phase_step, current_freq, probe, threshold);
-                    if (ret == RP_EOOR) {  // isnan && isinf
-                        low_signal = true;
-                        ampl_step = 0;
-                        phase_step = 0;
-                    }
-
-                    if (ret == RP_EIPV) {
-                        low_signal = true;
-                    }
-
-                    amplitude += ampl_step;
-                    phase_out += phase_step;
-                }
-
-                amplitude /= (int)avaraging;
-                phase_out /= (int)avaraging;
-
-                cur_step++;
-                ba_current_step.SendValue(cur_step);
-                ba_current_freq.SendValue(current_freq);
-
-                std::lock_guard lock(g_signalMutex);
-
-                signal.push_back(rpApp_BaCalibGain(next_freq, amplitude));
-                phase.push_back(rpApp_BaCalibPhase(next_freq, phase_out));
-
-                if (low_signal) {
-                    bad_signal.push_back(1);
-                } else {
-                    bad_signal.push_back(0);
-                }
-                g_request_show = true;
-            } else {
+            if (runSweep(BA_START_PROCESS, false, settings, start_freq, end_freq, steps)) {
                 ba_status.SendValue(BA_START_DONE);
             }
         }
@@ -3,6 +3,7 @@
 #include <CustomParameters.h>
 #include <DataManager.h>
 #include <stdlib.h>
+#include <chrono>
 #include <ctime>
 #include <fstream>
 
@@ -36,12 +37,19 @@ using namespace rp_calib;
 CFilter_logic::Ptr g_filter_logic = nullptr;
 CFilter_logicNch::Ptr g_filter_logicNch = nullptr;
 int g_sub_progress = 0;
+std::chrono::steady_clock::time_point g_filter_start;
 
 COscilloscope::Ptr g_acq = nullptr;
 CCalib::Ptr g_calib = nullptr;
 CCalibMan::Ptr g_calib_man = nullptr;
 std::mutex g_mtx;
 
+// Logs the duration of the AA and BB search of the filter calibration
+void logFilterTime() {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - g_filter_start).count();
+    WARNING("Filter AA/BB calibration time %lld ms", (long long)ms);
+}
+
 //#define DEBUG_MODE
 
 #define DAC_DEVIDER getDACDevider()
@@ -471,6 +479,7 @@ void calibFilter() {
     */
     if (filt_calib_step.Value() == 1) {
         g_filter_logic->init((rp_channel_t)adc_channel.Value());
+        g_filter_start = std::chrono::steady_clock::now();
 
         if (getDACChannels() >= 2) {
             g_calib_man->setOffset(RP_CH_1, 0);
@@ -500,9 +509,10 @@ void calibFilter() {
                 g_filter_logic->setCalculatedValue(dp);
             }
         }
-        g_filter_logic->removeHalfCalib();
+        g_filter_logic->fitGrid();
         // If there is no longer any possibility to calibrate, then we proceed to the next step.
         if (g_filter_logic->nextSetupCalibParameters() == -1) {
+            logFilterTime();
             filt_calib_step.SendValue(3);
             return;
         }
@@ -574,6 +584,7 @@ int calibAutoFilter() {
         g_sub_progress = 0;
         g_calib_man->initSq(8);
         g_filter_logicNch->init();
+        g_filter_start = std::chrono::steady_clock::now();
         if (getDACChannels() >= 2) {
             g_calib_man->setOffset(RP_CH_1, 0);
             g_calib_man->setFreq(RP_CH_1, 1000);
@@ -620,8 +631,9 @@ int calibAutoFilter() {
                 auto dp = g_acq->getDataAutoFilterSync();
                 g_filter_logicNch->setCalculatedValue(dp);
             }
-            g_filter_logicNch->removeHalfCalib();
+            g_filter_logicNch->fitGrid();
             if (g_filter_logicNch->nextSetupCalibParameters() == -1) {
+                logFilterTime();
                 g_sub_progress = 2;
                 return 1;
             }
@@ -729,6 +741,7 @@ int calibAutoFilter() {
         g_sub_progress = 0;
         g_calib_man->setModeLV_HV(RP_HIGH);
         g_filter_logicNch->init();
+        g_filter_start = std::chrono::steady_clock::now();
 
         if (getDACChannels() > 0) {
             g_calib_man->setOffset(RP_CH_1, 0);
@@ -778,8 +791,9 @@ int calibAutoFilter() {
                 auto dp = g_acq->getDataAutoFilterSync();
                 g_filter_logicNch->setCalculatedValue(dp);
             }
-            g_filter_logicNch->removeHalfCalib();
+            g_filter_logicNch->fitGrid();
             if (g_filter_logicNch->nextSetupCalibParameters() == -1) {
+                logFilterTime();
                 g_sub_progress = 2;
                 return 1;
             }
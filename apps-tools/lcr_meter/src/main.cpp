@@ -74,6 +74,11 @@ CIntParameter secDisplay("LCR_SEC_DISP", CBaseParameter::RW, 0, 0, 0, 3, CONFIG_
 
 CIntParameter logInterval("LOG_INTERVAL", CBaseParameter::RW, 100, 0, 0, 30000000, CONFIG_VAR);
 
+// Continuous lock-in mode
+CBooleanParameter lockIn("LCR_LOCKIN", CBaseParameter::RW, false, 0, CONFIG_VAR);
+CDoubleParameter lockInTimeConstant("LCR_LOCKIN_TC", CBaseParameter::RW, 0.1, 0, 0, 100, CONFIG_VAR);
+CDoubleParameter lockInRate("LCR_LOCKIN_RATE", CBaseParameter::RW, 10, 0, 0.1, 1000, CONFIG_VAR);
+
 CBooleanParameter moduleStatus("LCR_EXTMODULE_STATUS", CBaseParameter::RW, true, 0);
 
 CIntParameter controlSettings("CONTROL_CONFIG_SETTINGS", CBaseParameter::RW, 0, 0, 0, 10);
@@ -390,6 +395,21 @@ void updateFromFront(bool force) {
     if (IS_NEW(logInterval) || force) {
         logInterval.Update();
     }
+
+    if (IS_NEW(lockInTimeConstant) || force) {
+        lcrApp_LcrSetLockInTimeConstant(lockInTimeConstant.NewValue());
+        lockInTimeConstant.Update();
+    }
+
+    if (IS_NEW(lockInRate) || force) {
+        lcrApp_LcrSetLockInRate(lockInRate.NewValue());
+        lockInRate.Update();
+    }
+
+    if (IS_NEW(lockIn) || force) {
+        lcrApp_LcrSetLockIn(lockIn.NewValue());
+        lockIn.Update();
+    }
 }
 
 void OnNewParams(void) {
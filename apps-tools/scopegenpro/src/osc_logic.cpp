@@ -76,6 +76,7 @@ CIntParameter inFilter[MAX_ADC_CHANNELS] = INIT("OSC_CH", "_IN_FILTER", CBasePar
 CIntParameter inAC_DC[MAX_ADC_CHANNELS] = INIT("OSC_CH", "_IN_AC_DC", CBaseParameter::RW, RP_DC, 0, RP_DC, RP_AC, CONFIG_VAR);
 
 CIntParameter inSmoothMode[MAX_ADC_CHANNELS] = INIT("OSC_CH", "_SMOOTH", CBaseParameter::RW, rpApp_osc_interpolationMode::DISABLED, 0, 0, 4, CONFIG_VAR);
+CBooleanParameter inPeakDetect[MAX_ADC_CHANNELS] = INIT("OSC_CH", "_PEAK_DETECT", CBaseParameter::RW, false, 0, CONFIG_VAR);
 
 /* --------------------------------  TRIGGER PARAMETERS --------------------------- */
 CFloatParameter inTriggLevel("OSC_TRIG_LEVEL", CBaseParameter::RW, 0, 0, -20, 20, CONFIG_VAR);
@@ -653,6 +654,7 @@ auto updateOscParams(bool force) -> void {
         IF_VALUE_CHANGED_FORCE(inProbe[i], rpApp_OscSetProbeAtt((rp_channel_t)i, inProbe[i].NewValue()), force)
 
         IF_VALUE_CHANGED_FORCE(inSmoothMode[i], rpApp_OscSetSmoothMode((rp_channel_t)i, (rpApp_osc_interpolationMode)inSmoothMode[i].NewValue()), force)
+        IF_VALUE_CHANGED_FORCE(inPeakDetect[i], rpApp_OscSetPeakDetect((rp_channel_t)i, inPeakDetect[i].NewValue()), force)
 
         if (rp_HPGetFastADCIsAC_DCOrDefault()) {
             IF_VALUE_CHANGED_FORCE(inAC_DC[i], rp_AcqSetAC_DC((rp_channel_t)i, (rp_acq_ac_dc_mode_t)inAC_DC[i].NewValue()), force)
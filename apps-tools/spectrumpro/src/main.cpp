@@ -1,4 +1,5 @@
 #include "main.h"
+#include <algorithm>
 #include <array>
 #include "common.h"
 #include "common/profiler.h"
@@ -65,6 +66,18 @@ CBooleanParameter cursory[CURSORS_COUNT] = INIT2("SPEC_CURSOR_Y", "", CBaseParam
 CFloatParameter cursorV[CURSORS_COUNT] = INIT2("SPEC_CUR", "_V", CBaseParameter::RW, 0.25, 0, 0, 1, CONFIG_VAR);
 CFloatParameter cursorT[CURSORS_COUNT] = INIT2("SPEC_CUR", "_T", CBaseParameter::RW, 0.25, 0, 0, 1, CONFIG_VAR);
 
+/* --------------------------------  WATERFALL  ---------------------------- */
+// Continuous spectrogram on the AXI capture. The spectrum worker is stopped while it runs.
+CBooleanParameter waterfallRun("SPEC_WATERFALL_RUN", CBaseParameter::RW, false, 0);
+CIntParameter waterfallOverlap("SPEC_WATERFALL_OVERLAP", CBaseParameter::RW, 50, 0, 0, 95, CONFIG_VAR);
+CIntParameter waterfallDepth("SPEC_WATERFALL_DEPTH", CBaseParameter::RW, 256, 0, 16, 4096, CONFIG_VAR);
+CFloatParameter waterfallRTBW("SPEC_WATERFALL_RTBW", CBaseParameter::RO, 0, 0, 0, 1e9);
+CFloatParameter waterfallBinWidth("SPEC_WATERFALL_BIN_WIDTH", CBaseParameter::RO, 0, 0, 0, 1e9);
+CIntParameter waterfallDropped("SPEC_WATERFALL_DROPPED", CBaseParameter::RO, 0, 0, 0, INT32_MAX);
+CCustomBinarySignal<rp_dsp_api::cdsp_data_t> s_waterfall[MAX_ADC_CHANNELS] = INIT("ch", "_waterfall", 0, 0.0f);
+CCustomBinarySignal<uint32_t> s_waterfall_frames("waterfall_frames", 0, 0);
+static uint64_t g_waterfall_next = 0;
+
 CBooleanParameter pllControlEnable("EXT_CLOCK_ENABLE", CBaseParameter::RW, 0, 0, CONFIG_VAR);
 CIntParameter pllControlLocked("EXT_CLOCK_LOCKED", CBaseParameter::RW, 0, 0, 0, 1);
 
@@ -89,6 +102,66 @@ const std::vector<std::string> g_savedParams = {"CH1_IN_GAIN",
 
 rp_websocket::CWEBServer data_server;
 
+auto startWaterfall() -> bool {
+    rpApp_SpecStop();
+    for (auto ch = 0u; ch < g_adc_count; ch++) {
+        rpApp_SpecGramSetEnable((rp_channel_t)ch, inShow[ch].Value());
+    }
+    rpApp_SpecGramSetFFTSize(bufferSize.Value());
+    rpApp_SpecGramSetWindow((rp_dsp_api::window_mode_t)windowMode.Value());
+    rpApp_SpecGramSetOverlap(waterfallOverlap.Value() / 100.0f);
+    rpApp_SpecGramSetHistoryDepth(waterfallDepth.Value());
+    g_waterfall_next = 0;
+    return rpApp_SpecGramRun() == RP_OK;
+}
+
+auto stopWaterfall() -> void {
+    rpApp_SpecGramStop();
+    // The spectrum worker starts again with default settings
+    rpApp_SpecRun();
+    for (auto ch = 0u; ch < g_adc_count; ch++) {
+        rpApp_SpecSetProbe((rp_channel_t)ch, inProbe[ch].Value());
+        rpApp_SpecSetEnable((rp_channel_t)ch, inShow[ch].Value());
+    }
+    rpApp_SpecSetImpedance(impedance.Value());
+    rpApp_SpecSetWindow((rp_dsp_api::window_mode_t)windowMode.Value());
+    rpApp_SpecSetRemoveDC(cutDC.Value());
+    rpApp_SpecSetADCBufferSize(bufferSize.Value());
+    rpApp_SpecSetFreqMax(xmax.Value());
+}
+
+// Sends the rows that were added since the last update
+auto updateWaterfall() -> void {
+    std::vector<float> rows;
+    std::vector<uint64_t> frames;
+    std::vector<uint64_t> ch_frames;
+    bool first = true;
+    uint32_t bins = 0;
+    rpApp_SpecGramGetBins(&bins);
+    for (auto ch = 0u; ch < g_adc_count; ch++) {
+        if (!inShow[ch].Value()) {
+            if (s_waterfall[ch].GetSize())
+                s_waterfall[ch].Resize(0);
+            continue;
+        }
+        rpApp_SpecGramGetHistory((rp_channel_t)ch, g_waterfall_next, &rows, &ch_frames);
+        if (first) {
+            frames = ch_frames;
+            first = false;
+        }
+        // Rows finished while the previous channels were read are sent next time
+        rows.resize(std::min<size_t>(rows.size(), frames.size() * bins));
+        s_waterfall[ch].Set(rows);
+    }
+    if (frames.empty())
+        return;
+    s_waterfall_frames.Resize(frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        s_waterfall_frames[i] = frames[i];
+    }
+    g_waterfall_next = frames.back() + 1;
+}
+
 void UpdateParams(void) {
     inRun.Update();
 
@@ -102,6 +175,15 @@ void UpdateParams(void) {
     if (adc / buf != rbw.Value())
         rbw.SendValue(adc / buf);
 
+    if (rpApp_SpecGramRunning()) {
+        rpApp_specgram_stats_t stats;
+        if (rpApp_SpecGramGetStats(&stats) == RP_OK) {
+            waterfallRTBW.SendValue(stats.realtime_bw);
+            waterfallBinWidth.SendValue(stats.bin_width);
+            waterfallDropped.SendValue(std::min<uint64_t>(stats.dropped, INT32_MAX));
+        }
+    }
+
     updateGen();
 }
 
@@ -112,6 +194,11 @@ void UpdateBinarySignals(void) {
         return;
     }
 
+    if (rpApp_SpecGramRunning()) {
+        updateWaterfall();
+        return;
+    }
+
     auto mode = y_axis_mode.Value();
 
     const rp_dsp_api::rp_dsp_result_t* data = nullptr;
@@ -251,6 +338,33 @@ void OnNewParams(void) {
         }
     }
 
+    if (waterfallOverlap.IsNewValue()) {
+        waterfallOverlap.Update();
+        if (rpApp_SpecGramRunning())
+            rpApp_SpecGramSetOverlap(waterfallOverlap.Value() / 100.0f);
+        // The capture restarts, so the frame numbers start from zero
+        g_waterfall_next = 0;
+    }
+
+    if (waterfallDepth.IsNewValue()) {
+        waterfallDepth.Update();
+        if (rpApp_SpecGramRunning())
+            rpApp_SpecGramSetHistoryDepth(waterfallDepth.Value());
+        g_waterfall_next = 0;
+    }
+
+    if (waterfallRun.IsNewValue()) {
+        waterfallRun.Update();
+        if (waterfallRun.Value() && !rpApp_SpecGramRunning()) {
+            if (!startWaterfall()) {
+                stopWaterfall();
+                waterfallRun.SendValue(false);
+            }
+        } else if (!waterfallRun.Value() && rpApp_SpecGramRunning()) {
+            stopWaterfall();
+        }
+    }
+
     if (requestFullData.IsNewValue()) {
         requestFullData.Update();
     }
@@ -403,6 +517,7 @@ extern "C" int rp_app_init(void) {
 
 extern "C" int rp_app_exit(void) {
     fprintf(stderr, "Unloading spectrum version %s-%s.\n", VERSION_STR, REVISION_STR);
+    rpApp_SpecGramStop();
     rpApp_SpecStop();
     if (rp_HPGetIsPLLControlEnableOrDefault())
         rp_SetPllControlEnable(false);
@@ -5,10 +5,20 @@
 #include "data_lib/buffer.h"
 #include "logger_lib/file_logger.h"
 #include "streaming_lib/streaming_file.h"
+#include "writer_lib/bin_overview.h"
 
 using namespace converter_lib;
 using namespace streaming_lib;
 
+// Jumps over the segments before start_seg using the overview file of the capture
+static auto seekToSegment(const std::string& _file_name, int32_t start_seg, int64_t* position, int32_t* curSegment) -> void {
+    std::vector<CBinOverview::Segment> segments;
+    if (start_seg > 1 && CBinOverview::readSegments(_file_name, &segments) && (size_t)start_seg <= segments.size()) {
+        *position = segments[start_seg - 1].offset;
+        *curSegment = start_seg - 1;
+    }
+}
+
 auto CConverter::create() -> CConverter::Ptr {
     return std::make_shared<CConverter>();
 }
@@ -69,6 +79,7 @@ bool CConverter::convertToCSV(std::string _file_name, int32_t start_seg, int32_t
             uint64_t samplePos = 0;
             int channels = 0;
             start_seg = std::max(start_seg, 1);
+            seekToSegment(_file_name, start_seg, &position, &curSegment);
             while (position >= 0) {
                 auto freeSize = getFreeSpaceDisk(csv_file);
                 if (freeSize <= USING_FREE_SPACE) {
@@ -173,6 +184,7 @@ bool CConverter::convertToWAV(std::string _file_name, int32_t start_seg, int32_t
             int64_t position = 0;
             int32_t curSegment = 0;
             start_seg = std::max(start_seg, 1);
+            seekToSegment(_file_name, start_seg, &position, &curSegment);
             while (position >= 0) {
                 if (m_stopWriteWAV) {
                     aprintf(stdout, "%s Abort writing to WAV file\n", _prefix.c_str());
@@ -282,6 +294,7 @@ bool CConverter::convertToTDMS(std::string _file_name, int32_t start_seg, int32_
             int64_t position = 0;
             int32_t curSegment = 0;
             start_seg = std::max(start_seg, 1);
+            seekToSegment(_file_name, start_seg, &position, &curSegment);
             while (position >= 0) {
                 if (m_stopWriteWAV) {
                     aprintf(stdout, "%s Abort writing to TDMS file\n", _prefix.c_str());
@@ -4,7 +4,7 @@
 using namespace dac_streaming_lib;
 
 CDACStreamingApplication::CDACStreamingApplication(CDACStreamingManager::Ptr _streamingManager, uio_lib::CGenerator::Ptr _gen)
-    : m_gen(_gen), m_streamingManager(_streamingManager), m_Thread(), mtx(), m_ReadyToPass(0), m_isRun(false), m_isRunNonBloking(false), m_verbMode(false) {}
+    : m_gen(_gen), m_streamingManager(_streamingManager), m_Thread(), mtx(), m_ReadyToPass(0), m_isRun(false), m_isRunNonBloking(false), m_underrunCount(0), m_verbMode(false) {}
 
 CDACStreamingApplication::~CDACStreamingApplication() {
     stop();
@@ -60,6 +60,8 @@ void CDACStreamingApplication::genWorker() {
     DataLib::CDataBuffersPackDMA::Ptr buffer = nullptr;
     bool onePackMode = false;
     bool notRun = true;
+    bool starving = false;
+    m_underrunCount = 0;
     m_gen->stop();
     m_gen->prepare();
     m_GenThreadRun = true;
@@ -68,7 +70,13 @@ void CDACStreamingApplication::genWorker() {
             int64_t repeatInOpenPackMode = 0;
             bool one_pack_inf_mode = false;
             buffer = (!onePackMode || buffer == nullptr) ? m_streamingManager->getBuffer() : buffer;
+            if (!buffer && !notRun && !onePackMode && m_streamingManager->isRunned()) {
+                if (!starving)
+                    m_underrunCount++;
+                starving = true;
+            }
             if (buffer) {
+                starving = false;
                 auto ch1 = buffer->getBuffer(DataLib::EDataBuffersPackChannel::CH1);
                 auto ch2 = buffer->getBuffer(DataLib::EDataBuffersPackChannel::CH2);
                 uint32_t ch1Address = 0;
@@ -135,7 +143,8 @@ void CDACStreamingApplication::genWorker() {
                     if ((value.count() - timeBegin) >= 5000) {
                         auto bufferManager = m_streamingManager->getBufferManager();
                         if (bufferManager) {
-                            aprintf(stdout, "[DAC] Buffer status : %.2f%%\n", bufferManager->fullPercent() * 100.f);
+                            aprintf(stdout, "[DAC] Buffer status : %.2f%% Underruns: %llu\n", bufferManager->fullPercent() * 100.f,
+                                    (unsigned long long)m_underrunCount.load());
                         }
                         timeBegin = value.count();
                     }
@@ -160,4 +169,8 @@ void CDACStreamingApplication::signalHandler(const std::error_code&, int) {
 
 auto CDACStreamingApplication::setVerboseMode(bool mode) -> void {
     m_verbMode = mode;
+}
+
+auto CDACStreamingApplication::getUnderrunCount() -> uint64_t {
+    return m_underrunCount;
 }
\ No newline at end of file
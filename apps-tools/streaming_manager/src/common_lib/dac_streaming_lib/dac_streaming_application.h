@@ -21,6 +21,8 @@ class CDACStreamingApplication {
     auto stop() -> bool;
     auto isRun() -> bool { return m_isRun; }
     auto setVerboseMode(bool mode) -> void;
+    // Number of times the generator found the buffer ring empty while the file reader was still running
+    auto getUnderrunCount() -> uint64_t;
 
    private:
     void genWorker();
@@ -35,6 +37,7 @@ class CDACStreamingApplication {
     std::atomic_int m_ReadyToPass;
     std::atomic_bool m_isRun;
     std::atomic_bool m_isRunNonBloking;
+    std::atomic_uint64_t m_underrunCount;
     bool m_verbMode;
 };
 
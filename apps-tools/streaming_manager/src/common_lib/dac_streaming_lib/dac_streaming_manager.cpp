@@ -247,7 +247,15 @@ auto CDACStreamingManager::threadFunc() -> void {
                 auto pack = m_buffer->writeBuffer(true);
                 if (pack) {
                     CReaderController::Data data;
-                    auto res = m_readerController->getBufferPrepared(data);
+                    // Fill the DMA memory directly, without the intermediate copy
+                    std::array<uint8_t*, MAX_DAC_CHANNELS> dst = {nullptr, nullptr};
+                    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+                        auto dma = pack->getBuffer((DataLib::EDataBuffersPackChannel)idx);
+                        if (dma && dma->getDataLenght() == m_blockSize) {
+                            dst[idx] = (uint8_t*)dma->getMappedDataMemory();
+                        }
+                    }
+                    auto res = m_readerController->getBufferPrepared(data, dst);
                     if (data.size[0] != 0 || data.size[1] != 0) {
                         if (data.size[0] != 0) {
                             auto ch1 = pack->getBuffer(DataLib::CH1);
@@ -257,7 +265,8 @@ auto CDACStreamingManager::threadFunc() -> void {
 							if (ch1->getDataLenght() != data.size[0]) {
 								FATAL("DMA CH1 buffer has diffrent size src: %zu dst: %zu", data.size[0], ch1->getDataLenght())
 							}
-							memcpy(ch1->getMappedDataMemory(), data.ch[0], data.size[0]);
+							if (ch1->getMappedDataMemory() != data.ch[0])
+								memcpy(ch1->getMappedDataMemory(), data.ch[0], data.size[0]);
 							DataLib::setHeaderDAC(ch1, 1, data.real_size[0], onePackMode, repeatCount == -1, repeatCount, data.bits);
                         }
                         if (data.size[1] != 0) {
@@ -268,7 +277,8 @@ auto CDACStreamingManager::threadFunc() -> void {
 							if (ch2->getDataLenght() != data.size[1]) {
 								FATAL("DMA CH2 buffer has diffrent size src: %zu dst: %zu", data.size[1], ch2->getDataLenght())
 							}
-							memcpy(ch2->getMappedDataMemory(), data.ch[1], data.size[1]);
+							if (ch2->getMappedDataMemory() != data.ch[1])
+								memcpy(ch2->getMappedDataMemory(), data.ch[1], data.size[1]);
 							DataLib::setHeaderDAC(ch2, 2, data.real_size[1], onePackMode, repeatCount == -1, repeatCount, data.bits);
 						}
                         m_buffer->unlockBufferWrite();
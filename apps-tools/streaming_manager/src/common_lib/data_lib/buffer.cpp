@@ -34,6 +34,7 @@ CDataBufferDMA::CDataBufferDMA(uint8_t bitsBySample)
       m_channelSizeDAC(0),
       m_timeCapture(0) {
     setLostSamples(EDataLost::FPGA, 0);
+    setLostSamples(EDataLost::NETWORK, 0);
 }
 
 CDataBufferDMA::CDataBufferDMA(uint32_t startAddress, size_t lenght, void* mappedMemory, uint8_t bits)
@@ -55,6 +56,7 @@ CDataBufferDMA::CDataBufferDMA(uint32_t startAddress, size_t lenght, void* mappe
       m_channelSizeDAC(0),
       m_timeCapture(0) {
     setLostSamples(EDataLost::FPGA, 0);
+    setLostSamples(EDataLost::NETWORK, 0);
 }
 
 CDataBufferDMA::CDataBufferDMA(uint8_t* buffer, size_t lenght, uint8_t bits)
@@ -76,6 +78,7 @@ CDataBufferDMA::CDataBufferDMA(uint8_t* buffer, size_t lenght, uint8_t bits)
       m_channelSizeDAC(0),
       m_timeCapture(0) {
     setLostSamples(EDataLost::FPGA, 0);
+    setLostSamples(EDataLost::NETWORK, 0);
 }
 
 CDataBufferDMA::~CDataBufferDMA() {
@@ -88,6 +91,7 @@ CDataBufferDMA::~CDataBufferDMA() {
 
 auto CDataBufferDMA::reset() -> void {
     setLostSamples(EDataLost::FPGA, 0);
+    setLostSamples(EDataLost::NETWORK, 0);
 }
 
 auto CDataBufferDMA::getBuffer() const -> uint32_t {
@@ -155,11 +159,11 @@ auto CDataBufferDMA::getLostSamples(EDataLost mode) const -> uint64_t {
 }
 
 auto CDataBufferDMA::getLostSamplesAll() const -> uint64_t {
-    return getLostSamples(DataLib::FPGA);
+    return getLostSamples(DataLib::FPGA) + getLostSamples(DataLib::NETWORK);
 }
 
 auto CDataBufferDMA::getLostSamplesInBytesLenght() -> uint64_t {
-    auto lost = getLostSamples(DataLib::FPGA);
+    auto lost = getLostSamplesAll();
     return lost * (getBitBySample() / 8);
 }
 
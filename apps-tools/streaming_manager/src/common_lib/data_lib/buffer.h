@@ -7,7 +7,8 @@
 
 namespace DataLib {
 
-enum EDataLost { FPGA = 0 };
+// FPGA: samples the DMA could not store. NETWORK: samples of datagrams that did not reach the client.
+enum EDataLost { FPGA = 0, NETWORK = 1 };
 
 class CDataBufferDMA final {
    public:
@@ -1,5 +1,9 @@
 #include "neon_asm.h"
+#include <stdint.h>
 #include <stdlib.h>
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
 
 void memcpy_neon(__attribute__((unused)) volatile void* dst, __attribute__((unused)) volatile const void* src, __attribute__((unused)) size_t n) noexcept {
 #ifdef ARCH_ARM
@@ -53,3 +57,63 @@ void memcpy_stride_8bit_neon(__attribute__((unused)) volatile void* dst, __attri
     exit(-10);
 #endif
 }
+
+
+template <typename T>
+static void deinterleave_scalar(T* dst, const uint8_t* src, size_t count, size_t stride) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        memcpy(dst + i, src + i * stride, sizeof(T));
+    }
+}
+
+void deinterleave_neon(void* dst, const void* src, size_t count, size_t size, size_t stride) noexcept {
+    auto in = (const uint8_t*)src;
+    auto out = (uint8_t*)dst;
+    if (stride == size) {
+        memcpy_neon(out, in, count * size);
+        return;
+    }
+    size_t done = 0;
+#ifdef ARCH_ARM
+    // A vector load spans whole strides, stride - size bytes past its last sample. At least the last sample is
+    // left to the scalar tail, so src is never read past the last sample (e.g. the end of a mapped file).
+    if (size == 1 && stride == 2) {
+        for (; done + 16 < count; done += 16) {
+            vst1q_u8(out + done, vld2q_u8(in + done * 2).val[0]);
+        }
+    } else if (size == 2 && stride == 4) {
+        for (; done + 8 < count; done += 8) {
+            vst1q_u16((uint16_t*)out + done, vld2q_u16((const uint16_t*)(in + done * 4)).val[0]);
+        }
+    } else if (size == 2 && stride == 8) {
+        for (; done + 8 < count; done += 8) {
+            vst1q_u16((uint16_t*)out + done, vld4q_u16((const uint16_t*)(in + done * 8)).val[0]);
+        }
+    } else if (size == 4 && stride == 8) {
+        for (; done + 4 < count; done += 4) {
+            vst1q_u32((uint32_t*)out + done, vld2q_u32((const uint32_t*)(in + done * 8)).val[0]);
+        }
+    }
+#endif
+    in += done * stride;
+    out += done * size;
+    count -= done;
+    switch (size) {
+        case 1:
+            deinterleave_scalar((uint8_t*)out, in, count, stride);
+            break;
+        case 2:
+            deinterleave_scalar((uint16_t*)out, in, count, stride);
+            break;
+        case 4:
+            deinterleave_scalar((uint32_t*)out, in, count, stride);
+            break;
+        case 8:
+            deinterleave_scalar((uint64_t*)out, in, count, stride);
+            break;
+        default:
+            for (size_t i = 0; i < count; i++) {
+                memcpy(out + i * size, in + i * stride, size);
+            }
+    }
+}
\ No newline at end of file
@@ -5,5 +5,8 @@
 
 void memcpy_neon(volatile void* dst, volatile const void* src, size_t n) noexcept;
 void memcpy_stride_8bit_neon(volatile void* dst, volatile const void* src, size_t n) noexcept;
+// Copies count samples of size bytes, taken every stride bytes from src, to the continuous dst buffer.
+// Reads nothing past the last sample.
+void deinterleave_neon(void* dst, const void* src, size_t count, size_t size, size_t stride) noexcept;
 
 #endif
@@ -3,6 +3,14 @@
 #include <limits>
 #include "data_lib/neon_asm.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#define MIN_BUFFER_SIZE (10 * 1024 * 1024)
+
 using namespace net_lib;
 
 auto net_lib::createBuffer(const char* buffer, size_t size) -> net_buffer {
@@ -30,3 +38,22 @@ auto net_lib::createBuffer(uint64_t size) -> net_buffer {
         ;
     }
 }
+
+auto net_lib::socketBufferSize() -> uint64_t {
+    auto getTotalSystemMemory = []() -> uint64_t {
+#ifndef _WIN32
+        uint64_t pages = sysconf(_SC_PHYS_PAGES);
+        uint64_t page_size = sysconf(_SC_PAGE_SIZE);
+        return pages * page_size;
+#else
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+        GlobalMemoryStatusEx(&status);
+        return status.ullTotalPhys;
+#endif
+    };
+
+    auto totalSize = getTotalSystemMemory();
+    auto calc = totalSize * 0.05;
+    return MIN_BUFFER_SIZE > calc ? MIN_BUFFER_SIZE : calc;
+}
@@ -4,21 +4,38 @@
 #include <stdint.h>
 #include <list>
 #include <memory>
+#include <string>
 
 #define NET_ADC_STREAMING_PORT 18900
 #define NET_CONFIG_PORT 18901
 #define NET_BROADCAST_PORT 18902
 #define NET_DAC_STREAMING_PORT 18903
 
+// Data bytes per UDP datagram. The default fits a 1500 byte MTU, the jumbo size a 9000 byte MTU.
+#define NET_UDP_PAYLOAD 1424
+#define NET_UDP_PAYLOAD_JUMBO 8920
+#define NET_UDP_PAYLOAD_MAX 65000
+
 namespace net_lib {
 
 enum EMode { M_SERVER, M_CLIENT };
 
+enum EProtocol { P_TCP, P_UDP };
+
+struct SNetTransport {
+    EProtocol protocol = P_TCP;
+    std::string multicast = "";           // IPv4 group for UDP. Empty sends to each subscribed client.
+    uint32_t datagram = NET_UDP_PAYLOAD;  // Data bytes per UDP datagram
+    uint8_t ttl = 1;                      // Multicast hops
+};
+
 typedef std::shared_ptr<uint8_t[]> net_buffer;
 typedef std::list<std::pair<net_buffer, size_t>> net_list;
 
 auto createBuffer(const char* buffer, size_t size) -> net_buffer;
 auto createBuffer(uint64_t size) -> net_buffer;
+// Kernel socket buffer for the streaming sockets, 5% of the RAM and at least 10 MB
+auto socketBufferSize() -> uint64_t;
 }  // namespace net_lib
 
 #endif
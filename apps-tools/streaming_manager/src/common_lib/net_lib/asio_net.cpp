@@ -1,24 +1,35 @@
 #include "asio_net.h"
 #include "asio_socket_dma.h"
+#include "asio_socket_udp.h"
 
 using namespace net_lib;
 
-auto CAsioNet::create(net_lib::EMode _mode, std::string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers) -> CAsioNet::Ptr {
-    return std::make_shared<CAsioNet>(_mode, _host, _port, buffers);
+auto CAsioNet::create(net_lib::EMode _mode, std::string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers, SNetTransport _transport)
+    -> CAsioNet::Ptr {
+    return std::make_shared<CAsioNet>(_mode, _host, _port, buffers, _transport);
 }
 
-CAsioNet::CAsioNet(net_lib::EMode _mode, std::string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers)
+CAsioNet::CAsioNet(net_lib::EMode _mode, std::string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers, SNetTransport _transport)
     : m_mode(_mode), m_host(_host), m_port(_port), m_IsRun(false) {
-    m_server = CAsioSocketDMA::create(m_host, m_port, buffers);
+    // Both sockets have the same signals
+    auto connectSocket = [&](auto socket) {
+        socket->connectClientNotify.connect([&](auto& host) { this->clientConnectNotify(host); });
+        socket->connectServerNotify.connect([&](auto& host) { this->serverConnectNotify(host); });
+        socket->disconnectClientNotify.connect([&](auto& host) { this->clientDisconnectNotify(host); });
+        socket->disconnectServerNotify.connect([&](auto& host) { this->serverDisconnectNotify(host); });
+        socket->errorClientNotify.connect([&](auto e) { this->clientErrorNotify(e); });
+        socket->errorServerNotify.connect([&](auto e) { this->serverErrorNotify(e); });
+        socket->recivedNotify.connect([&](auto e, auto b) { this->reciveNotify(e, b); });
+        socket->sendNotify.connect([&](auto e, auto s) { this->sendNotify(e, s); });
+    };
 
-    m_server->connectClientNotify.connect([&](auto& host) { this->clientConnectNotify(host); });
-    m_server->connectServerNotify.connect([&](auto& host) { this->serverConnectNotify(host); });
-    m_server->disconnectClientNotify.connect([&](auto& host) { this->clientDisconnectNotify(host); });
-    m_server->disconnectServerNotify.connect([&](auto& host) { this->serverDisconnectNotify(host); });
-    m_server->errorClientNotify.connect([&](auto e) { this->clientErrorNotify(e); });
-    m_server->errorServerNotify.connect([&](auto e) { this->serverErrorNotify(e); });
-    m_server->recivedNotify.connect([&](auto e, auto b) { this->reciveNotify(e, b); });
-    m_server->sendNotify.connect([&](auto e, auto s) { this->sendNotify(e, s); });
+    if (_transport.protocol == net_lib::EProtocol::P_UDP) {
+        m_udp = CAsioSocketUDP::create(m_host, m_port, buffers, _transport);
+        connectSocket(m_udp);
+    } else {
+        m_server = CAsioSocketDMA::create(m_host, m_port, buffers);
+        connectSocket(m_server);
+    }
 }
 
 CAsioNet::~CAsioNet() {
@@ -26,37 +37,46 @@ CAsioNet::~CAsioNet() {
 }
 
 auto CAsioNet::isConnected() -> bool {
+    if (m_udp)
+        return m_IsRun && m_udp->isConnected();
     return m_IsRun && m_server->isConnected();
 }
 
+auto CAsioNet::getLostDatagrams() -> uint64_t {
+    return m_udp ? m_udp->getLostDatagrams() : 0;
+}
+
 auto CAsioNet::start() -> void {
     if (m_IsRun)
         return;
     if (m_mode == net_lib::EMode::M_SERVER) {
-        m_server->initServer();
+        m_udp ? m_udp->initServer() : m_server->initServer();
     }
     if (m_mode == net_lib::EMode::M_CLIENT) {
-        m_server->initClient();
+        m_udp ? m_udp->initClient() : m_server->initClient();
     }
     m_IsRun = true;
 }
 
 auto CAsioNet::stop() -> void {
     // sendServerStop();
-    m_server->stopReceive();
+    m_udp ? m_udp->stopReceive() : m_server->stopReceive();
     m_IsRun = false;
 }
 
 auto CAsioNet::cancel() -> void {
-    m_server->cancelSocket();
+    m_udp ? m_udp->cancelSocket() : m_server->cancelSocket();
 }
 
 auto CAsioNet::disconnect() -> void {
-    m_server->closeSocket();
+    m_udp ? m_udp->closeSocket() : m_server->closeSocket();
     m_IsRun = false;
 }
 
 auto CAsioNet::sendSyncData(DataLib::CDataBuffersPackDMA::Ptr _buffer) -> bool {
+    if (m_udp) {
+        return m_udp->sendSyncBuffer(_buffer);
+    }
     if (m_server) {
         return m_server->sendSyncBuffer(_buffer);
     }
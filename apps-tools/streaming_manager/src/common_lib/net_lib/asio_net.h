@@ -12,14 +12,15 @@ using namespace std;
 namespace net_lib {
 
 class CAsioSocketDMA;
+class CAsioSocketUDP;
 
 class CAsioNet {
    public:
     using Ptr = shared_ptr<CAsioNet>;
 
-    static auto create(net_lib::EMode _mode, string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers) -> CAsioNet::Ptr;
+    static auto create(net_lib::EMode _mode, string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers, SNetTransport _transport = {}) -> CAsioNet::Ptr;
 
-    CAsioNet(net_lib::EMode _mode, string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers);
+    CAsioNet(net_lib::EMode _mode, string _host, uint16_t _port, DataLib::CBuffersCached::Ptr buffers, SNetTransport _transport = {});
     ~CAsioNet();
 
     auto start() -> void;
@@ -29,6 +30,8 @@ class CAsioNet {
 
     auto sendSyncData(DataLib::CDataBuffersPackDMA::Ptr _buffer) -> bool;
     auto isConnected() -> bool;
+    // Datagrams that did not arrive, UDP client only
+    auto getLostDatagrams() -> uint64_t;
 
     sigslot::signal<string&> serverConnectNotify;
     sigslot::signal<string&> serverDisconnectNotify;
@@ -52,6 +55,7 @@ class CAsioNet {
     uint16_t m_port;
     bool m_IsRun;
     shared_ptr<CAsioSocketDMA> m_server;
+    shared_ptr<CAsioSocketUDP> m_udp;
 };
 
 }  // namespace net_lib
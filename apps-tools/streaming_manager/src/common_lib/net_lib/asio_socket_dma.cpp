@@ -3,8 +3,6 @@
 #include "asio_socket_dma.h"
 #include "logger_lib/file_logger.h"
 
-#define MIN_BUFFER_SIZE (10 * 1024 * 1024)
-
 using namespace net_lib;
 
 auto CAsioSocketDMA::create(std::string host, uint16_t port, CBuffersCached::Ptr buffers) -> CAsioSocketDMA::Ptr {
@@ -19,31 +17,10 @@ CAsioSocketDMA::CAsioSocketDMA(std::string host, uint16_t port, CBuffersCached::
       m_tcp_acceptor(0),
       m_mtx(),
       m_asio(new CAsioService()),
-      m_bufferSize(MIN_BUFFER_SIZE),
+      m_bufferSize(socketBufferSize()),
       m_buffers(buffers),
       m_currentBuffer(nullptr),
-      m_isStopReceive(false) {
-    auto calculateSocketBuffer = []() -> uint64_t {
-        auto getTotalSystemMemory = []() -> uint64_t {
-#ifndef _WIN32
-            uint64_t pages = sysconf(_SC_PHYS_PAGES);
-            uint64_t page_size = sysconf(_SC_PAGE_SIZE);
-            return pages * page_size;
-#else
-            MEMORYSTATUSEX status;
-            status.dwLength = sizeof(status);
-            GlobalMemoryStatusEx(&status);
-            return status.ullTotalPhys;
-#endif
-        };
-
-        auto totalSize = getTotalSystemMemory();
-        auto calc = totalSize * 0.05;
-        return MIN_BUFFER_SIZE > calc ? MIN_BUFFER_SIZE : calc;
-    };
-
-    m_bufferSize = calculateSocketBuffer();
-}
+      m_isStopReceive(false) {}
 
 CAsioSocketDMA::~CAsioSocketDMA() {
     stopReceive();
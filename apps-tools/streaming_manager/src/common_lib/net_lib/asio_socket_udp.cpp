@@ -0,0 +1,479 @@
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+#include "asio_socket_udp.h"
+#include "logger_lib/file_logger.h"
+
+// Clients repeat the subscription every second, the server forgets silent clients after 5 seconds
+#define SUBSCRIBE_INTERVAL_MS 1000
+#define SUBSCRIBE_TIMEOUT_MS 5000
+#define SUBSCRIBE_RETRIES 5
+
+#define MAX_DATAGRAM 65536
+
+// Late datagrams trail the stream by a few packs. A pack id further back means the server restarted and counts from 0 again.
+#define RESTART_PACKS 64
+
+using namespace net_lib;
+
+auto CAsioSocketUDP::create(std::string host, uint16_t port, CBuffersCached::Ptr buffers, SNetTransport transport) -> CAsioSocketUDP::Ptr {
+    return std::make_shared<CAsioSocketUDP>(host, port, buffers, transport);
+}
+
+CAsioSocketUDP::CAsioSocketUDP(std::string host, uint16_t port, CBuffersCached::Ptr buffers, SNetTransport transport)
+    : m_mode(net_lib::EMode::M_SERVER),
+      m_host(host),
+      m_port(port),
+      m_transport(transport),
+      m_socket(nullptr),
+      m_timer(nullptr),
+      m_rxBuffer(MAX_DATAGRAM),
+      m_mtx(),
+      m_asio(new CAsioService()),
+      m_bufferSize(socketBufferSize()),
+      m_buffers(buffers),
+      m_currentBuffer(nullptr),
+      m_isStopReceive(false),
+      m_subscribers(),
+      m_sequence(0),
+      m_packId(0),
+      m_connected(false),
+      m_unansweredSubscribe(0),
+      m_started(false),
+      m_nextSequence(0),
+      m_lostDatagrams(0),
+      m_received(),
+      m_receivedCount(0),
+      m_samples{0, 0, 0, 0},
+      m_lost{0, 0, 0, 0} {
+    if (m_transport.datagram < 256 || m_transport.datagram > NET_UDP_PAYLOAD_MAX) {
+        WARNING("Invalid datagram size %u. Used %u", m_transport.datagram, NET_UDP_PAYLOAD)
+        m_transport.datagram = NET_UDP_PAYLOAD;
+    }
+}
+
+CAsioSocketUDP::~CAsioSocketUDP() {
+    stopReceive();
+    closeSocket();
+    delete m_asio;
+    m_asio = nullptr;
+}
+
+auto CAsioSocketUDP::initServer() -> void {
+    closeSocket();
+    asio::error_code error;
+    {
+        std::lock_guard lock(m_mtx);
+        try {
+            m_socket = std::make_shared<asio::ip::udp::socket>(m_asio->getIO());
+            m_socket->open(asio::ip::udp::v4());
+            m_socket->set_option(asio::ip::udp::socket::reuse_address(true));
+            m_socket->set_option(asio::socket_base::send_buffer_size(m_bufferSize * 3));
+            if (m_transport.multicast != "") {
+                m_groupEndpoint = asio::ip::udp::endpoint(asio::ip::make_address_v4(m_transport.multicast), m_port);
+                m_socket->set_option(asio::ip::multicast::hops(m_transport.ttl));
+                m_socket->set_option(asio::ip::multicast::enable_loopback(true));
+            }
+            m_socket->bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), m_port));
+            m_mode = net_lib::EMode::M_SERVER;
+            m_isStopReceive = false;
+            startReceive();
+            startTimer();
+        } catch (const asio::system_error& e) {
+            error = e.code();
+            m_socket = nullptr;
+        }
+    }
+    if (error) {
+        errorServerNotify(error);
+    }
+}
+
+auto CAsioSocketUDP::initClient() -> void {
+    asio::error_code error;
+    {
+        std::lock_guard lock(m_mtx);
+        try {
+            asio::ip::udp::resolver resolver(m_asio->getIO());
+            m_serverEndpoint = *resolver.resolve(asio::ip::udp::v4(), m_host, std::to_string(m_port)).begin();
+            m_socket = std::make_shared<asio::ip::udp::socket>(m_asio->getIO());
+            m_socket->open(asio::ip::udp::v4());
+            m_socket->set_option(asio::socket_base::receive_buffer_size(m_bufferSize * 3));
+            if (m_transport.multicast != "") {
+                m_socket->set_option(asio::ip::udp::socket::reuse_address(true));
+                m_socket->bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), m_port));
+                m_socket->set_option(asio::ip::multicast::join_group(asio::ip::make_address_v4(m_transport.multicast)));
+            } else {
+                m_socket->bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), 0));
+            }
+            m_mode = net_lib::EMode::M_CLIENT;
+            m_isStopReceive = false;
+            m_connected = false;
+            m_unansweredSubscribe = 0;
+            m_started = false;
+            startReceive();
+            startTimer();
+        } catch (const asio::system_error& e) {
+            error = e.code();
+            m_socket = nullptr;
+        }
+    }
+    if (error) {
+        errorClientNotify(error);
+    } else {
+        sendControl(UDP_SUBSCRIBE, m_serverEndpoint);
+    }
+}
+
+auto CAsioSocketUDP::startReceive() -> void {
+    m_socket->async_receive_from(asio::buffer(m_rxBuffer), m_senderEndpoint,
+                                 std::bind(&CAsioSocketUDP::handlerReceive, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+auto CAsioSocketUDP::startTimer() -> void {
+    if (!m_timer)
+        m_timer = std::make_shared<asio::steady_timer>(m_asio->getIO());
+    m_timer->expires_after(std::chrono::milliseconds(SUBSCRIBE_INTERVAL_MS));
+    m_timer->async_wait(std::bind(&CAsioSocketUDP::handlerTimer, this, std::placeholders::_1));
+}
+
+auto CAsioSocketUDP::handlerTimer(const asio::error_code& _error) -> void {
+    if (_error || m_isStopReceive)
+        return;
+
+    if (m_mode == net_lib::EMode::M_SERVER) {
+        std::vector<std::string> expired;
+        {
+            std::lock_guard lock(m_mtx);
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = m_subscribers.begin(); it != m_subscribers.end();) {
+                if (now - it->second > std::chrono::milliseconds(SUBSCRIBE_TIMEOUT_MS)) {
+                    expired.push_back(it->first.address().to_string());
+                    it = m_subscribers.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+        for (auto& host : expired) {
+            disconnectServerNotify(host);
+        }
+    } else {
+        // The subscription is repeated as a keepalive
+        if (!m_connected && ++m_unansweredSubscribe > SUBSCRIBE_RETRIES) {
+            errorClientNotify(asio::error::timed_out);
+            return;
+        }
+        sendControl(UDP_SUBSCRIBE, m_serverEndpoint);
+    }
+
+    std::lock_guard lock(m_mtx);
+    if (m_socket)
+        startTimer();
+}
+
+auto CAsioSocketUDP::sendControl(EUDPType _type, const asio::ip::udp::endpoint& _endpoint) -> void {
+    UDPDatagramHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NET_UDP_MAGIC;
+    header.version = NET_UDP_VERSION;
+    header.type = _type;
+    std::lock_guard lock(m_mtx);
+    if (m_socket) {
+        asio::error_code error;
+        m_socket->send_to(asio::buffer(&header, sizeof(header)), _endpoint, 0, error);
+    }
+}
+
+auto CAsioSocketUDP::handlerReceive(const asio::error_code& _error, size_t _bytesTransferred) -> void {
+    // Operation aborted
+    if (_error.value() == 125 || m_isStopReceive) {
+        return;
+    }
+    if (!_error && _bytesTransferred >= sizeof(UDPDatagramHeader)) {
+        UDPDatagramHeader header;
+        memcpy(&header, m_rxBuffer.data(), sizeof(header));
+        if (header.magic == NET_UDP_MAGIC && header.version == NET_UDP_VERSION) {
+            if (header.type == UDP_DATA) {
+                if (m_mode == net_lib::EMode::M_CLIENT)
+                    receiveData(header, m_rxBuffer.data() + sizeof(header), _bytesTransferred - sizeof(header));
+            } else {
+                receiveControl(header);
+            }
+        }
+    }
+
+    std::lock_guard lock(m_mtx);
+    if (m_socket && !m_isStopReceive) {
+        startReceive();
+    }
+}
+
+auto CAsioSocketUDP::receiveControl(const UDPDatagramHeader& _header) -> void {
+    if (m_mode == net_lib::EMode::M_SERVER) {
+        auto sender = m_senderEndpoint;
+        auto host = sender.address().to_string();
+        if (_header.type == UDP_SUBSCRIBE) {
+            bool isNew = false;
+            {
+                std::lock_guard lock(m_mtx);
+                isNew = m_subscribers.count(sender) == 0;
+                m_subscribers[sender] = std::chrono::steady_clock::now();
+            }
+            if (isNew)
+                connectServerNotify(host);
+            // Several clients on one host share the group port, only the group reaches all of them
+            sendControl(UDP_ACK, m_transport.multicast != "" ? m_groupEndpoint : sender);
+        }
+        if (_header.type == UDP_LEAVE) {
+            size_t erased = 0;
+            {
+                std::lock_guard lock(m_mtx);
+                erased = m_subscribers.erase(sender);
+            }
+            if (erased)
+                disconnectServerNotify(host);
+        }
+    } else {
+        if (_header.type == UDP_ACK && !m_connected) {
+            m_connected = true;
+            connectClientNotify(m_host);
+        }
+    }
+}
+
+auto CAsioSocketUDP::receiveData(const UDPDatagramHeader& _header, const uint8_t* _data, size_t _size) -> void {
+    getBuffer();
+    if (m_currentBuffer == nullptr) {
+        return;
+    }
+
+    if (m_started && _header.packId + RESTART_PACKS < m_packId) {
+        WARNING("Pack id went back from %llu to %llu. New stream", (unsigned long long)m_packId, (unsigned long long)_header.packId)
+        // The partial pack of the old stream is lost
+        if (m_receivedCount > 0)
+            dropPacks(1);
+        m_started = false;
+    }
+
+    if (!m_started) {
+        m_started = true;
+        m_packId = _header.packId;
+        m_nextSequence = _header.sequence;
+        for (auto& s : m_samples)
+            s = _header.samples;
+    }
+
+    if (_header.sequence >= m_nextSequence) {
+        m_lostDatagrams += _header.sequence - m_nextSequence;
+        m_nextSequence = _header.sequence + 1;
+    } else if (m_lostDatagrams > 0) {
+        // Reordered datagram that was counted as lost
+        m_lostDatagrams--;
+    }
+
+    if (_header.packId < m_packId) {
+        // Late datagram of a pack that was completed or dropped
+        return;
+    }
+    if (_header.packId > m_packId) {
+        dropPacks(_header.packId - m_packId);
+        m_packId = _header.packId;
+    }
+
+    if (_header.channel > DataLib::EDataBuffersPackChannel::CH4 || _header.index >= _header.count) {
+        return;
+    }
+    auto buff = m_currentBuffer->getBuffer((DataLib::EDataBuffersPackChannel)_header.channel);
+    if (buff == nullptr || _header.bufferSize != buff->getBufferFullLenght() || (uint64_t)_header.offset + _size > _header.bufferSize) {
+        ERROR_LOG("Datagram does not match the buffers. Channel %d buffer size %u", _header.channel, _header.bufferSize)
+        return;
+    }
+
+    if (m_received.size() == 0) {
+        m_received.assign(_header.count, 0);
+        m_receivedCount = 0;
+    }
+    if (m_received.size() != _header.count || m_received[_header.index]) {
+        return;
+    }
+    m_received[_header.index] = 1;
+    m_receivedCount++;
+    m_samples[_header.channel] = _header.samples;
+    memcpy((uint8_t*)buff->getMappedMemory() + _header.offset, _data, _size);
+
+    if (m_receivedCount == _header.count) {
+        completePack();
+    }
+}
+
+auto CAsioSocketUDP::dropPacks(uint64_t _count) -> void {
+    for (auto i = (int)DataLib::EDataBuffersPackChannel::CH1; i <= (int)DataLib::EDataBuffersPackChannel::CH4; i++) {
+        if (m_currentBuffer->isChannelPresent((DataLib::EDataBuffersPackChannel)i)) {
+            m_lost[i] += m_samples[i] * _count;
+        }
+    }
+    m_received.clear();
+    m_receivedCount = 0;
+}
+
+auto CAsioSocketUDP::completePack() -> void {
+    for (auto i = (int)DataLib::EDataBuffersPackChannel::CH1; i <= (int)DataLib::EDataBuffersPackChannel::CH4; i++) {
+        auto buff = m_currentBuffer->getBuffer((DataLib::EDataBuffersPackChannel)i);
+        if (buff != nullptr) {
+            buff->setLostSamples(EDataLost::NETWORK, m_lost[i]);
+            m_lost[i] = 0;
+        }
+    }
+    m_currentBuffer->verifyPack();
+    recivedNotify(asio::error_code(), m_currentBuffer);
+    unlockBuffer();
+    m_packId++;
+    m_received.clear();
+    m_receivedCount = 0;
+}
+
+auto CAsioSocketUDP::stopReceive() -> void {
+    if (m_mode == net_lib::EMode::M_CLIENT && !m_isStopReceive) {
+        sendControl(UDP_LEAVE, m_serverEndpoint);
+    }
+    m_isStopReceive = true;
+}
+
+auto CAsioSocketUDP::getBuffer() -> void {
+    if (m_buffers == nullptr)
+        return;
+    // Only the receive handler uses the buffer. The lock is not held, the keepalive goes on while the reader is behind.
+    while (!m_isStopReceive && m_currentBuffer == nullptr) {
+        m_currentBuffer = m_buffers->writeBuffer(true);
+    }
+}
+
+auto CAsioSocketUDP::unlockBuffer() -> void {
+    if (m_buffers == nullptr)
+        return;
+    if (m_currentBuffer != nullptr) {
+        m_buffers->unlockBufferWrite();
+        m_currentBuffer = nullptr;
+    }
+}
+
+auto CAsioSocketUDP::isConnected() -> bool {
+    std::lock_guard lock(m_mtx);
+    if (!m_socket)
+        return false;
+    return m_mode == net_lib::EMode::M_SERVER ? m_subscribers.size() > 0 : m_connected;
+}
+
+auto CAsioSocketUDP::getLostDatagrams() -> uint64_t {
+    return m_lostDatagrams;
+}
+
+auto CAsioSocketUDP::cancelSocket() -> void {
+    std::lock_guard lock(m_mtx);
+    try {
+        if (m_timer) {
+            m_timer->cancel();
+        }
+        if (m_socket) {
+            m_socket->cancel();
+        }
+    } catch (...) {}
+}
+
+auto CAsioSocketUDP::closeSocket() -> void {
+    std::vector<std::string> subscribers;
+    bool wasConnected = false;
+    {
+        std::lock_guard lock(m_mtx);
+        if (!m_socket)
+            return;
+        try {
+            if (m_timer)
+                m_timer->cancel();
+            m_socket->close();
+        } catch (...) {}
+        m_socket = nullptr;
+        for (auto& kv : m_subscribers) {
+            subscribers.push_back(kv.first.address().to_string());
+        }
+        m_subscribers.clear();
+        wasConnected = m_connected;
+        m_connected = false;
+    }
+
+    try {
+        for (auto& host : subscribers) {
+            disconnectServerNotify(host);
+        }
+        if (wasConnected) {
+            disconnectClientNotify(m_host);
+        }
+    } catch (...) {}
+}
+
+auto CAsioSocketUDP::sendSyncBuffer(DataLib::CDataBuffersPackDMA::Ptr _buffer) -> bool {
+    std::lock_guard lock(m_mtx);
+    asio::error_code _error;
+
+    if (!m_socket)
+        return false;
+
+    std::vector<asio::ip::udp::endpoint> targets;
+    if (m_transport.multicast != "") {
+        targets.push_back(m_groupEndpoint);
+    } else {
+        for (auto& kv : m_subscribers) {
+            targets.push_back(kv.first);
+        }
+    }
+    if (targets.size() == 0)
+        return false;
+
+    uint32_t payload = m_transport.datagram;
+    uint32_t count = 0;
+    for (auto i = (int)DataLib::EDataBuffersPackChannel::CH1; i <= (int)DataLib::EDataBuffersPackChannel::CH4; i++) {
+        auto buff = _buffer->getBuffer((DataLib::EDataBuffersPackChannel)i);
+        if (buff != NULL) {
+            count += (buff->getBufferFullLenght() + payload - 1) / payload;
+        }
+    }
+
+    UDPDatagramHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NET_UDP_MAGIC;
+    header.version = NET_UDP_VERSION;
+    header.type = UDP_DATA;
+    header.packId = m_packId++;
+    header.count = count;
+
+    uint32_t index = 0;
+    for (auto i = (int)DataLib::EDataBuffersPackChannel::CH1; i <= (int)DataLib::EDataBuffersPackChannel::CH4; i++) {
+        auto buff = _buffer->getBuffer((DataLib::EDataBuffersPackChannel)i);
+        if (buff != NULL) {
+            auto data = (const uint8_t*)buff->getMappedMemory();
+            uint32_t size = buff->getBufferFullLenght();
+            header.channel = i;
+            header.bufferSize = size;
+            header.samples = buff->getSamplesCount();
+            for (uint32_t offset = 0; offset < size; offset += payload) {
+                header.sequence = m_sequence++;
+                header.index = index++;
+                header.offset = offset;
+                // The header and the DMA memory are gathered by the kernel, the samples are not copied
+                std::array<asio::const_buffer, 2> datagram = {asio::buffer(&header, sizeof(header)),
+                                                              asio::buffer(data + offset, std::min(payload, size - offset))};
+                for (auto& endpoint : targets) {
+                    asio::error_code error;
+                    m_socket->send_to(datagram, endpoint, 0, error);
+                    if (error)
+                        _error = error;
+                }
+            }
+        }
+    }
+    sendNotify(_error, _buffer->getLenghtBuffers());
+    return true;
+}
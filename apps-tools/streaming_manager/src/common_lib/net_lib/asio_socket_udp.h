@@ -0,0 +1,135 @@
+#ifndef NET_LIB_ASIO_SOCKET_UDP_H
+#define NET_LIB_ASIO_SOCKET_UDP_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "asio_common.h"
+#include "asio_service.h"
+#include "data_lib/buffers_cached.h"
+#include "data_lib/signal.hpp"
+
+using namespace std;
+using namespace DataLib;
+
+namespace net_lib {
+
+#define NET_UDP_MAGIC 0x52505544  // "RPUD"
+#define NET_UDP_VERSION 1
+
+enum EUDPType : uint8_t { UDP_DATA = 0, UDP_SUBSCRIBE = 1, UDP_LEAVE = 2, UDP_ACK = 3 };
+
+// Every datagram starts with this header. The channel buffers of a pack, NetworkPackHeader included,
+// are cut into datagrams that never span two channels.
+#pragma pack(push, 1)
+struct UDPDatagramHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint8_t channel;  // EDataBuffersPackChannel
+    uint8_t reserved;
+    uint64_t sequence;  // Per datagram, continuous on the sender
+    uint64_t packId;
+    uint32_t index;       // Datagram of the pack
+    uint32_t count;       // Datagrams in the pack
+    uint32_t offset;      // Position of the payload in the channel buffer
+    uint32_t bufferSize;  // Channel buffer size
+    uint32_t samples;     // Samples of the channel in the pack, for the loss accounting
+    uint32_t reserved2;
+};
+#pragma pack(pop)
+
+// ADC streaming over UDP. The server sends each pack as datagrams to the clients that subscribed,
+// or once to a multicast group. The client reassembles the packs in the cached buffers. Packs that
+// are not complete when the next pack starts are dropped and their samples are reported in the
+// NETWORK lost samples of the next pack.
+class CAsioSocketUDP {
+   public:
+    using Ptr = shared_ptr<CAsioSocketUDP>;
+
+    static Ptr create(string host, uint16_t port, CBuffersCached::Ptr buffers, SNetTransport transport);
+
+    CAsioSocketUDP(string host, uint16_t port, CBuffersCached::Ptr buffers, SNetTransport transport);
+    ~CAsioSocketUDP();
+
+    auto initServer() -> void;
+    auto initClient() -> void;
+    auto stopReceive() -> void;
+    auto cancelSocket() -> void;
+    auto closeSocket() -> void;
+    auto isConnected() -> bool;
+    auto sendSyncBuffer(DataLib::CDataBuffersPackDMA::Ptr _buffer) -> bool;
+    auto getLostDatagrams() -> uint64_t;
+
+    sigslot::signal<string&> connectServerNotify;
+    sigslot::signal<string&> disconnectServerNotify;
+
+    sigslot::signal<string&> connectClientNotify;
+    sigslot::signal<string&> disconnectClientNotify;
+
+    sigslot::signal<error_code> errorServerNotify;
+    sigslot::signal<error_code> errorClientNotify;
+
+    sigslot::signal<error_code, size_t> sendNotify;
+    sigslot::signal<error_code, DataLib::CDataBuffersPackDMA::Ptr> recivedNotify;
+
+   private:
+    CAsioSocketUDP(const CAsioSocketUDP&) = delete;
+    CAsioSocketUDP(CAsioSocketUDP&&) = delete;
+    CAsioSocketUDP& operator=(const CAsioSocketUDP&) = delete;
+    CAsioSocketUDP& operator=(const CAsioSocketUDP&&) = delete;
+
+    auto startReceive() -> void;
+    auto startTimer() -> void;
+    auto handlerReceive(const asio::error_code& _error, size_t _bytesTransferred) -> void;
+    auto handlerTimer(const asio::error_code& _error) -> void;
+    auto receiveControl(const UDPDatagramHeader& _header) -> void;
+    auto receiveData(const UDPDatagramHeader& _header, const uint8_t* _data, size_t _size) -> void;
+    auto sendControl(EUDPType _type, const asio::ip::udp::endpoint& _endpoint) -> void;
+    auto dropPacks(uint64_t _count) -> void;
+    auto completePack() -> void;
+
+    auto getBuffer() -> void;
+    auto unlockBuffer() -> void;
+
+    net_lib::EMode m_mode;
+    string m_host;
+    uint16_t m_port;
+    SNetTransport m_transport;
+
+    shared_ptr<asio::ip::udp::socket> m_socket;
+    shared_ptr<asio::steady_timer> m_timer;
+    asio::ip::udp::endpoint m_serverEndpoint;
+    asio::ip::udp::endpoint m_groupEndpoint;
+    asio::ip::udp::endpoint m_senderEndpoint;
+    std::vector<uint8_t> m_rxBuffer;
+
+    std::mutex m_mtx;
+    CAsioService* m_asio;
+    uint64_t m_bufferSize;
+    CBuffersCached::Ptr m_buffers;
+    CDataBuffersPackDMA::Ptr m_currentBuffer;
+    bool m_isStopReceive;
+
+    // Server
+    std::map<asio::ip::udp::endpoint, std::chrono::steady_clock::time_point> m_subscribers;
+    uint64_t m_sequence;
+    uint64_t m_packId;
+
+    // Client
+    bool m_connected;
+    int m_unansweredSubscribe;
+    bool m_started;
+    uint64_t m_nextSequence;
+    std::atomic<uint64_t> m_lostDatagrams;
+    std::vector<uint8_t> m_received;
+    uint32_t m_receivedCount;
+    uint64_t m_samples[4];
+    uint64_t m_lost[4];
+};
+
+}  // namespace net_lib
+
+#endif
@@ -0,0 +1,136 @@
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "logger_lib/file_logger.h"
+
+CMappedFile::CMappedFile()
+    : m_fd(-1), m_map(nullptr), m_size(0), m_window(0), m_pageSize(4096), m_readPos(0), m_prefetched(0), m_prefetchRun(false) {}
+
+CMappedFile::~CMappedFile() {
+    close();
+}
+
+auto CMappedFile::open(const std::string& _path) -> bool {
+    close();
+#ifdef _WIN32
+    // Not used on Windows. The reader falls back to the stream reader.
+    return false;
+#else
+    m_pageSize = sysconf(_SC_PAGESIZE);
+    m_fd = ::open(_path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        ERROR_LOG("Can't open file %s", _path.c_str())
+        return false;
+    }
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+        ERROR_LOG("Can't get size of file %s", _path.c_str())
+        close();
+        return false;
+    }
+    m_size = st.st_size;
+    void* map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        ERROR_LOG("Can't map file %s", _path.c_str())
+        m_map = nullptr;
+        close();
+        return false;
+    }
+    m_map = (uint8_t*)map;
+    madvise(m_map, m_size, MADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+auto CMappedFile::close() -> void {
+    stopPrefetch();
+#ifndef _WIN32
+    if (m_map) {
+        munmap(m_map, m_size);
+        m_map = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+    m_size = 0;
+}
+
+auto CMappedFile::isOpen() -> bool {
+    return m_map != nullptr;
+}
+
+auto CMappedFile::data() -> const uint8_t* {
+    return m_map;
+}
+
+auto CMappedFile::size() -> uint64_t {
+    return m_size;
+}
+
+auto CMappedFile::startPrefetch(uint64_t _window) -> void {
+    stopPrefetch();
+    if (!m_map)
+        return;
+    m_window = _window;
+    m_readPos = 0;
+    m_prefetched = 0;
+    m_prefetchRun = true;
+    m_thread = std::thread(&CMappedFile::prefetchFunc, this);
+}
+
+auto CMappedFile::stopPrefetch() -> void {
+    {
+        std::lock_guard lock(m_mtx);
+        m_prefetchRun = false;
+        m_cv.notify_all();
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+auto CMappedFile::setReadPosition(uint64_t _pos) -> void {
+    auto prev = m_readPos.exchange(_pos);
+    // Wake the thread only when half of the window is consumed or the position jumped back
+    if (_pos < prev || (m_prefetched < m_size && _pos + m_window / 2 > m_prefetched)) {
+        std::lock_guard lock(m_mtx);
+        m_cv.notify_all();
+    }
+}
+
+auto CMappedFile::prefetchFunc() -> void {
+    uint64_t lastPos = 0;
+    std::unique_lock lock(m_mtx);
+    while (m_prefetchRun) {
+        uint64_t pos = m_readPos;
+        if (pos < lastPos) {
+            m_prefetched = pos;
+        }
+        lastPos = pos;
+        uint64_t start = std::max<uint64_t>(m_prefetched, pos) & ~(m_pageSize - 1);
+        uint64_t end = std::min(pos + m_window, m_size);
+        if (start >= end) {
+            m_cv.wait(lock, [&] { return !m_prefetchRun || m_readPos < lastPos || (m_prefetched < m_size && m_readPos + m_window / 2 > m_prefetched); });
+            continue;
+        }
+        lock.unlock();
+#ifndef _WIN32
+        madvise(m_map + start, end - start, MADV_WILLNEED);
+#endif
+        // madvise only starts the read ahead. Touching the pages waits for it, here and not in the DAC thread.
+        uint8_t sink = 0;
+        for (uint64_t p = start; p < end; p += m_pageSize) {
+            sink += *(volatile uint8_t*)(m_map + p);
+        }
+        (void)sink;
+        m_prefetched = end;
+        lock.lock();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef READER_LIB_MAPPED_FILE_H
+#define READER_LIB_MAPPED_FILE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Read-only memory mapping of a whole file.
+ * A background thread keeps the pages in front of the read position resident (madvise + page touch),
+ * so the DAC feeding thread does not block on SD card reads. Pages stay in the page cache,
+ * so repeated playback does not read the file again while memory allows.
+ */
+
+class CMappedFile {
+   public:
+    CMappedFile();
+    ~CMappedFile();
+
+    auto open(const std::string& _path) -> bool;
+    auto close() -> void;
+    auto isOpen() -> bool;
+    auto data() -> const uint8_t*;
+    auto size() -> uint64_t;
+
+    auto startPrefetch(uint64_t _window) -> void;
+    auto stopPrefetch() -> void;
+    // Current file offset of the consumer. Moving backwards (repeat) restarts the prefetch from there.
+    auto setReadPosition(uint64_t _pos) -> void;
+
+   private:
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile(CMappedFile&&) = delete;
+    CMappedFile& operator=(const CMappedFile&) = delete;
+    CMappedFile& operator=(const CMappedFile&&) = delete;
+
+    auto prefetchFunc() -> void;
+
+    int m_fd;
+    uint8_t* m_map;
+    uint64_t m_size;
+    uint64_t m_window;
+    uint64_t m_pageSize;
+    std::atomic_uint64_t m_readPos;
+    std::atomic_uint64_t m_prefetched;
+    std::atomic_bool m_prefetchRun;
+    std::thread m_thread;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+};
+
+#endif
@@ -3,17 +3,20 @@
 #include "logger_lib/file_logger.h"
 
 // constexpr size_t g_max_buff = 32 * 1024;
+constexpr size_t g_mmap_chunk = 256 * 1024;
+constexpr uint64_t g_mmap_prefetch_window = 8 * 1024 * 1024;
 
 CReaderController::Ptr CReaderController::Create(CStreamSettings::DataFormat _fileType, std::string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count,
-                                                 uint32_t blockSize) {
-    return std::make_shared<CReaderController>(_fileType, _filePath, _repeat, _rep_count, blockSize);
+                                                 uint32_t blockSize, bool useMmap) {
+    return std::make_shared<CReaderController>(_fileType, _filePath, _repeat, _rep_count, blockSize, useMmap);
 }
 
 CReaderController::Ptr CReaderController::Create(DataIn* dataIn, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize) {
     return std::make_shared<CReaderController>(dataIn, _repeat, _rep_count, blockSize);
 }
 
-CReaderController::CReaderController(CStreamSettings::DataFormat _fileType, std::string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize)
+CReaderController::CReaderController(CStreamSettings::DataFormat _fileType, std::string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize,
+                                     bool useMmap)
     : m_fileType(_fileType),
       m_filePath(_filePath),
       m_repeat(_repeat),
@@ -33,7 +36,10 @@ CReaderController::CReaderController(CStreamSettings::DataFormat _fileType, std:
       m_channel2Size(0),
       m_blockSize(blockSize),
       m_genData(nullptr),
-      m_memSink(nullptr) {
+      m_memSink(nullptr),
+      m_mapped(nullptr),
+      m_currentChunk(0),
+      m_tdmsIndex(nullptr) {
     for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
         m_dataBuffers[idx] = new uint8_t[blockSize];
         memset(m_dataBuffers[idx], 0, blockSize);
@@ -49,9 +55,37 @@ CReaderController::CReaderController(CStreamSettings::DataFormat _fileType, std:
     }
 
     if (m_fileType.value == CStreamSettings::DataFormat::TDMS) {
-        openTDMS();
+        if (useMmap) {
+            openTDMSIndex();
+        }
+        if (!m_tdmsIndex) {
+            openTDMS();
+        }
+    }
+    if (useMmap) {
+        openMapped();
     }
     m_result = checkFile();
+    delete m_tdmsIndex;
+    m_tdmsIndex = nullptr;
+    if (m_mapped && m_channel1Present && m_fileType.value == CStreamSettings::DataFormat::WAV) {
+        buildWavChunks();
+    }
+    if (!m_mapped || m_chunks.empty()) {
+        delete m_mapped;
+        m_mapped = nullptr;
+        m_chunks.clear();
+        if (m_fileType.value == CStreamSettings::DataFormat::TDMS && !m_tdmsFile) {
+            openTDMS();
+            m_result = checkFile();
+        }
+    }
+    if (m_mapped) {
+        for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+            m_tempBuffer[idx].memoryMode = true;  // Buffers point into the mapping
+        }
+        m_mapped->startPrefetch(g_mmap_prefetch_window);
+    }
     resetReadFromBuffer();
 }
 
@@ -75,7 +109,10 @@ CReaderController::CReaderController(DataIn* dataIn, CStreamSettings::DACRepeat
       m_channel2Size(0),
       m_blockSize(blockSize),
       m_genData(dataIn),
-      m_memSink(nullptr) {
+      m_memSink(nullptr),
+      m_mapped(nullptr),
+      m_currentChunk(0),
+      m_tdmsIndex(nullptr) {
     for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
         m_dataBuffers[idx] = new uint8_t[blockSize];
         memset(m_dataBuffers[idx], 0, blockSize);
@@ -117,7 +154,10 @@ CReaderController::CReaderController(MemoryStreamSink* sink, uint32_t blockSize)
       m_channel2Size(0),
       m_blockSize(blockSize),
       m_genData(nullptr),
-      m_memSink(sink) {
+      m_memSink(sink),
+      m_mapped(nullptr),
+      m_currentChunk(0),
+      m_tdmsIndex(nullptr) {
     for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
         m_dataBuffers[idx] = new uint8_t[blockSize];
         memset(m_dataBuffers[idx], 0, blockSize);
@@ -144,6 +184,8 @@ CReaderController::~CReaderController() {
     delete[] m_dataBuffers[1];
     delete m_genData;
     delete m_memSink;
+    delete m_mapped;
+    delete m_tdmsIndex;
 }
 
 auto CReaderController::getChannels(dac_channels_t& channels) -> void {
@@ -160,6 +202,59 @@ auto CReaderController::disableRepeatMode() -> void {
     m_repeat = CStreamSettings::DACRepeat::DAC_REP_OFF;
 }
 
+auto CReaderController::isMapped() -> bool {
+    return m_mapped != nullptr;
+}
+
+auto CReaderController::openMapped() -> bool {
+    if (m_fileType.value != CStreamSettings::DataFormat::WAV && m_fileType.value != CStreamSettings::DataFormat::TDMS)
+        return false;
+    m_mapped = new CMappedFile();
+    if (!m_mapped->open(m_filePath)) {
+        WARNING("Can't map file %s. Use stream reader", m_filePath.c_str())
+        delete m_mapped;
+        m_mapped = nullptr;
+        return false;
+    }
+    return true;
+}
+
+auto CReaderController::openTDMSIndex() -> bool {
+    m_tdmsIndex = new TDMS::IndexedFile();
+    if (!m_tdmsIndex->open(m_filePath)) {
+        delete m_tdmsIndex;
+        m_tdmsIndex = nullptr;
+        return false;
+    }
+    m_result = OpenResult::OR_OK;
+    return true;
+}
+
+auto CReaderController::buildWavChunks() -> void {
+    m_chunks.clear();
+    if (!m_wavReader)
+        return;
+    auto header = m_wavReader->getHeader();
+    if (strncmp((const char*)header.RIFF, "RIFF", 4) != 0 || header.AudioFormat != 1)
+        return;
+    uint8_t bits = header.bitsPerSample;
+    if (!(bits == 16 || bits == 8))
+        return;
+    size_t frame = (bits / 8) * (m_channel2Present ? 2 : 1);
+    uint64_t offset = m_mapped->size() - m_wavReader->getDataSize();
+    uint64_t dataSize = (m_wavReader->getDataSize() / frame) * frame;
+    size_t chunkSize = (g_mmap_chunk / frame) * frame;
+    for (uint64_t pos = 0; pos < dataSize; pos += chunkSize) {
+        MappedChunk chunk;
+        chunk.offset = offset + pos;
+        chunk.size = std::min<uint64_t>(chunkSize, dataSize - pos);
+        chunk.channel = m_channel2Present ? MAPPED_STEREO : (uint8_t)DACChannels::DAC_CH1;
+        chunk.bits = bits;
+        chunk.stride = frame;
+        m_chunks.push_back(chunk);
+    }
+}
+
 auto CReaderController::openWav() -> bool {
     try {
         if (m_fileType.value == CStreamSettings::DataFormat::WAV) {
@@ -211,6 +306,12 @@ auto CReaderController::resetReadFromBuffer() -> bool {
     m_tempBuffer[0].deleteBuffer();
     m_tempBuffer[1].deleteBuffer();
 
+    if (m_mapped) {
+        m_checkEmptyFile = true;
+        m_currentChunk = 0;
+        return true;
+    }
+
     if (m_memSink) {
         if (m_memSink->callback == nullptr) {
             WARNING("Missing callback in memory sink")
@@ -254,6 +355,10 @@ auto CReaderController::writeFromTemp(uint8_t** buff, size_t max_size, size_t* w
 }
 
 auto CReaderController::getBufferPrepared(Data& data) -> BufferResult {
+    return getBufferPrepared(data, {m_dataBuffers[0], m_dataBuffers[1]});
+}
+
+auto CReaderController::getBufferPrepared(Data& data, std::array<uint8_t*, MAX_DAC_CHANNELS> dst) -> BufferResult {
     auto fillZero = [&](uint8_t** ch, size_t* size) {
         if (*ch) {
             if (0 != *size) {
@@ -265,12 +370,12 @@ auto CReaderController::getBufferPrepared(Data& data) -> BufferResult {
 
     data.size[0] = data.size[1] = 0;
     if (m_channel1Present) {
-        data.ch[0] = m_dataBuffers[0];
+        data.ch[0] = dst[0] ? dst[0] : m_dataBuffers[0];
     } else {
         data.ch[0] = nullptr;
     }
     if (m_channel2Present) {
-        data.ch[1] = m_dataBuffers[1];
+        data.ch[1] = dst[1] ? dst[1] : m_dataBuffers[1];
     } else {
         data.ch[1] = nullptr;
     }
@@ -328,7 +433,7 @@ auto CReaderController::getBufferPrepared(Data& data) -> BufferResult {
                 if (data_read.size[0] || data_read.size[1]) {
                     m_checkEmptyFile = false;
                 } else {
-                    if (m_genData == nullptr) {
+                    if (m_genData == nullptr && m_mapped == nullptr) {
                         delete[] data_read.ch[0];
                         delete[] data_read.ch[1];
                     }
@@ -388,6 +493,8 @@ auto CReaderController::getBuffer(Data& data) -> bool {
         }
         m_genData->readPosition += std::max(data.size[0], data.size[1]);
         return data.size[0] > 0 || data.size[1] > 0;
+    } else if (m_mapped) {
+        return getBufferMapped(data);
     } else if (m_fileType.value == CStreamSettings::DataFormat::WAV) {
         return getBufferWav(data);
     } else if (m_fileType.value == CStreamSettings::DataFormat::TDMS) {
@@ -417,6 +524,36 @@ auto CReaderController::getBufferWav(Data& data) -> bool {
     return false;
 }
 
+auto CReaderController::getBufferMapped(Data& data) -> bool {
+    if (m_currentChunk >= m_chunks.size()) {
+        return false;
+    }
+    auto& chunk = m_chunks[m_currentChunk++];
+    m_mapped->setReadPosition(chunk.offset);
+    // The mapping is read only. Temporary buffers in memory mode are only read from.
+    auto src = const_cast<uint8_t*>(m_mapped->data()) + chunk.offset;
+    data.bits = chunk.bits;
+    if (chunk.channel == MAPPED_STEREO) {
+        size_t bytes = chunk.bits / 8;
+        size_t frames = chunk.size / (bytes * 2);
+        for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+            m_stage[idx].resize(frames * bytes);
+            data.ch[idx] = m_stage[idx].data();
+            data.size[idx] = frames * bytes;
+            deinterleave_neon(data.ch[idx], src + idx * bytes, frames, bytes, chunk.stride);
+        }
+    } else if (chunk.stride != chunk.bits / 8u) {
+        m_stage[chunk.channel].resize(chunk.size);
+        data.ch[chunk.channel] = m_stage[chunk.channel].data();
+        data.size[chunk.channel] = chunk.size;
+        deinterleave_neon(data.ch[chunk.channel], src, chunk.size / (chunk.bits / 8), chunk.bits / 8, chunk.stride);
+    } else {
+        data.ch[chunk.channel] = src;
+        data.size[chunk.channel] = chunk.size;
+    }
+    return true;
+}
+
 auto CReaderController::getBufferTdms(Data& data) -> bool {
     if (m_tdmsFile && m_fileType.value == CStreamSettings::DataFormat::TDMS) {
         if (m_channel1Present == false && m_channel2Present == false) {
@@ -606,6 +743,9 @@ auto CReaderController::checkTDMSFile() -> OpenResult {
     bool channel1WrongType = false;
     bool channel2WrongType = false;
 
+    if (m_tdmsIndex) {
+        return checkTDMSIndex();
+    }
     if (m_tdmsFile) {
         for (auto& seg : m_tdmsSegments) {
             auto meta = m_tdmsFile->GetMetadata(seg);
@@ -658,3 +798,54 @@ auto CReaderController::checkTDMSFile() -> OpenResult {
     }
     return OpenResult::OR_CLOSE;
 }
+
+
+auto CReaderController::checkTDMSIndex() -> OpenResult {
+    const TDMS::IndexedFile::Channel* channels[MAX_DAC_CHANNELS] = {m_tdmsIndex->findChannel("/'Group'/'ch1'"), m_tdmsIndex->findChannel("/'Group'/'ch2'")};
+    size_t sizes[MAX_DAC_CHANNELS] = {0, 0};
+    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+        if (!channels[idx])
+            continue;
+        switch (channels[idx]->type) {
+            case TDMS::TDMSType::Integer8:
+            case TDMS::TDMSType::UnsignedInteger8:
+            case TDMS::TDMSType::Integer16:
+            case TDMS::TDMSType::UnsignedInteger16:
+                break;
+            default:
+                return OpenResult::OR_WRONG_DATA_TYPE;
+        }
+        sizes[idx] = channels[idx]->samples * channels[idx]->typeSize;
+    }
+    if (!channels[0] && !channels[1])
+        return OpenResult::OR_MISSING_CHANNELS;
+    if (sizes[0] != 0 && sizes[1] != 0 && sizes[0] != sizes[1])
+        return OpenResult::OR_DATA_NOT_EQUAL;
+    m_channel1Present = channels[0] != nullptr;
+    m_channel2Present = channels[1] != nullptr;
+    m_channel1Size = sizes[0];
+    m_channel2Size = sizes[1];
+
+    // Blocks are played in file order, like the metadata of the stream reader. Only single channel data is split.
+    m_chunks.clear();
+    bool split = !(channels[0] && channels[1]);
+    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+        if (!channels[idx])
+            continue;
+        auto typeSize = channels[idx]->typeSize;
+        for (auto& block : channels[idx]->blocks) {
+            size_t maxSamples = split && block.stride == typeSize ? g_mmap_chunk / typeSize : block.count;
+            for (uint64_t pos = 0; pos < block.count; pos += maxSamples) {
+                MappedChunk chunk;
+                chunk.offset = block.offset + pos * block.stride;
+                chunk.size = std::min<uint64_t>(maxSamples, block.count - pos) * typeSize;
+                chunk.channel = idx;
+                chunk.bits = typeSize * 8;
+                chunk.stride = block.stride;
+                m_chunks.push_back(chunk);
+            }
+        }
+    }
+    std::stable_sort(m_chunks.begin(), m_chunks.end(), [](const MappedChunk& a, const MappedChunk& b) { return a.offset < b.offset; });
+    return OpenResult::OR_OK;
+}
\ No newline at end of file
@@ -5,9 +5,11 @@
 #include <functional>
 #include <string>
 #include <vector>
+#include "mapped_file.h"
 #include "settings_lib/channels.hpp"
 #include "settings_lib/stream_settings.h"
 #include "tdms_lib/file.h"
+#include "tdms_lib/index_file.h"
 #include "wav_lib/wav_reader.h"
 
 /**
@@ -55,11 +57,19 @@ class CReaderController {
 	enum BufferResult { BR_OK = 0, BR_ENDED = 1, BR_BROKEN = 2, BR_EMPTY = 3 };
 
     using Ptr = shared_ptr<CReaderController>;
-    static Ptr Create(CStreamSettings::DataFormat _fileType, string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize);
+    static Ptr Create(CStreamSettings::DataFormat _fileType, string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize,
+                      bool useMmap = true);
 
     static Ptr Create(DataIn* dataIn, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize);
 
-    CReaderController(CStreamSettings::DataFormat _fileType, string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize);
+    /**
+     * With useMmap the file is mapped into memory and played directly from the page cache.
+     * A background thread reads ahead of the playback position. Repeats do not read the file again.
+     * TDMS files are opened through TDMS::IndexedFile, so only the metadata (or the .tdms_index sidecar) is read on open.
+     * Files that can't be mapped or indexed use the stream reader.
+     */
+    CReaderController(CStreamSettings::DataFormat _fileType, string _filePath, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize,
+                      bool useMmap = true);
 
     CReaderController(DataIn* dataIn, CStreamSettings::DACRepeat _repeat, uint32_t _rep_count, uint32_t blockSize);
 
@@ -70,6 +80,9 @@ class CReaderController {
     auto isOpen() -> CReaderController::OpenResult;
     auto checkFile() -> OpenResult;
     auto getBufferPrepared(Data& data) -> BufferResult;
+    // Same as above, but fills the given buffers of m_blockSize bytes (e.g. DMA memory) instead of the internal ones.
+    auto getBufferPrepared(Data& data, std::array<uint8_t*, MAX_DAC_CHANNELS> dst) -> BufferResult;
+    auto isMapped() -> bool;
 	auto getChannels(dac_channels_t &channels) -> void;
 	auto getChannelsSize(size_t *ch1Size, size_t *ch2Size) -> void;
 	auto disableRepeatMode() -> void;
@@ -90,17 +103,32 @@ class CReaderController {
         TemperaryBuffer& operator=(TemperaryBuffer&&) = delete;
     };
 
+    struct MappedChunk {
+        uint64_t offset = 0;
+        size_t size = 0;
+        uint8_t channel = 0;  // DAC channel or MAPPED_STEREO for interleaved WAV frames
+        uint8_t bits = 0;
+        uint32_t stride = 0;  // Distance between samples of the channel in the file
+    };
+
+    static constexpr uint8_t MAPPED_STEREO = 0xFF;
+
     CReaderController(CReaderController const&) = delete;
     CReaderController& operator=(CReaderController const&) = delete;
 
     auto checkTDMSFile() -> OpenResult;
+    auto checkTDMSIndex() -> OpenResult;
     auto checkWavFile() -> OpenResult;
     auto checkMemory() -> OpenResult;
     auto getBuffer(Data& data) -> bool;
     auto getBufferWav(Data& data) -> bool;
     auto getBufferTdms(Data& data) -> bool;
+    auto getBufferMapped(Data& data) -> bool;
+    auto openMapped() -> bool;
+    auto buildWavChunks() -> void;
     auto openWav() -> bool;
     auto openTDMS() -> bool;
+    auto openTDMSIndex() -> bool;
     auto moveNextMetadata() -> bool;
     auto resetReadFromBuffer() -> bool;
     auto writeFromTemp(uint8_t** buff, size_t max_size, size_t* write_pos, CReaderController::TemperaryBuffer* temp_buf, size_t* realSize) -> void;
@@ -128,6 +156,11 @@ class CReaderController {
 	uint8_t *m_dataBuffers[MAX_DAC_CHANNELS];
 	DataIn* m_genData;
     MemoryStreamSink* m_memSink;
+    CMappedFile* m_mapped;
+    vector<MappedChunk> m_chunks;
+    size_t m_currentChunk;
+    vector<uint8_t> m_stage[MAX_DAC_CHANNELS];
+    TDMS::IndexedFile* m_tdmsIndex;
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "stream_settings.h"
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -134,6 +135,10 @@ auto CStreamSettings::toJson() const -> std::string {
 
     adc_config["adc_capture_time"] = getADCCaptureTime().name();
 
+    adc_config["adc_net_protocol"] = getADCNetProtocol().name();
+    adc_config["adc_net_multicast"] = getADCNetMulticast();
+    adc_config["adc_net_datagram"] = getADCNetDatagram();
+
     for (auto i = 1u; i <= 4; i++) {
         adc_config["channel_state_" + to_string(i)] = getADCChannels(i).name();
         adc_config["channel_attenuator_" + to_string(i)] = getADCAttenuator(i).name();
@@ -219,6 +224,12 @@ auto CStreamSettings::parseJson(const std::string& json) -> bool {
             setADCCaptureTime(ADCCaptureTime::from_string(adc_config["adc_capture_time"].asString()));
         if (adc_config.isMember("use_calib"))
             setADCCalibration(State::from_string(adc_config["use_calib"].asString()));
+        if (adc_config.isMember("adc_net_protocol"))
+            setADCNetProtocol(NetProtocol::from_string(adc_config["adc_net_protocol"].asString()));
+        if (adc_config.isMember("adc_net_multicast"))
+            setADCNetMulticast(adc_config["adc_net_multicast"].asString());
+        if (adc_config.isMember("adc_net_datagram"))
+            setADCNetDatagram(adc_config["adc_net_datagram"].asUInt());
         for (auto i = 1u; i <= 4; i++) {
             if (adc_config.isMember("channel_state_" + to_string(i)))
                 setADCChannels(i, State::from_string(adc_config["channel_state_" + to_string(i)].asString()));
@@ -275,6 +286,9 @@ auto CStreamSettings::toString() const -> std::string {
     str += "Resolution:\t\t" + std::string(getADCResolution().to_string()) + "\n";
     str += "Use calibration:\t\t" + std::string(getADCCalibration().to_string()) + "\n";
     str += "Pass mode:\t\t" + std::string(getADCPassMode().to_string()) + "\n";
+    str += "Protocol:\t\t" + std::string(getADCNetProtocol().to_string()) + " (In network mode)\n";
+    str += "Multicast group:\t" + (getADCNetMulticast() == "" ? "Off" : getADCNetMulticast()) + " (UDP only)\n";
+    str += "Datagram size:\t\t" + std::to_string(getADCNetDatagram()) + " (UDP only)\n";
     str += "Samples:\t\t" + (getADCSamples() == 0 ? "Unlimited" : std::to_string(getADCSamples())) + " (In file mode)\n";
     str += "Data format:\t\t" + std::string(getADCFormat().to_string()) + " (In file mode)\n";
     str += "Data type:\t\t" + std::string(getADCType().to_string()) + " (In file mode)\n";
@@ -426,6 +440,41 @@ auto CStreamSettings::getADCCalibration() const -> State {
     return m_adcsettings.m_useCalib;
 }
 
+auto CStreamSettings::setADCNetProtocol(NetProtocol _protocol) -> void {
+    m_adcsettings.m_netProtocol = _protocol;
+}
+
+auto CStreamSettings::getADCNetProtocol() const -> NetProtocol {
+    return m_adcsettings.m_netProtocol;
+}
+
+auto CStreamSettings::setADCNetMulticast(std::string _group) -> bool {
+    // Empty for unicast, otherwise an IPv4 address from 224.0.0.0 to 239.255.255.255
+    if (_group != "") {
+        unsigned a, b, c, d;
+        char tail;
+        if (sscanf(_group.c_str(), "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a < 224 || a > 239 || b > 255 || c > 255 || d > 255)
+            return false;
+    }
+    m_adcsettings.m_netMulticast = _group;
+    return true;
+}
+
+auto CStreamSettings::getADCNetMulticast() const -> std::string {
+    return m_adcsettings.m_netMulticast;
+}
+
+auto CStreamSettings::setADCNetDatagram(uint32_t _size) -> bool {
+    if (_size < 256 || _size > 65000)
+        return false;
+    m_adcsettings.m_netDatagram = _size;
+    return true;
+}
+
+auto CStreamSettings::getADCNetDatagram() const -> uint32_t {
+    return m_adcsettings.m_netDatagram;
+}
+
 auto CStreamSettings::setDACFile(std::string _value) -> void {
     m_dacsettings.m_file = _value;
 }
@@ -567,6 +616,19 @@ auto CStreamSettings::setValue(std::string key, std::string value) -> bool {
             return true;
         }
 
+        if (key == "adc_net_protocol") {
+            setADCNetProtocol(NetProtocol::from_string(value));
+            return true;
+        }
+
+        if (key == "adc_net_multicast") {
+            return setADCNetMulticast(value);
+        }
+
+        if (key == "adc_net_datagram") {
+            return setADCNetDatagram(to_uint(value.c_str()));
+        }
+
         for (auto i = 1u; i <= 4; i++) {
             if (key == "channel_state_" + to_string(i)) {
                 return setADCChannels(i, State::from_string(value));
@@ -676,6 +738,18 @@ auto CStreamSettings::getValue(std::string key) -> std::string {
             return getADCCalibration().name();
         }
 
+        if (key == "adc_net_protocol") {
+            return getADCNetProtocol().name();
+        }
+
+        if (key == "adc_net_multicast") {
+            return getADCNetMulticast();
+        }
+
+        if (key == "adc_net_datagram") {
+            return std::to_string(getADCNetDatagram());
+        }
+
         for (auto i = 1u; i <= 4; i++) {
             if (key == "channel_state_" + to_string(i)) {
                 return getADCChannels(i).name();
@@ -767,6 +841,9 @@ auto CStreamSettings::getHelp() -> std::string {
     s += "adc_decimation\t\t: An unsigned integer value: 1-65535.\n";
     s += "use_calib\t\t: " + concat(CStreamSettings::State::names(), CStreamSettings::State::count) + "\n";
     s += "adc_capture_time\t\t: " + concat(CStreamSettings::ADCCaptureTime::names(), CStreamSettings::ADCCaptureTime::count) + "\n";
+    s += "adc_net_protocol\t: " + concat(CStreamSettings::NetProtocol::names(), CStreamSettings::NetProtocol::count) + "\n";
+    s += "adc_net_multicast\t: IPv4 multicast group for UDP, 224.0.0.0-239.255.255.255. Empty sends to each client.\n";
+    s += "adc_net_datagram\t: Data bytes per UDP datagram: 256-65000. 1424 for a 1500 byte MTU, 8920 for jumbo frames.\n";
     for (auto i = 1u; i <= 4; i++) {
         s += "channel_state_" + to_string(i) + "\t\t: " + concat(CStreamSettings::State::names(), CStreamSettings::State::count) + "\n";
         s += "channel_attenuator_" + to_string(i) + "\t: " + concat(CStreamSettings::Attenuator::names(), CStreamSettings::Attenuator::count) + "\n";
@@ -24,6 +24,8 @@ class CStreamSettings {
 
     ENUM(PassMode, NET = 0, "Network", FILE = 1, "File")
 
+    ENUM(NetProtocol, TCP = 0, "TCP", UDP = 1, "UDP")
+
     ENUM(DACPassMode, DAC_NET = 0, "Network", DAC_FILE = 1, "File")
 
     ENUM(DACRepeat, DAC_REP_OFF = -1, "Off", DAC_REP_INF = -2, "Infinity", DAC_REP_ON = 0, "On")
@@ -71,6 +73,12 @@ class CStreamSettings {
     auto getADCAC_DC(uint8_t _channel) const -> AC_DC;
     auto setADCCalibration(State _calibration) -> void;
     auto getADCCalibration() const -> State;
+    auto setADCNetProtocol(NetProtocol _protocol) -> void;
+    auto getADCNetProtocol() const -> NetProtocol;
+    auto setADCNetMulticast(std::string _group) -> bool;
+    auto getADCNetMulticast() const -> std::string;
+    auto setADCNetDatagram(uint32_t _size) -> bool;
+    auto getADCNetDatagram() const -> uint32_t;
 
     auto setDACSpeed(uint32_t _value) -> bool;
     auto getDACSpeed() const -> uint32_t;
@@ -116,6 +124,9 @@ class CStreamSettings {
         State m_useCalib = State::ON;
         AC_DC m_ac_dc[4] = {AC_DC::DC, AC_DC::DC, AC_DC::DC, AC_DC::DC};
         ADCCaptureTime m_captureTime = ADCCaptureTime::ON;
+        NetProtocol m_netProtocol = NetProtocol::TCP;
+        std::string m_netMulticast = "";
+        uint32_t m_netDatagram = 1424;
     };
 
     struct MemorySettings {
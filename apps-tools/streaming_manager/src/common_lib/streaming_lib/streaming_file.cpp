@@ -124,6 +124,7 @@ auto CStreamingFile::run(std::string _prefix, std::string _fileName) -> void {
     m_passSizeSamples[DataLib::CH2] = 0;
     m_passSizeSamples[DataLib::CH3] = 0;
     m_passSizeSamples[DataLib::CH4] = 0;
+    m_passMergedSamples.clear();
 
     m_file_out = _fileName == "" ? getNewFileName(m_fileType, m_filePath, _prefix) : _fileName;
     m_fileLogger = CFileLogger::create(m_file_out + ".log", m_testMode);
@@ -157,7 +158,10 @@ auto CStreamingFile::stopAndFlush() -> void {
 }
 
 auto CStreamingFile::convertBuffers(DataLib::CDataBuffersPackDMA::Ptr pack, DataLib::EDataBuffersPackChannel channel, bool lockADCTo1V) -> SBuffPass {
-    auto src_buff = pack->getBuffer(channel);
+    return convertBuffers(pack->getBuffer(channel), lockADCTo1V);
+}
+
+auto CStreamingFile::convertBuffers(DataLib::CDataBufferDMA::Ptr src_buff, bool lockADCTo1V) -> SBuffPass {
     if (!src_buff) {
         auto pbuff = SBuffPass();
         pbuff.buffer = nullptr;
@@ -252,6 +256,9 @@ auto CStreamingFile::getPassSamples() -> uint64_t {
         DataLib::EDataBuffersPackChannel ch = (DataLib::EDataBuffersPackChannel)i;
         all = std::max(all, m_passSizeSamples[ch]);
     }
+    for (auto samples : m_passMergedSamples) {
+        all = std::max(all, samples);
+    }
     return all;
 }
 
@@ -455,3 +462,86 @@ auto CStreamingFile::passBuffers(DataLib::CDataBuffersPackDMA::Ptr pack) -> int
     }
     return 1;
 }
+
+auto CStreamingFile::passMergedBuffers(const std::vector<SMergedChannel>& channels, int64_t timeCapture) -> int {
+    if (channels.size() == 0)
+        return 0;
+
+    if (m_fileType.value == CStreamSettings::DataFormat::BIN) {
+        // The BIN header has 4 channels. The merged channels take their places in order.
+        if (channels.size() > 4) {
+            ERROR_LOG("BIN file holds at most 4 channels. Merged channels %d", (int)channels.size())
+            return 0;
+        }
+        auto pack = DataLib::CDataBuffersPackDMA::Create();
+        for (size_t i = 0; i < channels.size(); i++) {
+            pack->addBuffer((DataLib::EDataBuffersPackChannel)i, channels[i].buffer);
+        }
+        return passBuffers(pack);
+    }
+
+    bool isWAV = m_fileType.value == CStreamSettings::DataFormat::WAV;
+    std::vector<std::pair<std::string, SBuffPass>> buffers;
+    uint64_t bufSamples = 0;
+    uint64_t rate = 0;
+    m_passMergedSamples.resize(channels.size(), 0);
+    for (size_t i = 0; i < channels.size(); i++) {
+        // WAV type support float full range -1...1. adc_mode always equal 1
+        auto pbuff = convertBuffers(channels[i].buffer, isWAV);
+        if (pbuff.buffer.get() == nullptr && pbuff.bufferLen) {
+            m_fileLogger->addMetric(CFileLogger::EMetric::OUT_OF_MEMORY, 1);
+            return 0;
+        }
+        if (m_samples != 0 && pbuff.samplesCount + m_passMergedSamples[i] > m_samples) {
+            pbuff.samplesCount = m_samples - m_passMergedSamples[i];
+            pbuff.bufferLen = pbuff.samplesCount * (pbuff.bitsBySample / 8);
+        }
+        m_passMergedSamples[i] += pbuff.samplesCount;
+        buffers.push_back({channels[i].name, pbuff});
+        bufSamples = std::max<uint64_t>(bufSamples, channels[i].buffer->getSamplesCount());
+        rate = std::max(rate, channels[i].buffer->getADCBaseRate());
+        m_fileLogger->addMetric(CFileLogger::EMetric::RECIVE_DATE, channels[i].buffer->getDataLenght());
+    }
+    m_fileLogger->addMetric(CFileLogger::EMetric::OSC_RATE, rate);
+
+    std::iostream* stream_data = nullptr;
+    if (isWAV) {
+        std::vector<SBuffPass> wavBuffers;
+        for (auto& item : buffers) {
+            wavBuffers.push_back(item.second);
+        }
+        stream_data = m_waveWriter->BuildWAVStream(wavBuffers);
+    } else {
+        auto time = std::make_shared<std::vector<int64_t>>();
+        if (timeCapture != 0 && bufSamples != 0) {
+            time->resize(bufSamples);
+            double period_ns = (rate > 0) ? (1.0 / rate) * 1e9 : 0;
+            for (auto idx = 0u; idx < bufSamples; idx++) {
+                time->at(idx) = timeCapture + (uint64_t)(period_ns * idx);
+            }
+        }
+        stream_data = buildTDMSStream(buffers, time);
+    }
+
+    if (m_file_manager->isWork()) {
+        if (!m_file_manager->addBufferToWrite(stream_data)) {
+            m_fileLogger->addMetric(CFileLogger::EMetric::FILESYSTEM_RATE, 1);
+        }
+    } else {
+        delete stream_data;
+    }
+
+    if (m_samples) {
+        bool reachLimits = true;
+        for (auto samples : m_passMergedSamples) {
+            if (samples < m_samples) {
+                reachLimits = false;
+                break;
+            }
+        }
+        if (reachLimits) {
+            stop(CStreamingFile::REACH_LIMIT, true);
+        }
+    }
+    return 1;
+}
@@ -15,6 +15,12 @@
 
 namespace streaming_lib {
 
+// One channel of a frame merged from several boards
+struct SMergedChannel {
+    std::string name;
+    DataLib::CDataBufferDMA::Ptr buffer;
+};
+
 class CStreamingFile {
    public:
     enum EStopReason { NORMAL = 0, OUT_SPACE = 1, REACH_LIMIT = 2 };
@@ -37,6 +43,8 @@ class CStreamingFile {
     auto isFileThreadWork() -> bool;
     auto isOutOfSpace() -> bool;
     auto passBuffers(DataLib::CDataBuffersPackDMA::Ptr pack) -> int;
+    // Writes the channels of several boards as one stream. A BIN file holds at most 4 channels.
+    auto passMergedBuffers(const std::vector<SMergedChannel>& channels, int64_t timeCapture) -> int;
 
     sigslot::signal<EStopReason> stopNotify;
 
@@ -65,6 +73,7 @@ class CStreamingFile {
     uint64_t m_samples;
     std::mutex m_stopMtx;
     std::map<DataLib::EDataBuffersPackChannel, uint64_t> m_passSizeSamples;
+    std::vector<uint64_t> m_passMergedSamples;
 
     bool m_testMode;
     bool m_volt_mode;
@@ -75,6 +84,7 @@ class CStreamingFile {
 
     auto stop(EStopReason reason, bool _flush) -> void;
     auto convertBuffers(DataLib::CDataBuffersPackDMA::Ptr pack, DataLib::EDataBuffersPackChannel channel, bool lockADCTo1V) -> SBuffPass;
+    auto convertBuffers(DataLib::CDataBufferDMA::Ptr src_buff, bool lockADCTo1V) -> SBuffPass;
 };
 
 }  // namespace streaming_lib
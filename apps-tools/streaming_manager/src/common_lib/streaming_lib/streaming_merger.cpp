@@ -0,0 +1,326 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include "logger_lib/file_logger.h"
+#include "streaming_merger.h"
+
+using namespace streaming_lib;
+
+static auto getPackId(DataLib::CDataBuffersPackDMA::Ptr pack) -> uint64_t {
+    for (auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++) {
+        auto buff = pack->getBuffer((DataLib::EDataBuffersPackChannel)i);
+        if (buff) {
+            return buff->getADCPackId();
+        }
+    }
+    return 0;
+}
+
+auto CStreamingMerger::create(CStreamingFile::Ptr file, uint32_t window) -> CStreamingMerger::Ptr {
+    return std::make_shared<CStreamingMerger>(file, window);
+}
+
+CStreamingMerger::CStreamingMerger(CStreamingFile::Ptr file, uint32_t window)
+    : m_file(file), m_window(window ? window : 1), m_boards(), m_frames(0), m_aligned(false), m_ended(false), m_stop(false), m_writing(false) {}
+
+CStreamingMerger::~CStreamingMerger() {
+    stop();
+    TRACE("Exit")
+}
+
+auto CStreamingMerger::addBoard(std::string host) -> int {
+    std::lock_guard lock(m_mtx);
+    SBoard board;
+    board.host = host;
+    board.statistic.host = host;
+    m_boards.push_back(board);
+    return m_boards.size() - 1;
+}
+
+auto CStreamingMerger::run() -> void {
+    m_stop = false;
+    m_thread = std::thread(&CStreamingMerger::task, this);
+}
+
+auto CStreamingMerger::stop() -> void {
+    {
+        std::lock_guard lock(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::lock_guard lock(m_mtx);
+    dropAll();
+    m_releasedCv.notify_all();
+}
+
+auto CStreamingMerger::passBuffers(int board, DataLib::CBuffersCached::Ptr buffers, DataLib::CDataBuffersPackDMA::Ptr pack) -> void {
+    std::lock_guard lock(m_mtx);
+    auto& b = m_boards[board];
+    if (m_ended || m_stop || b.finished) {
+        buffers->unlockBufferRead();
+        return;
+    }
+    if (b.layout.empty()) {
+        for (auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++) {
+            auto ch = (DataLib::EDataBuffersPackChannel)i;
+            auto buff = pack->getBuffer(ch);
+            if (buff) {
+                b.layout.push_back({ch, buff->getBitBySample(), buff->getDataLenght(), buff->getADCBaseRate()});
+            }
+        }
+    }
+    b.queue.push_back({pack, buffers, std::chrono::steady_clock::now()});
+    m_cv.notify_all();
+}
+
+auto CStreamingMerger::finishBoard(int board) -> void {
+    std::unique_lock lock(m_mtx);
+    m_boards[board].finished = true;
+    m_cv.notify_all();
+    m_releasedCv.wait(lock, [&] { return m_boards[board].queue.empty() && !m_writing; });
+}
+
+auto CStreamingMerger::getFrames() -> uint64_t {
+    std::lock_guard lock(m_mtx);
+    return m_frames;
+}
+
+auto CStreamingMerger::getStatistic() -> std::vector<SBoardStatistic> {
+    std::lock_guard lock(m_mtx);
+    std::vector<SBoardStatistic> statistic;
+    for (auto& b : m_boards) {
+        statistic.push_back(b.statistic);
+    }
+    return statistic;
+}
+
+auto CStreamingMerger::dropFront(SBoard& board) -> void {
+    board.queue.front().buffers->unlockBufferRead();
+    board.queue.pop_front();
+}
+
+auto CStreamingMerger::dropAll() -> void {
+    for (auto& b : m_boards) {
+        while (!b.queue.empty()) {
+            dropFront(b);
+        }
+    }
+}
+
+auto CStreamingMerger::task() -> void {
+    std::unique_lock lock(m_mtx);
+    while (!m_stop) {
+        std::vector<SQueuedPack> packs;
+        if (takeFrame(&packs)) {
+            m_writing = true;
+            lock.unlock();
+            writeFrame(packs);
+            lock.lock();
+            m_writing = false;
+            m_releasedCv.notify_all();
+            continue;
+        }
+        m_releasedCv.notify_all();
+        m_cv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+auto CStreamingMerger::align() -> bool {
+    for (auto& b : m_boards) {
+        if (b.queue.empty()) {
+            return false;
+        }
+    }
+
+    // The board that started last sets the first frame. Packs that end before it are dropped.
+    // Without capture time the first packs are taken as simultaneous.
+    int64_t start = 0;
+    bool useTime = true;
+    for (auto& b : m_boards) {
+        auto time = b.queue.front().pack->getTimeCapture();
+        useTime = useTime && time != 0;
+        start = std::max(start, time);
+    }
+
+    if (useTime) {
+        for (auto& b : m_boards) {
+            while (!b.queue.empty()) {
+                auto pack = b.queue.front().pack;
+                auto rate = pack->getOSCRate();
+                int64_t duration = rate ? pack->getBuffersSamples() * 1000000000ull / rate : 0;
+                if (pack->getTimeCapture() + duration / 2 >= start) {
+                    break;
+                }
+                dropFront(b);
+            }
+            if (b.queue.empty()) {
+                return false;
+            }
+        }
+    }
+
+    for (auto& b : m_boards) {
+        b.nextPackId = getPackId(b.queue.front().pack);
+    }
+    m_aligned = true;
+    return true;
+}
+
+auto CStreamingMerger::isFrameReady() -> bool {
+    bool waiting = false;
+    for (auto& b : m_boards) {
+        waiting = waiting || b.queue.empty();
+    }
+    if (!waiting) {
+        return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& b : m_boards) {
+        if (b.queue.empty()) {
+            continue;
+        }
+        if (b.finished || b.queue.size() >= m_window || now - b.queue.front().time > std::chrono::milliseconds(MERGER_WAIT_TIMEOUT)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto CStreamingMerger::takeFrame(std::vector<SQueuedPack>* packs) -> bool {
+    if (m_ended || m_boards.empty()) {
+        dropAll();
+        return false;
+    }
+
+    if (!m_aligned) {
+        bool finished = false;
+        for (auto& b : m_boards) {
+            // Before the start only the last packs of the window are kept
+            while (b.queue.size() > m_window) {
+                dropFront(b);
+            }
+        }
+        bool aligned = align();
+        for (auto& b : m_boards) {
+            finished = finished || (b.finished && b.queue.empty());
+        }
+        if (!aligned) {
+            // A board stopped before the boards could be aligned
+            if (finished) {
+                m_ended = true;
+                dropAll();
+            }
+            return false;
+        }
+    }
+
+    for (auto& b : m_boards) {
+        while (!b.queue.empty() && getPackId(b.queue.front().pack) < b.nextPackId) {
+            dropFront(b);
+        }
+        if (b.finished && b.queue.empty()) {
+            m_ended = true;
+            dropAll();
+            return false;
+        }
+    }
+
+    if (!isFrameReady()) {
+        return false;
+    }
+
+    bool present = false;
+    for (auto& b : m_boards) {
+        present = present || (!b.queue.empty() && getPackId(b.queue.front().pack) == b.nextPackId);
+    }
+
+    if (!present) {
+        // No board has this pack, skip to the first pack that any board has
+        uint64_t skip = UINT64_MAX;
+        for (auto& b : m_boards) {
+            if (!b.queue.empty()) {
+                skip = std::min(skip, getPackId(b.queue.front().pack) - b.nextPackId);
+            }
+        }
+        for (auto& b : m_boards) {
+            b.nextPackId += skip;
+            b.statistic.missingPacks += skip;
+            for (auto& l : b.layout) {
+                b.statistic.lostSamples += skip * (l.lenght * 8 / l.bits);
+            }
+        }
+        return takeFrame(packs);
+    }
+
+    int64_t reference = 0;
+    for (auto& b : m_boards) {
+        SQueuedPack item;
+        if (!b.queue.empty() && getPackId(b.queue.front().pack) == b.nextPackId) {
+            item = b.queue.front();
+            b.queue.pop_front();
+        }
+        packs->push_back(item);
+        auto pack = item.pack;
+        b.nextPackId++;
+
+        if (pack) {
+            b.statistic.packs++;
+            for (auto& l : b.layout) {
+                auto buff = pack->getBuffer(l.channel);
+                if (buff) {
+                    b.statistic.lostSamples += buff->getLostSamplesAll();
+                }
+            }
+            auto time = pack->getTimeCapture();
+            if (reference == 0) {
+                reference = time;
+            }
+            if (reference != 0 && time != 0) {
+                b.statistic.skew = time - reference;
+                b.statistic.maxSkew = std::max(b.statistic.maxSkew, std::abs(b.statistic.skew));
+            }
+        } else {
+            b.statistic.missingPacks++;
+            for (auto& l : b.layout) {
+                b.statistic.lostSamples += l.lenght * 8 / l.bits;
+            }
+        }
+    }
+    m_frames++;
+    return true;
+}
+
+auto CStreamingMerger::writeFrame(const std::vector<SQueuedPack>& packs) -> void {
+    // The layouts do not change after the first pack of each board, which came before the alignment
+    int64_t timeCapture = 0;
+    std::vector<SMergedChannel> channels;
+    for (size_t i = 0; i < packs.size(); i++) {
+        auto& board = m_boards[i];
+        auto pack = packs[i].pack;
+        for (auto& l : board.layout) {
+            SMergedChannel channel;
+            channel.name = board.host + "_ch" + std::to_string(l.channel + 1);
+            channel.buffer = pack ? pack->getBuffer(l.channel) : nullptr;
+            if (!channel.buffer) {
+                channel.buffer = DataLib::CDataBufferDMA::Create(new uint8_t[l.lenght](), l.lenght, l.bits);
+                channel.buffer->setADCBaseRate(l.rate);
+            }
+            channels.push_back(channel);
+        }
+        if (pack && timeCapture == 0) {
+            timeCapture = pack->getTimeCapture();
+        }
+    }
+
+    m_file->passMergedBuffers(channels, timeCapture);
+
+    for (auto& item : packs) {
+        if (item.pack) {
+            item.buffers->unlockBufferRead();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef STREAMING_LIB_STREAMING_MERGER_H
+#define STREAMING_LIB_STREAMING_MERGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data_lib/buffers_cached.h"
+#include "streaming_file.h"
+
+#define MERGER_DEFAULT_WINDOW 32
+#define MERGER_WAIT_TIMEOUT 1000  // ms
+
+namespace streaming_lib {
+
+// Merges the ADC streams of several boards into one file.
+// The packs stay in the cached buffers of their board until the frame is written, so the reorder window costs no copy.
+// The boards are aligned once on the capture time of their first packs, after that the pack ids advance together.
+// When a board has no pack for a frame and another board has a full window, or waited too long,
+// the missing board is written as zeros and its samples are counted as lost.
+class CStreamingMerger {
+   public:
+    using Ptr = std::shared_ptr<CStreamingMerger>;
+
+    struct SBoardStatistic {
+        std::string host;
+        uint64_t packs = 0;
+        uint64_t missingPacks = 0;
+        uint64_t lostSamples = 0;  // FPGA and network losses and the samples of missing packs, all channels
+        int64_t skew = 0;          // Capture time against the first board of the last frame, ns
+        int64_t maxSkew = 0;
+    };
+
+    static auto create(CStreamingFile::Ptr file, uint32_t window = MERGER_DEFAULT_WINDOW) -> Ptr;
+
+    CStreamingMerger(CStreamingFile::Ptr file, uint32_t window);
+    ~CStreamingMerger();
+
+    // Boards are added before run. The first board is the time reference.
+    auto addBoard(std::string host) -> int;
+    auto run() -> void;
+    auto stop() -> void;
+
+    // Called from the receiver of the board. The read lock of the pack in buffers is released when the pack is written or dropped.
+    auto passBuffers(int board, DataLib::CBuffersCached::Ptr buffers, DataLib::CDataBuffersPackDMA::Ptr pack) -> void;
+    // The board stopped receiving. Returns when all its packs are released. The merged stream ends with the first finished board.
+    auto finishBoard(int board) -> void;
+
+    auto getFrames() -> uint64_t;
+    auto getStatistic() -> std::vector<SBoardStatistic>;
+
+   private:
+    CStreamingMerger(const CStreamingMerger&) = delete;
+    CStreamingMerger(CStreamingMerger&&) = delete;
+    CStreamingMerger& operator=(const CStreamingMerger&) = delete;
+    CStreamingMerger& operator=(const CStreamingMerger&&) = delete;
+
+    struct SChannelLayout {
+        DataLib::EDataBuffersPackChannel channel;
+        uint8_t bits;
+        size_t lenght;
+        uint64_t rate;
+    };
+
+    struct SQueuedPack {
+        DataLib::CDataBuffersPackDMA::Ptr pack;
+        DataLib::CBuffersCached::Ptr buffers;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    struct SBoard {
+        std::string host;
+        std::deque<SQueuedPack> queue;
+        std::vector<SChannelLayout> layout;  // Channels of the first pack
+        uint64_t nextPackId = 0;
+        bool finished = false;
+        SBoardStatistic statistic;
+    };
+
+    auto task() -> void;
+    auto align() -> bool;
+    auto isFrameReady() -> bool;
+    auto takeFrame(std::vector<SQueuedPack>* packs) -> bool;
+    auto writeFrame(const std::vector<SQueuedPack>& packs) -> void;
+    auto dropFront(SBoard& board) -> void;
+    auto dropAll() -> void;
+
+    CStreamingFile::Ptr m_file;
+    uint32_t m_window;
+    std::vector<SBoard> m_boards;
+    uint64_t m_frames;
+    bool m_aligned;
+    bool m_ended;
+    bool m_stop;
+    bool m_writing;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::condition_variable m_releasedCv;
+    std::thread m_thread;
+};
+
+}  // namespace streaming_lib
+
+#endif
@@ -9,14 +9,24 @@
 
 using namespace streaming_lib;
 
-auto CStreamingNet::create(std::string &_host, uint16_t _port) -> CStreamingNet::Ptr
+auto CStreamingNet::create(std::string &_host, uint16_t _port, net_lib::SNetTransport _transport) -> CStreamingNet::Ptr
 {
-	return std::make_shared<CStreamingNet>(_host, _port);
+	return std::make_shared<CStreamingNet>(_host, _port, _transport);
 }
 
-CStreamingNet::CStreamingNet(std::string &_host, uint16_t _port)
+auto CStreamingNet::getTransport(const CStreamSettings &_settings) -> net_lib::SNetTransport
+{
+	net_lib::SNetTransport transport;
+	transport.protocol = _settings.getADCNetProtocol().value == CStreamSettings::NetProtocol::UDP ? net_lib::P_UDP : net_lib::P_TCP;
+	transport.multicast = _settings.getADCNetMulticast();
+	transport.datagram = _settings.getADCNetDatagram();
+	return transport;
+}
+
+CStreamingNet::CStreamingNet(std::string &_host, uint16_t _port, net_lib::SNetTransport _transport)
 	: m_host(_host)
 	, m_port(_port)
+	, m_transport(_transport)
 	, m_asionet(nullptr)
 	, m_index_of_message(0)
 	, m_thread()
@@ -36,7 +46,7 @@ void CStreamingNet::startServer() {
     }
 
     m_index_of_message = 0;
-    m_asionet = new net_lib::CAsioNet(net_lib::EMode::M_SERVER, m_host, m_port, nullptr);
+    m_asionet = new net_lib::CAsioNet(net_lib::EMode::M_SERVER, m_host, m_port, nullptr, m_transport);
     m_asionet->serverConnectNotify.connect([](std::string host) { aprintf(stdout, "Connected %s\n", host.c_str()); });
     m_asionet->serverDisconnectNotify.connect([](std::string host) { aprintf(stdout, "Disconnect %s\n", host.c_str()); });
     m_asionet->start();
@@ -8,6 +8,7 @@
 
 #include "data_lib/buffers_pack.h"
 #include "net_lib/asio_net.h"
+#include "settings_lib/stream_settings.h"
 
 #define TCP_BUFFER_LIMIT 32 * 1024
 
@@ -19,9 +20,11 @@ class CStreamingNet {
     typedef std::function<DataLib::CDataBuffersPackDMA::Ptr()> getBufferFunc;
     typedef std::function<void()> unlockBufferFunc;
 
-    static auto create(std::string& _host, uint16_t _port) -> Ptr;
+    static auto create(std::string& _host, uint16_t _port, net_lib::SNetTransport _transport = {}) -> Ptr;
+    // Transport of the ADC stream from the adc_net_* settings
+    static auto getTransport(const CStreamSettings& _settings) -> net_lib::SNetTransport;
 
-    CStreamingNet(std::string& _host, uint16_t _port);
+    CStreamingNet(std::string& _host, uint16_t _port, net_lib::SNetTransport _transport = {});
     ~CStreamingNet();
 
     auto run() -> void;
@@ -40,6 +43,7 @@ class CStreamingNet {
 
     std::string m_host;
     uint16_t m_port;
+    net_lib::SNetTransport m_transport;
 
     net_lib::CAsioNet* m_asionet;
 
@@ -0,0 +1,481 @@
+#include "index_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include "data_lib/neon_asm.h"
+
+using namespace TDMS;
+
+#define LEAD_IN_SIZE 28
+#define TOC_META_DATA (1 << 1)
+#define TOC_NEW_OBJ_LIST (1 << 2)
+#define TOC_RAW_DATA (1 << 3)
+#define TOC_INTERLEAVED (1 << 5)
+#define TOC_BIG_ENDIAN (1 << 6)
+#define TOC_DAQMX (1 << 7)
+#define RAW_INDEX_NONE 0xFFFFFFFF
+#define RAW_INDEX_SAME 0x00000000
+#define RAW_INDEX_DAQMX_FORMAT 0x00001269
+#define RAW_INDEX_DAQMX_DIGITAL 0x0000126A
+
+namespace {
+
+struct LeadIn {
+    char tag[4];
+    uint32_t toc;
+    uint32_t version;
+    uint64_t nextSegment;
+    uint64_t rawData;
+};
+
+auto readLeadIn(const uint8_t* data, LeadIn* leadIn) -> void {
+    memcpy(leadIn->tag, data, 4);
+    memcpy(&leadIn->toc, data + 4, 4);
+    memcpy(&leadIn->version, data + 8, 4);
+    memcpy(&leadIn->nextSegment, data + 12, 8);
+    memcpy(&leadIn->rawData, data + 20, 8);
+}
+
+// Bounds checked reader of the metadata block
+struct MetaCursor {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    template <typename T>
+    auto get(T* value) -> bool {
+        if (end - pos < (ptrdiff_t)sizeof(T))
+            return false;
+        memcpy(value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    auto getString(string* value) -> bool {
+        uint32_t len = 0;
+        if (!get(&len) || end - pos < (ptrdiff_t)len)
+            return false;
+        if (value)
+            value->assign((const char*)pos, len);
+        pos += len;
+        return true;
+    }
+
+    auto skip(uint64_t size) -> bool {
+        if ((uint64_t)(end - pos) < size)
+            return false;
+        pos += size;
+        return true;
+    }
+};
+
+auto splitPath(const string& path, vector<string>* parts) -> void {
+    size_t pos = 0;
+    while ((pos = path.find("/'", pos)) != string::npos) {
+        string part;
+        pos += 2;
+        while (pos < path.size()) {
+            if (path[pos] == '\'') {
+                if (pos + 1 < path.size() && path[pos + 1] == '\'') {
+                    part += '\'';
+                    pos += 2;
+                    continue;
+                }
+                break;
+            }
+            part += path[pos++];
+        }
+        parts->push_back(part);
+    }
+}
+
+}  // namespace
+
+struct IndexedFile::State {
+    map<string, Object> objects;
+    vector<string> active;
+};
+
+IndexedFile::IndexedFile() : m_file(nullptr), m_mapping(nullptr), m_map(nullptr), m_size(0), m_indexUsed(false), m_channels() {}
+
+IndexedFile::~IndexedFile() {
+    close();
+}
+
+auto IndexedFile::getIndexFileName(const string& fileName) -> string {
+    return fileName + "_index";
+}
+
+auto IndexedFile::open(const string& fileName, bool writeIndex) -> bool {
+    close();
+    if (!mapFile(fileName)) {
+        close();
+        return false;
+    }
+
+    State state;
+    uint64_t dataEnd = 0;
+    auto indexName = getIndexFileName(fileName);
+    m_indexUsed = loadFromIndex(state, indexName, &dataEnd);
+    if (!m_indexUsed) {
+        state = State();
+        m_channels.clear();
+        dataEnd = 0;
+    }
+    if (dataEnd < m_size) {
+        // No index, or data was appended after the index was written
+        std::ofstream index;
+        if (writeIndex) {
+            index.open(indexName, ios::binary | (m_indexUsed ? ios::app : ios::trunc));
+        }
+        if (!loadFromData(state, dataEnd, index.is_open() ? &index : nullptr)) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+auto IndexedFile::close() -> void {
+    unmapFile();
+    m_size = 0;
+    m_indexUsed = false;
+    m_channels.clear();
+}
+
+#ifdef _WIN32
+
+auto IndexedFile::mapFile(const string& fileName) -> bool {
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < LEAD_IN_SIZE)
+        return false;
+    m_size = size.QuadPart;
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+        return false;
+    m_map = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    return m_map != nullptr;
+}
+
+auto IndexedFile::unmapFile() -> void {
+    if (m_map) {
+        UnmapViewOfFile(m_map);
+        m_map = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+}
+
+#else
+
+auto IndexedFile::mapFile(const string& fileName) -> bool {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < LEAD_IN_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    m_size = st.st_size;
+    void* map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    m_map = (uint8_t*)map;
+    return true;
+}
+
+auto IndexedFile::unmapFile() -> void {
+    if (m_map) {
+        munmap(m_map, m_size);
+        m_map = nullptr;
+    }
+}
+
+#endif  // _WIN32
+
+auto IndexedFile::isOpen() -> bool {
+    return m_map != nullptr;
+}
+
+auto IndexedFile::isIndexUsed() -> bool {
+    return m_indexUsed;
+}
+
+auto IndexedFile::getSize() -> uint64_t {
+    return m_size;
+}
+
+auto IndexedFile::getChannels() -> const vector<Channel>& {
+    return m_channels;
+}
+
+auto IndexedFile::findChannel(const string& name) -> const Channel* {
+    for (auto& ch : m_channels) {
+        if (ch.path == name || ch.name == name)
+            return &ch;
+    }
+    return nullptr;
+}
+
+auto IndexedFile::loadFromIndex(State& state, const string& indexName, uint64_t* dataEnd) -> bool {
+    std::ifstream file(indexName, ios::binary | ios::ate);
+    if (!file.is_open())
+        return false;
+    auto size = (uint64_t)file.tellg();
+    vector<uint8_t> index(size);
+    file.seekg(0);
+    if (size == 0 || !file.read((char*)index.data(), size))
+        return false;
+
+    uint64_t pos = 0;
+    uint64_t segment = 0;
+    uint64_t lastSegment = 0;
+    while (pos + LEAD_IN_SIZE <= size) {
+        LeadIn leadIn;
+        readLeadIn(index.data() + pos, &leadIn);
+        if (memcmp(leadIn.tag, "TDSh", 4) != 0 || pos + LEAD_IN_SIZE + leadIn.rawData > size || segment + LEAD_IN_SIZE > m_size)
+            return false;
+        if (!addSegment(state, index.data() + pos, index.data() + pos + LEAD_IN_SIZE, leadIn.rawData, segment))
+            return false;
+        pos += LEAD_IN_SIZE + leadIn.rawData;
+        lastSegment = segment;
+        if (leadIn.nextSegment == (uint64_t)-1) {
+            segment = m_size;
+            break;
+        }
+        segment += LEAD_IN_SIZE + leadIn.nextSegment;
+    }
+    // Only the last segment is checked, so that opening does not touch the whole data file
+    if (pos != size || memcmp(m_map + lastSegment, "TDSm", 4) != 0 || segment > m_size)
+        return false;
+    *dataEnd = segment;
+    return true;
+}
+
+auto IndexedFile::loadFromData(State& state, uint64_t start, std::ostream* index) -> bool {
+    uint64_t segment = start;
+    while (segment + LEAD_IN_SIZE <= m_size) {
+        LeadIn leadIn;
+        readLeadIn(m_map + segment, &leadIn);
+        if (memcmp(leadIn.tag, "TDSm", 4) != 0)
+            return false;
+        uint64_t metaSize = std::min<uint64_t>(leadIn.rawData, m_size - segment - LEAD_IN_SIZE);
+        if (!addSegment(state, m_map + segment, m_map + segment + LEAD_IN_SIZE, metaSize, segment))
+            return false;
+        if (index) {
+            index->write("TDSh", 4);
+            index->write((const char*)m_map + segment + 4, LEAD_IN_SIZE - 4 + metaSize);
+        }
+        if (leadIn.nextSegment == (uint64_t)-1)
+            break;
+        segment += LEAD_IN_SIZE + leadIn.nextSegment;
+    }
+    return true;
+}
+
+auto IndexedFile::addSegment(State& state, const uint8_t* leadInData, const uint8_t* meta, uint64_t metaSize, uint64_t segmentOffset) -> bool {
+    LeadIn leadIn;
+    readLeadIn(leadInData, &leadIn);
+    if (leadIn.toc & (TOC_BIG_ENDIAN | TOC_DAQMX))
+        return false;
+
+    if (leadIn.toc & TOC_META_DATA) {
+        if (leadIn.toc & TOC_NEW_OBJ_LIST)
+            state.active.clear();
+        MetaCursor cursor{meta, meta + metaSize};
+        uint32_t objects = 0;
+        if (!cursor.get(&objects))
+            return false;
+        for (uint32_t i = 0; i < objects; i++) {
+            string path;
+            uint32_t rawIndex = 0;
+            if (!cursor.getString(&path) || !cursor.get(&rawIndex))
+                return false;
+            auto& obj = state.objects[path];
+            bool hasRaw = rawIndex != RAW_INDEX_NONE;
+            if (rawIndex == RAW_INDEX_DAQMX_FORMAT || rawIndex == RAW_INDEX_DAQMX_DIGITAL)
+                return false;
+            if (hasRaw && rawIndex != RAW_INDEX_SAME) {
+                uint32_t type = 0;
+                uint32_t dimension = 0;
+                uint64_t count = 0;
+                if (!cursor.get(&type) || !cursor.get(&dimension) || !cursor.get(&count))
+                    return false;
+                obj.type = (TDMSType)type;
+                obj.count = count;
+                obj.size = count * DataType::GetLength(obj.type);
+                if (obj.type == TDMSType::String) {
+                    if (!cursor.get(&obj.size))
+                        return false;
+                }
+            }
+            auto it = std::find(state.active.begin(), state.active.end(), path);
+            if (hasRaw && it == state.active.end())
+                state.active.push_back(path);
+            if (!hasRaw && it != state.active.end())
+                state.active.erase(it);
+
+            uint32_t properties = 0;
+            if (!cursor.get(&properties))
+                return false;
+            for (uint32_t p = 0; p < properties; p++) {
+                uint32_t type = 0;
+                if (!cursor.getString(nullptr) || !cursor.get(&type))
+                    return false;
+                if ((TDMSType)type == TDMSType::String ? !cursor.getString(nullptr) : !cursor.skip(DataType::GetLength((TDMSType)type)))
+                    return false;
+            }
+
+            if (obj.channel < 0 && obj.type != TDMSType::Empty && obj.type != TDMSType::String) {
+                vector<string> parts;
+                splitPath(path, &parts);
+                if (parts.size() == 2) {
+                    Channel channel;
+                    channel.path = path;
+                    channel.group = parts[0];
+                    channel.name = parts[1];
+                    channel.type = obj.type;
+                    channel.typeSize = DataType::GetLength(obj.type);
+                    obj.channel = m_channels.size();
+                    m_channels.push_back(channel);
+                }
+            }
+        }
+    }
+
+    if (!(leadIn.toc & TOC_RAW_DATA))
+        return true;
+
+    uint64_t dataStart = segmentOffset + LEAD_IN_SIZE + leadIn.rawData;
+    uint64_t segmentEnd = leadIn.nextSegment == (uint64_t)-1 ? m_size : std::min(m_size, segmentOffset + LEAD_IN_SIZE + leadIn.nextSegment);
+    uint64_t chunkSize = 0;
+    uint32_t stride = 0;
+    bool interleaved = leadIn.toc & TOC_INTERLEAVED;
+    for (auto& path : state.active) {
+        auto& obj = state.objects[path];
+        if (interleaved && obj.type == TDMSType::String)
+            return false;
+        chunkSize += obj.size;
+        stride += DataType::GetLength(obj.type);
+    }
+    if (chunkSize == 0 || dataStart >= segmentEnd)
+        return true;
+
+    // A segment can hold several chunks with the same layout when the metadata did not change
+    uint64_t chunks = (segmentEnd - dataStart) / chunkSize;
+    for (uint64_t k = 0; k < chunks; k++) {
+        uint64_t offset = dataStart + k * chunkSize;
+        for (auto& path : state.active) {
+            auto& obj = state.objects[path];
+            if (obj.channel >= 0 && obj.count) {
+                auto& channel = m_channels[obj.channel];
+                if (channel.typeSize == DataType::GetLength(obj.type)) {
+                    Block block;
+                    block.offset = offset;
+                    block.firstSample = channel.samples;
+                    block.count = obj.count;
+                    block.stride = interleaved ? stride : channel.typeSize;
+                    auto& blocks = channel.blocks;
+                    if (!blocks.empty() && !interleaved && blocks.back().stride == block.stride &&
+                        blocks.back().offset + blocks.back().count * block.stride == block.offset) {
+                        blocks.back().count += block.count;
+                    } else {
+                        blocks.push_back(block);
+                    }
+                    channel.samples += obj.count;
+                }
+            }
+            offset += interleaved ? DataType::GetLength(obj.type) : obj.size;
+        }
+    }
+    return true;
+}
+
+auto IndexedFile::forEachBlock(const Channel* channel, uint64_t first, uint64_t count, const std::function<void(const uint8_t*, uint64_t, uint32_t)>& func) -> void {
+    if (!channel || !m_map || count == 0)
+        return;
+    auto& blocks = channel->blocks;
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), first, [](uint64_t value, const Block& block) { return value < block.firstSample; });
+    if (it == blocks.begin())
+        return;
+    for (--it; it != blocks.end() && count; ++it) {
+        uint64_t skip = first - it->firstSample;
+        if (skip >= it->count)
+            continue;
+        uint64_t n = std::min(count, it->count - skip);
+        func(m_map + it->offset + skip * it->stride, n, it->stride);
+        first += n;
+        count -= n;
+    }
+}
+
+auto IndexedFile::read(const Channel* channel, uint64_t first, uint64_t count, void* dst) -> uint64_t {
+    uint64_t copied = 0;
+    if (!channel)
+        return 0;
+    auto out = (uint8_t*)dst;
+    forEachBlock(channel, first, count, [&](const uint8_t* data, uint64_t n, uint32_t stride) {
+        deinterleave_neon(out, data, n, channel->typeSize, stride);
+        out += n * channel->typeSize;
+        copied += n;
+    });
+    return copied;
+}
+
+auto IndexedFile::writeIndex(const string& fileName) -> bool {
+    std::remove(getIndexFileName(fileName).c_str());
+    IndexedFile file;
+    return file.open(fileName, true);
+}
+
+auto IndexedFile::appendIndexSegment(std::iostream& segment, std::ostream& index) -> bool {
+    segment.seekg(0, segment.end);
+    uint64_t size = segment.tellg();
+    uint64_t pos = 0;
+    vector<char> meta;
+    while (pos + LEAD_IN_SIZE <= size) {
+        uint8_t leadInData[LEAD_IN_SIZE];
+        segment.seekg(pos, segment.beg);
+        if (!segment.read((char*)leadInData, LEAD_IN_SIZE))
+            return false;
+        LeadIn leadIn;
+        readLeadIn(leadInData, &leadIn);
+        if (memcmp(leadIn.tag, "TDSm", 4) != 0 || pos + LEAD_IN_SIZE + leadIn.rawData > size)
+            return false;
+        meta.resize(leadIn.rawData);
+        if (!segment.read(meta.data(), meta.size()))
+            return false;
+        index.write("TDSh", 4);
+        index.write((const char*)leadInData + 4, LEAD_IN_SIZE - 4);
+        index.write(meta.data(), meta.size());
+        if (leadIn.nextSegment == (uint64_t)-1)
+            break;
+        pos += LEAD_IN_SIZE + leadIn.nextSegment;
+    }
+    segment.clear();
+    segment.seekg(0, segment.beg);
+    return index.good();
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "data_type.h"
+
+namespace TDMS {
+
+/**
+ * Random access TDMS reader.
+ * The file is memory mapped and only the segment lead-ins and metadata are parsed, once, into a table of raw data blocks per channel.
+ * The metadata is taken from the "<file>.tdms_index" sidecar when it exists, so the data file is not walked at all.
+ * Samples are returned as spans pointing into the mapping or copied (de-interleaved) into caller buffers.
+ * Big-endian and DAQmx raw data are not supported.
+ */
+class IndexedFile {
+   public:
+    struct Block {
+        uint64_t offset = 0;       // File offset of the first sample
+        uint64_t firstSample = 0;  // Index of the first sample in the channel
+        uint64_t count = 0;
+        uint32_t stride = 0;  // Distance between samples in bytes. Equals the type size for continuous data
+    };
+
+    struct Channel {
+        string path;  // "/'Group'/'ch1'"
+        string group;
+        string name;
+        TDMSType type = TDMSType::Empty;
+        uint32_t typeSize = 0;
+        uint64_t samples = 0;
+        vector<Block> blocks;
+    };
+
+    template <typename T>
+    struct Span {
+        const T* data = nullptr;
+        uint64_t count = 0;
+        uint32_t stride = sizeof(T);
+        auto isContinuous() const -> bool { return stride == sizeof(T); }
+        auto at(uint64_t index) const -> T {
+            T value;
+            memcpy(&value, (const uint8_t*)data + index * stride, sizeof(T));
+            return value;
+        }
+    };
+
+    IndexedFile();
+    ~IndexedFile();
+
+    // Maps the file and loads the segment table. With writeIndex a missing or outdated index file is created.
+    auto open(const string& fileName, bool writeIndex = false) -> bool;
+    auto close() -> void;
+    auto isOpen() -> bool;
+    auto isIndexUsed() -> bool;
+    auto getSize() -> uint64_t;
+    auto getChannels() -> const vector<Channel>&;
+    // Accepts the full path or only the channel name
+    auto findChannel(const string& name) -> const Channel*;
+
+    // Spans over [first, first + count). Returns an empty list if T does not match the channel type size.
+    template <typename T>
+    auto getSpans(const Channel* channel, uint64_t first, uint64_t count) -> vector<Span<T>> {
+        vector<Span<T>> spans;
+        if (!channel || channel->typeSize != sizeof(T))
+            return spans;
+        forEachBlock(channel, first, count, [&](const uint8_t* data, uint64_t n, uint32_t stride) { spans.push_back({(const T*)data, n, stride}); });
+        return spans;
+    }
+
+    // Copies samples to dst. Returns the number of copied samples.
+    auto read(const Channel* channel, uint64_t first, uint64_t count, void* dst) -> uint64_t;
+
+    static auto getIndexFileName(const string& fileName) -> string;
+    // Creates the index file from the data file
+    static auto writeIndex(const string& fileName) -> bool;
+    // Appends the index part of the segments in the stream (lead-in with "TDSh" tag and metadata) to the index stream
+    static auto appendIndexSegment(std::iostream& segment, std::ostream& index) -> bool;
+
+   private:
+    IndexedFile(const IndexedFile&) = delete;
+    IndexedFile(IndexedFile&&) = delete;
+    IndexedFile& operator=(const IndexedFile&) = delete;
+    IndexedFile& operator=(const IndexedFile&&) = delete;
+
+    struct Object {
+        int32_t channel = -1;
+        TDMSType type = TDMSType::Empty;
+        uint64_t count = 0;
+        uint64_t size = 0;
+    };
+
+    struct State;
+
+    auto loadFromIndex(State& state, const string& indexName, uint64_t* dataEnd) -> bool;
+    auto loadFromData(State& state, uint64_t start, std::ostream* index) -> bool;
+    auto addSegment(State& state, const uint8_t* leadIn, const uint8_t* meta, uint64_t metaSize, uint64_t segmentOffset) -> bool;
+    auto mapFile(const string& fileName) -> bool;
+    auto unmapFile() -> void;
+    auto forEachBlock(const Channel* channel, uint64_t first, uint64_t count, const std::function<void(const uint8_t*, uint64_t, uint32_t)>& func) -> void;
+
+    void* m_file;     // Windows file handle
+    void* m_mapping;  // Windows file mapping handle
+    uint8_t* m_map;
+    uint64_t m_size;
+    bool m_indexUsed;
+    vector<Channel> m_channels;
+};
+
+}  // namespace TDMS
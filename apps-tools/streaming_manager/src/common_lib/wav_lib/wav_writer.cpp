@@ -12,11 +12,14 @@ auto CWaveWriter::resetHeaderInit() -> void {
 }
 
 auto CWaveWriter::BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_buffs) -> std::iostream* {
-    auto ch1 = new_buffs[DataLib::CH1];
-    auto ch2 = new_buffs[DataLib::CH2];
-    auto ch3 = new_buffs[DataLib::CH3];
-    auto ch4 = new_buffs[DataLib::CH4];
+    std::vector<SBuffPass> buffs;
+    for (auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++) {
+        buffs.push_back(new_buffs[(DataLib::EDataBuffersPackChannel)i]);
+    }
+    return BuildWAVStream(buffs);
+}
 
+auto CWaveWriter::BuildWAVStream(std::vector<SBuffPass> new_buffs) -> std::iostream* {
     // IF resolution = 32bit this FLOAT type data
     // Init variables
 
@@ -28,44 +31,16 @@ auto CWaveWriter::BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel, SBuf
     std::vector<uint8_t> channelsBits;
     std::vector<size_t> channelsSamples;
 
-    if (ch1.buffer.get()) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch1.samplesCount ? ch1.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch1.bitsBySample ? ch1.bitsBySample : maxBitBySample;
-        OSCRate = ch1.adcSpeed;
-        channels.push_back(ch1.buffer);
-        channelsBits.push_back(ch1.bitsBySample);
-        channelsSamples.push_back(ch1.samplesCount);
-    }
-
-    if (ch2.buffer.get()) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch2.samplesCount ? ch2.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch2.bitsBySample ? ch2.bitsBySample : maxBitBySample;
-        OSCRate = ch2.adcSpeed;
-        channels.push_back(ch2.buffer);
-        channelsBits.push_back(ch2.bitsBySample);
-        channelsSamples.push_back(ch2.samplesCount);
-    }
-
-    if (ch3.buffer.get()) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch3.samplesCount ? ch3.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch3.bitsBySample ? ch3.bitsBySample : maxBitBySample;
-        OSCRate = ch3.adcSpeed;
-        channels.push_back(ch3.buffer);
-        channelsBits.push_back(ch3.bitsBySample);
-        channelsSamples.push_back(ch3.samplesCount);
-    }
-
-    if (ch4.buffer.get()) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch4.samplesCount ? ch4.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch4.bitsBySample ? ch4.bitsBySample : maxBitBySample;
-        OSCRate = ch4.adcSpeed;
-        channels.push_back(ch4.buffer);
-        channelsBits.push_back(ch4.bitsBySample);
-        channelsSamples.push_back(ch4.samplesCount);
+    for (auto& ch : new_buffs) {
+        if (ch.buffer.get()) {
+            m_numChannels++;
+            maxSamples = maxSamples < ch.samplesCount ? ch.samplesCount : maxSamples;
+            maxBitBySample = maxBitBySample < ch.bitsBySample ? ch.bitsBySample : maxBitBySample;
+            OSCRate = ch.adcSpeed;
+            channels.push_back(ch.buffer);
+            channelsBits.push_back(ch.bitsBySample);
+            channelsSamples.push_back(ch.samplesCount);
+        }
     }
 
     m_samplesPerChannel = maxSamples;
@@ -11,6 +11,8 @@ class CWaveWriter {
     CWaveWriter();
     auto resetHeaderInit() -> void;
     auto BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_buffs) -> std::iostream*;
+    // Channels with a buffer are interleaved in order
+    auto BuildWAVStream(std::vector<SBuffPass> new_buffs) -> std::iostream*;
 
    private:
     auto addInt32ToFileData(std::stringstream* memory, int32_t i) -> void;
@@ -0,0 +1,312 @@
+#include "bin_overview.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "w_binary.h"
+
+#define OVERVIEW_BLOCK_VALUES 4096
+#define OVERVIEW_BLOCK_SEGMENTS 256
+#define OVERVIEW_TYPE_SEGMENTS 0
+#define OVERVIEW_TYPE_LEVEL 1
+
+namespace {
+
+struct BlockHeader {
+    char tag[4] = {'B', 'O', 'V', 'R'};
+    uint8_t type = 0;
+    uint8_t channel = 0;
+    uint8_t level = 0;
+    uint8_t reserved = 0;
+    uint32_t count = 0;
+    uint32_t reserved2 = 0;
+    uint64_t first = 0;
+};
+
+static_assert(sizeof(BlockHeader) == 24);
+static_assert(sizeof(CBinOverview::Value) == 12);
+
+constexpr uint32_t g_endOfSegment[3] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+
+auto readBlockHeader(std::ifstream& fs, BlockHeader* header) -> bool {
+    if (!fs.read((char*)header, sizeof(BlockHeader)))
+        return false;
+    return memcmp(header->tag, "BOVR", 4) == 0;
+}
+
+}  // namespace
+
+CBinOverview::CBinOverview() : m_segmentsWritten(0), m_samples{0, 0, 0, 0}, m_positions{0, 0, 0, 0} {}
+
+CBinOverview::~CBinOverview() {
+    close();
+}
+
+auto CBinOverview::getFileName(const std::string& binFile) -> std::string {
+    return binFile + "_overview";
+}
+
+auto CBinOverview::open(const std::string& binFile) -> bool {
+    close();
+    m_fs.open(getFileName(binFile), std::ios::binary | std::ios::trunc);
+    for (auto& ch : m_channels) {
+        ch = ChannelState();
+        std::fill(std::begin(ch.written), std::end(ch.written), 0);
+    }
+    m_segments.clear();
+    m_segmentsWritten = 0;
+    std::fill(std::begin(m_samples), std::end(m_samples), 0);
+    std::fill(std::begin(m_positions), std::end(m_positions), 0);
+    return m_fs.is_open();
+}
+
+auto CBinOverview::close() -> void {
+    if (!m_fs.is_open())
+        return;
+    // The partial values at the end of the capture
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        for (uint8_t level = MIN_LEVEL; level <= MAX_LEVEL; level++) {
+            if (m_channels[ch].acc[level].count)
+                push(ch, level, true);
+            flushLevel(ch, level);
+        }
+    }
+    flushSegments();
+    m_fs.close();
+}
+
+auto CBinOverview::isOpen() -> bool {
+    return m_fs.is_open();
+}
+
+auto CBinOverview::addSegment(const uint8_t* data, uint64_t size, uint64_t fileOffset) -> bool {
+    if (!m_fs.is_open() || size < sizeof(CBinInfo::BinHeader) + sizeof(g_endOfSegment))
+        return false;
+    CBinInfo::BinHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (sizeof(header) + header.sigmentLength + sizeof(g_endOfSegment) > size)
+        return false;
+
+    Segment segment;
+    segment.offset = fileOffset;
+    for (int i = 0; i < 4; i++) {
+        segment.rate = std::max(segment.rate, header.oscRate[i]);
+        segment.firstSample[i] = m_samples[i];
+        segment.firstPosition[i] = m_positions[i];
+    }
+    m_segments.push_back(segment);
+    if (m_segments.size() >= OVERVIEW_BLOCK_SEGMENTS)
+        flushSegments();
+
+    auto ptr = data + sizeof(header);
+    for (uint8_t i = 0; i < 4; i++) {
+        uint64_t samples = 0;
+        if (header.dataFormatSize[i])
+            samples = header.sizeCh[i] / header.dataFormatSize[i];
+        switch (header.dataFormatSize[i]) {
+            case 1:
+                addSamples(i, (const int8_t*)ptr, samples);
+                break;
+            case 2:
+                addSamples(i, (const int16_t*)ptr, samples);
+                break;
+            case 4:
+                addSamples(i, (const float*)ptr, samples);
+                break;
+            default:
+                samples = 0;
+                break;
+        }
+        ptr += header.sizeCh[i];
+        m_samples[i] += samples;
+        m_positions[i] += samples + header.lostCount[i];
+    }
+    return m_fs.good();
+}
+
+template <typename T>
+auto CBinOverview::addSamples(uint8_t channel, const T* data, uint64_t count) -> void {
+    using Sum = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+    constexpr uint64_t bucket = 1ull << (2 * MIN_LEVEL);
+    auto& acc = m_channels[channel].acc[MIN_LEVEL];
+    while (count) {
+        uint64_t n = std::min(count, bucket - acc.count);
+        T min = data[0];
+        T max = data[0];
+        Sum sum = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            min = std::min(min, data[i]);
+            max = std::max(max, data[i]);
+            sum += data[i];
+        }
+        if (acc.count == 0) {
+            acc.min = min;
+            acc.max = max;
+        } else {
+            acc.min = std::min<float>(acc.min, min);
+            acc.max = std::max<float>(acc.max, max);
+        }
+        acc.sum += sum;
+        acc.count += n;
+        data += n;
+        count -= n;
+        if (acc.count == bucket)
+            push(channel, MIN_LEVEL, false);
+    }
+}
+
+auto CBinOverview::push(uint8_t channel, uint8_t level, bool last) -> void {
+    auto& state = m_channels[channel];
+    auto& acc = state.acc[level];
+    Value value;
+    value.min = acc.min;
+    value.max = acc.max;
+    value.mean = acc.sum / acc.count;
+    state.pending[level].push_back(value);
+    if (state.pending[level].size() >= OVERVIEW_BLOCK_VALUES)
+        flushLevel(channel, level);
+
+    if (level < MAX_LEVEL) {
+        auto& next = state.acc[level + 1];
+        if (next.count == 0) {
+            next.min = acc.min;
+            next.max = acc.max;
+        } else {
+            next.min = std::min(next.min, acc.min);
+            next.max = std::max(next.max, acc.max);
+        }
+        next.sum += acc.sum;
+        next.count += acc.count;
+        if (!last && next.count == 1ull << (2 * (level + 1)))
+            push(channel, level + 1, false);
+    }
+    acc = Accumulator();
+}
+
+auto CBinOverview::flushLevel(uint8_t channel, uint8_t level) -> void {
+    auto& state = m_channels[channel];
+    auto& pending = state.pending[level];
+    if (pending.empty())
+        return;
+    BlockHeader header;
+    header.type = OVERVIEW_TYPE_LEVEL;
+    header.channel = channel;
+    header.level = level;
+    header.count = pending.size();
+    header.first = state.written[level];
+    m_fs.write((const char*)&header, sizeof(header));
+    m_fs.write((const char*)pending.data(), pending.size() * sizeof(Value));
+    state.written[level] += pending.size();
+    pending.clear();
+}
+
+auto CBinOverview::flushSegments() -> void {
+    if (m_segments.empty())
+        return;
+    BlockHeader header;
+    header.type = OVERVIEW_TYPE_SEGMENTS;
+    header.count = m_segments.size();
+    header.first = m_segmentsWritten;
+    m_fs.write((const char*)&header, sizeof(header));
+    m_fs.write((const char*)m_segments.data(), m_segments.size() * sizeof(Segment));
+    m_segmentsWritten += m_segments.size();
+    m_segments.clear();
+    m_fs.flush();
+}
+
+auto CBinOverview::build(const std::string& binFile) -> bool {
+    std::ifstream fs(binFile, std::ios::binary | std::ios::ate);
+    if (!fs.is_open())
+        return false;
+    uint64_t length = fs.tellg();
+    CBinOverview overview;
+    if (!overview.open(binFile))
+        return false;
+    std::vector<uint8_t> buffer;
+    uint64_t position = 0;
+    while (position + sizeof(CBinInfo::BinHeader) + sizeof(g_endOfSegment) <= length) {
+        CBinInfo::BinHeader header;
+        fs.seekg(position, std::ios::beg);
+        if (!fs.read((char*)&header, sizeof(header)))
+            break;
+        uint64_t segmentSize = sizeof(header) + header.sigmentLength + sizeof(g_endOfSegment);
+        if (position + segmentSize > length)
+            break;
+        buffer.resize(segmentSize);
+        memcpy(buffer.data(), &header, sizeof(header));
+        if (!fs.read((char*)buffer.data() + sizeof(header), segmentSize - sizeof(header)))
+            break;
+        if (memcmp(buffer.data() + segmentSize - sizeof(g_endOfSegment), g_endOfSegment, sizeof(g_endOfSegment)) != 0)
+            break;
+        overview.addSegment(buffer.data(), segmentSize, position);
+        position += segmentSize;
+    }
+    overview.close();
+    return true;
+}
+
+auto CBinOverview::readSegments(const std::string& binFile, std::vector<Segment>* segments) -> bool {
+    std::ifstream fs(getFileName(binFile), std::ios::binary);
+    if (!fs.is_open())
+        return false;
+    segments->clear();
+    BlockHeader header;
+    while (readBlockHeader(fs, &header)) {
+        if (header.type == OVERVIEW_TYPE_SEGMENTS) {
+            auto pos = segments->size();
+            segments->resize(pos + header.count);
+            if (!fs.read((char*)(segments->data() + pos), header.count * sizeof(Segment))) {
+                segments->resize(pos);
+                break;
+            }
+        } else {
+            fs.seekg(header.count * sizeof(Value), std::ios::cur);
+        }
+    }
+    return true;
+}
+
+auto CBinOverview::readLevel(const std::string& binFile, uint8_t channel, uint8_t level, uint64_t first, uint64_t count, std::vector<Value>* values) -> bool {
+    std::ifstream fs(getFileName(binFile), std::ios::binary);
+    if (!fs.is_open())
+        return false;
+    values->clear();
+    uint64_t last = count ? first + count : UINT64_MAX;
+    BlockHeader header;
+    while (readBlockHeader(fs, &header)) {
+        uint64_t blockSize = header.count * (header.type == OVERVIEW_TYPE_SEGMENTS ? sizeof(Segment) : sizeof(Value));
+        if (header.type != OVERVIEW_TYPE_LEVEL || header.channel != channel || header.level != level || header.first + header.count <= first ||
+            header.first >= last) {
+            fs.seekg(blockSize, std::ios::cur);
+            continue;
+        }
+        auto begin = std::max(first, header.first);
+        auto end = std::min(last, header.first + header.count);
+        auto pos = values->size();
+        values->resize(pos + (end - begin));
+        fs.seekg((begin - header.first) * sizeof(Value), std::ios::cur);
+        if (!fs.read((char*)(values->data() + pos), (end - begin) * sizeof(Value))) {
+            values->resize(pos);
+            break;
+        }
+        fs.seekg((header.first + header.count - end) * sizeof(Value), std::ios::cur);
+        if (end == last)
+            break;
+    }
+    return true;
+}
+
+auto CBinOverview::findSegmentByTime(const std::vector<Segment>& segments, double seconds) -> int32_t {
+    if (segments.empty())
+        return -1;
+    int32_t found = 1;
+    for (size_t i = 0; i < segments.size(); i++) {
+        auto& seg = segments[i];
+        auto position = *std::max_element(std::begin(seg.firstPosition), std::end(seg.firstPosition));
+        if (seg.rate && (double)position / seg.rate > seconds)
+            break;
+        found = i + 1;
+    }
+    return found;
+}
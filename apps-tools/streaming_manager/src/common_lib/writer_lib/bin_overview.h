@@ -0,0 +1,88 @@
+#ifndef WRITER_LIB_BIN_OVERVIEW_H
+#define WRITER_LIB_BIN_OVERVIEW_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Overview sidecar of a BIN capture ("<file>.bin_overview").
+ * It holds the file offset of every segment and min/max/mean pyramids per channel.
+ * Level L of the pyramid has one value per 4^L stored samples (lost samples are not counted).
+ * The file is a sequence of tagged blocks written while capturing, so a reader loads only the blocks of one level.
+ */
+class CBinOverview {
+   public:
+    static constexpr uint8_t MIN_LEVEL = 4;  // 256 samples per value
+    static constexpr uint8_t MAX_LEVEL = 16;
+
+    struct Segment {
+        uint64_t offset = 0;  // File offset of the segment header
+        uint64_t rate = 0;
+        uint64_t firstSample[4] = {0, 0, 0, 0};    // Stored samples before the segment
+        uint64_t firstPosition[4] = {0, 0, 0, 0};  // Stored and lost samples before the segment
+    };
+
+    struct Value {
+        float min = 0;
+        float max = 0;
+        float mean = 0;
+    };
+
+    CBinOverview();
+    ~CBinOverview();
+
+    static auto getFileName(const std::string& binFile) -> std::string;
+
+    // Writer
+    auto open(const std::string& binFile) -> bool;
+    auto close() -> void;
+    auto isOpen() -> bool;
+    // Adds one BIN segment (header, data and end marker) written at fileOffset
+    auto addSegment(const uint8_t* data, uint64_t size, uint64_t fileOffset) -> bool;
+
+    // Creates the overview of an existing BIN file
+    static auto build(const std::string& binFile) -> bool;
+
+    // Reader
+    static auto readSegments(const std::string& binFile, std::vector<Segment>* segments) -> bool;
+    // Values [first, first + count) of the level. Count 0 reads the whole level.
+    static auto readLevel(const std::string& binFile, uint8_t channel, uint8_t level, uint64_t first, uint64_t count, std::vector<Value>* values) -> bool;
+    // Number of the segment (from 1) that contains the time in seconds from the capture start, or -1
+    static auto findSegmentByTime(const std::vector<Segment>& segments, double seconds) -> int32_t;
+
+   private:
+    CBinOverview(const CBinOverview&) = delete;
+    CBinOverview(CBinOverview&&) = delete;
+    CBinOverview& operator=(const CBinOverview&) = delete;
+    CBinOverview& operator=(const CBinOverview&&) = delete;
+
+    struct Accumulator {
+        float min = 0;
+        float max = 0;
+        double sum = 0;
+        uint64_t count = 0;
+    };
+
+    struct ChannelState {
+        Accumulator acc[MAX_LEVEL + 1];
+        std::vector<Value> pending[MAX_LEVEL + 1];
+        uint64_t written[MAX_LEVEL + 1];
+    };
+
+    template <typename T>
+    auto addSamples(uint8_t channel, const T* data, uint64_t count) -> void;
+    auto push(uint8_t channel, uint8_t level, bool last) -> void;
+    auto flushLevel(uint8_t channel, uint8_t level) -> void;
+    auto flushSegments() -> void;
+
+    std::ofstream m_fs;
+    ChannelState m_channels[4];
+    std::vector<Segment> m_segments;
+    uint64_t m_segmentsWritten;
+    uint64_t m_samples[4];
+    uint64_t m_positions[4];
+};
+
+#endif
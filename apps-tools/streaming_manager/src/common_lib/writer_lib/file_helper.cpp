@@ -68,6 +68,17 @@ auto dirNameOf(const std::string& fname) -> std::string {
 }
 
 auto buildTDMSStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_buffs, std::shared_ptr<std::vector<int64_t>> time) -> std::iostream* {
+    std::vector<std::pair<std::string, SBuffPass>> channels;
+    for (auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++) {
+        auto ch = (DataLib::EDataBuffersPackChannel)i;
+        if (new_buffs.find(ch) != new_buffs.end()) {
+            channels.push_back({"ch" + std::to_string(i + 1), new_buffs.at(ch)});
+        }
+    }
+    return buildTDMSStream(channels, time);
+}
+
+auto buildTDMSStream(std::vector<std::pair<std::string, SBuffPass>> channels, std::shared_ptr<std::vector<int64_t>> time) -> std::iostream* {
     TDMS::File outFile;
     TDMS::WriterSegment segment;
     vector<shared_ptr<TDMS::Metadata>> data;
@@ -82,7 +93,6 @@ auto buildTDMSStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_b
     data.push_back(root);
     auto group = segment.GenerateGroup("Group");
     data.push_back(group);
-    // new_buffs.at(DataLib::CH1)
 
     //    auto *time = TDMS::DataType::GetRawTimeValue(tim_sec + timezone);
     //    TDMS::DataType dataprop;
@@ -96,56 +106,7 @@ auto buildTDMSStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_b
         segment.AddRaw(channel, TDMS::TDMSType::Integer64, time->size(), sh_time);
     }
 
-    if (new_buffs.find(DataLib::CH1) != new_buffs.end()) {
-        auto settings = new_buffs.at(DataLib::CH1);
-        if (settings.bufferLen) {
-            auto data_type = TDMS::TDMSType::Integer8;
-            if (settings.bitsBySample == 16)
-                data_type = TDMS::TDMSType::Integer16;
-            if (settings.bitsBySample == 32)
-                data_type = TDMS::TDMSType::SingleFloat;
-            auto sampelsCount = settings.samplesCount;
-            auto buffer = settings.buffer;
-            auto channel = segment.GenerateChannel("Group", "ch1");
-            data.push_back(channel);
-            segment.AddRaw(channel, data_type, sampelsCount, buffer);
-        }
-    }
-
-    if (new_buffs.find(DataLib::CH2) != new_buffs.end()) {
-        auto settings = new_buffs.at(DataLib::CH2);
-        if (settings.bufferLen) {
-            auto data_type = TDMS::TDMSType::Integer8;
-            if (settings.bitsBySample == 16)
-                data_type = TDMS::TDMSType::Integer16;
-            if (settings.bitsBySample == 32)
-                data_type = TDMS::TDMSType::SingleFloat;
-            auto sampelsCount = settings.samplesCount;
-            auto buffer = settings.buffer;
-            auto channel = segment.GenerateChannel("Group", "ch2");
-            data.push_back(channel);
-            segment.AddRaw(channel, data_type, sampelsCount, buffer);
-        }
-    }
-
-    if (new_buffs.find(DataLib::CH3) != new_buffs.end()) {
-        auto settings = new_buffs.at(DataLib::CH3);
-        if (settings.bufferLen) {
-            auto data_type = TDMS::TDMSType::Integer8;
-            if (settings.bitsBySample == 16)
-                data_type = TDMS::TDMSType::Integer16;
-            if (settings.bitsBySample == 32)
-                data_type = TDMS::TDMSType::SingleFloat;
-            auto sampelsCount = settings.samplesCount;
-            auto buffer = settings.buffer;
-            auto channel = segment.GenerateChannel("Group", "ch3");
-            data.push_back(channel);
-            segment.AddRaw(channel, data_type, sampelsCount, buffer);
-        }
-    }
-
-    if (new_buffs.find(DataLib::CH4) != new_buffs.end()) {
-        auto settings = new_buffs.at(DataLib::CH4);
+    for (auto& [name, settings] : channels) {
         if (settings.bufferLen) {
             auto data_type = TDMS::TDMSType::Integer8;
             if (settings.bitsBySample == 16)
@@ -154,7 +115,7 @@ auto buildTDMSStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_b
                 data_type = TDMS::TDMSType::SingleFloat;
             auto sampelsCount = settings.samplesCount;
             auto buffer = settings.buffer;
-            auto channel = segment.GenerateChannel("Group", "ch4");
+            auto channel = segment.GenerateChannel("Group", name);
             data.push_back(channel);
             segment.AddRaw(channel, data_type, sampelsCount, buffer);
         }
@@ -48,6 +48,8 @@ auto readCSV(std::iostream* buffer, int64_t* _position, int* _channels, uint64_t
 auto readBinData(std::iostream* buffer, int64_t* _position) -> SBinData*;
 
 auto buildTDMSStream(std::map<DataLib::EDataBuffersPackChannel, SBuffPass> new_buffs, std::shared_ptr<std::vector<int64_t>> time) -> std::iostream*;
+// Channels are written in order under the given names
+auto buildTDMSStream(std::vector<std::pair<std::string, SBuffPass>> channels, std::shared_ptr<std::vector<int64_t>> time) -> std::iostream*;
 auto buildBINStream(DataLib::CDataBuffersPackDMA::Ptr buff_pack, std::map<DataLib::EDataBuffersPackChannel, uint32_t> _samples) -> std::iostream*;
 
 auto dirNameOf(const std::string& fname) -> std::string;
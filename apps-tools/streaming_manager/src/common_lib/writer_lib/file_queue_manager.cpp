@@ -1,7 +1,9 @@
 #include "file_queue_manager.h"
 #include <ctime>
+#include <sstream>
 #include "file_helper.h"
 #include "logger_lib/file_logger.h"
+#include "tdms_lib/index_file.h"
 
 FileQueueManager::FileQueueManager(bool testMode) : Queue() {
     m_threadWork = false;
@@ -12,6 +14,7 @@ FileQueueManager::FileQueueManager(bool testMode) : Queue() {
     m_testMode = testMode;
     m_fileName = "";
     m_hasWriteSize = 0;
+    m_writeIndex = false;
 }
 
 FileQueueManager::~FileQueueManager() {
@@ -21,6 +24,8 @@ FileQueueManager::~FileQueueManager() {
 auto FileQueueManager::deleteFile() -> void {
     try {
         std::remove(m_fileName.c_str());
+        std::remove(TDMS::IndexedFile::getIndexFileName(m_fileName).c_str());
+        std::remove(CBinOverview::getFileName(m_fileName).c_str());
     } catch (std::exception& e) {
         aprintf(stderr, "Error delete file: %s err: %s \n", m_fileName.c_str(), e.what());
     }
@@ -51,6 +56,13 @@ auto FileQueueManager::openFile(std::string FileName, bool Append) -> void {
         }
     }
     m_fileName = FileName;
+    // The index must describe the file from the first segment. Appended files are indexed by the reader.
+    if (m_indexFs.is_open())
+        m_indexFs.close();
+    m_overview.close();
+    std::remove(TDMS::IndexedFile::getIndexFileName(FileName).c_str());
+    std::remove(CBinOverview::getFileName(FileName).c_str());
+    m_writeIndex = !Append;
     auto dirName = dirNameOf(FileName);
     if (dirName == "") {
         dirName = ".";
@@ -70,6 +82,9 @@ auto FileQueueManager::openFile(std::string FileName, bool Append) -> void {
 auto FileQueueManager::closeFile() -> void {
     if (fs.is_open())
         fs.close();
+    if (m_indexFs.is_open())
+        m_indexFs.close();
+    m_overview.close();
 }
 
 auto FileQueueManager::startWrite(CStreamSettings::DataFormat _fileType) -> void {
@@ -139,6 +154,7 @@ auto FileQueueManager::writeToFile() -> int {
     auto Length = bstream->tellg();
 
     if (fs.good() && ((m_hasWriteSize + Length) < m_freeSize)) {
+        uint64_t fileOffset = m_hasWriteSize;
         bstream->seekg(0, bstream->beg);
         if (m_testMode) {
             fs.seekp(0);
@@ -149,6 +165,25 @@ auto FileQueueManager::writeToFile() -> int {
         //        auto Length = bstream->tellg();
         m_hasWriteSize += Length;
 
+        if (m_fileType.value == CStreamSettings::DataFormat::TDMS && m_writeIndex && !m_testMode) {
+            if (!m_indexFs.is_open()) {
+                m_indexFs.open(TDMS::IndexedFile::getIndexFileName(m_fileName), std::ios::binary | std::ios::trunc);
+            }
+            TDMS::IndexedFile::appendIndexSegment(*bstream, m_indexFs);
+            m_indexFs.flush();
+        }
+
+        if (m_fileType.value == CStreamSettings::DataFormat::BIN && m_writeIndex && !m_testMode) {
+            auto memory = dynamic_cast<std::stringstream*>(bstream);
+            if (memory) {
+                if (!m_overview.isOpen()) {
+                    m_overview.open(m_fileName);
+                }
+                auto view = memory->view();
+                m_overview.addSegment((const uint8_t*)view.data(), view.size(), fileOffset);
+            }
+        }
+
         if (m_fileType.value == CStreamSettings::DataFormat::WAV) {
             if (m_firstSectionWrite) {
                 updateWavFile(Length);
@@ -10,6 +10,7 @@
 #include <thread>
 #include <vector>
 #include "data_lib/signal.hpp"
+#include "bin_overview.h"
 #include "settings_lib/stream_settings.h"
 #include "w_queue.h"
 
@@ -38,6 +39,9 @@ class FileQueueManager : public Queue {
     auto outSpaceNotifyThread() -> void;
 
     std::fstream fs;
+    std::ofstream m_indexFs;  // .tdms_index sidecar
+    CBinOverview m_overview;  // .bin_overview sidecar
+    bool m_writeIndex;
     std::thread* th;
     std::atomic_bool m_ThreadRun;
     bool m_threadWork;
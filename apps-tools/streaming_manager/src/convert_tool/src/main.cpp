@@ -8,6 +8,7 @@
 #include <string>
 #include "converter_lib/converter.h"
 #include "logger_lib/file_logger.h"
+#include "writer_lib/bin_overview.h"
 #include "writer_lib/file_helper.h"
 
 #define MAX(X, Y) ((X > Y) ? X : Y)
@@ -40,11 +41,14 @@ bool CheckMissing(const char* val, const char* Message) {
 }
 
 void UsingArgs(char const* progName) {
-    std::cout << "Usage: " << progName << " file_name [-i][-s start][-e end][-f format][-t][-ci][-cb|-cs|-cn]\n";
+    std::cout << "Usage: " << progName << " file_name [-i][-o][-s start][-e end][-ts time][-te time][-f format][-t][-ci][-cb|-cs|-cn]\n";
     std::cout << "\t-i get info about BIN file\n";
     std::cout << "\t-ia get info about BIN file. Including information on all segments.\n";
+    std::cout << "\t-o Creates the overview file (segment index and min/max levels) of BIN file\n";
     std::cout << "\t-s Segment from which the conversion starts\n";
     std::cout << "\t-e Segment where the conversion will end\n";
+    std::cout << "\t-ts Time in seconds from the capture start from which the conversion starts\n";
+    std::cout << "\t-te Time in seconds from the capture start where the conversion will end\n";
     std::cout << "\t-f File format. [CSV|WAV|TDMS]. By default used CSV format\n";
     std::cout << "\t-t Creates test data files for DAC streaming\n";
     std::cout << "\t-ci Adds an index column to the CSV file.\n";
@@ -72,6 +76,20 @@ int ParseInt(string value) noexcept {
     }
 }
 
+double ParseTime(string value) noexcept {
+    try {
+        double x = std::stod(value);
+        if (x < 0) {
+            std::cout << "Error read parameter\n";
+            return -1;
+        }
+        return x;
+    } catch (std::exception& e) {
+        std::cout << "Error read parameter\n";
+        return -1;
+    }
+}
+
 int main(int argc, char* argv[]) {
     signal(SIGINT, sigHandlerStopCSV);
     if (argc < 2) {
@@ -83,12 +101,25 @@ int main(int argc, char* argv[]) {
     bool check_info = cmdOptionExists(argv, argv + argc, "-i");
     bool check_info_all = cmdOptionExists(argv, argv + argc, "-ia");
     bool gen_test = cmdOptionExists(argv, argv + argc, "-t");
+    bool build_overview = cmdOptionExists(argv, argv + argc, "-o");
 
     if (gen_test) {
         createTestFiels();
         return 0;
     }
 
+    if (build_overview) {
+        if (!CBinOverview::build(file_name)) {
+            std::cout << " Error open file: " << file_name << "\n";
+            return -1;
+        }
+        std::vector<CBinOverview::Segment> segments;
+        CBinOverview::readSegments(file_name, &segments);
+        aprintf(stdout, "Overview file: %s\n", CBinOverview::getFileName(file_name).c_str());
+        aprintf(stdout, "Segments count: %zu\n", segments.size());
+        return 0;
+    }
+
     if (check_info || check_info_all) {
         std::fstream fs;
         fs.open(file_name, std::ios::binary | std::ofstream::in | std::ofstream::out);
@@ -175,6 +206,38 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    const char* time_opts[] = {"-ts", "-te"};
+    std::vector<CBinOverview::Segment> segments;
+    for (auto opt : time_opts) {
+        if (!cmdOptionExists(argv, argv + argc, opt))
+            continue;
+        char* time_char = getCmdOption(argv, argv + argc, opt);
+        if (CheckMissing(time_char, "time")) {
+            UsingArgs(argv[0]);
+            return -1;
+        }
+        double time = ParseTime(time_char);
+        if (time < 0) {
+            UsingArgs(argv[0]);
+            return -1;
+        }
+        if (segments.empty() && !CBinOverview::readSegments(file_name, &segments)) {
+            // Captures without overview file
+            CBinOverview::build(file_name);
+            CBinOverview::readSegments(file_name, &segments);
+        }
+        auto seg = CBinOverview::findSegmentByTime(segments, time);
+        if (seg == -1) {
+            std::cout << " Error read segments of file: " << file_name << "\n";
+            return -1;
+        }
+        if (opt == time_opts[0]) {
+            s = seg;
+        } else {
+            e = seg;
+        }
+    }
+
     if (cmdOptionExists(argv, argv + argc, "-f")) {
         format = getCmdOption(argv, argv + argc, "-f");
     }
@@ -51,10 +51,12 @@ static struct option long_options_streaming[] = {
     {"limit", required_argument, 0, 'l'},
     {"mode", required_argument, 0, 'm'},
     {"timeout", required_argument, 0, 't'},
+    {"merge", no_argument, 0, 'g'},
+    {"window", required_argument, 0, 'w'},
     {"verbose", no_argument, 0, 'v'},
     {0, 0, 0, 0}};
 
-static constexpr char optstring_streaming[] = "sh:c:f:d:l:m:t:v";
+static constexpr char optstring_streaming[] = "sh:c:f:d:l:m:t:gw:v";
 
 static struct option long_options_dac_streaming[] = {
     /* These options set a flag. */
@@ -285,9 +287,9 @@ auto ClientOpt::usage(char const* progName) -> void {
         "\tThis mode allows you to control streaming as a client, and also captures data in network streaming mode.\n"
         "\n"
         "\tOptions:\n"
-        "\t\t%s -s [-h IPs] -f tdms|wav|csv|bin [-d NAME] [-m raw|volt] [-l SAMPLES] [-t MSEC] [-v]\n"
+        "\t\t%s -s [-h IPs] -f tdms|wav|csv|bin [-d NAME] [-m raw|volt] [-l SAMPLES] [-t MSEC] [-g [-w PACKS]] [-v]\n"
         "\t\t%s --streaming [--hosts=IPs] --format=tdms|wav|csv|bin [--dir=NAME] [--limit=SAMPLES] [--mode=raw|volt] [--timeout=MSEC] "
-        "[--verbose]\n"
+        "[--merge [--window=PACKS]] [--verbose]\n"
         "\n"
         "\t\t--streaming            -s              Enable streaming mode.\n"
         "\t\t--hosts=IP,...         -h IP,...       You can specify one or more board IP addresses through a separator - ','\n"
@@ -307,6 +309,10 @@ auto ClientOpt::usage(char const* progName) -> void {
         "\t\t                                              volt = Converts binary integer format to floating point format.\n"
         "\t\t                                                    Measured in volts. In wav format, it is limited from -1 to 1.\n"
         "\t\t--timeout=MSEC         -t MSEC         Stops recording after a specified amount of time.\n"
+        "\t\t--merge                -g              Writes the boards to one file, aligned by capture time and pack number.\n"
+        "\t\t                                       For boards that share a clock (daisy chain). A bin file holds at most 4 channels.\n"
+        "\t\t--window=PACKS         -w PACKS        Packs a board may be ahead of the others before the missing packs are written as lost [1-1024] "
+        "(%d by default).\n"
         "\t\t--verbose              -v              Displays service information.\n"
         "\n"
         "DAC streaming Mode:\n"
@@ -333,7 +339,7 @@ auto ClientOpt::usage(char const* progName) -> void {
         "\t\t--verbose              -v              Displays service information.\n"
         "\n";
     auto n = name.c_str();
-    fprintf(stderr, format, n, n, n, n, n, n, n, n, n, n, n, n, n, 0x7FFFFFFF, n, n);
+    fprintf(stderr, format, n, n, n, n, n, n, n, n, n, n, n, n, n, 0x7FFFFFFF, Options().merge_window, n, n);
 
     fprintf(stderr, "Configuration file variables and valid values:\nName\t\t\t  Parameters\n%s\n", CStreamSettings::getHelp().c_str());
 }
@@ -666,6 +672,20 @@ auto ClientOpt::parse(int argc, char* argv[]) -> ClientOpt::Options {
                     break;
                 }
 
+                case 'g':
+                    opt.merge = true;
+                    break;
+
+                case 'w': {
+                    int window = 0;
+                    if (get_int(&window, optarg, "Error get merge window", 1, 1024) != 0) {
+                        opt.mode = Mode::ERROR_PARAM;
+                        return opt;
+                    }
+                    opt.merge_window = window;
+                    break;
+                }
+
                 default: {
                     if (opt.mode == Mode::CONFIG) {
                         fprintf(stderr, "[ERROR] Unknown parameter\n");
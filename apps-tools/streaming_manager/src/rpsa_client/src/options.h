@@ -49,6 +49,8 @@ struct Options {
     StreamingType streamign_type;
     SaveType save_type{SaveType::NONE};
     int samples{0};
+    bool merge{false};
+    int merge_window{32};  // Packs
     std::string config_item_name{""};
     std::string config_item_value{""};
     bool config_item_write{false};
@@ -2,6 +2,7 @@
 #include <mutex>
 #include "config.h"
 #include "logger_lib/file_logger.h"
+#include "streaming_lib/streaming_net.h"
 
 #ifdef _WIN32
 #include <dir.h>
@@ -295,6 +296,53 @@ auto requestActiveChannels(std::shared_ptr<ClientNetConfigManager> cl,
     return true;
 }
 
+auto requestNetTransport(std::shared_ptr<ClientNetConfigManager> cl,
+						 std::list<std::string> &hosts,
+						 std::map<std::string, net_lib::SNetTransport> *transports,
+						 bool verbose) -> bool
+{
+	std::atomic<int> rstart_counter;
+
+    cl->errorNofiy.connect([&](ClientNetConfigManager::Errors errors, std::string host, error_code err) {
+        const std::lock_guard<std::mutex> lock(g_rmutex);
+        if (errors == ClientNetConfigManager::Errors::SERVER_INTERNAL) {
+            aprintf(stderr, "%s Error: %s %s\n", getTS(": ").c_str(), host.c_str(), err.message().c_str());
+            rstart_counter--;
+        }
+        if (errors == ClientNetConfigManager::Errors::CANNT_SET_DATA_TO_CONFIG) {
+            rstart_counter--;
+        }
+    });
+
+	cl->getNewSettingsNofiy.connect([&](std::string host) {
+		const std::lock_guard<std::mutex> lock(g_rmutex);
+		auto transport = streaming_lib::CStreamingNet::getTransport(*cl->getLocalSettingsOfHost(host));
+		if (verbose)
+			aprintf(stdout, "%s %s Protocol: %s\n", getTS(": ").c_str(), host.c_str(), transport.protocol == net_lib::P_UDP ? "UDP" : "TCP");
+		rstart_counter--;
+		if (transports)
+			(*transports)[host] = transport;
+	});
+
+	rstart_counter = hosts.size();
+	for (auto &host : hosts) {
+		if (verbose)
+            aprintf(stdout, "%s Request for configuration sent : %s\n", getTS(": ").c_str(), host.c_str());
+        if (!cl->requestConfig(host)) {
+            rstart_counter--;
+        }
+	}
+	while (rstart_counter > 0) {
+        sleepMs(100);
+        if (g_rexit_flag) {
+            cl->removeHadlers();
+            return false;
+        }
+    }
+    cl->removeHadlers();
+    return true;
+}
+
 auto startADC(std::shared_ptr<ClientNetConfigManager> cl, std::list<std::string>& masterHosts, std::list<std::string>& slaveHosts,
               std::map<std::string, StateRunnedHosts>* runned_hosts) -> bool {
     std::atomic<int> rstart_counter;
@@ -3,6 +3,7 @@
 
 #include <map>
 #include "config_net_lib/client_net_config_manager.h"
+#include "net_lib/asio_common.h"
 #include "options.h"
 
 auto startRemote(std::shared_ptr<ClientNetConfigManager> cl,
@@ -16,4 +17,8 @@ auto requestActiveChannels(std::shared_ptr<ClientNetConfigManager> cl,
 						   std::list<std::string> &hosts,
 						   std::map<std::string, adc_channels_t> *sizes,
 						   bool verbose) -> bool;
+auto requestNetTransport(std::shared_ptr<ClientNetConfigManager> cl,
+						 std::list<std::string> &hosts,
+						 std::map<std::string, net_lib::SNetTransport> *transports,
+						 bool verbose) -> bool;
 #endif
@@ -6,6 +6,7 @@
 #include "remote.h"
 #include "settings_lib/stream_settings.h"
 #include "streaming_lib/streaming_file.h"
+#include "streaming_lib/streaming_merger.h"
 #include "test_helper.h"
 #include "writer_lib/file_helper.h"
 
@@ -20,26 +21,18 @@ std::atomic<int> g_runClientCounter;
 
 std::map<std::string, bool> g_terminate;
 
+// All boards go to one file with --merge
+streaming_lib::CStreamingFile::Ptr g_merged_file;
+streaming_lib::CStreamingMerger::Ptr g_merger;
+
 std::vector<std::thread> clients;
 
 auto stopCSV() -> void;
 auto stopStreaming() -> void;
 auto stopStreaming(std::string host) -> void;
 
-auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t activeChannels) -> void
-{
-	auto memoryManager = new uio_lib::CMemoryManager();
-	auto buffers = DataLib::CBuffersCached::create();
-	memoryManager->setMemoryBlockSize(size);
-    memoryManager->reallocateBlocks();
-    auto blocks = memoryManager->getFreeBlockCount();
-	auto reserved __attribute__((unused)) = memoryManager->reserveMemory(uio_lib::MM_ADC, blocks, activeChannels.count());
-	buffers->generateBuffersEmptyADC(activeChannels, memoryManager->getRegions(uio_lib::MM_ADC), DataLib::sizeHeader());
-	TRACE_SHORT("Reserved blocks %d", reserved)
-
-	g_terminate[host] = false;
-
-	if (g_soption.save_dir == "")
+auto createFileManager(std::string prefix) -> streaming_lib::CStreamingFile::Ptr {
+    if (g_soption.save_dir == "")
         g_soption.save_dir = ".";
 
     CStreamSettings::DataFormat file_type = CStreamSettings::DataFormat::BIN;
@@ -57,8 +50,7 @@ auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t
             file_type = CStreamSettings::DataFormat::BIN;
             break;
         default:
-            stopStreaming(host);
-            return;
+            return nullptr;
     }
 
     bool convert_v = false;
@@ -74,13 +66,36 @@ auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t
             break;
     }
 
-    auto g_file_manager = streaming_lib::CStreamingFile::create(file_type, g_soption.save_dir, g_soption.samples, convert_v, false);
-    g_file_manager->run(host + "_" + g_filenameDate);
+    auto file_manager = streaming_lib::CStreamingFile::create(file_type, g_soption.save_dir, g_soption.samples, convert_v, false);
+    file_manager->run(prefix + "_" + g_filenameDate);
+    return file_manager;
+}
+
+auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t activeChannels, net_lib::SNetTransport transport, int mergeBoard) -> void
+{
+	auto memoryManager = new uio_lib::CMemoryManager();
+	auto buffers = DataLib::CBuffersCached::create();
+	memoryManager->setMemoryBlockSize(size);
+    memoryManager->reallocateBlocks();
+    auto blocks = memoryManager->getFreeBlockCount();
+	auto reserved __attribute__((unused)) = memoryManager->reserveMemory(uio_lib::MM_ADC, blocks, activeChannels.count());
+	buffers->generateBuffersEmptyADC(activeChannels, memoryManager->getRegions(uio_lib::MM_ADC), DataLib::sizeHeader());
+	TRACE_SHORT("Reserved blocks %d", reserved)
+
+	g_terminate[host] = false;
+
+    auto merger = g_merger;
+    auto g_file_manager = merger ? g_merged_file : createFileManager(host);
+    if (!g_file_manager) {
+        stopStreaming(host);
+        delete memoryManager;
+        return;
+    }
 
     auto g_s_file_w = std::weak_ptr<streaming_lib::CStreamingFile>(g_file_manager);
     auto g_s_buffers_w = std::weak_ptr<DataLib::CBuffersCached>(buffers);
 
-    auto g_asionet = net_lib::CAsioNet::create(net_lib::M_CLIENT, host, NET_ADC_STREAMING_PORT, buffers);
+    auto g_asionet = net_lib::CAsioNet::create(net_lib::M_CLIENT, host, NET_ADC_STREAMING_PORT, buffers, transport);
 
     g_asionet->clientConnectNotify.connect([](std::string host) {
         const std::lock_guard lock(g_smutex);
@@ -98,7 +113,7 @@ auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t
     });
 
     // auto g_net_buffer_w = std::weak_ptr<streaming_lib::CStreamingNetBuffer>(g_net_buffer);
-    g_asionet->reciveNotify.connect([g_s_file_w, g_s_buffers_w, host](std::error_code error, DataLib::CDataBuffersPackDMA::Ptr pack) {
+    g_asionet->reciveNotify.connect([g_s_file_w, g_s_buffers_w, host, merger, mergeBoard](std::error_code error, DataLib::CDataBuffersPackDMA::Ptr pack) {
         if (!error) {
             auto obj = g_s_file_w.lock();
             auto obj2 = g_s_buffers_w.lock();
@@ -148,8 +163,12 @@ auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t
                     auto h = host;
                     addStatisticStreaming(h, sizeCh1 + sizeCh2 + sizeCh3 + sizeCh4, sempCh1, sempCh2, sempCh3, sempCh4, lostRate, flost, -1);
                 }
-                obj->passBuffers(pack);
-                obj2->unlockBufferRead();
+                if (merger) {
+                    merger->passBuffers(mergeBoard, obj2, pack);
+                } else {
+                    obj->passBuffers(pack);
+                    obj2->unlockBufferRead();
+                }
             }
         }
     });
@@ -168,6 +187,14 @@ auto runClient(std::string host, StateRunnedHosts, uint32_t size, adc_channels_t
         }
     }
 
+    if (merger) {
+        g_asionet->stop();
+        g_asionet = nullptr;
+        merger->finishBoard(mergeBoard);
+        delete memoryManager;
+        return;
+    }
+
     g_file_manager->stopAndFlush();
     g_asionet->stop();
     g_asionet = nullptr;
@@ -219,13 +246,43 @@ auto startStreaming(std::shared_ptr<ClientNetConfigManager> cl, ClientOpt::Optio
         return;
 	}
 
+	std::map<std::string, net_lib::SNetTransport> transports;
+	if (!requestNetTransport(cl, hosts, &transports, remote_opt.verbous)) {
+		aprintf(stdout, "%s Can't get network settings\n", getTS(": ").c_str());
+        return;
+	}
+
+	if (g_soption.merge) {
+		size_t channels = 0;
+		for (auto& host : hosts) {
+			channels += activeChannels[host].count();
+		}
+		if (channels > 4 && (g_soption.streamign_type == ClientOpt::StreamingType::BIN || g_soption.streamign_type == ClientOpt::StreamingType::CSV)) {
+			aprintf(stderr, "%s A merged bin file holds at most 4 channels. Active channels %d. Use tdms or wav.\n", getTS(": ").c_str(), (int)channels);
+			return;
+		}
+	}
+
 	runned_hosts.clear();
     remote_opt.remote_mode = ClientOpt::RemoteMode::START;
     if (startRemote(cl, remote_opt, nullptr, &runned_hosts)) {
         g_runClientCounter = runned_hosts.size();
+        std::map<std::string, int> mergeBoards;
+        if (g_soption.merge) {
+            g_merged_file = createFileManager("merged");
+            if (!g_merged_file) {
+                return;
+            }
+            g_merger = streaming_lib::CStreamingMerger::create(g_merged_file, g_soption.merge_window);
+            for (auto kv : runned_hosts) {
+                if (kv.second == StateRunnedHosts::TCP && activeChannels[kv.first].count() > 0)
+                    mergeBoards[kv.first] = g_merger->addBoard(kv.first);
+            }
+            g_merger->run();
+        }
         for (auto kv : runned_hosts) {
 			if (kv.second == StateRunnedHosts::TCP && activeChannels[kv.first].count() > 0)
-				clients.push_back(std::thread(runClient, kv.first, kv.second, blockSizes[kv.first], activeChannels[kv.first]));
+				clients.push_back(std::thread(runClient, kv.first, kv.second, blockSizes[kv.first], activeChannels[kv.first], transports[kv.first], g_merger ? mergeBoards[kv.first] : -1));
         }
         while (g_runClientCounter > 0) {
             sleepMs(100);
@@ -296,6 +353,33 @@ auto startStreaming(std::shared_ptr<ClientNetConfigManager> cl, ClientOpt::Optio
             }
         }
 
+        if (g_merger) {
+            g_merger->stop();
+            g_merged_file->stopAndFlush();
+            if (g_soption.verbous) {
+                aprintf(stdout, "%s Merged frames: %llu\n", getTS(": ").c_str(), (unsigned long long)g_merger->getFrames());
+                for (auto& board : g_merger->getStatistic()) {
+                    aprintf(stdout,
+                            "%s %s packs %llu missing %llu lost samples %llu skew %.3f us (max %.3f us)\n",
+                            getTS(": ").c_str(),
+                            board.host.c_str(),
+                            (unsigned long long)board.packs,
+                            (unsigned long long)board.missingPacks,
+                            (unsigned long long)board.lostSamples,
+                            board.skew / 1000.0,
+                            board.maxSkew / 1000.0);
+                }
+            }
+            if (g_soption.streamign_type == ClientOpt::StreamingType::CSV) {
+                const std::lock_guard lock(g_s_csv_mutex);
+                auto fileName = g_merged_file->getCSVFileName();
+                g_converter["merged"] = converter_lib::CConverter::create();
+                g_converter["merged"]->convertToCSV(fileName, "merged", FH_CSV_ADD_INDEX);
+            }
+            g_merger = nullptr;
+            g_merged_file = nullptr;
+        }
+
         remote_opt.remote_mode = ClientOpt::RemoteMode::STOP;
         if (!startRemote(cl, remote_opt, nullptr, &runned_hosts)) {
             aprintf(stdout, "%s Can't stop streaming on remote machines\n", getTS(": ").c_str());
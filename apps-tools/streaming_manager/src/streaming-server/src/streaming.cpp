@@ -344,7 +344,7 @@ auto startServer(bool verbMode, bool testMode, bool is_master) -> void {
 
         // Create streaming handlers
         if (use_file.value == CStreamSettings::PassMode::NET) {
-            g_s_net = streaming_lib::CStreamingNet::create(ip_addr_host, NET_ADC_STREAMING_PORT);
+            g_s_net = streaming_lib::CStreamingNet::create(ip_addr_host, NET_ADC_STREAMING_PORT, streaming_lib::CStreamingNet::getTransport(settings));
             g_s_net->getBuffer = [g_s_buffer_w]() -> CDataBuffersPackDMA::Ptr {
                 auto obj = g_s_buffer_w.lock();
                 return obj ? obj->readBuffer() : nullptr;
@@ -0,0 +1,27 @@
+#!/usr/bin/python3
+
+import sys
+import streaming
+
+# Reads parts of a TDMS file saved by the streaming without loading the whole file
+
+file_name = sys.argv[1] if len(sys.argv) > 1 else "data_file.tdms"
+
+reader = streaming.TDMSFileReader()
+# The index file is created on the first open and makes the following opens instant
+if not reader.open(file_name, True):
+    print(f"Can't open {file_name}")
+    sys.exit(1)
+
+print(f"Index used: {reader.isIndexUsed()}")
+for channel in reader.getChannels():
+    samples = reader.getSamplesCount(channel)
+    bits = reader.getBitsBySample(channel)
+    print(f"Channel {channel}: {samples} samples, {bits} bits")
+    # 1000 samples from the middle of the file
+    first = samples // 2
+    data = reader.readDouble(channel, first, 1000)
+    if len(data):
+        print(f"  samples [{first}, {first + len(data)}): min {min(data)} max {max(data)}")
+
+reader.close()
@@ -12,6 +12,7 @@
 #include "data_lib/buffers_cached.h"
 #include "logger_lib/file_logger.h"
 #include "net_lib/asio_net.h"
+#include "streaming_lib/streaming_net.h"
 #include "uio_lib/memory_manager.h"
 
 class ADCCb : public ConfigCallback {
@@ -59,12 +60,12 @@ struct ADCStreamClient::Impl {
     std::map<std::string, bool> m_terminate;
     std::mutex m_smutex;
     std::atomic<int> m_runClientCounter;
-	auto runClient(ADCStreamClient *client, std::string host, uint32_t size, adc_channels_t activeChannels) -> void;
+	auto runClient(ADCStreamClient *client, std::string host, uint32_t size, adc_channels_t activeChannels, net_lib::SNetTransport transport) -> void;
 	std::vector<std::thread *> clients;
 	std::shared_ptr<ADCCb> m_configCallback;
 };
 
-auto ADCStreamClient::Impl::runClient(ADCStreamClient *client, std::string host, uint32_t size, adc_channels_t activeChannels) -> void
+auto ADCStreamClient::Impl::runClient(ADCStreamClient *client, std::string host, uint32_t size, adc_channels_t activeChannels, net_lib::SNetTransport transport) -> void
 {
 	auto memoryManager = new uio_lib::CMemoryManager();
 	auto buffers = DataLib::CBuffersCached::create();
@@ -79,7 +80,7 @@ auto ADCStreamClient::Impl::runClient(ADCStreamClient *client, std::string host,
 
 	auto g_s_buffers_w = std::weak_ptr<DataLib::CBuffersCached>(buffers);
 
-	auto g_asionet = net_lib::CAsioNet::create(net_lib::M_CLIENT, host, NET_ADC_STREAMING_PORT, buffers);
+	auto g_asionet = net_lib::CAsioNet::create(net_lib::M_CLIENT, host, NET_ADC_STREAMING_PORT, buffers, transport);
 
 	g_asionet->clientConnectNotify.connect([&](std::string host) {
 		const std::lock_guard lock(m_smutex);
@@ -122,6 +123,7 @@ auto ADCStreamClient::Impl::runClient(ADCStreamClient *client, std::string host,
                         if (buff) {
                             channel.bitsPerSample = buff->getBitBySample();
                             channel.fpgaLost = buff->getLostSamples(DataLib::FPGA);
+                            channel.networkLost = buff->getLostSamples(DataLib::NETWORK);
                             channel.samples = buff->getSamplesCount();
                             channel.adcBaseBits = buff->getADCBaseBits();
                             channel.baseRate = buff->getADCBaseRate();
@@ -227,6 +229,18 @@ auto ADCStreamClient::startStreaming() -> bool {
         return false;
 	}
 
+	// The transport is part of the server settings
+	std::map<std::string, net_lib::SNetTransport> transports;
+	for (auto& host : hosts) {
+		CStreamSettings settings;
+		auto config = m_pimpl->m_configClient->getFileConfig(host);
+		if (config == "" || !settings.parseJson(config)) {
+			aprintf(stderr, "%s Can't get network settings\n", getTS(": ").c_str());
+			return false;
+		}
+		transports[host] = streaming_lib::CStreamingNet::getTransport(settings);
+	}
+
 	std::map<string, StateRunningHosts> runned_hosts;
     stopStreaming();
 
@@ -234,7 +248,7 @@ auto ADCStreamClient::startStreaming() -> bool {
         m_pimpl->m_runClientCounter = runned_hosts.size();
         for (auto kv : runned_hosts) {
 			if (kv.second == StateRunningHosts::TCP && activeChannels[kv.first].count() > 0)
-				m_pimpl->clients.push_back(new std::thread(&ADCStreamClient::Impl::runClient, m_pimpl, this, kv.first, blockSizes[kv.first], activeChannels[kv.first]));
+				m_pimpl->clients.push_back(new std::thread(&ADCStreamClient::Impl::runClient, m_pimpl, this, kv.first, blockSizes[kv.first], activeChannels[kv.first], transports[kv.first]));
             else {
                 m_pimpl->m_runClientCounter--;
             }
@@ -10,6 +10,7 @@ struct ADCChannel {
     uint32_t samples = 0;
     uint8_t bitsPerSample = 0;
     uint64_t fpgaLost = 0;
+    uint64_t networkLost = 0;  // UDP only, samples of the datagrams that did not arrive
     bool attenuator_1_20 = false;
     uint32_t baseRate = 0;
     uint8_t adcBaseBits = 0;
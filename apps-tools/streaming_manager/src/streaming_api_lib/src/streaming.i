@@ -17,6 +17,7 @@
 #include "adc_streaming.h"
 #include "dac_streaming.h"
 #include "config_streaming.h"
+#include "tdms_reader.h"
 %}
 
 
@@ -32,6 +33,7 @@
 %template(StringVector) std::vector<std::string>;
 %template(Int16Vector) std::vector<int16_t>;
 %template(Int8Vector) std::vector<int8_t>;
+%template(DoubleVector) std::vector<double>;
 %template(StringList) std::list<std::string>;
 %template(BoolArray4) std::array<bool, 4>;
 
@@ -97,3 +99,4 @@
 %include "dac_streaming.h"
 %include "config_streaming.h"
 %include "callbacks.h"
+%include "tdms_reader.h"
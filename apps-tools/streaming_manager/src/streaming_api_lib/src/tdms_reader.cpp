@@ -0,0 +1,98 @@
+#include "tdms_reader.h"
+#include "tdms_lib/index_file.h"
+
+struct TDMSFileReader::Impl {
+    TDMS::IndexedFile m_file;
+
+    template <typename T>
+    auto read(std::string channel, uint64_t first, uint64_t count) -> std::vector<T> {
+        std::vector<T> data;
+        auto ch = m_file.findChannel(channel);
+        if (!ch || ch->typeSize != sizeof(T) || first >= ch->samples)
+            return data;
+        data.resize(std::min(count, ch->samples - first));
+        data.resize(m_file.read(ch, first, data.size(), data.data()));
+        return data;
+    }
+
+    template <typename T>
+    auto convert(std::string channel, uint64_t first, uint64_t count) -> std::vector<double> {
+        auto raw = read<T>(channel, first, count);
+        return std::vector<double>(raw.begin(), raw.end());
+    }
+};
+
+TDMSFileReader::TDMSFileReader() {
+    m_pimpl = new Impl();
+}
+
+TDMSFileReader::~TDMSFileReader() {
+    delete m_pimpl;
+}
+
+auto TDMSFileReader::open(std::string fileName, bool writeIndex) -> bool {
+    return m_pimpl->m_file.open(fileName, writeIndex);
+}
+
+auto TDMSFileReader::close() -> void {
+    m_pimpl->m_file.close();
+}
+
+auto TDMSFileReader::isOpen() -> bool {
+    return m_pimpl->m_file.isOpen();
+}
+
+auto TDMSFileReader::isIndexUsed() -> bool {
+    return m_pimpl->m_file.isIndexUsed();
+}
+
+auto TDMSFileReader::getChannels() -> std::vector<std::string> {
+    std::vector<std::string> names;
+    for (auto& ch : m_pimpl->m_file.getChannels())
+        names.push_back(ch.name);
+    return names;
+}
+
+auto TDMSFileReader::getSamplesCount(std::string channel) -> uint64_t {
+    auto ch = m_pimpl->m_file.findChannel(channel);
+    return ch ? ch->samples : 0;
+}
+
+auto TDMSFileReader::getBitsBySample(std::string channel) -> uint8_t {
+    auto ch = m_pimpl->m_file.findChannel(channel);
+    return ch ? ch->typeSize * 8 : 0;
+}
+
+auto TDMSFileReader::readInt8(std::string channel, uint64_t first, uint64_t count) -> std::vector<int8_t> {
+    return m_pimpl->read<int8_t>(channel, first, count);
+}
+
+auto TDMSFileReader::readInt16(std::string channel, uint64_t first, uint64_t count) -> std::vector<int16_t> {
+    return m_pimpl->read<int16_t>(channel, first, count);
+}
+
+auto TDMSFileReader::readDouble(std::string channel, uint64_t first, uint64_t count) -> std::vector<double> {
+    auto ch = m_pimpl->m_file.findChannel(channel);
+    if (!ch)
+        return {};
+    switch (ch->type) {
+        case TDMS::TDMSType::Integer8:
+            return m_pimpl->convert<int8_t>(channel, first, count);
+        case TDMS::TDMSType::UnsignedInteger8:
+            return m_pimpl->convert<uint8_t>(channel, first, count);
+        case TDMS::TDMSType::Integer16:
+            return m_pimpl->convert<int16_t>(channel, first, count);
+        case TDMS::TDMSType::UnsignedInteger16:
+            return m_pimpl->convert<uint16_t>(channel, first, count);
+        case TDMS::TDMSType::Integer32:
+            return m_pimpl->convert<int32_t>(channel, first, count);
+        case TDMS::TDMSType::UnsignedInteger32:
+            return m_pimpl->convert<uint32_t>(channel, first, count);
+        case TDMS::TDMSType::SingleFloat:
+            return m_pimpl->convert<float>(channel, first, count);
+        case TDMS::TDMSType::DoubleFloat:
+            return m_pimpl->convert<double>(channel, first, count);
+        default:
+            return {};
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef TDMS_READER_H
+#define TDMS_READER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Random access reader of TDMS files saved by the streaming. Only the requested samples are read from the file.
+class TDMSFileReader {
+   public:
+    TDMSFileReader();
+    ~TDMSFileReader();
+
+    // With writeIndex the "<file>.tdms_index" file is created, so the next open does not walk the data file
+    auto open(std::string fileName, bool writeIndex = false) -> bool;
+    auto close() -> void;
+    auto isOpen() -> bool;
+    auto isIndexUsed() -> bool;
+
+    auto getChannels() -> std::vector<std::string>;
+    auto getSamplesCount(std::string channel) -> uint64_t;
+    auto getBitsBySample(std::string channel) -> uint8_t;
+
+    // Read count samples from the first sample. The channel type must match the function.
+    auto readInt8(std::string channel, uint64_t first, uint64_t count) -> std::vector<int8_t>;
+    auto readInt16(std::string channel, uint64_t first, uint64_t count) -> std::vector<int16_t>;
+    // Converts any integer or float channel
+    auto readDouble(std::string channel, uint64_t first, uint64_t count) -> std::vector<double>;
+
+   private:
+    TDMSFileReader(const TDMSFileReader&) = delete;
+    TDMSFileReader& operator=(const TDMSFileReader&) = delete;
+
+    struct Impl;
+    // Pointer to the internal implementation
+    Impl* m_pimpl;
+};
+
+#endif
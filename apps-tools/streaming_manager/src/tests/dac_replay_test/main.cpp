@@ -0,0 +1,263 @@
+/**
+ * Replays generated WAV and TDMS files through CReaderController with the memory mapped reader and with the stream reader.
+ * Checks that both produce the same blocks and prints the throughput.
+ * TDMS files are also replayed with a .tdms_index file and read back at random positions through TDMS::IndexedFile.
+ *
+ * Usage: dac_replay_test [file size MB] [block size]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "reader_lib/reader_controller.h"
+#include "tdms_lib/file.h"
+#include "tdms_lib/index_file.h"
+#include "tdms_lib/writer.h"
+
+using namespace std;
+
+struct SReplayResult {
+    vector<uint8_t> ch[MAX_DAC_CHANNELS];
+    double openSeconds = 0;
+    double seconds = 0;
+    CReaderController::BufferResult result = CReaderController::BR_OK;
+};
+
+static auto samplePattern(size_t index, int channel) -> uint16_t {
+    return (uint16_t)(index * 7 + channel * 1000);
+}
+
+static auto createWav(const string& path, uint16_t channels, uint16_t bits, uint32_t samples) -> void {
+    uint32_t dataSize = samples * channels * (bits / 8);
+    uint32_t value32;
+    uint16_t value16;
+    ofstream file(path, ios::binary);
+    file.write("RIFF", 4);
+    value32 = 36 + dataSize;
+    file.write((char*)&value32, 4);
+    file.write("WAVEfmt ", 8);
+    value32 = 16;
+    file.write((char*)&value32, 4);
+    value16 = 1;
+    file.write((char*)&value16, 2);
+    file.write((char*)&channels, 2);
+    value32 = 125000000;
+    file.write((char*)&value32, 4);
+    value32 = 125000000 * channels * (bits / 8);
+    file.write((char*)&value32, 4);
+    value16 = channels * (bits / 8);
+    file.write((char*)&value16, 2);
+    file.write((char*)&bits, 2);
+    file.write("data", 4);
+    file.write((char*)&dataSize, 4);
+    vector<uint8_t> frames(dataSize);
+    for (uint32_t i = 0; i < samples; i++) {
+        for (uint16_t ch = 0; ch < channels; ch++) {
+            auto value = samplePattern(i, ch);
+            memcpy(frames.data() + (i * channels + ch) * (bits / 8), &value, bits / 8);
+        }
+    }
+    file.write((char*)frames.data(), frames.size());
+}
+
+static auto createTdms(const string& path, uint32_t segments, uint32_t samplesPerSegment, int channels = 2) -> void {
+    remove(path.c_str());
+    TDMS::File file;
+    for (uint32_t seg = 0; seg < segments; seg++) {
+        TDMS::WriterSegment segment;
+        vector<shared_ptr<TDMS::Metadata>> data;
+        auto root = segment.GenerateRoot();
+        root->TableOfContents.HasMetaData = true;
+        root->TableOfContents.HasRawData = true;
+        data.push_back(root);
+        data.push_back(segment.GenerateGroup("Group"));
+        for (int ch = 0; ch < channels; ch++) {
+            auto channel = segment.GenerateChannel("Group", ch == 0 ? "ch1" : "ch2");
+            data.push_back(channel);
+            auto raw = std::shared_ptr<uint8_t[]>(new uint8_t[samplesPerSegment * 2]);
+            auto values = (uint16_t*)raw.get();
+            for (uint32_t i = 0; i < samplesPerSegment; i++) {
+                values[i] = samplePattern(seg * samplesPerSegment + i, ch);
+            }
+            segment.AddRaw(channel, TDMS::TDMSType::Integer16, samplesPerSegment, raw);
+        }
+        segment.LoadMetadata(data);
+        file.WriteFile(path, segment, seg != 0);
+    }
+}
+
+template <typename T>
+static auto writeValue(vector<uint8_t>& buffer, T value) -> void {
+    buffer.insert(buffer.end(), (uint8_t*)&value, (uint8_t*)&value + sizeof(T));
+}
+
+static auto writeString(vector<uint8_t>& buffer, const string& value) -> void {
+    writeValue<uint32_t>(buffer, value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+// Segments with interleaved raw data of two Int16 channels. The TDMS writer only produces continuous data.
+static auto createInterleavedTdms(const string& path, uint32_t segments, uint32_t samplesPerSegment) -> void {
+    ofstream file(path, ios::binary);
+    for (uint32_t seg = 0; seg < segments; seg++) {
+        vector<uint8_t> meta;
+        writeValue<uint32_t>(meta, 4);
+        writeString(meta, "/");
+        writeValue<uint32_t>(meta, 0xFFFFFFFF);
+        writeValue<uint32_t>(meta, 0);
+        writeString(meta, "/'Group'");
+        writeValue<uint32_t>(meta, 0xFFFFFFFF);
+        writeValue<uint32_t>(meta, 0);
+        for (auto name : {"/'Group'/'ch1'", "/'Group'/'ch2'"}) {
+            writeString(meta, name);
+            writeValue<uint32_t>(meta, 20);
+            writeValue<uint32_t>(meta, (uint32_t)TDMS::TDMSType::Integer16);
+            writeValue<uint32_t>(meta, 1);
+            writeValue<uint64_t>(meta, samplesPerSegment);
+            writeValue<uint32_t>(meta, 0);
+        }
+        vector<uint8_t> raw;
+        for (uint32_t i = 0; i < samplesPerSegment; i++) {
+            writeValue<uint16_t>(raw, samplePattern(seg * samplesPerSegment + i, 0));
+            writeValue<uint16_t>(raw, samplePattern(seg * samplesPerSegment + i, 1));
+        }
+        vector<uint8_t> leadIn;
+        leadIn.insert(leadIn.end(), {'T', 'D', 'S', 'm'});
+        writeValue<uint32_t>(leadIn, (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5));
+        writeValue<uint32_t>(leadIn, 4713);
+        writeValue<uint64_t>(leadIn, meta.size() + raw.size());
+        writeValue<uint64_t>(leadIn, meta.size());
+        file.write((char*)leadIn.data(), leadIn.size());
+        file.write((char*)meta.data(), meta.size());
+        file.write((char*)raw.data(), raw.size());
+    }
+}
+
+// Reads samples at pseudo random positions and compares them with the generated pattern
+static auto checkIndexedRead(const char* name, const string& path, int channels, uint64_t samples) -> bool {
+    TDMS::IndexedFile file;
+    bool ok = file.open(path);
+    vector<uint16_t> values;
+    uint64_t position = 12345;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; ok && i < 1000; i++) {
+        position = (position * 6364136223846793005ull + 1442695040888963407ull);
+        uint64_t first = (position >> 20) % samples;
+        uint64_t count = std::min<uint64_t>(1 + (position >> 8) % 100000, samples - first);
+        values.resize(count);
+        for (int ch = 0; ok && ch < channels; ch++) {
+            auto channel = file.findChannel(ch == 0 ? "ch1" : "ch2");
+            ok = channel && channel->samples == samples && file.read(channel, first, count, values.data()) == count;
+            for (uint64_t j = 0; ok && j < count; j++) {
+                ok = values[j] == samplePattern(first + j, ch);
+            }
+            auto spans = file.getSpans<uint16_t>(channel, first, 1);
+            ok = ok && spans.size() == 1 && spans[0].at(0) == samplePattern(first, ch);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("%-12s %s  random read %8.1f us/read (index %s)\n", name, ok ? "OK  " : "FAIL", seconds * 1e6 / 1000, file.isIndexUsed() ? "used" : "not used");
+    return ok;
+}
+
+static auto replay(CStreamSettings::DataFormat format, const string& path, uint32_t repeat, uint32_t blockSize, bool useMmap) -> SReplayResult {
+    SReplayResult res;
+    auto begin = std::chrono::steady_clock::now();
+    CReaderController reader(format, path, CStreamSettings::DACRepeat::DAC_REP_ON, repeat, blockSize, useMmap);
+    if (reader.isOpen() != CReaderController::OR_OK) {
+        res.result = CReaderController::BR_BROKEN;
+        return res;
+    }
+    if (reader.isMapped() != useMmap) {
+        fprintf(stderr, "%s: reader mapped mode %d, expected %d\n", path.c_str(), reader.isMapped(), useMmap);
+    }
+    vector<uint8_t> dst(blockSize);
+    size_t chSizes[MAX_DAC_CHANNELS] = {0, 0};
+    reader.getChannelsSize(&chSizes[0], &chSizes[1]);
+    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+        res.ch[idx].reserve(chSizes[idx] * repeat + blockSize);
+    }
+    auto opened = std::chrono::steady_clock::now();
+    res.openSeconds = std::chrono::duration<double>(opened - begin).count();
+    while (true) {
+        CReaderController::Data data;
+        res.result = useMmap ? reader.getBufferPrepared(data, {dst.data(), nullptr}) : reader.getBufferPrepared(data);
+        for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+            if (data.ch[idx] && data.size[idx])
+                res.ch[idx].insert(res.ch[idx].end(), data.ch[idx], data.ch[idx] + data.size[idx]);
+        }
+        if (res.result != CReaderController::BR_OK)
+            break;
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - opened).count();
+    return res;
+}
+
+static auto runCase(const char* name, CStreamSettings::DataFormat format, const string& path, uint32_t repeat, uint32_t blockSize) -> bool {
+    auto mapped = replay(format, path, repeat, blockSize, true);
+    auto stream = replay(format, path, repeat, blockSize, false);
+    bool ok = mapped.result == CReaderController::BR_ENDED && stream.result == CReaderController::BR_ENDED;
+    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+        ok = ok && mapped.ch[idx] == stream.ch[idx];
+    }
+    double mb = (mapped.ch[0].size() + mapped.ch[1].size()) / (1024.0 * 1024.0);
+    printf("%-12s %s  mmap %8.1f MB/s (open %6.1f ms)  stream %8.1f MB/s (open %6.1f ms)\n", name, ok ? "OK  " : "FAIL", mb / mapped.seconds,
+           mapped.openSeconds * 1000, mb / stream.seconds, stream.openSeconds * 1000);
+    return ok;
+}
+
+// The stream reader does not de-interleave TDMS data, so the mapped reader is compared with the generated pattern
+static auto runPatternCase(const char* name, CStreamSettings::DataFormat format, const string& path, uint64_t samples, uint32_t blockSize) -> bool {
+    auto mapped = replay(format, path, 1, blockSize, true);
+    bool ok = mapped.result == CReaderController::BR_ENDED;
+    for (auto idx = 0u; idx < MAX_DAC_CHANNELS; idx++) {
+        ok = ok && mapped.ch[idx].size() >= samples * 2;
+        for (uint64_t i = 0; ok && i < samples; i++) {
+            ok = ((uint16_t*)mapped.ch[idx].data())[i] == samplePattern(i, idx);
+        }
+    }
+    double mb = (mapped.ch[0].size() + mapped.ch[1].size()) / (1024.0 * 1024.0);
+    printf("%-12s %s  mmap %8.1f MB/s (open %6.1f ms)\n", name, ok ? "OK  " : "FAIL", mb / mapped.seconds, mapped.openSeconds * 1000);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t sizeMB = argc > 1 ? atoi(argv[1]) : 16;
+    uint32_t blockSize = argc > 2 ? atoi(argv[2]) : 128 * 1024;
+    uint32_t samples = sizeMB * 1024 * 1024 / 4;
+    bool ok = true;
+
+    createWav("replay_mono16.wav", 1, 16, samples * 2 + 123);
+    createWav("replay_stereo16.wav", 2, 16, samples + 77);
+    createWav("replay_stereo8.wav", 2, 8, samples * 2 + 6);
+    createTdms("replay.tdms", sizeMB * 4, 64 * 1024);
+    createTdms("replay_ch1.tdms", sizeMB * 4, 128 * 1024, 1);
+    createInterleavedTdms("replay_interleaved.tdms", sizeMB * 4, 64 * 1024);
+    remove(TDMS::IndexedFile::getIndexFileName("replay.tdms").c_str());
+
+    ok &= runCase("wav mono16", CStreamSettings::DataFormat::WAV, "replay_mono16.wav", 2, blockSize);
+    ok &= runCase("wav stereo16", CStreamSettings::DataFormat::WAV, "replay_stereo16.wav", 2, blockSize);
+    ok &= runCase("wav stereo8", CStreamSettings::DataFormat::WAV, "replay_stereo8.wav", 1, blockSize);
+    ok &= runCase("tdms", CStreamSettings::DataFormat::TDMS, "replay.tdms", 2, blockSize);
+    ok &= runCase("tdms ch1", CStreamSettings::DataFormat::TDMS, "replay_ch1.tdms", 2, blockSize);
+    ok &= runPatternCase("tdms interl.", CStreamSettings::DataFormat::TDMS, "replay_interleaved.tdms", (uint64_t)sizeMB * 4 * 64 * 1024, blockSize);
+    ok &= checkIndexedRead("read", "replay.tdms", 2, (uint64_t)sizeMB * 4 * 64 * 1024);
+    ok &= checkIndexedRead("read interl.", "replay_interleaved.tdms", 2, (uint64_t)sizeMB * 4 * 64 * 1024);
+    ok &= TDMS::IndexedFile::writeIndex("replay.tdms");
+    ok &= runCase("tdms index", CStreamSettings::DataFormat::TDMS, "replay.tdms", 2, blockSize);
+    ok &= checkIndexedRead("read index", "replay.tdms", 2, (uint64_t)sizeMB * 4 * 64 * 1024);
+
+    remove("replay_mono16.wav");
+    remove("replay_stereo16.wav");
+    remove("replay_stereo8.wav");
+    remove("replay.tdms");
+    remove(TDMS::IndexedFile::getIndexFileName("replay.tdms").c_str());
+    remove("replay_ch1.tdms");
+    remove("replay_interleaved.tdms");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/**
+ * Streams ADC packs from a server to a client over the loopback interface with the TCP and the UDP transport.
+ * Prints the CPU time per MB of both ends together and, for UDP, the datagrams and samples that were lost.
+ * The server sends as fast as it can, so UDP losses show where the receiver falls behind.
+ *
+ * Usage: net_loopback_test [MB to send] [block size] [datagram size]
+ */
+
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "data_lib/network_header.h"
+#include "net_lib/asio_net.h"
+#include "uio_lib/memory_manager.h"
+
+using namespace std;
+
+struct SLoopbackResult {
+    uint64_t sentBytes = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t receivedPacks = 0;
+    uint64_t lostSamples = 0;
+    uint64_t lostDatagrams = 0;
+    double seconds = 0;
+    double cpuSeconds = 0;
+};
+
+static auto cpuTime() -> double {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static auto createBuffers(uio_lib::CMemoryManager* manager, uint32_t blockSize) -> DataLib::CBuffersCached::Ptr {
+    adc_channels_t channels;
+    channels.enable(ADCChannels::ADC_CH1);
+    channels.enable(ADCChannels::ADC_CH2);
+    manager->setMemoryBlockSize(blockSize);
+    manager->reallocateBlocks();
+    manager->reserveMemory(uio_lib::MM_ADC, manager->getFreeBlockCount(), channels.count());
+    auto buffers = DataLib::CBuffersCached::create();
+    buffers->generateBuffersEmptyADC(channels, manager->getRegions(uio_lib::MM_ADC), DataLib::sizeHeader());
+    return buffers;
+}
+
+static auto runLoopback(net_lib::SNetTransport transport, uint16_t port, uint64_t totalBytes, uint32_t blockSize) -> SLoopbackResult {
+    SLoopbackResult result;
+    uio_lib::CMemoryManager serverMemory;
+    uio_lib::CMemoryManager clientMemory;
+    auto serverBuffers = createBuffers(&serverMemory, blockSize);
+    auto clientBuffers = createBuffers(&clientMemory, blockSize);
+    serverBuffers->initHeadersADC();
+
+    atomic<uint64_t> receivedBytes = 0;
+    atomic<uint64_t> receivedPacks = 0;
+    atomic<uint64_t> lostSamples = 0;
+
+    auto server = net_lib::CAsioNet::create(net_lib::M_SERVER, "127.0.0.1", port, serverBuffers, transport);
+    auto client = net_lib::CAsioNet::create(net_lib::M_CLIENT, "127.0.0.1", port, clientBuffers, transport);
+    client->reciveNotify.connect([&](error_code error, DataLib::CDataBuffersPackDMA::Ptr pack) {
+        if (!error) {
+            for (auto ch = (int)DataLib::CH1; ch <= (int)DataLib::CH4; ch++) {
+                auto buff = pack->getBuffer((DataLib::EDataBuffersPackChannel)ch);
+                if (buff) {
+                    lostSamples += buff->getLostSamples(DataLib::NETWORK);
+                }
+            }
+            receivedBytes += pack->getLenghtBuffers();
+            receivedPacks++;
+            clientBuffers->unlockBufferRead();
+        }
+    });
+    server->start();
+    client->start();
+
+    auto waitStart = chrono::steady_clock::now();
+    while (!server->isConnected()) {
+        if (chrono::steady_clock::now() - waitStart > chrono::seconds(5)) {
+            fprintf(stderr, "Client did not connect\n");
+            return result;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+
+    auto startTime = chrono::steady_clock::now();
+    auto startCpu = cpuTime();
+    uint64_t id = 0;
+    while (result.sentBytes < totalBytes) {
+        auto pack = serverBuffers->writeBuffer();
+        for (auto ch = (int)DataLib::CH1; ch <= (int)DataLib::CH4; ch++) {
+            auto buff = pack->getBuffer((DataLib::EDataBuffersPackChannel)ch);
+            if (buff) {
+                DataLib::setHeaderADC(buff, id);
+            }
+        }
+        serverBuffers->unlockBufferWrite();
+        pack = serverBuffers->readBuffer();
+        if (!server->sendSyncData(pack)) {
+            fprintf(stderr, "Send failed\n");
+            break;
+        }
+        serverBuffers->unlockBufferRead();
+        result.sentBytes += pack->getLenghtBuffers();
+        id++;
+    }
+
+    // Let the client drain what is still in the socket buffer
+    auto lastBytes = receivedBytes.load();
+    while (true) {
+        this_thread::sleep_for(chrono::milliseconds(200));
+        if (receivedBytes == lastBytes || receivedBytes >= result.sentBytes)
+            break;
+        lastBytes = receivedBytes;
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    result.cpuSeconds = cpuTime() - startCpu;
+    result.receivedBytes = receivedBytes;
+    result.receivedPacks = receivedPacks;
+    result.lostSamples = lostSamples;
+    result.lostDatagrams = client->getLostDatagrams();
+    client->stop();
+    server->stop();
+    return result;
+}
+
+static auto printResult(const char* name, const SLoopbackResult& result) -> void {
+    double sentMB = result.sentBytes / (1024.0 * 1024.0);
+    double receivedMB = result.receivedBytes / (1024.0 * 1024.0);
+    printf("%-14s sent %8.1f MB  received %8.1f MB in %6.3f s  %8.1f MB/s  CPU %7.3f ms/MB  packs %llu  lost datagrams %llu  lost samples %llu\n",
+           name,
+           sentMB,
+           receivedMB,
+           result.seconds,
+           receivedMB / result.seconds,
+           receivedMB > 0 ? result.cpuSeconds * 1000.0 / receivedMB : 0,
+           (unsigned long long)result.receivedPacks,
+           (unsigned long long)result.lostDatagrams,
+           (unsigned long long)result.lostSamples);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t totalMB = argc > 1 ? atoll(argv[1]) : 512;
+    uint32_t blockSize = argc > 2 ? atoi(argv[2]) : 64 * 1024;
+    uint32_t datagram = argc > 3 ? atoi(argv[3]) : NET_UDP_PAYLOAD;
+    uint64_t totalBytes = totalMB * 1024 * 1024;
+
+    net_lib::SNetTransport tcp;
+    printResult("TCP", runLoopback(tcp, 18950, totalBytes, blockSize));
+
+    net_lib::SNetTransport udp;
+    udp.protocol = net_lib::P_UDP;
+    udp.datagram = datagram;
+    printResult("UDP", runLoopback(udp, 18951, totalBytes, blockSize));
+
+    net_lib::SNetTransport jumbo;
+    jumbo.protocol = net_lib::P_UDP;
+    jumbo.datagram = NET_UDP_PAYLOAD_JUMBO;
+    printResult("UDP jumbo", runLoopback(jumbo, 18952, totalBytes, blockSize));
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * Merges the packs of two simulated boards with CStreamingMerger into one TDMS file and reads it back.
+ * The second board starts two packs later, its capture time is 300 ns late and one of its packs never arrives.
+ * Checks the alignment, the zeros written for the missing pack and the per board statistics.
+ *
+ * Usage: stream_merger_test
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "data_lib/network_header.h"
+#include "streaming_lib/streaming_merger.h"
+#include "tdms_lib/index_file.h"
+#include "uio_lib/memory_manager.h"
+
+using namespace std;
+
+#define BLOCK_SAMPLES 4096
+#define RATE 1953125
+#define FRAMES 18
+#define MISSING_FRAME 5
+#define SKEW 300
+
+static auto samplePattern(uint64_t index, int channel) -> uint16_t {
+    return (uint16_t)(index * 3 + channel * 10000 + 1);
+}
+
+struct SBoardSim {
+    uio_lib::CMemoryManager memory;
+    DataLib::CBuffersCached::Ptr buffers;
+};
+
+static auto createBoard(SBoardSim* board) -> void {
+    adc_channels_t channels;
+    channels.enable(ADCChannels::ADC_CH1);
+    channels.enable(ADCChannels::ADC_CH2);
+    board->memory.setMemoryBlockSize(BLOCK_SAMPLES * 2 + DataLib::sizeHeader());
+    board->memory.reallocateBlocks();
+    board->memory.reserveMemory(uio_lib::MM_ADC, 64, channels.count());
+    board->buffers = DataLib::CBuffersCached::create();
+    board->buffers->generateBuffersEmptyADC(channels, board->memory.getRegions(uio_lib::MM_ADC), DataLib::sizeHeader());
+}
+
+// Samples of a pack after the memory manager rounded the block size
+static uint64_t g_packSamples = 0;
+
+// Frame is the index of the pack in the merged file, channel is the column of the board in the file
+static auto passPack(streaming_lib::CStreamingMerger::Ptr merger, int board, SBoardSim* sim, uint64_t id, int64_t time, int64_t frame, int firstColumn) -> void {
+    sim->buffers->writeBuffer();
+    sim->buffers->unlockBufferWrite();
+    auto pack = sim->buffers->readBuffer();
+    for (auto ch = (int)DataLib::CH1; ch <= (int)DataLib::CH2; ch++) {
+        auto buff = pack->getBuffer((DataLib::EDataBuffersPackChannel)ch);
+        buff->setBitBySample(16);
+        buff->setADCBaseRate(RATE);
+        buff->setADCPackId(id);
+        buff->setTimeCapture(time);
+        buff->setLostSamples(DataLib::FPGA, 0);
+        buff->setLostSamples(DataLib::NETWORK, 0);
+        g_packSamples = buff->getSamplesCount();
+        auto data = (uint16_t*)buff->getMappedDataMemory();
+        for (uint32_t i = 0; i < g_packSamples; i++) {
+            data[i] = frame >= 0 ? samplePattern(frame * g_packSamples + i, firstColumn + ch) : 0xFFFF;
+        }
+    }
+    merger->passBuffers(board, sim->buffers, pack);
+}
+
+static auto checkFile(const string& path) -> bool {
+    TDMS::IndexedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    const char* names[] = {"A_ch1", "A_ch2", "B_ch1", "B_ch2"};
+    vector<uint16_t> values(FRAMES * g_packSamples);
+    for (int column = 0; column < 4; column++) {
+        auto channel = file.findChannel(names[column]);
+        if (!channel || channel->samples != values.size() || file.read(channel, 0, values.size(), values.data()) != values.size()) {
+            fprintf(stderr, "%s: wrong size\n", names[column]);
+            return false;
+        }
+        for (uint64_t i = 0; i < values.size(); i++) {
+            bool missing = column >= 2 && i / g_packSamples == MISSING_FRAME;
+            uint16_t expected = missing ? 0 : samplePattern(i, column);
+            if (values[i] != expected) {
+                fprintf(stderr, "%s: sample %llu is %u, expected %u\n", names[column], (unsigned long long)i, values[i], expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int, char*[]) {
+    string dir = "merger_test";
+    SBoardSim boardA;
+    SBoardSim boardB;
+    createBoard(&boardA);
+    createBoard(&boardB);
+
+    auto file = streaming_lib::CStreamingFile::create(CStreamSettings::DataFormat::TDMS, dir, 0, false, false);
+    file->run("merged");
+    auto merger = streaming_lib::CStreamingMerger::create(file, 8);
+    auto a = merger->addBoard("A");
+    auto b = merger->addBoard("B");
+    merger->run();
+
+    // A starts two packs before B. Its first two packs have no partner and are dropped by the alignment.
+    int64_t start = 1000000000000ll;
+    int64_t packTime = BLOCK_SAMPLES * 1000000000ll / RATE;
+    for (int k = 0; k < FRAMES + 2; k++) {
+        passPack(merger, a, &boardA, 100 + k, start + k * packTime, k - 2, 0);
+        if (k >= 2 && k - 2 != MISSING_FRAME) {
+            passPack(merger, b, &boardB, 5 + k, start + k * packTime + SKEW, k - 2, 2);
+        }
+    }
+    merger->finishBoard(a);
+    merger->finishBoard(b);
+    merger->stop();
+    file->stopAndFlush();
+
+    bool ok = merger->getFrames() == FRAMES;
+    auto statistic = merger->getStatistic();
+    for (auto& board : statistic) {
+        printf("%s packs %llu missing %llu lost samples %llu skew %lld ns (max %lld ns)\n",
+               board.host.c_str(),
+               (unsigned long long)board.packs,
+               (unsigned long long)board.missingPacks,
+               (unsigned long long)board.lostSamples,
+               (long long)board.skew,
+               (long long)board.maxSkew);
+    }
+    ok = ok && statistic[0].packs == FRAMES && statistic[0].missingPacks == 0 && statistic[0].lostSamples == 0;
+    ok = ok && statistic[1].packs == FRAMES - 1 && statistic[1].missingPacks == 1 && statistic[1].lostSamples == 2 * g_packSamples;
+    ok = ok && statistic[1].skew == SKEW && statistic[1].maxSkew == SKEW;
+    ok = ok && checkFile(file->getCSVFileName());
+    printf("frames %llu %s\n", (unsigned long long)merger->getFrames(), ok ? "OK" : "FAIL");
+
+    remove(file->getCSVFileName().c_str());
+    remove((file->getCSVFileName() + ".log").c_str());
+    remove(dir.c_str());
+    return ok ? 0 : 1;
+}
@@ -843,7 +843,7 @@ bool startServer(bool testMode) {
 
         // Create streaming handlers
         if (use_file.value == CStreamSettings::PassMode::NET) {
-            g_s_net = streaming_lib::CStreamingNet::create(ip_addr_host, sock_port);
+            g_s_net = streaming_lib::CStreamingNet::create(ip_addr_host, sock_port, streaming_lib::CStreamingNet::getTransport(settings));
             g_s_net->getBuffer = [g_s_buffer_w]() -> DataLib::CDataBuffersPackDMA::Ptr {
                 auto obj = g_s_buffer_w.lock();
                 return obj ? obj->readBuffer() : nullptr;
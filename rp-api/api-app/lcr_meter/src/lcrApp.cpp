@@ -158,3 +158,31 @@ int lcrApp_LcrSetShuntMode(lcr_shunt_mode_t shunt_mode) {
 int lcrApp_LcrGetShuntMode(lcr_shunt_mode_t* shunt_mode) {
     return lcr_GetShuntMode(shunt_mode);
 }
+
+int lcrApp_LcrSetLockIn(bool enable) {
+    return lcr_SetLockIn(enable);
+}
+
+int lcrApp_LcrGetLockIn(bool* enable) {
+    return lcr_GetLockIn(enable);
+}
+
+int lcrApp_LcrSetLockInTimeConstant(float tau) {
+    return lcr_SetLockInTimeConstant(tau);
+}
+
+int lcrApp_LcrGetLockInTimeConstant(float* tau) {
+    return lcr_GetLockInTimeConstant(tau);
+}
+
+int lcrApp_LcrSetLockInRate(float rate) {
+    return lcr_SetLockInRate(rate);
+}
+
+int lcrApp_LcrGetLockInRate(float* rate) {
+    return lcr_GetLockInRate(rate);
+}
+
+int lcrApp_LcrGetLockInStat(uint64_t* outputs, uint64_t* dropped) {
+    return lcr_GetLockInStat(outputs, dropped);
+}
@@ -11,6 +11,8 @@
 #ifndef __LCR_APP_H
 #define __LCR_APP_H
 
+#include <stdint.h>
+
 typedef enum calibration {
     CALIB_NONE,
     CALIB_OPEN,
@@ -103,6 +105,18 @@ int lcrApp_LcrGetMeasSeries(bool* series);
 int lcrApp_LcrCheckExtensionModuleConnection(bool _muteWarnings);
 int lcrApp_LcrIsModuleConnected(bool* state);
 
+// Continuous lock-in mode. The acquisition is not re-armed, readings are published at the output rate.
+int lcrApp_LcrSetLockIn(bool enable);
+int lcrApp_LcrGetLockIn(bool* enable);
+// Time constant of the output filter in seconds [0 - 100]. 0 publishes the last block.
+int lcrApp_LcrSetLockInTimeConstant(float tau);
+int lcrApp_LcrGetLockInTimeConstant(float* tau);
+// Readings per second [0.1 - 1000]
+int lcrApp_LcrSetLockInRate(float rate);
+int lcrApp_LcrGetLockInRate(float* rate);
+// Readings published and blocks dropped since the lock-in was armed
+int lcrApp_LcrGetLockInStat(uint64_t* outputs, uint64_t* dropped);
+
 const char* lcrApp_LcrGetError(lcr_error_t errorCode);
 
 #endif  //__LCR_APP_H
@@ -0,0 +1,320 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya LCR meter continuous lock-in engine
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*/
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+#include "lcr_lockin.h"
+#include "rp_hw-profiles.h"
+#include "utils.h"
+
+CLCRLockIn::CLCRLockIn() {}
+
+CLCRLockIn::~CLCRLockIn() {
+    stop();
+}
+
+auto CLCRLockIn::setTimeConstant(float _tau) -> int {
+    if (_tau < 0 || _tau > 100) {
+        return RP_LCR_ERROR_INVALID_VALUE;
+    }
+    m_tau = _tau;
+    return RP_LCR_OK;
+}
+
+auto CLCRLockIn::getTimeConstant() -> float {
+    return m_tau;
+}
+
+auto CLCRLockIn::setOutputRate(float _rate) -> int {
+    if (_rate < 0.1 || _rate > 1000) {
+        return RP_LCR_ERROR_INVALID_VALUE;
+    }
+    m_rate = _rate;
+    return RP_LCR_OK;
+}
+
+auto CLCRLockIn::getOutputRate() -> float {
+    return m_rate;
+}
+
+auto CLCRLockIn::start(float _freq, uint32_t _adc_rate) -> int {
+    stop();
+    if (_freq <= 0) {
+        return RP_LCR_ERROR_INVALID_VALUE;
+    }
+
+    int dec = 1;
+    lcr_getDecimationValue(_freq, &dec, _adc_rate, SAMPLES_PER_PERIOD);
+    m_freq = _freq;
+    m_decimation = dec;
+    m_sample_rate = (double)_adc_rate / dec;
+    m_cycles_per_sample = _freq / m_sample_rate;
+
+    // Two channels share the DDR region. Without AXI the 16k buffer is followed the same way.
+    uint32_t axi_start = 0;
+    uint32_t axi_size = 0;
+    uint32_t ch_bytes = 0;
+    m_axi = false;
+    if (rp_HPGetIsDMAinv0_94OrDefault() && rp_AcqAxiGetMemoryRegion(&axi_start, &axi_size) == RP_OK) {
+        ch_bytes = (axi_size / 2) & ~0xFu;
+        m_ring_samples = ch_bytes / sizeof(int16_t);
+        m_axi = m_ring_samples >= MAX_BLOCK * 4;
+    }
+    if (!m_axi) {
+        m_ring_samples = ADC_BUFFER_SIZE;
+    }
+
+    ECHECK(rp_AcqStop());
+    if (m_axi) {
+        ECHECK(rp_AcqAxiSetDecimationFactor(m_decimation));
+        for (auto ch : {RP_CH_1, RP_CH_2}) {
+            ECHECK(rp_AcqAxiSetTriggerDelay(ch, m_ring_samples));
+            ECHECK(rp_AcqAxiSetBufferSamples(ch, axi_start + ch_bytes * ch, m_ring_samples));
+            ECHECK(rp_AcqAxiEnable(ch, true));
+        }
+    } else {
+        ECHECK(rp_AcqReset());
+        ECHECK(rp_AcqSetDecimationFactor(m_decimation));
+        ECHECK(rp_AcqSetTriggerDelayDirect(ADC_BUFFER_SIZE));
+    }
+    m_running = true;
+
+    // There is no trigger, the buffer is written until the acquisition is stopped
+    ECHECK(rp_AcqStart());
+    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED));
+    m_last_poll = std::chrono::steady_clock::now();
+    auto ret = m_axi ? rp_AcqAxiGetWritePointer(RP_CH_1, &m_origin) : rp_AcqGetWritePointer(&m_origin);
+    if (ret != RP_OK) {
+        return ret;
+    }
+    m_last_wp = m_origin;
+    m_written = 0;
+    m_next = 0;
+    m_valid_from = 0;
+    m_outputs = 0;
+    m_dropped = 0;
+
+    m_applied_tau = -1;
+    m_applied_rate = -1;
+    applySettings();
+    reset();
+    TRACE_SHORT("Lock-in %f Hz decimation %d block %d %s", m_freq, m_decimation, m_block, m_axi ? "AXI" : "ADC buffer");
+    return RP_OK;
+}
+
+auto CLCRLockIn::stop() -> void {
+    if (!m_running)
+        return;
+    rp_AcqStop();
+    if (m_axi) {
+        rp_AcqAxiEnable(RP_CH_1, false);
+        rp_AcqAxiEnable(RP_CH_2, false);
+    }
+    m_running = false;
+}
+
+auto CLCRLockIn::isRunning() -> bool {
+    return m_running;
+}
+
+auto CLCRLockIn::getFreq() -> float {
+    return m_freq;
+}
+
+auto CLCRLockIn::reset() -> void {
+    m_has_value = false;
+    m_u = 0;
+    m_i = 0;
+    m_min = FLT_MAX;
+    m_max = -FLT_MAX;
+    m_p2p = 0;
+    m_next_output = std::chrono::steady_clock::now() + m_output_interval;
+}
+
+auto CLCRLockIn::applySettings() -> void {
+    float tau = m_tau;
+    float rate = m_rate;
+    if (tau == m_applied_tau && rate == m_applied_rate)
+        return;
+    m_applied_tau = tau;
+    m_applied_rate = rate;
+
+    // A whole number of periods cancels the offset and the 2f product of the mixer.
+    // The block is kept below a quarter of the output interval and of the ring.
+    double spp = m_sample_rate / m_freq;
+    double target = std::min({(double)MAX_BLOCK, m_ring_samples / 4.0, m_sample_rate / (4.0 * rate)});
+    uint32_t pmax = std::max(1.0, floor(target / spp));
+    uint32_t periods = pmax;
+    double best = 1;
+    for (uint32_t p = pmax; p >= std::max(1u, pmax / 2); p--) {
+        double len = p * spp;
+        double err = fabs(len - round(len));
+        if (err < best) {
+            best = err;
+            periods = p;
+        }
+    }
+    m_block = std::clamp<uint32_t>(round(periods * spp), 1, MAX_BLOCK);
+
+    m_ch1.resize(m_block);
+    m_ch2.resize(m_block);
+    m_ref_cos.resize(m_block);
+    m_ref_sin.resize(m_block);
+    for (uint32_t n = 0; n < m_block; n++) {
+        double w = 2.0 * M_PI * m_cycles_per_sample * n;
+        m_ref_cos[n] = cos(w);
+        m_ref_sin[n] = sin(w);
+    }
+
+    double block_time = m_block / m_sample_rate;
+    m_alpha = tau > 0 ? 1.0 - exp(-block_time / tau) : 1.0;
+    m_output_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    m_next_output = std::chrono::steady_clock::now() + m_output_interval;
+}
+
+auto CLCRLockIn::currentPosition() -> uint64_t {
+    uint32_t wp = 0;
+    auto before = std::chrono::steady_clock::now();
+    auto ret = m_axi ? rp_AcqAxiGetWritePointer(RP_CH_1, &wp) : rp_AcqGetWritePointer(&wp);
+    if (ret == RP_OK) {
+        // Upper bound of the samples written since the last poll. From a whole ring on, the pointer
+        // difference can hide wraps and everything not yet read is dropped.
+        double gap = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_last_poll).count() * m_sample_rate;
+        m_written += (wp + m_ring_samples - m_last_wp) % m_ring_samples;
+        m_last_wp = wp;
+        m_last_poll = before;
+        if (gap >= m_ring_samples) {
+            m_valid_from = m_written;
+        }
+    }
+    return m_written;
+}
+
+auto CLCRLockIn::readBlock(uint64_t _start) -> bool {
+    uint32_t pos = (m_origin + _start) % m_ring_samples;
+    bool ok = true;
+    for (auto ch : {RP_CH_1, RP_CH_2}) {
+        uint32_t size = m_block;
+        auto buffer = ch == RP_CH_1 ? m_ch1.data() : m_ch2.data();
+        if (m_axi) {
+            ok &= rp_AcqAxiGetDataV(ch, pos, &size, buffer) == RP_OK;
+        } else {
+            ok &= rp_AcqGetDataV(ch, pos, &size, buffer) == RP_OK;
+        }
+        ok &= size == m_block;
+    }
+    // The block may have been overwritten while it was copied
+    return ok && currentPosition() - _start <= m_ring_samples && _start >= m_valid_from;
+}
+
+auto CLCRLockIn::mixBlock() -> void {
+    double ur = 0;
+    double ui = 0;
+    double ir = 0;
+    double ii = 0;
+    float vmin = m_ch2[0];
+    float vmax = m_ch2[0];
+    for (uint32_t n = 0; n < m_block; n++) {
+        float u = m_ch1[n] - m_ch2[n];
+        float i = m_ch2[n];
+        ur += u * m_ref_cos[n];
+        ui -= u * m_ref_sin[n];
+        ir += i * m_ref_cos[n];
+        ii -= i * m_ref_sin[n];
+        vmin = std::min(vmin, i);
+        vmax = std::max(vmax, i);
+    }
+    double scale = 2.0 / m_block;
+    std::complex<double> u(ur * scale, ui * scale);
+    std::complex<double> i(ir * scale, ii * scale);
+
+    // Each block is referred to the phase of IN2, so the filter does not depend on where the block starts
+    auto mag = std::abs(i);
+    if (mag == 0) {
+        m_dropped++;
+        return;
+    }
+    u *= std::conj(i) / mag;
+    i = mag;
+
+    if (!m_has_value) {
+        m_u = u;
+        m_i = i;
+        m_has_value = true;
+    } else {
+        m_u += m_alpha * (u - m_u);
+        m_i += m_alpha * (i - m_i);
+    }
+    m_min = std::min(m_min, vmin);
+    m_max = std::max(m_max, vmax);
+}
+
+auto CLCRLockIn::process() -> bool {
+    if (!m_running)
+        return false;
+    applySettings();
+
+    auto written = currentPosition();
+    if (m_next < m_valid_from) {
+        m_dropped += (m_valid_from - m_next + m_block - 1) / m_block;
+        m_next = m_valid_from;
+    }
+    if (written > m_next + m_ring_samples / 2) {
+        // Behind by half the ring, keep the newest block
+        uint64_t skip = (written - m_next - m_block) / m_block;
+        m_next += skip * m_block;
+        m_dropped += skip;
+    }
+    auto now = std::chrono::steady_clock::now();
+    // Stops at the output time, the remaining blocks are read on the next call
+    while (m_next + m_block <= written && (now < m_next_output || !m_has_value)) {
+        if (readBlock(m_next)) {
+            mixBlock();
+        } else {
+            m_dropped++;
+        }
+        m_next += m_block;
+        now = std::chrono::steady_clock::now();
+    }
+
+    if (!m_has_value || now < m_next_output)
+        return false;
+    m_next_output += m_output_interval;
+    if (m_next_output < now)
+        m_next_output = now + m_output_interval;
+    m_p2p = m_max >= m_min ? m_max - m_min : 0;
+    m_min = FLT_MAX;
+    m_max = -FLT_MAX;
+    m_outputs++;
+    return true;
+}
+
+auto CLCRLockIn::getPhasors(std::complex<double>* _u, std::complex<double>* _i) -> bool {
+    if (!m_has_value)
+        return false;
+    *_u = m_u;
+    *_i = m_i;
+    return true;
+}
+
+auto CLCRLockIn::getPeakToPeak() -> double {
+    return m_p2p;
+}
+
+auto CLCRLockIn::getBlock(const float** _ch1, const float** _ch2, uint32_t* _size) -> void {
+    *_ch1 = m_ch1.data();
+    *_ch2 = m_ch2.data();
+    *_size = m_block;
+}
+
+auto CLCRLockIn::getStat(uint64_t* _outputs, uint64_t* _dropped) -> void {
+    *_outputs = m_outputs;
+    *_dropped = m_dropped;
+}
@@ -0,0 +1,113 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya LCR meter continuous lock-in engine
+*
+* The acquisition runs without a trigger and the engine follows the write pointer of the
+* AXI DDR ring, or of the 16k oscilloscope buffer when the FPGA has no AXI capture. Every block
+* holds a whole number of generator periods and is mixed with a reference at the generator
+* frequency. Both phasors of a block are referred to the phase of IN2 before they are filtered,
+* so blocks that are skipped when the reader falls behind do not disturb the average.
+* When more time than a whole ring passed between two polls of the write pointer, the blocks not
+* read yet are dropped, since the pointer can't show how often the ring wrapped meanwhile.
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*/
+
+#ifndef __LCRLOCKIN_H
+#define __LCRLOCKIN_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <vector>
+
+#include "lcrApp.h"
+#include "rp.h"
+
+class CLCRLockIn {
+
+   public:
+    static constexpr uint32_t SAMPLES_PER_PERIOD = 64;
+    static constexpr uint32_t MAX_BLOCK = 16384;
+
+    CLCRLockIn();
+    ~CLCRLockIn();
+
+    CLCRLockIn(CLCRLockIn&) = delete;
+    CLCRLockIn(CLCRLockIn&&) = delete;
+
+    // Time constant of the output filter in seconds. 0 publishes the last block.
+    auto setTimeConstant(float _tau) -> int;
+    auto getTimeConstant() -> float;
+    // Outputs per second, counted in acquired samples
+    auto setOutputRate(float _rate) -> int;
+    auto getOutputRate() -> float;
+
+    // Arms the continuous acquisition for the generator frequency
+    auto start(float _freq, uint32_t _adc_rate) -> int;
+    auto stop() -> void;
+    auto isRunning() -> bool;
+    auto getFreq() -> float;
+    // Forgets the filtered values, after a shunt change
+    auto reset() -> void;
+
+    // Demodulates the blocks written since the last call. Returns true when an output is due.
+    auto process() -> bool;
+    // Filtered phasors of the DUT voltage (IN1 - IN2) and of the shunt voltage (IN2) in volts
+    auto getPhasors(std::complex<double>* _u, std::complex<double>* _i) -> bool;
+    // Peak to peak of IN2 over the last output interval
+    auto getPeakToPeak() -> double;
+    // Last block read, for the shunt range check
+    auto getBlock(const float** _ch1, const float** _ch2, uint32_t* _size) -> void;
+    auto getStat(uint64_t* _outputs, uint64_t* _dropped) -> void;
+
+   private:
+    auto currentPosition() -> uint64_t;
+    auto readBlock(uint64_t _start) -> bool;
+    auto mixBlock() -> void;
+    auto applySettings() -> void;
+
+    bool m_running = false;
+    bool m_axi = false;
+    std::atomic<float> m_tau = 0.1;
+    std::atomic<float> m_rate = 10;
+    float m_applied_tau = -1;
+    float m_applied_rate = -1;
+
+    float m_freq = 0;
+    uint32_t m_decimation = 1;
+    double m_sample_rate = 0;
+    double m_cycles_per_sample = 0;
+
+    uint32_t m_ring_samples = 0;
+    uint32_t m_origin = 0;
+    uint32_t m_last_wp = 0;
+    uint64_t m_written = 0;
+    uint64_t m_next = 0;
+    // Blocks starting before this position may have been overwritten by a wrap the write pointer can't show
+    uint64_t m_valid_from = 0;
+    std::chrono::steady_clock::time_point m_last_poll;
+    std::chrono::steady_clock::time_point m_next_output;
+    std::chrono::steady_clock::duration m_output_interval;
+
+    uint32_t m_block = 0;
+    double m_alpha = 1;
+    std::vector<float> m_ch1;
+    std::vector<float> m_ch2;
+    std::vector<float> m_ref_cos;
+    std::vector<float> m_ref_sin;
+
+    bool m_has_value = false;
+    std::complex<double> m_u = 0;
+    std::complex<double> m_i = 0;
+    float m_min = 0;
+    float m_max = 0;
+    double m_p2p = 0;
+
+    std::atomic<uint64_t> m_outputs = 0;
+    std::atomic<uint64_t> m_dropped = 0;
+};
+
+#endif  //__LCRLOCKIN_H
@@ -23,6 +23,7 @@
 #include <thread>
 #include <vector>
 
+#include "lcr_lockin.h"
 #include "lcr_meter.h"
 
 #include "calib.h"
@@ -33,6 +34,7 @@
 
 CLCRHardware g_lcr_hw;
 CLCRGenerator g_generator;
+CLCRLockIn g_lockin;
 
 typedef double data_t;
 
@@ -51,6 +53,7 @@ std::mutex g_lcr_mutex_data;
 std::atomic_bool g_lcr_threadRun = false;
 std::atomic_bool g_lcr_threadPause = false;
 std::atomic_bool g_lcr_GenRun = false;
+std::atomic_bool g_lcr_lockIn = false;
 
 static auto g_adc_rate = rp_HPGetBaseFastADCSpeedHzOrDefault();
 
@@ -201,7 +204,10 @@ void lcr_MainThread() {
         /* Main lcr meter algorithm */
         if (!g_lcr_threadPause) {
             std::lock_guard lock(g_lcr_mutex);
-            if (g_lcr_GenRun) {
+            if (g_lcr_GenRun && g_lcr_lockIn) {
+                lcr_LockInStep();
+            } else if (g_lcr_GenRun) {
+                g_lockin.stop();
                 int decimation;
                 float freq;
                 int ret_val = lcr_ThreadAcqData(buffer, &decimation, &freq);
@@ -217,6 +223,7 @@ void lcr_MainThread() {
         }
         usleep(50);
     }
+    g_lockin.stop();
     rp_deleteBuffer(buffer);
     releaseFFT();
 }
@@ -253,6 +260,56 @@ int lcr_ThreadAcqData(buffers_t* data, int* dec, float* freq) {
     return RP_OK;
 }
 
+/* Continuous lock-in. Publishes a reading at the output rate without re-arming the acquisition. */
+int lcr_LockInStep() {
+    float freq = g_generator.getFreq();
+    if (!g_lockin.isRunning() || g_lockin.getFreq() != freq) {
+        if (g_lockin.start(freq, g_adc_rate) != RP_OK) {
+            ERROR_LOG("Can't start the lock-in, back to single captures")
+            g_lockin.stop();
+            g_lcr_lockIn = false;
+            return RP_LCR_UERROR;
+        }
+    }
+    if (!g_lockin.process() || main_params.calibration) {
+        return RP_LCR_OK;
+    }
+
+    auto r_shunt = g_lcr_hw.getShunt();
+    if (main_params.shunt_mode == RP_LCR_S_EXTENSION) {
+        const float* ch1 = NULL;
+        const float* ch2 = NULL;
+        uint32_t size = 0;
+        g_lockin.getBlock(&ch1, &ch2, &size);
+        lcr_CheckShunt(ch1, ch2, size);
+        // The filtered current belongs to the old range
+        if (g_lcr_hw.getShunt() != r_shunt) {
+            g_lockin.reset();
+            return RP_LCR_OK;
+        }
+    }
+
+    std::complex<double> u;
+    std::complex<double> i;
+    if (!g_lockin.getPhasors(&u, &i)) {
+        return RP_LCR_OK;
+    }
+    double r_RC = 1;
+    if (main_params.shunt_mode == RP_LCR_S_EXTENSION)
+        r_RC = g_lcr_hw.calibShunt(r_shunt, freq);
+
+    if (main_params.shunt_mode == RP_LCR_S_CUSTOM)
+        r_RC = main_params.shunt;
+
+    auto z = u / i * r_RC;
+    std::lock_guard lockData(g_lcr_mutex_data);
+    g_th_params.phase_out = std::arg(z) * 180.0 / M_PI;
+    g_th_params.z_out = z.real() + z.imag() * I;
+    g_th_params.frequency = freq;
+    g_th_params.p_p_amp = g_lockin.getPeakToPeak();
+    return RP_LCR_OK;
+}
+
 int lcr_getImpedance(buffers_t* data, int api_decimation, float freq) {
     auto r_shunt = g_lcr_hw.getShunt();
     return lcr_data_analysis(data, r_shunt, freq, api_decimation);
@@ -612,4 +669,36 @@ int lcr_SetShuntMode(lcr_shunt_mode_t shunt_mode) {
 int lcr_GetShuntMode(lcr_shunt_mode_t* shunt_mode) {
     *shunt_mode = main_params.shunt_mode;
     return RP_LCR_OK;
-}
\ No newline at end of file
+}
+int lcr_SetLockIn(bool enable) {
+    g_lcr_lockIn = enable;
+    return RP_LCR_OK;
+}
+
+int lcr_GetLockIn(bool* enable) {
+    *enable = g_lcr_lockIn;
+    return RP_LCR_OK;
+}
+
+int lcr_SetLockInTimeConstant(float tau) {
+    return g_lockin.setTimeConstant(tau);
+}
+
+int lcr_GetLockInTimeConstant(float* tau) {
+    *tau = g_lockin.getTimeConstant();
+    return RP_LCR_OK;
+}
+
+int lcr_SetLockInRate(float rate) {
+    return g_lockin.setOutputRate(rate);
+}
+
+int lcr_GetLockInRate(float* rate) {
+    *rate = g_lockin.getOutputRate();
+    return RP_LCR_OK;
+}
+
+int lcr_GetLockInStat(uint64_t* outputs, uint64_t* dropped) {
+    g_lockin.getStat(outputs, dropped);
+    return RP_LCR_OK;
+}
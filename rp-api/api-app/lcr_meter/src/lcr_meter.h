@@ -63,6 +63,7 @@ int lcr_SafeThreadGen(rp_channel_t channel, float frequency);
 int lcr_ThreadAcqData(buffers_t* data, int* dec, float* freq);
 int lcr_getImpedance(buffers_t* data, int api_decimation, float freq);
 void lcr_CheckShunt(const float* ch1, const float* ch2, const uint32_t _size);
+int lcr_LockInStep();
 
 // int lcr_Correction();
 int lcr_CalculateData(float _Complex Z_measured, float phase_measured, float freq);
@@ -88,6 +89,13 @@ int lcr_SetCustomShunt(int shunt);
 int lcr_GetCustomShunt(int* shunt);
 int lcr_SetShuntMode(lcr_shunt_mode_t shunt_mode);
 int lcr_GetShuntMode(lcr_shunt_mode_t* shunt_mode);
+int lcr_SetLockIn(bool enable);
+int lcr_GetLockIn(bool* enable);
+int lcr_SetLockInTimeConstant(float tau);
+int lcr_GetLockInTimeConstant(float* tau);
+int lcr_SetLockInRate(float rate);
+int lcr_GetLockInRate(float* rate);
+int lcr_GetLockInStat(uint64_t* outputs, uint64_t* dropped);
 
 int lcr_CheckModuleConnection(bool _muteWarnings);
 int lcr_IsModuleConnected(bool* state);
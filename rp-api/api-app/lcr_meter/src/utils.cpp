@@ -27,9 +27,10 @@
 
 void lcr_getDecimationValue(float frequency,
                             int *dec_val,
-                            uint32_t adc_rate){
+                            uint32_t adc_rate,
+                            uint32_t samples_per_period){
 
-    auto decimation = adc_rate / (frequency * 2048);
+    auto decimation = adc_rate / (frequency * samples_per_period);
 
      if (decimation < 16){
         if (decimation >= 8)
@@ -33,6 +33,6 @@
 }
 
 
-void lcr_getDecimationValue(float frequency,int *dec_val,uint32_t adc_rate);
+void lcr_getDecimationValue(float frequency,int *dec_val,uint32_t adc_rate,uint32_t samples_per_period = 2048);
 
 #endif //UTILS_H_
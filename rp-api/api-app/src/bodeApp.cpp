@@ -18,12 +18,16 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #include "common.h"
 #include "math/rp_algorithms.h"
 #include "math/rp_dsp.h"
+#include "math/rp_multitone.h"
 #include "rp_hw-profiles.h"
 #include "rp_hw_calib.h"
 
@@ -574,12 +578,13 @@ int rpApp_BaSafeThreadGen(rp_channel_t _channel, float _frequency, float _ampl,
     return RP_OK;
 }
 
-int rpApp_BaSafeThreadAcqData(rp_ba_buffer_t& _buffer, int _decimation, int _acq_size, float _trigger) {
-    (void)(_trigger);
+// The captured samples are the last _acq_size before the trigger, so waiting _settle_us more
+// before triggering keeps the first settle time after a retune out of the buffer.
+static int acqData(rp_ba_buffer_t& _buffer, int _decimation, int _acq_size, uint32_t _settle_us) {
     uint32_t pos = 0;
     uint32_t acq_u_size = _acq_size;
     //uint32_t acq_delay = acq_u_size > ADC_BUFFER_SIZE / 2.0 ? acq_u_size - ADC_BUFFER_SIZE / 2.0 : 0;
-    uint64_t sleep_time = static_cast<uint64_t>(_acq_size) * _decimation / (rpApp_BaGetADCSpeed() / 1e6);
+    uint64_t sleep_time = static_cast<uint64_t>(_acq_size) * _decimation / (adc_rate / 1e6) + _settle_us;
     sleep_time = sleep_time < 1 ? 1 : sleep_time;
     bool fillState = false;
 
@@ -630,6 +635,11 @@ int rpApp_BaSafeThreadAcqData(rp_ba_buffer_t& _buffer, int _decimation, int _acq
     return RP_OK;
 }
 
+int rpApp_BaSafeThreadAcqData(rp_ba_buffer_t& _buffer, int _decimation, int _acq_size, float _trigger) {
+    (void)(_trigger);
+    return acqData(_buffer, _decimation, _acq_size, 0);
+}
+
 uint32_t increaseSmallBuffer(uint32_t _decimation, uint32_t _currentSize) {
     int half_size = ADC_BUFFER_SIZE / 2;
     int rate = half_size / _currentSize;
@@ -644,14 +654,9 @@ uint32_t increaseSmallBuffer(uint32_t _decimation, uint32_t _currentSize) {
     return _currentSize;
 }
 
-int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t& _buffer, float* _amplitude,
-                         float* _phase, float _freq, float _probe, float _input_threshold) {
-    float gain = 0;
-    float phase_out = 0;
-    int ret = 0;
+// Decimation and capture length for _periods_number periods of _freq
+static void getAcqParams(float _freq, int _periods_number, int* _decimation, uint32_t* _acq_size) {
     int acq_size;
-    //Generate a sinusoidal wave form
-    rpApp_BaSafeThreadGen(RP_CH_1, _freq, _amplitude_in, _dc_bias);
     int size_buff_limit = ADC_BUFFER_SIZE / 4;
     int sampls = size_buff_limit / _periods_number;
     int decimation = adc_rate / (sampls * _freq);
@@ -673,8 +678,16 @@ int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias
     acq_size = round((static_cast<float>(_periods_number) * adc_rate) / (_freq * decimation));
     auto new_acq_size = increaseSmallBuffer(decimation, acq_size);
     TRACE_SHORT("Decimation: %d Gen freq: %f Buffer size %d Increase size %d", decimation, _freq, acq_size, new_acq_size);
-    rpApp_BaSafeThreadAcqData(_buffer, decimation, new_acq_size, _amplitude_in);
-    rp_GenOutDisable(RP_CH_1);
+    *_decimation = decimation;
+    *_acq_size = new_acq_size;
+}
+
+// Gain in dB and phase difference in degrees of a captured buffer. The probe factor is applied in place.
+static int analyseBuffer(rp_ba_logic_t mode, rp_ba_buffer_t& _buffer, int decimation, float _freq, float _probe, float _input_threshold, float* _amplitude,
+                         float* _phase) {
+    float gain = 0;
+    float phase_out = 0;
+    int ret = 0;
 
     // int ret = rp_BaDataAnalysis(_buffer, acq_size, ADC_SAMPLE_RATE / decimation,_freq, samples_period,  &gain, &phase_out,_input_threshold);
     //int ret = dataAnalysisTrap(_buffer.ch1,_buffer.ch2, new_acq_size, _freq, decimation,rpApp_BaGetADCSpeed(),  &gain, &phase_out,_input_threshold);
@@ -690,7 +703,8 @@ int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias
         ret = analysisTrap(_buffer.ch1, _buffer.ch2, _freq, decimation, adc_rate, _input_threshold, &phase[0], &phase[1], &gain, &phase_out);
     }
 
-    if (mode == RP_BA_LOGIC_FFT) {
+    // Single tone points of a multi-tone sweep use the FFT
+    if (mode == RP_BA_LOGIC_FFT || mode == RP_BA_LOGIC_MULTITONE) {
         ret = analysisFFT(_buffer.ch1, _buffer.ch2, _freq, decimation, &gain, &phase_out, _input_threshold);
     }
 
@@ -703,6 +717,322 @@ int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias
     return ret;
 }
 
+int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t& _buffer, float* _amplitude,
+                         float* _phase, float _freq, float _probe, float _input_threshold) {
+    int decimation = 1;
+    uint32_t acq_size = 0;
+    //Generate a sinusoidal wave form
+    rpApp_BaSafeThreadGen(RP_CH_1, _freq, _amplitude_in, _dc_bias);
+    getAcqParams(_freq, _periods_number, &decimation, &acq_size);
+    rpApp_BaSafeThreadAcqData(_buffer, decimation, acq_size, _amplitude_in);
+    rp_GenOutDisable(RP_CH_1);
+    return analyseBuffer(mode, _buffer, decimation, _freq, _probe, _input_threshold, _amplitude, _phase);
+}
+
+std::vector<float> rpApp_BaSweepFrequencies(float _start_freq, float _end_freq, uint32_t _steps, bool _log_scale) {
+    std::vector<float> freqs;
+    if (_steps == 0)
+        return freqs;
+    freqs.reserve(_steps);
+    float div = _steps > 1 ? _steps - 1 : 1;
+    if (_log_scale) {
+        auto a = log10f(_start_freq);
+        auto b = log10f(_end_freq);
+        auto c = (b - a) / div;
+        for (uint32_t i = 0; i < _steps; i++)
+            freqs.push_back(pow(10.f, c * i + a));
+    } else {
+        auto freq_step = (_end_freq - _start_freq) / div;
+        for (uint32_t i = 0; i < _steps; i++)
+            freqs.push_back(_start_freq + freq_step * i);
+    }
+    return freqs;
+}
+
+uint32_t rpApp_BaSettleTime(float _freq, float _settle_periods, uint32_t _settle_min_us) {
+    double settle = _freq > 0 ? _settle_periods * 1e6 / _freq : 0;
+    return MAX(static_cast<uint32_t>(settle), _settle_min_us);
+}
+
+/* Pipelined sweep. The calling thread retunes the generator and captures while
+   a second thread analyses the previous capture. Two capture slots are used in turn. */
+namespace {
+
+struct ba_capture_t {
+    rp_ba_buffer_t buffer{ADC_BUFFER_SIZE};
+    uint32_t point = 0;
+    int repeat = 0;
+    int decimation = 1;
+};
+
+struct ba_pipe_t {
+    ba_capture_t slots[2];
+    std::mutex mtx;
+    std::condition_variable cond;
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    bool done = false;
+    bool stop = false;
+};
+
+void analysisLoop(ba_pipe_t* pipe, const rp_ba_sweep_settings_t* settings, const std::vector<float>* freqs, rp_ba_sweep_callback_t* callback, uint32_t* points) {
+    rp_ba_sweep_point_t point;
+    for (;;) {
+        std::unique_lock lock(pipe->mtx);
+        pipe->cond.wait(lock, [pipe] { return pipe->consumed < pipe->produced || pipe->done; });
+        if (pipe->consumed == pipe->produced)
+            return;
+        auto& slot = pipe->slots[pipe->consumed % 2];
+        if (pipe->stop) {
+            // Captures made before the acquisition side saw the stop request are dropped
+            pipe->consumed++;
+            pipe->cond.notify_all();
+            continue;
+        }
+        lock.unlock();
+
+        if (slot.repeat == 0) {
+            point = rp_ba_sweep_point_t();
+            point.index = slot.point;
+            point.freq = (*freqs)[slot.point];
+        }
+        float ampl = 0;
+        float phase = 0;
+        auto ret = analyseBuffer(settings->mode, slot.buffer, slot.decimation, point.freq, settings->probe, settings->input_threshold, &ampl, &phase);
+        if (ret == RP_EOOR) {  // isnan && isinf
+            ampl = 0;
+            phase = 0;
+            point.status = RP_EOOR;
+        } else if (ret != RP_OK && point.status == RP_OK) {
+            point.status = RP_EIPV;
+        }
+        point.amplitude += ampl;
+        point.phase += phase;
+        bool last = slot.repeat == settings->averaging - 1;
+
+        lock.lock();
+        pipe->consumed++;
+        pipe->cond.notify_all();
+        lock.unlock();
+
+        if (last) {
+            point.amplitude /= settings->averaging;
+            point.phase /= settings->averaging;
+            (*points)++;
+            if (*callback && !(*callback)(point)) {
+                lock.lock();
+                pipe->stop = true;
+                pipe->cond.notify_all();
+            }
+        }
+    }
+}
+
+}  // namespace
+
+static int pipelinedSweep(const rp_ba_sweep_settings_t& _settings, const std::vector<float>& _freqs, rp_ba_sweep_callback_t& _callback, uint32_t* _points) {
+    int ret = RP_OK;
+    ba_pipe_t pipe;
+    std::thread analysis(analysisLoop, &pipe, &_settings, &_freqs, &_callback, _points);
+
+    for (uint32_t i = 0; i < _freqs.size() && ret == RP_OK; i++) {
+        int decimation = 1;
+        uint32_t acq_size = 0;
+        auto freq = _freqs[i];
+        // The generator stays on between points, only the frequency changes
+        ret = rpApp_BaSafeThreadGen(RP_CH_1, freq, _settings.amplitude, _settings.dc_bias);
+        if (ret != RP_OK)
+            break;
+        getAcqParams(freq, _settings.periods, &decimation, &acq_size);
+        auto settle = rpApp_BaSettleTime(freq, _settings.settle_periods, _settings.settle_min_us);
+
+        for (int r = 0; r < _settings.averaging; r++) {
+            std::unique_lock lock(pipe.mtx);
+            pipe.cond.wait(lock, [&pipe] { return pipe.produced - pipe.consumed < 2 || pipe.stop; });
+            if (pipe.stop)
+                break;
+            auto& slot = pipe.slots[pipe.produced % 2];
+            lock.unlock();
+
+            slot.point = i;
+            slot.repeat = r;
+            slot.decimation = decimation;
+            ret = acqData(slot.buffer, decimation, acq_size, r == 0 ? settle : 0);
+            if (ret != RP_OK)
+                break;
+
+            lock.lock();
+            pipe.produced++;
+            pipe.cond.notify_all();
+        }
+
+        std::lock_guard lock(pipe.mtx);
+        if (pipe.stop)
+            break;
+    }
+
+    {
+        std::lock_guard lock(pipe.mtx);
+        pipe.done = true;
+        pipe.cond.notify_all();
+    }
+    analysis.join();
+    return ret;
+}
+
+/* Multi-tone sweep. Consecutive frequencies within a decade are grouped, up to settings.tones per group.
+   Each group is one arbitrary waveform and one capture. */
+static int genMultiTone(rp_ba_sweep_settings_t const& _settings, rp_dsp_api::CMultiTone& _mt, std::vector<float>& _wave) {
+    if (_mt.getWaveform(_wave.data(), _wave.size()) != 0)
+        return RP_EOOR;
+    pthread_mutex_lock(&mutex);
+    EXEC_CHECK_MUTEX(rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY), mutex);
+    EXEC_CHECK_MUTEX(rp_GenArbWaveform(RP_CH_1, _wave.data(), _wave.size()), mutex);
+    EXEC_CHECK_MUTEX(rp_GenAmp(RP_CH_1, _settings.amplitude), mutex);
+    EXEC_CHECK_MUTEX(rp_GenOffset(RP_CH_1, _settings.dc_bias), mutex);
+    EXEC_CHECK_MUTEX(rp_GenFreq(RP_CH_1, _mt.getFundamental()), mutex);
+    EXEC_CHECK_MUTEX(rp_GenOutEnable(RP_CH_1), mutex);
+    EXEC_CHECK_MUTEX(rp_GenResetTrigger(RP_CH_1), mutex);
+    TRACE_SHORT("Start multi-tone A: %f Off: %f F0: %f Tones: %d CF: %f", _settings.amplitude, _settings.dc_bias, _mt.getFundamental(), _mt.getToneCount(),
+                _mt.getCrestFactor())
+    pthread_mutex_unlock(&mutex);
+    return RP_OK;
+}
+
+// Single tone measurement of one point, used for the points a group could not resolve
+static int measureTone(rp_ba_sweep_settings_t const& _settings, rp_ba_buffer_t& _buffer, rp_ba_sweep_point_t* _point) {
+    int decimation = 1;
+    uint32_t acq_size = 0;
+    int ret = rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+    if (ret == RP_OK)
+        ret = rpApp_BaSafeThreadGen(RP_CH_1, _point->freq, _settings.amplitude, _settings.dc_bias);
+    if (ret != RP_OK)
+        return ret;
+    getAcqParams(_point->freq, _settings.periods, &decimation, &acq_size);
+    auto settle = rpApp_BaSettleTime(_point->freq, _settings.settle_periods, _settings.settle_min_us);
+    _point->amplitude = 0;
+    _point->phase = 0;
+    _point->status = RP_OK;
+    for (int r = 0; r < _settings.averaging; r++) {
+        float ampl = 0;
+        float phase = 0;
+        ret = acqData(_buffer, decimation, acq_size, r == 0 ? settle : 0);
+        if (ret != RP_OK)
+            return ret;
+        ret = analyseBuffer(_settings.mode, _buffer, decimation, _point->freq, _settings.probe, _settings.input_threshold, &ampl, &phase);
+        if (ret == RP_EOOR) {  // isnan && isinf
+            ampl = 0;
+            phase = 0;
+            _point->status = RP_EOOR;
+        } else if (ret != RP_OK && _point->status == RP_OK) {
+            _point->status = RP_EIPV;
+        }
+        _point->amplitude += ampl;
+        _point->phase += phase;
+    }
+    _point->amplitude /= _settings.averaging;
+    _point->phase /= _settings.averaging;
+    return RP_OK;
+}
+
+static int multiToneSweep(const rp_ba_sweep_settings_t& _settings, const std::vector<float>& _freqs, rp_ba_sweep_callback_t& _callback, uint32_t* _points) {
+    rp_dsp_api::CMultiTone mt(adc_rate, ADC_BUFFER_SIZE);
+    rp_ba_buffer_t buffer(ADC_BUFFER_SIZE);
+    std::vector<float> wave(DAC_BUFFER_SIZE);
+    std::vector<double> group_freqs;
+    std::vector<rp_dsp_api::multitone_result_t> results;
+    std::vector<rp_ba_sweep_point_t> points;
+    auto max_tones = std::clamp<uint32_t>(_settings.tones, 1, rp_dsp_api::CMultiTone::MAX_TONES);
+    int ret = RP_OK;
+
+    for (uint32_t first = 0; first < _freqs.size() && ret == RP_OK;) {
+        uint32_t end = first + 1;
+        while (end < _freqs.size() && end - first < max_tones && _freqs[end] > _freqs[end - 1] && _freqs[end] <= _freqs[first] * 10) {
+            end++;
+        }
+        uint32_t count = end - first;
+        group_freqs.assign(_freqs.begin() + first, _freqs.begin() + end);
+        points.assign(count, rp_ba_sweep_point_t());
+        for (uint32_t i = 0; i < count; i++) {
+            points[i].index = first + i;
+            points[i].freq = _freqs[first + i];
+        }
+
+        bool planned = count > 1 && mt.setTones(group_freqs.data(), count, _settings.tone_periods) == 0;
+        if (planned) {
+            mt.getFreqVector(group_freqs.data());
+            results.assign(count, rp_dsp_api::multitone_result_t());
+            ret = genMultiTone(_settings, mt, wave);
+            auto settle = rpApp_BaSettleTime(group_freqs[0], _settings.settle_periods, _settings.settle_min_us);
+            for (int r = 0; r < _settings.averaging && ret == RP_OK; r++) {
+                ret = acqData(buffer, mt.getDecimation(), mt.getCaptureLength(), r == 0 ? settle : 0);
+                if (ret == RP_OK && mt.analyze(buffer.ch1.data(), buffer.ch2.data(), buffer.ch1.size(), results.data()) != 0)
+                    ret = RP_EOOR;
+                for (uint32_t i = 0; i < count && ret == RP_OK; i++) {
+                    float ampl = 20. * log10(results[i].gain);
+                    float phase = results[i].phase;
+                    if (std::isnan(ampl) || std::isinf(ampl)) {
+                        ampl = 0;
+                        phase = 0;
+                        points[i].status = RP_EOOR;
+                    }
+                    points[i].freq = group_freqs[i];
+                    points[i].amplitude += ampl / _settings.averaging;
+                    points[i].phase += phase / _settings.averaging;
+                    points[i].snr = r == 0 ? results[i].snr : std::min<float>(points[i].snr, results[i].snr);
+                }
+            }
+            if (ret != RP_OK)
+                break;
+        }
+
+        // Points the group missed or measured with too much noise get a capture of their own
+        for (uint32_t i = 0; i < count && ret == RP_OK; i++) {
+            if (!planned || points[i].status != RP_OK || points[i].snr < _settings.snr_min) {
+                ret = measureTone(_settings, buffer, &points[i]);
+            }
+        }
+
+        for (uint32_t i = 0; i < count && ret == RP_OK; i++) {
+            (*_points)++;
+            if (_callback && !_callback(points[i]))
+                return rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+        }
+        first = end;
+    }
+    auto restore = rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+    return ret != RP_OK ? ret : restore;
+}
+
+int rpApp_BaSweep(const rp_ba_sweep_settings_t& _settings, const std::vector<float>& _freqs, rp_ba_sweep_callback_t _callback, float* _points_per_sec) {
+    if (_settings.averaging < 1 || _settings.periods < 1)
+        return RP_EOOR;
+    for (auto f : _freqs) {
+        if (!(f > 0))
+            return RP_EOOR;
+    }
+
+    auto start = steady_clock::now();
+    int ret = rpApp_BaSafeThreadAcqPrepare();
+    if (ret != RP_OK)
+        return ret;
+
+    uint32_t points = 0;
+    if (_settings.mode == RP_BA_LOGIC_MULTITONE) {
+        ret = multiToneSweep(_settings, _freqs, _callback, &points);
+    } else {
+        ret = pipelinedSweep(_settings, _freqs, _callback, &points);
+    }
+    rp_GenOutDisable(RP_CH_1);
+
+    double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+    float points_per_sec = elapsed > 0 ? points / elapsed : 0;
+    TRACE_SHORT("Sweep %u points in %f s, %f points/s", points, elapsed, points_per_sec);
+    if (_points_per_sec)
+        *_points_per_sec = points_per_sec;
+    return ret;
+}
+
 int rpApp_BaInit() {
     int ret = rp_GenReset();
     if (ret != RP_OK) {
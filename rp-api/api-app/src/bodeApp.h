@@ -14,12 +14,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <cstddef>
+#include <functional>
 #include <vector>
 #include "rp.h"
 
 #define BA_CALIB_FILENAME "/tmp/ba_calib.data"
 
-enum rp_ba_logic_t { RP_BA_LOGIC_TRAP = 0, RP_BA_LOGIC_FFT = 1 };
+enum rp_ba_logic_t { RP_BA_LOGIC_TRAP = 0, RP_BA_LOGIC_FFT = 1, RP_BA_LOGIC_MULTITONE = 2 };
 
 struct rp_ba_buffer_t {
     std::vector<float> ch1;
@@ -30,6 +31,36 @@ struct rp_ba_buffer_t {
     }
 };
 
+struct rp_ba_sweep_settings_t {
+    rp_ba_logic_t mode = RP_BA_LOGIC_TRAP;
+    float amplitude = 0;
+    float dc_bias = 0;
+    int periods = 8;
+    int averaging = 1;
+    float probe = 1;
+    float input_threshold = 0;
+    // After each retune the capture starts once settle_periods of the new frequency have passed, but not before settle_min_us
+    float settle_periods = 1;
+    uint32_t settle_min_us = 10;
+    // RP_BA_LOGIC_MULTITONE: up to tones frequencies within a decade share one capture of tone_periods periods
+    // of the fundamental. Points with a lower SNR than snr_min dB are measured again with a single tone.
+    uint32_t tones = 16;
+    uint32_t tone_periods = 2;
+    float snr_min = 30;
+};
+
+struct rp_ba_sweep_point_t {
+    uint32_t index = 0;
+    float freq = 0;
+    float amplitude = 0;  // dB
+    float phase = 0;      // deg
+    float snr = 0;        // dB, multi-tone only
+    int status = RP_OK;   // RP_EIPV for a small signal, RP_EOOR if the gain is not finite
+};
+
+// Called for each point in order, from the analysis thread unless the mode is RP_BA_LOGIC_MULTITONE. Returns false to stop the sweep.
+typedef std::function<bool(const rp_ba_sweep_point_t& point)> rp_ba_sweep_callback_t;
+
 int rpApp_BaInit();
 int rpApp_BaRelease();
 int rpApp_BaDataAnalysis(const rp_ba_buffer_t& buffer, uint32_t size, float samplesPerSecond, float _freq, float samples_period, float* gain, float* phase_out,
@@ -39,6 +70,9 @@ int rpApp_BaSafeThreadGen(rp_channel_t _channel, float _frequency, float _ampl,
 int rpApp_BaSafeThreadAcqData(rp_ba_buffer_t& _buffer, int _decimation, int _acq_size, int _dec, float _trigger);
 int rpApp_BaGetAmplPhase(rp_ba_logic_t mode, float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t& _buffer, float* _amplitude, float* _phase, float _freq,
                          float _probe, float _input_threshold);
+std::vector<float> rpApp_BaSweepFrequencies(float _start_freq, float _end_freq, uint32_t _steps, bool _log_scale);
+uint32_t rpApp_BaSettleTime(float _freq, float _settle_periods, uint32_t _settle_min_us);
+int rpApp_BaSweep(const rp_ba_sweep_settings_t& _settings, const std::vector<float>& _freqs, rp_ba_sweep_callback_t _callback, float* _points_per_sec);
 float rpApp_BaCalibGain(float _freq, float _ampl);
 float rpApp_BaCalibPhase(float _freq, float _phase);
 int rpApp_BaResetCalibration();
@@ -565,6 +565,17 @@ int osc_GetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode* _mode)
     return RP_OK;
 }
 
+int osc_SetPeakDetect(rp_channel_t _channel, bool _enable) {
+    std::lock_guard lock(g_mutex);
+    g_decimator.setPeakDetect(_channel, _enable);
+    return RP_OK;
+}
+
+int osc_GetPeakDetect(rp_channel_t _channel, bool* _enable) {
+    *_enable = g_decimator.getPeakDetect(_channel);
+    return RP_OK;
+}
+
 int osc_SetUpdateViewCallback(rpApp_osc_updateViewCallback_t callback) {
     std::lock_guard lock(g_mutex);
     g_updateViewCallback = callback;
@@ -111,6 +111,8 @@ int osc_getShowInvalid(rp_channel_t _channel, bool* _state);
 
 int osc_SetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode _mode);
 int osc_GetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode* _mode);
+int osc_SetPeakDetect(rp_channel_t _channel, bool _enable);
+int osc_GetPeakDetect(rp_channel_t _channel, bool* _enable);
 
 int osc_SetForceUpdateView(bool enable);
 int osc_GetForceUpdateView(bool* enable);
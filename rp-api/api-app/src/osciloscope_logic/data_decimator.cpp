@@ -1,12 +1,60 @@
 #include "data_decimator.h"
 #include <limits.h>
 #include <math.h>
+#include <algorithm>
+#include <cmath>
 #include "common.h"
 #include "math/rp_interpolation.h"
+#include "math/rp_math.h"
+
+namespace {
+
+struct ColumnStat {
+    float m_min;
+    float m_max;
+    double m_sum;
+    uint32_t m_count;
+};
+
+// Adds one contiguous run of the buffer to _stat
+auto reduceRun(const float* _data, uint32_t _start, uint32_t _len, ColumnStat* _stat) -> void {
+    if (_len == 0)
+        return;
+    float vmin, vmax;
+    double sum;
+    minmax_sum_float_neon(_data + _start, _len, &vmin, &vmax, &sum);
+    if (_stat->m_count == 0) {
+        _stat->m_min = vmin;
+        _stat->m_max = vmax;
+    } else {
+        _stat->m_min = std::min(_stat->m_min, vmin);
+        _stat->m_max = std::max(_stat->m_max, vmax);
+    }
+    _stat->m_sum += sum;
+    _stat->m_count += _len;
+}
+
+// Reduces the samples of one screen column. [_x0, _x1) is relative to the trigger, which sits at buffer index 0,
+// so a column that crosses the trigger is split into two contiguous runs of the circular buffer.
+auto reduceColumn(const float* _data, vsize_t _dataSize, int32_t _x0, int32_t _x1, ColumnStat* _stat) -> void {
+    _stat->m_count = 0;
+    _stat->m_sum = 0;
+    if (_x0 < 0 && _x1 > 0) {
+        reduceRun(_data, _x0 + _dataSize, -_x0, _stat);
+        reduceRun(_data, 0, _x1, _stat);
+    } else if (_x1 <= 0) {
+        reduceRun(_data, _x0 + _dataSize, _x1 - _x0, _stat);
+    } else {
+        reduceRun(_data, _x0, _x1 - _x0, _stat);
+    }
+}
+
+}  // namespace
 
 CDataDecimator::CDataDecimator() : m_decimationFactor(1), m_viewSize(0), m_scaleFunc(NULL), m_settingsMutex(), m_decimatedData(), m_triggerLevel(0), m_dataOffset(0) {
     for (auto i = 0u; i < MAX_ADC_CHANNELS; ++i) {
         m_mode[i] = DISABLED;
+        m_peakDetect[i] = false;
     }
     m_originalData.resize(ADC_BUFFER_SIZE);
 }
@@ -51,6 +99,15 @@ auto CDataDecimator::getInterpolationMode(rp_channel_t _channel) const -> rpApp_
     return m_mode[_channel];
 }
 
+auto CDataDecimator::setPeakDetect(rp_channel_t _channel, bool _enable) -> void {
+    std::lock_guard lock(m_settingsMutex);
+    m_peakDetect[_channel] = _enable;
+}
+
+auto CDataDecimator::getPeakDetect(rp_channel_t _channel) const -> bool {
+    return m_peakDetect[_channel];
+}
+
 auto CDataDecimator::setScaleFunction(func_t _func) -> void {
     std::lock_guard lock(m_settingsMutex);
     m_scaleFunc = _func;
@@ -264,6 +321,11 @@ auto CDataDecimator::decimate(rp_channel_t _channel, const float* _data, vsize_t
         _viewInfo->m_mean /= count ? count : 1;
         _viewInfo->m_meanUnscale /= count ? count : 1;
         _viewInfo->m_trigPosition = trigPosInViewOrigin;
+    } else if (m_peakDetect[_channel]) {
+        startView = 0 - trigPosInView;
+        stopView = viewSize - trigPosInView;
+        decimatePeakDetect(_data, _dataSize, startView, range, scaleFuncCof1, scaleFuncCof2, _view, _viewInfo, _unscaledView);
+        _viewInfo->m_trigPosition = trigPosInViewOrigin;
     } else {
         startView = 0 - trigPosInView;
         stopView = viewSize - trigPosInView;
@@ -323,20 +385,28 @@ auto CDataDecimator::decimate(rp_channel_t _channel, const float* _data, vsize_t
             dataIndexEnd = screenToBuffer(x, m_decimationFactor, &t);
             x--;
         }
-        uint32_t count = 0;
-        uint32_t trigId = 0;
-        for (int idx = dataIndexStart; idx != dataIndexEnd; idx = (idx + 1) % ADC_BUFFER_SIZE, trigId++) {
-            auto y = _data[idx];
-            _originalData->push_back(y);
-            if (_viewRawInfo->m_maxUnscale < y)
-                _viewRawInfo->m_maxUnscale = y;
-            if (_viewRawInfo->m_minUnscale > y)
-                _viewRawInfo->m_minUnscale = y;
-            _viewRawInfo->m_meanUnscale += y;
-            count++;
-            if (idx == 0) {
-                _viewRawInfo->m_trigPosition = trigId - 1;
-            }
+        // [dataIndexStart, dataIndexEnd) is one or two contiguous runs of the circular buffer. They are copied
+        // and reduced with the same NEON min/max/sum as the peak detect columns.
+        uint32_t count = (dataIndexEnd - dataIndexStart + ADC_BUFFER_SIZE) % ADC_BUFFER_SIZE;
+        uint32_t first = std::min<uint32_t>(count, ADC_BUFFER_SIZE - dataIndexStart);
+        ColumnStat stat;
+        stat.m_count = 0;
+        stat.m_sum = 0;
+        _originalData->reserve(count + 1);
+        _originalData->insert(_originalData->end(), _data + dataIndexStart, _data + dataIndexStart + first);
+        _originalData->insert(_originalData->end(), _data, _data + (count - first));
+        reduceRun(_data, dataIndexStart, first, &stat);
+        reduceRun(_data, 0, count - first, &stat);
+        if (stat.m_count) {
+            if (_viewRawInfo->m_maxUnscale < stat.m_max)
+                _viewRawInfo->m_maxUnscale = stat.m_max;
+            if (_viewRawInfo->m_minUnscale > stat.m_min)
+                _viewRawInfo->m_minUnscale = stat.m_min;
+            _viewRawInfo->m_meanUnscale += stat.m_sum;
+        }
+        uint32_t trigId = (ADC_BUFFER_SIZE - dataIndexStart) % ADC_BUFFER_SIZE;
+        if (trigId < count) {
+            _viewRawInfo->m_trigPosition = trigId - 1;
         }
         _originalData->push_back(_data[dataIndexEnd]);
         _viewRawInfo->m_meanUnscale /= count ? count : 1;
@@ -344,3 +414,79 @@ auto CDataDecimator::decimate(rp_channel_t _channel, const float* _data, vsize_t
 
     return true;
 }
+
+auto CDataDecimator::decimatePeakDetect(const float* _data, vsize_t _dataSize, int _startView, ValidRange _range, float _scaleCof1, float _scaleCof2,
+                                        std::vector<float>* _view, DataInfo* _viewInfo, std::vector<float>* _unscaledView) -> void {
+    // Same pixel to sample mapping and limits as screenToBuffer, but every sample between two pixels goes into the column.
+    // [minX, maxX) is relative to the trigger, screenToBuffer accepts x up to _dataSize / 2 inclusive.
+    int32_t minX = -(int32_t)(_dataSize / 2);
+    int32_t maxX = (int32_t)(_dataSize / 2) + 1;
+    if (_range.m_validBeforeTrigger != -1)
+        minX = std::max(minX, -_range.m_validBeforeTrigger);
+    if (_range.m_validAfterTrigger != -1)
+        maxX = std::min(maxX, _range.m_validAfterTrigger + 1);
+
+    auto setPoint = [&](size_t _iView, float _value) {
+        (*_view)[_iView] = std::isnan(_value) ? _value : scaleAmplitude<float>(_value, _scaleCof1, _scaleCof2);
+        if (_unscaledView)
+            (*_unscaledView)[_iView] = _value;
+    };
+
+    auto viewSize = _view->size();
+    float prev = std::numeric_limits<float>::quiet_NaN();
+    double sum = 0;
+    uint64_t count = 0;
+    ColumnStat stat;
+    // Every column is two pixels wide and gives two points, its min and its max, so the trace draws the
+    // whole envelope and a one-sample glitch reaches the screen whatever its position in the column.
+    // With an odd view size the last column is three pixels wide, so it still gets both extremes.
+    int points = 2;
+    for (size_t iView = 0; iView < viewSize; iView += points) {
+        points = viewSize - iView == 3 ? 3 : std::min<size_t>(2, viewSize - iView);
+        int idx = _startView + (int)iView;
+        int32_t x0 = floor((float)idx * m_decimationFactor - 1);
+        int32_t x1 = floor((float)(idx + points) * m_decimationFactor - 1);
+        if (x1 <= x0)
+            x1 = x0 + 1;
+        x0 = std::max(x0, minX);
+        x1 = std::min(x1, maxX);
+        if (x0 >= x1) {
+            for (int i = 0; i < points; i++)
+                setPoint(iView + i, std::numeric_limits<float>::quiet_NaN());
+            prev = std::numeric_limits<float>::quiet_NaN();
+            continue;
+        }
+        reduceColumn(_data, _dataSize, x0, x1, &stat);
+
+        // Start with the extreme closer to the previous point, so the polyline does not cross the column twice
+        bool maxFirst = !std::isnan(prev) && (stat.m_max - prev) < (prev - stat.m_min);
+        float first = maxFirst ? stat.m_max : stat.m_min;
+        float second = maxFirst ? stat.m_min : stat.m_max;
+        if (points >= 2) {
+            setPoint(iView, first);
+            for (int i = 1; i < points; i++)
+                setPoint(iView + i, second);
+        } else {
+            // A one pixel view has room for one point only
+            setPoint(iView, second);
+        }
+        prev = second;
+
+        if (_viewInfo->m_maxUnscale < stat.m_max)
+            _viewInfo->m_maxUnscale = stat.m_max;
+        if (_viewInfo->m_minUnscale > stat.m_min)
+            _viewInfo->m_minUnscale = stat.m_min;
+        auto scaledMin = scaleAmplitude<float>(stat.m_min, _scaleCof1, _scaleCof2);
+        auto scaledMax = scaleAmplitude<float>(stat.m_max, _scaleCof1, _scaleCof2);
+        if (scaledMin > scaledMax)
+            std::swap(scaledMin, scaledMax);
+        if (_viewInfo->m_max < scaledMax)
+            _viewInfo->m_max = scaledMax;
+        if (_viewInfo->m_min > scaledMin)
+            _viewInfo->m_min = scaledMin;
+        sum += stat.m_sum;
+        count += stat.m_count;
+    }
+    _viewInfo->m_meanUnscale = count ? sum / count : 0;
+    _viewInfo->m_mean = scaleAmplitude<float>(_viewInfo->m_meanUnscale, _scaleCof1, _scaleCof2);
+}
@@ -45,6 +45,9 @@ class CDataDecimator {
     auto setInterpolationMode(rp_channel_t _channel, rpApp_osc_interpolationMode _mode) -> void;
     auto getInterpolationMode(rp_channel_t _channel) const -> rpApp_osc_interpolationMode;
 
+    auto setPeakDetect(rp_channel_t _channel, bool _enable) -> void;
+    auto getPeakDetect(rp_channel_t _channel) const -> bool;
+
     auto setScaleFunction(func_t _func) -> void;
     auto getScaleFunction() const -> func_t;
 
@@ -59,9 +62,13 @@ class CDataDecimator {
                   DataInfo* _viewInfo, DataInfo* _viewRawInfo, ValidRange range, std::vector<float>* _unscaledView) -> bool;
 
    private:
+    auto decimatePeakDetect(const float* _data, vsize_t _dataSize, int _startView, ValidRange _range, float _scaleCof1, float _scaleCof2, std::vector<float>* _view,
+                            DataInfo* _viewInfo, std::vector<float>* _unscaledView) -> void;
+
     float m_decimationFactor;
     vsize_t m_viewSize;
     rpApp_osc_interpolationMode m_mode[MAX_ADC_CHANNELS];
+    bool m_peakDetect[MAX_ADC_CHANNELS];
     func_t m_scaleFunc;
     std::mutex m_settingsMutex;
     std::vector<float> m_decimatedData;
@@ -14,6 +14,7 @@
 #include "common.h"
 #include "osciloscopeApp.h"
 #include "rpApp.h"
+#include "spectrogramApp.h"
 #include "spectrometerApp.h"
 #include "version.h"
 
@@ -46,6 +47,7 @@ int rpApp_OscRunMainThread() {
 
 int rpApp_Release() {
     osc_stop();
+    specgram_stop();
     osc_Release();
     ECHECK(rp_Release());
     return RP_OK;
@@ -327,6 +329,14 @@ int rpApp_OscGetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode* _
     return osc_GetSmoothMode(_channel, _mode);
 }
 
+int rpApp_OscSetPeakDetect(rp_channel_t _channel, bool _enable) {
+    return osc_SetPeakDetect(_channel, _enable);
+}
+
+int rpApp_OscGetPeakDetect(rp_channel_t _channel, bool* _enable) {
+    return osc_GetPeakDetect(_channel, _enable);
+}
+
 int rpApp_OscSetForceUpdateView(bool enable) {
     return osc_SetForceUpdateView(enable);
 }
@@ -466,6 +476,96 @@ int rpApp_SpecGetImpedance(double* value) {
     return spec_getImpedance(value);
 }
 
+int rpApp_SpecSetZoom(double center, uint32_t decimation) {
+    return spec_setZoom(center, decimation);
+}
+
+int rpApp_SpecGetZoom(double* center, uint32_t* decimation) {
+    return spec_getZoom(center, decimation);
+}
+
+int rpApp_SpecSetZoomEnable(bool enable) {
+    return spec_setZoomEnable(enable);
+}
+
+int rpApp_SpecGetZoomEnable(bool* enable) {
+    return spec_getZoomEnable(enable);
+}
+
+// SPECTROGRAM
+
+int rpApp_SpecGramRun() {
+    return specgram_run();
+}
+
+int rpApp_SpecGramStop() {
+    return specgram_stop();
+}
+
+int rpApp_SpecGramRunning() {
+    return specgram_running();
+}
+
+int rpApp_SpecGramSetEnable(rp_channel_t channel, bool state) {
+    return specgram_setEnable(channel, state);
+}
+
+int rpApp_SpecGramGetEnable(rp_channel_t channel, bool* state) {
+    return specgram_getEnable(channel, state);
+}
+
+int rpApp_SpecGramSetFFTSize(uint32_t size) {
+    return specgram_setFFTSize(size);
+}
+
+int rpApp_SpecGramGetFFTSize(uint32_t* size) {
+    return specgram_getFFTSize(size);
+}
+
+int rpApp_SpecGramSetOverlap(float overlap) {
+    return specgram_setOverlap(overlap);
+}
+
+int rpApp_SpecGramGetOverlap(float* overlap) {
+    return specgram_getOverlap(overlap);
+}
+
+int rpApp_SpecGramSetDecimation(uint32_t decimation) {
+    return specgram_setDecimation(decimation);
+}
+
+int rpApp_SpecGramGetDecimation(uint32_t* decimation) {
+    return specgram_getDecimation(decimation);
+}
+
+int rpApp_SpecGramSetWindow(rp_dsp_api::window_mode_t mode) {
+    return specgram_setWindow(mode);
+}
+
+int rpApp_SpecGramGetWindow(rp_dsp_api::window_mode_t* mode) {
+    return specgram_getWindow(mode);
+}
+
+int rpApp_SpecGramSetHistoryDepth(uint32_t rows) {
+    return specgram_setHistoryDepth(rows);
+}
+
+int rpApp_SpecGramGetHistoryDepth(uint32_t* rows) {
+    return specgram_getHistoryDepth(rows);
+}
+
+int rpApp_SpecGramGetBins(uint32_t* bins) {
+    return specgram_getBins(bins);
+}
+
+int rpApp_SpecGramGetHistory(rp_channel_t channel, uint64_t from_frame, std::vector<float>* data, std::vector<uint64_t>* frames) {
+    return specgram_getHistory(channel, from_frame, data, frames);
+}
+
+int rpApp_SpecGramGetStats(rpApp_specgram_stats_t* stats) {
+    return specgram_getStats(stats);
+}
+
 // X-Y mode
 
 int rpApp_OscSetEnableXY(bool _state) {
@@ -100,6 +100,18 @@ typedef enum { RPAPP_RAW_EXPORT = 0, RPAPP_VIEW_EXPORT = 1 } rpApp_osc_exportMod
 
 typedef std::function<void(rp_channel_t channel, uint32_t decimation, float timeScale, const std::vector<float>& data)> rpApp_osc_updateViewCallback_t;
 
+/**
+* Counters of the continuous spectrogram.
+*/
+typedef struct {
+    uint64_t frames;      //!< Frames analysed since the start
+    uint64_t dropped;     //!< Frames lost because the DMA overwrote them before they were analysed
+    uint64_t last_frame;  //!< Number of the newest frame in the history
+    float frame_rate;     //!< Frames analysed per second
+    float realtime_bw;    //!< Input bandwidth in Hz that is analysed without gaps
+    float bin_width;      //!< Frequency step between bins in Hz
+} rpApp_specgram_stats_t;
+
 /** @name General
 */
 ///@{
@@ -664,6 +676,19 @@ int rpApp_OscSetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode _m
 
 int rpApp_OscGetSmoothMode(rp_channel_t _channel, rpApp_osc_interpolationMode* _mode);
 
+/**
+* Enables min/max (peak-detect) decimation of the view. When more than one sample falls on a screen pixel,
+* the pixel is drawn from the extremes of all its samples instead of a single picked sample, so glitches
+* narrower than a pixel stay visible. Has no effect when the view is interpolated (less than one sample per pixel).
+* @param _channel Channel to configure.
+* @param _enable True to enable peak detect.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetPeakDetect(rp_channel_t _channel, bool _enable);
+
+int rpApp_OscGetPeakDetect(rp_channel_t _channel, bool* _enable);
+
 int rpApp_OscSetForceUpdateView(bool enable);
 
 int rpApp_OscGetForceUpdateView(bool* enable);
@@ -750,8 +775,100 @@ int rpApp_SpecGetADCBufferSize();
 
 int rpApp_SpecGetFpgaFreq(float* freq);
 
+/**
+* Sets the zoom band of the spectrum worker. In zoom mode the signal is captured at full rate through AXI DMA,
+* mixed down to the centre frequency and decimated, so the view holds rpApp_SpecGetViewSize() bins of
+* ADC rate / decimation / size Hz between center - span/2 and center + span/2.
+* @param center Centre frequency in Hz.
+* @param decimation Power of two from 2 to 16384. The span is ADC rate / decimation and must lie within 0 .. ADC rate / 2.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_SpecSetZoom(double center, uint32_t decimation);
+
+int rpApp_SpecGetZoom(double* center, uint32_t* decimation);
+
+/**
+* Switches the spectrum worker between the full band and the zoom band set by rpApp_SpecSetZoom().
+* The view frequency vector follows the mode.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_SpecSetZoomEnable(bool enable);
+
+int rpApp_SpecGetZoomEnable(bool* enable);
+
 int rpApp_OscMeasureMaxValue(rpApp_osc_source source, float* Max);
 
 int rpApp_OscMeasureMinValue(rpApp_osc_source source, float* Min);
 
+/** @name Spectrogram
+* Continuous spectrogram on the AXI DMA capture. It does not use a trigger and must not run together with the spectrum worker.
+* Settings changed while running restart the capture.
+*/
+///@{
+
+/**
+* Starts the DMA capture and the FFT worker threads (one per core).
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_SpecGramRun();
+
+int rpApp_SpecGramStop();
+
+int rpApp_SpecGramRunning();
+
+int rpApp_SpecGramSetEnable(rp_channel_t channel, bool state);
+
+int rpApp_SpecGramGetEnable(rp_channel_t channel, bool* state);
+
+/**
+* Sets the FFT length in samples. Power of two from 256 to 65536.
+*/
+int rpApp_SpecGramSetFFTSize(uint32_t size);
+
+int rpApp_SpecGramGetFFTSize(uint32_t* size);
+
+/**
+* Sets the overlap of consecutive frames, from 0 to 0.95 of the FFT length.
+*/
+int rpApp_SpecGramSetOverlap(float overlap);
+
+int rpApp_SpecGramGetOverlap(float* overlap);
+
+int rpApp_SpecGramSetDecimation(uint32_t decimation);
+
+int rpApp_SpecGramGetDecimation(uint32_t* decimation);
+
+int rpApp_SpecGramSetWindow(rp_dsp_api::window_mode_t mode);
+
+int rpApp_SpecGramGetWindow(rp_dsp_api::window_mode_t* mode);
+
+/**
+* Sets the number of frames kept in the waterfall history.
+*/
+int rpApp_SpecGramSetHistoryDepth(uint32_t rows);
+
+int rpApp_SpecGramGetHistoryDepth(uint32_t* rows);
+
+/**
+* Number of bins in a history row (half of the FFT length).
+*/
+int rpApp_SpecGramGetBins(uint32_t* bins);
+
+/**
+* Copies the history rows of the channel from the frame from_frame to the newest one, oldest first.
+* Rows are in dBm. Dropped frames are missing, so the number of every row is returned in frames.
+* @param channel Channel
+* @param from_frame First frame to return. Only the newest rows up to the history depth are kept.
+* @param data Rows one after another, rpApp_SpecGramGetBins() values each
+* @param frames Frame number of every row
+*/
+int rpApp_SpecGramGetHistory(rp_channel_t channel, uint64_t from_frame, std::vector<float>* data, std::vector<uint64_t>* frames);
+
+int rpApp_SpecGramGetStats(rpApp_specgram_stats_t* stats);
+
+///@}
+
 #endif  //__RP_H
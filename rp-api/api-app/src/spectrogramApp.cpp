@@ -0,0 +1,465 @@
+/**
+ * @brief Red Pitaya continuous spectrogram worker.
+ *
+ * The acquisition is started without a trigger, so the AXI DMA keeps writing
+ * the DDR ring. A reader thread follows the write pointer and queues frames
+ * that overlap by the configured amount. Each worker thread owns a CDSP
+ * instance (the FFT state is not shared) and stores the power of every bin
+ * in a history ring together with the frame number.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common.h"
+#include "spectrogramApp.h"
+
+#define SPECGRAM_MIN_FFT 256
+#define SPECGRAM_MAX_FFT 65536
+#define SPECGRAM_MAX_OVERLAP 0.95f
+#define SPECGRAM_MAX_DEPTH 4096
+#define SPECGRAM_POLL_US 200
+#define SPECGRAM_STAT_PERIOD_MS 500
+
+namespace {
+
+typedef struct {
+    uint64_t frame;
+    uint64_t start;  // Absolute sample index from the start of the capture
+} specgram_job_t;
+
+typedef struct {
+    std::unique_ptr<rp_dsp_api::CDSP> dsp;
+    std::unique_ptr<rp_dsp_api::data_t> data;
+    std::thread thread;
+} specgram_worker_t;
+
+/* Settings. They are applied on the next start. */
+std::mutex g_ctrl_mutex;
+bool g_enable[MAX_ADC_CHANNELS] = {true, true, true, true};
+uint32_t g_fft_size = 4096;
+float g_overlap = 0.5;
+uint32_t g_decimation = 1;
+rp_dsp_api::window_mode_t g_window = rp_dsp_api::HANNING;
+uint32_t g_depth = 256;
+
+std::atomic<bool> g_running = false;
+std::atomic<bool> g_quit = false;
+std::thread g_reader;
+std::vector<specgram_worker_t> g_workers;
+
+/* Position in the AXI ring */
+std::mutex g_pos_mutex;
+rp_channel_t g_ref_channel = RP_CH_1;
+uint32_t g_buffer_samples = 0;
+uint32_t g_origin = 0;
+uint32_t g_last_wp = 0;
+uint64_t g_written = 0;
+
+std::mutex g_queue_mutex;
+std::condition_variable g_queue_cv;
+std::deque<specgram_job_t> g_queue;
+size_t g_queue_max = 0;
+
+/* Waterfall history */
+std::mutex g_history_mutex;
+std::vector<float> g_history[MAX_ADC_CHANNELS];
+std::vector<uint64_t> g_history_frame;
+uint64_t g_history_stored = 0;
+uint32_t g_bins = 0;
+uint64_t g_last_frame = 0;
+bool g_has_frame = false;
+
+std::atomic<uint64_t> g_frames = 0;
+std::atomic<uint64_t> g_dropped = 0;
+std::atomic<float> g_frame_rate = 0;
+std::atomic<float> g_realtime_bw = 0;
+
+auto hopSize() -> uint32_t {
+    return std::max<uint32_t>(1, g_fft_size - (uint32_t)(g_fft_size * g_overlap));
+}
+
+auto currentPosition() -> uint64_t {
+    std::lock_guard lock(g_pos_mutex);
+    uint32_t wp = 0;
+    if (rp_AcqAxiGetWritePointer(g_ref_channel, &wp) == RP_OK) {
+        g_written += (wp + g_buffer_samples - g_last_wp) % g_buffer_samples;
+        g_last_wp = wp;
+    }
+    return g_written;
+}
+
+auto storeRow(uint64_t frame, rp_dsp_api::data_t* data) -> void {
+    std::lock_guard lock(g_history_mutex);
+    // Slots are used in the order the frames are finished, so dropped frames do not leave empty rows
+    auto slot = g_history_stored++ % g_depth;
+    auto& power = data->m_converted.m_result[rp_dsp_api::DBM];
+    for (uint8_t ch = 0; ch < MAX_ADC_CHANNELS; ch++) {
+        if (g_history[ch].empty())
+            continue;
+        std::copy_n(power[ch].begin(), g_bins, g_history[ch].begin() + slot * g_bins);
+    }
+    g_history_frame[slot] = frame;
+    if (!g_has_frame || frame > g_last_frame)
+        g_last_frame = frame;
+    g_has_frame = true;
+    g_frames++;
+}
+
+void workerThread(specgram_worker_t* worker) {
+    auto channels = getADCChannels();
+    auto dsp = worker->dsp.get();
+    auto data = worker->data.get();
+    while (1) {
+        specgram_job_t job;
+        {
+            std::unique_lock lock(g_queue_mutex);
+            g_queue_cv.wait(lock, [] { return g_quit || !g_queue.empty(); });
+            if (g_quit)
+                return;
+            job = g_queue.front();
+            g_queue.pop_front();
+        }
+
+        bool ok = true;
+        uint32_t pos = (g_origin + job.start) % g_buffer_samples;
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            if (!g_enable[ch])
+                continue;
+            uint32_t size = g_fft_size;
+            ok &= rp_AcqAxiGetDataV((rp_channel_t)ch, pos, &size, data->m_in[ch].data()) == RP_OK;
+        }
+        // The DMA may have overwritten the frame while it was copied
+        if (!ok || currentPosition() - job.start > g_buffer_samples) {
+            g_dropped++;
+            continue;
+        }
+
+        dsp->windowFilter(data);
+        dsp->fft(data);
+        dsp->decimate(data, dsp->getOutSignalLength(), dsp->getOutSignalLength());
+        dsp->cnvToMetric(data, g_decimation);
+        storeRow(job.frame, data);
+    }
+}
+
+void readerThread() {
+    auto hop = hopSize();
+    // Frames still waiting in the queue must not be overwritten before a worker copies them
+    uint64_t limit = g_buffer_samples / 2;
+    uint64_t next = 0;
+    uint64_t frame = 0;
+    auto rate = (double)getADCRate() / g_decimation;
+
+    auto stat_time = std::chrono::steady_clock::now();
+    uint64_t stat_written = 0;
+    uint64_t stat_frames = 0;
+
+    while (!g_quit) {
+        auto written = currentPosition();
+        if (written > next + limit) {
+            uint64_t skip = (written - next - g_fft_size) / hop;
+            next += skip * hop;
+            frame += skip;
+            g_dropped += skip;
+        }
+        {
+            std::lock_guard lock(g_queue_mutex);
+            while (next + g_fft_size <= written && g_queue.size() < g_queue_max) {
+                g_queue.push_back({frame, next});
+                next += hop;
+                frame++;
+            }
+        }
+        g_queue_cv.notify_all();
+
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>(now - stat_time).count();
+        if (elapsed * 1000.0 >= SPECGRAM_STAT_PERIOD_MS) {
+            uint64_t frames = g_frames;
+            double input = written - stat_written;
+            double analysed = (double)(frames - stat_frames) * hop;
+            g_frame_rate = (frames - stat_frames) / elapsed;
+            // The input bandwidth that is analysed without gaps
+            g_realtime_bw = input > 0 ? std::min(1.0, analysed / input) * rate / 2.0 : 0;
+            stat_time = now;
+            stat_written = written;
+            stat_frames = frames;
+        }
+        usleep(SPECGRAM_POLL_US);
+    }
+}
+
+auto stopLocked() -> int {
+    if (!g_running)
+        return RP_OK;
+    g_quit = true;
+    g_queue_cv.notify_all();
+    if (g_reader.joinable())
+        g_reader.join();
+    for (auto& worker : g_workers) {
+        if (worker.thread.joinable())
+            worker.thread.join();
+    }
+    g_workers.clear();
+    g_queue.clear();
+
+    rp_AcqStop();
+    auto channels = getADCChannels();
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        rp_AcqAxiEnable((rp_channel_t)ch, false);
+    }
+    g_running = false;
+    return RP_OK;
+}
+
+auto runLocked() -> int {
+    if (g_running)
+        return RP_OK;
+
+    auto channels = getADCChannels();
+    auto enabled = std::count(g_enable, g_enable + channels, true);
+    if (enabled == 0)
+        return RP_EOOR;
+
+    uint32_t axi_start = 0;
+    uint32_t axi_size = 0;
+    if (rp_AcqAxiGetMemoryRegion(&axi_start, &axi_size) != RP_OK)
+        return RP_EOOR;
+    uint32_t ch_bytes = (axi_size / channels) & ~0xFu;
+    g_buffer_samples = ch_bytes / sizeof(int16_t);
+    if (g_buffer_samples < g_fft_size * 4) {
+        ERROR_LOG("AXI buffer is too small for FFT size %d", g_fft_size);
+        return RP_EOOR;
+    }
+
+    g_workers.clear();
+    g_workers.resize(std::max(1u, std::thread::hardware_concurrency()));
+    for (auto& worker : g_workers) {
+        worker.dsp = std::make_unique<rp_dsp_api::CDSP>(channels, g_fft_size, getADCRate(), false);
+        // The workers already use every core, a channel pool per worker would oversubscribe them
+        worker.dsp->setThreads(1);
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            worker.dsp->setChannel(ch, g_enable[ch]);
+        }
+        if (worker.dsp->window_init(g_window) < 0 || worker.dsp->fftInit() < 0) {
+            g_workers.clear();
+            return RP_EOOR;
+        }
+        worker.data.reset(worker.dsp->createData());
+        if (!worker.data) {
+            g_workers.clear();
+            return RP_EAM;
+        }
+        worker.dsp->prepareFreqVector(worker.data.get(), g_decimation);
+    }
+    g_queue_max = g_workers.size() * 2;
+
+    {
+        std::lock_guard lock(g_history_mutex);
+        g_bins = g_fft_size / 2;
+        for (uint8_t ch = 0; ch < MAX_ADC_CHANNELS; ch++) {
+            g_history[ch].clear();
+            if (ch < channels && g_enable[ch])
+                g_history[ch].assign((size_t)g_depth * g_bins, 0);
+        }
+        g_history_frame.assign(g_depth, UINT64_MAX);
+        g_history_stored = 0;
+        g_last_frame = 0;
+        g_has_frame = false;
+    }
+    g_frames = 0;
+    g_dropped = 0;
+    g_frame_rate = 0;
+    g_realtime_bw = 0;
+
+    rp_AcqStop();
+    rp_AcqAxiSetDecimationFactor(g_decimation);
+    bool first = true;
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        auto channel = (rp_channel_t)ch;
+        if (!g_enable[ch]) {
+            rp_AcqAxiEnable(channel, false);
+            continue;
+        }
+        rp_AcqAxiSetTriggerDelay(channel, g_buffer_samples);
+        rp_AcqAxiSetBufferSamples(channel, axi_start + ch_bytes * ch, g_buffer_samples);
+        if (rp_AcqAxiEnable(channel, true) != RP_OK) {
+            g_workers.clear();
+            return RP_EOOR;
+        }
+        if (first)
+            g_ref_channel = channel;
+        first = false;
+    }
+
+    // There is no trigger, so the DMA writes the ring until the acquisition is stopped
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED);
+    {
+        std::lock_guard lock(g_pos_mutex);
+        rp_AcqAxiGetWritePointer(g_ref_channel, &g_origin);
+        g_last_wp = g_origin;
+        g_written = 0;
+    }
+
+    g_quit = false;
+    try {
+        for (auto& worker : g_workers) {
+            worker.thread = std::thread(workerThread, &worker);
+        }
+        g_reader = std::thread(readerThread);
+    } catch (const std::exception& e) {
+        ERROR_LOG("Thread creation failed: %s\n", e.what());
+        g_running = true;
+        stopLocked();
+        return RP_APP_EST;
+    }
+    g_running = true;
+    return RP_OK;
+}
+
+// Settings can be changed while running, the capture restarts with them
+template <typename F>
+auto applySetting(F setter) -> int {
+    std::lock_guard lock(g_ctrl_mutex);
+    bool running = g_running;
+    stopLocked();
+    setter();
+    return running ? runLocked() : RP_OK;
+}
+
+}  // namespace
+
+int specgram_run() {
+    std::lock_guard lock(g_ctrl_mutex);
+    return runLocked();
+}
+
+int specgram_stop() {
+    std::lock_guard lock(g_ctrl_mutex);
+    return stopLocked();
+}
+
+int specgram_running() {
+    return g_running;
+}
+
+int specgram_setEnable(rp_channel_t channel, bool state) {
+    if (channel >= getADCChannels())
+        return RP_EOOR;
+    return applySetting([=] { g_enable[channel] = state; });
+}
+
+int specgram_getEnable(rp_channel_t channel, bool* state) {
+    if (channel >= getADCChannels())
+        return RP_EOOR;
+    *state = g_enable[channel];
+    return RP_OK;
+}
+
+int specgram_setFFTSize(uint32_t size) {
+    if (size < SPECGRAM_MIN_FFT || size > SPECGRAM_MAX_FFT || (size & (size - 1)) != 0)
+        return RP_EOOR;
+    return applySetting([=] { g_fft_size = size; });
+}
+
+int specgram_getFFTSize(uint32_t* size) {
+    *size = g_fft_size;
+    return RP_OK;
+}
+
+int specgram_setOverlap(float overlap) {
+    if (overlap < 0 || overlap > SPECGRAM_MAX_OVERLAP)
+        return RP_EOOR;
+    return applySetting([=] { g_overlap = overlap; });
+}
+
+int specgram_getOverlap(float* overlap) {
+    *overlap = g_overlap;
+    return RP_OK;
+}
+
+int specgram_setDecimation(uint32_t decimation) {
+    if (decimation == 0)
+        return RP_EOOR;
+    return applySetting([=] { g_decimation = decimation; });
+}
+
+int specgram_getDecimation(uint32_t* decimation) {
+    *decimation = g_decimation;
+    return RP_OK;
+}
+
+int specgram_setWindow(rp_dsp_api::window_mode_t mode) {
+    return applySetting([=] { g_window = mode; });
+}
+
+int specgram_getWindow(rp_dsp_api::window_mode_t* mode) {
+    *mode = g_window;
+    return RP_OK;
+}
+
+int specgram_setHistoryDepth(uint32_t rows) {
+    if (rows == 0 || rows > SPECGRAM_MAX_DEPTH)
+        return RP_EOOR;
+    return applySetting([=] { g_depth = rows; });
+}
+
+int specgram_getHistoryDepth(uint32_t* rows) {
+    *rows = g_depth;
+    return RP_OK;
+}
+
+int specgram_getBins(uint32_t* bins) {
+    *bins = g_fft_size / 2;
+    return RP_OK;
+}
+
+int specgram_getHistory(rp_channel_t channel, uint64_t from_frame, std::vector<float>* data, std::vector<uint64_t>* frames) {
+    if (channel >= MAX_ADC_CHANNELS || !data || !frames)
+        return RP_EOOR;
+    std::lock_guard lock(g_history_mutex);
+    data->clear();
+    frames->clear();
+    if (!g_has_frame || g_history[channel].empty())
+        return RP_OK;
+    std::vector<uint32_t> slots;
+    for (uint32_t slot = 0; slot < g_depth; slot++) {
+        if (g_history_frame[slot] != UINT64_MAX && g_history_frame[slot] >= from_frame)
+            slots.push_back(slot);
+    }
+    // The workers may finish frames out of order
+    std::sort(slots.begin(), slots.end(), [](uint32_t a, uint32_t b) { return g_history_frame[a] < g_history_frame[b]; });
+    data->reserve(slots.size() * g_bins);
+    for (auto slot : slots) {
+        auto row = g_history[channel].begin() + slot * g_bins;
+        data->insert(data->end(), row, row + g_bins);
+        frames->push_back(g_history_frame[slot]);
+    }
+    return RP_OK;
+}
+
+int specgram_getStats(rpApp_specgram_stats_t* stats) {
+    if (!stats)
+        return RP_EOOR;
+    {
+        std::lock_guard lock(g_history_mutex);
+        stats->last_frame = g_last_frame;
+    }
+    stats->frames = g_frames;
+    stats->dropped = g_dropped;
+    stats->frame_rate = g_frame_rate;
+    stats->realtime_bw = g_realtime_bw;
+    stats->bin_width = (float)getADCRate() / g_decimation / g_fft_size;
+    return RP_OK;
+}
@@ -0,0 +1,52 @@
+/**
+ * @brief Red Pitaya continuous spectrogram worker.
+ *
+ * Reads the AXI DMA ring without a trigger and computes overlapping FFT frames
+ * on several worker threads. The newest frames are kept in a waterfall history.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __SPECTROGRAMAPP_H
+#define __SPECTROGRAMAPP_H
+
+#include "math/rp_dsp.h"
+#include "rpApp.h"
+
+int specgram_run();
+
+int specgram_stop();
+
+int specgram_running();  // true/false
+
+int specgram_setEnable(rp_channel_t channel, bool state);
+
+int specgram_getEnable(rp_channel_t channel, bool* state);
+
+int specgram_setFFTSize(uint32_t size);
+
+int specgram_getFFTSize(uint32_t* size);
+
+int specgram_setOverlap(float overlap);
+
+int specgram_getOverlap(float* overlap);
+
+int specgram_setDecimation(uint32_t decimation);
+
+int specgram_getDecimation(uint32_t* decimation);
+
+int specgram_setWindow(rp_dsp_api::window_mode_t mode);
+
+int specgram_getWindow(rp_dsp_api::window_mode_t* mode);
+
+int specgram_setHistoryDepth(uint32_t rows);
+
+int specgram_getHistoryDepth(uint32_t* rows);
+
+int specgram_getBins(uint32_t* bins);
+
+int specgram_getHistory(rp_channel_t channel, uint64_t from_frame, std::vector<float>* data, std::vector<uint64_t>* frames);
+
+int specgram_getStats(rpApp_specgram_stats_t* stats);
+
+#endif /* __SPECTROGRAMAPP_H*/
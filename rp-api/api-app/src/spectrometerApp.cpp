@@ -21,14 +21,17 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "common.h"
 #include "common/profiler.h"
 #include "math/rp_math.h"
+#include "math/rp_zoom_fft.h"
 #include "spectrometerApp.h"
 #include "version.h"
 
@@ -44,6 +47,7 @@ typedef enum rp_spectr_worker_state_e {
 // 0 - Xaxis; 1 - Ch 1; 2 - Ch 2; 3 - Ch 3; 4 - Ch 4
 #define SPECTR_OUT_SIG_NUM (MAX_ADC_CHANNELS + 1)
 #define NUM_SIGNAL_PERIODS 16
+#define ZOOM_READ_CHUNK 65536
 
 int rp_spectr_worker_init();
 int rp_spectr_worker_clean(void);
@@ -67,6 +71,13 @@ int rp_spectr_signals_dirty = 0;
 rp_dsp_api::CDSP* g_dsp;
 rp_dsp_api::data_t g_data;
 
+/* Zoom mode: AXI capture at full rate, mixed down and decimated around g_zoom_center */
+std::mutex g_zoom_mutex;
+rp_dsp_api::CZoomFFT* g_zoom_fft = nullptr;
+std::atomic<bool> g_zoom_enable = false;
+double g_zoom_center = 0;
+uint32_t g_zoom_decimation = 2;
+
 static float current_freq_range;
 
 int rp_spectr_worker_init() {
@@ -93,6 +104,15 @@ int rp_spectr_worker_init() {
         return -1;
     }
 
+    {
+        std::lock_guard zoom_lock(g_zoom_mutex);
+        g_zoom_fft = new rp_dsp_api::CZoomFFT(g_dsp->getOutSignalLength(), rate);
+        g_zoom_fft->setWindow(g_dsp->getCurrentWindowMode());
+        if (g_zoom_center > 0 && g_zoom_fft->setZoom(g_zoom_center, g_zoom_decimation) != 0) {
+            g_zoom_enable = false;
+        }
+    }
+
     try {
         rp_spectr_thread_handler = new std::thread(rp_spectr_worker_thread);
     } catch (const std::exception& e) {
@@ -106,6 +126,9 @@ int rp_spectr_worker_init() {
 void clearAll() {
     delete g_dsp;
     g_dsp = nullptr;
+    std::lock_guard zoom_lock(g_zoom_mutex);
+    delete g_zoom_fft;
+    g_zoom_fft = nullptr;
 }
 
 int rp_spectr_worker_clean(void) {
@@ -127,6 +150,7 @@ int rp_spectr_worker_exit(void) {
             }
         }
         delete rp_spectr_thread_handler;
+        rp_spectr_thread_handler = NULL;
     }
     rp_spectr_worker_clean();
     return ret_val;
@@ -140,6 +164,103 @@ int rp_spectr_worker_change_state(rp_spectr_worker_state_t new_state) {
     return 0;
 }
 
+/* One zoom spectrum from an AXI capture at full rate. Returns 1 if the state changed during the capture. */
+int rp_spectr_zoom_acquire(rp_spectr_worker_state_t old_state) {
+    static auto adc_channels = getADCChannels();
+    static std::vector<float> chunk(ZOOM_READ_CHUNK);
+    static std::vector<float> amplitude[MAX_ADC_CHANNELS];
+
+    std::lock_guard zoom_lock(g_zoom_mutex);
+    if (!g_zoom_fft)
+        return -1;
+
+    uint32_t axi_start = 0;
+    uint32_t axi_size = 0;
+    if (rp_AcqAxiGetMemoryRegion(&axi_start, &axi_size) != RP_OK)
+        return -1;
+    uint32_t ch_bytes = (axi_size / adc_channels) & ~0xFu;
+    uint32_t ch_samples = ch_bytes / sizeof(int16_t);
+    uint64_t need = g_zoom_fft->getInputLength();
+    if (need >= ch_samples) {
+        ERROR_LOG("Zoom needs %llu samples, the AXI buffer holds %u", (unsigned long long)need, ch_samples);
+        return -1;
+    }
+
+    bool enabled[MAX_ADC_CHANNELS] = {};
+    rp_AcqStop();
+    rp_AcqAxiSetDecimationFactor(1);
+    for (auto ch = 0; ch < adc_channels; ch++) {
+        g_dsp->getChannel(ch, &enabled[ch]);
+        if (!enabled[ch])
+            continue;
+        rp_AcqAxiSetTriggerDelay((rp_channel_t)ch, need);
+        rp_AcqAxiSetBufferSamples((rp_channel_t)ch, axi_start + ch_bytes * ch, ch_samples);
+        rp_AcqAxiEnable((rp_channel_t)ch, true);
+    }
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+    int ret = 0;
+    for (auto ch = 0; ch < adc_channels && ret == 0; ch++) {
+        bool fillState = !enabled[ch];
+        while (!fillState) {
+            if (rp_spectr_ctrl != old_state) {
+                ret = 1;
+                break;
+            }
+            rp_AcqAxiGetBufferFillState((rp_channel_t)ch, &fillState);
+        }
+    }
+    rp_AcqStop();
+
+    /* The filters run outside of the data lock, a long capture must not block the readers */
+    auto size = g_dsp->getOutSignalLength();
+    for (auto ch = 0; ch < adc_channels && ret == 0; ch++) {
+        if (!enabled[ch])
+            continue;
+        uint32_t trig_pos = 0;
+        rp_AcqAxiGetWritePointerAtTrig((rp_channel_t)ch, &trig_pos);
+        g_zoom_fft->reset();
+        uint64_t read = 0;
+        while (!g_zoom_fft->isReady() && read < need) {
+            uint32_t n = std::min<uint64_t>(ZOOM_READ_CHUNK, need - read);
+            if (rp_AcqAxiGetDataV((rp_channel_t)ch, trig_pos + read, &n, chunk.data()) != RP_OK || n == 0)
+                break;
+            g_zoom_fft->process(chunk.data(), n);
+            read += n;
+        }
+        amplitude[ch].resize(size);
+        if (g_zoom_fft->getAmplitude(amplitude[ch].data()) != 0)
+            ret = -1;
+    }
+
+    for (auto ch = 0; ch < adc_channels; ch++) {
+        if (enabled[ch])
+            rp_AcqAxiEnable((rp_channel_t)ch, false);
+    }
+    if (ret != 0)
+        return ret;
+
+    std::lock_guard lock(rp_spectr_buf_size_mutex);
+    auto data = g_dsp->getStoredData();
+    /* decimate() scales by 2 / window sum of the full band window */
+    float scale = g_dsp->getWindowSum() / 2;
+    for (auto ch = 0; ch < adc_channels; ch++) {
+        if (enabled[ch])
+            multiply_array_by_scalar_float_neon(data->m_fft[ch].data(), amplitude[ch].data(), scale, size);
+    }
+    g_zoom_fft->getFreqVector(data->m_converted.m_freq_vector.data());
+    data->m_converted.m_data_size = size;
+    data->m_converted.m_maxFreq = 0;  // Makes prepareFreqVector() rebuild the vector when zoom is disabled
+    g_dsp->decimate(data, size, size);
+    /* The first bins are the bottom of the band, not DC */
+    bool removeDC = g_dsp->getRemoveDC();
+    g_dsp->setRemoveDC(false);
+    g_dsp->cnvToMetric(data, 1);
+    g_dsp->setRemoveDC(removeDC);
+    return 0;
+}
+
 void rp_spectr_worker_thread() {
     rp_spectr_worker_state_t old_state;
     int current_decimation = 1;
@@ -167,6 +288,14 @@ void rp_spectr_worker_thread() {
             rp_spectr_worker_change_state(AUTO_STATE);
             continue;
         }
+        if (g_zoom_enable) {
+            if (rp_spectr_zoom_acquire(old_state) < 0) {
+                ERROR_LOG("Zoom acquisition failed, zoom is disabled");
+                g_zoom_enable = false;
+            }
+            usleep(100);
+            continue;
+        }
         /* Start the writting machine */
         current_decimation = g_decimation;
         buffer_size = g_dsp->getSignalLength();
@@ -286,6 +415,7 @@ int spec_unlockData() {
 }
 
 int spec_stop() {
+    rp_spectr_worker_change_state(QUIT_STATE);
     rp_spectr_worker_exit();
     return 0;
 }
@@ -295,6 +425,11 @@ int spec_setWindow(rp_dsp_api::window_mode_t mode) {
     if (!g_dsp)
         return -1;
     g_dsp->window_init(mode);
+    {
+        std::lock_guard zoom_lock(g_zoom_mutex);
+        if (g_zoom_fft)
+            g_zoom_fft->setWindow(mode);
+    }
     rp_spectr_worker_change_state(RESET_STATE);
     return 0;
 }
@@ -416,6 +551,12 @@ int spec_setADCBufferSize(size_t size) {
         rp_spectr_worker_clean();
         return -1;
     }
+
+    {
+        std::lock_guard zoom_lock(g_zoom_mutex);
+        if (g_zoom_fft && g_zoom_fft->setFFTSize(g_dsp->getOutSignalLength()) != 0)
+            g_zoom_enable = false;
+    }
     rp_spectr_worker_change_state(RESET_STATE);
     return 0;
 }
@@ -442,4 +583,35 @@ int spec_setImpedance(double value) {
 int spec_getImpedance(double* value) {
     *value = g_dsp->getImpedance();
     return RP_OK;
-}
\ No newline at end of file
+}
+int spec_setZoom(double center, uint32_t decimation) {
+    std::lock_guard zoom_lock(g_zoom_mutex);
+    rp_dsp_api::CZoomFFT check(rp_dsp_api::CZoomFFT::MIN_FFT_SIZE, getADCRate());
+    auto zoom = g_zoom_fft ? g_zoom_fft : &check;
+    if (zoom->setZoom(center, decimation) != 0)
+        return RP_EOOR;
+    g_zoom_center = center;
+    g_zoom_decimation = decimation;
+    rp_spectr_worker_change_state(RESET_STATE);
+    return RP_OK;
+}
+
+int spec_getZoom(double* center, uint32_t* decimation) {
+    std::lock_guard zoom_lock(g_zoom_mutex);
+    *center = g_zoom_center;
+    *decimation = g_zoom_decimation;
+    return RP_OK;
+}
+
+int spec_setZoomEnable(bool enable) {
+    if (enable && g_zoom_center <= 0)
+        return RP_EOOR;
+    g_zoom_enable = enable;
+    rp_spectr_worker_change_state(RESET_STATE);
+    return RP_OK;
+}
+
+int spec_getZoomEnable(bool* enable) {
+    *enable = g_zoom_enable;
+    return RP_OK;
+}
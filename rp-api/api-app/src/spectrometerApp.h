@@ -60,4 +60,12 @@ int spec_setImpedance(double value);
 
 int spec_getImpedance(double* value);
 
+int spec_setZoom(double center, uint32_t decimation);
+
+int spec_getZoom(double* center, uint32_t* decimation);
+
+int spec_setZoomEnable(bool enable);
+
+int spec_getZoomEnable(bool* enable);
+
 #endif /* __SPECTROMETERAPP_H*/
@@ -42,7 +42,8 @@ class CFilter_logic {
     auto setCalibParameters() -> int;
     auto setCalculatedValue(COscilloscope::DataPassAutoFilter item) -> int;
     auto nextSetupCalibParameters() -> int;
-    auto removeHalfCalib() -> void;
+    // Fits a quadratic surface to the measured grid and centers a smaller grid on its minimum
+    auto fitGrid() -> void;
     auto getCalibCount() -> int;
     auto getCalibDone() -> int;
     auto calcProgress() -> int;
@@ -52,8 +53,14 @@ class CFilter_logic {
     auto setCalibMode(int _mode) -> void;
 
    private:
+    auto makeGrid() -> void;
+
     std::vector<GridItem> m_grid;
     GridItem m_lastGood;
+    bool m_hasGood;
+    double m_centerAA;
+    double m_centerBB;
+    double m_percentEnd;
     CCalibMan::Ptr m_calib_man;
     rp_channel_t m_channel;
     int64_t m_index;
@@ -22,7 +22,7 @@ class CFilter_logicNch {
     auto setCalculatedValue(COscilloscope::DataPassAutoFilterSync item) -> void;
     auto getCalibCount() -> int;
     auto getCalibDone() -> int;
-    auto removeHalfCalib() -> void;
+    auto fitGrid() -> void;
     auto nextSetupCalibParameters() -> int;
     auto calcProgress() -> int;
     auto setGoodCalibParameterCh(rp_channel_t ch) -> void;
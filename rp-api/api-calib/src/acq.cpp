@@ -23,24 +23,21 @@ const float g_adc_smpl_freq = getADCRate();
 
 namespace rp_calib {
 
-auto trapezoidalApprox(double* data, float T, int size) -> float {
-    double result = 0;
-    for (int i = 0; i < size - 1; i++) {
-        result += data[i] + data[i + 1];
-    }
-    result = ((T / 2.0) * result);
-    return result;
+// Trapezoidal integral of samples whose sum is _sum, every inner sample counts twice
+auto trapezoidalApprox(double _sum, double _first, double _last, float T) -> float {
+    return (T / 2.0) * (2.0 * _sum - _first - _last);
 }
 
-auto isSineTester(float* data, uint32_t size, uint32_t dec) -> bool {
+// Form factor of the signal, RMS over rectified mean, 1.11 for a sine
+auto isSineTester(const BufferStats& _stats, float* data, uint32_t size, uint32_t dec) -> bool {
+    if (size < 2)
+        return false;
     double T = (dec / g_adc_smpl_freq);
-    double ch_rms[size];
-    double ch_avr[size];
-    for (uint32_t i = 0; i < size; i++) {
-        ch_rms[i] = data[i] * data[i];
-        ch_avr[i] = fabs(data[i]);
-    }
-    double K0 = sqrtf(T * size * trapezoidalApprox(ch_rms, T, size)) / trapezoidalApprox(ch_avr, T, size);
+    float first = data[0];
+    float last = data[size - 1];
+    double rms = trapezoidalApprox(_stats.sum_sq, first * first, last * last, T);
+    double avr = trapezoidalApprox(_stats.sum_abs, fabs(first), fabs(last), T);
+    double K0 = sqrtf(T * size * rms) / avr;
     return ((K0 > 1.10) && (K0 < 1.12));
 }
 
@@ -352,47 +349,29 @@ void COscilloscope::acquire() {
         DataPass localDP;
         localDP.index = m_index++;
         double time_of_buffer = m_adc_sample_per * m_buffer.size * m_decimation / 1000.0;
+        BufferStats stats[RP_CALIB_MAX_ADC_CHANNELS];
         for (auto i = 0u; i < m_channels; i++) {
+            stats[i] = bufferStats(m_buffer.ch_f[i], acq_u_size);
             double per = 0;
             measurePeriod(m_buffer.ch_i[i], m_buffer.size, &per, m_decimation);
             localDP.periodsByBuffer[i] = (per == 0.f ? 0.0 : time_of_buffer / ((double)per));
-            localDP.isSineSignal[i] = isSineTester(m_buffer.ch_f[i], m_buffer.size, m_decimation);
+            localDP.isSineSignal[i] = isSineTester(stats[i], m_buffer.ch_f[i], m_buffer.size, m_decimation);
             // if (i == 0)
             //     fprintf(stderr,"CH %d Per %lf (ms) dec %d tb %lf (us) isSine %d\n",i+1,per,m_decimation,time_of_buffer,localDP.isSineSignal[i]);
         }
 
         pthread_mutex_lock(&m_avgFilter);
         for (auto i = 0u; i < m_channels; i++) {
-            localDP.ch_avg[i] = 0;
-            localDP.ch_mean[i] = 0;
-            localDP.ch_max[i] = m_buffer.ch_f[i][0];
-            localDP.ch_min[i] = m_buffer.ch_f[i][0];
-            localDP.ch_avg_raw[i] = 0;
-            localDP.ch_mean_raw[i] = 0;
-            localDP.ch_min_raw[i] = m_buffer.ch_i[i][0];
-            localDP.ch_max_raw[i] = m_buffer.ch_i[i][0];
-
-            for (auto j = 0u; j < acq_u_size; ++j) {
-                if (localDP.ch_max[i] < m_buffer.ch_f[i][j])
-                    localDP.ch_max[i] = m_buffer.ch_f[i][j];
-                if (localDP.ch_min[i] > m_buffer.ch_f[i][j])
-                    localDP.ch_min[i] = m_buffer.ch_f[i][j];
-                localDP.ch_avg[i] += m_buffer.ch_f[i][j];
-            }
+            localDP.ch_max[i] = stats[i].max;
+            localDP.ch_min[i] = stats[i].min;
             localDP.ch_p_p[i] = localDP.ch_max[i] - localDP.ch_min[i];
             localDP.ch_mean[i] = (localDP.ch_max[i] + localDP.ch_min[i]) / 2.0;
-            localDP.ch_avg[i] /= acq_u_size;
-
-            for (auto j = 0u; j < acq_u_size_raw; ++j) {
-                auto ch = m_buffer.ch_i[i][j];
-                if (localDP.ch_max_raw[i] < ch)
-                    localDP.ch_max_raw[i] = ch;
-                if (localDP.ch_min_raw[i] > ch)
-                    localDP.ch_min_raw[i] = ch;
-                localDP.ch_avg_raw[i] += ch;
-            }
+            localDP.ch_avg[i] = stats[i].sum / acq_u_size;
 
-            localDP.ch_avg_raw[i] /= (int32_t)acq_u_size_raw;
+            auto raw = bufferStatsRaw(m_buffer.ch_i[i], acq_u_size_raw);
+            localDP.ch_max_raw[i] = raw.max;
+            localDP.ch_min_raw[i] = raw.min;
+            localDP.ch_avg_raw[i] = raw.sum / (int32_t)acq_u_size_raw;
             localDP.ch_mean_raw[i] = (localDP.ch_max_raw[i] + localDP.ch_min_raw[i]) / 2.0;
 
             if (m_avg_filter) {
@@ -669,24 +648,18 @@ void COscilloscope::acquireAutoFilter() {
         if (aa != localDP.f_aa || bb != localDP.f_bb || pp != localDP.f_pp || kk != localDP.f_kk)
             return;
 
-        auto* ch = m_buffer.ch_f[m_channel];
-        auto* ch_raw = m_buffer.ch_i[m_channel];
-        for (uint32_t i = 0; i < acq_u_size; i++) {
-            m_acu_buffer[i] += ch[i];
-            m_acu_buffer_raw[i] += ch_raw[i];
-        }
+        accumulate(m_acu_buffer, m_buffer.ch_f[m_channel], acq_u_size);
+        accumulate(m_acu_buffer_raw, m_buffer.ch_i[m_channel], acq_u_size);
         repeat_count++;
     }
 
-    for (uint32_t i = 0; i < acq_u_size; i++) {
-        m_acu_buffer[i] /= (double)repeat_count;
-        m_acu_buffer_raw[i] /= (double)repeat_count;
-    }
+    scale(m_acu_buffer, acq_u_size, 1.0f / repeat_count);
+    scale(m_acu_buffer_raw, acq_u_size, 1.0f / repeat_count);
     localDP.cur_channel = m_channel;
     localDP.index = m_index++;
     auto cross = calcCountCrossZero(m_acu_buffer, acq_u_size);
-    if (cross.size() >= 2) {
-        auto last_max = findLastMax(m_acu_buffer, acq_u_size, cross[1]);
+    auto last_max = cross.size() >= 2 ? findLastMax(m_acu_buffer, acq_u_size, cross[1]) : -1;
+    if (last_max >= 0) {
         // auto last_max_raw = findLastMax(m_acu_buffer_raw, acq_u_size, cross[1]);
         double value = calculate(m_acu_buffer, acq_u_size, m_acu_buffer[last_max], cross[0], cross[1], localDP.deviation);
         double value_raw = calculate(m_acu_buffer_raw, acq_u_size, m_acu_buffer_raw[last_max], cross[0], cross[1], localDP.deviation);
@@ -791,18 +764,14 @@ void COscilloscope::acquireAutoFilterSync() {
         if (exitFlag)
             return;
         for (auto j = 0u; j < m_channels; j++) {
-            for (uint32_t i = 0; i < acq_u_size; i++) {
-                m_acu_buffer[j][i] += m_buffer.ch_f[j][i];
-                m_acu_buffer_raw[j][i] += m_buffer.ch_i[j][i];
-            }
+            accumulate(m_acu_buffer[j], m_buffer.ch_f[j], acq_u_size);
+            accumulate(m_acu_buffer_raw[j], m_buffer.ch_i[j], acq_u_size);
         }
         repeat_count++;
     }
     for (auto j = 0u; j < m_channels; j++) {
-        for (uint32_t i = 0; i < acq_u_size; i++) {
-            m_acu_buffer[j][i] /= (double)repeat_count;
-            m_acu_buffer_raw[j][i] /= (double)repeat_count;
-        }
+        scale(m_acu_buffer[j], acq_u_size, 1.0f / repeat_count);
+        scale(m_acu_buffer_raw[j], acq_u_size, 1.0f / repeat_count);
     }
     for (auto j = 0u; j < m_channels; j++) {
         localDP.valueCH[j].cur_channel = (rp_channel_t)j;
@@ -812,8 +781,8 @@ void COscilloscope::acquireAutoFilterSync() {
 
     for (auto j = 0u; j < m_channels; j++) {
         auto cross1 = calcCountCrossZero(m_acu_buffer[j], acq_u_size);
-        if (cross1.size() >= 2) {
-            auto last_max1 = findLastMax(m_acu_buffer[j], acq_u_size, cross1[1]);
+        auto last_max1 = cross1.size() >= 2 ? findLastMax(m_acu_buffer[j], acq_u_size, cross1[1]) : -1;
+        if (last_max1 >= 0) {
             // auto last_max_raw1 = findLastMax(m_acu_buffer_raw[j], acq_u_size, cross1[1]);
             double value1 = calculate(m_acu_buffer[j], acq_u_size, m_acu_buffer[j][last_max1], cross1[0], cross1[1], localDP.valueCH[j].deviation);
             double value_raw1 = calculate(m_acu_buffer_raw[j], acq_u_size, m_acu_buffer_raw[j][last_max1], cross1[0], cross1[1], localDP.valueCH[j].deviation);
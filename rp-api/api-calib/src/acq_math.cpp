@@ -4,8 +4,157 @@
 #include <iostream>
 #include "rp.h"
 
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
 namespace rp_calib {
 
+// Float partial sums are flushed to double every SUM_BLOCK samples, so the error does not grow
+// with the buffer size
+#define SUM_BLOCK 1024
+
+BufferStats bufferStats(const float* _buffer, uint32_t _size) {
+    BufferStats s;
+    if (_size == 0)
+        return s;
+    float vmin = _buffer[0];
+    float vmax = _buffer[0];
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    if (_size >= 4) {
+        float32x4_t mn = vld1q_f32(_buffer);
+        float32x4_t mx = mn;
+        while (i + 4 <= _size) {
+            uint32_t end = i + SUM_BLOCK < _size ? i + SUM_BLOCK : _size;
+            float32x4_t sum = vdupq_n_f32(0);
+            float32x4_t sum_sq = vdupq_n_f32(0);
+            float32x4_t sum_abs = vdupq_n_f32(0);
+            for (; i + 4 <= end; i += 4) {
+                float32x4_t v = vld1q_f32(_buffer + i);
+                mn = vminq_f32(mn, v);
+                mx = vmaxq_f32(mx, v);
+                sum = vaddq_f32(sum, v);
+                sum_sq = vmlaq_f32(sum_sq, v, v);
+                sum_abs = vaddq_f32(sum_abs, vabsq_f32(v));
+            }
+            float r[4];
+            vst1q_f32(r, sum);
+            s.sum += (double)r[0] + r[1] + r[2] + r[3];
+            vst1q_f32(r, sum_sq);
+            s.sum_sq += (double)r[0] + r[1] + r[2] + r[3];
+            vst1q_f32(r, sum_abs);
+            s.sum_abs += (double)r[0] + r[1] + r[2] + r[3];
+        }
+        float r[4];
+        vst1q_f32(r, mn);
+        vmin = fminf(fminf(r[0], r[1]), fminf(r[2], r[3]));
+        vst1q_f32(r, mx);
+        vmax = fmaxf(fmaxf(r[0], r[1]), fmaxf(r[2], r[3]));
+    }
+#endif
+    while (i < _size) {
+        uint32_t end = i + SUM_BLOCK < _size ? i + SUM_BLOCK : _size;
+        float sum = 0, sum_sq = 0, sum_abs = 0;
+        for (; i < end; i++) {
+            float v = _buffer[i];
+            vmin = v < vmin ? v : vmin;
+            vmax = v > vmax ? v : vmax;
+            sum += v;
+            sum_sq += v * v;
+            sum_abs += fabsf(v);
+        }
+        s.sum += sum;
+        s.sum_sq += sum_sq;
+        s.sum_abs += sum_abs;
+    }
+    s.min = vmin;
+    s.max = vmax;
+    return s;
+}
+
+BufferStatsRaw bufferStatsRaw(const int16_t* _buffer, uint32_t _size) {
+    BufferStatsRaw s;
+    if (_size == 0)
+        return s;
+    int16_t vmin = _buffer[0];
+    int16_t vmax = _buffer[0];
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    if (_size >= 8) {
+        int16x8_t mn = vld1q_s16(_buffer);
+        int16x8_t mx = mn;
+        // The 32 bit lanes cannot overflow within 32768 samples
+        while (i + 8 <= _size) {
+            uint32_t end = i + 32768 < _size ? i + 32768 : _size;
+            int32x4_t sum = vdupq_n_s32(0);
+            for (; i + 8 <= end; i += 8) {
+                int16x8_t v = vld1q_s16(_buffer + i);
+                mn = vminq_s16(mn, v);
+                mx = vmaxq_s16(mx, v);
+                sum = vpadalq_s16(sum, v);
+            }
+            int32_t r[4];
+            vst1q_s32(r, sum);
+            s.sum += (int64_t)r[0] + r[1] + r[2] + r[3];
+        }
+        int16_t r[8];
+        vst1q_s16(r, mn);
+        for (auto v : r)
+            vmin = v < vmin ? v : vmin;
+        vst1q_s16(r, mx);
+        for (auto v : r)
+            vmax = v > vmax ? v : vmax;
+    }
+#endif
+    for (; i < _size; i++) {
+        int16_t v = _buffer[i];
+        vmin = v < vmin ? v : vmin;
+        vmax = v > vmax ? v : vmax;
+        s.sum += v;
+    }
+    s.min = vmin;
+    s.max = vmax;
+    return s;
+}
+
+void accumulate(float* _acc, const float* _buffer, uint32_t _size) {
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    for (; i + 4 <= _size; i += 4) {
+        vst1q_f32(_acc + i, vaddq_f32(vld1q_f32(_acc + i), vld1q_f32(_buffer + i)));
+    }
+#endif
+    for (; i < _size; i++)
+        _acc[i] += _buffer[i];
+}
+
+void accumulate(float* _acc, const int16_t* _buffer, uint32_t _size) {
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    for (; i + 8 <= _size; i += 8) {
+        int16x8_t v = vld1q_s16(_buffer + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(_acc + i, vaddq_f32(vld1q_f32(_acc + i), lo));
+        vst1q_f32(_acc + i + 4, vaddq_f32(vld1q_f32(_acc + i + 4), hi));
+    }
+#endif
+    for (; i < _size; i++)
+        _acc[i] += _buffer[i];
+}
+
+void scale(float* _buffer, uint32_t _size, float _factor) {
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    for (; i + 4 <= _size; i += 4) {
+        vst1q_f32(_buffer + i, vmulq_n_f32(vld1q_f32(_buffer + i), _factor));
+    }
+#endif
+    for (; i < _size; i++)
+        _buffer[i] *= _factor;
+}
+
 // int16_t convertCnts(int16_t cnts)
 // {
 //     int16_t m;
@@ -41,7 +190,7 @@ std::vector<int> calcCountCrossZero(float* _buffer, int _size) {
 
 float* filterBuffer(float* _buffer, int _size) {
     float* new_buffer = new float[_size];
-    std::memcpy(new_buffer, _buffer, _size);
+    std::memcpy(new_buffer, _buffer, _size * sizeof(float));
     float core[] = {1.0 / 8.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 8.0};
     for (int i = 2; i < _size - 2; i++) {
         float sum = 0;
@@ -53,21 +202,33 @@ float* filterBuffer(float* _buffer, int _size) {
     return new_buffer;
 }
 
+// Sample of filterBuffer, only the few samples left of the crossing are needed
+static float filteredAt(const float* _buffer, int _size, int _i) {
+    if (_i < 2 || _i >= _size - 2)
+        return _buffer[_i];
+    const float core[] = {1.0 / 8.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 8.0};
+    float sum = 0;
+    for (int j = -2; j <= 2; j++) {
+        sum += core[j + 2] * _buffer[_i + j];
+    }
+    return sum;
+}
+
 int findLastMax(float* _buffer, int _size, int _cross) {
-    if (_cross == 0)
+    if (_cross <= 0 || _cross >= _size)
         return -1;
-    auto f = filterBuffer(_buffer, _size);
     float eps = 0.002;
     int left_pos = _cross;
-    // float delta_max = 1;
-    while (fabs(f[left_pos - 1] - f[left_pos]) > eps) {
+    float right = filteredAt(_buffer, _size, left_pos);
+    float left = filteredAt(_buffer, _size, left_pos - 1);
+    while (fabs(left - right) > eps) {
         left_pos--;
         if (left_pos == 0) {
-            delete f;
             return -1;
         }
+        right = left;
+        left = filteredAt(_buffer, _size, left_pos - 1);
     }
-    delete f;
     return left_pos;
 }
 
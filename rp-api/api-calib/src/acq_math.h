@@ -4,6 +4,28 @@
 
 namespace rp_calib {
 
+// Statistics of a buffer, taken in one pass
+struct BufferStats {
+    float min = 0;
+    float max = 0;
+    double sum = 0;
+    double sum_sq = 0;
+    double sum_abs = 0;
+};
+
+struct BufferStatsRaw {
+    int16_t min = 0;
+    int16_t max = 0;
+    int64_t sum = 0;
+};
+
+auto bufferStats(const float* _buffer, uint32_t _size) -> BufferStats;
+auto bufferStatsRaw(const int16_t* _buffer, uint32_t _size) -> BufferStatsRaw;
+// _acc[i] += _buffer[i], sums the captures of an averaged acquisition
+auto accumulate(float* _acc, const float* _buffer, uint32_t _size) -> void;
+auto accumulate(float* _acc, const int16_t* _buffer, uint32_t _size) -> void;
+auto scale(float* _buffer, uint32_t _size, float _factor) -> void;
+
 // auto convertCnts(int16_t cnts) -> int16_t;
 auto calcCountCrossZero(float* _buffer, int _size) -> std::vector<int>;
 auto findLastMax(float* _buffer, int _size, int _cross) -> int;
@@ -1,4 +1,5 @@
 #include "filter_logic.h"
+#include <math.h>
 #include <iostream>
 
 #define GAIN_LO_FILT_AA 0x7D93
@@ -12,18 +13,11 @@
 
 #define PERCENT_RANGE 20.0
 #define PERCENT_MIN 0.001
-#define MIN_AA GAIN_LO_FILT_AA * (1.0 - PERCENT_RANGE / 100.0)
-#define MAX_AA GAIN_LO_FILT_AA * (1.0 + PERCENT_RANGE / 100.0)
-#define MIN_BB GAIN_LO_FILT_BB * (1.0 - PERCENT_RANGE / 100.0)
-#define MAX_BB GAIN_LO_FILT_BB * (1.0 + PERCENT_RANGE / 100.0)
-#define MIN_AA_HI GAIN_HI_FILT_AA * (1.0 - PERCENT_RANGE / 100.0)
-#define MAX_AA_HI GAIN_HI_FILT_AA * (1.0 + PERCENT_RANGE / 100.0)
-#define MIN_BB_HI GAIN_HI_FILT_BB * (1.0 - PERCENT_RANGE / 100.0)
-#define MAX_BB_HI GAIN_HI_FILT_BB * (1.0 + PERCENT_RANGE / 100.0)
 #define MIN_PP 0
 #define MAX_PP 0x50000
-#define STEPS_AA 2
-#define STEPS_BB STEPS_AA
+// Grid shrink factor of a round, when the fitted minimum lies inside the grid and when it does not
+#define SHRINK_INSIDE 4.0
+#define SHRINK_OUTSIDE 2.0
 
 namespace rp_calib {
 
@@ -31,17 +25,42 @@ CFilter_logic::Ptr CFilter_logic::Create(CCalibMan::Ptr _calib_man) {
     return std::make_shared<CFilter_logic>(_calib_man);
 }
 
+double score(const CFilter_logic::GridItem& i) {
+    return i.value_raw * i.value_raw + i.deviationFromAVG * i.deviationFromAVG;
+}
+
+// Measured points first, best score first
 bool compare(CFilter_logic::GridItem i1, CFilter_logic::GridItem i2) {
-    return ((i1.value_raw * i1.value_raw + i1.deviationFromAVG * i1.deviationFromAVG) < (i2.value_raw * i2.value_raw + i2.deviationFromAVG * i2.deviationFromAVG));
-    //    return ((i1.value  * i1.value + i1.deviationFromAVG * i1.deviationFromAVG) < (i2.value  * i2.value + i2.deviationFromAVG * i2.deviationFromAVG));
+    if (i1.calculate != i2.calculate)
+        return i1.calculate;
+    return score(i1) < score(i2);
 }
 
-bool IsContain(std::vector<CFilter_logic::GridItem>& _list, CFilter_logic::GridItem i1) {
-    for (size_t i = 0; i < _list.size(); i++) {
-        if (_list[i].aa == i1.aa && _list[i].bb == i1.bb)
-            return true;
+// Solves _a * x = _b in place by Gaussian elimination with partial pivoting
+bool solve(double _a[6][6], double _b[6], int _n) {
+    for (int c = 0; c < _n; c++) {
+        int p = c;
+        for (int r = c + 1; r < _n; r++) {
+            if (fabs(_a[r][c]) > fabs(_a[p][c]))
+                p = r;
+        }
+        if (fabs(_a[p][c]) < 1e-12)
+            return false;
+        std::swap(_a[c], _a[p]);
+        std::swap(_b[c], _b[p]);
+        for (int r = c + 1; r < _n; r++) {
+            double k = _a[r][c] / _a[c][c];
+            for (int i = c; i < _n; i++)
+                _a[r][i] -= k * _a[c][i];
+            _b[r] -= k * _b[c];
+        }
+    }
+    for (int c = _n - 1; c >= 0; c--) {
+        for (int i = c + 1; i < _n; i++)
+            _b[c] -= _a[c][i] * _b[i];
+        _b[c] /= _a[c][c];
     }
-    return false;
+    return true;
 }
 
 CFilter_logic::CFilter_logic(CCalibMan::Ptr _calib_man) : m_calib_man(_calib_man) {
@@ -52,6 +71,10 @@ CFilter_logic::CFilter_logic(CCalibMan::Ptr _calib_man) : m_calib_man(_calib_man
     m_calibRef = 0.9;
     m_calibMode = 0;
     m_grid.clear();
+    m_centerAA = GAIN_LO_FILT_AA;
+    m_centerBB = GAIN_LO_FILT_BB;
+    m_percentEnd = PERCENT_MIN;
+    m_hasGood = false;
 }
 
 void CFilter_logic::init(rp_channel_t _ch) {
@@ -60,28 +83,32 @@ void CFilter_logic::init(rp_channel_t _ch) {
     m_percent = PERCENT_RANGE;
     m_calibAmpl = 0x1000;
     m_oldcalibAmpl = -1;
-    m_grid.clear();
-    auto min_a = MIN_AA;
-    auto max_a = MAX_AA;
-    auto min_b = MIN_BB;
-    auto max_b = MAX_BB;
-
+    m_hasGood = false;
+    m_centerAA = GAIN_LO_FILT_AA;
+    m_centerBB = GAIN_LO_FILT_BB;
     if (m_calib_man->getModeLV_HV() == RP_HIGH) {
-        min_a = MIN_AA_HI;
-        max_a = MAX_AA_HI;
-        min_b = MIN_BB_HI;
-        max_b = MAX_BB_HI;
+        m_centerAA = GAIN_HI_FILT_AA;
+        m_centerBB = GAIN_HI_FILT_BB;
     }
-    for (int i = min_a; i <= max_a; i += (max_a - min_a) / STEPS_AA) {
-        for (int j = min_b; j <= max_b; j += (max_b - min_b) / STEPS_BB) {
+    // Finer grids than one count of the smaller coefficient measure the same points again
+    m_percentEnd = std::max(PERCENT_MIN, 100.0 / std::min(m_centerAA, m_centerBB));
+    makeGrid();
+}
+
+void CFilter_logic::makeGrid() {
+    m_grid.clear();
+    for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
             GridItem item;
-            item.aa = i;
-            item.bb = j;
+            item.aa = lround(m_centerAA * (1.0 + i * m_percent / 100.0));
+            item.bb = lround(m_centerBB * (1.0 + j * m_percent / 100.0));
             item.value = 0;
             item.value_raw = 0;
             item.calculate = false;
-            item.ch = _ch;
+            item.ch = m_channel;
             item.deviationFromAVG = 0;
+            item.lastValue = 0;
+            item.lastDeviation = 0;
             item.index = m_index++;
             m_grid.push_back(item);
         }
@@ -126,7 +153,8 @@ int CFilter_logic::setCalibParameters() {
 }
 
 void CFilter_logic::setGoodCalibParameter() {
-    sort();
+    if (!m_hasGood)
+        return;
     m_calib_man->setCalibValue(m_lastGood.ch, F_AA_CH, m_lastGood.aa);
     m_calib_man->setCalibValue(m_lastGood.ch, F_BB_CH, m_lastGood.bb);
     m_calib_man->updateCalib(m_lastGood.ch);
@@ -163,65 +191,60 @@ int CFilter_logic::setCalculatedValue(COscilloscope::DataPassAutoFilter item) {
     return -1;
 }
 
-void CFilter_logic::removeHalfCalib() {
+void CFilter_logic::fitGrid() {
     sort();
-    m_grid.erase(m_grid.end() - m_grid.size() / 3.0, m_grid.end());
-    if (m_grid.size() > 0)
-        m_lastGood = m_grid[0];
-}
+    std::vector<GridItem> measured;
+    for (auto& item : m_grid) {
+        if (item.calculate)
+            measured.push_back(item);
+    }
+    if (measured.empty()) {
+        m_percent /= SHRINK_OUTSIDE;
+        return;
+    }
+    if (!m_hasGood || compare(measured[0], m_lastGood)) {
+        m_lastGood = measured[0];
+        m_hasGood = true;
+    }
 
-CFilter_logic::GridItem GetNewItem(std::vector<CFilter_logic::GridItem> _list, int _index) {
-    std::vector<CFilter_logic::GridItem> new_grid;
-    for (size_t i = 0; i < _list.size(); i++) {
-        if (_list[i].index == _index) {
-            new_grid.push_back(_list[i]);
+    // Least squares fit of score = c0 + c1 x + c2 y + c3 x^2 + c4 x y + c5 y^2, where x and y are
+    // the offsets of AA and BB from the grid center in grid steps
+    double a[6][6] = {};
+    double b[6] = {};
+    for (auto& item : measured) {
+        double x = (item.aa / m_centerAA - 1.0) * 100.0 / m_percent;
+        double y = (item.bb / m_centerBB - 1.0) * 100.0 / m_percent;
+        double t[6] = {1, x, y, x * x, x * y, y * y};
+        for (int r = 0; r < 6; r++) {
+            for (int c = 0; c < 6; c++)
+                a[r][c] += t[r] * t[c];
+            b[r] += t[r] * score(item);
         }
     }
-    if (new_grid.size() > 0) {
-        std::sort(new_grid.begin(), new_grid.end(), compare);
-        return new_grid[0];
-    }
-    CFilter_logic::GridItem item;
-    item.index = -1;
-    return item;
-}
 
-std::vector<CFilter_logic::GridItem> Split(CFilter_logic::GridItem _item, double _step) {
-    std::vector<CFilter_logic::GridItem> new_grid;
-    if (_step == 0)
-        return new_grid;
-    for (double i = 1.0 - (_step / 100.0); i <= 1 + (_step / 100.0); i += (_step / 100.0))
-        for (double j = 1.0 - (_step / 100.0); j <= 1 + (_step / 100.0); j += (_step / 100.0)) {
-            CFilter_logic::GridItem new_item = _item;
-            new_item.calculate = false;
-            new_item.aa *= i;
-            new_item.bb *= j;
-            new_item.lastValue = new_item.value;
-            new_item.lastDeviation = new_item.deviationFromAVG;
-            if (!IsContain(new_grid, new_item))
-                new_grid.push_back(new_item);
+    // The minimum of a convex surface, otherwise the best measured point
+    double x = (measured[0].aa / m_centerAA - 1.0) * 100.0 / m_percent;
+    double y = (measured[0].bb / m_centerBB - 1.0) * 100.0 / m_percent;
+    bool inside = false;
+    if (measured.size() >= 6 && solve(a, b, 6)) {
+        double det = 4 * b[3] * b[5] - b[4] * b[4];
+        if (b[3] > 0 && det > 0) {
+            double fx = (-2 * b[5] * b[1] + b[4] * b[2]) / det;
+            double fy = (-2 * b[3] * b[2] + b[4] * b[1]) / det;
+            inside = fabs(fx) <= 1 && fabs(fy) <= 1;
+            x = std::clamp(fx, -1.0, 1.0);
+            y = std::clamp(fy, -1.0, 1.0);
         }
-    return new_grid;
+    }
+    m_centerAA *= 1.0 + x * m_percent / 100.0;
+    m_centerBB *= 1.0 + y * m_percent / 100.0;
+    m_percent /= inside ? SHRINK_INSIDE : SHRINK_OUTSIDE;
 }
 
+// A finished channel keeps measuring a grid, so the channels of CFilter_logicNch stay in step
 int CFilter_logic::nextSetupCalibParameters() {
-    if (m_percent < PERCENT_MIN)
-        return -1;
-    std::vector<GridItem> new_grid;
-    std::vector<int64_t> index_list;
-    for (size_t i = 0; i < m_grid.size(); i++) {
-        if (std::find(index_list.begin(), index_list.end(), m_grid[i].index) == index_list.end()) {
-            index_list.push_back(m_grid[i].index);
-        }
-    }
-    m_percent /= STEPS_BB;
-    for (size_t i = 0; i < index_list.size(); i++) {
-        auto item = GetNewItem(m_grid, index_list[i]);
-        auto split_grid = Split(item, m_percent);
-        new_grid.insert(new_grid.end(), split_grid.begin(), split_grid.end());
-    }
-    m_grid = new_grid;
-    return m_percent < PERCENT_MIN ? -1 : 0;
+    makeGrid();
+    return m_percent < m_percentEnd ? -1 : 0;
 }
 
 void CFilter_logic::sort() {
@@ -229,16 +252,7 @@ void CFilter_logic::sort() {
 }
 
 int CFilter_logic::calcProgress() {
-    double p = PERCENT_RANGE;
-    double cur = 0;
-    double max_range = 0;
-    while (p >= PERCENT_MIN) {
-        max_range++;
-        p /= STEPS_BB;
-        if (p >= m_percent)
-            cur++;
-    }
-    auto progress = cur / max_range * 100.0;
+    double progress = log(PERCENT_RANGE / m_percent) / log(PERCENT_RANGE / m_percentEnd) * 100.0;
     if (progress < 0)
         progress = 0;
     if (progress > 100)
@@ -71,10 +71,10 @@ int CFilter_logicNch::getCalibDone() {
     return count;
 }
 
-void CFilter_logicNch::removeHalfCalib() {
+void CFilter_logicNch::fitGrid() {
     auto channels = getADCChannels();
     for (auto i = 0u; i < channels; i++) {
-        m_fl[i]->removeHalfCalib();
+        m_fl[i]->fitGrid();
     }
 }
 
@@ -15,16 +15,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <array>
+#include <condition_variable>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <new>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
 #include "rp_dsp.h"
 #include "rp_log.h"
 
-#include "kiss_fftr.h"
+#include "rp_fft.h"
 
 #include "rp_math.h"
 
@@ -59,8 +63,91 @@ constexpr double g_w2mw = 1000;
 #define RP_FLATTOP_A3 0.083578947
 #define RP_FLATTOP_A4 0.006947368
 
+#define DSP_PARALLEL_MIN_LENGTH 4096  // Shorter signals are processed on the calling thread only
+
 using namespace rp_dsp_api;
 
+namespace {
+
+// Persistent helper threads. run() calls fn(0) on the calling thread and fn(1) .. fn(threads - 1)
+// on the helpers, and returns when all of them are done.
+class CChannelPool {
+
+   public:
+    explicit CChannelPool(uint32_t threads) {
+        for (uint32_t slot = 1; slot < threads; slot++) {
+            m_threads.emplace_back(&CChannelPool::loop, this, slot);
+        }
+    }
+
+    ~CChannelPool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    auto getThreads() -> uint32_t { return m_threads.size() + 1; }
+
+    auto run(const std::function<void(uint32_t)>& fn) -> void {
+        {
+            std::lock_guard lock(m_mutex);
+            m_fn = &fn;
+            m_pending = m_threads.size();
+            m_generation++;
+        }
+        m_start.notify_all();
+        fn(0);
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_fn = NULL;
+    }
+
+   private:
+    auto loop(uint32_t slot) -> void {
+        uint64_t generation = 0;
+        while (true) {
+            const std::function<void(uint32_t)>* fn = NULL;
+            {
+                std::unique_lock lock(m_mutex);
+                m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+                if (m_stop)
+                    return;
+                generation = m_generation;
+                fn = m_fn;
+            }
+            (*fn)(slot);
+            {
+                std::lock_guard lock(m_mutex);
+                m_pending--;
+            }
+            m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(uint32_t)>* m_fn = NULL;
+    uint64_t m_generation = 0;
+    uint32_t m_pending = 0;
+    bool m_stop = false;
+};
+
+// Enabled channels and their probe attenuation, copied under the channel lock at the start of each step
+struct channel_list_t {
+    std::array<uint8_t, 256> index;
+    std::array<uint32_t, 256> probe;
+    uint32_t count = 0;
+};
+
+}  // namespace
+
 auto __zeroethOrderBessel(double x) -> double {
     const double eps = 0.000001;
     double Value = 0;
@@ -85,15 +172,59 @@ struct CDSP::Impl {
     window_mode_t m_window_mode = HANNING;
     std::vector<cdsp_data_t> m_window;
     bool m_remove_DC = true;
-    std::vector<kiss_fft_cpx>* m_kiss_fft_out = NULL;
-    kiss_fftr_cfg m_kiss_fft_cfg = NULL;
-    size_t m_kiss_fft_cfg_max_size = 0;
+    std::vector<kiss_fft_cpx>* m_fft_out = NULL;
+    // One set of backends per thread, they keep their scratch buffers in the instance
+    std::array<CFFTBackend*, DSP_MAX_THREADS> m_fft_kiss = {};
+    std::array<CFFTBackend*, DSP_MAX_THREADS> m_fft_neon = {};
+    std::array<CFFTBackend*, DSP_MAX_THREADS> m_fft = {};  // Initialized backends used by fft()
+#ifdef ARCH_ARM
+    fft_backend_t m_fft_backend = FFT_NEON;
+#else
+    fft_backend_t m_fft_backend = FFT_KISS;
+#endif
+    uint8_t m_threads = DSP_DEFAULT_THREADS;
+    CChannelPool* m_pool = NULL;
     std::mutex m_channelMutex;
     std::map<uint8_t, bool> m_channelState;
     std::map<uint8_t, uint32_t> m_channelProbe;
     data_t* m_data = NULL;
+
+    auto enabledChannels() -> channel_list_t;
+    auto forEachChannel(const channel_list_t& list, uint32_t length, const std::function<void(uint32_t slot, uint32_t begin, uint32_t end)>& fn) -> void;
 };
 
+auto CDSP::Impl::enabledChannels() -> channel_list_t {
+    std::lock_guard lock(m_channelMutex);
+    channel_list_t list;
+    for (uint32_t ch = 0; ch < m_max_channels; ch++) {
+        if (!m_channelState[ch])
+            continue;
+        list.index[list.count] = ch;
+        list.probe[list.count] = m_channelProbe[ch];
+        list.count++;
+    }
+    return list;
+}
+
+// Splits the channels of list into contiguous ranges, one per thread. fn(slot, begin, end) processes
+// list.index[begin] .. list.index[end - 1] and may use the scratch buffers of slot.
+auto CDSP::Impl::forEachChannel(const channel_list_t& list, uint32_t length, const std::function<void(uint32_t slot, uint32_t begin, uint32_t end)>& fn) -> void {
+    uint32_t threads = std::min<uint32_t>(m_threads, list.count);
+    if (threads < 2 || length < DSP_PARALLEL_MIN_LENGTH) {
+        fn(0, 0, list.count);
+        return;
+    }
+    if (!m_pool || m_pool->getThreads() != m_threads) {
+        delete m_pool;
+        m_pool = new CChannelPool(m_threads);
+    }
+    m_pool->run([&](uint32_t slot) {
+        if (slot < threads) {
+            fn(slot, slot * list.count / threads, (slot + 1) * list.count / threads);
+        }
+    });
+}
+
 CDSP::CDSP(uint8_t max_channels, uint32_t max_adc_buffer, uint32_t adc_max_speed, bool createStoredData) {
     m_pimpl = new Impl();
     m_pimpl->m_max_adc_buffer_size = max_adc_buffer;
@@ -104,13 +235,12 @@ CDSP::CDSP(uint8_t max_channels, uint32_t max_adc_buffer, uint32_t adc_max_speed
     m_pimpl->m_window_sum = 1;
     m_pimpl->m_window_mode = HANNING;
     m_pimpl->m_remove_DC = true;
-    m_pimpl->m_kiss_fft_cfg = NULL;
-    m_pimpl->m_kiss_fft_out = new std::vector<kiss_fft_cpx>[max_channels];
+    m_pimpl->m_fft_out = new std::vector<kiss_fft_cpx>[max_channels];
 
     for (uint8_t i = 0; i < max_channels; i++) {
         m_pimpl->m_channelState[i] = true;
         m_pimpl->m_channelProbe[i] = 1;
-        m_pimpl->m_kiss_fft_out[i].reserve(max_adc_buffer);
+        m_pimpl->m_fft_out[i].reserve(max_adc_buffer);
     }
 
     m_pimpl->m_window.reserve(max_adc_buffer);
@@ -118,26 +248,23 @@ CDSP::CDSP(uint8_t max_channels, uint32_t max_adc_buffer, uint32_t adc_max_speed
         m_pimpl->m_data = createData();
     }
 
-    kiss_fftr_alloc(max_adc_buffer, 0, NULL, &m_pimpl->m_kiss_fft_cfg_max_size);  // precalculate memory
-    if (m_pimpl->m_kiss_fft_cfg_max_size != 0) {
-        uint8_t* memory = new uint8_t[m_pimpl->m_kiss_fft_cfg_max_size];
-        m_pimpl->m_kiss_fft_cfg = kiss_fftr_alloc(max_adc_buffer, 0, (void*)memory, &m_pimpl->m_kiss_fft_cfg_max_size);
-    }
+    fftInit();
 }
 
 CDSP::~CDSP() {
-    if (m_pimpl->m_kiss_fft_out) {
-        delete[] m_pimpl->m_kiss_fft_out;
-        m_pimpl->m_kiss_fft_out = NULL;
+    if (m_pimpl->m_fft_out) {
+        delete[] m_pimpl->m_fft_out;
+        m_pimpl->m_fft_out = NULL;
     }
 
-    kiss_fft_cleanup();
-
-    if (m_pimpl->m_kiss_fft_cfg) {
-        delete[] (uint8_t*)m_pimpl->m_kiss_fft_cfg;
-        m_pimpl->m_kiss_fft_cfg = NULL;
+    delete m_pimpl->m_pool;
+    for (uint32_t slot = 0; slot < DSP_MAX_THREADS; slot++) {
+        delete m_pimpl->m_fft_kiss[slot];
+        delete m_pimpl->m_fft_neon[slot];
     }
 
+    kiss_fft_cleanup();
+
     delete m_pimpl;
 }
 
@@ -209,84 +336,70 @@ auto CDSP::getSignalMaxLength() -> uint32_t {
     return m_pimpl->m_max_adc_buffer_size;
 }
 
-int CDSP::window_init(window_mode_t mode) {
+auto rp_dsp_api::createWindow(window_mode_t mode, uint32_t len, cdsp_data_t* window, double* sum) -> int {
     uint32_t i;
-    m_pimpl->m_window_sum = 0;
-    m_pimpl->m_window_mode = mode;
-
-    try {
-        auto size = getSignalMaxLength();
-        m_pimpl->m_window.resize(size);
-        if (m_pimpl->m_window.size() != size) {
-            ERROR_LOG("Can not allocate memory");
-            return -1;
-        }
-    } catch (const std::bad_alloc& e) {
-        ERROR_LOG("Can not allocate memory");
-        return -1;
-    }
-
-    switch (m_pimpl->m_window_mode) {
+    *sum = 0;
+    switch (mode) {
         case HANNING: {
-            for (i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_SPECTR_HANN_AMP * (1 - cos(2 * M_PI * i / (double)(getSignalLength() - 1)));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for (i = 0; i < len; i++) {
+                window[i] = RP_SPECTR_HANN_AMP * (1 - cos(2 * M_PI * i / (double)(len - 1)));
+                *sum += window[i];
             }
             break;
         }
         case RECTANGULAR: {
-            for (i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = 1;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for (i = 0; i < len; i++) {
+                window[i] = 1;
+                *sum += window[i];
             }
             break;
         }
         case HAMMING: {
-            for (i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / (double)(getSignalLength() - 1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for (i = 0; i < len; i++) {
+                window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / (double)(len - 1));
+                *sum += window[i];
             }
             break;
         }
         case BLACKMAN_HARRIS: {
-            for (i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_BLACKMAN_A0 - RP_BLACKMAN_A1 * cos(2 * M_PI * i / (double)(getSignalLength() - 1)) +
-                                       RP_BLACKMAN_A2 * cos(4 * M_PI * i / (double)(getSignalLength() - 1)) - RP_BLACKMAN_A3 * cos(6 * M_PI * i / (double)(getSignalLength() - 1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for (i = 0; i < len; i++) {
+                window[i] = RP_BLACKMAN_A0 - RP_BLACKMAN_A1 * cos(2 * M_PI * i / (double)(len - 1)) +
+                            RP_BLACKMAN_A2 * cos(4 * M_PI * i / (double)(len - 1)) - RP_BLACKMAN_A3 * cos(6 * M_PI * i / (double)(len - 1));
+                *sum += window[i];
             }
             break;
         }
         case FLAT_TOP: {
-            for (i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_FLATTOP_A0 - RP_FLATTOP_A1 * cos(2 * M_PI * i / (double)(getSignalLength() - 1)) +
-                                       RP_FLATTOP_A2 * cos(4 * M_PI * i / (double)(getSignalLength() - 1)) - RP_FLATTOP_A3 * cos(6 * M_PI * i / (double)(getSignalLength() - 1)) +
-                                       RP_FLATTOP_A4 * cos(8 * M_PI * i / (double)(getSignalLength() - 1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for (i = 0; i < len; i++) {
+                window[i] = RP_FLATTOP_A0 - RP_FLATTOP_A1 * cos(2 * M_PI * i / (double)(len - 1)) +
+                            RP_FLATTOP_A2 * cos(4 * M_PI * i / (double)(len - 1)) - RP_FLATTOP_A3 * cos(6 * M_PI * i / (double)(len - 1)) +
+                            RP_FLATTOP_A4 * cos(8 * M_PI * i / (double)(len - 1));
+                *sum += window[i];
             }
             break;
         }
         case KAISER_4: {
             const double x = 1.0 / __zeroethOrderBessel(4);
-            const double y = (getSignalLength() - 1) / 2.0;
+            const double y = (len - 1) / 2.0;
 
-            for (i = 0; i < getSignalLength(); i++) {
+            for (i = 0; i < len; i++) {
                 const double K = (i - y) / y;
                 const double arg = sqrt(1.0 - (K * K));
-                m_pimpl->m_window[i] = __zeroethOrderBessel(4 * arg) * x;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+                window[i] = __zeroethOrderBessel(4 * arg) * x;
+                *sum += window[i];
             }
             break;
         }
 
         case KAISER_8: {
             const double x = 1.0 / __zeroethOrderBessel(8);
-            const double y = (getSignalLength() - 1) / 2.0;
+            const double y = (len - 1) / 2.0;
 
-            for (i = 0; i < getSignalLength(); i++) {
+            for (i = 0; i < len; i++) {
                 const double K = (i - y) / y;
                 const double arg = sqrt(1.0 - (K * K));
-                m_pimpl->m_window[i] = __zeroethOrderBessel(8 * arg) * x;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+                window[i] = __zeroethOrderBessel(8 * arg) * x;
+                *sum += window[i];
             }
             break;
         }
@@ -296,6 +409,28 @@ int CDSP::window_init(window_mode_t mode) {
     return 0;
 }
 
+int CDSP::window_init(window_mode_t mode) {
+    m_pimpl->m_window_sum = 0;
+    m_pimpl->m_window_mode = mode;
+
+    try {
+        auto size = getSignalMaxLength();
+        m_pimpl->m_window.resize(size);
+        if (m_pimpl->m_window.size() != size) {
+            ERROR_LOG("Can not allocate memory");
+            return -1;
+        }
+    } catch (const std::bad_alloc& e) {
+        ERROR_LOG("Can not allocate memory");
+        return -1;
+    }
+    return createWindow(mode, getSignalLength(), m_pimpl->m_window.data(), &m_pimpl->m_window_sum);
+}
+
+auto CDSP::getWindowSum() -> double {
+    return m_pimpl->m_window_sum;
+}
+
 auto CDSP::remoteDCCount() -> uint8_t {
     switch (m_pimpl->m_window_mode) {
         case HANNING: {
@@ -340,13 +475,28 @@ auto CDSP::getRemoveDC() -> bool {
 }
 
 auto CDSP::setProbe(uint8_t channel, uint32_t value) -> void {
+    std::lock_guard lock(m_pimpl->m_channelMutex);
     m_pimpl->m_channelProbe[channel] = value;
 }
 
 auto CDSP::getProbe(uint8_t channel, uint32_t* value) -> void {
+    std::lock_guard lock(m_pimpl->m_channelMutex);
     *value = m_pimpl->m_channelProbe[channel];
 }
 
+auto CDSP::setThreads(uint8_t count) -> int {
+    if (count < 1 || count > DSP_MAX_THREADS) {
+        ERROR_LOG("Wrong thread count %d", count);
+        return -1;
+    }
+    m_pimpl->m_threads = count;
+    return fftInit();
+}
+
+auto CDSP::getThreads() -> uint8_t {
+    return m_pimpl->m_threads;
+}
+
 auto CDSP::prepareFreqVector(data_t* data, double f_s, float decimation) -> int {
     if (!data) {
         ERROR_LOG("Data not initialized");
@@ -379,41 +529,72 @@ auto CDSP::windowFilter(data_t* data) -> int {
         ERROR_LOG("Data not initialized");
         return -1;
     }
-    for (uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-        if (!m_pimpl->m_channelState[j])
-            continue;
-        // for (i = 0; i < getSignalLength(); i++) {
-        //     data->m_filtred[j][i] = data->m_in[j][i] * m_pimpl->m_window[i] * m_pimpl->m_channelProbe[j];
-        // }
-
-        if constexpr (std::is_same_v<cdsp_data_t, float>) {
-            multiply_arrays_float_neon(data->m_filtred[j].data(), data->m_in[j].data(), m_pimpl->m_window.data(), getSignalLength());
-            multiply_array_by_scalar_float_neon(data->m_filtred[j].data(), data->m_filtred[j].data(), m_pimpl->m_channelProbe[j], getSignalLength());
-        } else if constexpr (std::is_same_v<cdsp_data_t, double>) {
-            // Cast to the expected type if your data structures can handle it
-            multiply_arrays_double_neon(reinterpret_cast<double*>(data->m_filtred[j].data()),
-                                        reinterpret_cast<const double*>(data->m_in[j].data()),
-                                        reinterpret_cast<const double*>(m_pimpl->m_window.data()),
-                                        getSignalLength());
-            multiply_array_by_scalar_double_neon(reinterpret_cast<double*>(data->m_filtred[j].data()),
-                                                 reinterpret_cast<double*>(data->m_filtred[j].data()),
-                                                 static_cast<double>(m_pimpl->m_channelProbe[j]),
-                                                 getSignalLength());
+    auto channels = m_pimpl->enabledChannels();
+    auto len = getSignalLength();
+    m_pimpl->forEachChannel(channels, len, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t n = begin; n < end; n++) {
+            auto j = channels.index[n];
+            // for (i = 0; i < getSignalLength(); i++) {
+            //     data->m_filtred[j][i] = data->m_in[j][i] * m_pimpl->m_window[i] * m_pimpl->m_channelProbe[j];
+            // }
+
+            if constexpr (std::is_same_v<cdsp_data_t, float>) {
+                multiply_arrays_float_neon(data->m_filtred[j].data(), data->m_in[j].data(), m_pimpl->m_window.data(), len);
+                multiply_array_by_scalar_float_neon(data->m_filtred[j].data(), data->m_filtred[j].data(), channels.probe[n], len);
+            } else if constexpr (std::is_same_v<cdsp_data_t, double>) {
+                // Cast to the expected type if your data structures can handle it
+                multiply_arrays_double_neon(reinterpret_cast<double*>(data->m_filtred[j].data()),
+                                            reinterpret_cast<const double*>(data->m_in[j].data()),
+                                            reinterpret_cast<const double*>(m_pimpl->m_window.data()),
+                                            len);
+                multiply_array_by_scalar_double_neon(reinterpret_cast<double*>(data->m_filtred[j].data()),
+                                                     reinterpret_cast<double*>(data->m_filtred[j].data()),
+                                                     static_cast<double>(channels.probe[n]),
+                                                     len);
+            }
         }
-    }
+    });
     data->m_is_data_filtred = true;
     return 0;
 }
 
+auto CDSP::setFFTBackend(fft_backend_t backend) -> int {
+    if (backend != FFT_KISS && backend != FFT_NEON) {
+        ERROR_LOG("Unknown FFT backend %d", backend);
+        return -1;
+    }
+    m_pimpl->m_fft_backend = backend;
+    return fftInit();
+}
+
+auto CDSP::getFFTBackend() -> fft_backend_t {
+    return m_pimpl->m_fft[0] ? m_pimpl->m_fft[0]->getType() : FFT_KISS;
+}
+
 auto CDSP::fftInit() -> int {
     auto sigLen = getSignalLength();
 
     for (uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-        m_pimpl->m_kiss_fft_out[j].resize(sigLen);
+        m_pimpl->m_fft_out[j].resize(sigLen);
     }
 
-    size_t size = m_pimpl->m_kiss_fft_cfg_max_size;
-    m_pimpl->m_kiss_fft_cfg = kiss_fftr_alloc(sigLen, 0, m_pimpl->m_kiss_fft_cfg, &size);
+    // kiss_fftr stays available as the fallback for sizes the selected backend does not support
+    auto type = m_pimpl->m_fft_backend == FFT_NEON && CFFTBackend::isSupported(FFT_NEON, sigLen) ? FFT_NEON : FFT_KISS;
+    for (uint32_t slot = 0; slot < DSP_MAX_THREADS; slot++) {
+        m_pimpl->m_fft[slot] = NULL;
+        if (slot >= m_pimpl->m_threads)
+            continue;
+        auto& backend = type == FFT_NEON ? m_pimpl->m_fft_neon[slot] : m_pimpl->m_fft_kiss[slot];
+        if (!backend) {
+            backend = CFFTBackend::create(type, m_pimpl->m_max_adc_buffer_size, m_pimpl->m_max_channels);
+        }
+        if (!backend || backend->init(sigLen)) {
+            ERROR_LOG("Can't initialize FFT for size %d", sigLen);
+            m_pimpl->m_fft.fill(NULL);
+            return -1;
+        }
+        m_pimpl->m_fft[slot] = backend;
+    }
     return 0;
 }
 
@@ -460,28 +641,42 @@ auto CDSP::fft(data_t* data) -> int {
         return -1;
     }
 
-    if (!m_pimpl->m_kiss_fft_out || !m_pimpl->m_kiss_fft_cfg) {
-        ERROR_LOG("rp_spect_fft not initialized");
-        return -1;
+    for (uint32_t slot = 0; slot < m_pimpl->m_threads; slot++) {
+        if (!m_pimpl->m_fft_out || !m_pimpl->m_fft[slot] || m_pimpl->m_fft[slot]->getSize() != getSignalLength()) {
+            ERROR_LOG("rp_spect_fft not initialized");
+            return -1;
+        }
     }
     auto& _in = data->m_is_data_filtred ? data->m_filtred : data->m_in;
-    for (uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-        if (!m_pimpl->m_channelState[j])
-            continue;
-        kiss_fftr(m_pimpl->m_kiss_fft_cfg, (kiss_fft_scalar*)_in[j].data(), m_pimpl->m_kiss_fft_out[j].data());
-    }
-    for (uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-        if (!m_pimpl->m_channelState[j])
-            continue;
+    auto channels = m_pimpl->enabledChannels();
+    std::array<int, DSP_MAX_THREADS> result = {};
+    m_pimpl->forEachChannel(channels, getSignalLength(), [&](uint32_t slot, uint32_t begin, uint32_t end) {
+        // The channels of a thread are transformed in one call, so the backend can batch them
+        std::array<const float*, 256> in = {};
+        std::array<kiss_fft_cpx*, 256> out = {};
+        for (uint32_t n = begin; n < end; n++) {
+            in[n - begin] = _in[channels.index[n]].data();
+            out[n - begin] = m_pimpl->m_fft_out[channels.index[n]].data();
+        }
+        result[slot] = m_pimpl->m_fft[slot]->forward(in.data(), out.data(), end - begin);
+        if (result[slot])
+            return;
+        for (uint32_t n = begin; n < end; n++) {
+            auto j = channels.index[n];
 #ifdef ARCH_ARM
-        neonMagnitudeOptimized(getOutSignalLength(), m_pimpl->m_kiss_fft_out[j].data(), data->m_fft[j].data());
+            neonMagnitudeOptimized(getOutSignalLength(), m_pimpl->m_fft_out[j].data(), data->m_fft[j].data());
 #else
-        for (uint32_t i = 0; i < getOutSignalLength(); i++) {  // FFT limited to fs/2, specter of amplitudes
-            auto x = m_pimpl->m_kiss_fft_out[j][i].r * m_pimpl->m_kiss_fft_out[j][i].r;
-            auto y = m_pimpl->m_kiss_fft_out[j][i].i * m_pimpl->m_kiss_fft_out[j][i].i;
-            data->m_fft[j][i] = sqrtf(x + y);
-        }
+            for (uint32_t i = 0; i < getOutSignalLength(); i++) {  // FFT limited to fs/2, specter of amplitudes
+                auto x = m_pimpl->m_fft_out[j][i].r * m_pimpl->m_fft_out[j][i].r;
+                auto y = m_pimpl->m_fft_out[j][i].i * m_pimpl->m_fft_out[j][i].i;
+                data->m_fft[j][i] = sqrtf(x + y);
+            }
 #endif
+        }
+    });
+    for (auto res : result) {
+        if (res)
+            return -1;
     }
     return 0;
 }
@@ -490,15 +685,15 @@ int CDSP::getAmpAndPhase(data_t* _data, double _freq, double* _amp1, double* _ph
     float wsumf = 1.0 / (float)m_pimpl->m_window_sum * 2.0;
 
     auto amp = [&](int ch, int i) {
-        return sqrtf(pow(m_pimpl->m_kiss_fft_out[ch][i].r, 2) + pow(m_pimpl->m_kiss_fft_out[ch][i].i, 2)) * wsumf;
+        return sqrtf(pow(m_pimpl->m_fft_out[ch][i].r, 2) + pow(m_pimpl->m_fft_out[ch][i].i, 2)) * wsumf;
     };
 
     for (uint32_t i = 0; i < getOutSignalLength(); i++) {
         if (_data->m_converted.m_freq_vector[i] >= _freq) {
             *_amp1 = amp(0, i);
             *_amp2 = amp(1, i);
-            *_phase1 = atan2(m_pimpl->m_kiss_fft_out[0][i].i, m_pimpl->m_kiss_fft_out[0][i].r);
-            *_phase2 = atan2(m_pimpl->m_kiss_fft_out[1][i].i, m_pimpl->m_kiss_fft_out[1][i].r);
+            *_phase1 = atan2(m_pimpl->m_fft_out[0][i].i, m_pimpl->m_fft_out[0][i].r);
+            *_phase2 = atan2(m_pimpl->m_fft_out[1][i].i, m_pimpl->m_fft_out[1][i].r);
             return 0;
         }
     }
@@ -515,8 +710,6 @@ auto CDSP::decimate(data_t* data, uint32_t in_len, uint32_t out_len) -> int {
 }
 
 auto CDSP::decimate_ex(data_t* data, uint32_t in_len, uint32_t out_len) -> int {
-    std::lock_guard lock(m_pimpl->m_channelMutex);
-
     if (!data) {
         ERROR_LOG("Data not initialized");
         return -1;
@@ -533,94 +726,86 @@ auto CDSP::decimate_ex(data_t* data, uint32_t in_len, uint32_t out_len) -> int {
         return -1;
     }
 
-    for (uint32_t c = 0; c < m_pimpl->m_max_channels; c++) {
-        if (!m_pimpl->m_channelState[c])
-            continue;
-        auto& vec = data->m_dec_data_z[c];
-        std::fill(vec.begin(), vec.end(), 0.0f);
-        vec = data->m_dec_data_wsumf[c];
-        std::fill(vec.begin(), vec.end(), 0.0f);
-        vec = data->m_dec_data_scaled[c];
-        std::fill(vec.begin(), vec.end(), 0.0f);
-    }
-
-    for (uint32_t c = 0; c < m_pimpl->m_max_channels; c++) {
-        if (!m_pimpl->m_channelState[c])
-            continue;
-
-        auto& fft_channel = data->m_fft[c];
-        auto& converted_z = data->m_dec_data_z[c];
-        auto& converted_wsumf = data->m_dec_data_wsumf[c];
-        auto& converted_scaled = data->m_dec_data_scaled[c];
-
-        for (uint32_t i = 0, j = 0; i < out_len; i++, j += step) {
-            float sum_z = 0.0f;
-            float sum_fft_wsumf = 0.0f;
-            float sum_fft_scaled = 0.0f;
-
-            for (uint32_t k = j; k < j + step; k++) {
-                const float fft_wsumf = fft_channel[k] * wsumf;
-                const float fft_scaled = fft_wsumf * 0.707106781f;
+    auto channels = m_pimpl->enabledChannels();
+    m_pimpl->forEachChannel(channels, in_len, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t n = begin; n < end; n++) {
+            auto c = channels.index[n];
+            auto& fft_channel = data->m_fft[c];
+            auto& converted_z = data->m_dec_data_z[c];
+            auto& converted_wsumf = data->m_dec_data_wsumf[c];
+            auto& converted_scaled = data->m_dec_data_scaled[c];
 
-                sum_fft_wsumf += fft_wsumf;
-                sum_fft_scaled += fft_scaled;
-                sum_z += (fft_scaled * fft_scaled) * imp_reciprocal;
+            std::fill(converted_z.begin(), converted_z.end(), 0.0f);
+            std::fill(converted_wsumf.begin(), converted_wsumf.end(), 0.0f);
+            std::fill(converted_scaled.begin(), converted_scaled.end(), 0.0f);
+
+            for (uint32_t i = 0, j = 0; i < out_len; i++, j += step) {
+                float sum_z = 0.0f;
+                float sum_fft_wsumf = 0.0f;
+                float sum_fft_scaled = 0.0f;
+
+                for (uint32_t k = j; k < j + step; k++) {
+                    const float fft_wsumf = fft_channel[k] * wsumf;
+                    const float fft_scaled = fft_wsumf * 0.707106781f;
+
+                    sum_fft_wsumf += fft_wsumf;
+                    sum_fft_scaled += fft_scaled;
+                    sum_z += (fft_scaled * fft_scaled) * imp_reciprocal;
+                }
+                converted_z[i] = sum_z / step_f;
+                converted_wsumf[i] = sum_fft_wsumf / step_f;
+                converted_scaled[i] = sum_fft_scaled / step_f;
+
+                // converted_dbm[i] = sum_z / step_f;
+                // converted_mw[i] = sum_z / step_f;
+                // converted_dbw[i] = sum_z / step_f;
+                // converted_volt[i] = sum_fft_wsumf / step_f;
+                // converted_dbu[i] = sum_fft_scaled / step_f;
+                // converted_dbv[i] = sum_fft_scaled / step_f;
+                // converted_dbuV[i] = sum_fft_scaled / step_f;
             }
-            converted_z[i] = sum_z / step_f;
-            converted_wsumf[i] = sum_fft_wsumf / step_f;
-            converted_scaled[i] = sum_fft_scaled / step_f;
-
-            // converted_dbm[i] = sum_z / step_f;
-            // converted_mw[i] = sum_z / step_f;
-            // converted_dbw[i] = sum_z / step_f;
-            // converted_volt[i] = sum_fft_wsumf / step_f;
-            // converted_dbu[i] = sum_fft_scaled / step_f;
-            // converted_dbv[i] = sum_fft_scaled / step_f;
-            // converted_dbuV[i] = sum_fft_scaled / step_f;
         }
-    }
+    });
 
     return 0;
 }
 
 auto CDSP::decimate_disabled(data_t* data, uint32_t in_len) -> int {
-    std::lock_guard lock(m_pimpl->m_channelMutex);
-
     if (!data) {
         ERROR_LOG("Data not initialized");
         return -1;
     }
 
     const float wsumf = 2.0f / static_cast<float>(m_pimpl->m_window_sum);
+    const float imp_reciprocal = 1.0f / m_pimpl->m_imp;
 
-    for (uint32_t c = 0; c < m_pimpl->m_max_channels; c++) {
-        if (!m_pimpl->m_channelState[c])
-            continue;
-
-        auto& fft_data = data->m_fft[c];
-        auto& converted_z = data->m_dec_data_z[c];
-        auto& converted_wsumf = data->m_dec_data_wsumf[c];
-        auto& converted_scaled = data->m_dec_data_scaled[c];
-
-        const float imp_reciprocal = 1.0f / m_pimpl->m_imp;
-
-        for (uint32_t i = 0; i < in_len; i++) {
-            const cdsp_data_t fft_wsumf = fft_data[i] * wsumf;
-            const cdsp_data_t fft_scaled = fft_wsumf * 0.707106781f;
-            const cdsp_data_t z = (fft_scaled * fft_scaled) * imp_reciprocal;
-            // dbm_vec[i] = z;
-            // mw_vec[i] = z;
-            // dbw_vec[i] = z;
-            // volt_vec[i] = fft_wsumf;
-            // dbu_vec[i] = fft_scaled;
-            // dbv_vec[i] = fft_scaled;
-            // dbuV_vec[i] = fft_scaled;
+    auto channels = m_pimpl->enabledChannels();
+    m_pimpl->forEachChannel(channels, in_len, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t n = begin; n < end; n++) {
+            auto c = channels.index[n];
+            auto& fft_data = data->m_fft[c];
+            auto& converted_z = data->m_dec_data_z[c];
+            auto& converted_wsumf = data->m_dec_data_wsumf[c];
+            auto& converted_scaled = data->m_dec_data_scaled[c];
 
-            converted_z[i] = z;
-            converted_wsumf[i] = fft_wsumf;
-            converted_scaled[i] = fft_scaled;
+            for (uint32_t i = 0; i < in_len; i++) {
+                const cdsp_data_t fft_wsumf = fft_data[i] * wsumf;
+                const cdsp_data_t fft_scaled = fft_wsumf * 0.707106781f;
+                const cdsp_data_t z = (fft_scaled * fft_scaled) * imp_reciprocal;
+                // dbm_vec[i] = z;
+                // mw_vec[i] = z;
+                // dbw_vec[i] = z;
+                // volt_vec[i] = fft_wsumf;
+                // dbu_vec[i] = fft_scaled;
+                // dbv_vec[i] = fft_scaled;
+                // dbuV_vec[i] = fft_scaled;
+
+                converted_z[i] = z;
+                converted_wsumf[i] = fft_wsumf;
+                converted_scaled[i] = fft_scaled;
+            }
         }
-    }
+    });
 
     return 0;
 }
@@ -747,7 +932,6 @@ auto CDSP::decimate_disabled(data_t* data, uint32_t in_len) -> int {
 // }
 
 auto CDSP::cnvToMetric(data_t* data, uint32_t decimation, uint32_t minFreq, uint32_t maxFreq) -> int {
-    std::lock_guard lock(m_pimpl->m_channelMutex);
     if (!data) {
         ERROR_LOG("Data not initialized");
         return -1;
@@ -755,8 +939,6 @@ auto CDSP::cnvToMetric(data_t* data, uint32_t decimation, uint32_t minFreq, uint
 
     bool skipPeakRange = minFreq == 0 && maxFreq == 0;
 
-    cdsp_data_t max_pw[COUNT_DSP_MODE];
-    int max_pw_idx[COUNT_DSP_MODE];
     float freq_smpl = (float)m_pimpl->m_adc_max_speed / (float)decimation;
     float freq_const = freq_smpl / (2.0f * (float)getOutSignalLength());
     static auto logLim_10 = 10.f * log10f(LOG_LIMIT);
@@ -764,10 +946,16 @@ auto CDSP::cnvToMetric(data_t* data, uint32_t decimation, uint32_t minFreq, uint
     static auto LOG_0775 = log10f(0.775);
     static auto LOG_W2MW = log10f(g_w2mw);
 
-    auto isSkip = [skipPeakRange, freq_const, minFreq, maxFreq](uint32_t i) {
+    // A prepared frequency vector also describes zoomed spectra, which do not start at 0 Hz
+    bool useFreqVector = data->m_converted.m_data_size == getOutSignalLength();
+    auto binFreq = [data, useFreqVector, freq_const](uint32_t i) -> float {
+        return useFreqVector ? data->m_converted.m_freq_vector[i] : (float)i * freq_const;
+    };
+
+    auto isSkip = [skipPeakRange, &binFreq, minFreq, maxFreq](uint32_t i) {
         if (skipPeakRange)
             return false;
-        auto currentFreq = ((float)i * freq_const);
+        auto currentFreq = binFreq(i);
         if (currentFreq < minFreq || currentFreq > maxFreq)
             return true;
         return false;
@@ -784,99 +972,103 @@ auto CDSP::cnvToMetric(data_t* data, uint32_t decimation, uint32_t minFreq, uint
         }
     }
 
-    for (uint32_t c = 0; c < m_pimpl->m_max_channels; c++) {
-        if (!m_pimpl->m_channelState[c])
-            continue;
-
-        for (int mode = MIN_DSP_MODE; mode < COUNT_DSP_MODE; mode++) {
-            max_pw[mode] = std::numeric_limits<cdsp_data_t>::lowest();
-            max_pw_idx[mode] = 0;
-        }
-
-        for (uint32_t i = 0; i < getOutSignalLength(); i++) {
+    auto channels = m_pimpl->enabledChannels();
+    m_pimpl->forEachChannel(channels, getOutSignalLength(), [&](uint32_t, uint32_t begin, uint32_t end) {
+        cdsp_data_t max_pw[COUNT_DSP_MODE];
+        int max_pw_idx[COUNT_DSP_MODE];
+        for (uint32_t n = begin; n < end; n++) {
+            auto c = channels.index[n];
 
-            auto& converted_z = data->m_dec_data_z[c];
-            auto& converted_wsumf = data->m_dec_data_wsumf[c];
-            auto& converted_scaled = data->m_dec_data_scaled[c];
-
-            auto& dbm_vec_c = data->m_converted.m_result[DBM][c];
-            auto& mw_vec_c = data->m_converted.m_result[MW][c];
-            auto& dbw_vec_c = data->m_converted.m_result[DBW][c];
-            auto& volt_vec_c = data->m_converted.m_result[VOLT][c];
-            auto& dbu_vec_c = data->m_converted.m_result[DBU][c];
-            auto& dbv_vec_c = data->m_converted.m_result[DBV][c];
-            auto& dbuV_vec_c = data->m_converted.m_result[DBuV][c];
-
-            auto log_scaled_10 = log10f_neon(converted_scaled[i]);
-            auto log_converted_10 = log10f_neon(converted_z[i]);
-            auto need_skip = isSkip(i);
-            /* Conversion to power (Watts) */
-            auto ch_p = converted_z[i] * g_w2mw;
-            dbm_vec_c[i] = ch_p > LOG_LIMIT ? 10 * (log_converted_10 + LOG_W2MW) : logLim_10;  // W -> mW -> dBm
-
-            if (dbm_vec_c[i] >= max_pw[DBM] && !need_skip) {
-                max_pw[DBM] = dbm_vec_c[i];
-                max_pw_idx[DBM] = i;
+            for (int mode = MIN_DSP_MODE; mode < COUNT_DSP_MODE; mode++) {
+                max_pw[mode] = std::numeric_limits<cdsp_data_t>::lowest();
+                max_pw_idx[mode] = 0;
             }
 
-            volt_vec_c[i] = converted_wsumf[i];
-
-            if (volt_vec_c[i] >= max_pw[VOLT] && !need_skip) {
-                max_pw[VOLT] = volt_vec_c[i];
-                max_pw_idx[VOLT] = i;
+            for (uint32_t i = 0; i < getOutSignalLength(); i++) {
+
+                auto& converted_z = data->m_dec_data_z[c];
+                auto& converted_wsumf = data->m_dec_data_wsumf[c];
+                auto& converted_scaled = data->m_dec_data_scaled[c];
+
+                auto& dbm_vec_c = data->m_converted.m_result[DBM][c];
+                auto& mw_vec_c = data->m_converted.m_result[MW][c];
+                auto& dbw_vec_c = data->m_converted.m_result[DBW][c];
+                auto& volt_vec_c = data->m_converted.m_result[VOLT][c];
+                auto& dbu_vec_c = data->m_converted.m_result[DBU][c];
+                auto& dbv_vec_c = data->m_converted.m_result[DBV][c];
+                auto& dbuV_vec_c = data->m_converted.m_result[DBuV][c];
+
+                auto log_scaled_10 = log10f_neon(converted_scaled[i]);
+                auto log_converted_10 = log10f_neon(converted_z[i]);
+                auto need_skip = isSkip(i);
+                /* Conversion to power (Watts) */
+                auto ch_p = converted_z[i] * g_w2mw;
+                dbm_vec_c[i] = ch_p > LOG_LIMIT ? 10 * (log_converted_10 + LOG_W2MW) : logLim_10;  // W -> mW -> dBm
+
+                if (dbm_vec_c[i] >= max_pw[DBM] && !need_skip) {
+                    max_pw[DBM] = dbm_vec_c[i];
+                    max_pw_idx[DBM] = i;
+                }
+
+                volt_vec_c[i] = converted_wsumf[i];
+
+                if (volt_vec_c[i] >= max_pw[VOLT] && !need_skip) {
+                    max_pw[VOLT] = volt_vec_c[i];
+                    max_pw_idx[VOLT] = i;
+                }
+
+                // ( 20*log10( 0.686 / .775 ))
+                ch_p = converted_scaled[i] / 0.775;
+                // dbu_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) : logLim_20;  // W -> mW -> dBm
+                dbu_vec_c[i] = ch_p > LOG_LIMIT ? 20 * (log_scaled_10 - LOG_0775) : logLim_20;
+
+                if (dbu_vec_c[i] >= max_pw[DBU] && !need_skip) {
+                    max_pw[DBU] = dbu_vec_c[i];
+                    max_pw_idx[DBU] = i;
+                }
+
+                // ( 20*log10( RMS / 1.0 ))
+                ch_p = converted_scaled[i];
+                //dbv_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) : logLim_20;  // W -> mW -> dBm
+                dbv_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log_scaled_10 : logLim_20;
+
+                if (dbv_vec_c[i] >= max_pw[DBV] && !need_skip) {
+                    max_pw[DBV] = dbv_vec_c[i];
+                    max_pw_idx[DBV] = i;
+                }
+
+                // ( 20*log10( RMS / 1.0 )) + 120
+                // ch_p = converted_scaled[i];
+                // dbuV_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) + 120 : logLim_20 + 120;  // W -> mW -> dBm
+                dbuV_vec_c[i] = dbv_vec_c[i] + 120;
+                if (dbuV_vec_c[i] >= max_pw[DBuV] && !need_skip) {
+                    max_pw[DBuV] = dbuV_vec_c[i];
+                    max_pw_idx[DBuV] = i;
+                }
+
+                // W -> mW
+                ch_p = converted_z[i] * g_w2mw;
+                mw_vec_c[i] = ch_p;
+
+                if (mw_vec_c[i] >= max_pw[MW] && !need_skip) {
+                    max_pw[MW] = mw_vec_c[i];
+                    max_pw_idx[MW] = i;
+                }
+
+                ch_p = converted_z[i];
+                dbw_vec_c[i] = ch_p > LOG_LIMIT ? 10 * log_converted_10 : logLim_10;
+
+                if (dbw_vec_c[i] >= max_pw[DBW] && !need_skip) {
+                    max_pw[DBW] = dbw_vec_c[i];
+                    max_pw_idx[DBW] = i;
+                }
             }
-
-            // ( 20*log10( 0.686 / .775 ))
-            ch_p = converted_scaled[i] / 0.775;
-            // dbu_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) : logLim_20;  // W -> mW -> dBm
-            dbu_vec_c[i] = ch_p > LOG_LIMIT ? 20 * (log_scaled_10 - LOG_0775) : logLim_20;
-
-            if (dbu_vec_c[i] >= max_pw[DBU] && !need_skip) {
-                max_pw[DBU] = dbu_vec_c[i];
-                max_pw_idx[DBU] = i;
-            }
-
-            // ( 20*log10( RMS / 1.0 ))
-            ch_p = converted_scaled[i];
-            //dbv_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) : logLim_20;  // W -> mW -> dBm
-            dbv_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log_scaled_10 : logLim_20;
-
-            if (dbv_vec_c[i] >= max_pw[DBV] && !need_skip) {
-                max_pw[DBV] = dbv_vec_c[i];
-                max_pw_idx[DBV] = i;
-            }
-
-            // ( 20*log10( RMS / 1.0 )) + 120
-            // ch_p = converted_scaled[i];
-            // dbuV_vec_c[i] = ch_p > LOG_LIMIT ? 20 * log10f_neon(ch_p) + 120 : logLim_20 + 120;  // W -> mW -> dBm
-            dbuV_vec_c[i] = dbv_vec_c[i] + 120;
-            if (dbuV_vec_c[i] >= max_pw[DBuV] && !need_skip) {
-                max_pw[DBuV] = dbuV_vec_c[i];
-                max_pw_idx[DBuV] = i;
-            }
-
-            // W -> mW
-            ch_p = converted_z[i] * g_w2mw;
-            mw_vec_c[i] = ch_p;
-
-            if (mw_vec_c[i] >= max_pw[MW] && !need_skip) {
-                max_pw[MW] = mw_vec_c[i];
-                max_pw_idx[MW] = i;
-            }
-
-            ch_p = converted_z[i];
-            dbw_vec_c[i] = ch_p > LOG_LIMIT ? 10 * log_converted_10 : logLim_10;
-
-            if (dbw_vec_c[i] >= max_pw[DBW] && !need_skip) {
-                max_pw[DBW] = dbw_vec_c[i];
-                max_pw_idx[DBW] = i;
+            for (int mode = MIN_DSP_MODE; mode < COUNT_DSP_MODE; mode++) {
+                data->m_converted.m_peak_power[mode][c] = max_pw[mode];
+                data->m_converted.m_peak_freq[mode][c] = binFreq(max_pw_idx[mode]);
             }
         }
-        for (int mode = MIN_DSP_MODE; mode < COUNT_DSP_MODE; mode++) {
-            data->m_converted.m_peak_power[mode][c] = max_pw[mode];
-            data->m_converted.m_peak_freq[mode][c] = ((float)max_pw_idx[mode] / (float)getOutSignalLength() * freq_smpl / 2);
-        }
-    }
+    });
 
     return 0;
 }
@@ -17,11 +17,18 @@ namespace rp_dsp_api {
 
 typedef enum { RECTANGULAR = 0, HANNING = 1, HAMMING = 2, BLACKMAN_HARRIS = 3, FLAT_TOP = 4, KAISER_4 = 5, KAISER_8 = 6 } window_mode_t;
 
+// FFT_NEON is vectorized on ARM and limited to power of two sizes, other sizes fall back to FFT_KISS
+typedef enum { FFT_KISS = 0, FFT_NEON = 1 } fft_backend_t;
+
 typedef enum { DBM = 0, VOLT = 1, DBU = 2, DBV = 3, DBuV = 4, MW = 5, DBW = 6 } mode_t;
 
 constexpr const int MIN_DSP_MODE = rp_dsp_api::DBM;
 constexpr const int COUNT_DSP_MODE = (rp_dsp_api::DBW + 1);
 
+// Threads that process the channels of one CDSP in parallel, the calling thread included
+constexpr const uint8_t DSP_MAX_THREADS = 4;
+constexpr const uint8_t DSP_DEFAULT_THREADS = 2;
+
 typedef float cdsp_data_t;
 typedef std::vector<cdsp_data_t> cdsp_data_vec_t;
 typedef std::vector<std::vector<cdsp_data_t>> cdsp_data_ch_t;
@@ -52,6 +59,9 @@ typedef struct {
     auto reset() -> void { m_is_data_filtred = false; }
 } data_t;
 
+// Fills window with len coefficients of the given mode and stores their sum in sum
+int createWindow(window_mode_t mode, uint32_t len, cdsp_data_t* window, double* sum);
+
 class CDSP {
 
    public:
@@ -72,6 +82,7 @@ class CDSP {
 
     int window_init(window_mode_t mode);
     window_mode_t getCurrentWindowMode();
+    double getWindowSum();
 
     void setImpedance(double value);
     double getImpedance();
@@ -82,10 +93,20 @@ class CDSP {
     void setProbe(uint8_t channel, uint32_t value);
     void getProbe(uint8_t channel, uint32_t* value);
 
+    // Channels are split over count threads when the signal is long enough. 1 processes them on the calling thread.
+    // Like fftInit, it must not be called while another thread is processing data.
+    int setThreads(uint8_t count);
+    uint8_t getThreads();
+
     int prepareFreqVector(data_t* data, double adc_rate_f_s, float decimation);
     int prepareFreqVector(data_t* data, float decimation);
 
     int windowFilter(data_t* data);
+    // Selects the FFT implementation and reinitializes it for the current signal length
+    int setFFTBackend(fft_backend_t backend);
+    // Backend in use, FFT_KISS when the selected one does not support the signal length
+    fft_backend_t getFFTBackend();
+
     int fftInit();
     int fft(data_t* data);
     int getAmpAndPhase(data_t* _data, double _freq, double* _amp1, double* _phase1, double* _amp2, double* _phase2);
@@ -11,6 +11,7 @@
 
 %apply int { window_mode_t }
 %apply int { mode_t }
+%apply int { fft_backend_t }
 
 %apply uint32_t *OUTPUT { uint32_t *value };
 %apply bool *OUTPUT { bool *enable };
@@ -98,5 +99,9 @@ namespace rp_dsp_api {
 %apply int16_t *INPUT { volatile const int16_t *src1 };
 %apply int16_t *INPUT { volatile const int16_t *src2 };
 
+%apply float *OUTPUT { float *min };
+%apply float *OUTPUT { float *max };
+%apply double *OUTPUT { double *sum };
+
 
 %include "rp_math.h"
\ No newline at end of file
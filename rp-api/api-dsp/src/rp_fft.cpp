@@ -0,0 +1,427 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya real FFT backends used by CDSP.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "rp_fft.h"
+#include "rp_log.h"
+
+#include "kiss_fftr.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define NEON_FFT_MIN_SIZE 16
+#define NEON_FFT_MAX_SIZE 65536
+
+using namespace rp_dsp_api;
+
+namespace {
+
+auto isPowerOf2(uint32_t value) -> bool {
+    return value && !(value & (value - 1));
+}
+
+auto cmul(kiss_fft_cpx z, float wr, float wi) -> kiss_fft_cpx {
+    return {z.r * wr - z.i * wi, z.i * wr + z.r * wi};
+}
+
+#ifdef ARCH_ARM
+
+auto cmulNeon(float32x4_t zr, float32x4_t zi, float wr, float wi) -> float32x4x2_t {
+    float32x4x2_t res;
+    res.val[0] = vmlsq_n_f32(vmulq_n_f32(zr, wr), zi, wi);
+    res.val[1] = vmlaq_n_f32(vmulq_n_f32(zi, wr), zr, wi);
+    return res;
+}
+
+auto cmulNeon(float32x4_t zr, float32x4_t zi, float32x4_t wr, float32x4_t wi) -> float32x4x2_t {
+    float32x4x2_t res;
+    res.val[0] = vmlsq_f32(vmulq_f32(zr, wr), zi, wi);
+    res.val[1] = vmlaq_f32(vmulq_f32(zi, wr), zr, wi);
+    return res;
+}
+
+// Lanes in reverse order
+auto reverseNeon(float32x4_t value) -> float32x4_t {
+    float32x4_t swapped = vrev64q_f32(value);
+    return vcombine_f32(vget_high_f32(swapped), vget_low_f32(swapped));
+}
+
+// rows[k][p] -> rows[p][k]
+auto transposeNeon(float32x4_t* rows) -> void {
+    float32x4x2_t t01 = vtrnq_f32(rows[0], rows[1]);
+    float32x4x2_t t23 = vtrnq_f32(rows[2], rows[3]);
+    rows[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    rows[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    rows[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    rows[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#endif
+
+class CKissFFT : public CFFTBackend {
+
+   public:
+    CKissFFT(uint32_t max_size) {
+        kiss_fftr_alloc(max_size, 0, NULL, &m_cfg_max_size);  // precalculate memory
+        if (m_cfg_max_size != 0) {
+            m_memory.resize(m_cfg_max_size);
+            size_t size = m_cfg_max_size;
+            m_cfg = kiss_fftr_alloc(max_size, 0, m_memory.data(), &size);
+            m_size = m_cfg ? max_size : 0;
+        }
+    }
+
+    auto getType() -> fft_backend_t override { return FFT_KISS; }
+
+    auto init(uint32_t size) -> int override {
+        if (m_memory.empty()) {
+            ERROR_LOG("kiss_fftr memory not allocated");
+            return -1;
+        }
+        size_t mem_size = m_cfg_max_size;
+        auto cfg = kiss_fftr_alloc(size, 0, m_memory.data(), &mem_size);
+        if (!cfg) {
+            ERROR_LOG("kiss_fftr can't be initialized for size %d", size);
+            return -1;
+        }
+        m_cfg = cfg;
+        m_size = size;
+        return 0;
+    }
+
+    auto getSize() -> uint32_t override { return m_size; }
+
+    auto forward(const float* const* in, kiss_fft_cpx* const* out, uint8_t count) -> int override {
+        if (!m_cfg) {
+            ERROR_LOG("kiss_fftr not initialized");
+            return -1;
+        }
+        for (uint8_t c = 0; c < count; c++) {
+            kiss_fftr(m_cfg, (const kiss_fft_scalar*)in[c], out[c]);
+        }
+        return 0;
+    }
+
+   private:
+    std::vector<uint8_t> m_memory;
+    size_t m_cfg_max_size = 0;
+    kiss_fftr_cfg m_cfg = NULL;
+    uint32_t m_size = 0;
+};
+
+// The real input of size N is transformed as N / 2 complex samples and split afterwards.
+// Radix-4 Stockham passes need no bit reversal, a radix-2 pass ends odd powers of two.
+// All channels go through each pass together, so the twiddles are loaded once per pass.
+class CNeonFFT : public CFFTBackend {
+
+   public:
+    CNeonFFT(uint32_t max_size, uint8_t max_channels) : m_max_channels(max_channels) {
+        max_size = std::min<uint32_t>(max_size, NEON_FFT_MAX_SIZE);
+        m_stages.reserve(16);
+        m_twiddle.reserve(max_size);
+        m_post.reserve(max_size / 2);
+        m_work.reserve((size_t)max_size * max_channels);
+        m_src.resize(max_channels);
+        m_dst.resize(max_channels);
+    }
+
+    auto getType() -> fft_backend_t override { return FFT_NEON; }
+
+    auto init(uint32_t size) -> int override {
+        if (!isSupported(FFT_NEON, size)) {
+            ERROR_LOG("Size %d is not supported by the NEON FFT", size);
+            return -1;
+        }
+        const uint32_t half = size / 2;
+        m_stages.clear();
+        m_twiddle.clear();
+        uint32_t n = half;
+        uint32_t s = 1;
+        for (; n >= 4; n /= 4, s *= 4) {
+            // w1, w2, w3 of each p, real and imaginary parts in separate rows
+            const uint32_t m = n / 4;
+            const uint32_t offset = m_twiddle.size();
+            m_stages.push_back({n, s, offset});
+            m_twiddle.resize(offset + 6 * m);
+            float* w = m_twiddle.data() + offset;
+            for (uint32_t k = 1; k <= 3; k++) {
+                for (uint32_t p = 0; p < m; p++) {
+                    double angle = -2.0 * M_PI * k * p / n;
+                    w[(2 * k - 2) * m + p] = cos(angle);
+                    w[(2 * k - 1) * m + p] = sin(angle);
+                }
+            }
+        }
+        m_radix2_stride = n == 2 ? s : 0;
+
+        // -j * exp(-2 pi i k / size)
+        m_post.resize(half);
+        for (uint32_t k = 0; k < half; k++) {
+            double angle = 2.0 * M_PI * k / size;
+            m_post[k] = {(float)-sin(angle), (float)-cos(angle)};
+        }
+        m_work.resize((size_t)size * m_max_channels);
+        m_size = size;
+        return 0;
+    }
+
+    auto getSize() -> uint32_t override { return m_size; }
+
+    auto forward(const float* const* in, kiss_fft_cpx* const* out, uint8_t count) -> int override {
+        if (m_size == 0) {
+            ERROR_LOG("NEON FFT not initialized");
+            return -1;
+        }
+        if (count > m_max_channels) {
+            ERROR_LOG("Too many channels %d", count);
+            return -1;
+        }
+        const uint32_t half = m_size / 2;
+        for (uint8_t c = 0; c < count; c++) {
+            m_src[c] = m_work.data() + (size_t)m_size * c;
+            m_dst[c] = m_src[c] + half;
+            memcpy(m_src[c], in[c], m_size * sizeof(float));
+        }
+        for (auto& stage : m_stages) {
+            radix4(stage, count);
+            std::swap(m_src, m_dst);
+        }
+        if (m_radix2_stride) {
+            radix2(m_radix2_stride, count);
+            std::swap(m_src, m_dst);
+        }
+        for (uint8_t c = 0; c < count; c++) {
+            split(m_src[c], out[c]);
+        }
+        return 0;
+    }
+
+   private:
+    struct Stage {
+        uint32_t n;  // Length of the sub transforms
+        uint32_t s;  // Stride between their samples
+        uint32_t offset;
+    };
+
+    auto radix4(const Stage& stage, uint8_t count) -> void;
+    auto radix2(uint32_t s, uint8_t count) -> void;
+    auto split(const kiss_fft_cpx* z, kiss_fft_cpx* out) -> void;
+
+    uint8_t m_max_channels;
+    uint32_t m_size = 0;
+    uint32_t m_radix2_stride = 0;
+    std::vector<Stage> m_stages;
+    std::vector<float> m_twiddle;
+    std::vector<kiss_fft_cpx> m_post;
+    std::vector<kiss_fft_cpx> m_work;  // Two buffers of size / 2 per channel
+    std::vector<kiss_fft_cpx*> m_src;
+    std::vector<kiss_fft_cpx*> m_dst;
+};
+
+auto CNeonFFT::radix4(const Stage& stage, uint8_t count) -> void {
+    const uint32_t s = stage.s;
+    const uint32_t m = stage.n / 4;
+    const uint32_t sm = s * m;
+    const float* w1r = m_twiddle.data() + stage.offset;
+    const float* w1i = w1r + m;
+    const float* w2r = w1r + 2 * m;
+    const float* w2i = w1r + 3 * m;
+    const float* w3r = w1r + 4 * m;
+    const float* w3i = w1r + 5 * m;
+
+#ifdef ARCH_ARM
+    if (s == 1 && m % 4 == 0) {
+        // First pass, vectorized over p. The results of four p are transposed to get y[4p + k].
+        for (uint32_t p = 0; p < m; p += 4) {
+            float32x4_t vw1r = vld1q_f32(w1r + p);
+            float32x4_t vw1i = vld1q_f32(w1i + p);
+            float32x4_t vw2r = vld1q_f32(w2r + p);
+            float32x4_t vw2i = vld1q_f32(w2i + p);
+            float32x4_t vw3r = vld1q_f32(w3r + p);
+            float32x4_t vw3i = vld1q_f32(w3i + p);
+            for (uint8_t c = 0; c < count; c++) {
+                const kiss_fft_cpx* x = m_src[c] + p;
+                float32x4x2_t a = vld2q_f32(&x[0].r);
+                float32x4x2_t b = vld2q_f32(&x[m].r);
+                float32x4x2_t cc = vld2q_f32(&x[2 * m].r);
+                float32x4x2_t d = vld2q_f32(&x[3 * m].r);
+                float32x4_t apc_r = vaddq_f32(a.val[0], cc.val[0]);
+                float32x4_t apc_i = vaddq_f32(a.val[1], cc.val[1]);
+                float32x4_t amc_r = vsubq_f32(a.val[0], cc.val[0]);
+                float32x4_t amc_i = vsubq_f32(a.val[1], cc.val[1]);
+                float32x4_t bpd_r = vaddq_f32(b.val[0], d.val[0]);
+                float32x4_t bpd_i = vaddq_f32(b.val[1], d.val[1]);
+                float32x4_t bmd_r = vsubq_f32(b.val[0], d.val[0]);
+                float32x4_t bmd_i = vsubq_f32(b.val[1], d.val[1]);
+
+                float32x4x2_t y1 = cmulNeon(vaddq_f32(amc_r, bmd_i), vsubq_f32(amc_i, bmd_r), vw1r, vw1i);
+                float32x4x2_t y2 = cmulNeon(vsubq_f32(apc_r, bpd_r), vsubq_f32(apc_i, bpd_i), vw2r, vw2i);
+                float32x4x2_t y3 = cmulNeon(vsubq_f32(amc_r, bmd_i), vaddq_f32(amc_i, bmd_r), vw3r, vw3i);
+                float32x4_t re[4] = {vaddq_f32(apc_r, bpd_r), y1.val[0], y2.val[0], y3.val[0]};
+                float32x4_t im[4] = {vaddq_f32(apc_i, bpd_i), y1.val[1], y2.val[1], y3.val[1]};
+                transposeNeon(re);
+                transposeNeon(im);
+                kiss_fft_cpx* y = m_dst[c] + 4 * p;
+                for (uint32_t i = 0; i < 4; i++) {
+                    float32x4x2_t value;
+                    value.val[0] = re[i];
+                    value.val[1] = im[i];
+                    vst2q_f32(&y[4 * i].r, value);
+                }
+            }
+        }
+        return;
+    }
+
+    if (s % 4 == 0) {
+        // Later passes, vectorized over q with one twiddle per p
+        for (uint32_t p = 0; p < m; p++) {
+            for (uint8_t c = 0; c < count; c++) {
+                const kiss_fft_cpx* x = m_src[c] + s * p;
+                kiss_fft_cpx* y = m_dst[c] + 4 * s * p;
+                for (uint32_t q = 0; q < s; q += 4) {
+                    float32x4x2_t a = vld2q_f32(&x[q].r);
+                    float32x4x2_t b = vld2q_f32(&x[q + sm].r);
+                    float32x4x2_t cc = vld2q_f32(&x[q + 2 * sm].r);
+                    float32x4x2_t d = vld2q_f32(&x[q + 3 * sm].r);
+                    float32x4_t apc_r = vaddq_f32(a.val[0], cc.val[0]);
+                    float32x4_t apc_i = vaddq_f32(a.val[1], cc.val[1]);
+                    float32x4_t amc_r = vsubq_f32(a.val[0], cc.val[0]);
+                    float32x4_t amc_i = vsubq_f32(a.val[1], cc.val[1]);
+                    float32x4_t bpd_r = vaddq_f32(b.val[0], d.val[0]);
+                    float32x4_t bpd_i = vaddq_f32(b.val[1], d.val[1]);
+                    float32x4_t bmd_r = vsubq_f32(b.val[0], d.val[0]);
+                    float32x4_t bmd_i = vsubq_f32(b.val[1], d.val[1]);
+
+                    float32x4x2_t y0;
+                    y0.val[0] = vaddq_f32(apc_r, bpd_r);
+                    y0.val[1] = vaddq_f32(apc_i, bpd_i);
+                    vst2q_f32(&y[q].r, y0);
+                    vst2q_f32(&y[q + s].r, cmulNeon(vaddq_f32(amc_r, bmd_i), vsubq_f32(amc_i, bmd_r), w1r[p], w1i[p]));
+                    vst2q_f32(&y[q + 2 * s].r, cmulNeon(vsubq_f32(apc_r, bpd_r), vsubq_f32(apc_i, bpd_i), w2r[p], w2i[p]));
+                    vst2q_f32(&y[q + 3 * s].r, cmulNeon(vsubq_f32(amc_r, bmd_i), vaddq_f32(amc_i, bmd_r), w3r[p], w3i[p]));
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    for (uint32_t p = 0; p < m; p++) {
+        for (uint8_t c = 0; c < count; c++) {
+            const kiss_fft_cpx* x = m_src[c] + s * p;
+            kiss_fft_cpx* y = m_dst[c] + 4 * s * p;
+            for (uint32_t q = 0; q < s; q++) {
+                kiss_fft_cpx a = x[q];
+                kiss_fft_cpx b = x[q + sm];
+                kiss_fft_cpx cc = x[q + 2 * sm];
+                kiss_fft_cpx d = x[q + 3 * sm];
+                kiss_fft_cpx apc = {a.r + cc.r, a.i + cc.i};
+                kiss_fft_cpx amc = {a.r - cc.r, a.i - cc.i};
+                kiss_fft_cpx bpd = {b.r + d.r, b.i + d.i};
+                kiss_fft_cpx bmd = {b.r - d.r, b.i - d.i};
+                y[q] = {apc.r + bpd.r, apc.i + bpd.i};
+                y[q + s] = cmul({amc.r + bmd.i, amc.i - bmd.r}, w1r[p], w1i[p]);
+                y[q + 2 * s] = cmul({apc.r - bpd.r, apc.i - bpd.i}, w2r[p], w2i[p]);
+                y[q + 3 * s] = cmul({amc.r - bmd.i, amc.i + bmd.r}, w3r[p], w3i[p]);
+            }
+        }
+    }
+}
+
+auto CNeonFFT::radix2(uint32_t s, uint8_t count) -> void {
+    for (uint8_t c = 0; c < count; c++) {
+        // Butterflies without twiddles, real and imaginary parts are handled alike
+        const float* x = &m_src[c][0].r;
+        float* y = &m_dst[c][0].r;
+        const uint32_t len = 2 * s;
+        uint32_t i = 0;
+#ifdef ARCH_ARM
+        for (; i + 4 <= len; i += 4) {
+            float32x4_t a = vld1q_f32(x + i);
+            float32x4_t b = vld1q_f32(x + i + len);
+            vst1q_f32(y + i, vaddq_f32(a, b));
+            vst1q_f32(y + i + len, vsubq_f32(a, b));
+        }
+#endif
+        for (; i < len; i++) {
+            y[i] = x[i] + x[i + len];
+            y[i + len] = x[i] - x[i + len];
+        }
+    }
+}
+
+// X[k] = E[k] - j W^k O[k], E and O being the even and odd parts of Z[k] and conj(Z[N/2 - k])
+auto CNeonFFT::split(const kiss_fft_cpx* z, kiss_fft_cpx* out) -> void {
+    const uint32_t half = m_size / 2;
+    out[0] = {z[0].r + z[0].i, 0};
+    out[half] = {z[0].r - z[0].i, 0};
+    uint32_t k = 1;
+#ifdef ARCH_ARM
+    float32x4_t vhalf = vdupq_n_f32(0.5f);
+    for (; k + 4 <= half; k += 4) {
+        float32x4x2_t a = vld2q_f32(&z[k].r);
+        float32x4x2_t b = vld2q_f32(&z[half - k - 3].r);
+        float32x4_t br = reverseNeon(b.val[0]);
+        float32x4_t bi = vnegq_f32(reverseNeon(b.val[1]));
+        float32x4_t er = vmulq_f32(vaddq_f32(a.val[0], br), vhalf);
+        float32x4_t ei = vmulq_f32(vaddq_f32(a.val[1], bi), vhalf);
+        float32x4_t or_ = vmulq_f32(vsubq_f32(a.val[0], br), vhalf);
+        float32x4_t oi = vmulq_f32(vsubq_f32(a.val[1], bi), vhalf);
+        float32x4x2_t w = vld2q_f32(&m_post[k].r);
+        float32x4x2_t t = cmulNeon(or_, oi, w.val[0], w.val[1]);
+        t.val[0] = vaddq_f32(er, t.val[0]);
+        t.val[1] = vaddq_f32(ei, t.val[1]);
+        vst2q_f32(&out[k].r, t);
+    }
+#endif
+    for (; k < half; k++) {
+        kiss_fft_cpx a = z[k];
+        kiss_fft_cpx b = {z[half - k].r, -z[half - k].i};
+        kiss_fft_cpx e = {(a.r + b.r) * 0.5f, (a.i + b.i) * 0.5f};
+        kiss_fft_cpx o = {(a.r - b.r) * 0.5f, (a.i - b.i) * 0.5f};
+        kiss_fft_cpx t = cmul(o, m_post[k].r, m_post[k].i);
+        out[k] = {e.r + t.r, e.i + t.i};
+    }
+}
+
+}  // namespace
+
+auto CFFTBackend::create(fft_backend_t backend, uint32_t max_size, uint8_t max_channels) -> CFFTBackend* {
+    switch (backend) {
+        case FFT_KISS:
+            return new (std::nothrow) CKissFFT(max_size);
+        case FFT_NEON:
+            return new (std::nothrow) CNeonFFT(max_size, max_channels);
+        default:
+            ERROR_LOG("Unknown FFT backend %d", backend);
+            return NULL;
+    }
+}
+
+auto CFFTBackend::isSupported(fft_backend_t backend, uint32_t size) -> bool {
+    switch (backend) {
+        case FFT_KISS:
+            return size >= 2 && !(size & 1);
+        case FFT_NEON:
+            return isPowerOf2(size) && size >= NEON_FFT_MIN_SIZE && size <= NEON_FFT_MAX_SIZE;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya real FFT backends used by CDSP.
+ *
+ * FFT_KISS wraps kiss_fftr and accepts any even size. It is the reference implementation.
+ * FFT_NEON is a radix-4 Stockham transform for power of two sizes, vectorized with NEON on ARM
+ * and running the same algorithm with scalar butterflies elsewhere.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __RP_FFT_H__
+#define __RP_FFT_H__
+
+#include <stdint.h>
+
+#include "kiss_fft.h"
+#include "rp_dsp.h"
+
+namespace rp_dsp_api {
+
+class CFFTBackend {
+
+   public:
+    // Creates a backend for transforms up to max_size samples on up to max_channels channels
+    static CFFTBackend* create(fft_backend_t backend, uint32_t max_size, uint8_t max_channels);
+    static bool isSupported(fft_backend_t backend, uint32_t size);
+
+    virtual ~CFFTBackend() = default;
+
+    virtual fft_backend_t getType() = 0;
+
+    // Prepares a real transform of size samples
+    virtual int init(uint32_t size) = 0;
+    virtual uint32_t getSize() = 0;
+
+    // Unscaled forward transform of count channels, out[ch] receives size / 2 + 1 bins
+    virtual int forward(const float* const* in, kiss_fft_cpx* const* out, uint8_t count) = 0;
+};
+
+}  // namespace rp_dsp_api
+
+#endif
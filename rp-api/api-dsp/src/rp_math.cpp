@@ -7,6 +7,10 @@
 #include <cstring>
 #include <iostream>
 
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
 const float __log10f_rng = 0.3010299957f;
 
 const float __log10f_lut[8] = {
@@ -2021,4 +2025,62 @@ void divide_array_by_scalar_double_neon(volatile double* dst, volatile const dou
 #endif
 }
 
+void minmax_sum_float_neon(volatile const float* src, size_t n, float* min, float* max, double* sum) {
+    if (n == 0) {
+        return;
+    }
+    const float* p = (const float*)src;
+    float vmin = p[0];
+    float vmax = p[0];
+    double acc = 0;
+    size_t i = 0;
+#ifdef ARCH_ARM
+    if (n >= 16) {
+        float32x4_t mn0 = vld1q_f32(p);
+        float32x4_t mx0 = mn0;
+        float32x4_t mn1 = mn0;
+        float32x4_t mx1 = mn0;
+        // Partial sums stay in float for at most 4096 elements, then go to double
+        while (i + 8 <= n) {
+            size_t chunk_end = i + 4096 < n ? i + 4096 : n;
+            float32x4_t s0 = vdupq_n_f32(0);
+            float32x4_t s1 = vdupq_n_f32(0);
+            for (; i + 8 <= chunk_end; i += 8) {
+                __builtin_prefetch(p + i + 64);
+                float32x4_t a = vld1q_f32(p + i);
+                float32x4_t b = vld1q_f32(p + i + 4);
+                mn0 = vminq_f32(mn0, a);
+                mx0 = vmaxq_f32(mx0, a);
+                mn1 = vminq_f32(mn1, b);
+                mx1 = vmaxq_f32(mx1, b);
+                s0 = vaddq_f32(s0, a);
+                s1 = vaddq_f32(s1, b);
+            }
+            float32x4_t s = vaddq_f32(s0, s1);
+            float32x2_t s2 = vpadd_f32(vget_low_f32(s), vget_high_f32(s));
+            acc += (double)vget_lane_f32(s2, 0) + (double)vget_lane_f32(s2, 1);
+        }
+        float32x4_t mn = vminq_f32(mn0, mn1);
+        float32x4_t mx = vmaxq_f32(mx0, mx1);
+        float32x2_t mn2 = vpmin_f32(vget_low_f32(mn), vget_high_f32(mn));
+        float32x2_t mx2 = vpmax_f32(vget_low_f32(mx), vget_high_f32(mx));
+        mn2 = vpmin_f32(mn2, mn2);
+        mx2 = vpmax_f32(mx2, mx2);
+        vmin = vget_lane_f32(mn2, 0);
+        vmax = vget_lane_f32(mx2, 0);
+    }
+#endif
+    for (; i < n; ++i) {
+        float v = p[i];
+        if (v < vmin)
+            vmin = v;
+        if (v > vmax)
+            vmax = v;
+        acc += v;
+    }
+    *min = vmin;
+    *max = vmax;
+    *sum = acc;
+}
+
 #pragma GCC diagnostic pop
\ No newline at end of file
@@ -290,8 +290,24 @@ void multiply_array_by_scalar_double_neon(volatile double* dst, volatile const d
  */
 void divide_array_by_scalar_double_neon(volatile double* dst, volatile const double* src, const double scalar, size_t n);
 
+// ============================================================================
+// Reduction Functions - Float
+// ============================================================================
+
+/**
+ * @brief Min/max/sum reduction over float array.
+ * @param src Source array
+ * @param n Number of elements
+ * @param min Minimum value (output)
+ * @param max Maximum value (output)
+ * @param sum Sum of all elements (output)
+ * @note Outputs are left untouched when n is 0
+ */
+void minmax_sum_float_neon(volatile const float* src, size_t n, float* min, float* max, double* sum);
+
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif  // __RP_MATH_H__
\ No newline at end of file
+#endif  // __RP_MATH_H__
\ No newline at end of file
@@ -0,0 +1,374 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya multi-tone excitation. Several frequencies measured from one capture.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <complex>
+#include <new>
+#include <vector>
+
+#include "kiss_fftr.h"
+#include "rp_fft.h"
+#include "rp_log.h"
+#include "rp_multitone.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MT_MIN_CAPTURE 64      // Shortest capture, fewer samples do not leave room between the harmonics
+#define MT_NYQUIST_MARGIN 4    // The highest tone stays below adc_rate / decimation / MT_NYQUIST_MARGIN
+#define MT_MAX_SNR 200.0       // Reported when the neighbouring bins are exactly zero
+#define MT_RENORM_STEP 1024    // Samples between renormalizations of the phasor recursion
+#define MT_CF_ITERATIONS 40    // Clipping passes that lower the crest factor after the Schroeder phases
+#define MT_CF_CLIP 0.85        // Clipping level relative to the current peak
+#define MT_CF_OVERSAMPLE 8     // Table samples per period of the highest tone while optimizing
+
+using namespace rp_dsp_api;
+
+namespace {
+
+auto floorPowerOf2(uint32_t value) -> uint32_t {
+    uint32_t p = 1;
+    while (p <= value / 2)
+        p <<= 1;
+    return value ? p : 0;
+}
+
+// Decimations below 16 are powers of two, see rp_AcqSetDecimationFactor
+auto snapDecimation(uint64_t decimation) -> uint64_t {
+    if (decimation >= 16)
+        return decimation;
+    uint64_t d = 1;
+    while (d < decimation)
+        d <<= 1;
+    return d;
+}
+
+auto nextDecimation(uint64_t decimation) -> uint64_t {
+    return decimation < 16 ? decimation * 2 : decimation + 1;
+}
+
+}  // namespace
+
+struct CMultiTone::Impl {
+    uint32_t m_adc_rate;
+    uint32_t m_max_capture;
+
+    std::vector<uint32_t> m_harmonics;
+    std::vector<double> m_phases;
+    uint32_t m_periods = MIN_PERIODS;
+    uint32_t m_decimation = 1;
+    uint32_t m_samples_per_period = 0;
+    double m_fundamental = 0;
+    double m_crest_factor = 0;
+
+    CFFTBackend* m_fft = NULL;
+    std::vector<float> m_in[2];
+    std::vector<kiss_fft_cpx> m_out[2];
+
+    auto plan(const double* freqs, uint32_t count, uint32_t samples_per_period, uint32_t periods, double max_error) -> bool;
+    auto optimizePhases() -> void;
+    auto synthesize(float* out, uint32_t size) -> double;
+    auto initFFT(uint32_t size) -> int;
+};
+
+auto CMultiTone::Impl::plan(const double* freqs, uint32_t count, uint32_t samples_per_period, uint32_t periods, double max_error) -> bool {
+    // Neighbouring tones at least one fundamental apart, so rounding can keep them on distinct harmonics
+    double f0_max = freqs[0];
+    for (uint32_t i = 1; i < count; i++) {
+        f0_max = std::min(f0_max, freqs[i] - freqs[i - 1]);
+    }
+    std::vector<uint32_t> harmonics(count);
+    // A higher decimation gives a finer grid and a longer capture, the first one that keeps every tone close enough is used
+    for (uint64_t decimation = snapDecimation((uint64_t)ceil(m_adc_rate / (f0_max * samples_per_period))); decimation <= MAX_DECIMATION;
+         decimation = nextDecimation(decimation)) {
+        double f0 = (double)m_adc_rate / ((double)decimation * samples_per_period);
+        uint32_t last = 0;
+        bool within = true;
+        for (uint32_t i = 0; i < count; i++) {
+            auto k = (uint32_t)std::max(1.0, round(freqs[i] / f0));
+            harmonics[i] = std::max(k, last + 1);
+            last = harmonics[i];
+            within = within && fabs(harmonics[i] * f0 - freqs[i]) <= freqs[i] * max_error;
+        }
+        // The grid only gets finer from here, the highest tone does not come back below the Nyquist margin
+        if ((uint64_t)last * MT_NYQUIST_MARGIN > samples_per_period)
+            return false;
+        if (!within)
+            continue;
+
+        m_harmonics.swap(harmonics);
+        m_decimation = decimation;
+        m_samples_per_period = samples_per_period;
+        m_periods = periods;
+        m_fundamental = f0;
+        return true;
+    }
+    return false;
+}
+
+// Iterative clipping (Van der Ouderaa): the clipped waveform keeps the phases of its tone bins for the next pass.
+// Schroeder phases are only optimal for equally spaced tones, log spaced tones gain the most here.
+auto CMultiTone::Impl::optimizePhases() -> void {
+    auto count = m_harmonics.size();
+    if (count < 3)
+        return;
+    uint32_t size = 64;
+    while (size < m_harmonics.back() * MT_CF_OVERSAMPLE)
+        size <<= 1;
+
+    size_t len_fwd = 0;
+    size_t len_inv = 0;
+    kiss_fftr_alloc(size, 0, NULL, &len_fwd);
+    kiss_fftr_alloc(size, 1, NULL, &len_inv);
+    std::vector<uint8_t> mem_fwd(len_fwd);
+    std::vector<uint8_t> mem_inv(len_inv);
+    auto fwd = kiss_fftr_alloc(size, 0, mem_fwd.data(), &len_fwd);
+    auto inv = kiss_fftr_alloc(size, 1, mem_inv.data(), &len_inv);
+    if (!fwd || !inv)
+        return;
+
+    std::vector<float> wave(size);
+    std::vector<kiss_fft_cpx> spectrum(size / 2 + 1);
+    auto phases = m_phases;
+    double best = INFINITY;
+    for (int it = 0; it <= MT_CF_ITERATIONS; it++) {
+        std::fill(spectrum.begin(), spectrum.end(), kiss_fft_cpx{0, 0});
+        for (size_t i = 0; i < count; i++) {
+            spectrum[m_harmonics[i]] = {(float)cos(phases[i]), (float)sin(phases[i])};
+        }
+        kiss_fftri(inv, spectrum.data(), wave.data());
+        float peak = 0;
+        for (auto v : wave) {
+            peak = std::max(peak, fabsf(v));
+        }
+        if (peak < best) {
+            best = peak;
+            m_phases = phases;
+        }
+        float clip = peak * MT_CF_CLIP;
+        for (auto& v : wave) {
+            v = std::clamp(v, -clip, clip);
+        }
+        kiss_fftr(fwd, wave.data(), spectrum.data());
+        for (size_t i = 0; i < count; i++) {
+            auto& x = spectrum[m_harmonics[i]];
+            phases[i] = atan2(x.i, x.r);
+        }
+    }
+}
+
+auto CMultiTone::Impl::synthesize(float* out, uint32_t size) -> double {
+    std::fill(out, out + size, 0.0f);
+    auto count = m_harmonics.size();
+    for (size_t i = 0; i < count; i++) {
+        // The rotation is exact at the start of every block, the rounding error does not build up over the period
+        double step = 2 * M_PI * m_harmonics[i] / size;
+        for (uint32_t start = 0; start < size; start += MT_RENORM_STEP) {
+            std::complex<double> z = std::polar(1.0, step * start + m_phases[i]);
+            std::complex<double> w = std::polar(1.0, step);
+            uint32_t end = std::min(size, start + MT_RENORM_STEP);
+            for (uint32_t n = start; n < end; n++) {
+                out[n] += z.real();
+                z *= w;
+            }
+        }
+    }
+    float peak = 0;
+    for (uint32_t n = 0; n < size; n++) {
+        peak = std::max(peak, fabsf(out[n]));
+    }
+    if (peak > 0) {
+        for (uint32_t n = 0; n < size; n++) {
+            out[n] /= peak;
+        }
+    }
+    // Unit amplitude tones have an RMS of sqrt(count / 2) together
+    return count ? peak / sqrt(count / 2.0) : 0;
+}
+
+auto CMultiTone::Impl::initFFT(uint32_t size) -> int {
+    if (m_fft && m_fft->getSize() == size)
+        return 0;
+    auto type = FFT_KISS;
+#ifdef ARCH_ARM
+    if (CFFTBackend::isSupported(FFT_NEON, size))
+        type = FFT_NEON;
+#endif
+    if (!m_fft || m_fft->getType() != type) {
+        delete m_fft;
+        m_fft = CFFTBackend::create(type, m_max_capture, 2);
+        if (!m_fft) {
+            ERROR_LOG("Can not allocate FFT");
+            return -1;
+        }
+    }
+    try {
+        for (int ch = 0; ch < 2; ch++) {
+            m_in[ch].resize(size);
+            m_out[ch].resize(size / 2 + 1);
+        }
+    } catch (const std::bad_alloc& e) {
+        ERROR_LOG("Can not allocate memory");
+        return -1;
+    }
+    return m_fft->init(size);
+}
+
+CMultiTone::CMultiTone(uint32_t adc_rate, uint32_t max_capture) {
+    m_pimpl = new Impl();
+    m_pimpl->m_adc_rate = adc_rate;
+    m_pimpl->m_max_capture = floorPowerOf2(max_capture);
+}
+
+CMultiTone::~CMultiTone() {
+    delete m_pimpl->m_fft;
+    delete m_pimpl;
+}
+
+auto CMultiTone::setTones(const double* freqs, uint32_t count, uint32_t periods, double max_error) -> int {
+    if (count == 0 || count > MAX_TONES) {
+        WARNING("Wrong tone count %d", count)
+        return -1;
+    }
+    if (periods < MIN_PERIODS) {
+        WARNING("Wrong period count %d", periods)
+        return -1;
+    }
+    if (!(max_error > 0)) {
+        WARNING("Wrong frequency error %f", max_error)
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!(freqs[i] > 0) || (i > 0 && !(freqs[i] > freqs[i - 1]))) {
+            WARNING("Tone frequencies must be positive and ascending")
+            return -1;
+        }
+    }
+    if (freqs[count - 1] * MT_NYQUIST_MARGIN > m_pimpl->m_adc_rate) {
+        WARNING("Tone %f Hz is too close to the Nyquist frequency", freqs[count - 1])
+        return -1;
+    }
+
+    // The longest capture that fits gives the finest frequency grid and the most samples per tone
+    bool planned = false;
+    for (uint32_t m = floorPowerOf2(m_pimpl->m_max_capture / periods); m >= MT_MIN_CAPTURE && !planned; m /= 2) {
+        planned = m_pimpl->plan(freqs, count, m, periods, max_error);
+    }
+    if (!planned) {
+        WARNING("Tones from %f to %f Hz do not fit in one capture within %f of their frequencies", freqs[0], freqs[count - 1], max_error)
+        m_pimpl->m_harmonics.clear();
+        return -1;
+    }
+
+    // Schroeder phases for a flat spectrum
+    m_pimpl->m_phases.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        m_pimpl->m_phases[i] = fmod(-M_PI * i * (i + 1.0) / count, 2 * M_PI);
+    }
+    m_pimpl->optimizePhases();
+    m_pimpl->m_crest_factor = 0;
+    return m_pimpl->initFFT(getCaptureLength());
+}
+
+auto CMultiTone::getToneCount() -> uint32_t {
+    return m_pimpl->m_harmonics.size();
+}
+
+auto CMultiTone::getFreqVector(double* out) -> int {
+    if (m_pimpl->m_harmonics.empty())
+        return -1;
+    for (size_t i = 0; i < m_pimpl->m_harmonics.size(); i++) {
+        out[i] = m_pimpl->m_harmonics[i] * m_pimpl->m_fundamental;
+    }
+    return 0;
+}
+
+auto CMultiTone::getFundamental() -> double {
+    return m_pimpl->m_fundamental;
+}
+
+auto CMultiTone::getDecimation() -> uint32_t {
+    return m_pimpl->m_decimation;
+}
+
+auto CMultiTone::getCaptureLength() -> uint32_t {
+    return m_pimpl->m_samples_per_period * m_pimpl->m_periods;
+}
+
+auto CMultiTone::getWaveform(float* out, uint32_t size) -> int {
+    if (m_pimpl->m_harmonics.empty())
+        return -1;
+    if (m_pimpl->m_harmonics.back() * 2 >= size) {
+        WARNING("Waveform of %d samples is too short for harmonic %d", size, m_pimpl->m_harmonics.back())
+        return -1;
+    }
+    m_pimpl->m_crest_factor = m_pimpl->synthesize(out, size);
+    return 0;
+}
+
+auto CMultiTone::getCrestFactor() -> double {
+    if (m_pimpl->m_crest_factor == 0 && !m_pimpl->m_harmonics.empty()) {
+        std::vector<float> wave(std::max<uint32_t>(1024, m_pimpl->m_harmonics.back() * 16));
+        m_pimpl->m_crest_factor = m_pimpl->synthesize(wave.data(), wave.size());
+    }
+    return m_pimpl->m_crest_factor;
+}
+
+auto CMultiTone::analyze(const float* ch1, const float* ch2, uint32_t size, multitone_result_t* out) -> int {
+    auto length = getCaptureLength();
+    if (m_pimpl->m_harmonics.empty() || !m_pimpl->m_fft) {
+        ERROR_LOG("Multi-tone not initialized");
+        return -1;
+    }
+    if (size < length) {
+        ERROR_LOG("Capture of %d samples is shorter than %d", size, length);
+        return -1;
+    }
+    std::copy(ch1, ch1 + length, m_pimpl->m_in[0].begin());
+    std::copy(ch2, ch2 + length, m_pimpl->m_in[1].begin());
+    const float* in[2] = {m_pimpl->m_in[0].data(), m_pimpl->m_in[1].data()};
+    kiss_fft_cpx* spectrum[2] = {m_pimpl->m_out[0].data(), m_pimpl->m_out[1].data()};
+    if (m_pimpl->m_fft->forward(in, spectrum, 2) != 0)
+        return -1;
+
+    auto periods = m_pimpl->m_periods;
+    auto last_bin = length / 2;
+    for (size_t i = 0; i < m_pimpl->m_harmonics.size(); i++) {
+        uint32_t bin = m_pimpl->m_harmonics[i] * periods;
+        std::complex<double> x[2];
+        double snr = MT_MAX_SNR;
+        for (int ch = 0; ch < 2; ch++) {
+            x[ch] = {spectrum[ch][bin].r, spectrum[ch][bin].i};
+            // Bins strictly between this harmonic and its neighbours hold no excitation
+            double noise = 0;
+            uint32_t noise_bins = 0;
+            for (uint32_t j = 1; j < periods; j++) {
+                for (auto b : {bin - j, bin + j}) {
+                    if (b == 0 || b > last_bin)
+                        continue;
+                    noise += spectrum[ch][b].r * spectrum[ch][b].r + spectrum[ch][b].i * spectrum[ch][b].i;
+                    noise_bins++;
+                }
+            }
+            double power = std::norm(x[ch]);
+            if (noise_bins && noise > 0) {
+                snr = std::min(snr, 10 * log10(power * noise_bins / noise));
+            } else if (power == 0) {
+                snr = -MT_MAX_SNR;
+            }
+        }
+        auto h = x[1] / x[0];
+        out[i].freq = m_pimpl->m_harmonics[i] * m_pimpl->m_fundamental;
+        out[i].gain = std::abs(h);
+        out[i].phase = std::arg(h) * 180.0 / M_PI;
+        out[i].snr = snr;
+    }
+    return 0;
+}
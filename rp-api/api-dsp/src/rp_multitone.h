@@ -0,0 +1,77 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya multi-tone excitation. Several frequencies measured from one capture.
+ *
+ * The tones are harmonics of a fundamental that fits a whole number of times in the capture,
+ * so every tone falls on an FFT bin and no window is needed. The phases follow Schroeder's
+ * formula to keep the crest factor of the sum low. The bins between the harmonics carry no
+ * excitation and give the noise floor next to each tone.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __RP_MULTITONE_H__
+#define __RP_MULTITONE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace rp_dsp_api {
+
+typedef struct {
+    double freq;   // Tone frequency in Hz
+    double gain;   // |ch2 / ch1|
+    double phase;  // Phase of ch2 relative to ch1 in degrees
+    double snr;    // Tone over the noise of the neighbouring bins in dB, the lower of both channels
+} multitone_result_t;
+
+class CMultiTone {
+
+   public:
+    static constexpr uint32_t MAX_TONES = 64;
+    static constexpr uint32_t MIN_PERIODS = 2;
+    static constexpr uint32_t MAX_DECIMATION = 65536;
+    // Largest allowed distance of a tone from its requested frequency, relative to it
+    static constexpr double MAX_FREQ_ERROR = 0.01;
+
+    // adc_rate is the input sample rate in Hz, max_capture the longest capture in samples
+    CMultiTone(uint32_t adc_rate, uint32_t max_capture);
+    ~CMultiTone();
+
+    // Plans one excitation for count ascending frequencies. Each tone moves to the nearest free harmonic
+    // of the fundamental, getFreqVector returns the frequencies actually used. The fundamental is lowered
+    // until every tone is within max_error of its request, the call fails when no capture allows it.
+    // The capture holds periods periods of the fundamental, at least MIN_PERIODS.
+    int setTones(const double* freqs, uint32_t count, uint32_t periods, double max_error = MAX_FREQ_ERROR);
+    uint32_t getToneCount();
+    int getFreqVector(double* out);
+
+    // Repetition rate of the waveform, the generator frequency for an arbitrary waveform
+    double getFundamental();
+    uint32_t getDecimation();
+    // Samples to capture at getDecimation()
+    uint32_t getCaptureLength();
+
+    // One period of the excitation in size samples, peak normalized to 1
+    int getWaveform(float* out, uint32_t size);
+    // Peak over RMS of the excitation
+    double getCrestFactor();
+
+    // Demodulates all tones from getCaptureLength() samples of both channels. out holds getToneCount() results.
+    int analyze(const float* ch1, const float* ch2, uint32_t size, multitone_result_t* out);
+
+   private:
+    CMultiTone(const CMultiTone&) = delete;
+    CMultiTone(CMultiTone&&) = delete;
+    CMultiTone& operator=(const CMultiTone&) = delete;
+    CMultiTone& operator=(const CMultiTone&&) = delete;
+
+    struct Impl;
+    // Pointer to the internal implementation
+    Impl* m_pimpl;
+};
+
+}  // namespace rp_dsp_api
+
+#endif
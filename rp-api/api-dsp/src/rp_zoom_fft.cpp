@@ -0,0 +1,488 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya zoom FFT. High resolution spectrum of a narrow band around a centre frequency.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "rp_log.h"
+#include "rp_zoom_fft.h"
+
+#include "kiss_fft.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ZOOM_BLOCK 256            // Input samples mixed per NCO update
+#define ZOOM_CIC_ORDER 3          // Gain R^3 keeps the integrators in 64 bits up to MAX_DECIMATION
+#define ZOOM_CIC_SCALE 65536.0f   // Fixed point scale of the CIC input, 1 LSB = 15 uV
+#define ZOOM_FIR_TAPS 95          // Decimate by 2 stage after the CIC
+#define ZOOM_FIR_CUTOFF 0.22      // Relative to the FIR input rate, the output band ends at 0.25
+#define ZOOM_SETTLE 2             // FIR outputs dropped while the CIC fills
+#define ZOOM_MAX_CORRECTION 10.0  // Limits the droop correction at the band edges
+
+using namespace rp_dsp_api;
+
+namespace {
+
+auto isPowerOf2(uint32_t value) -> bool {
+    return value && !(value & (value - 1));
+}
+
+auto dotProduct(const float* a, const float* b, uint32_t n) -> float {
+    uint32_t i = 0;
+    float result = 0;
+#ifdef ARCH_ARM
+    float32x4_t acc1 = vdupq_n_f32(0);
+    float32x4_t acc2 = vdupq_n_f32(0);
+    for (; i + 8 <= n; i += 8) {
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc2 = vmlaq_f32(acc2, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc1 = vaddq_f32(acc1, acc2);
+    float32x2_t sum = vadd_f32(vget_low_f32(acc1), vget_high_f32(acc1));
+    result = vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+    for (; i < n; i++) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+}  // namespace
+
+struct CZoomFFT::Impl {
+    uint32_t m_fft_size;
+    uint32_t m_adc_rate;
+    window_mode_t m_window_mode = HANNING;
+    double m_center = 0;
+    uint32_t m_decimation = 2;
+    uint32_t m_cic_ratio = 1;
+    double m_cic_gain = 1;
+
+    std::vector<cdsp_data_t> m_window;
+    double m_window_sum = 1;
+    std::vector<float> m_fir;
+    std::vector<float> m_correction;  // Inverse response of the filters per output bin
+
+    uint64_t m_nco_pos = 0;
+    std::vector<float> m_mix_i;
+    std::vector<float> m_mix_q;
+    std::vector<int32_t> m_quantized;  // Interleaved I/Q of one block
+
+    uint64_t m_integ[ZOOM_CIC_ORDER][2];
+    uint64_t m_comb[ZOOM_CIC_ORDER][2];
+    uint32_t m_cic_count = 0;
+
+    // FIR input: the samples the next outputs need plus one block
+    std::vector<float> m_fir_i;
+    std::vector<float> m_fir_q;
+    uint32_t m_fir_len = 0;
+    uint32_t m_fir_next = 0;
+
+    uint32_t m_skip = ZOOM_SETTLE;
+    uint32_t m_collected = 0;
+    std::vector<kiss_fft_cpx> m_frame;
+    std::vector<kiss_fft_cpx> m_windowed;
+    std::vector<kiss_fft_cpx> m_spectrum;
+    std::vector<uint8_t> m_cfg_mem;
+    kiss_fft_cfg m_cfg = NULL;
+
+    auto initFFT() -> int;
+    auto designFilters() -> void;
+    auto updateCorrection() -> void;
+    auto reset() -> void;
+    auto mix(const cdsp_data_t* in, uint32_t n) -> void;
+    auto cic(uint32_t n) -> void;
+    auto comb(const uint64_t* value) -> void;
+    auto fir() -> void;
+};
+
+auto CZoomFFT::Impl::initFFT() -> int {
+    try {
+        m_window.resize(m_fft_size);
+        m_correction.resize(m_fft_size);
+        m_frame.resize(m_fft_size);
+        m_windowed.resize(m_fft_size);
+        m_spectrum.resize(m_fft_size);
+        size_t len = 0;
+        kiss_fft_alloc(m_fft_size, 0, NULL, &len);
+        m_cfg_mem.resize(len);
+        m_cfg = kiss_fft_alloc(m_fft_size, 0, m_cfg_mem.data(), &len);
+    } catch (const std::bad_alloc& e) {
+        ERROR_LOG("Can not allocate memory");
+        m_cfg = NULL;
+        return -1;
+    }
+    if (!m_cfg) {
+        ERROR_LOG("kiss_fft_alloc failed");
+        return -1;
+    }
+    if (createWindow(m_window_mode, m_fft_size, m_window.data(), &m_window_sum) != 0)
+        return -1;
+    updateCorrection();
+    return 0;
+}
+
+auto CZoomFFT::Impl::designFilters() -> void {
+    // Blackman windowed sinc
+    m_fir.resize(ZOOM_FIR_TAPS);
+    double sum = 0;
+    for (int n = 0; n < ZOOM_FIR_TAPS; n++) {
+        double m = n - (ZOOM_FIR_TAPS - 1) / 2.0;
+        double sinc = m == 0 ? 2 * ZOOM_FIR_CUTOFF : sin(2 * M_PI * ZOOM_FIR_CUTOFF * m) / (M_PI * m);
+        double w = 0.42 - 0.5 * cos(2 * M_PI * n / (ZOOM_FIR_TAPS - 1)) + 0.08 * cos(4 * M_PI * n / (ZOOM_FIR_TAPS - 1));
+        m_fir[n] = sinc * w;
+        sum += m_fir[n];
+    }
+    for (auto& h : m_fir) {
+        h /= sum;
+    }
+    m_cic_ratio = m_decimation / 2;
+    m_cic_gain = 1.0 / (pow((double)m_cic_ratio, ZOOM_CIC_ORDER) * ZOOM_CIC_SCALE);
+}
+
+auto CZoomFFT::Impl::updateCorrection() -> void {
+    if (m_correction.size() != m_fft_size)
+        return;
+    double bin = (double)m_adc_rate / m_decimation / m_fft_size;
+    double fir_rate = (double)m_adc_rate / m_cic_ratio;
+    for (uint32_t j = 0; j < m_fft_size; j++) {
+        double f = ((double)j - m_fft_size / 2.0) * bin;
+        double h = 1;
+        if (m_cic_ratio > 1 && f != 0) {
+            double x = M_PI * f / m_adc_rate;
+            h = pow(fabs(sin(m_cic_ratio * x) / (m_cic_ratio * sin(x))), ZOOM_CIC_ORDER);
+        }
+        double h_fir = 0;
+        for (int n = 0; n < ZOOM_FIR_TAPS; n++) {
+            h_fir += m_fir[n] * cos(2 * M_PI * f / fir_rate * (n - (ZOOM_FIR_TAPS - 1) / 2.0));
+        }
+        h *= fabs(h_fir);
+        m_correction[j] = h > 1.0 / ZOOM_MAX_CORRECTION ? 1.0 / h : ZOOM_MAX_CORRECTION;
+    }
+}
+
+auto CZoomFFT::Impl::reset() -> void {
+    memset(m_integ, 0, sizeof(m_integ));
+    memset(m_comb, 0, sizeof(m_comb));
+    m_cic_count = 0;
+    m_nco_pos = 0;
+    m_fir_len = 0;
+    m_fir_next = 0;
+    m_skip = ZOOM_SETTLE;
+    m_collected = 0;
+}
+
+auto CZoomFFT::Impl::mix(const cdsp_data_t* in, uint32_t n) -> void {
+    // The phase is recomputed from the sample position for every block, the rotation error does not accumulate
+    double cycles = fmod((double)m_nco_pos * m_center / m_adc_rate, 1.0);
+    double phase = -2 * M_PI * cycles;
+    double step = -2 * M_PI * m_center / m_adc_rate;
+    float* out_i = m_mix_i.data();
+    float* out_q = m_mix_q.data();
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    float pr[4];
+    float pi[4];
+    for (int l = 0; l < 4; l++) {
+        pr[l] = cos(phase + step * l);
+        pi[l] = sin(phase + step * l);
+    }
+    float32x4_t vr = vld1q_f32(pr);
+    float32x4_t vi = vld1q_f32(pi);
+    const float sr = cos(4 * step);
+    const float si = sin(4 * step);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t x = vld1q_f32(in + i);
+        vst1q_f32(out_i + i, vmulq_f32(x, vr));
+        vst1q_f32(out_q + i, vmulq_f32(x, vi));
+        float32x4_t nr = vmlsq_n_f32(vmulq_n_f32(vr, sr), vi, si);
+        vi = vmlaq_n_f32(vmulq_n_f32(vr, si), vi, sr);
+        vr = nr;
+    }
+#endif
+    double cr = cos(phase + step * i);
+    double ci = sin(phase + step * i);
+    const double sr1 = cos(step);
+    const double si1 = sin(step);
+    for (; i < n; i++) {
+        out_i[i] = in[i] * cr;
+        out_q[i] = in[i] * ci;
+        double nr = cr * sr1 - ci * si1;
+        ci = cr * si1 + ci * sr1;
+        cr = nr;
+    }
+    m_nco_pos += n;
+}
+
+auto CZoomFFT::Impl::comb(const uint64_t* value) -> void {
+    float out[2];
+    for (int c = 0; c < 2; c++) {
+        uint64_t v = value[c];
+        for (int s = 0; s < ZOOM_CIC_ORDER; s++) {
+            uint64_t t = v - m_comb[s][c];
+            m_comb[s][c] = v;
+            v = t;
+        }
+        out[c] = (double)(int64_t)v * m_cic_gain;
+    }
+    m_fir_i[m_fir_len] = out[0];
+    m_fir_q[m_fir_len] = out[1];
+    m_fir_len++;
+}
+
+auto CZoomFFT::Impl::cic(uint32_t n) -> void {
+    int32_t* q = m_quantized.data();
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    for (; i + 4 <= n; i += 4) {
+        int32x4x2_t v;
+        v.val[0] = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&m_mix_i[i]), ZOOM_CIC_SCALE));
+        v.val[1] = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&m_mix_q[i]), ZOOM_CIC_SCALE));
+        vst2q_s32(q + 2 * i, v);
+    }
+#endif
+    for (; i < n; i++) {
+        q[2 * i] = std::clamp(m_mix_i[i] * ZOOM_CIC_SCALE, -2147483520.f, 2147483520.f);
+        q[2 * i + 1] = std::clamp(m_mix_q[i] * ZOOM_CIC_SCALE, -2147483520.f, 2147483520.f);
+    }
+
+    // Integrators wrap around modulo 2^64, the combs remove the wrap
+    uint64_t out[2];
+#ifdef ARCH_ARM
+    uint64x2_t s0 = vld1q_u64(m_integ[0]);
+    uint64x2_t s1 = vld1q_u64(m_integ[1]);
+    uint64x2_t s2 = vld1q_u64(m_integ[2]);
+    for (i = 0; i < n; i++) {
+        uint64x2_t x = vreinterpretq_u64_s64(vmovl_s32(vld1_s32(q + 2 * i)));
+        s0 = vaddq_u64(s0, x);
+        s1 = vaddq_u64(s1, s0);
+        s2 = vaddq_u64(s2, s1);
+        if (++m_cic_count == m_cic_ratio) {
+            m_cic_count = 0;
+            vst1q_u64(out, s2);
+            comb(out);
+        }
+    }
+    vst1q_u64(m_integ[0], s0);
+    vst1q_u64(m_integ[1], s1);
+    vst1q_u64(m_integ[2], s2);
+#else
+    for (i = 0; i < n; i++) {
+        for (int c = 0; c < 2; c++) {
+            m_integ[0][c] += (uint64_t)(int64_t)q[2 * i + c];
+            for (int s = 1; s < ZOOM_CIC_ORDER; s++) {
+                m_integ[s][c] += m_integ[s - 1][c];
+            }
+        }
+        if (++m_cic_count == m_cic_ratio) {
+            m_cic_count = 0;
+            out[0] = m_integ[ZOOM_CIC_ORDER - 1][0];
+            out[1] = m_integ[ZOOM_CIC_ORDER - 1][1];
+            comb(out);
+        }
+    }
+#endif
+}
+
+auto CZoomFFT::Impl::fir() -> void {
+    for (; m_fir_next + ZOOM_FIR_TAPS <= m_fir_len; m_fir_next += 2) {
+        float i = dotProduct(m_fir.data(), &m_fir_i[m_fir_next], ZOOM_FIR_TAPS);
+        float q = dotProduct(m_fir.data(), &m_fir_q[m_fir_next], ZOOM_FIR_TAPS);
+        if (m_skip) {
+            m_skip--;
+        } else if (m_collected < m_fft_size) {
+            m_frame[m_collected].r = i;
+            m_frame[m_collected].i = q;
+            m_collected++;
+        }
+    }
+    uint32_t keep = m_fir_len - m_fir_next;
+    memmove(m_fir_i.data(), &m_fir_i[m_fir_next], keep * sizeof(float));
+    memmove(m_fir_q.data(), &m_fir_q[m_fir_next], keep * sizeof(float));
+    m_fir_len = keep;
+    m_fir_next = 0;
+}
+
+CZoomFFT::CZoomFFT(uint32_t fft_size, uint32_t adc_rate) {
+    m_pimpl = new Impl();
+    m_pimpl->m_fft_size = fft_size;
+    m_pimpl->m_adc_rate = adc_rate;
+    m_pimpl->m_mix_i.resize(ZOOM_BLOCK);
+    m_pimpl->m_mix_q.resize(ZOOM_BLOCK);
+    m_pimpl->m_quantized.resize(ZOOM_BLOCK * 2);
+    m_pimpl->m_fir_i.resize(ZOOM_FIR_TAPS + 1 + ZOOM_BLOCK);
+    m_pimpl->m_fir_q.resize(ZOOM_FIR_TAPS + 1 + ZOOM_BLOCK);
+    m_pimpl->designFilters();
+    if (setFFTSize(fft_size) != 0) {
+        WARNING("Wrong FFT size %d", fft_size)
+    }
+    m_pimpl->reset();
+}
+
+CZoomFFT::~CZoomFFT() {
+    delete m_pimpl;
+}
+
+auto CZoomFFT::setFFTSize(uint32_t size) -> int {
+    if (size < MIN_FFT_SIZE || size > MAX_FFT_SIZE || !isPowerOf2(size)) {
+        WARNING("Wrong FFT size %d", size)
+        return -1;
+    }
+    m_pimpl->m_fft_size = size;
+    m_pimpl->reset();
+    return m_pimpl->initFFT();
+}
+
+auto CZoomFFT::getFFTSize() -> uint32_t {
+    return m_pimpl->m_fft_size;
+}
+
+auto CZoomFFT::setWindow(window_mode_t mode) -> int {
+    double sum = 0;
+    std::vector<cdsp_data_t> window(m_pimpl->m_fft_size);
+    if (createWindow(mode, m_pimpl->m_fft_size, window.data(), &sum) != 0)
+        return -1;
+    m_pimpl->m_window_mode = mode;
+    m_pimpl->m_window.swap(window);
+    m_pimpl->m_window_sum = sum;
+    return 0;
+}
+
+auto CZoomFFT::getWindow() -> window_mode_t {
+    return m_pimpl->m_window_mode;
+}
+
+auto CZoomFFT::setZoom(double center_freq, uint32_t decimation) -> int {
+    if (decimation < 2 || decimation > MAX_DECIMATION || !isPowerOf2(decimation)) {
+        WARNING("Wrong zoom decimation %d", decimation)
+        return -1;
+    }
+    // The band must lie between 0 and the Nyquist frequency, otherwise mirror images of real tones fall into it
+    double half_span = (double)m_pimpl->m_adc_rate / decimation / 2.0;
+    if (center_freq - half_span < 0 || center_freq + half_span > m_pimpl->m_adc_rate / 2.0) {
+        WARNING("Zoom band %f +/- %f Hz is outside of 0 .. fs/2", center_freq, half_span)
+        return -1;
+    }
+    m_pimpl->m_center = center_freq;
+    m_pimpl->m_decimation = decimation;
+    m_pimpl->designFilters();
+    m_pimpl->updateCorrection();
+    m_pimpl->reset();
+    return 0;
+}
+
+auto CZoomFFT::getCenterFreq() -> double {
+    return m_pimpl->m_center;
+}
+
+auto CZoomFFT::getDecimation() -> uint32_t {
+    return m_pimpl->m_decimation;
+}
+
+auto CZoomFFT::getSpan() -> double {
+    return (double)m_pimpl->m_adc_rate / m_pimpl->m_decimation;
+}
+
+auto CZoomFFT::getBinWidth() -> double {
+    return getSpan() / m_pimpl->m_fft_size;
+}
+
+auto CZoomFFT::getInputLength() -> uint64_t {
+    // The first FIR output needs ZOOM_FIR_TAPS CIC outputs, then one output per two
+    uint64_t cic_outputs = ZOOM_FIR_TAPS + 2ull * (ZOOM_SETTLE + m_pimpl->m_fft_size - 1);
+    return cic_outputs * m_pimpl->m_cic_ratio;
+}
+
+auto CZoomFFT::reset() -> void {
+    m_pimpl->reset();
+}
+
+auto CZoomFFT::process(const cdsp_data_t* in, size_t count) -> size_t {
+    size_t used = 0;
+    while (used < count && !isReady()) {
+        uint32_t n = std::min<size_t>(ZOOM_BLOCK, count - used);
+        m_pimpl->mix(in + used, n);
+        if (m_pimpl->m_cic_ratio > 1) {
+            m_pimpl->cic(n);
+        } else {
+            memcpy(&m_pimpl->m_fir_i[m_pimpl->m_fir_len], m_pimpl->m_mix_i.data(), n * sizeof(float));
+            memcpy(&m_pimpl->m_fir_q[m_pimpl->m_fir_len], m_pimpl->m_mix_q.data(), n * sizeof(float));
+            m_pimpl->m_fir_len += n;
+        }
+        m_pimpl->fir();
+        used += n;
+    }
+    return used;
+}
+
+auto CZoomFFT::isReady() -> bool {
+    return m_pimpl->m_collected == m_pimpl->m_fft_size;
+}
+
+auto CZoomFFT::getAmplitude(cdsp_data_t* out) -> int {
+    if (!m_pimpl->m_cfg) {
+        ERROR_LOG("Zoom FFT not initialized");
+        return -1;
+    }
+    if (!isReady()) {
+        ERROR_LOG("Zoom FFT frame is not complete");
+        return -1;
+    }
+    auto size = m_pimpl->m_fft_size;
+    auto frame = m_pimpl->m_frame.data();
+    auto windowed = m_pimpl->m_windowed.data();
+    auto window = m_pimpl->m_window.data();
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    for (; i + 4 <= size; i += 4) {
+        float32x4x2_t v = vld2q_f32(&frame[i].r);
+        float32x4_t w = vld1q_f32(window + i);
+        v.val[0] = vmulq_f32(v.val[0], w);
+        v.val[1] = vmulq_f32(v.val[1], w);
+        vst2q_f32(&windowed[i].r, v);
+    }
+#endif
+    for (; i < size; i++) {
+        windowed[i].r = frame[i].r * window[i];
+        windowed[i].i = frame[i].i * window[i];
+    }
+    kiss_fft(m_pimpl->m_cfg, windowed, m_pimpl->m_spectrum.data());
+
+    // A real tone of amplitude A gives A/2 at baseband, the FFT adds the window sum
+    float scale = 2.0 / m_pimpl->m_window_sum;
+    for (uint32_t j = 0; j < size; j++) {
+        auto& bin = m_pimpl->m_spectrum[(j + size / 2) & (size - 1)];
+        out[j] = sqrtf(bin.r * bin.r + bin.i * bin.i) * scale * m_pimpl->m_correction[j];
+    }
+    return 0;
+}
+
+auto CZoomFFT::getFreqVector(cdsp_data_t* out) -> int {
+    auto size = m_pimpl->m_fft_size;
+    auto bin = getBinWidth();
+    for (uint32_t j = 0; j < size; j++) {
+        out[j] = m_pimpl->m_center + ((double)j - size / 2.0) * bin;
+    }
+    return 0;
+}
+
+auto CZoomFFT::getMemoryUsage() -> size_t {
+    auto bytes = [](const auto& v) { return v.capacity() * sizeof(v[0]); };
+    return sizeof(Impl) + bytes(m_pimpl->m_window) + bytes(m_pimpl->m_fir) + bytes(m_pimpl->m_correction) + bytes(m_pimpl->m_mix_i) + bytes(m_pimpl->m_mix_q) +
+           bytes(m_pimpl->m_quantized) + bytes(m_pimpl->m_fir_i) + bytes(m_pimpl->m_fir_q) + bytes(m_pimpl->m_frame) + bytes(m_pimpl->m_windowed) +
+           bytes(m_pimpl->m_spectrum) + bytes(m_pimpl->m_cfg_mem);
+}
@@ -0,0 +1,81 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya zoom FFT. High resolution spectrum of a narrow band around a centre frequency.
+ *
+ * The input is mixed to baseband with a complex NCO, decimated by a CIC stage
+ * and a FIR half band stage, and transformed with a complex FFT of modest size.
+ * The input is streamed in blocks, so the memory does not depend on the decimation.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __RP_ZOOM_FFT_H__
+#define __RP_ZOOM_FFT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rp_dsp.h"
+
+namespace rp_dsp_api {
+
+class CZoomFFT {
+
+   public:
+    static constexpr uint32_t MIN_FFT_SIZE = 64;
+    static constexpr uint32_t MAX_FFT_SIZE = 65536;
+    static constexpr uint32_t MAX_DECIMATION = 16384;
+
+    // fft_size is the number of output bins, adc_rate the input sample rate in Hz
+    CZoomFFT(uint32_t fft_size, uint32_t adc_rate);
+    ~CZoomFFT();
+
+    // Power of two from MIN_FFT_SIZE to MAX_FFT_SIZE
+    int setFFTSize(uint32_t size);
+    uint32_t getFFTSize();
+
+    int setWindow(window_mode_t mode);
+    window_mode_t getWindow();
+
+    // The span is adc_rate / decimation around center_freq and must lie within 0 .. adc_rate / 2.
+    // The decimation is a power of two from 2 to MAX_DECIMATION.
+    int setZoom(double center_freq, uint32_t decimation);
+    double getCenterFreq();
+    uint32_t getDecimation();
+    double getSpan();
+    double getBinWidth();
+
+    // Input samples needed for one spectrum, including the settling of the filters
+    uint64_t getInputLength();
+
+    // Clears the filter state and the collected samples
+    void reset();
+
+    // Mixes, filters and decimates a block of input samples. Returns the number of samples used.
+    // It is less than count once the spectrum is complete, the rest of the input is not needed.
+    size_t process(const cdsp_data_t* in, size_t count);
+    bool isReady();
+
+    // Peak amplitude per bin from center - span/2 to center + span/2, getFFTSize() values.
+    // The droop of the decimation filters is corrected.
+    int getAmplitude(cdsp_data_t* out);
+    int getFreqVector(cdsp_data_t* out);
+
+    // Bytes of working memory held by the instance
+    size_t getMemoryUsage();
+
+   private:
+    CZoomFFT(const CZoomFFT&) = delete;
+    CZoomFFT(CZoomFFT&&) = delete;
+    CZoomFFT& operator=(const CZoomFFT&) = delete;
+    CZoomFFT& operator=(const CZoomFFT&&) = delete;
+
+    struct Impl;
+    // Pointer to the internal implementation
+    Impl* m_pimpl;
+};
+
+}  // namespace rp_dsp_api
+
+#endif
@@ -247,6 +247,71 @@ print("\nobj.remoteDCCount()")
 res = obj.remoteDCCount()
 print(f"  DC Count: {res}")
 
+print("\n--- FFT Backends ---")
+print(f"  Default backend: {obj.getFFTBackend()}")
+
+# The NEON backend must match kiss_fft, the reference, on the same windowed input
+def fft_magnitudes(backend, size, signals):
+    dsp = rp_dsp.CDSP(2, size, 125000000)
+    dsp.setSignalLength(size)
+    dsp.window_init(rp_dsp.HANNING)
+    res = dsp.setFFTBackend(backend)
+    d = dsp.createData()
+    for ch in range(2):
+        vec = d.getChannelData(ch)
+        for i in range(size):
+            vec[i] = signals[ch][i]
+    dsp.windowFilter(d)
+    dsp.fft(d)
+    return res, dsp.getFFTBackend(), [list(d.m_fft[ch])[:dsp.getOutSignalLength()] for ch in range(2)]
+
+random.seed(1)
+for size in [256, 1024, 16384]:
+    signals = [[math.sin(i * 0.05 * (ch + 1)) + random.uniform(-0.1, 0.1) for i in range(size)] for ch in range(2)]
+    res_k, used_k, kiss_out = fft_magnitudes(rp_dsp.FFT_KISS, size, signals)
+    res_n, used_n, neon_out = fft_magnitudes(rp_dsp.FFT_NEON, size, signals)
+    test_result(f"setFFTBackend size {size}", res_k == 0 and res_n == 0)
+    test_result(f"  Backend in use kiss={used_k} neon={used_n}", used_k == rp_dsp.FFT_KISS and used_n == rp_dsp.FFT_NEON)
+    peak = max(max(kiss_out[0]), max(kiss_out[1]))
+    err = max(abs(a - b) for ch in range(2) for a, b in zip(kiss_out[ch], neon_out[ch]))
+    print(f"    max error {err / peak:.3e} relative to the peak")
+    test_result(f"  NEON FFT matches kiss_fft, size {size}", err / peak < 1e-5)
+
+# Sizes that are not a power of two fall back to kiss_fft
+fallback = rp_dsp.CDSP(2, 1000, 125000000)
+fallback.setSignalLengthDiv2(1000)
+res = fallback.setFFTBackend(rp_dsp.FFT_NEON)
+test_result("NEON falls back to kiss_fft for size 1000", res == 0 and fallback.getFFTBackend() == rp_dsp.FFT_KISS)
+fallback = None
+
+print("\n--- Channel Threads ---")
+print(f"  Default threads: {obj.getThreads()}")
+test_result("setThreads(0) rejected", obj.setThreads(0) != 0)
+
+# Four channels on one and two threads must give the same spectra
+def four_channel_spectra(threads):
+    size = 8192
+    dsp = rp_dsp.CDSP(4, size, 125000000)
+    dsp.setSignalLength(size)
+    dsp.window_init(rp_dsp.HANNING)
+    res = dsp.setThreads(threads)
+    d = dsp.createData()
+    for ch in range(4):
+        vec = d.getChannelData(ch)
+        for i in range(size):
+            vec[i] = math.sin(i * 0.01 * (ch + 1))
+    dsp.prepareFreqVector(d, 1.0)
+    dsp.windowFilter(d)
+    dsp.fft(d)
+    dsp.decimate(d, dsp.getOutSignalLength(), dsp.getOutSignalLength())
+    dsp.cnvToMetric(d, 1)
+    return res, [list(d.m_converted.m_result[rp_dsp.DBM][ch])[:dsp.getOutSignalLength()] for ch in range(4)]
+
+res_1, spectra_1 = four_channel_spectra(1)
+res_2, spectra_2 = four_channel_spectra(2)
+test_result("setThreads(1), setThreads(2)", res_1 == 0 and res_2 == 0)
+test_result("Same spectra on 1 and 2 threads", spectra_1 == spectra_2)
+
 # ============================================================================
 # SECTION 3: Basic Math Function Tests
 # ============================================================================
@@ -870,7 +935,33 @@ except AttributeError as e:
     print(f"  [SKIP] divide_arrays_neon_Ex not available: {e}")
 
 # ============================================================================
-# SECTION 11: Cleanup
+# SECTION 11: Min/Max Reduction
+# ============================================================================
+
+test_section_header("Min/Max Reduction (minmax_sum_float_neon)")
+
+try:
+    print("\n--- minmax_sum_float_neon Tests ---")
+
+    for size in [1, 7, 16, 33, 1000, 16384]:
+        src = rp_dsp.arrFloat(size)
+        values = [random.uniform(-1.0, 1.0) for _ in range(size)]
+        for i, v in enumerate(values):
+            src[i] = v
+        # Narrow glitch must survive the reduction
+        glitch = size // 2
+        src[glitch] = 5.0
+        values[glitch] = 5.0
+
+        vmin, vmax, vsum = rp_dsp.minmax_sum_float_neon(src.cast(), size)
+        passed = compare_float(vmin, min(values), 1e-6) and compare_float(vmax, max(values), 1e-6) and compare_double(vsum, sum(values), 1e-4)
+        test_result(f"minmax_sum_float_neon size={size} min={vmin:.4f} max={vmax:.4f}", passed)
+
+except AttributeError as e:
+    print(f"  [SKIP] min/max reduction not available: {e}")
+
+# ============================================================================
+# SECTION 12: Cleanup
 # ============================================================================
 
 test_section_header("Cleanup")
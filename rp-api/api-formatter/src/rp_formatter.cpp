@@ -7,7 +7,9 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <sstream>
@@ -22,10 +24,33 @@
 
 namespace rp_formatter_api {
 
+#define STREAM_DEFAULT_SEGMENT 65536
+#define STREAM_MAX_PENDING_SEGMENTS 16
+
+struct SStreamChannel {
+    rp_bits_t m_bits;
+    std::string m_name;
+    std::vector<uint8_t> m_data;
+    size_t m_offset = 0;  // Bytes of m_data already written
+
+    auto pending() const -> size_t { return (m_data.size() - m_offset) / SBufferPack::getBytesCount(m_bits); }
+
+    auto consume(size_t _samples) -> void {
+        m_offset += _samples * SBufferPack::getBytesCount(m_bits);
+        // Move the tail to the front only when it is cheap compared to what was written
+        if (m_offset >= m_data.size() / 2) {
+            m_data.erase(m_data.begin(), m_data.begin() + m_offset);
+            m_offset = 0;
+        }
+    }
+};
+
 struct CFormatter::Impl {
     rp_mode_t m_mode;
     uint32_t m_oscRate;
     SBufferPack m_pack;
+    std::map<rp_channel_t, SStreamChannel> m_stream;
+    size_t m_segmentSamples = STREAM_DEFAULT_SEGMENT;
     std::fstream* m_file = NULL;
     CWaveWriter* m_wave = NULL;
     CTDMSWriter* m_tdms = NULL;
@@ -38,6 +63,9 @@ struct CFormatter::Impl {
     };
 
     auto setChannelData(rp_channel_t _channel, void* _buffer, size_t _samplesCount, rp_bits_t _bits, std::string& _name) -> void;
+    auto appendChannelData(rp_channel_t _channel, const void* _buffer, size_t _samplesCount, rp_bits_t _bits, std::string& _name) -> bool;
+    auto flushStream(bool _all) -> bool;
+    auto writePack(SBufferPack* _pack, std::iostream* _memory) -> bool;
     auto getMaxSamples() -> size_t;
 };
 
@@ -168,6 +196,8 @@ auto CFormatter::openFile(std::string _path) -> bool {
 
 auto CFormatter::closeFile() -> bool {
     if (m_pimpl->m_file) {
+        m_pimpl->flushStream(true);
+        m_pimpl->m_stream.clear();
         if (m_pimpl->m_file->is_open()) {
             m_pimpl->m_file->flush();
             m_pimpl->m_file->close();
@@ -188,37 +218,161 @@ auto CFormatter::isOpenFile() -> bool {
     return false;
 }
 
+auto CFormatter::Impl::writePack(SBufferPack* _pack, std::iostream* _memory) -> bool {
+    if (m_wave) {
+        return m_wave->writeToStream(_pack, _memory);
+    }
+    if (m_tdms) {
+        return m_tdms->writeToStream(_pack, _memory);
+    }
+    if (m_csv) {
+        return m_csv->writeToStream(_pack, _memory);
+    }
+    return false;
+}
+
 auto CFormatter::writeToFile() -> bool {
     if (!isOpenFile()) {
         return false;
     }
-    if (m_pimpl->m_wave) {
-        return m_pimpl->m_wave->writeToStream(&m_pimpl->m_pack, m_pimpl->m_file);
+    return m_pimpl->writePack(&m_pimpl->m_pack, m_pimpl->m_file);
+}
+
+auto CFormatter::writeToStream(std::iostream* _memory) -> bool {
+    return m_pimpl->writePack(&m_pimpl->m_pack, _memory);
+}
+
+auto CFormatter::getMaxSamples() -> size_t {
+    return m_pimpl->getMaxSamples();
+}
+
+
+auto CFormatter::Impl::appendChannelData(rp_channel_t _channel, const void* _buffer, size_t _samplesCount, rp_bits_t _bits, std::string& _name) -> bool {
+    if (!m_file || !m_file->is_open()) {
+        return false;
     }
-    if (m_pimpl->m_tdms) {
-        return m_pimpl->m_tdms->writeToStream(&m_pimpl->m_pack, m_pimpl->m_file);
+    auto search = m_stream.find(_channel);
+    if (search == m_stream.end()) {
+        search = m_stream.emplace(_channel, SStreamChannel()).first;
+        search->second.m_bits = _bits;
+        search->second.m_name = _name;
+    } else if (search->second.m_bits != _bits) {
+        fprintf(stderr, "[ERROR] CFormatter::appendChannel sample type of channel %s changed\n", SBufferPack::getChannelName(_channel));
+        return false;
     }
-    if (m_pimpl->m_csv) {
-        return m_pimpl->m_csv->writeToStream(&m_pimpl->m_pack, m_pimpl->m_file);
+    auto& ch = search->second;
+    if (ch.pending() + _samplesCount > m_segmentSamples * STREAM_MAX_PENDING_SEGMENTS) {
+        fprintf(stderr, "[ERROR] CFormatter::appendChannel channel %s is too far ahead of the other channels\n", SBufferPack::getChannelName(_channel));
+        return false;
     }
-    return false;
+    auto bytes = _samplesCount * SBufferPack::getBytesCount(_bits);
+    auto pos = ch.m_data.size();
+    ch.m_data.resize(pos + bytes);
+    memcpy(ch.m_data.data() + pos, _buffer, bytes);
+    return flushStream(false);
 }
 
-auto CFormatter::writeToStream(std::iostream* _memory) -> bool {
-    if (m_pimpl->m_wave) {
-        return m_pimpl->m_wave->writeToStream(&m_pimpl->m_pack, _memory);
+auto CFormatter::Impl::flushStream(bool _all) -> bool {
+    if (!m_file || !m_file->is_open()) {
+        return false;
     }
-    if (m_pimpl->m_tdms) {
-        return m_pimpl->m_tdms->writeToStream(&m_pimpl->m_pack, _memory);
+    while (m_stream.size()) {
+        size_t minPending = SIZE_MAX;
+        size_t maxPending = 0;
+        for (auto& [_, ch] : m_stream) {
+            minPending = std::min(minPending, ch.pending());
+            maxPending = std::max(maxPending, ch.pending());
+        }
+        size_t count = 0;
+        if (minPending >= m_segmentSamples) {
+            count = m_segmentSamples;
+        } else if (_all && maxPending > 0) {
+            // Last segment. Channels can end with different lengths.
+            count = std::min(maxPending, m_segmentSamples);
+        } else {
+            break;
+        }
+
+        SBufferPack pack;
+        for (auto& [channel, ch] : m_stream) {
+            pack.m_bits[channel] = ch.m_bits;
+            pack.m_samplesCount[channel] = std::min(count, ch.pending());
+            pack.m_buffer[channel] = ch.m_data.data() + ch.m_offset;
+            pack.m_name[channel] = ch.m_name;
+        }
+        if (!writePack(&pack, m_file)) {
+            return false;
+        }
+        for (auto& [channel, ch] : m_stream) {
+            ch.consume(pack.m_samplesCount[channel]);
+        }
     }
-    if (m_pimpl->m_csv) {
-        return m_pimpl->m_csv->writeToStream(&m_pimpl->m_pack, _memory);
+    return true;
+}
+
+template <typename T>
+auto CFormatter::appendChannel(rp_channel_t _channel, const T* _buffer, size_t _samplesCount, std::string _name) -> bool {
+    return m_pimpl->appendChannelData(_channel, _buffer, _samplesCount, SSampleType<T>::bits, _name);
+}
+
+template auto CFormatter::appendChannel<uint8_t>(rp_channel_t, const uint8_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<uint16_t>(rp_channel_t, const uint16_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<int32_t>(rp_channel_t, const int32_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<uint32_t>(rp_channel_t, const uint32_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<int64_t>(rp_channel_t, const int64_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<uint64_t>(rp_channel_t, const uint64_t*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<float>(rp_channel_t, const float*, size_t, std::string) -> bool;
+template auto CFormatter::appendChannel<double>(rp_channel_t, const double*, size_t, std::string) -> bool;
+
+auto CFormatter::appendChannelUI8NP(rp_channel_t _channel, uint8_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelUI16NP(rp_channel_t _channel, uint16_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelI32NP(rp_channel_t _channel, int32_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelUI32NP(rp_channel_t _channel, uint32_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelI64NP(rp_channel_t _channel, int64_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelUI64NP(rp_channel_t _channel, uint64_t* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelFNP(rp_channel_t _channel, float* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::appendChannelDNP(rp_channel_t _channel, double* _np_buffer, int _samplesCount, std::string _name) -> bool {
+    return appendChannel(_channel, _np_buffer, _samplesCount, _name);
+}
+
+auto CFormatter::setSegmentSize(size_t _samples) -> void {
+    m_pimpl->m_segmentSamples = std::max<size_t>(_samples, 1);
+}
+
+auto CFormatter::getSegmentSize() -> size_t {
+    return m_pimpl->m_segmentSamples;
+}
+
+auto CFormatter::getPendingSamples(rp_channel_t _channel) -> size_t {
+    if (auto search = m_pimpl->m_stream.find(_channel); search != m_pimpl->m_stream.end()) {
+        return search->second.pending();
     }
-    return false;
+    return 0;
 }
 
-auto CFormatter::getMaxSamples() -> size_t {
-    return m_pimpl->getMaxSamples();
+auto CFormatter::flush(bool _all) -> bool {
+    return m_pimpl->flushStream(_all);
 }
 
 }  // namespace rp_formatter_api
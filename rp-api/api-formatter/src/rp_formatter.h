@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <string>
 
 namespace rp_formatter_api {
 
@@ -74,6 +75,35 @@ class CFormatter {
 
     auto getMaxSamples() -> size_t;
 
+    /**
+     * Streaming mode.
+     * Chunks are copied into a queue per channel. As soon as every channel has
+     * getSegmentSize() samples queued, a segment is written to the file opened with openFile().
+     * The remaining samples are written by flush(true) or closeFile().
+     * Returns false if no file is open, the sample type of the channel changed,
+     * or the channel is more than 16 segments ahead of the others.
+     */
+    template <typename T>
+    auto appendChannel(rp_channel_t _channel, const T* _buffer, size_t _samplesCount, std::string _name = "") -> bool;
+
+    auto appendChannelUI8NP(rp_channel_t _channel, uint8_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelUI16NP(rp_channel_t _channel, uint16_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelI32NP(rp_channel_t _channel, int32_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelUI32NP(rp_channel_t _channel, uint32_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelI64NP(rp_channel_t _channel, int64_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelUI64NP(rp_channel_t _channel, uint64_t* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelFNP(rp_channel_t _channel, float* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+    auto appendChannelDNP(rp_channel_t _channel, double* _np_buffer, int _samplesCount, std::string _name = "") -> bool;
+
+    auto setSegmentSize(size_t _samples) -> void;
+    auto getSegmentSize() -> size_t;
+    auto getPendingSamples(rp_channel_t _channel) -> size_t;
+
+    /**
+     * Writes all complete segments. With _all set, also writes the incomplete tail of every channel.
+     */
+    auto flush(bool _all = false) -> bool;
+
    private:
     CFormatter(const CFormatter&) = delete;
     CFormatter(CFormatter&&) = delete;
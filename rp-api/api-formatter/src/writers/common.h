@@ -76,6 +76,8 @@ struct SBufferPack {
         }
     }
 
+    static auto getBytesCount(rp_bits_t type) -> uint8_t { return getBitsCount(type) / 8; }
+
     static const char* getChannelName(rp_channel_t channel) {
         static const char* names[] = {"CH1", "CH2", "CH3", "CH4", "CH5", "CH6", "CH7", "CH8", "CH9", "CH10", "TIME", "INDEX"};
 
@@ -86,6 +88,42 @@ struct SBufferPack {
     }
 };
 
+// Maps a sample type to its rp_bits_t tag at compile time
+template <typename T>
+struct SSampleType;
+template <>
+struct SSampleType<uint8_t> {
+    static constexpr rp_bits_t bits = RP_F_ui8_Bit;
+};
+template <>
+struct SSampleType<uint16_t> {
+    static constexpr rp_bits_t bits = RP_F_ui16_Bit;
+};
+template <>
+struct SSampleType<uint32_t> {
+    static constexpr rp_bits_t bits = RP_F_ui32_Bit;
+};
+template <>
+struct SSampleType<int32_t> {
+    static constexpr rp_bits_t bits = RP_F_i32_Bit;
+};
+template <>
+struct SSampleType<uint64_t> {
+    static constexpr rp_bits_t bits = RP_F_ui64_Bit;
+};
+template <>
+struct SSampleType<int64_t> {
+    static constexpr rp_bits_t bits = RP_F_i64_Bit;
+};
+template <>
+struct SSampleType<float> {
+    static constexpr rp_bits_t bits = RP_F_f32_Bit;
+};
+template <>
+struct SSampleType<double> {
+    static constexpr rp_bits_t bits = RP_F_d64_Bit;
+};
+
 }  // namespace rp_formatter_api
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
  */
 
 #include <cassert>
+#include <charconv>
 #include <chrono>
 #include <ctime>
 #include <fstream>
@@ -15,6 +16,7 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include "rp_csv_writer.h"
@@ -26,9 +28,57 @@ struct CCSVWriter::Impl {
     uint32_t m_OSCRate;
     string m_devider = ",";
     bool m_initHeader = true;
+    size_t m_rowsWritten = 0;
     auto write(SBufferPack* _pack, std::iostream* _memory) -> bool;
 };
 
+namespace {
+
+typedef void (*append_value_t)(std::string& _s, const void* _buffer, size_t _index);
+
+// Same text as std::to_string, without the temporary string per sample
+template <typename T>
+auto appendValue(std::string& _s, const void* _buffer, size_t _index) -> void {
+    char buf[512];
+    auto value = static_cast<const T*>(_buffer)[_index];
+    std::to_chars_result res;
+    if constexpr (std::is_floating_point_v<T>) {
+        res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, 6);
+    } else {
+        res = std::to_chars(buf, buf + sizeof(buf), value);
+    }
+    if (res.ec == std::errc()) {
+        _s.append(buf, res.ptr - buf);
+    } else {
+        _s += std::to_string(value);
+    }
+}
+
+auto getAppendValue(rp_bits_t _bits) -> append_value_t {
+    switch (_bits) {
+        case RP_F_ui8_Bit:
+            return appendValue<uint8_t>;
+        case RP_F_ui16_Bit:
+            return appendValue<uint16_t>;
+        case RP_F_ui32_Bit:
+            return appendValue<uint32_t>;
+        case RP_F_i32_Bit:
+            return appendValue<int32_t>;
+        case RP_F_ui64_Bit:
+            return appendValue<uint64_t>;
+        case RP_F_i64_Bit:
+            return appendValue<int64_t>;
+        case RP_F_f32_Bit:
+            return appendValue<float>;
+        case RP_F_d64_Bit:
+            return appendValue<double>;
+        default:
+            return NULL;
+    }
+}
+
+}  // namespace
+
 CCSVWriter::CCSVWriter(uint32_t _oscRate) {
     m_pimpl = new Impl();
     m_pimpl->m_OSCRate = _oscRate;
@@ -40,6 +90,7 @@ CCSVWriter::~CCSVWriter() {
 
 auto CCSVWriter::resetHeaderInit() -> void {
     m_pimpl->m_initHeader = true;
+    m_pimpl->m_rowsWritten = 0;
 }
 
 auto CCSVWriter::Impl::write(SBufferPack* _pack, std::iostream* _memory) -> bool {
@@ -69,71 +120,47 @@ auto CCSVWriter::Impl::write(SBufferPack* _pack, std::iostream* _memory) -> bool
 
         s += "\r\n";
         _memory->write(s.c_str(), s.length());
+        m_initHeader = false;
     }
     size_t max_samples = 0;
     rp_channel_t all_fields[] = {RP_F_INDEX, RP_F_TIME, RP_F_CH1, RP_F_CH2, RP_F_CH3, RP_F_CH4, RP_F_CH5, RP_F_CH6, RP_F_CH7, RP_F_CH8, RP_F_CH9, RP_F_CH10};
 
+    // Resolve the formatting function of every column once instead of per sample
+    std::vector<append_value_t> columnFunc;
+    std::vector<const void*> columnBuffer;
+    std::vector<size_t> columnSamples;
     for (auto ch : all_fields) {
         if (_pack->m_buffer.count(ch)) {
+            columnFunc.push_back(getAppendValue(_pack->m_bits[ch]));
+            columnBuffer.push_back(_pack->m_buffer[ch]);
+            columnSamples.push_back(_pack->m_samplesCount[ch]);
             max_samples = std::max(max_samples, (size_t)_pack->m_samplesCount[ch]);
         }
     }
 
+    // Rows are separated by a line break, the last row of the file has none
+    const size_t rows_per_write = 4096;
+    std::string s;
+    s.reserve(rows_per_write * columnFunc.size() * 16);
     for (size_t i = 0; i < max_samples; i++) {
-        std::string s = "";
-        bool first_in_row = true;
-
-        for (auto ch : all_fields) {
-            if (_pack->m_buffer.count(ch)) {
-                if (!first_in_row)
-                    s += m_devider;
-                first_in_row = false;
-
-                if (i < _pack->m_samplesCount[ch]) {
-                    void* ptr = _pack->m_buffer[ch];
-                    auto bit = _pack->m_bits[ch];
-
-                    switch (bit) {
-                        case RP_F_ui8_Bit:
-                            s += std::to_string(((uint8_t*)ptr)[i]);
-                            break;
-                        case RP_F_ui16_Bit:
-                            s += std::to_string(((uint16_t*)ptr)[i]);
-                            break;
-                        case RP_F_ui32_Bit:
-                            s += std::to_string(((uint32_t*)ptr)[i]);
-                            break;
-                        case RP_F_i32_Bit:
-                            s += std::to_string(((int32_t*)ptr)[i]);
-                            break;
-                        case RP_F_ui64_Bit:
-                            s += std::to_string(((uint64_t*)ptr)[i]);
-                            break;
-                        case RP_F_i64_Bit:
-                            s += std::to_string(((int64_t*)ptr)[i]);
-                            break;
-                        case RP_F_f32_Bit:
-                            s += std::to_string(((float*)ptr)[i]);
-                            break;
-                        case RP_F_d64_Bit:
-                            s += std::to_string(((double*)ptr)[i]);
-                            break;
-                        default:
-                            s += "0";
-                            break;
-                    }
-                } else {
-                    s += "0";
-                }
+        if (m_rowsWritten++ > 0) {
+            s += "\r\n";
+        }
+        for (size_t c = 0; c < columnFunc.size(); c++) {
+            if (c > 0)
+                s += m_devider;
+            if (i < columnSamples[c] && columnFunc[c]) {
+                columnFunc[c](s, columnBuffer[c], i);
+            } else {
+                s += "0";
             }
         }
-
-        if (i < max_samples - 1) {
-            s += "\r\n";
+        if ((i + 1) % rows_per_write == 0) {
+            _memory->write(s.c_str(), s.length());
+            s.clear();
         }
-
-        _memory->write(s.c_str(), s.length());
     }
+    _memory->write(s.c_str(), s.length());
 
     return true;
 }
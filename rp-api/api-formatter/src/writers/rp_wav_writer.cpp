@@ -7,6 +7,7 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <map>
@@ -23,6 +24,7 @@ struct CWaveWriter::Impl {
     uint8_t m_bitDepth;
     uint32_t m_samplesPerChannel;
     uint32_t m_OSCRate;
+    uint64_t m_dataSize;  // Bytes of samples written since the header
     rp_endianness_t m_endianness;
     std::fstream* m_file = NULL;
 
@@ -85,8 +87,9 @@ auto CWaveWriter::resetHeaderInit() -> void {
 }
 
 auto CWaveWriter::Impl::buildHeader(std::iostream* memory) -> void {
-    int sampleRate = 44100;
-    int32_t dataChunkSize = m_samplesPerChannel * m_numChannels * (m_bitDepth / 8);
+    // Sizes start at zero and are increased by updateSize after every block of samples
+    m_dataSize = 0;
+    int32_t dataChunkSize = 0;
     int16_t data_format = m_bitDepth == 32 ? 0x0003 : 0x0001;
     addStringToFileData(memory, "RIFF");
 
@@ -102,7 +105,7 @@ auto CWaveWriter::Impl::buildHeader(std::iostream* memory) -> void {
     addInt16ToFileData(memory, (int16_t)m_numChannels, m_endianness);  // num channels
     addInt32ToFileData(memory, (int32_t)m_OSCRate, m_endianness);      // sample rate
 
-    int32_t numBytesPerSecond = (int32_t)((m_numChannels * sampleRate * m_bitDepth) / 8);
+    int32_t numBytesPerSecond = (int32_t)(((uint64_t)m_numChannels * m_OSCRate * m_bitDepth) / 8);
     addInt32ToFileData(memory, numBytesPerSecond, m_endianness);
 
     int16_t numBytesPerBlock = m_numChannels * (m_bitDepth / 8);
@@ -146,12 +149,12 @@ auto CWaveWriter::Impl::write(SBufferPack* _pack, std::iostream* _memory) -> boo
         }
     }
 
-    if (maxBitBySample > RP_F_f32_Bit) {
-        maxBitBySample = RP_F_f32_Bit;
+    if (maxBitBySample > SBufferPack::getBitsCount(RP_F_f32_Bit)) {
+        maxBitBySample = SBufferPack::getBitsCount(RP_F_f32_Bit);
     }
 
     m_samplesPerChannel = maxSamples;
-    auto m_bitDepth = maxBitBySample;
+    m_bitDepth = maxBitBySample;
 
     // std::stringstream *memory = new std::stringstream(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
     if (m_headerInit) {
@@ -255,27 +258,20 @@ auto CWaveWriter::writeToStream(SBufferPack* _pack, std::iostream* _memory) -> b
     return m_pimpl->write(_pack, _memory);
 }
 
+// RIFF sizes are unsigned 32 bit. Above 4 GB they stay at 0xFFFFFFFF, which most readers take as "up to the end of the file".
 auto CWaveWriter::Impl::updateSize(std::iostream* _memory, size_t _size) -> void {
-    int offset1 = 4;
-    int offset2 = 40;
+    const std::streamoff offsetRiff = 4;
+    const std::streamoff offsetData = 40;
+    const uint64_t headerTail = 4 + 24 + 8;  // "WAVE", fmt chunk and data chunk header
 
-    auto cur_p = _memory->tellp();
-    auto cur_g = _memory->tellg();
-
-    int32_t size1 = 0;
-    int32_t size2 = 0;
-    _memory->seekg(offset1, _memory->beg);
-    _memory->read((char*)&size1, sizeof(size1));
-
-    size1 += _size;
-    _memory->seekp(offset1, _memory->beg);
-    _memory->write((char*)&size1, sizeof(size1));
-    _memory->seekg(offset2, _memory->beg);
-    _memory->read((char*)&size2, sizeof(size2));
-    size2 += _size;
-    _memory->seekp(offset2, _memory->beg);
-    _memory->write((char*)&size2, sizeof(size2));
+    m_dataSize += _size;
+    auto riffSize = (uint32_t)std::min<uint64_t>(m_dataSize + headerTail, UINT32_MAX);
+    auto dataSize = (uint32_t)std::min<uint64_t>(m_dataSize, UINT32_MAX);
 
+    auto cur_p = _memory->tellp();
+    _memory->seekp(offsetRiff, _memory->beg);
+    addInt32ToFileData(_memory, (int32_t)riffSize, m_endianness);
+    _memory->seekp(offsetData, _memory->beg);
+    addInt32ToFileData(_memory, (int32_t)dataSize, m_endianness);
     _memory->seekp(cur_p);
-    _memory->seekg(cur_g);
 }
@@ -0,0 +1,45 @@
+#!/usr/bin/python3
+
+# Writes a long recording through the streaming API and reports throughput and peak memory.
+# Usage: rp_formatter_stream_bench.py [size_MB] [wav|tdms|csv] [path]
+
+import resource
+import sys
+import time
+import numpy as np
+from rp_formatter import *
+
+size_mb = int(sys.argv[1]) if len(sys.argv) > 1 else 1024
+mode_name = sys.argv[2] if len(sys.argv) > 2 else "wav"
+path = sys.argv[3] if len(sys.argv) > 3 else "/tmp/stream_bench." + mode_name
+
+modes = {"wav": RP_F_WAV, "tdms": RP_F_TDMS, "csv": RP_F_CSV}
+channels = [RP_F_CH1, RP_F_CH2]
+chunk = 16384
+
+# Samples of raw float data to push. CSV output is several times larger than the input.
+total = size_mb * 1024 * 1024 // (4 * len(channels))
+data = [np.sin(np.arange(chunk, dtype=np.float32) / (100 + i)).astype(np.float32) for i in range(len(channels))]
+
+obj = CFormatter(modes[mode_name], 125000000)
+if not obj.openFile(path):
+    print("Failed open", path)
+    sys.exit(1)
+
+rss_start = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+start = time.monotonic()
+pushed = 0
+while pushed < total:
+    for i, ch in enumerate(channels):
+        if not obj.appendChannelFNP(ch, data[i]):
+            print("appendChannelFNP failed at sample", pushed)
+            sys.exit(1)
+    pushed += chunk
+obj.closeFile()
+elapsed = time.monotonic() - start
+rss_end = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+mb = pushed * 4 * len(channels) / 1024 / 1024
+print("Mode:", mode_name)
+print("Input: %.1f MB in %.2f s (%.1f MB/s)" % (mb, elapsed, mb / elapsed))
+print("Peak RSS growth: %d kB" % (rss_end - rss_start))
@@ -524,4 +524,36 @@ print(res)
 
 print("obj2.closeFile()")
 res = obj2.closeFile()
-print(res)
\ No newline at end of file
+print(res)
+
+# Streaming mode
+
+for mode, name in [(RP_F_WAV, "test_stream.wav"), (RP_F_TDMS, "test_stream.tdms"), (RP_F_CSV, "test_stream.csv")]:
+    print("CFormatter(" + str(mode) + ",125000000)")
+    obj3 = CFormatter(mode,125000000)
+
+    print("obj3.setSegmentSize(4096)")
+    res = obj3.setSegmentSize(4096)
+    print(res)
+
+    print("obj3.openFile('" + name + "')")
+    res = obj3.openFile(name)
+    print(res)
+
+    chunk = 1000
+    for k in range(20):
+        t = np.arange(k * chunk, (k + 1) * chunk, dtype=np.float32)
+        print("obj3.appendChannelFNP(RP_F_CH1,chunk " + str(k) + ")")
+        res = obj3.appendChannelFNP(RP_F_CH1,np.sin(t / 100).astype(np.float32))
+        print(res)
+        print("obj3.appendChannelFNP(RP_F_CH2,chunk " + str(k) + ")")
+        res = obj3.appendChannelFNP(RP_F_CH2,np.cos(t / 100).astype(np.float32))
+        print(res)
+
+    print("obj3.getPendingSamples(RP_F_CH1)")
+    res = obj3.getPendingSamples(RP_F_CH1)
+    print(res)
+
+    print("obj3.closeFile()")
+    res = obj3.closeFile()
+    print(res)
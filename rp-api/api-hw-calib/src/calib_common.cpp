@@ -16,7 +16,6 @@
 #define REVISION_STR XSTR(REVISION)
 #endif
 
-static const char eeprom_device[] = "/sys/bus/i2c/devices/0-0050/eeprom";
 static const int eeprom_calib_off = 0x0000;
 static const int eeprom_calib_factory_off = 0x1c00;
 
@@ -38,85 +37,39 @@ uint_gain_calib_t convertFloatToInt(channel_calib_t* param, uint8_t precision) {
 }
 
 uint8_t* readParams(uint16_t* size, bool use_factory_zone) {
-    FILE* fp;
-
-    /* open EEPROM device */
-    fp = fopen(eeprom_device, "r");
-    if (fp == NULL) {
-        ERROR_LOG("Error opening eeprom file.");
-        return NULL;
-    }
-
-    /* ...and seek to the appropriate storage offset */
     int offset = use_factory_zone ? eeprom_calib_factory_off : eeprom_calib_off;
-    if (fseek(fp, offset, SEEK_SET) < 0) {
-        fclose(fp);
-        return NULL;
-    }
 
     uint8_t* buf = (uint8_t*)malloc(*size);
     if (!buf) {
         ERROR_LOG("Memory allocation error.");
-        fclose(fp);
         return NULL;
     }
 
-    *size = fread(buf, sizeof(char), *size, fp);
-    fclose(fp);
+    /* served from the EEPROM snapshot when it is valid */
+    uint32_t read_size = 0;
+    if (rp_HPReadEEPROM(offset, buf, *size, &read_size) != RP_HP_OK) {
+        ERROR_LOG("Error reading eeprom.");
+        free(buf);
+        return NULL;
+    }
+    *size = read_size;
     return buf;
 }
 
 uint8_t* readHeader(uint16_t* size, bool use_factory_zone) {
-    FILE* fp;
-
-    /* open EEPROM device */
-    fp = fopen(eeprom_device, "r");
-    if (fp == NULL) {
-        ERROR_LOG("Error opening eeprom file.");
-        return NULL;
-    }
-
-    /* ...and seek to the appropriate storage offset */
-    int offset = use_factory_zone ? eeprom_calib_factory_off : eeprom_calib_off;
-    if (fseek(fp, offset, SEEK_SET) < 0) {
-        fclose(fp);
-        return NULL;
-    }
-
-    uint8_t* buf = (uint8_t*)malloc(*size);
-    if (!buf) {
-        ERROR_LOG("Memory allocation error.");
-        fclose(fp);
-        return NULL;
-    }
-
-    *size = fread(buf, sizeof(char), *size, fp);
-    fclose(fp);
-    return buf;
+    return readParams(size, use_factory_zone);
 }
 
 int writeParams(uint8_t* buffer, uint16_t size, bool use_factory_zone) {
-    FILE* fp;
-
-    /* open EEPROM device */
-    fp = fopen(eeprom_device, "w+");
-    if (fp == NULL) {
-        ERROR_LOG("Error opening eeprom file.");
-        return -1;
-    }
-
-    /* ...and seek to the appropriate storage offset */
     int offset = use_factory_zone ? eeprom_calib_factory_off : eeprom_calib_off;
-    if (fseek(fp, offset, SEEK_SET) < 0) {
-        fclose(fp);
+
+    /* write data to EEPROM component, this also drops the EEPROM snapshot */
+    uint32_t written_size = 0;
+    if (rp_HPWriteEEPROM(offset, buffer, size, &written_size) != RP_HP_OK) {
+        ERROR_LOG("Error writing eeprom.");
         return -1;
     }
-
-    /* write data to EEPROM component */
-    size = fwrite(buffer, sizeof(char), size, fp);
-    fclose(fp);
-
-    return size;
+    return written_size;
 }
 
 uint8_t* readFromEpprom(uint16_t* size) {
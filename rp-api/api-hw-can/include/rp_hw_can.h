@@ -49,6 +49,9 @@
 #define RP_HW_CAN_ESFS 24  // Failed apply filter
 #define RP_HW_CAN_ESEF 25  // Failed to set error handling
 #define RP_HW_CAN_ESR 26   // Failed read frame from socket
+#define RP_HW_CAN_ECAS 27  // Failed. Capture already started
+#define RP_HW_CAN_ECNS 28  // Failed. Capture not started
+#define RP_HW_CAN_ECS 29   // Failed start capture
 
 ///@}
 
@@ -57,7 +60,8 @@
  */
 typedef enum {
     RP_CAN_0 = 0, /* can0 interface */
-    RP_CAN_1 = 1, /* can1 interface */
+    RP_CAN_1 = 1,      /* can1 interface */
+    RP_CAN_VCAN_0 = 2, /* vcan0 virtual interface. Used for testing without hardware */
 } rp_can_interface_t;
 
 typedef struct {
@@ -107,6 +111,26 @@ typedef struct {
     uint8_t data[8];
 } rp_can_frame_t;
 
+/**
+ * Frame stored by the capture engine. The layout is fixed (24 bytes, little endian on the board)
+ * so that arrays of frames can be passed as raw byte buffers to Python and SCPI.
+ */
+typedef struct {
+    uint64_t timestamp_ns; /* Receive time in nanoseconds. Hardware timestamp if enabled on the interface, otherwise kernel software timestamp (CLOCK_REALTIME) */
+    uint32_t can_id_raw;   /* CAN id with EFF/RTR/ERR flags, as in struct can_frame */
+    uint8_t can_dlc;
+    uint8_t reserved[3];
+    uint8_t data[8];
+} rp_can_capture_frame_t;
+
+typedef struct {
+    uint64_t received;        /* Frames received from the socket and stored in the capture ring */
+    uint64_t dropped_ring;    /* Frames lost because the capture ring was full */
+    uint64_t dropped_socket;  /* Frames dropped by the kernel because the socket queue was full */
+    uint64_t hw_timestamped;  /* Frames with a hardware timestamp */
+    bool hw_timestamping;     /* Hardware receive timestamps were enabled on the interface (SIOCSHWTSTAMP) */
+} rp_can_capture_stats_t;
+
 /**
  * Retrieves the library version number
  * @return Library version
@@ -433,4 +457,83 @@ int rp_CanSetFilter(rp_can_interface_t interface, bool isJoinFilter);
 */
 int rp_CanShowErrorFrames(rp_can_interface_t interface, bool enable);
 
+/**
+* Starts a background capture of the interface.
+* The capture uses its own socket and reads frames in batches into a ring buffer, so frames are not lost between calls to rp_CanCaptureRead.
+* Filters from the filter list are applied to the capture socket when the capture starts.
+* @param interface  Selected interface
+* @param ring_size Number of frames the ring can hold. Rounded up to a power of two.
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanCaptureStart(rp_can_interface_t interface, uint32_t ring_size);
+
+/**
+* Stops the background capture and frees the ring buffer. Frames not yet read are lost.
+* @param interface  Selected interface
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanCaptureStop(rp_can_interface_t interface);
+
+/**
+* Takes up to count frames out of the capture ring.
+* @param interface  Selected interface
+* @param timeout Time to wait for the first frame if the ring is empty. 0 - do not wait.
+* @param frames Buffer for frames
+* @param count In: buffer size in frames. Out: number of frames copied.
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanCaptureRead(rp_can_interface_t interface, uint32_t timeout, rp_can_capture_frame_t* frames, uint32_t* count);
+
+/**
+* Takes frames out of the capture ring into a numpy buffer of uint8.
+* Each frame takes sizeof(rp_can_capture_frame_t) bytes.
+* @param interface  Selected interface
+* @param timeout Time to wait for the first frame if the ring is empty. 0 - do not wait.
+* @param count Returns the number of frames copied.
+* @param np_buffer Buffer for frames
+* @param size Buffer size in bytes.
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanCaptureReadNP(rp_can_interface_t interface, uint32_t timeout, uint32_t* count, uint8_t* np_buffer, int size);
+
+/**
+* Returns the capture counters.
+* @param interface  Selected interface
+* @param stats Counters
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanCaptureGetStats(rp_can_interface_t interface, rp_can_capture_stats_t* stats);
+
+/**
+* Sends a burst of frames on an open socket with as few system calls as possible.
+* The socket must be opened with rp_CanOpen.
+* @param interface  Selected interface
+* @param frames Frames to send. Only can_id_raw, can_dlc and data are used unless keepTiming is set.
+* @param count Number of frames
+* @param keepTiming If true, frames are sent with the same spacing as their timestamps (replay of a capture).
+* @param timeout Timeout when the send buffer is full. 0 - timeout is disabled.
+* @param sent Returns the number of frames sent.
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanSendBurst(rp_can_interface_t interface, const rp_can_capture_frame_t* frames, uint32_t count, bool keepTiming, uint32_t timeout, uint32_t* sent);
+
+/**
+* Sends a burst of frames from a numpy buffer of uint8 in the rp_can_capture_frame_t layout.
+* @param interface  Selected interface
+* @param keepTiming If true, frames are sent with the same spacing as their timestamps.
+* @param timeout Timeout when the send buffer is full. 0 - timeout is disabled.
+* @param sent Returns the number of frames sent.
+* @param np_buffer Frames
+* @param size Buffer size in bytes.
+* @return If the function is successful, the return value is RP_HW_CAN_OK.
+* If the function is unsuccessful, the return value is any of RP_HW_CAN_E* values that indicate an error.
+*/
+int rp_CanSendBurstNP(rp_can_interface_t interface, bool keepTiming, uint32_t timeout, uint32_t* sent, uint8_t* np_buffer, int size);
+
 #endif  // RP_HW_CAN_H
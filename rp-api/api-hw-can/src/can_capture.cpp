@@ -0,0 +1,471 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya CAN capture engine.
+ *
+ * Every capture owns a raw CAN socket and a thread that pulls frames with recvmmsg
+ * into a single producer / single consumer ring. Readers take frames in bulk without
+ * touching the socket. Bursts are sent with sendmmsg on the socket opened by rp_CanOpen.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rp_hw_can.h"
+#include "can_capture.h"
+#include "can_socket.h"
+#include "common.h"
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+#define CAPTURE_BATCH 64
+#define CAPTURE_MIN_RING 64
+#define CAPTURE_RCV_TIMEOUT_US 100000
+#define CAPTURE_CTRL_SIZE 128
+
+static_assert(sizeof(rp_can_capture_frame_t) == 24, "rp_can_capture_frame_t layout must not change");
+
+namespace {
+
+auto timespecToNs(const timespec &_ts) -> uint64_t {
+    return (uint64_t)_ts.tv_sec * 1000000000ull + (uint64_t)_ts.tv_nsec;
+}
+
+auto nowNs(clockid_t _clock) -> uint64_t {
+    timespec ts;
+    clock_gettime(_clock, &ts);
+    return timespecToNs(ts);
+}
+
+// SCM_TIMESTAMPING carries three timestamps: software, deprecated, raw hardware.
+// Depending on the time_t ABI of the kernel they are either 32 or 64 bit pairs.
+auto parseTimestamping(const cmsghdr *_cmsg, uint64_t *_ts, bool *_hw) -> bool {
+    auto len = _cmsg->cmsg_len - CMSG_LEN(0);
+    auto data = CMSG_DATA(_cmsg);
+    uint64_t ts[3] = {0, 0, 0};
+    if (len == 3 * 2 * sizeof(int64_t)) {
+        int64_t v[6];
+        memcpy(v, data, sizeof(v));
+        for (int i = 0; i < 3; i++)
+            ts[i] = (uint64_t)v[i * 2] * 1000000000ull + (uint64_t)v[i * 2 + 1];
+    } else if (len == 3 * 2 * sizeof(int32_t)) {
+        int32_t v[6];
+        memcpy(v, data, sizeof(v));
+        for (int i = 0; i < 3; i++)
+            ts[i] = (uint64_t)(uint32_t)v[i * 2] * 1000000000ull + (uint64_t)(uint32_t)v[i * 2 + 1];
+    } else {
+        return false;
+    }
+    *_hw = ts[2] != 0;
+    *_ts = ts[2] ? ts[2] : ts[0];
+    return *_ts != 0;
+}
+
+struct Capture {
+    int fd = -1;
+    std::thread thread;
+    std::atomic<bool> stop = false;
+
+    std::vector<rp_can_capture_frame_t> ring;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> head = 0;  // Written by the capture thread only
+    std::atomic<uint64_t> tail = 0;  // Written by readers only
+
+    std::atomic<uint64_t> received = 0;
+    std::atomic<uint64_t> droppedRing = 0;
+    std::atomic<uint64_t> droppedSocket = 0;
+    std::atomic<uint64_t> hwTimestamped = 0;
+    bool hwTimestamping = false;
+
+    std::mutex readMutex;
+    std::mutex waitMutex;
+    std::condition_variable waitCond;
+
+    ~Capture() {
+        stopThread();
+        if (fd >= 0)
+            close(fd);
+    }
+
+    auto stopThread() -> void {
+        stop = true;
+        if (thread.joinable())
+            thread.join();
+    }
+
+    auto run() -> void {
+        can_frame frames[CAPTURE_BATCH];
+        iovec iov[CAPTURE_BATCH];
+        mmsghdr msgs[CAPTURE_BATCH];
+        alignas(cmsghdr) char ctrl[CAPTURE_BATCH][CAPTURE_CTRL_SIZE];
+
+        memset(msgs, 0, sizeof(msgs));
+        for (int i = 0; i < CAPTURE_BATCH; i++) {
+            iov[i].iov_base = &frames[i];
+            iov[i].iov_len = sizeof(can_frame);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = ctrl[i];
+        }
+
+        while (!stop) {
+            for (int i = 0; i < CAPTURE_BATCH; i++) {
+                msgs[i].msg_hdr.msg_controllen = CAPTURE_CTRL_SIZE;
+                msgs[i].msg_hdr.msg_flags = 0;
+            }
+            // Blocks until the first frame or SO_RCVTIMEO, then takes whatever is queued
+            auto n = recvmmsg(fd, msgs, CAPTURE_BATCH, MSG_WAITFORONE, nullptr);
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    // Interface is down or restarting. Keep the capture alive.
+                    usleep(CAPTURE_RCV_TIMEOUT_US);
+                }
+                continue;
+            }
+
+            auto fallbackTs = nowNs(CLOCK_REALTIME);
+            auto h = head.load(std::memory_order_relaxed);
+            auto t = tail.load(std::memory_order_acquire);
+            auto stored = h;
+            for (int i = 0; i < n; i++) {
+                if (msgs[i].msg_len != sizeof(can_frame))
+                    continue;
+                uint64_t ts = 0;
+                bool hw = false;
+                for (auto cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level != SOL_SOCKET)
+                        continue;
+                    if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                        uint32_t ovfl;
+                        memcpy(&ovfl, CMSG_DATA(cmsg), sizeof(ovfl));
+                        droppedSocket.store(ovfl, std::memory_order_relaxed);
+                    } else {
+                        parseTimestamping(cmsg, &ts, &hw);
+                    }
+                }
+                if (h - t > mask) {
+                    t = tail.load(std::memory_order_acquire);
+                    if (h - t > mask) {
+                        droppedRing.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                }
+                auto &dst = ring[h & mask];
+                dst.timestamp_ns = ts ? ts : fallbackTs;
+                if (hw)
+                    hwTimestamped.fetch_add(1, std::memory_order_relaxed);
+                dst.can_id_raw = frames[i].can_id;
+                dst.can_dlc = frames[i].can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : frames[i].can_dlc;
+                memset(dst.reserved, 0, sizeof(dst.reserved));
+                memcpy(dst.data, frames[i].data, CAN_MAX_DLEN);
+                h++;
+            }
+            // Frames with a wrong length or lost to a full ring are not counted as received
+            received.fetch_add(h - stored, std::memory_order_relaxed);
+            head.store(h, std::memory_order_release);
+            {
+                // Empty critical section orders the head update against a reader going to sleep
+                std::lock_guard lock(waitMutex);
+            }
+            waitCond.notify_all();
+        }
+    }
+
+    auto read(uint32_t _timeout, rp_can_capture_frame_t *_frames, uint32_t _max) -> uint32_t {
+        std::lock_guard lock(readMutex);
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        if (h == t && _timeout > 0) {
+            std::unique_lock wlock(waitMutex);
+            waitCond.wait_for(wlock, std::chrono::milliseconds(_timeout), [&] { return head.load(std::memory_order_acquire) != t; });
+            h = head.load(std::memory_order_acquire);
+        }
+        auto n = h - t;
+        if (n > _max)
+            n = _max;
+        auto start = t & mask;
+        auto first = std::min<uint64_t>(n, ring.size() - start);
+        memcpy(_frames, &ring[start], first * sizeof(rp_can_capture_frame_t));
+        memcpy(_frames + first, &ring[0], (n - first) * sizeof(rp_can_capture_frame_t));
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+};
+
+std::mutex g_captureMutex;
+std::map<rp_can_interface_t, std::shared_ptr<Capture>> g_captures;
+
+auto getCapture(rp_can_interface_t _interface) -> std::shared_ptr<Capture> {
+    std::lock_guard lock(g_captureMutex);
+    if (auto search = g_captures.find(_interface); search != g_captures.end()) {
+        return search->second;
+    }
+    return nullptr;
+}
+
+// The driver only stamps frames in hardware once the interface is configured for it. Needs CAP_NET_ADMIN.
+auto enableHwTimestamps(int _fd, const char *_ifname) -> bool {
+    hwtstamp_config config;
+    memset(&config, 0, sizeof(config));
+    config.tx_type = HWTSTAMP_TX_OFF;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+    ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, _ifname, IFNAMSIZ - 1);
+    ifr.ifr_data = (char *)&config;
+    if (ioctl(_fd, SIOCSHWTSTAMP, &ifr)) {
+        WARNING("Hardware timestamps are not available on %s: %s. Frames get software timestamps", _ifname, strerror(errno));
+        return false;
+    }
+    if (config.rx_filter == HWTSTAMP_FILTER_NONE) {
+        WARNING("Driver of %s refused hardware receive timestamps. Frames get software timestamps", _ifname);
+        return false;
+    }
+    return true;
+}
+
+auto openCaptureSocket(const char *_ifname, rp_can_interface_t _interface, bool *_hwTimestamping) -> int {
+    auto s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0)
+        return -1;
+
+    ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, _ifname, IFNAMSIZ - 1);
+    if (ioctl(s, SIOCGIFINDEX, &ifr)) {
+        close(s);
+        return -1;
+    }
+
+    auto filters = socket_GetFilters(_interface);
+    if (filters.size() && setsockopt(s, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), sizeof(can_filter) * filters.size())) {
+        close(s);
+        return -1;
+    }
+
+    timeval tv = {.tv_sec = 0, .tv_usec = CAPTURE_RCV_TIMEOUT_US};
+    if (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv))) {
+        close(s);
+        return -1;
+    }
+
+    // Optional features. Without them frames get a user space timestamp and kernel drops are not counted.
+    *_hwTimestamping = enableHwTimestamps(s, _ifname);
+    int tsFlags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &tsFlags, sizeof(tsFlags));
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+
+    sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(s, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+auto waitWritable(int _fd, uint32_t _timeout) -> int {
+    if (_timeout == 0) {
+        return RP_HW_CAN_ESBO;
+    }
+    pollfd fds = {.fd = _fd, .events = POLLOUT, .revents = 0};
+    auto ret = poll(&fds, 1, _timeout);
+    if (ret == -1 && errno != EINTR) {
+        return RP_HW_CAN_ESPE;
+    }
+    if (ret == 0) {
+        return RP_HW_CAN_ESTE;
+    }
+    return RP_HW_CAN_OK;
+}
+
+}  // namespace
+
+auto capture_Start(rp_can_interface_t _interface, uint32_t _ringSize) -> int {
+    auto ifname = getInterfaceName(_interface);
+    if (!strcmp(ifname, ""))
+        return RP_HW_CAN_EUI;
+
+    std::lock_guard lock(g_captureMutex);
+    if (g_captures.find(_interface) != g_captures.end()) {
+        return RP_HW_CAN_ECAS;
+    }
+
+    uint64_t size = CAPTURE_MIN_RING;
+    while (size < _ringSize)
+        size <<= 1;
+
+    auto capture = std::make_shared<Capture>();
+    capture->fd = openCaptureSocket(ifname, _interface, &capture->hwTimestamping);
+    if (capture->fd < 0) {
+        return RP_HW_CAN_ECS;
+    }
+    try {
+        capture->ring.resize(size);
+        capture->mask = size - 1;
+        capture->thread = std::thread(&Capture::run, capture.get());
+    } catch (...) {
+        return RP_HW_CAN_ECS;
+    }
+    g_captures[_interface] = capture;
+    return RP_HW_CAN_OK;
+}
+
+auto capture_Stop(rp_can_interface_t _interface) -> int {
+    std::shared_ptr<Capture> capture;
+    {
+        std::lock_guard lock(g_captureMutex);
+        auto search = g_captures.find(_interface);
+        if (search == g_captures.end()) {
+            return RP_HW_CAN_ECNS;
+        }
+        capture = search->second;
+        g_captures.erase(search);
+    }
+    capture->stopThread();
+    return RP_HW_CAN_OK;
+}
+
+auto capture_Read(rp_can_interface_t _interface, uint32_t _timeout, rp_can_capture_frame_t *_frames, uint32_t *_count) -> int {
+    if (!_frames || !_count) {
+        return RP_HW_CAN_ESD;
+    }
+    auto capture = getCapture(_interface);
+    if (!capture) {
+        *_count = 0;
+        return RP_HW_CAN_ECNS;
+    }
+    *_count = capture->read(_timeout, _frames, *_count);
+    if (*_count == 0 && _timeout > 0) {
+        return RP_HW_CAN_ESTE;
+    }
+    return RP_HW_CAN_OK;
+}
+
+auto capture_GetStats(rp_can_interface_t _interface, rp_can_capture_stats_t *_stats) -> int {
+    if (!_stats) {
+        return RP_HW_CAN_ESD;
+    }
+    auto capture = getCapture(_interface);
+    if (!capture) {
+        return RP_HW_CAN_ECNS;
+    }
+    _stats->received = capture->received.load(std::memory_order_relaxed);
+    _stats->dropped_ring = capture->droppedRing.load(std::memory_order_relaxed);
+    _stats->dropped_socket = capture->droppedSocket.load(std::memory_order_relaxed);
+    _stats->hw_timestamped = capture->hwTimestamped.load(std::memory_order_relaxed);
+    _stats->hw_timestamping = capture->hwTimestamping;
+    return RP_HW_CAN_OK;
+}
+
+auto capture_SendBurst(rp_can_interface_t _interface, const rp_can_capture_frame_t *_frames, uint32_t _count, bool _keepTiming, uint32_t _timeout, uint32_t *_sent) -> int {
+    if (_sent)
+        *_sent = 0;
+    if (!_frames && _count) {
+        return RP_HW_CAN_ESD;
+    }
+    auto s = socket_GetFd(_interface);
+    if (s < 0) {
+        return RP_HW_CAN_ESN;
+    }
+
+    can_frame frames[CAPTURE_BATCH];
+    iovec iov[CAPTURE_BATCH];
+    mmsghdr msgs[CAPTURE_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < CAPTURE_BATCH; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(can_frame);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    auto startNs = nowNs(CLOCK_MONOTONIC);
+    auto baseTs = _count ? _frames[0].timestamp_ns : 0;
+    auto deadlineOf = [&](uint32_t idx) -> uint64_t {
+        auto ts = _frames[idx].timestamp_ns;
+        return startNs + (ts > baseTs ? ts - baseTs : 0);
+    };
+
+    uint32_t done = 0;
+    while (done < _count) {
+        if (_keepTiming) {
+            auto deadline = deadlineOf(done);
+            timespec ts = {.tv_sec = (time_t)(deadline / 1000000000ull), .tv_nsec = (long)(deadline % 1000000000ull)};
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            }
+        }
+
+        // All frames that are already due go out in one call
+        uint32_t batch = 0;
+        auto now = _keepTiming ? nowNs(CLOCK_MONOTONIC) : 0;
+        while (batch < CAPTURE_BATCH && done + batch < _count) {
+            if (_keepTiming && batch > 0 && deadlineOf(done + batch) > now)
+                break;
+            auto &src = _frames[done + batch];
+            auto &dst = frames[batch];
+            memset(&dst, 0, sizeof(dst));
+            dst.can_id = src.can_id_raw;
+            dst.can_dlc = src.can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : src.can_dlc;
+            memcpy(dst.data, src.data, dst.can_dlc);
+            batch++;
+        }
+
+        uint32_t batchSent = 0;
+        while (batchSent < batch) {
+            auto ret = sendmmsg(s, msgs + batchSent, batch - batchSent, 0);
+            if (ret < 0) {
+                switch (errno) {
+                    case ENOBUFS:
+                    case EAGAIN: {
+                        auto wret = waitWritable(s, _timeout);
+                        if (wret != RP_HW_CAN_OK) {
+                            if (_sent)
+                                *_sent = done + batchSent;
+                            return wret;
+                        }
+                        break;
+                    }
+                    case EINTR:
+                        break;
+                    default:
+                        if (_sent)
+                            *_sent = done + batchSent;
+                        return RP_HW_CAN_ESE;
+                }
+                continue;
+            }
+            batchSent += ret;
+        }
+        done += batch;
+        if (_sent)
+            *_sent = done;
+    }
+    return RP_HW_CAN_OK;
+}
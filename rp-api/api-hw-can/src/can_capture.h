@@ -0,0 +1,22 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya CAN capture engine
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef _CAN_CAPTURE_H_
+#define _CAN_CAPTURE_H_
+
+#include "rp_hw_can.h"
+
+auto capture_Start(rp_can_interface_t _interface, uint32_t _ringSize) -> int;
+auto capture_Stop(rp_can_interface_t _interface) -> int;
+auto capture_Read(rp_can_interface_t _interface, uint32_t _timeout, rp_can_capture_frame_t *_frames, uint32_t *_count) -> int;
+auto capture_GetStats(rp_can_interface_t _interface, rp_can_capture_stats_t *_stats) -> int;
+auto capture_SendBurst(rp_can_interface_t _interface, const rp_can_capture_frame_t *_frames, uint32_t _count, bool _keepTiming, uint32_t _timeout, uint32_t *_sent) -> int;
+
+#endif // _CAN_CAPTURE_H_
@@ -7,6 +7,7 @@
 #include <net/if.h>
 #include <unistd.h>
 #include <algorithm>
+#include <vector>
 
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -231,24 +232,34 @@ auto socket_ClearFilter(rp_can_interface_t _interface) -> int{
     return RP_HW_CAN_OK;
 }
 
+auto socket_GetFd(rp_can_interface_t _interface) -> int{
+    if (auto search = g_sockets.find(_interface); search != g_sockets.end()){
+        return search->second;
+    }
+    return -1;
+}
+
+auto socket_GetFilters(rp_can_interface_t _interface) -> std::vector<can_filter>{
+    std::vector<can_filter> c_filter;
+    if (auto search = g_filters.find(_interface); search != g_filters.end()){
+        for (auto const& it : search->second) {
+            c_filter.push_back({.can_id = it.first, .can_mask = it.second});
+        }
+    }
+    return c_filter;
+}
+
 auto socket_SetFilter(rp_can_interface_t _interface, bool _isJoinFilter) -> int{
    if (auto search = g_sockets.find(_interface); search != g_sockets.end()){
         auto s = g_sockets[_interface];
 
 
         if (auto search = g_filters.find(_interface); search != g_filters.end()){
-            auto& filter = g_filters[_interface];
-            if (filter.size()){
-                auto c_filter = new can_filter[filter.size()];
-                int i = 0;
-                for (auto const& it : filter) {
-                    c_filter[i].can_id = it.first;
-                    c_filter[i].can_mask = it.second;
-                }
-                if (setsockopt(s, SOL_CAN_RAW, _isJoinFilter ? CAN_RAW_JOIN_FILTERS: CAN_RAW_FILTER, c_filter, sizeof(can_filter) * filter.size())) {
+            auto c_filter = socket_GetFilters(_interface);
+            if (c_filter.size()){
+                if (setsockopt(s, SOL_CAN_RAW, _isJoinFilter ? CAN_RAW_JOIN_FILTERS: CAN_RAW_FILTER, c_filter.data(), sizeof(can_filter) * c_filter.size())) {
                     return RP_HW_CAN_ESFS;
                 }
-                delete[] c_filter;
             }else{
                 if (setsockopt(s, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0)) {
                     return RP_HW_CAN_ESFS;
@@ -11,6 +11,9 @@
 #ifndef _CAN_SOCKET_H_
 #define _CAN_SOCKET_H_
 
+#include <vector>
+#include <linux/can.h>
+
 auto socket_Open(rp_can_interface_t _interface) -> int;
 auto socket_Close(rp_can_interface_t _interface) -> int;
 auto socket_Send(rp_can_interface_t _interface, uint32_t _canId, unsigned char *_data, uint8_t _dataSize, bool _isExtended, bool _rtr, uint32_t _timeout) -> int;
@@ -20,5 +23,7 @@ auto socket_RemoveFilter(rp_can_interface_t _interface, uint32_t _filter, uint32
 auto socket_ClearFilter(rp_can_interface_t _interface) -> int;
 auto socket_SetFilter(rp_can_interface_t _interface, bool _isJoinFilter) -> int;
 auto socket_ShowErrorFrames(rp_can_interface_t _interface, bool _enable) -> int;
+auto socket_GetFd(rp_can_interface_t _interface) -> int;
+auto socket_GetFilters(rp_can_interface_t _interface) -> std::vector<can_filter>;
 
 #endif // _CAN_SOCKET_H_
\ No newline at end of file
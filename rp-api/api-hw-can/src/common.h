@@ -42,6 +42,7 @@ inline const char* getInterfaceName(rp_can_interface_t _interface){
     switch(_interface){
         case RP_CAN_0: return "can0";
         case RP_CAN_1: return "can1";
+        case RP_CAN_VCAN_0: return "vcan0";
         default: ;
     }
     return "";
@@ -17,6 +17,7 @@
 #include "common.h"
 #include "can_control.h"
 #include "can_socket.h"
+#include "can_capture.h"
 
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 
@@ -80,6 +81,9 @@ const char* rp_CanGetError(int errorCode) {
         case RP_HW_CAN_ESFS:   return "Failed apply filter";
         case RP_HW_CAN_ESEF:   return "Failed to set error handling";
         case RP_HW_CAN_ESR:    return "Failed read frame from socket";
+        case RP_HW_CAN_ECAS:   return "Failed. Capture already started";
+        case RP_HW_CAN_ECNS:   return "Failed. Capture not started";
+        case RP_HW_CAN_ECS:    return "Failed start capture";
 
         default:       return "Unknown error";
     }
@@ -249,4 +253,34 @@ int rp_CanSetFilter(rp_can_interface_t _interface, bool _isJoinFilter){
 
 int rp_CanShowErrorFrames(rp_can_interface_t _interface, bool _enable){
     return socket_ShowErrorFrames(_interface,_enable);
-}
\ No newline at end of file
+}
+
+int rp_CanCaptureStart(rp_can_interface_t interface, uint32_t ring_size){
+    return capture_Start(interface, ring_size);
+}
+
+int rp_CanCaptureStop(rp_can_interface_t interface){
+    return capture_Stop(interface);
+}
+
+int rp_CanCaptureRead(rp_can_interface_t interface, uint32_t timeout, rp_can_capture_frame_t* frames, uint32_t* count){
+    return capture_Read(interface, timeout, frames, count);
+}
+
+int rp_CanCaptureReadNP(rp_can_interface_t interface, uint32_t timeout, uint32_t* count, uint8_t* np_buffer, int size){
+    *count = size > 0 ? size / sizeof(rp_can_capture_frame_t) : 0;
+    return capture_Read(interface, timeout, reinterpret_cast<rp_can_capture_frame_t*>(np_buffer), count);
+}
+
+int rp_CanCaptureGetStats(rp_can_interface_t interface, rp_can_capture_stats_t* stats){
+    return capture_GetStats(interface, stats);
+}
+
+int rp_CanSendBurst(rp_can_interface_t interface, const rp_can_capture_frame_t* frames, uint32_t count, bool keepTiming, uint32_t timeout, uint32_t* sent){
+    return capture_SendBurst(interface, frames, count, keepTiming, timeout, sent);
+}
+
+int rp_CanSendBurstNP(rp_can_interface_t interface, bool keepTiming, uint32_t timeout, uint32_t* sent, uint8_t* np_buffer, int size){
+    uint32_t count = size > 0 ? size / sizeof(rp_can_capture_frame_t) : 0;
+    return capture_SendBurst(interface, reinterpret_cast<const rp_can_capture_frame_t*>(np_buffer), count, keepTiming, timeout, sent);
+}
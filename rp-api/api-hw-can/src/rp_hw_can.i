@@ -34,6 +34,7 @@ import_array();
 %pointer_functions(rp_can_bittiming_t, p_rp_can_bittiming_t);
 %pointer_functions(rp_can_bittiming_limits_t, p_rp_can_bittiming_limits_t);
 %pointer_functions(rp_can_frame_t, p_rp_can_frame_t);
+%pointer_functions(rp_can_capture_stats_t, p_rp_can_capture_stats_t);
 
 %numpy_typemaps(uint8_t,    NPY_UINT8   , unsigned char)
 
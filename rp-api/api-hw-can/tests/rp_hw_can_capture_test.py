@@ -0,0 +1,82 @@
+#!/usr/bin/python3
+
+# Capture and burst send test on the vcan0 virtual interface. No CAN hardware is needed.
+
+import subprocess
+import time
+import rp_hw_can
+import numpy as np
+
+FRAMES = 5000
+
+frame_dtype = np.dtype([('timestamp_ns', '<u8'), ('can_id_raw', '<u4'), ('can_dlc', 'u1'), ('reserved', 'u1', 3), ('data', 'u1', 8)])
+assert frame_dtype.itemsize == 24
+
+subprocess.run("modprobe vcan", shell=True)
+subprocess.run("ip link add dev vcan0 type vcan", shell=True, stderr=subprocess.DEVNULL)
+subprocess.run("ip link set up vcan0", shell=True)
+
+print("rp_hw_can.rp_CanOpen(rp_hw_can.RP_CAN_VCAN_0)")
+res = rp_hw_can.rp_CanOpen(rp_hw_can.RP_CAN_VCAN_0)
+print(res,rp_hw_can.rp_CanGetError(res))
+
+print("rp_hw_can.rp_CanCaptureStart(rp_hw_can.RP_CAN_VCAN_0, " + str(FRAMES) + ")")
+res = rp_hw_can.rp_CanCaptureStart(rp_hw_can.RP_CAN_VCAN_0, FRAMES)
+print(res,rp_hw_can.rp_CanGetError(res))
+
+print("rp_hw_can.rp_CanCaptureStart(rp_hw_can.RP_CAN_VCAN_0, " + str(FRAMES) + ") again")
+res = rp_hw_can.rp_CanCaptureStart(rp_hw_can.RP_CAN_VCAN_0, FRAMES)
+print(res,rp_hw_can.rp_CanGetError(res))
+
+tx = np.zeros(FRAMES, dtype=frame_dtype)
+tx['can_id_raw'] = np.arange(FRAMES) % 0x7FF
+tx['can_dlc'] = 8
+tx['data'][:, 0] = np.arange(FRAMES) & 0xFF
+tx['data'][:, 1] = (np.arange(FRAMES) >> 8) & 0xFF
+
+print("rp_hw_can.rp_CanSendBurstNP(rp_hw_can.RP_CAN_VCAN_0, False, 1000, tx)")
+start = time.monotonic()
+res = rp_hw_can.rp_CanSendBurstNP(rp_hw_can.RP_CAN_VCAN_0, False, 1000, tx.view(np.uint8))
+print(res,rp_hw_can.rp_CanGetError(res[0]), "sent in", time.monotonic() - start, "s")
+
+rx = np.zeros(FRAMES, dtype=frame_dtype)
+received = 0
+while received < FRAMES:
+    res = rp_hw_can.rp_CanCaptureReadNP(rp_hw_can.RP_CAN_VCAN_0, 500, rx[received:].view(np.uint8))
+    if res[0] != rp_hw_can.RP_HW_CAN_OK:
+        print(res,rp_hw_can.rp_CanGetError(res[0]))
+        break
+    received += res[1]
+
+print("Received", received, "of", FRAMES)
+print("Ids match:", np.array_equal(rx['can_id_raw'][:received], tx['can_id_raw'][:received]))
+print("Data match:", np.array_equal(rx['data'][:received], tx['data'][:received]))
+print("Timestamps monotonic:", bool(np.all(np.diff(rx['timestamp_ns'][:received].astype(np.int64)) >= 0)))
+
+stats = rp_hw_can.rp_can_capture_stats_t()
+print("rp_hw_can.rp_CanCaptureGetStats(rp_hw_can.RP_CAN_VCAN_0)")
+res = rp_hw_can.rp_CanCaptureGetStats(rp_hw_can.RP_CAN_VCAN_0, stats)
+print(res,rp_hw_can.rp_CanGetError(res))
+print("received", stats.received, "dropped_ring", stats.dropped_ring, "dropped_socket", stats.dropped_socket)
+# vcan has no hardware clock, so hardware timestamping is expected to be off here
+print("hw_timestamping", stats.hw_timestamping, "hw_timestamped", stats.hw_timestamped)
+
+# Replay with original timing: 10 frames 10 ms apart should take about 90 ms
+replay = tx[:10].copy()
+replay['timestamp_ns'] = np.arange(10) * 10000000
+print("rp_hw_can.rp_CanSendBurstNP(rp_hw_can.RP_CAN_VCAN_0, True, 1000, replay)")
+start = time.monotonic()
+res = rp_hw_can.rp_CanSendBurstNP(rp_hw_can.RP_CAN_VCAN_0, True, 1000, replay.view(np.uint8))
+print(res,rp_hw_can.rp_CanGetError(res[0]), "sent in", time.monotonic() - start, "s")
+
+print("rp_hw_can.rp_CanCaptureStop(rp_hw_can.RP_CAN_VCAN_0)")
+res = rp_hw_can.rp_CanCaptureStop(rp_hw_can.RP_CAN_VCAN_0)
+print(res,rp_hw_can.rp_CanGetError(res))
+
+print("rp_hw_can.rp_CanCaptureStop(rp_hw_can.RP_CAN_VCAN_0) again")
+res = rp_hw_can.rp_CanCaptureStop(rp_hw_can.RP_CAN_VCAN_0)
+print(res,rp_hw_can.rp_CanGetError(res))
+
+print("rp_hw_can.rp_CanClose(rp_hw_can.RP_CAN_VCAN_0)")
+res = rp_hw_can.rp_CanClose(rp_hw_can.RP_CAN_VCAN_0)
+print(res,rp_hw_can.rp_CanGetError(res))
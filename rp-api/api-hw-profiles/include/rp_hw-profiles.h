@@ -111,6 +111,37 @@ typedef enum {
 */
 int rp_HPInit();
 
+/**
+* Reads raw bytes from the board EEPROM.
+* The EEPROM is read over I2C once per boot and kept as a validated snapshot in tmpfs (/dev/shm),
+* so later calls from any process do not touch the I2C bus. Only root processes store the snapshot.
+* @param offset - Offset in the EEPROM.
+* @param buffer - Destination buffer.
+* @param size - Number of bytes to read.
+* @param read_size - Number of bytes actually read.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_HP_E* values that indicate an error.
+*/
+int rp_HPReadEEPROM(uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* read_size);
+
+/**
+* Writes raw bytes to the board EEPROM and drops the EEPROM snapshot.
+* @param offset - Offset in the EEPROM.
+* @param buffer - Source buffer.
+* @param size - Number of bytes to write.
+* @param written_size - Number of bytes actually written.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_HP_E* values that indicate an error.
+*/
+int rp_HPWriteEEPROM(uint32_t offset, const uint8_t* buffer, uint32_t size, uint32_t* written_size);
+
+/**
+* Drops the EEPROM snapshot. Needed only if the EEPROM was changed bypassing rp_HPWriteEEPROM (e.g. fw_setenv).
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_HP_E* values that indicate an error.
+*/
+int rp_HPResetEEPROMSnapshot();
+
 /**
 * Returns the model read from eeprom
 * @return If the function is successful, the return value is RP_OK.
@@ -9,6 +9,7 @@
  */
 
 #include "common.h"
+#include "eeprom_snapshot.h"
 #include <ctype.h>
 #include <errno.h>
 #include <pwd.h>
@@ -323,22 +324,13 @@ int hp_cmn_Init() {
         return is_valid ? RP_HP_OK : RP_HP_ERM;
     }
 
-    std::ifstream eeprom("/sys/bus/i2c/devices/0-0050/eeprom", std::ios::binary);
-    if (!eeprom.is_open()) {
-        fprintf(stderr, "[hp_cmn_Init] Error open eeprom: %s\n", strerror(errno));
+    std::vector<char> buffer(LINE_LENGTH + 1, 0);
+    int bytes_read = hp_snapshot_Read(0x1804, (uint8_t*)buffer.data(), LINE_LENGTH);
+    if (bytes_read < 0) {
+        fprintf(stderr, "[hp_cmn_Init] Error read eeprom\n");
         return RP_HP_ERE;
     }
 
-    eeprom.seekg(0x1804);
-    if (eeprom.fail()) {
-        fprintf(stderr, "[hp_cmn_Init] Error seek eeprom\n");
-        return RP_HP_ERE;
-    }
-
-    std::vector<char> buffer(LINE_LENGTH);
-    eeprom.read(buffer.data(), LINE_LENGTH);
-    size_t bytes_read = eeprom.gcount();
-
     if (bytes_read == 0) {
         return RP_HP_ERM;
     }
@@ -348,7 +340,7 @@ int hp_cmn_Init() {
 
     // Парсим данные
     size_t position = 0;
-    while (position < bytes_read) {
+    while (position < (size_t)bytes_read) {
         std::string line(&buffer[position]);
         if (line.empty()) {
             break;
@@ -379,7 +371,6 @@ int hp_cmn_Init() {
         position += line.length() + 1;
     }
 
-    eeprom.close();
     initialized = true;
     is_valid = !model.empty();
 
@@ -0,0 +1,332 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Hardware Profiles. EEPROM snapshot shared between processes.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "eeprom_snapshot.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    char boot_id[40];
+    uint64_t generation;
+    uint32_t size;
+    uint32_t crc32;
+} snapshot_header_t;
+
+std::mutex g_snapshotMutex;
+std::vector<uint8_t> g_image;
+bool g_loaded = false;
+uint64_t g_generation = 0;  // Generation g_image belongs to
+bool g_deviceEnd = false;   // g_image reaches the end of the EEPROM
+
+uint32_t crc32(const uint8_t* _data, size_t _size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < _size; i++) {
+        crc ^= _data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+std::string getBootId() {
+    char buf[40] = {0};
+    int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY);
+    if (fd < 0) {
+        return "";
+    }
+    auto len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        return "";
+    }
+    std::string id(buf, len);
+    while (!id.empty() && (id.back() == '\n' || id.back() == '\r')) {
+        id.pop_back();
+    }
+    return id;
+}
+
+// Files in /dev/shm can be planted by any user, so only root owned files nobody else can change are used
+int openTrusted(const char* _path) {
+    int fd = open(_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != 0 || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Generation of the EEPROM content, 0 when no write happened since boot
+uint64_t getGeneration() {
+    uint64_t gen = 0;
+    int fd = openTrusted(EEPROM_SNAPSHOT_GEN_PATH);
+    if (fd < 0) {
+        return 0;
+    }
+    if (pread(fd, &gen, sizeof(gen), 0) != (ssize_t)sizeof(gen)) {
+        gen = 0;
+    }
+    close(fd);
+    return gen;
+}
+
+void bumpGeneration() {
+    if (geteuid() != 0) {
+        return;
+    }
+    int fd = open(EEPROM_SNAPSHOT_GEN_PATH, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd >= 0 && (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != 0)) {
+        // Planted by somebody else, replace it with a file of our own
+        close(fd);
+        unlink(EEPROM_SNAPSHOT_GEN_PATH);
+        fd = open(EEPROM_SNAPSHOT_GEN_PATH, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "[hp_snapshot] Error open %s: %s\n", EEPROM_SNAPSHOT_GEN_PATH, strerror(errno));
+        return;
+    }
+    {
+        fchmod(fd, 0644);
+        flock(fd, LOCK_EX);
+        uint64_t gen = 0;
+        if (pread(fd, &gen, sizeof(gen), 0) != (ssize_t)sizeof(gen)) {
+            gen = 0;
+        }
+        gen++;
+        if (pwrite(fd, &gen, sizeof(gen), 0) != (ssize_t)sizeof(gen)) {
+            fprintf(stderr, "[hp_snapshot] Error write %s: %s\n", EEPROM_SNAPSHOT_GEN_PATH, strerror(errno));
+        }
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+}
+
+bool readAll(int _fd, uint8_t* _buffer, size_t _size, size_t* _read) {
+    size_t pos = 0;
+    while (pos < _size) {
+        auto r = read(_fd, _buffer + pos, _size - pos);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (r == 0)
+            break;
+        pos += r;
+    }
+    *_read = pos;
+    return true;
+}
+
+bool loadSnapshot(const std::string& _bootId, uint64_t _generation) {
+    if (_bootId.empty()) {
+        return false;
+    }
+    int fd = openTrusted(EEPROM_SNAPSHOT_PATH);
+    if (fd < 0) {
+        return false;
+    }
+    snapshot_header_t header;
+    size_t rb = 0;
+    bool ok = readAll(fd, (uint8_t*)&header, sizeof(header), &rb) && rb == sizeof(header);
+    ok = ok && header.magic == EEPROM_SNAPSHOT_MAGIC && header.version == EEPROM_SNAPSHOT_VERSION && header.size <= EEPROM_MAX_SIZE;
+    ok = ok && strncmp(header.boot_id, _bootId.c_str(), sizeof(header.boot_id)) == 0 && header.generation == _generation;
+    if (ok) {
+        g_image.resize(header.size);
+        ok = readAll(fd, g_image.data(), header.size, &rb) && rb == header.size && crc32(g_image.data(), header.size) == header.crc32;
+    }
+    close(fd);
+    if (!ok) {
+        g_image.clear();
+    }
+    return ok;
+}
+
+bool loadEeprom(size_t _size) {
+    int fd = open(EEPROM_DEVICE, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[hp_snapshot] Error open eeprom: %s\n", strerror(errno));
+        return false;
+    }
+    g_image.resize(_size);
+    size_t rb = 0;
+    bool ok = readAll(fd, g_image.data(), _size, &rb);
+    close(fd);
+    if (!ok || rb == 0) {
+        fprintf(stderr, "[hp_snapshot] Error read eeprom: %s\n", strerror(errno));
+        g_image.clear();
+        return false;
+    }
+    g_image.resize(rb);
+    g_deviceEnd = rb < _size;
+    return true;
+}
+
+// _generation is the one read before the EEPROM, so an image read during a write is never stored as current
+void storeSnapshot(const std::string& _bootId, uint64_t _generation) {
+    // Readers trust root owned snapshots only
+    if (_bootId.empty() || geteuid() != 0) {
+        return;
+    }
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = EEPROM_SNAPSHOT_MAGIC;
+    header.version = EEPROM_SNAPSHOT_VERSION;
+    strncpy(header.boot_id, _bootId.c_str(), sizeof(header.boot_id) - 1);
+    header.generation = _generation;
+    header.size = g_image.size();
+    header.crc32 = crc32(g_image.data(), g_image.size());
+
+    // Written aside and renamed, so concurrent readers never see a partial file.
+    // mkstemp creates a new file, a name planted in /dev/shm is never followed.
+    std::string tmp = std::string(EEPROM_SNAPSHOT_PATH) + ".XXXXXX";
+    int fd = mkstemp(tmp.data());
+    if (fd < 0) {
+        return;
+    }
+    fchmod(fd, 0644);
+    bool ok = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+    ok = ok && write(fd, g_image.data(), g_image.size()) == (ssize_t)g_image.size();
+    close(fd);
+    if (!ok || rename(tmp.c_str(), EEPROM_SNAPSHOT_PATH) != 0) {
+        unlink(tmp.c_str());
+    }
+}
+
+bool isEmulated() {
+    static const bool emulated = [] {
+        auto env = getenv("RP_EMULATION");
+        return env && *env && strcmp(env, "0") != 0;
+    }();
+    return emulated;
+}
+
+// Blank EEPROM with only the environment block filled in, so the board model can be
+// chosen with RP_EMULATION_MODEL when running without hardware.
+void loadEmulated() {
+    auto env = getenv("RP_EMULATION_MODEL");
+    std::string block = std::string("hw_rev=") + (env && *env ? env : "STEM_125-14_v1.1");
+    block += '\0';
+    block += "ethaddr=00:26:32:00:00:00";
+    block += '\0';
+    block += '\0';
+    g_image.assign(EEPROM_MAX_SIZE, 0xFF);
+    memcpy(g_image.data() + EEPROM_EMULATED_ENV_OFFSET, block.data(), block.size());
+}
+
+// _end is the end of the range the caller is going to read
+bool load(size_t _end) {
+    if (isEmulated()) {
+        if (!g_loaded) {
+            loadEmulated();
+            g_loaded = true;
+        }
+        return true;
+    }
+    _end = std::min<size_t>(_end, EEPROM_MAX_SIZE);
+    auto generation = getGeneration();
+    if (g_loaded && generation == g_generation && (_end <= g_image.size() || g_deviceEnd)) {
+        return true;
+    }
+    g_loaded = false;
+    auto bootId = getBootId();
+    // A snapshot shorter than EEPROM_READ_SIZE holds the whole EEPROM
+    bool snapshot = loadSnapshot(bootId, generation);
+    if (snapshot && (_end <= g_image.size() || g_image.size() < EEPROM_READ_SIZE)) {
+        g_deviceEnd = g_image.size() < EEPROM_READ_SIZE;
+    } else {
+        if (!loadEeprom(std::max<size_t>(_end, EEPROM_READ_SIZE))) {
+            return false;
+        }
+        storeSnapshot(bootId, generation);
+    }
+    g_generation = generation;
+    g_loaded = true;
+    return true;
+}
+
+}  // namespace
+
+int hp_snapshot_Read(uint32_t _offset, uint8_t* _buffer, size_t _size) {
+    std::lock_guard lock(g_snapshotMutex);
+    if (!load((size_t)_offset + _size)) {
+        return -1;
+    }
+    if (_offset >= g_image.size()) {
+        return 0;
+    }
+    size_t len = std::min(_size, g_image.size() - _offset);
+    memcpy(_buffer, g_image.data() + _offset, len);
+    return len;
+}
+
+int hp_snapshot_Write(uint32_t _offset, const uint8_t* _buffer, size_t _size) {
+    std::lock_guard lock(g_snapshotMutex);
+    if (isEmulated()) {
+        // The emulated image lives for the whole process, so calibration writes stay visible
+        if (!load((size_t)_offset + _size) || _offset >= g_image.size()) {
+            return -1;
+        }
+        size_t len = std::min(_size, g_image.size() - _offset);
+        memcpy(g_image.data() + _offset, _buffer, len);
+        return len;
+    }
+    // Drop the snapshot first: if the write fails half way the EEPROM is re-read anyway.
+    // The generation changes before and after the write, so a snapshot another process takes
+    // from the EEPROM meanwhile is stale for everybody once the write is done.
+    bumpGeneration();
+    unlink(EEPROM_SNAPSHOT_PATH);
+    g_loaded = false;
+    g_image.clear();
+
+    int fd = open(EEPROM_DEVICE, O_WRONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[hp_snapshot] Error open eeprom: %s\n", strerror(errno));
+        return -1;
+    }
+    int ret = -1;
+    if (lseek(fd, _offset, SEEK_SET) == (off_t)_offset) {
+        ret = write(fd, _buffer, _size);
+    }
+    close(fd);
+    bumpGeneration();
+    return ret;
+}
+
+void hp_snapshot_Invalidate() {
+    std::lock_guard lock(g_snapshotMutex);
+    if (isEmulated()) {
+        return;
+    }
+    bumpGeneration();
+    unlink(EEPROM_SNAPSHOT_PATH);
+    g_loaded = false;
+    g_image.clear();
+}
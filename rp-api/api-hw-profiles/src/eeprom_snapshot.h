@@ -0,0 +1,43 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Hardware Profiles. EEPROM snapshot shared between processes.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef RP_HW_PROFILES_EEPROM_SNAPSHOT_H
+#define RP_HW_PROFILES_EEPROM_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EEPROM_DEVICE "/sys/bus/i2c/devices/0-0050/eeprom"
+#define EEPROM_SNAPSHOT_PATH "/dev/shm/rp_eeprom_snapshot"
+#define EEPROM_SNAPSHOT_GEN_PATH "/dev/shm/rp_eeprom_snapshot.gen"
+#define EEPROM_SNAPSHOT_MAGIC 0x45455052  // "RPEE"
+#define EEPROM_SNAPSHOT_VERSION 2
+#define EEPROM_MAX_SIZE 0x10000
+#define EEPROM_READ_SIZE 0x2000  // User calibration at 0x0000, environment at 0x1804, factory calibration at 0x1c00
+#define EEPROM_EMULATED_ENV_OFFSET 0x1804
+
+// The EEPROM image is read over I2C once per boot and stored in tmpfs. Every later process
+// validates the snapshot (version, boot id, CRC32) and reads it instead of the device.
+// Only root stores a snapshot and only a regular file owned by root and not writable by group or
+// others is trusted. EEPROM writes bump a generation counter before and after the write; a snapshot
+// taken under another generation is stale and ignored. The generation is checked on every read, so a
+// long running process sees calibration written by another one.
+// Only the first EEPROM_READ_SIZE bytes are read, unless a read asks for more.
+// Returns the number of bytes copied into _buffer or -1 if neither snapshot nor EEPROM is readable.
+// With RP_EMULATION set the device is never touched: a blank image holding only the board model
+// from RP_EMULATION_MODEL is kept in memory instead.
+int hp_snapshot_Read(uint32_t _offset, uint8_t* _buffer, size_t _size);
+
+// Writes go straight to the EEPROM. The snapshot is dropped so the next reader takes a new one.
+int hp_snapshot_Write(uint32_t _offset, const uint8_t* _buffer, size_t _size);
+
+void hp_snapshot_Invalidate();
+
+#endif
@@ -1,4 +1,5 @@
 #include "common.h"
+#include "eeprom_snapshot.h"
 #include "stdio.h"
 #include "stem_122_16SDR_v1.0.h"
 #include "stem_122_16SDR_v1.1.h"
@@ -61,6 +62,29 @@ int rp_HPInit() {
     return hp_cmn_Init();
 }
 
+int rp_HPReadEEPROM(uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* read_size) {
+    int ret = hp_snapshot_Read(offset, buffer, size);
+    if (ret < 0) {
+        return RP_HP_ERE;
+    }
+    *read_size = ret;
+    return RP_HP_OK;
+}
+
+int rp_HPWriteEEPROM(uint32_t offset, const uint8_t* buffer, uint32_t size, uint32_t* written_size) {
+    int ret = hp_snapshot_Write(offset, buffer, size);
+    if (ret < 0) {
+        return RP_HP_EU;
+    }
+    *written_size = ret;
+    return RP_HP_OK;
+}
+
+int rp_HPResetEEPROMSnapshot() {
+    hp_snapshot_Invalidate();
+    return RP_HP_OK;
+}
+
 int rp_HPPrint() {
     int state;
     profiles_t* p = getProfile(&state);
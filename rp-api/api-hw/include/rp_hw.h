@@ -95,6 +95,10 @@ extern "C" {
 #define RP_HW_EISPIIC 77
 /** I2C invalid slave address */
 #define RP_HW_EISAIIC 78
+/** Failed to read sensor */
+#define RP_HW_ESENS 80
+/** Sensor sampler is not running */
+#define RP_HW_ESNR 81
 ///@}
 
 /**
@@ -125,6 +129,25 @@ typedef enum {
     RP_UART_SPACE = 4  //!< Set Always 0
 } rp_uart_parity_t;
 
+/**
+ * XADC sensors
+ */
+typedef enum {
+    RP_SENS_TEMP = 0,     //!< CPU temperature (Celsius)
+    RP_SENS_VCCINT = 1,   //!< VCCINT (1.0V)
+    RP_SENS_VCCAUX = 2,   //!< VCCAUX (1.8V)
+    RP_SENS_VCCBRAM = 3,  //!< VCCBRAM (1.0V)
+    RP_SENS_VCCPINT = 4,  //!< VCCPINT (1.0V)
+    RP_SENS_VCCPAUX = 5,  //!< VCCPAUX (1.8V)
+    RP_SENS_VCCDDR = 6,   //!< VCCDDR (1.5V)
+    RP_SENS_AIN0 = 7,     //!< Slow analog input 0 (voltage on XADC pin)
+    RP_SENS_AIN1 = 8,     //!< Slow analog input 1 (voltage on XADC pin)
+    RP_SENS_AIN2 = 9,     //!< Slow analog input 2 (voltage on XADC pin)
+    RP_SENS_AIN3 = 10,    //!< Slow analog input 3 (voltage on XADC pin)
+    RP_SENS_AIN4 = 11,    //!< Analog input AI4 (5V line power)
+    RP_SENS_COUNT = 12
+} rp_sensor_t;
+
 /**
  * SPI mode
  */
@@ -741,6 +764,55 @@ int rp_GetPowerVCCAUX(uint32_t* raw, float* value);
  */
 int rp_GetPowerVCCDDR(uint32_t* raw, float* value);
 
+/**
+ * Reads a sensor directly. Scale and offset are read once and the raw attribute stays open,
+ * so each call costs a single pread.
+ * @param sensor Sensor
+ * @param raw Raw XADC value
+ * @param value Converted value. Temperature in Celsius, voltages in Volts. RP_SENS_AIN4 gives the 5V line voltage, like rp_GetPowerI4.
+ * @return If the function is successful, the return value is RP_HW_OK.
+ * If the function is unsuccessful, the return value is any of RP_HW_E* values that indicate an error.
+ */
+int rp_SensorsRead(rp_sensor_t sensor, uint32_t* raw, float* value);
+
+/**
+ * Starts a background thread that samples all sensors at a fixed rate into a history ring.
+ * @param period_us Sampling period in microseconds
+ * @param history_size Number of samples kept per sensor
+ * @return If the function is successful, the return value is RP_HW_OK.
+ * If the function is unsuccessful, the return value is any of RP_HW_E* values that indicate an error.
+ */
+int rp_SensorsStartSampler(uint32_t period_us, uint32_t history_size);
+
+/**
+ * Stops the background sampler. Waits for rp_SensorsGetLatest and rp_SensorsGetHistory calls in progress before the history is freed.
+ * @return If the function is successful, the return value is RP_HW_OK.
+ * If the function is unsuccessful, the return value is any of RP_HW_E* values that indicate an error.
+ */
+int rp_SensorsStopSampler();
+
+/**
+ * Returns the latest sample of a sensor from the background sampler. No system calls are made.
+ * @param sensor Sensor
+ * @param raw Raw XADC value
+ * @param value Converted value
+ * @param timestamp_us Sample time, CLOCK_MONOTONIC in microseconds
+ * @return If the function is successful, the return value is RP_HW_OK.
+ * If the function is unsuccessful, the return value is any of RP_HW_E* values that indicate an error.
+ */
+int rp_SensorsGetLatest(rp_sensor_t sensor, uint32_t* raw, float* value, uint64_t* timestamp_us);
+
+/**
+ * Copies the sampled history of a sensor, oldest sample first. No system calls are made.
+ * @param sensor Sensor
+ * @param values Buffer for converted values
+ * @param timestamps_us Buffer for sample times (CLOCK_MONOTONIC, microseconds). Can be NULL.
+ * @param size In: buffer size. Out: number of samples copied.
+ * @return If the function is successful, the return value is RP_HW_OK.
+ * If the function is unsuccessful, the return value is any of RP_HW_E* values that indicate an error.
+ */
+int rp_SensorsGetHistory(rp_sensor_t sensor, float* values, uint64_t* timestamps_us, uint32_t* size);
+
 #ifdef __cplusplus
 }
 #endif
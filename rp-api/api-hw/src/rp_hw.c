@@ -78,6 +78,8 @@ const char* rp_HwGetError(int errorCode) {
         case RP_HW_ENRSPIIC:   return "I2C device not responding. Check connection and address.";
         case RP_HW_EISPIIC:    return "I2C invalid speed setting.";
         case RP_HW_EISAIIC:    return "I2C invalid slave address.";
+        case RP_HW_ESENS:      return "Failed to read sensor.";
+        case RP_HW_ESNR:       return "Sensor sampler is not running.";
 
         default:               return "Unknown error";
     }
@@ -484,4 +486,27 @@ int rp_GetPowerVCCDDR(uint32_t *raw, float* value){
         return RP_HW_EBIIC;
     }
     return sens_GetPowerVCCDDR(raw, value);
-}
\ No newline at end of file
+}
+
+int rp_SensorsRead(rp_sensor_t sensor, uint32_t* raw, float* value){
+    if (raw == NULL || value == NULL) {
+        return RP_HW_EIPV;
+    }
+    return sens_Read(sensor, raw, value) ? RP_HW_ESENS : RP_HW_OK;
+}
+
+int rp_SensorsStartSampler(uint32_t period_us, uint32_t history_size){
+    return sens_StartSampler(period_us, history_size);
+}
+
+int rp_SensorsStopSampler(){
+    return sens_StopSampler();
+}
+
+int rp_SensorsGetLatest(rp_sensor_t sensor, uint32_t* raw, float* value, uint64_t* timestamp_us){
+    return sens_GetLatest(sensor, raw, value, timestamp_us);
+}
+
+int rp_SensorsGetHistory(rp_sensor_t sensor, float* values, uint64_t* timestamps_us, uint32_t* size){
+    return sens_GetHistory(sensor, values, timestamps_us, size);
+}
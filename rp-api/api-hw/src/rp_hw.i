@@ -16,13 +16,14 @@
   import_array();
 %}
 
-%apply int { rp_uart_bits_size_t, rp_uart_stop_bits_t, rp_uart_parity_t, rp_spi_mode_t, rp_spi_state_t, rp_spi_cs_mode_t, rp_spi_order_bit_t }
+%apply int { rp_uart_bits_size_t, rp_uart_stop_bits_t, rp_uart_parity_t, rp_spi_mode_t, rp_spi_state_t, rp_spi_cs_mode_t, rp_spi_order_bit_t, rp_sensor_t }
 %apply int *OUTPUT { rp_uart_bits_size_t * _out_value, rp_uart_stop_bits_t * _out_value, rp_uart_parity_t * _out_value, rp_spi_mode_t * _out_value, rp_spi_state_t * _out_value, rp_spi_cs_mode_t * _out_value, rp_spi_order_bit_t * _out_value, int *_out_value }
 %apply bool *OUTPUT { bool * _out_value };
 %apply unsigned char *OUTPUT { uint8_t *_out_value };
 %apply unsigned short *OUTPUT { uint16_t *_out_value };
 %apply unsigned int *OUTPUT { uint32_t *_out_value, size_t *_out_value, size_t *_out_len, uint32_t *raw };
 %apply float *OUTPUT { float *value };
+%apply unsigned long long *OUTPUT { uint64_t *timestamp_us };
 
 /* --- NUMPY TYPEMAPS --- */
 
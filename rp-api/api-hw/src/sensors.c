@@ -1,32 +1,65 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
 #include "rp_hw.h"
 #include "sensors.h"
 #include "rp_log.h"
 
+#define XADC_IIO_PATH "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/"
 
-int sens_GetValueFromFile(const char* file, uint32_t *value){
+typedef struct {
+    const char* name;   // IIO channel prefix
+    bool has_offset;
+    atomic_bool is_init;  // set once scale, offset and fd_raw are valid
+    int fd_raw;         // kept open, re-read with pread
+    float scale;        // immutable for XADC, read once
+    float offset;
+} sens_channel_t;
 
-    if (!file || !value) {
-        ERROR_LOG("NULL pointer");
-        return -1;
-    }
+typedef struct {
+    uint64_t timestamp_us;
+    uint32_t raw[RP_SENS_COUNT];
+    float value[RP_SENS_COUNT];
+} sens_sample_t;
 
-    FILE *fp = fopen (file, "r");
-	if (!fp) {
-        ERROR_LOG("Can't open %s: %s", file, strerror(errno));
-        return -1;
-    }
-    int ret = fscanf(fp, "%u", value);
-    fclose(fp);
+static sens_channel_t g_channels[RP_SENS_COUNT] = {
+    [RP_SENS_TEMP] = {"in_temp0", true, false, -1, 0, 0},
+    [RP_SENS_VCCINT] = {"in_voltage0_vccint", false, false, -1, 0, 0},
+    [RP_SENS_VCCAUX] = {"in_voltage1_vccaux", false, false, -1, 0, 0},
+    [RP_SENS_VCCBRAM] = {"in_voltage2_vccbram", false, false, -1, 0, 0},
+    [RP_SENS_VCCPINT] = {"in_voltage3_vccpint", false, false, -1, 0, 0},
+    [RP_SENS_VCCPAUX] = {"in_voltage4_vccpaux", false, false, -1, 0, 0},
+    [RP_SENS_VCCDDR] = {"in_voltage5_vccoddr", false, false, -1, 0, 0},
+    [RP_SENS_AIN0] = {"in_voltage9", false, false, -1, 0, 0},
+    [RP_SENS_AIN1] = {"in_voltage11", false, false, -1, 0, 0},
+    [RP_SENS_AIN2] = {"in_voltage10", false, false, -1, 0, 0},
+    [RP_SENS_AIN3] = {"in_voltage8", false, false, -1, 0, 0},
+    [RP_SENS_AIN4] = {"in_voltage12", false, false, -1, 0, 0},
+};
 
-    if (ret != 1) {
-        ERROR_LOG("Failed to read value from %s", file);
-        return -1;
-    }
+// Guards channel opening only, the sampler thread may take it through sens_Read
+static pthread_mutex_t g_sens_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Serializes sampler start and stop. Never taken by the sampler thread, so stop can join it.
+static pthread_mutex_t g_sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-    return 0;
-}
+static pthread_t g_sampler_thread;
+static atomic_bool g_sampler_run = false;
+static atomic_bool g_sampler_started = false;
+// Readers copying from the ring right now, the ring is freed only when there are none
+static atomic_uint g_ring_readers = 0;
+static uint32_t g_sampler_period_us = 0;
+static sens_sample_t* g_ring = NULL;
+static uint32_t g_ring_size = 0;
+// Number of samples the sampler has started / finished writing. Readers copy from the ring
+// without locking and drop whatever the writer may have touched meanwhile.
+static atomic_uint_fast64_t g_ring_begin = 0;
+static atomic_uint_fast64_t g_ring_written = 0;
 
 int sens_GetFValueFromFile(const char* file, float *value){
     if (!file || !value) {
@@ -51,38 +84,74 @@ int sens_GetFValueFromFile(const char* file, float *value){
     return 0;
 }
 
-int GetTempValueRaw( uint32_t* raw , float* value) {
-    if (!raw || !value) {
-        ERROR_LOG("NULL pointer");
-        return -1;
+float sens_ConvertI4(uint32_t raw) {
+    float uAdc = (float)raw / 0xfff;
+    return uAdc * (56.0 + 4.99) / 4.99;
+}
+
+static int sens_OpenChannel(rp_sensor_t sensor) {
+    sens_channel_t* ch = &g_channels[sensor];
+    if (atomic_load_explicit(&ch->is_init, memory_order_acquire)) {
+        return 0;
     }
-    uint32_t offset = 0;
-    float scale = 0;
-    if (sens_GetValueFromFile("/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_temp0_offset",&offset))
-        return -1;
-    if (sens_GetValueFromFile("/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_temp0_raw",raw))
-        return -1;
-    if (sens_GetFValueFromFile("/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_temp0_scale",&scale))
-        return -1;
-    *value = ((float)(offset + *raw)) * scale / 1000.0;
-    return 0;
+    pthread_mutex_lock(&g_sens_mutex);
+    if (atomic_load_explicit(&ch->is_init, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_sens_mutex);
+        return 0;
+    }
+    char path[255];
+    int ret = -1;
+    snprintf(path, sizeof(path), XADC_IIO_PATH "%s_scale", ch->name);
+    if (sens_GetFValueFromFile(path, &ch->scale))
+        goto out;
+    ch->offset = 0;
+    if (ch->has_offset) {
+        snprintf(path, sizeof(path), XADC_IIO_PATH "%s_offset", ch->name);
+        if (sens_GetFValueFromFile(path, &ch->offset))
+            goto out;
+    }
+    snprintf(path, sizeof(path), XADC_IIO_PATH "%s_raw", ch->name);
+    ch->fd_raw = open(path, O_RDONLY | O_CLOEXEC);
+    if (ch->fd_raw < 0) {
+        ERROR_LOG("Can't open %s: %s", path, strerror(errno));
+        goto out;
+    }
+    atomic_store_explicit(&ch->is_init, true, memory_order_release);
+    ret = 0;
+out:
+    pthread_mutex_unlock(&g_sens_mutex);
+    return ret;
 }
 
-int GetValueRaw(const char* file, uint32_t* raw , float* value) {
-    if (!file || !raw || !value) {
-        ERROR_LOG("NULL pointer");
+int sens_Read(rp_sensor_t sensor, uint32_t* raw, float* value) {
+    if ((int)sensor < 0 || sensor >= RP_SENS_COUNT || !raw || !value) {
         return -1;
     }
-    float scale = 0;
-    char s_raw[255];
-    char s_scale[255];
-    sprintf(s_raw,"/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/%s_raw",file);
-    sprintf(s_scale,"/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/%s_scale",file);
-    if (sens_GetValueFromFile(s_raw , raw))
+    if (sens_OpenChannel(sensor))
+        return -1;
+    sens_channel_t* ch = &g_channels[sensor];
+
+    // sysfs regenerates the attribute on every read from offset 0
+    char buf[32];
+    ssize_t len = pread(ch->fd_raw, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        ERROR_LOG("Failed to read %s_raw: %s", ch->name, strerror(errno));
         return -1;
-    if (sens_GetFValueFromFile(s_scale , &scale))
+    }
+    buf[len] = 0;
+    char* end = NULL;
+    unsigned long v = strtoul(buf, &end, 10);
+    if (end == buf) {
+        ERROR_LOG("Failed to read value from %s_raw", ch->name);
         return -1;
-    *value = ((float)*raw) * scale / 1000.0;
+    }
+    *raw = v;
+    if (sensor == RP_SENS_AIN4) {
+        // AI4 is behind a divider, report the 5V line like rp_GetPowerI4
+        *value = sens_ConvertI4(*raw);
+    } else {
+        *value = ((float)*raw + ch->offset) * ch->scale / 1000.0;
+    }
     return 0;
 }
 
@@ -92,51 +161,203 @@ float sens_GetCPUTemp(uint32_t *raw){
         return -1;
     }
     float temp_val = 0;
-    if (GetTempValueRaw(raw,&temp_val))
+    if (sens_Read(RP_SENS_TEMP, raw, &temp_val))
         return -1;
     return temp_val;
 }
 
-int AI4pinGetValueRaw(uint32_t* value) {
-    FILE *fp = fopen ("/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage12_raw", "r");
-    if (!fp){
-        ERROR_LOG("Can't open %s","/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage12_raw");
-        return -1;
-    }
-    int r = fscanf (fp, "%u", value)  != 1;
-    fclose(fp);
-    return r;
-}
-
 int sens_GetPowerI4(uint32_t *raw,float* value){
-    uint32_t value_raw;
-    int result = AI4pinGetValueRaw(&value_raw);
-    float uAdc=(float)value_raw/0xfff;
-    *raw = value_raw;
-	*value = uAdc*(56.0+4.99)/4.99;
-    return result;
+    return sens_Read(RP_SENS_AIN4, raw, value) ? 1 : 0;
 }
 
 int sens_GetPowerVCCPINT(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage3_vccpint",raw,value);
+    return sens_Read(RP_SENS_VCCPINT, raw, value);
 }
 
 int sens_GetPowerVCCPAUX(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage4_vccpaux",raw,value);
+    return sens_Read(RP_SENS_VCCPAUX, raw, value);
 }
 
 int sens_GetPowerVCCBRAM(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage2_vccbram",raw,value);
+    return sens_Read(RP_SENS_VCCBRAM, raw, value);
 }
 
 int sens_GetPowerVCCINT(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage0_vccint",raw,value);
+    return sens_Read(RP_SENS_VCCINT, raw, value);
 }
 
 int sens_GetPowerVCCAUX(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage1_vccaux",raw,value);
+    return sens_Read(RP_SENS_VCCAUX, raw, value);
 }
 
 int sens_GetPowerVCCDDR(uint32_t *raw,float* value){
-    return GetValueRaw("in_voltage5_vccoddr",raw,value);
+    return sens_Read(RP_SENS_VCCDDR, raw, value);
+}
+
+/**
+ * Background sampler
+ */
+
+static uint64_t sens_NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static void* sens_SamplerThread(void* arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    uint64_t index = atomic_load_explicit(&g_ring_written, memory_order_relaxed);
+    while (atomic_load_explicit(&g_sampler_run, memory_order_relaxed)) {
+        atomic_store_explicit(&g_ring_begin, index + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        sens_sample_t* s = &g_ring[index % g_ring_size];
+        s->timestamp_us = sens_NowUs();
+        for (int i = 0; i < RP_SENS_COUNT; i++) {
+            if (sens_Read((rp_sensor_t)i, &s->raw[i], &s->value[i])) {
+                s->raw[i] = 0;
+                s->value[i] = 0;
+            }
+        }
+
+        index++;
+        atomic_store_explicit(&g_ring_written, index, memory_order_release);
+
+        next.tv_nsec += (long)(g_sampler_period_us % 1000000) * 1000;
+        next.tv_sec += g_sampler_period_us / 1000000 + next.tv_nsec / 1000000000;
+        next.tv_nsec %= 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+    }
+    return NULL;
+}
+
+int sens_StartSampler(uint32_t period_us, uint32_t history_size) {
+    if (period_us == 0 || history_size == 0) {
+        return RP_HW_EIPV;
+    }
+    pthread_mutex_lock(&g_sampler_mutex);
+    if (atomic_load(&g_sampler_started)) {
+        pthread_mutex_unlock(&g_sampler_mutex);
+        return RP_HW_EIPV;
+    }
+
+    // Open every channel up front so the sampler loop only does pread
+    for (int i = 0; i < RP_SENS_COUNT; i++) {
+        if (sens_OpenChannel((rp_sensor_t)i)) {
+            pthread_mutex_unlock(&g_sampler_mutex);
+            return RP_HW_ESENS;
+        }
+    }
+
+    // One extra slot is always in flight for the writer
+    g_ring_size = history_size + 1;
+    g_ring = (sens_sample_t*)calloc(g_ring_size, sizeof(sens_sample_t));
+    if (!g_ring) {
+        pthread_mutex_unlock(&g_sampler_mutex);
+        return RP_HW_EAL;
+    }
+    g_sampler_period_us = period_us;
+    atomic_store(&g_ring_begin, 0);
+    atomic_store(&g_ring_written, 0);
+    atomic_store(&g_sampler_run, true);
+    if (pthread_create(&g_sampler_thread, NULL, sens_SamplerThread, NULL)) {
+        atomic_store(&g_sampler_run, false);
+        free(g_ring);
+        g_ring = NULL;
+        pthread_mutex_unlock(&g_sampler_mutex);
+        return RP_HW_EAL;
+    }
+    atomic_store(&g_sampler_started, true);
+    pthread_mutex_unlock(&g_sampler_mutex);
+    return RP_HW_OK;
+}
+
+int sens_StopSampler(void) {
+    pthread_mutex_lock(&g_sampler_mutex);
+    if (!atomic_load(&g_sampler_started)) {
+        pthread_mutex_unlock(&g_sampler_mutex);
+        return RP_HW_OK;
+    }
+    // New readers see the sampler stopped, the ones already in wait for their copy to end
+    atomic_store(&g_sampler_started, false);
+    atomic_store(&g_sampler_run, false);
+    pthread_join(g_sampler_thread, NULL);
+    while (atomic_load(&g_ring_readers) != 0) {
+        sched_yield();
+    }
+    free(g_ring);
+    g_ring = NULL;
+    g_ring_size = 0;
+    pthread_mutex_unlock(&g_sampler_mutex);
+    return RP_HW_OK;
+}
+
+// Copies up to max samples ending at the newest one. Returns the number of consistent samples, oldest first.
+static uint32_t sens_CopyHistory(rp_sensor_t sensor, uint32_t max, uint32_t* raw, float* values, uint64_t* timestamps) {
+    for (;;) {
+        uint64_t end = atomic_load_explicit(&g_ring_written, memory_order_acquire);
+        uint64_t count = end < max ? end : max;
+        if (count > g_ring_size - 1)
+            count = g_ring_size - 1;
+        uint64_t first = end - count;
+        for (uint64_t i = first; i < end; i++) {
+            const sens_sample_t* s = &g_ring[i % g_ring_size];
+            uint32_t k = i - first;
+            if (raw)
+                raw[k] = s->raw[sensor];
+            if (values)
+                values[k] = s->value[sensor];
+            if (timestamps)
+                timestamps[k] = s->timestamp_us;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t begin = atomic_load_explicit(&g_ring_begin, memory_order_relaxed);
+        // Samples with index below begin - ring_size may have been overwritten during the copy
+        uint64_t valid_from = begin > g_ring_size ? begin - g_ring_size : 0;
+        if (first >= valid_from) {
+            return count;
+        }
+    }
+}
+
+// Registers a reader of the ring. Returns false, and registers nothing, when the sampler is stopped.
+// The counter goes up before the started flag is checked, so sens_StopSampler either is seen here or sees the reader.
+static bool sens_EnterRing(void) {
+    atomic_fetch_add(&g_ring_readers, 1);
+    if (!atomic_load(&g_sampler_started)) {
+        atomic_fetch_sub(&g_ring_readers, 1);
+        return false;
+    }
+    return true;
+}
+
+int sens_GetLatest(rp_sensor_t sensor, uint32_t* raw, float* value, uint64_t* timestamp_us) {
+    if ((int)sensor < 0 || sensor >= RP_SENS_COUNT || !raw || !value || !timestamp_us) {
+        return RP_HW_EIPV;
+    }
+    if (!sens_EnterRing()) {
+        return RP_HW_ESNR;
+    }
+    int ret = RP_HW_ESNR;
+    if (atomic_load_explicit(&g_ring_written, memory_order_acquire) != 0) {
+        sens_CopyHistory(sensor, 1, raw, value, timestamp_us);
+        ret = RP_HW_OK;
+    }
+    atomic_fetch_sub(&g_ring_readers, 1);
+    return ret;
+}
+
+int sens_GetHistory(rp_sensor_t sensor, float* values, uint64_t* timestamps_us, uint32_t* size) {
+    if ((int)sensor < 0 || sensor >= RP_SENS_COUNT || !values || !size) {
+        return RP_HW_EIPV;
+    }
+    if (!sens_EnterRing()) {
+        return RP_HW_ESNR;
+    }
+    *size = sens_CopyHistory(sensor, *size, NULL, values, timestamps_us);
+    atomic_fetch_sub(&g_ring_readers, 1);
+    return RP_HW_OK;
 }
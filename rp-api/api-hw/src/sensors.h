@@ -11,6 +11,9 @@
 #ifndef SENSORS_H
 #define SENSORS_H
 
+#include <stdint.h>
+#include "rp_hw.h"
+
 float sens_GetCPUTemp(uint32_t *raw);
 int sens_GetPowerI4(uint32_t *raw,float* value);
 int sens_GetPowerVCCPINT(uint32_t *raw,float* value);
@@ -20,4 +23,10 @@ int sens_GetPowerVCCINT(uint32_t *raw,float* value);
 int sens_GetPowerVCCAUX(uint32_t *raw,float* value);
 int sens_GetPowerVCCDDR(uint32_t *raw,float* value);
 
-#endif
\ No newline at end of file
+int sens_Read(rp_sensor_t sensor, uint32_t* raw, float* value);
+int sens_StartSampler(uint32_t period_us, uint32_t history_size);
+int sens_StopSampler(void);
+int sens_GetLatest(rp_sensor_t sensor, uint32_t* raw, float* value, uint64_t* timestamp_us);
+int sens_GetHistory(rp_sensor_t sensor, float* values, uint64_t* timestamps_us, uint32_t* size);
+
+#endif
@@ -1,6 +1,7 @@
 #!/usr/bin/python3
 
 import numpy as np
+import time
 import rp_hw
 
 
@@ -335,4 +336,27 @@ print(res,rp_hw.rp_HwGetError(res[0]))
 
 print("rp_hw.rp_GetPowerVCCDDR()")
 res = rp_hw.rp_GetPowerVCCDDR()
-print(res,rp_hw.rp_HwGetError(res[0]))
\ No newline at end of file
+print(res,rp_hw.rp_HwGetError(res[0]))
+
+print("rp_hw.rp_SensorsRead(rp_hw.RP_SENS_TEMP)")
+res = rp_hw.rp_SensorsRead(rp_hw.RP_SENS_TEMP)
+print(res,rp_hw.rp_HwGetError(res[0]))
+
+print("rp_hw.rp_SensorsGetLatest(rp_hw.RP_SENS_TEMP) without sampler")
+res = rp_hw.rp_SensorsGetLatest(rp_hw.RP_SENS_TEMP)
+print(res,rp_hw.rp_HwGetError(res[0]))
+
+print("rp_hw.rp_SensorsStartSampler(10000, 100)")
+res = rp_hw.rp_SensorsStartSampler(10000, 100)
+print(res,rp_hw.rp_HwGetError(res))
+
+time.sleep(0.5)
+
+for sensor in range(rp_hw.RP_SENS_COUNT):
+    print("rp_hw.rp_SensorsGetLatest(" + str(sensor) + ")")
+    res = rp_hw.rp_SensorsGetLatest(sensor)
+    print(res,rp_hw.rp_HwGetError(res[0]))
+
+print("rp_hw.rp_SensorsStopSampler()")
+res = rp_hw.rp_SensorsStopSampler()
+print(res,rp_hw.rp_HwGetError(res))
@@ -11,11 +11,15 @@
 #include <string.h>
 
 #include "common.h"
+#include "emulator.h"
 #include "rp.h"
 #include "rp_hw-profiles.h"
 
 int common_Open(const std::string dev, rp_handle_uio_t* handle) {
     handle->dev = dev;
+    if (la_emu_IsEnabled()) {
+        return la_emu_Map(handle);
+    }
     // try opening the device
     handle->fd = open(handle->dev.c_str(), O_RDWR);
     if (handle->fd == -1) {
@@ -33,6 +37,9 @@ int common_Open(const std::string dev, rp_handle_uio_t* handle) {
 }
 
 int common_Close(rp_handle_uio_t* handle) {
+    if (la_emu_IsEnabled()) {
+        return la_emu_Unmap(handle);
+    }
     int r = 0;
     // release regset
     if (munmap((void*)handle->regset, handle->length) == -1) {
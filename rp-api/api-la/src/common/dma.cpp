@@ -13,11 +13,17 @@
 #include <string.h>
 
 #include "dma.h"
+#include "emulator.h"
 #include "rp.h"
 
 int rp_dmaReservedMemory(uint32_t* _startAddress, uint32_t* _size) {
     *_startAddress = 0;
     *_size = 0;
+    if (la_emu_IsEnabled()) {
+        *_startAddress = LA_EMU_RESERVED_MEMORY_ADDR;
+        *_size = LA_EMU_RESERVED_MEMORY_SIZE;
+        return RP_OK;
+    }
     int fd = 0;
     if ((fd = open("/sys/firmware/devicetree/base/reserved-memory/buffer@2000000_b/reg", O_RDONLY)) == -1) {
         FATAL("Error open: /sys/firmware/devicetree/base/reserved-memory/buffer@2000000_b/reg\n");
@@ -52,6 +58,9 @@ int rp_dmaOpen(const std::string dev, rp_handle_uio_t* handle, size_t sgm_size,
     }
 
     handle->dma_dev = dev;
+    if (la_emu_IsEnabled()) {
+        return la_emu_DmaOpen(handle, sgm_count * sgm_size);
+    }
     handle->dma_fd = open(handle->dma_dev.c_str(), O_RDWR);
 
     if (handle->dma_fd == -1) {
@@ -68,6 +77,9 @@ int rp_dmaOpen(const std::string dev, rp_handle_uio_t* handle, size_t sgm_size,
 }
 
 int rp_dmaCtrl(rp_handle_uio_t* handle, RP_DMA_CTRL ctrl) {
+    if (la_emu_IsEnabled()) {
+        return la_emu_DmaCtrl(handle, ctrl);
+    }
     switch (ctrl) {
         case RP_DMA_CYCLIC:
             ioctl(handle->dma_fd, CYCLIC_RX, 0);
@@ -95,6 +107,9 @@ int rp_dmaRead(rp_handle_uio_t* handle, int timeout_s, bool* timeOut) {
 
     TRACE_SHORT("Read")
     *timeOut = false;
+    if (la_emu_IsEnabled()) {
+        return la_emu_DmaRead(handle, timeout_s, timeOut);
+    }
     ioctl(handle->dma_fd, TIMEOUT, timeout_s);  // Set timeout in sec
     int s = read(handle->dma_fd, NULL, 1);
     if (s < 0) {
@@ -108,6 +123,9 @@ int rp_dmaRead(rp_handle_uio_t* handle, int timeout_s, bool* timeOut) {
 }
 
 int rp_dmaClose(rp_handle_uio_t* handle) {
+    if (la_emu_IsEnabled()) {
+        return la_emu_DmaClose(handle);
+    }
     if (handle->dma_fd) {
         if (close(handle->dma_fd) == -1) {
             return -1;
@@ -0,0 +1,254 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya logic analyzer emulation implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "emulator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "common.h"
+#include "rp.h"
+#include "rp_la_acq.h"
+
+#define LA_EMU_POLL_US 1000
+
+namespace {
+
+typedef struct {
+    int16_t* mem;
+    uint64_t size;  // In 16 bit words
+    bool rle;
+    uint64_t words = 0;
+} emu_writer_t;
+
+// Trigger search position, kept between polls
+typedef struct {
+    uint64_t clock;
+    uint8_t last;
+} emu_scan_t;
+
+volatile rp_la_acq_regset_t* g_regs = NULL;
+int16_t* g_dma = NULL;
+size_t g_dmaSize = 0;
+uint64_t g_start = 0;  // Base clock of the first sample
+std::atomic_bool g_stop = false;
+const auto g_epoch = std::chrono::steady_clock::now();
+
+auto clockNow() -> uint64_t {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+    return (uint64_t)((double)ns * c_max_dig_sampling_rate / 1e9);
+}
+
+auto inputs(uint64_t clock, uint8_t polarity) -> uint8_t {
+    return (uint8_t)(clock / LA_EMU_STEP_CLOCKS) ^ polarity;
+}
+
+// Samples until the counter can change again, at least one
+auto runLength(uint64_t clock, uint32_t dec) -> uint64_t {
+    uint64_t next = (clock / LA_EMU_STEP_CLOCKS + 1) * LA_EMU_STEP_CLOCKS;
+    return std::max<uint64_t>(1, (next - clock + dec - 1) / dec);
+}
+
+auto fires(uint8_t last, uint8_t value, const rp_la_trg_regset_t& trg) -> bool {
+    bool level = ((value ^ trg.cmp_val) & trg.cmp_msk) == 0;
+    if ((trg.edg_pos | trg.edg_neg) == 0)
+        return level;
+    uint32_t rising = ~last & value;
+    uint32_t falling = last & ~value;
+    return level && ((rising & trg.edg_pos) || (falling & trg.edg_neg));
+}
+
+// Scans the samples up to clock to, true with the trigger sample in *at
+auto findTrigger(emu_scan_t* scan, uint64_t to, uint32_t dec, uint8_t polarity, const rp_la_trg_regset_t& trg, uint64_t* at) -> bool {
+    while (scan->clock <= to) {
+        uint8_t value = inputs(scan->clock, polarity);
+        if (fires(scan->last, value, trg)) {
+            *at = scan->clock;
+            return true;
+        }
+        scan->last = value;
+        scan->clock += runLength(scan->clock, dec) * dec;
+    }
+    return false;
+}
+
+void put(emu_writer_t* w, uint8_t value, uint64_t count) {
+    if (w->rle) {
+        // Length - 1 in the upper byte, at most 256 samples per word
+        while (count > 0) {
+            uint64_t n = std::min<uint64_t>(count, 256);
+            w->mem[w->words++ % w->size] = (int16_t)(((n - 1) << 8) | value);
+            count -= n;
+        }
+        return;
+    }
+    // Only the last buffer length of samples is kept
+    if (count > w->size) {
+        w->words += count - w->size;
+        count = w->size;
+    }
+    for (; count > 0; count--) {
+        w->mem[w->words++ % w->size] = value;
+    }
+}
+
+void render(emu_writer_t* w, uint64_t clock, uint64_t samples, uint32_t dec, uint8_t polarity) {
+    while (samples > 0) {
+        uint64_t n = std::min(samples, runLength(clock, dec));
+        put(w, inputs(clock, polarity), n);
+        clock += n * dec;
+        samples -= n;
+    }
+}
+
+}  // namespace
+
+bool la_emu_IsEnabled() {
+    static const bool enabled = [] {
+        auto env = getenv("RP_EMULATION");
+        return env && *env && strcmp(env, "0") != 0;
+    }();
+    return enabled;
+}
+
+int la_emu_Map(rp_handle_uio_t* handle) {
+    void* mem = mmap(NULL, handle->length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        ERROR_LOG("Error map emulated registers")
+        return -1;
+    }
+    handle->fd = -1;
+    handle->regset = mem;
+    g_regs = (volatile rp_la_acq_regset_t*)mem;
+    return 0;
+}
+
+int la_emu_Unmap(rp_handle_uio_t* handle) {
+    g_regs = NULL;
+    if (munmap((void*)handle->regset, handle->length) == -1) {
+        ERROR_LOG("Error unmap emulated registers")
+        return -1;
+    }
+    handle->regset = NULL;
+    return 0;
+}
+
+int la_emu_DmaOpen(rp_handle_uio_t* handle, size_t size) {
+    // A memfd, so rp_la_api can map dma_fd like the DMA device
+    int fd = memfd_create("rp-la-dma", MFD_CLOEXEC);
+    if (fd == -1 || ftruncate(fd, size) == -1) {
+        ERROR_LOG("Unable to create emulated DMA buffer");
+        if (fd != -1)
+            close(fd);
+        return -1;
+    }
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        ERROR_LOG("Unable to map emulated DMA buffer");
+        close(fd);
+        return -1;
+    }
+    g_dma = (int16_t*)mem;
+    g_dmaSize = size;
+    handle->dma_fd = fd;
+    handle->dma_size = size;
+    return RP_OK;
+}
+
+int la_emu_DmaCtrl(rp_handle_uio_t* handle, RP_DMA_CTRL ctrl) {
+    switch (ctrl) {
+        case RP_DMA_CYCLIC:
+            g_start = clockNow();
+            g_stop = false;
+            break;
+        case RP_DMA_STOP_RX:
+            g_stop = true;
+            break;
+        default:
+            return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+int la_emu_DmaRead(rp_handle_uio_t* handle, int timeout_s, bool* timeOut) {
+    *timeOut = false;
+    auto regs = g_regs;
+    if (!regs || !g_dma) {
+        ERROR_LOG("Emulated LA is not open")
+        return -1;
+    }
+
+    uint32_t dec = ioread32(&regs->dec.dec) + 1;
+    uint8_t polarity = ioread32(&regs->cfg_pol);
+    uint32_t pre = ioread32(&regs->cfg.pre);
+    uint32_t pst = ioread32(&regs->cfg.pst);
+    uint32_t mask = ioread32(&regs->trig_mask);
+    bool rle = ioread32(&regs->cfg_rle) & RP_LA_ACQ_RLE_ENABLE_MASK;
+    rp_la_trg_regset_t trg;
+    trg.cmp_msk = ioread32(&regs->trg.cmp_msk);
+    trg.cmp_val = ioread32(&regs->trg.cmp_val);
+    trg.edg_pos = ioread32(&regs->trg.edg_pos);
+    trg.edg_neg = ioread32(&regs->trg.edg_neg);
+
+    // Triggers are only accepted once the pre-trigger samples are in
+    uint64_t first = g_start + (uint64_t)pre * dec;
+    emu_scan_t scan = {first, inputs(first >= dec ? first - dec : first, polarity)};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_s);
+    uint64_t trigger = first;
+    while (!(ioread32(&regs->cfg__aut_con) & RP_LA_ACQ_CFG_AUTO_MASK)) {
+        uint64_t now = clockNow();
+        if ((mask & RP_TRG_LOA_PAT_MASK) && findTrigger(&scan, now, dec, polarity, trg, &trigger))
+            break;
+        if ((mask & RP_TRG_LOA_SWE_MASK) && (ioread32(&regs->ctl) & RP_CTL_SWT_MASK)) {
+            trigger = std::max(first, g_start + (now - std::min(now, g_start)) / dec * dec);
+            break;
+        }
+        // A stop or the timeout end the read without data, like the driver
+        if (g_stop || (timeout_s > 0 && std::chrono::steady_clock::now() >= deadline)) {
+            *timeOut = true;
+            return RP_OK;
+        }
+        usleep(LA_EMU_POLL_US);
+    }
+
+    // Samples are written from the start of the buffer, the trigger sample is the first post-trigger one
+    emu_writer_t w = {g_dma, g_dmaSize / sizeof(int16_t), rle};
+    render(&w, trigger - (uint64_t)pre * dec, (uint64_t)pre + pst, dec, polarity);
+
+    iowrite32((uint32_t)(pre % w.size) + TRIG_DELAY_SAMPLES, &regs->sts.pre);
+    iowrite32(pst, &regs->sts.pst);
+    iowrite32((uint32_t)w.words, &regs->sts_cur);
+    iowrite32((uint32_t)w.words, &regs->sts_lst);
+    uint64_t stop = trigger + (uint64_t)pst * dec;
+    iowrite32((uint32_t)g_start, &regs->cts_acq_lo);
+    iowrite32((uint32_t)(g_start >> 32), &regs->cts_acq_hi);
+    iowrite32((uint32_t)trigger, &regs->cts_trg_lo);
+    iowrite32((uint32_t)(trigger >> 32), &regs->cts_trg_hi);
+    iowrite32((uint32_t)stop, &regs->cts_stp_lo);
+    iowrite32((uint32_t)(stop >> 32), &regs->cts_stp_hi);
+    return RP_OK;
+}
+
+int la_emu_DmaClose(rp_handle_uio_t* handle) {
+    int r = RP_OK;
+    if (g_dma && munmap(g_dma, g_dmaSize) == -1) {
+        r = -1;
+    }
+    g_dma = NULL;
+    g_dmaSize = 0;
+    if (close(handle->dma_fd) == -1) {
+        r = -1;
+    }
+    return r;
+}
@@ -0,0 +1,45 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya logic analyzer emulation interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __RP_LA_EMULATOR_H
+#define __RP_LA_EMULATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "structs.h"
+
+// Same nominal region as the rp-api emulation backend
+#define LA_EMU_RESERVED_MEMORY_ADDR 0x2000000
+#define LA_EMU_RESERVED_MEMORY_SIZE 0x800000
+
+#define LA_EMU_STEP_CLOCKS 125  // Inputs count up every 1 us at 125 MHz
+
+/**
+ * With RP_EMULATION=1 the LA registers are plain process memory and the DMA buffer is a memfd, so
+ * rp_la_api can map it like the DMA device. A blocking read runs the capture: the inputs are an
+ * 8 bit counter stepping every LA_EMU_STEP_CLOCKS base clocks, sampled with the set decimation and
+ * polarity. Pattern/edge, software and auto triggers are honoured. The pre- and post-trigger
+ * samples around the trigger are written in RLE or raw format, and the status registers and time
+ * stamps are set like the FPGA leaves them. The trigger is awaited in real time, the post-trigger
+ * samples are available at once.
+ */
+
+bool la_emu_IsEnabled();
+
+int la_emu_Map(rp_handle_uio_t* handle);
+int la_emu_Unmap(rp_handle_uio_t* handle);
+
+int la_emu_DmaOpen(rp_handle_uio_t* handle, size_t size);
+int la_emu_DmaCtrl(rp_handle_uio_t* handle, RP_DMA_CTRL ctrl);
+int la_emu_DmaRead(rp_handle_uio_t* handle, int timeout_s, bool* timeOut);
+int la_emu_DmaClose(rp_handle_uio_t* handle);
+
+#endif  //__RP_LA_EMULATOR_H
@@ -8,6 +8,7 @@
 #include <limits>
 #include <list>
 #include <string>
+#include <tuple>
 
 #include "bit_decoder/bit_decoder_one_line_rle.h"
 #include "common/profiler.h"
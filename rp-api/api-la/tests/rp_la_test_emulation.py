@@ -0,0 +1,38 @@
+#!/usr/bin/python3
+
+# Runs an RLE capture on the logic analyzer emulation. Does not need a board, so it can run on a host CI machine.
+# The emulated inputs are an 8 bit counter, the capture triggers on a rising edge of DIO3.
+
+import os
+import sys
+import numpy as np
+
+os.environ["RP_EMULATION"] = "1"
+import rp_la
+
+PRE = 1000
+POST = 3000
+
+obj = rp_la.CLAController()
+obj.setEnableRLE(True)
+obj.setDecimation(1)
+obj.setTrigger(rp_la.LA_T_CHANNEL_4, rp_la.LA_RISING)
+obj.setPreTriggerSamples(PRE)
+obj.setPostTriggerSamples(POST)
+
+obj.runAsync(0)
+isTimeout = obj.wait(5000)
+print("Timeout", isTimeout)
+
+samples = np.zeros(obj.getCapturedSamples(), dtype=np.uint8)
+count = obj.getUnpackedRLEDataNP(samples)
+print("Unpacked samples count:", count)
+if isTimeout or count != PRE + POST:
+    sys.exit(1)
+
+before = samples[PRE - 1] & 0x08
+after = samples[PRE] & 0x08
+print("DIO3 around the trigger", before, after)
+if before != 0 or after == 0:
+    sys.exit(1)
+del obj
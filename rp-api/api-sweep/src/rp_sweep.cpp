@@ -1,5 +1,6 @@
 #include "rp_sweep.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cmath>
@@ -15,6 +16,13 @@
 #include <vector>
 #include "rp_hw-profiles.h"
 
+// Shortest step of the software sweep. The generator registers are written at most this often.
+#define SWEEP_MIN_STEP_US 50
+// Upper limit of the precomputed steps per sweep, keeps the table of long sweeps small
+#define SWEEP_MAX_STEPS 16384
+// Idle wake up interval when no channel is sweeping
+#define SWEEP_IDLE_MS 100
+
 using namespace std;
 using namespace std::chrono;
 
@@ -33,39 +41,62 @@ auto getDACChannels() -> uint8_t {
 
 uint8_t g_sweep_dac_max_channels = getDACChannels();
 
+struct Stats {
+    uint64_t writes = 0;     // Frequency register writes
+    uint64_t missed = 0;     // Steps skipped because the thread woke up too late
+    uint64_t deadlines = 0;  // Steps executed
+    double jitterSum = 0;    // Wake up delay after the step deadline, ns
+    double jitterMax = 0;
+};
+
 struct Settings {
-    time_point<system_clock> startTime;
+    time_point<steady_clock> startTime;
     bool run = false;
-    int currentStep = 0;
-    int startF = 0;
-    int endF = 0;
+    float startF = 0;
+    float endF = 0;
     int time = 1;
     uint64_t rep = 0;
     bool isInf = true;
-    uint64_t currentRep = 0;
     rp_gen_sweep_mode_t mode = RP_GEN_SWEEP_MODE_LINEAR;
     rp_gen_sweep_dir_t dir = RP_GEN_SWEEP_DIR_NORMAL;
+
+    // Precomputed sweep, rebuilt after every settings change.
+    // freq[i] is the frequency at x = i / steps, dds[i] the matching generator phase step.
+    vector<float> freq;
+    vector<uint64_t> dds;
+    uint32_t steps = 0;
+    uint64_t nextStep = 0;  // Absolute step index: cycle * steps + step in cycle
+    uint64_t lastDDS = UINT64_MAX;
+    bool done = false;
+    Stats stats;
 };
 
 struct CSweepController::Impl {
-    auto getNewFreq(Settings& _setting) -> double;
-    auto reset(rp_channel_t _ch, time_point<system_clock> _tp) -> int;
+    auto reset(rp_channel_t _ch, time_point<steady_clock> _tp) -> int;
+    auto buildTable(Settings& _setting) -> void;
+    auto stepDeadline(const Settings& _setting, uint64_t _step) -> time_point<steady_clock>;
+    auto process(rp_channel_t _ch, Settings& _setting, time_point<steady_clock> _now) -> void;
     auto loop() -> void;
     thread m_Thread;
     mutex mtx;
     mutex mtx_run;
-    atomic_flag m_ThreadRun = ATOMIC_FLAG_INIT;
+    condition_variable m_cv;
+    atomic_bool m_ThreadRun;
     atomic_bool m_IsRun;
     atomic_bool m_Pause;
     Settings m_Settings[RP_CH_4 + 1];
-    time_point<system_clock> m_lastLoop;
+    uint32_t m_dacRate = 0;
     bool apiInit = false;
 };
 
 CSweepController::CSweepController() {
     m_pimpl = new Impl();
+    m_pimpl->m_ThreadRun = false;
     m_pimpl->m_IsRun = false;
     m_pimpl->m_Pause = false;
+    if (rp_HPGetBaseFastDACSpeedHz(&m_pimpl->m_dacRate) != RP_HP_OK) {
+        ERROR_LOG("Can't get fast DAC base rate")
+    }
     setDefault();
     if (!rp_IsApiInit()) {
         if (rp_InitAddresses() == RP_OK) {
@@ -107,8 +138,7 @@ void CSweepController::run() {
         if (m_pimpl->m_IsRun)
             return;
         m_pimpl->m_IsRun = true;
-        m_pimpl->m_ThreadRun.test_and_set();
-        m_pimpl->m_lastLoop = std::chrono::system_clock::now();
+        m_pimpl->m_ThreadRun = true;
         m_pimpl->m_Thread = std::thread(&CSweepController::Impl::loop, this->m_pimpl);
     } catch (const std::exception& e) {
         ERROR_LOG("Thread cannot be started %s", e.what())
@@ -117,81 +147,113 @@ void CSweepController::run() {
 
 void CSweepController::stop() {
     lock_guard<std::mutex> lock(m_pimpl->mtx_run);
-    m_pimpl->m_ThreadRun.clear();
+    {
+        lock_guard<std::mutex> lock(m_pimpl->mtx);
+        m_pimpl->m_ThreadRun = false;
+        m_pimpl->m_cv.notify_all();
+    }
     if (m_pimpl->m_Thread.joinable())
         m_pimpl->m_Thread.join();
     m_pimpl->m_IsRun = false;
 }
 
-double CSweepController::Impl::getNewFreq(Settings& _setting) {
-    if (_setting.run == false)
-        return -1;
-    if (_setting.isInf == false && _setting.currentRep == 0)
-        return -1;
-
-    double start = min(_setting.startF, _setting.endF);
-    double stop = max(_setting.startF, _setting.endF);
-    bool invert = _setting.startF > _setting.endF;
-
-    auto timeNow = system_clock::now();
-    auto curTime = time_point_cast<microseconds>(timeNow);
-    auto startTime = time_point_cast<microseconds>(_setting.startTime);
-    uint64_t time = curTime.time_since_epoch().count() - startTime.time_since_epoch().count();
-    uint64_t cycles = time / _setting.time;
-
-    double x = static_cast<double>(time - cycles * _setting.time) / static_cast<double>(_setting.time);
-    double freq = 0;
-
-    if (_setting.isInf == false) {
-        auto koff = (_setting.dir == RP_GEN_SWEEP_DIR_UP_DOWN ? 2 : 1);
-        _setting.currentRep = _setting.rep * koff - std::min(cycles, _setting.rep * koff);
-        if (_setting.currentRep == 0) {
-            x = koff == 2 ? 0 : 1;
+auto CSweepController::Impl::buildTable(Settings& _setting) -> void {
+    _setting.steps = std::clamp(_setting.time / SWEEP_MIN_STEP_US, 1, SWEEP_MAX_STEPS);
+    _setting.freq.resize(_setting.steps + 1);
+    _setting.dds.resize(_setting.steps + 1);
+    double start = _setting.startF;
+    double stop = _setting.endF;
+    for (uint32_t i = 0; i <= _setting.steps; i++) {
+        double x = static_cast<double>(i) / static_cast<double>(_setting.steps);
+        double freq = 0;
+        if (_setting.mode == RP_GEN_SWEEP_MODE_LINEAR) {
+            freq = (stop - start) * x + start;
         }
+        if (_setting.mode == RP_GEN_SWEEP_MODE_LOG) {
+            freq = start * exp(x * log(stop / start));
+        }
+        _setting.freq[i] = freq;
+        // Same quantization as the generator phase step register (32.32 fixed point)
+        _setting.dds[i] = m_dacRate ? (uint64_t)(65536.0 * freq / m_dacRate * DAC_BUFFER_SIZE * 4294967296.0) : i;
+    }
+}
+
+auto CSweepController::Impl::stepDeadline(const Settings& _setting, uint64_t _step) -> time_point<steady_clock> {
+    uint64_t period = (uint64_t)_setting.time * 1000;
+    uint64_t cycle = _step / _setting.steps;
+    uint64_t inCycle = _step % _setting.steps;
+    return _setting.startTime + nanoseconds(cycle * period + inCycle * period / _setting.steps);
+}
+
+auto CSweepController::Impl::process(rp_channel_t _ch, Settings& _setting, time_point<steady_clock> _now) -> void {
+    uint64_t period = (uint64_t)_setting.time * 1000;
+    uint64_t elapsed = duration_cast<nanoseconds>(_now - _setting.startTime).count();
+    uint64_t step = (elapsed / period) * _setting.steps + (elapsed % period) * _setting.steps / period;
+    step = std::max(step, _setting.nextStep);
+    uint64_t cycle = step / _setting.steps;
+
+    auto jitter = (double)duration_cast<nanoseconds>(_now - stepDeadline(_setting, _setting.nextStep)).count();
+    _setting.stats.deadlines++;
+    _setting.stats.jitterSum += jitter;
+    _setting.stats.jitterMax = std::max(_setting.stats.jitterMax, jitter);
+    _setting.stats.missed += step - _setting.nextStep;
+
+    bool upDown = _setting.dir == RP_GEN_SWEEP_DIR_UP_DOWN;
+    uint32_t index = 0;
+    if (_setting.isInf == false && cycle >= _setting.rep * (upDown ? 2 : 1)) {
+        // Last repetition done. Hold the end frequency, or the start frequency after up-down.
+        index = upDown ? 0 : _setting.steps;
+        _setting.done = true;
+    } else {
+        uint32_t inCycle = step % _setting.steps;
+        index = upDown && (cycle % 2) ? _setting.steps - inCycle : inCycle;
     }
 
-    if (invert)
-        x = 1 - x;
-    if (cycles % 2 != 0 && _setting.dir == RP_GEN_SWEEP_DIR_UP_DOWN)
-        x = 1 - x;
-
-    if (_setting.mode == RP_GEN_SWEEP_MODE_LINEAR) {
-        freq = ((stop - start) * x + start);
-    }
-
-    if (_setting.mode == RP_GEN_SWEEP_MODE_LOG) {
-        freq = start * exp(x * log(stop / start));
+    if (_setting.dds[index] != _setting.lastDDS) {
+        rp_GenFreqDirect(_ch, _setting.freq[index]);
+        rp_GenTriggerOnly(_ch);
+        _setting.lastDDS = _setting.dds[index];
+        _setting.stats.writes++;
     }
-
-    return freq;
+    _setting.nextStep = step + 1;
 }
 
 void CSweepController::Impl::loop() {
     try {
-        while (m_ThreadRun.test_and_set()) {
-            mtx.lock();
+        unique_lock<mutex> lock(mtx);
+        while (m_ThreadRun) {
             if (m_Pause) {
-                auto curTime = time_point_cast<microseconds>(system_clock::now());
-                auto lastTime = time_point_cast<microseconds>(m_lastLoop);
-                auto time = curTime - lastTime;
-                m_Settings[0].startTime += time;
-                m_Settings[1].startTime += time;
-            } else {
-                auto freq1 = getNewFreq(m_Settings[0]);
-                auto freq2 = getNewFreq(m_Settings[1]);
-
-                if (freq1 > 0) {
-                    rp_GenFreqDirect(RP_CH_1, freq1);
-                    rp_GenTriggerOnly(RP_CH_1);
-                }
-                if (freq2 > 0) {
-                    rp_GenFreqDirect(RP_CH_2, freq2);
-                    rp_GenTriggerOnly(RP_CH_2);
+                // Running sweeps are shifted by the paused time, so they continue where they stopped.
+                // A sweep reset during the pause starts when the pause ends.
+                auto pauseStart = steady_clock::now();
+                m_cv.wait(lock, [this] { return !m_Pause || !m_ThreadRun; });
+                auto pauseEnd = steady_clock::now();
+                for (int i = 0; i < g_sweep_dac_max_channels; i++) {
+                    auto& setting = m_Settings[i];
+                    if (setting.startTime > pauseStart) {
+                        setting.startTime = pauseEnd;
+                    } else if (setting.run && !setting.done) {
+                        setting.startTime += pauseEnd - pauseStart;
+                    }
                 }
+                continue;
+            }
+
+            auto now = steady_clock::now();
+            auto next = now + milliseconds(SWEEP_IDLE_MS);
+            for (int i = 0; i < g_sweep_dac_max_channels; i++) {
+                auto& setting = m_Settings[i];
+                if (!setting.run || setting.done)
+                    continue;
+                if (setting.freq.empty())
+                    buildTable(setting);
+                if (stepDeadline(setting, setting.nextStep) <= now)
+                    process((rp_channel_t)i, setting, now);
+                if (!setting.done)
+                    next = std::min(next, stepDeadline(setting, setting.nextStep));
             }
-            m_lastLoop = std::chrono::system_clock::now();
-            mtx.unlock();
-            std::this_thread::sleep_for(std::chrono::microseconds(1));
+            // Settings changes, pause and stop wake the thread up early
+            m_cv.wait_until(lock, next);
         }
 
     } catch (std::exception& e) {
@@ -199,12 +261,18 @@ void CSweepController::Impl::loop() {
     }
 }
 
-int CSweepController::Impl::reset(rp_channel_t _ch, time_point<system_clock> _tp) {
+int CSweepController::Impl::reset(rp_channel_t _ch, time_point<steady_clock> _tp) {
     int index = convertIndex(_ch);
     if (index >= 0) {
-        m_Settings[index].currentStep = 0;
-        m_Settings[index].startTime = _tp;
-        m_Settings[index].currentRep = m_Settings[index].rep;
+        auto& setting = m_Settings[index];
+        setting.startTime = _tp;
+        setting.freq.clear();
+        setting.dds.clear();
+        setting.nextStep = 0;
+        setting.lastDDS = UINT64_MAX;
+        setting.done = false;
+        setting.stats = Stats();
+        m_cv.notify_all();
         return RP_OK;
     }
     return RP_EOOR;
@@ -217,7 +285,7 @@ int CSweepController::genSweep(rp_channel_t _ch, bool _enable) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].run != _enable) {
         m_pimpl->m_Settings[index].run = _enable;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -243,7 +311,7 @@ int CSweepController::setStartFreq(rp_channel_t _ch, float _freq) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].startF != _freq) {
         m_pimpl->m_Settings[index].startF = _freq;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -259,7 +327,7 @@ int CSweepController::setStopFreq(rp_channel_t _ch, float _freq) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].endF != _freq) {
         m_pimpl->m_Settings[index].endF = _freq;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -300,7 +368,7 @@ auto CSweepController::setNumberOfRepetitions(rp_channel_t _ch, bool _isInfinty,
             reqReset = true;
     }
     if (reqReset)
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
 
     return RP_OK;
 }
@@ -327,7 +395,7 @@ int CSweepController::setTime(rp_channel_t _ch, int _time) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].time != _time) {
         m_pimpl->m_Settings[index].time = _time;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -349,7 +417,7 @@ int CSweepController::setMode(rp_channel_t _ch, rp_gen_sweep_mode_t _mode) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].mode != _mode) {
         m_pimpl->m_Settings[index].mode = _mode;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -371,7 +439,7 @@ int CSweepController::setDir(rp_channel_t _ch, rp_gen_sweep_dir_t _dir) {
         return RP_EOOR;
     if (m_pimpl->m_Settings[index].dir != _dir) {
         m_pimpl->m_Settings[index].dir = _dir;
-        return m_pimpl->reset(_ch, system_clock::now());
+        return m_pimpl->reset(_ch, steady_clock::now());
     }
     return RP_OK;
 }
@@ -386,9 +454,79 @@ auto CSweepController::getDir(rp_channel_t _ch, rp_gen_sweep_dir_t* _dir) -> int
     return RP_EOOR;
 }
 
+auto CSweepController::getStats(rp_channel_t _ch, uint64_t* _writes, uint64_t* _missed, double* _jitterAvgUs, double* _jitterMaxUs) -> int {
+    lock_guard<std::mutex> lock(m_pimpl->mtx);
+    int index = convertIndex(_ch);
+    if (index < 0)
+        return RP_EOOR;
+    auto& stats = m_pimpl->m_Settings[index].stats;
+    *_writes = stats.writes;
+    *_missed = stats.missed;
+    *_jitterAvgUs = stats.deadlines ? stats.jitterSum / stats.deadlines / 1000.0 : 0;
+    *_jitterMaxUs = stats.jitterMax / 1000.0;
+    return RP_OK;
+}
+
+auto CSweepController::loadChirp(rp_channel_t _ch) -> int {
+    lock_guard<std::mutex> lock(m_pimpl->mtx);
+    int index = convertIndex(_ch);
+    if (index < 0)
+        return RP_EOOR;
+    auto& setting = m_pimpl->m_Settings[index];
+
+    // One buffer holds the whole sweep, up and down for RP_GEN_SWEEP_DIR_UP_DOWN
+    bool upDown = setting.dir == RP_GEN_SWEEP_DIR_UP_DOWN;
+    double period = setting.time * 1e-6 * (upDown ? 2 : 1);
+    double sampleRate = std::min<double>(DAC_BUFFER_SIZE / period, m_pimpl->m_dacRate);
+    if (std::max(fabs(setting.startF), fabs(setting.endF)) >= sampleRate / 2) {
+        ERROR_LOG("Sweep up to %f Hz needs a longer sweep time. Sample rate of the chirp is %f Hz", std::max(setting.startF, setting.endF), sampleRate)
+        return RP_EOOR;
+    }
+
+    vector<float> chirp(DAC_BUFFER_SIZE);
+    double start = setting.startF;
+    double stop = setting.endF;
+    double phase = 0;
+    for (uint32_t i = 0; i < DAC_BUFFER_SIZE; i++) {
+        double x = static_cast<double>(i) / DAC_BUFFER_SIZE;
+        if (upDown)
+            x = x < 0.5 ? x * 2 : 2 - x * 2;
+        double freq = 0;
+        if (setting.mode == RP_GEN_SWEEP_MODE_LINEAR) {
+            freq = (stop - start) * x + start;
+        }
+        if (setting.mode == RP_GEN_SWEEP_MODE_LOG) {
+            freq = start * exp(x * log(stop / start));
+        }
+        chirp[i] = sin(phase);
+        phase = fmod(phase + 2 * M_PI * freq * period / DAC_BUFFER_SIZE, 2 * M_PI);
+    }
+
+    // The generator plays the sweep, the software sweep of this channel stops
+    setting.run = false;
+    m_pimpl->reset(_ch, steady_clock::now());
+
+    int ret = rp_GenWaveform(_ch, RP_WAVEFORM_ARBITRARY);
+    if (ret == RP_OK)
+        ret = rp_GenArbWaveform(_ch, chirp.data(), DAC_BUFFER_SIZE);
+    if (ret == RP_OK)
+        ret = rp_GenFreqDirect(_ch, 1.0 / period);
+    if (ret == RP_OK && !setting.isInf) {
+        ret = rp_GenMode(_ch, RP_GEN_MODE_BURST);
+        if (ret == RP_OK)
+            ret = rp_GenBurstCount(_ch, (int)setting.rep);
+    } else if (ret == RP_OK) {
+        // A burst left by an earlier finite chirp would stop the endless one
+        ret = rp_GenMode(_ch, RP_GEN_MODE_CONTINUOUS);
+    }
+    if (ret == RP_OK)
+        ret = rp_GenTriggerOnly(_ch);
+    return ret;
+}
+
 void CSweepController::resetAll() {
     lock_guard<std::mutex> lock(m_pimpl->mtx);
-    auto tp = system_clock::now();
+    auto tp = steady_clock::now();
     for (int i = RP_CH_1; i <= RP_CH_4 && i < g_sweep_dac_max_channels; i++) {
         m_pimpl->reset((rp_channel_t)i, tp);
     }
@@ -404,7 +542,9 @@ auto CSweepController::isAllDisabled() -> bool {
 }
 
 void CSweepController::pause(bool _state) {
+    lock_guard<std::mutex> lock(m_pimpl->mtx);
     m_pimpl->m_Pause = _state;
+    m_pimpl->m_cv.notify_all();
 }
 
 auto CSweepController::setDefault() -> void {
@@ -557,6 +697,18 @@ int rp_SWGetDir(rp_channel_t ch, rp_gen_sweep_dir_t* dir) {
     return g_sweep->getDir(ch, dir);
 }
 
+int rp_SWGetStats(rp_channel_t ch, uint64_t* writes, uint64_t* missed, double* jitterAvgUs, double* jitterMaxUs) {
+    if (g_sweep == NULL)
+        return RP_EANI;
+    return g_sweep->getStats(ch, writes, missed, jitterAvgUs, jitterMaxUs);
+}
+
+int rp_SWLoadChirp(rp_channel_t ch) {
+    if (g_sweep == NULL)
+        return RP_EANI;
+    return g_sweep->loadChirp(ch);
+}
+
 int rp_SWResetAll() {
     if (g_sweep == NULL)
         return RP_EANI;
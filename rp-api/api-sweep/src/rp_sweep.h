@@ -39,6 +39,22 @@ class CSweepController {
     auto resetAll() -> void;
     auto setDefault() -> void;
 
+    /**
+     * Timing of the software sweep since the last settings change.
+     * _writes: generator frequency updates. Steps that quantize to the same frequency register are not written.
+     * _missed: steps skipped because the sweep thread woke up after the next step deadline.
+     * _jitterAvgUs, _jitterMaxUs: delay of the frequency update after its deadline.
+     */
+    auto getStats(rp_channel_t _ch, uint64_t* _writes, uint64_t* _missed, double* _jitterAvgUs, double* _jitterMaxUs) -> int;
+
+    /**
+     * Loads the configured sweep into the generator as an arbitrary waveform (chirp).
+     * The generator then sweeps on its own with sample accurate timing, which allows much shorter
+     * sweep times than the software sweep. The software sweep of the channel is disabled.
+     * Finite repetitions use burst mode. Returns RP_EOOR if the sweep time is too short for the stop frequency.
+     */
+    auto loadChirp(rp_channel_t _ch) -> int;
+
    private:
     CSweepController(const CSweepController&) = delete;
     CSweepController(CSweepController&&) = delete;
@@ -72,6 +88,8 @@ int rp_SWSetNumberOfRepetitions(rp_channel_t ch, bool _isInfinty, uint64_t _coun
 int rp_SWGetNumberOfRepetitions(rp_channel_t ch, bool* _isInfinty, uint64_t* _count);
 int rp_SWSetDir(rp_channel_t ch, rp_gen_sweep_dir_t dir);
 int rp_SWGetDir(rp_channel_t ch, rp_gen_sweep_dir_t* dir);
+int rp_SWGetStats(rp_channel_t ch, uint64_t* writes, uint64_t* missed, double* jitterAvgUs, double* jitterMaxUs);
+int rp_SWLoadChirp(rp_channel_t ch);
 
 }  // namespace rp_sweep_api
 
@@ -13,6 +13,7 @@
 %apply float *OUTPUT { float * };
 %apply int *OUTPUT { int * };
 %apply uint64_t *OUTPUT { uint64_t * };
+%apply double *OUTPUT { double * };
 %apply int *OUTPUT { rp_gen_sweep_mode_t *_mode };
 %apply int *OUTPUT { rp_gen_sweep_dir_t *_dir };
 %apply int *OUTPUT { rp_gen_sweep_mode_t *mode };
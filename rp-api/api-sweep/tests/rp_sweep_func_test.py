@@ -70,6 +70,12 @@ print(rp_sweep.rp_SWGenSweep(rp.RP_CH_1,True))
 print("rp_sweep.rp_SWIsGen(rp.RP_CH_1)")
 print(rp_sweep.rp_SWIsGen(rp.RP_CH_1))
 
+print("rp_sweep.rp_SWGetStats(rp.RP_CH_1)")
+print(rp_sweep.rp_SWGetStats(rp.RP_CH_1))
+
+print("rp_sweep.rp_SWLoadChirp(rp.RP_CH_1)")
+print(rp_sweep.rp_SWLoadChirp(rp.RP_CH_1))
+
 print("rp_sweep.rp_SWStop()")
 print(rp_sweep.rp_SWStop())
 
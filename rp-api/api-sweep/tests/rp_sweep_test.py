@@ -96,6 +96,14 @@ print("obj.isAllDisabled()")
 res = obj.isAllDisabled()
 print(res)
 
+print("obj.getStats(rp.RP_CH_1)")
+res = obj.getStats(rp.RP_CH_1)
+print(res)
+
+print("obj.loadChirp(rp.RP_CH_1)")
+res = obj.loadChirp(rp.RP_CH_1)
+print(res)
+
 print("obj.stop()")
 res = obj.stop()
 print(res)
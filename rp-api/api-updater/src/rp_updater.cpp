@@ -12,14 +12,19 @@
 
 #include <signal.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 #include "rp_log.h"
 #include "rp_updater_curl.h"
 #include "rp_updater_fs.h"
+#include "rp_updater_zip.h"
 
 #define NAME_LEN 20
 
@@ -40,6 +45,13 @@ struct info_t {
     uint32_t buildNumber;
 };
 
+// The archive is extracted into ECOSYSTEM_EXTRACT_PATH while it downloads
+struct pipeline_t {
+    CUZipStream zip;
+    std::string fileName;
+    uint64_t received = 0;
+};
+
 void signalHandlerStrong(int signum) {}
 
 void signalHandlerDefault(int signum) {
@@ -113,6 +125,102 @@ void copyEcosystem() {
 
 std::vector<std::pair<std::string, info_t>> g_downloadedFiles;
 
+auto extractPath(const std::string& fileName) -> std::string {
+    return std::string(ECOSYSTEM_EXTRACT_PATH) + "/" + fileName;
+}
+
+// A directory of ours that nobody else can write, not a symlink
+auto isPrivateDirectory(const std::string& path) -> bool {
+    struct stat st;
+    return lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Creates ECOSYSTEM_EXTRACT_PATH, or replaces it when someone else could have written into it
+auto prepareExtractPath() -> int {
+    if (isPrivateDirectory(ECOSYSTEM_EXTRACT_PATH)) {
+        return RP_UP_OK;
+    }
+    std::error_code ec;
+    fs::remove_all(ECOSYSTEM_EXTRACT_PATH, ec);
+    if (mkdir(ECOSYSTEM_EXTRACT_PATH, 0700) != 0 || !isPrivateDirectory(ECOSYSTEM_EXTRACT_PATH)) {
+        ERROR_LOG("Can't create %s", ECOSYSTEM_EXTRACT_PATH);
+        return RP_UP_ERR;
+    }
+    return RP_UP_OK;
+}
+
+// The manifest is written last, a tree without it is incomplete. Trees extracted during a full download
+// are only used for the archive they came from, checked by its MD5. Delta trees have no archive, they are
+// trusted because only the updater can write into ECOSYSTEM_EXTRACT_PATH.
+auto getExtracted(const std::string& fileName, zip_manifest_t* manifest) -> bool {
+    if (!isPrivateDirectory(ECOSYSTEM_EXTRACT_PATH) || !isPrivateDirectory(extractPath(fileName))) {
+        return false;
+    }
+    if (readManifest(extractPath(fileName) + "/" + ECOSYSTEM_MANIFEST, manifest) != RP_UP_OK || manifest->zip_name != fileName) {
+        return false;
+    }
+    if (manifest->zip_md5 == "delta") {
+        return true;
+    }
+    auto zip_path = std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName;
+    std::error_code ec;
+    auto size = fs::file_size(zip_path, ec);
+    if (ec || size != manifest->zip_size || manifest->zip_md5.empty()) {
+        return false;
+    }
+    std::string md5;
+    return rp_UpdaterGetMD5(zip_path, &md5) == RP_UP_OK && md5 == manifest->zip_md5;
+}
+
+auto attachPipeline(CUCurl* curl, std::shared_ptr<pipeline_t> pipeline) -> int {
+    auto ret = prepareExtractPath();
+    if (ret != RP_UP_OK) {
+        return ret;
+    }
+    removeDirectory(extractPath(pipeline->fileName));
+    ret = pipeline->zip.start(extractPath(pipeline->fileName));
+    if (ret != RP_UP_OK) {
+        return ret;
+    }
+    curl->setDataCallback([pipeline](const uint8_t* data, size_t size, uint64_t offset) {
+        if (offset < pipeline->received) {
+            pipeline->zip.restart();
+        }
+        pipeline->received = offset + size;
+        // Errors are reported by finish, the download goes on
+        pipeline->zip.write(data, size);
+        return true;
+    });
+    return RP_UP_OK;
+}
+
+auto completePipeline(std::shared_ptr<pipeline_t> pipeline, bool success) -> int {
+    auto out_dir = extractPath(pipeline->fileName);
+    if (!success) {
+        pipeline->zip.abort();
+        removeDirectory(out_dir);
+        return RP_UP_EDF;
+    }
+    auto ret = pipeline->zip.finish();
+    if (ret == RP_UP_ECM) {
+        ERROR_LOG("Downloaded file %s is corrupted", pipeline->fileName.c_str());
+        removeDirectory(out_dir);
+        fs::remove(std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + pipeline->fileName);
+        return RP_UP_ECM;
+    }
+    if (ret != RP_UP_OK) {
+        // Left to unzip when installing
+        WARNING("Can't extract %s during download", pipeline->fileName.c_str());
+        removeDirectory(out_dir);
+        return RP_UP_OK;
+    }
+    zip_manifest_t manifest = {.zip_name = pipeline->fileName, .zip_size = pipeline->zip.getSize(), .zip_md5 = pipeline->zip.getMD5(), .entries = pipeline->zip.getEntries()};
+    if (writeManifest(out_dir + "/" + ECOSYSTEM_MANIFEST, manifest) != RP_UP_OK) {
+        removeDirectory(out_dir);
+    }
+    return RP_UP_OK;
+}
+
 int rp_UpdaterInit() {
     fs::create_directories(ECOSYSTEM_DOWNLOAD_PATH);
     fs::permissions(ECOSYSTEM_DOWNLOAD_PATH, std::filesystem::perms::owner_all | std::filesystem::perms::group_all, std::filesystem::perm_options::add);
@@ -174,6 +282,8 @@ int rp_UpdaterGetDownloadedFilesList(std::vector<std::string>& files) {
 int rp_UpdaterDownloadFile(std::string url, const std::string& username, const std::string& password) {
     CUCurl curl;
     auto fileName = CUCurl::getFilenameFromUrl(url);
+    auto pipeline = std::make_shared<pipeline_t>();
+    pipeline->fileName = fileName;
     curl.setDoneCallback([fileName](bool success) {
         std::lock_guard lock(g_callbackMutex);
         if (g_callbacks) {
@@ -186,7 +296,13 @@ int rp_UpdaterDownloadFile(std::string url, const std::string& username, const s
             g_callbacks->downloadProgress(fileName, now, total, stop);
         }
     });
-    return curl.downloadFile(url, std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName, username, password);
+    auto ret = attachPipeline(&curl, pipeline);
+    if (ret != RP_UP_OK) {
+        return ret;
+    }
+    ret = curl.downloadFile(url, std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName, username, password);
+    auto ret2 = completePipeline(pipeline, ret == RP_UP_OK);
+    return ret != RP_UP_OK ? ret : ret2;
 }
 
 int rp_UpdaterDownloadFileAsync(std::string url, const std::string& username, const std::string& password) {
@@ -194,7 +310,10 @@ int rp_UpdaterDownloadFileAsync(std::string url, const std::string& username, co
     delete g_curl;
     g_curl = new CUCurl();
     auto fileName = CUCurl::getFilenameFromUrl(url);
-    g_curl->setDoneCallback([fileName](bool success) {
+    auto pipeline = std::make_shared<pipeline_t>();
+    pipeline->fileName = fileName;
+    g_curl->setDoneCallback([fileName, pipeline](bool success) {
+        success = completePipeline(pipeline, success) == RP_UP_OK && success;
         std::lock_guard lock(g_callbackMutex);
         if (g_callbacks) {
             g_callbacks->downloadDone(fileName, success);
@@ -206,8 +325,181 @@ int rp_UpdaterDownloadFileAsync(std::string url, const std::string& username, co
             g_callbacks->downloadProgress(fileName, now, total, stop);
         }
     });
+    auto ret = attachPipeline(g_curl, pipeline);
+    if (ret != RP_UP_OK) {
+        return ret;
+    }
     return g_curl->downloadFileAsync(url, std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName, username, password);
 }
+// Copies an installed file that should be unchanged, the copy is checked against the CRC32 of the new archive
+auto copyInstalled(const std::string& src, const std::string& dst, const zip_entry_t& entry, std::string* md5) -> bool {
+    FILE* in = fopen(src.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+    createDirTree(dst.substr(0, dst.find_last_of('/')));
+    FILE* out = fopen(dst.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_md5(), NULL);
+    uint32_t crc = crc32(0L, Z_NULL, 0);
+    uint64_t size = 0;
+    bool ok = true;
+    std::vector<uint8_t> buffer(65536);
+    size_t n = 0;
+    while (ok && (n = fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        crc = crc32(crc, buffer.data(), n);
+        EVP_DigestUpdate(ctx, buffer.data(), n);
+        size += n;
+        ok = fwrite(buffer.data(), 1, n, out) == n;
+    }
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_size = 0;
+    EVP_DigestFinal_ex(ctx, hash, &hash_size);
+    EVP_MD_CTX_free(ctx);
+    fclose(in);
+    ok &= fclose(out) == 0;
+    ok &= crc == entry.crc32 && size == entry.size;
+    if (!ok) {
+        std::remove(dst.c_str());
+        return false;
+    }
+    char hex[3];
+    md5->clear();
+    for (unsigned int i = 0; i < hash_size; i++) {
+        snprintf(hex, sizeof(hex), "%02x", hash[i]);
+        *md5 += hex;
+    }
+    return true;
+}
+
+int rp_UpdaterDownloadFileDelta(std::string url, const std::string& username, const std::string& password) {
+    auto fileName = CUCurl::getFilenameFromUrl(url);
+    zip_manifest_t installed;
+    if (readManifest(std::string(ECOSYSTEM_INSTALL_PATH) + "/" + ECOSYSTEM_MANIFEST, &installed) != RP_UP_OK) {
+        TRACE_SHORT("No installed manifest, full download")
+        return rp_UpdaterDownloadFile(url, username, password);
+    }
+
+    CUCurl curl;
+    uint64_t size = 0;
+    if (curl.getRemoteSize(url, &size, username, password) != RP_UP_OK) {
+        return RP_UP_ERR;
+    }
+    auto collect = [](std::vector<uint8_t>* buffer) {
+        return [buffer](const uint8_t* data, size_t size, uint64_t offset) {
+            buffer->insert(buffer->end(), data, data + size);
+            return true;
+        };
+    };
+
+    // The end record and usually the whole central directory
+    std::vector<uint8_t> tail;
+    uint64_t tail_size = std::min<uint64_t>(size, 256 * 1024);
+    uint64_t cd_offset = 0;
+    uint64_t cd_size = 0;
+    if (curl.downloadRange(url, size - tail_size, tail_size, collect(&tail), username, password) != RP_UP_OK) {
+        TRACE_SHORT("No range support, full download")
+        return rp_UpdaterDownloadFile(url, username, password);
+    }
+    if (zipFindCentralDirectory(tail, size, &cd_offset, &cd_size) != RP_UP_OK || cd_offset + cd_size > size) {
+        return RP_UP_EUF;
+    }
+    std::vector<uint8_t> cd;
+    if (cd_offset >= size - tail_size) {
+        auto begin = tail.begin() + (cd_offset - (size - tail_size));
+        cd.assign(begin, begin + cd_size);
+    } else if (curl.downloadRange(url, cd_offset, cd_size, collect(&cd), username, password) != RP_UP_OK) {
+        return RP_UP_EDF;
+    }
+    std::vector<zip_entry_t> entries;
+    if (zipParseCentralDirectory(cd, &entries) != RP_UP_OK) {
+        return RP_UP_EUF;
+    }
+    std::sort(entries.begin(), entries.end(), [](const zip_entry_t& a, const zip_entry_t& b) { return a.offset < b.offset; });
+
+    std::map<std::string, zip_entry_t> installed_files;
+    for (auto& entry : installed.entries) {
+        installed_files[entry.name] = entry;
+    }
+
+    if (prepareExtractPath() != RP_UP_OK) {
+        return RP_UP_ERR;
+    }
+    auto out_dir = extractPath(fileName);
+    removeDirectory(out_dir);
+    createDirTree(out_dir);
+    zip_manifest_t manifest = {.zip_name = fileName, .zip_size = size, .zip_md5 = "delta", .entries = {}};
+
+    // Consecutive changed entries are fetched with one request, up to the next entry or the central directory
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    uint64_t fetch_size = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto& entry = entries[i];
+        uint64_t end = i + 1 < entries.size() ? entries[i + 1].offset : cd_offset;
+        if (entry.name.back() == '/') {
+            createDirTree(out_dir + "/" + entry.name.substr(0, entry.name.size() - 1));
+            continue;
+        }
+        auto it = installed_files.find(entry.name);
+        if (zipIsSafeName(entry.name) && it != installed_files.end() && it->second.crc32 == entry.crc32 && it->second.size == entry.size &&
+            copyInstalled(std::string(ECOSYSTEM_INSTALL_PATH) + "/" + entry.name, out_dir + "/" + entry.name, entry, &entry.md5)) {
+            manifest.entries.push_back(entry);
+            continue;
+        }
+        if (!ranges.empty() && ranges.back().second == entry.offset) {
+            ranges.back().second = end;
+        } else {
+            ranges.push_back({entry.offset, end});
+        }
+        fetch_size += end - entry.offset;
+    }
+    TRACE_SHORT("Delta %s: %zu files unchanged, fetch %llu of %llu bytes", fileName.c_str(), manifest.entries.size(),
+                (unsigned long long)fetch_size, (unsigned long long)size)
+
+    // The fetched entries and the central directory form a stream the extractor accepts
+    CUZipStream zip;
+    auto ret = zip.start(out_dir);
+    uint64_t fetched = 0;
+    for (auto& range : ranges) {
+        if (ret != RP_UP_OK) {
+            break;
+        }
+        ret = curl.downloadRange(
+            url, range.first, range.second - range.first,
+            [&](const uint8_t* data, size_t size, uint64_t offset) {
+                fetched += size;
+                std::lock_guard lock(g_callbackMutex);
+                if (g_callbacks) {
+                    g_callbacks->downloadProgress(fileName, fetched, fetch_size, false);
+                }
+                return zip.write(data, size);
+            },
+            username, password);
+    }
+    if (ret == RP_UP_OK) {
+        zip.write(cd.data(), cd.size());
+        ret = zip.finish();
+    }
+    if (ret == RP_UP_OK) {
+        auto& fetched_entries = zip.getEntries();
+        manifest.entries.insert(manifest.entries.end(), fetched_entries.begin(), fetched_entries.end());
+        ret = writeManifest(out_dir + "/" + ECOSYSTEM_MANIFEST, manifest);
+    }
+    if (ret != RP_UP_OK) {
+        zip.abort();
+        removeDirectory(out_dir);
+    }
+    std::lock_guard lock(g_callbackMutex);
+    if (g_callbacks) {
+        g_callbacks->downloadDone(fileName, ret == RP_UP_OK);
+    }
+    return ret;
+}
+
 int rp_UpdaterWaitDownloadFile() {
     std::lock_guard lock(g_curlMutex);
     if (g_curl) {
@@ -382,8 +674,31 @@ int rp_UpdaterGetReleaseAvailableFilesList(std::vector<std::string>& files) {
     return RP_UP_OK;
 }
 
+// md5.txt lists the hashes of the boot files, the manifest has the hashes computed during extraction
+auto isValidExtracted(const std::string& fileName, const zip_manifest_t& manifest) -> bool {
+    std::ifstream file(extractPath(fileName) + "/md5.txt");
+    std::string md5((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    md5.erase(std::remove(md5.begin(), md5.end(), ' '), md5.end());
+    if (md5 == "") {
+        return false;
+    }
+    for (auto name : {"boot.bin", "u-boot.scr", "uImage"}) {
+        auto entry = std::find_if(manifest.entries.begin(), manifest.entries.end(), [name](const zip_entry_t& e) { return e.name == name; });
+        if (entry == manifest.entries.end() || entry->md5 == "" || md5.find(entry->md5 + name) == std::string::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int rp_UpdaterIsValidDownloadedFile(std::string fileName, bool* state) {
     *state = false;
+    zip_manifest_t manifest;
+    if (getExtracted(fileName, &manifest) && manifest.zip_md5 != "") {
+        *state = isValidExtracted(fileName, manifest);
+        return RP_UP_OK;
+    }
+
     auto md5 = readFileFromZip(std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName, "md5.txt");
     if (md5 == "") {
         return RP_UP_OK;
@@ -472,22 +787,53 @@ bool replace_self(std::string& new_executable_path) {
 }
 
 int rp_UpdaterUpdateBoardEcosystem(std::string fileName, bool stopServices) {
+    // Checked once here, the archive MD5 is not computed twice
+    zip_manifest_t manifest;
+    bool extracted = getExtracted(fileName, &manifest);
     bool valid = false;
-    rp_UpdaterIsValidDownloadedFile(fileName, &valid);
+    if (extracted) {
+        valid = isValidExtracted(fileName, manifest);
+    } else {
+        rp_UpdaterIsValidDownloadedFile(fileName, &valid);
+    }
     if (!valid) {
         return RP_UP_ECM;
     }
-    auto out_dir = std::string("/tmp/") + fileName;
-    removeDirectory(out_dir);
-    auto ret = unzip(std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName, out_dir, [](uint64_t current, uint64_t total, const char* fileName) {
+    auto out_dir = extractPath(fileName);
+    int ret = RP_UP_OK;
+    if (extracted) {
+        // Extracted during the download
         std::lock_guard lock(g_callbackMutex);
         if (g_callbacks) {
-            g_callbacks->unzipProgress(current, total, fileName);
+            g_callbacks->unzipProgress(manifest.entries.size(), manifest.entries.size(), "");
         }
-    });
-
-    if (ret != RP_UP_OK) {
-        return ret;
+    } else {
+        auto zip_path = std::string(ECOSYSTEM_DOWNLOAD_PATH) + "/" + fileName;
+        ret = prepareExtractPath();
+        if (ret != RP_UP_OK) {
+            return ret;
+        }
+        removeDirectory(out_dir);
+        manifest.entries.clear();
+        ret = unzip(
+            zip_path, out_dir,
+            [](uint64_t current, uint64_t total, const char* fileName) {
+                std::lock_guard lock(g_callbackMutex);
+                if (g_callbacks) {
+                    g_callbacks->unzipProgress(current, total, fileName);
+                }
+            },
+            &manifest.entries);
+
+        if (ret != RP_UP_OK) {
+            return ret;
+        }
+        // Installed with the ecosystem for the next delta download
+        std::error_code ec;
+        manifest.zip_name = fileName;
+        manifest.zip_size = fs::file_size(zip_path, ec);
+        manifest.zip_md5 = "";
+        writeManifest(out_dir + "/" + ECOSYSTEM_MANIFEST, manifest);
     }
 
     signal(SIGCHLD, signalHandlerStrong);
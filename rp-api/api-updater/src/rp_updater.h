@@ -42,6 +42,9 @@ int rp_UpdaterIsValidDownloadedFile(std::string fileName, bool* state);
 
 int rp_UpdaterDownloadFile(std::string url, const std::string& username = "", const std::string& password = "");
 int rp_UpdaterDownloadFileAsync(std::string url, const std::string& username = "", const std::string& password = "");
+// Fetches only the files whose CRC32 differs from the installed ecosystem and copies the others.
+// The result is installed with rp_UpdaterUpdateBoardEcosystem, no archive is kept.
+int rp_UpdaterDownloadFileDelta(std::string url, const std::string& username = "", const std::string& password = "");
 
 int rp_UpdaterWaitDownloadFile();
 int rp_UpdaterStopDownloadFile();
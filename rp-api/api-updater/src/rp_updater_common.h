@@ -50,6 +50,10 @@
 
 #define ECOSYSTEM_DOWNLOAD_PATH "/home/redpitaya/ecosystems"
 #define ECOSYSTEM_INSTALL_PATH "/opt/redpitaya"
+/** Private to the updater (0700), trees in it are installed without unzipping again */
+#define ECOSYSTEM_EXTRACT_PATH "/home/redpitaya/ecosystems/.extracted"
+/** Written at the root of an extracted ecosystem, lists the files with their CRC32 and MD5. Installed with the ecosystem. */
+#define ECOSYSTEM_MANIFEST ".rp_updater_manifest"
 
 int rp_UpdaterGetMD5(std::string fileName, std::string* hash);
 int rp_UpdaterGetMD5(const std::vector<uint8_t>& data, std::string* hash);
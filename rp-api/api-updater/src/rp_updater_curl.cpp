@@ -9,6 +9,9 @@
  */
 
 #include "rp_updater_curl.h"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <regex>
@@ -16,8 +19,81 @@
 
 namespace fs = std::filesystem;
 
-size_t curl_write_data(void* ptr, size_t size, size_t nmemb, FILE* stream) {
-    return fwrite(ptr, size, nmemb, stream);
+struct download_ctx_t {
+    CUCurl* holder;
+    CURL* curl;
+    FILE* fp;
+    uint64_t offset;
+    bool checked;
+    bool rejected;
+};
+
+struct range_ctx_t {
+    std::function<bool(const uint8_t* data, size_t size, uint64_t offset)> func;
+    CURL* curl;
+    uint64_t offset;
+    uint64_t end;
+    bool checked;
+    bool rejected;
+};
+
+static auto truncateFile(FILE* fp) -> bool {
+    return fflush(fp) == 0 && ftruncate(fileno(fp), 0) == 0;
+}
+
+static auto setupRequest(CURL* curl, const std::string& url, const std::string& username, const std::string& password) -> void {
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);  // 10 sec
+    // A connection that stalls for 30 sec is dropped and resumed
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+    if (!username.empty() || !password.empty()) {
+        curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
+        curl_easy_setopt(curl, CURLOPT_USERNAME, username.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+    }
+}
+
+size_t CUCurl::curl_write_part(void* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto ctx = static_cast<download_ctx_t*>(userdata);
+    size_t length = size * nmemb;
+    if (!ctx->checked) {
+        long http_code = 0;
+        curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code != 200 && http_code != 206) {
+            return 0;
+        }
+        ctx->checked = true;
+    }
+    if (fwrite(ptr, 1, length, ctx->fp) != length) {
+        return 0;
+    }
+    if (ctx->holder->m_data && !ctx->holder->m_data(static_cast<const uint8_t*>(ptr), length, ctx->offset)) {
+        ctx->rejected = true;
+        return 0;
+    }
+    ctx->offset += length;
+    return length;
+}
+
+size_t CUCurl::curl_write_range(void* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto ctx = static_cast<range_ctx_t*>(userdata);
+    size_t length = size * nmemb;
+    if (!ctx->checked) {
+        long http_code = 0;
+        curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code != 206) {
+            return 0;
+        }
+        ctx->checked = true;
+    }
+    length = std::min<uint64_t>(length, ctx->end - ctx->offset);
+    if (!ctx->func(static_cast<const uint8_t*>(ptr), length, ctx->offset)) {
+        ctx->rejected = true;
+        return 0;
+    }
+    ctx->offset += length;
+    return size * nmemb;
 }
 
 size_t curl_write_html_data(void* contents, size_t size, size_t nmemb, std::string* s) {
@@ -35,7 +111,8 @@ int CUCurl::progressCallback(void* clientp, curl_off_t dltotal, curl_off_t dlnow
         auto ptr = static_cast<CUCurl*>(clientp);
         if (dltotal > 204) {
             if (ptr->m_delegate != nullptr) {
-                ptr->m_delegate(dlnow, dltotal, ptr->stop_download);
+                uint64_t offset = ptr->m_resume_offset;
+                ptr->m_delegate(dlnow + offset, dltotal + offset, ptr->stop_download);
             }
         }
         if (ptr->stop_download) {
@@ -64,7 +141,9 @@ CUCurl::CUCurl() {
     m_delegate = nullptr;
     m_downloadTh = nullptr;
     m_done = nullptr;
+    m_data = nullptr;
     stop_download = false;
+    m_resume_offset = 0;
 }
 
 CUCurl::~CUCurl() {
@@ -89,37 +168,114 @@ auto CUCurl::wait() -> void {
     }
 }
 
-auto CUCurl::downloadFile(const std::string& url, const std::string& output_file, const std::string& username, const std::string& password) -> int {
-    CURL* curl = NULL;
-    FILE* fp;
-    CURLcode res;
+auto CUCurl::waitRetry(int attempt) -> bool {
+    // 1, 2, 4, 8 and 16 seconds between the attempts
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1 << std::min(attempt - 1, 4));
+    while (std::chrono::steady_clock::now() < until) {
+        if (stop_download) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return !stop_download;
+}
 
-    curl = curl_easy_init();
-    if (curl) {
-        fp = fopen(output_file.c_str(), "wb");
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_data);
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);  // 10 sec
+auto CUCurl::download(const std::string& url, const std::string& output_file, const std::string& username, const std::string& password) -> int {
+    auto part_file = output_file + ".part";
+    download_ctx_t ctx;
+    ctx.holder = this;
+    ctx.fp = fopen(part_file.c_str(), "a+b");
+    if (!ctx.fp) {
+        return RP_UP_EOF;
+    }
+
+    // The bytes of an interrupted download are passed on again before the transfer resumes
+    fseek(ctx.fp, 0, SEEK_END);
+    ctx.offset = ftell(ctx.fp);
+    if (ctx.offset > 0 && m_data) {
+        fseek(ctx.fp, 0, SEEK_SET);
+        std::vector<uint8_t> buffer(65536);
+        uint64_t offset = 0;
+        size_t n = 0;
+        while (offset < ctx.offset && (n = fread(buffer.data(), 1, buffer.size(), ctx.fp)) > 0) {
+            if (!m_data(buffer.data(), n, offset)) {
+                break;
+            }
+            offset += n;
+        }
+        if (offset != ctx.offset) {
+            WARNING("Discard %s", part_file.c_str());
+            truncateFile(ctx.fp);
+            ctx.offset = 0;
+        }
+    }
+    if (ctx.offset > 0) {
+        TRACE_SHORT("Resume %s from %llu", part_file.c_str(), (unsigned long long)ctx.offset)
+    }
+
+    int ret = RP_UP_EDF;
+    for (int attempt = 0; attempt <= DOWNLOAD_RETRIES; attempt++) {
+        if (attempt > 0 && !waitRetry(attempt)) {
+            break;
+        }
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            break;
+        }
+        ctx.curl = curl;
+        ctx.checked = false;
+        ctx.rejected = false;
+        m_resume_offset = ctx.offset;
+        setupRequest(curl, url, username, password);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_part);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
         curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
         curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
         curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CUCurl::progressCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-        if (!username.empty() || !password.empty()) {
-            curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
-            curl_easy_setopt(curl, CURLOPT_USERNAME, username.c_str());
-            curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+        if (ctx.offset > 0) {
+            curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)ctx.offset);
         }
-        res = curl_easy_perform(curl);
+        auto res = curl_easy_perform(curl);
         long http_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
         curl_easy_cleanup(curl);
-        fclose(fp);
 
-        if (res == CURLE_OK && http_code == 200) {
-            return RP_UP_OK;
+        if (res == CURLE_OK && (http_code == 200 || http_code == 206)) {
+            ret = RP_UP_OK;
+            break;
+        }
+        if (stop_download || ctx.rejected) {
+            break;
+        }
+        if (ctx.offset > 0 && (res == CURLE_RANGE_ERROR || http_code == 416)) {
+            // The server can't resume or the part does not match its file any more. The whole file comes again.
+            WARNING("Can't resume %s, restart", part_file.c_str());
+            truncateFile(ctx.fp);
+            ctx.offset = 0;
+            continue;
         }
+        if (http_code >= 400 && http_code < 500) {
+            WARNING("HTTP error: %ld", http_code);
+            break;
+        }
+        WARNING("Download interrupted at %llu (%s), attempt %d", (unsigned long long)ctx.offset, curl_easy_strerror(res), attempt + 1);
     }
-    return RP_UP_EDF;
+    m_resume_offset = 0;
+    bool ok = fflush(ctx.fp) == 0;
+    ok &= fclose(ctx.fp) == 0;
+    if (ret == RP_UP_OK && (!ok || rename(part_file.c_str(), output_file.c_str()) != 0)) {
+        ret = RP_UP_EOF;
+    }
+    // A part is kept for the next attempt only when it has data
+    if (ret != RP_UP_OK && ctx.offset == 0) {
+        std::remove(part_file.c_str());
+    }
+    return ret;
+}
+
+auto CUCurl::downloadFile(const std::string& url, const std::string& output_file, const std::string& username, const std::string& password) -> int {
+    stop_download = false;
+    return download(url, output_file, username, password);
 }
 
 auto CUCurl::downloadFileAsync(const std::string& url, const std::string& output_file, const std::string& username, const std::string& password) -> int {
@@ -128,47 +284,78 @@ auto CUCurl::downloadFileAsync(const std::string& url, const std::string& output
     stop_download = false;
     m_downloadTh = new std::thread(
         [username, password](CUCurl* holder, const std::string url, const std::string output_file) {
-            CURL* curl = NULL;
-            FILE* fp;
-            CURLcode res;
-
-            curl = curl_easy_init();
-            if (curl) {
-                fp = fopen(output_file.c_str(), "wb");
-                curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-                curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_data);
-                curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);  // 10 sec
-                curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-                curl_easy_setopt(curl, CURLOPT_XFERINFODATA, holder);
-                curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CUCurl::progressCallback);
-                curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-                if (!username.empty() || !password.empty()) {
-                    curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
-                    curl_easy_setopt(curl, CURLOPT_USERNAME, username.c_str());
-                    curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
-                }
-                res = curl_easy_perform(curl);
-                long http_code = 0;
-                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-                curl_easy_cleanup(curl);
-                fclose(fp);
-
-                if (res == CURLE_OK && http_code == 200) {
-                    if (holder->m_done) {
-                        holder->m_done(true);
-                    }
-                    return;
-                }
-                fs::remove(output_file);
-            }
+            auto ret = holder->download(url, output_file, username, password);
             if (holder->m_done) {
-                holder->m_done(false);
+                holder->m_done(ret == RP_UP_OK);
             }
         },
         this, url, output_file);
     return RP_UP_OK;
 }
 
+auto CUCurl::downloadRange(const std::string& url, uint64_t offset, uint64_t size, func_data_t func, const std::string& username,
+                           const std::string& password) -> int {
+    if (size == 0) {
+        return RP_UP_OK;
+    }
+    range_ctx_t ctx;
+    ctx.func = func;
+    ctx.offset = offset;
+    ctx.end = offset + size;
+    for (int attempt = 0; attempt <= DOWNLOAD_RETRIES; attempt++) {
+        if (attempt > 0 && !waitRetry(attempt)) {
+            break;
+        }
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            break;
+        }
+        ctx.curl = curl;
+        ctx.checked = false;
+        ctx.rejected = false;
+        auto range = std::to_string(ctx.offset) + "-" + std::to_string(ctx.end - 1);
+        setupRequest(curl, url, username, password);
+        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_range);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
+        auto res = curl_easy_perform(curl);
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_cleanup(curl);
+
+        if (ctx.offset == ctx.end) {
+            return RP_UP_OK;
+        }
+        // A server without range support sends the whole file
+        if (stop_download || ctx.rejected || http_code == 200 || (http_code >= 400 && http_code < 500)) {
+            break;
+        }
+        WARNING("Range request interrupted at %llu (%s), attempt %d", (unsigned long long)ctx.offset, curl_easy_strerror(res), attempt + 1);
+    }
+    return RP_UP_EDF;
+}
+
+auto CUCurl::getRemoteSize(const std::string& url, uint64_t* size, const std::string& username, const std::string& password) -> int {
+    *size = 0;
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return RP_UP_ERR;
+    }
+    setupRequest(curl, url, username, password);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    auto res = curl_easy_perform(curl);
+    long http_code = 0;
+    curl_off_t length = -1;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    curl_easy_cleanup(curl);
+    if (res != CURLE_OK || http_code != 200 || length < 0) {
+        return RP_UP_ERR;
+    }
+    *size = length;
+    return RP_UP_OK;
+}
+
 auto CUCurl::setProgressCallback(func_progress_t func) -> void {
     m_delegate = func;
 }
@@ -177,6 +364,10 @@ auto CUCurl::setDoneCallback(func_done_t func) -> void {
     m_done = func;
 }
 
+auto CUCurl::setDataCallback(func_data_t func) -> void {
+    m_data = func;
+}
+
 auto CUCurl::getFilenameFromUrl(const std::string& url) -> std::string {
     std::regex regex(R"(([^/?#]+)(?:[?#].*)?$)");
     std::smatch match;
@@ -25,21 +25,31 @@
 class CUCurl {
     typedef std::function<void(uint64_t now, uint64_t total, bool stop)> func_progress_t;
     typedef std::function<void(bool success)> func_done_t;
+    // Receives the bytes of the file in order. offset goes back to 0 when the download starts over.
+    // Returning false stops the download.
+    typedef std::function<bool(const uint8_t* data, size_t size, uint64_t offset)> func_data_t;
 
    public:
+    static constexpr int DOWNLOAD_RETRIES = 5;
+
     CUCurl();
     ~CUCurl();
 
     CUCurl(CUCurl&) = delete;
     CUCurl(CUCurl&&) = delete;
 
+    // The file is written to output_file.part and renamed when complete. An existing part is resumed with a range request.
     auto downloadFile(const std::string& url, const std::string& output_file, const std::string& username = "", const std::string& password = "") -> int;
     auto downloadFileAsync(const std::string& url, const std::string& output_file, const std::string& username = "", const std::string& password = "") -> int;
+    auto downloadRange(const std::string& url, uint64_t offset, uint64_t size, func_data_t func, const std::string& username = "",
+                       const std::string& password = "") -> int;
+    auto getRemoteSize(const std::string& url, uint64_t* size, const std::string& username = "", const std::string& password = "") -> int;
     auto stopDownloadFile() -> bool;
     auto wait() -> void;
 
     auto setProgressCallback(func_progress_t func) -> void;
     auto setDoneCallback(func_done_t func) -> void;
+    auto setDataCallback(func_data_t func) -> void;
 
     auto getListNB(bool* succes) -> std::vector<std::string>;
     auto getListRelease(bool* succes) -> std::vector<std::string>;
@@ -48,10 +58,17 @@ class CUCurl {
     static auto getFilenameFromUrl(const std::string& url) -> std::string;
 
    private:
+    auto download(const std::string& url, const std::string& output_file, const std::string& username, const std::string& password) -> int;
+    auto waitRetry(int attempt) -> bool;
+
     func_progress_t m_delegate;
     func_done_t m_done;
+    func_data_t m_data;
     std::thread* m_downloadTh;
     std::atomic<bool> stop_download;
+    std::atomic<uint64_t> m_resume_offset;
+    static auto curl_write_part(void* ptr, size_t size, size_t nmemb, void* userdata) -> size_t;
+    static auto curl_write_range(void* ptr, size_t size, size_t nmemb, void* userdata) -> size_t;
     static auto progressCallback(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) -> int;
 };
 
@@ -282,7 +282,7 @@ auto readFileFromZipBytes(const std::string& zip_path, const std::string& file_n
 }
 
 auto unzip(const std::string& zip_path, const std::string& output_dir,
-           std::function<void(uint64_t current, uint64_t total, const char* fileName)> progress) -> int {
+           std::function<void(uint64_t current, uint64_t total, const char* fileName)> progress, std::vector<zip_entry_t>* entries) -> int {
 
     auto create_directory = [](const std::string& path) {
         struct stat st;
@@ -313,6 +313,9 @@ auto unzip(const std::string& zip_path, const std::string& output_dir,
     }
 
     zip_int64_t num_entries = zip_get_num_entries(archive, 0);
+    if (entries) {
+        entries->clear();
+    }
 
     for (zip_int64_t i = 0; i < num_entries; ++i) {
         const char* file_name = zip_get_name(archive, i, 0);
@@ -321,6 +324,11 @@ auto unzip(const std::string& zip_path, const std::string& output_dir,
             continue;
         }
 
+        zip_stat_t zst;
+        if (entries && zip_stat_index(archive, i, 0, &zst) == 0) {
+            entries->push_back({.name = file_name, .crc32 = zst.crc, .size = zst.size, .compressed_size = zst.comp_size, .offset = 0, .md5 = ""});
+        }
+
         std::string full_path = output_dir + "/" + file_name;
 
         size_t last_slash = full_path.find_last_of('/');
@@ -15,6 +15,7 @@
 #include <functional>
 #include <vector>
 #include "rp_updater_common.h"
+#include "rp_updater_zip.h"
 
 auto createDirTree(const std::string& full_path) -> bool;
 auto copyFile(const std::string& _src, const std::string& _dst) -> void;
@@ -27,7 +28,7 @@ auto listdirForDelete(const std::string& root, const std::string& d_name, int le
 auto readFileFromZip(const std::string& zip_path, const std::string& file_name) -> std::string;
 auto readFileFromZipBytes(const std::string& zip_path, const std::string& file_name) -> std::vector<uint8_t>;
 auto unzip(const std::string& zip_path, const std::string& output_dir,
-           std::function<void(uint64_t current, uint64_t total, const char* fileName)> progress) -> int;
+           std::function<void(uint64_t current, uint64_t total, const char* fileName)> progress, std::vector<zip_entry_t>* entries = nullptr) -> int;
 
 auto deleteEmptyFolders(const std::filesystem::path& dirPath) -> bool;
 
@@ -0,0 +1,653 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library updater api
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "rp_updater_zip.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "rp_log.h"
+#include "rp_updater_fs.h"
+
+#define ZIP_LOCAL_SIG 0x04034b50
+#define ZIP_DESCRIPTOR_SIG 0x08074b50
+#define ZIP_CENTRAL_SIG 0x02014b50
+#define ZIP_EOCD_SIG 0x06054b50
+#define ZIP_EOCD64_SIG 0x06064b50
+#define ZIP_EOCD64_LOCATOR_SIG 0x07064b50
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_CENTRAL_HEADER_SIZE 46
+#define ZIP_EOCD_SIZE 22
+#define ZIP_EOCD64_LOCATOR_SIZE 20
+#define ZIP_ZIP64_EXTRA 0x0001
+
+#define MANIFEST_HEADER "# rp_updater manifest 1"
+
+static auto rd16(const uint8_t* p) -> uint16_t {
+    return p[0] | (p[1] << 8);
+}
+
+static auto rd32(const uint8_t* p) -> uint32_t {
+    return (uint32_t)rd16(p) | ((uint32_t)rd16(p + 2) << 16);
+}
+
+static auto rd64(const uint8_t* p) -> uint64_t {
+    return (uint64_t)rd32(p) | ((uint64_t)rd32(p + 4) << 32);
+}
+
+static auto toHex(const unsigned char* data, unsigned int size) -> std::string {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned int i = 0; i < size; i++) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0xF];
+    }
+    return hex;
+}
+
+static auto finalMD5(EVP_MD_CTX* ctx) -> std::string {
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int size = 0;
+    if (EVP_DigestFinal_ex(ctx, md, &size) != 1) {
+        return "";
+    }
+    return toHex(md, size);
+}
+
+// Reads the zip64 sizes of the extra field. Only the fields set to 0xFFFFFFFF in the header are present.
+static auto readZip64Extra(const uint8_t* extra, size_t size, uint64_t* usize, uint64_t* csize, uint64_t* offset) -> bool {
+    size_t pos = 0;
+    while (pos + 4 <= size) {
+        uint16_t id = rd16(extra + pos);
+        uint16_t len = rd16(extra + pos + 2);
+        pos += 4;
+        if (pos + len > size) {
+            return false;
+        }
+        if (id == ZIP_ZIP64_EXTRA) {
+            const uint8_t* p = extra + pos;
+            const uint8_t* end = p + len;
+            for (auto value : {usize, csize, offset}) {
+                if (value && *value == 0xFFFFFFFF) {
+                    if (p + 8 > end) {
+                        return false;
+                    }
+                    *value = rd64(p);
+                    p += 8;
+                }
+            }
+            return true;
+        }
+        pos += len;
+    }
+    return false;
+}
+
+// Entries may not leave the output directory
+auto zipIsSafeName(const std::string& name) -> bool {
+    if (name.empty() || name[0] == '/' || name.find('\\') != std::string::npos) {
+        return false;
+    }
+    std::stringstream ss(name);
+    std::string part;
+    while (std::getline(ss, part, '/')) {
+        if (part == "..") {
+            return false;
+        }
+    }
+    return true;
+}
+
+CUZipStream::CUZipStream() {
+    m_thread = nullptr;
+    m_queued = 0;
+    m_finish = false;
+    m_restart = false;
+    m_error = RP_UP_OK;
+    m_state = state_t::HEADER;
+    m_flags = 0;
+    m_method = 0;
+    m_zip64 = false;
+    m_left = 0;
+    m_read = 0;
+    m_written = 0;
+    m_crc = 0;
+    m_file = nullptr;
+    memset(&m_zs, 0, sizeof(m_zs));
+    m_zs_init = false;
+    m_entry_md5 = EVP_MD_CTX_new();
+    m_stream_md5 = EVP_MD_CTX_new();
+    m_size = 0;
+}
+
+CUZipStream::~CUZipStream() {
+    abort();
+    if (m_zs_init) {
+        inflateEnd(&m_zs);
+    }
+    EVP_MD_CTX_free(m_entry_md5);
+    EVP_MD_CTX_free(m_stream_md5);
+}
+
+auto CUZipStream::start(const std::string& output_dir) -> int {
+    abort();
+    m_output_dir = output_dir;
+    if (!m_output_dir.empty()) {
+        createDirTree(m_output_dir);
+        if (!std::filesystem::is_directory(m_output_dir)) {
+            return RP_UP_ECD;
+        }
+    }
+    m_queue.clear();
+    m_queued = 0;
+    m_finish = false;
+    m_restart = false;
+    m_error = RP_UP_OK;
+    resetParser();
+    m_thread = new std::thread(&CUZipStream::worker, this);
+    return RP_UP_OK;
+}
+
+auto CUZipStream::write(const void* data, size_t size) -> bool {
+    if (size == 0) {
+        return true;
+    }
+    std::unique_lock lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_queued < MAX_QUEUED || m_error != RP_UP_OK || !m_thread; });
+    if (m_error != RP_UP_OK || !m_thread) {
+        return false;
+    }
+    auto bytes = static_cast<const uint8_t*>(data);
+    m_queue.emplace_back(bytes, bytes + size);
+    m_queued += size;
+    lock.unlock();
+    m_cv.notify_all();
+    return true;
+}
+
+auto CUZipStream::restart() -> void {
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.clear();
+        m_queued = 0;
+        m_restart = true;
+        m_error = RP_UP_OK;
+    }
+    m_cv.notify_all();
+}
+
+auto CUZipStream::finish() -> int {
+    if (!m_thread) {
+        return RP_UP_EUF;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_finish = true;
+    }
+    m_cv.notify_all();
+    if (m_thread->joinable()) {
+        m_thread->join();
+    }
+    delete m_thread;
+    m_thread = nullptr;
+
+    if (m_error != RP_UP_OK) {
+        return m_error;
+    }
+    // The archive is complete only when the central directory was reached
+    if (m_state != state_t::TAIL) {
+        fail(RP_UP_EUF);
+        return RP_UP_EUF;
+    }
+    m_md5 = finalMD5(m_stream_md5);
+    return RP_UP_OK;
+}
+
+auto CUZipStream::abort() -> void {
+    if (!m_thread) {
+        return;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.clear();
+        m_queued = 0;
+        m_finish = true;
+        if (m_error == RP_UP_OK) {
+            m_error = RP_UP_EUF;
+        }
+    }
+    m_cv.notify_all();
+    if (m_thread->joinable()) {
+        m_thread->join();
+    }
+    delete m_thread;
+    m_thread = nullptr;
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+auto CUZipStream::getSize() -> uint64_t {
+    return m_size;
+}
+
+auto CUZipStream::getMD5() -> std::string {
+    return m_md5;
+}
+
+auto CUZipStream::getEntries() -> const std::vector<zip_entry_t>& {
+    return m_entries;
+}
+
+auto CUZipStream::worker() -> void {
+    while (true) {
+        std::vector<uint8_t> chunk;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_queue.empty() || m_finish || m_restart; });
+            if (m_restart) {
+                m_restart = false;
+                m_error = RP_UP_OK;
+                lock.unlock();
+                resetParser();
+                continue;
+            }
+            if (m_queue.empty()) {
+                break;
+            }
+            chunk = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queued -= chunk.size();
+        }
+        m_cv.notify_all();
+        consume(chunk.data(), chunk.size());
+    }
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+auto CUZipStream::resetParser() -> void {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_state = state_t::HEADER;
+    m_head.clear();
+    m_entries.clear();
+    m_size = 0;
+    m_md5 = "";
+    EVP_DigestInit_ex(m_stream_md5, EVP_md5(), NULL);
+}
+
+auto CUZipStream::fail(int error) -> void {
+    m_state = state_t::ERROR;
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_error == RP_UP_OK) {
+            m_error = error;
+        }
+    }
+    m_cv.notify_all();
+}
+
+auto CUZipStream::consume(const uint8_t* data, size_t size) -> void {
+    if (m_state == state_t::ERROR) {
+        return;
+    }
+    uint64_t base = m_size;
+    const uint8_t* begin = data;
+    EVP_DigestUpdate(m_stream_md5, data, size);
+    m_size += size;
+
+    while (size > 0) {
+        switch (m_state) {
+            case state_t::HEADER: {
+                if (m_head.empty()) {
+                    m_entry.offset = base + (data - begin);
+                }
+                parseHeader(&data, &size);
+                break;
+            }
+
+            case state_t::STORED: {
+                size_t n = std::min<uint64_t>(size, m_left);
+                if (!writeEntry(data, n)) {
+                    return;
+                }
+                data += n;
+                size -= n;
+                m_left -= n;
+                m_read += n;
+                if (m_left == 0) {
+                    closeEntry();
+                }
+                break;
+            }
+
+            case state_t::DEFLATE: {
+                uint8_t out[32768];
+                int ret = Z_OK;
+                m_zs.next_in = const_cast<Bytef*>(data);
+                m_zs.avail_in = size;
+                do {
+                    m_zs.next_out = out;
+                    m_zs.avail_out = sizeof(out);
+                    ret = inflate(&m_zs, Z_NO_FLUSH);
+                    if (ret != Z_OK && ret != Z_STREAM_END) {
+                        fail(RP_UP_EUF);
+                        return;
+                    }
+                    size_t n = sizeof(out) - m_zs.avail_out;
+                    if (n && !writeEntry(out, n)) {
+                        return;
+                    }
+                } while (ret == Z_OK && (m_zs.avail_in > 0 || m_zs.avail_out == 0));
+                size_t used = size - m_zs.avail_in;
+                data += used;
+                size -= used;
+                m_read += used;
+                if (ret == Z_STREAM_END) {
+                    closeEntry();
+                }
+                break;
+            }
+
+            case state_t::DESCRIPTOR: {
+                // Optional signature, CRC32 and both sizes, 64 bit for zip64 entries
+                size_t need = 4;
+                if (m_head.size() >= 4) {
+                    need = (rd32(m_head.data()) == ZIP_DESCRIPTOR_SIG ? 8 : 4) + (m_zip64 ? 16 : 8);
+                }
+                size_t n = std::min(size, need - m_head.size());
+                m_head.insert(m_head.end(), data, data + n);
+                data += n;
+                size -= n;
+                if (m_head.size() == need && need > 4) {
+                    const uint8_t* p = m_head.data() + (rd32(m_head.data()) == ZIP_DESCRIPTOR_SIG ? 4 : 0);
+                    m_entry.crc32 = rd32(p);
+                    m_entry.compressed_size = m_zip64 ? rd64(p + 4) : rd32(p + 4);
+                    m_entry.size = m_zip64 ? rd64(p + 12) : rd32(p + 8);
+                    m_flags &= ~0x8;
+                    closeEntry();
+                }
+                break;
+            }
+
+            case state_t::TAIL:
+                // Central directory, only hashed
+                size = 0;
+                break;
+
+            case state_t::ERROR:
+                return;
+        }
+    }
+}
+
+auto CUZipStream::parseHeader(const uint8_t** data, size_t* size) -> void {
+    size_t need = 4;
+    if (m_head.size() >= ZIP_LOCAL_HEADER_SIZE) {
+        need = ZIP_LOCAL_HEADER_SIZE + rd16(&m_head[26]) + rd16(&m_head[28]);
+    } else if (m_head.size() >= 4) {
+        need = ZIP_LOCAL_HEADER_SIZE;
+    }
+    size_t n = std::min(*size, need - m_head.size());
+    m_head.insert(m_head.end(), *data, *data + n);
+    *data += n;
+    *size -= n;
+    if (m_head.size() < need) {
+        return;
+    }
+
+    if (need == 4) {
+        uint32_t sig = rd32(m_head.data());
+        if (sig == ZIP_CENTRAL_SIG || sig == ZIP_EOCD_SIG || sig == ZIP_EOCD64_SIG) {
+            m_state = state_t::TAIL;
+        } else if (sig != ZIP_LOCAL_SIG) {
+            ERROR_LOG("Unexpected zip signature 0x%08x", sig);
+            fail(RP_UP_EUF);
+        }
+        return;
+    }
+    if (need == ZIP_LOCAL_HEADER_SIZE && rd16(&m_head[26]) + rd16(&m_head[28]) > 0) {
+        return;
+    }
+    openEntry();
+}
+
+auto CUZipStream::openEntry() -> void {
+    const uint8_t* h = m_head.data();
+    uint16_t name_len = rd16(h + 26);
+    uint16_t extra_len = rd16(h + 28);
+    m_flags = rd16(h + 6);
+    m_method = rd16(h + 8);
+    m_entry.name = std::string((const char*)h + ZIP_LOCAL_HEADER_SIZE, name_len);
+    m_entry.crc32 = rd32(h + 14);
+    m_entry.compressed_size = rd32(h + 18);
+    m_entry.size = rd32(h + 22);
+    m_entry.md5 = "";
+    m_zip64 = readZip64Extra(h + ZIP_LOCAL_HEADER_SIZE + name_len, extra_len, &m_entry.size, &m_entry.compressed_size, nullptr);
+    m_head.clear();
+
+    if (!zipIsSafeName(m_entry.name)) {
+        ERROR_LOG("Wrong file name in zip %s", m_entry.name.c_str());
+        fail(RP_UP_EUF);
+        return;
+    }
+    // Encrypted entries are not supported, stored entries need their size in the header
+    if ((m_flags & 0x1) || (m_method != 0 && m_method != 8) || (m_method == 0 && (m_flags & 0x8))) {
+        ERROR_LOG("Unsupported zip entry %s method %d flags 0x%x", m_entry.name.c_str(), m_method, m_flags);
+        fail(RP_UP_EUF);
+        return;
+    }
+
+    if (!m_output_dir.empty()) {
+        auto full_path = m_output_dir + "/" + m_entry.name;
+        if (m_entry.name.back() == '/') {
+            createDirTree(full_path.substr(0, full_path.size() - 1));
+        } else {
+            createDirTree(full_path.substr(0, full_path.find_last_of('/')));
+            m_file = fopen(full_path.c_str(), "wb");
+            if (!m_file) {
+                ERROR_LOG("Can't create %s", full_path.c_str());
+                fail(RP_UP_EOF);
+                return;
+            }
+        }
+    }
+
+    m_crc = crc32(0L, Z_NULL, 0);
+    EVP_DigestInit_ex(m_entry_md5, EVP_md5(), NULL);
+    m_read = 0;
+    m_written = 0;
+    if (m_method == 8) {
+        if (m_zs_init) {
+            inflateReset(&m_zs);
+        } else {
+            if (inflateInit2(&m_zs, -MAX_WBITS) != Z_OK) {
+                fail(RP_UP_EUF);
+                return;
+            }
+            m_zs_init = true;
+        }
+        m_state = state_t::DEFLATE;
+    } else {
+        m_left = m_entry.compressed_size;
+        m_state = state_t::STORED;
+        if (m_left == 0) {
+            closeEntry();
+        }
+    }
+}
+
+auto CUZipStream::writeEntry(const uint8_t* data, size_t size) -> bool {
+    m_crc = crc32(m_crc, data, size);
+    EVP_DigestUpdate(m_entry_md5, data, size);
+    m_written += size;
+    if (m_file && fwrite(data, 1, size, m_file) != size) {
+        ERROR_LOG("Error write %s", m_entry.name.c_str());
+        fail(RP_UP_EUF);
+        return false;
+    }
+    return true;
+}
+
+auto CUZipStream::closeEntry() -> void {
+    if (m_flags & 0x8) {
+        // The sizes and the CRC32 follow the data
+        m_head.clear();
+        m_state = state_t::DESCRIPTOR;
+        return;
+    }
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    if (m_crc != m_entry.crc32 || m_written != m_entry.size || m_read != m_entry.compressed_size) {
+        ERROR_LOG("Wrong CRC32 or size of %s", m_entry.name.c_str());
+        fail(RP_UP_ECM);
+        return;
+    }
+    m_entry.md5 = finalMD5(m_entry_md5);
+    m_entries.push_back(m_entry);
+    m_head.clear();
+    m_state = state_t::HEADER;
+}
+
+auto zipFindCentralDirectory(const std::vector<uint8_t>& tail, uint64_t file_size, uint64_t* cd_offset, uint64_t* cd_size) -> int {
+    if (tail.size() < ZIP_EOCD_SIZE || tail.size() > file_size) {
+        return RP_UP_EUF;
+    }
+    uint64_t tail_start = file_size - tail.size();
+    // The end record is followed by a comment of up to 64k
+    for (size_t pos = tail.size() - ZIP_EOCD_SIZE + 1; pos-- > 0;) {
+        const uint8_t* p = tail.data() + pos;
+        if (rd32(p) != ZIP_EOCD_SIG) {
+            continue;
+        }
+        *cd_size = rd32(p + 12);
+        *cd_offset = rd32(p + 16);
+        if (*cd_size != 0xFFFFFFFF && *cd_offset != 0xFFFFFFFF) {
+            return RP_UP_OK;
+        }
+        if (pos < ZIP_EOCD64_LOCATOR_SIZE || rd32(p - ZIP_EOCD64_LOCATOR_SIZE) != ZIP_EOCD64_LOCATOR_SIG) {
+            return RP_UP_EUF;
+        }
+        uint64_t eocd64 = rd64(p - ZIP_EOCD64_LOCATOR_SIZE + 8);
+        if (eocd64 < tail_start || eocd64 - tail_start + 56 > tail.size()) {
+            return RP_UP_EUF;
+        }
+        const uint8_t* r = tail.data() + (eocd64 - tail_start);
+        if (rd32(r) != ZIP_EOCD64_SIG) {
+            return RP_UP_EUF;
+        }
+        *cd_size = rd64(r + 40);
+        *cd_offset = rd64(r + 48);
+        return RP_UP_OK;
+    }
+    return RP_UP_EUF;
+}
+
+auto zipParseCentralDirectory(const std::vector<uint8_t>& cd, std::vector<zip_entry_t>* entries) -> int {
+    entries->clear();
+    size_t pos = 0;
+    while (pos + 4 <= cd.size() && rd32(cd.data() + pos) == ZIP_CENTRAL_SIG) {
+        if (pos + ZIP_CENTRAL_HEADER_SIZE > cd.size()) {
+            return RP_UP_EUF;
+        }
+        const uint8_t* h = cd.data() + pos;
+        uint16_t name_len = rd16(h + 28);
+        uint16_t extra_len = rd16(h + 30);
+        uint16_t comment_len = rd16(h + 32);
+        if (pos + ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len > cd.size()) {
+            return RP_UP_EUF;
+        }
+        zip_entry_t entry;
+        entry.name = std::string((const char*)h + ZIP_CENTRAL_HEADER_SIZE, name_len);
+        entry.crc32 = rd32(h + 16);
+        entry.compressed_size = rd32(h + 20);
+        entry.size = rd32(h + 24);
+        entry.offset = rd32(h + 42);
+        readZip64Extra(h + ZIP_CENTRAL_HEADER_SIZE + name_len, extra_len, &entry.size, &entry.compressed_size, &entry.offset);
+        entries->push_back(entry);
+        pos += ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len;
+    }
+    return entries->empty() ? RP_UP_EUF : RP_UP_OK;
+}
+
+auto writeManifest(const std::string& path, const zip_manifest_t& manifest) -> int {
+    auto tmp = path + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "w");
+    if (!file) {
+        return RP_UP_EOF;
+    }
+    fprintf(file, "%s\n", MANIFEST_HEADER);
+    fprintf(file, "zip %llu %s %s\n", (unsigned long long)manifest.zip_size, manifest.zip_md5.empty() ? "-" : manifest.zip_md5.c_str(),
+            manifest.zip_name.c_str());
+    for (auto& entry : manifest.entries) {
+        fprintf(file, "%08x %llu %s %s\n", entry.crc32, (unsigned long long)entry.size, entry.md5.empty() ? "-" : entry.md5.c_str(),
+                entry.name.c_str());
+    }
+    bool ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok &= fclose(file) == 0;
+    // Written last, the manifest marks a complete tree
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return RP_UP_EOF;
+    }
+    return RP_UP_OK;
+}
+
+auto readManifest(const std::string& path, zip_manifest_t* manifest) -> int {
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line) || line != MANIFEST_HEADER) {
+        return RP_UP_EOF;
+    }
+    manifest->entries.clear();
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::string first;
+        std::string md5;
+        uint64_t size = 0;
+        if (!(ss >> first >> size >> md5)) {
+            return RP_UP_EOF;
+        }
+        std::string name;
+        ss.get();
+        std::getline(ss, name);
+        if (md5 == "-") {
+            md5 = "";
+        }
+        if (first == "zip") {
+            manifest->zip_name = name;
+            manifest->zip_size = size;
+            manifest->zip_md5 = md5;
+        } else {
+            zip_entry_t entry;
+            entry.name = name;
+            entry.crc32 = std::stoul(first, nullptr, 16);
+            entry.size = size;
+            entry.compressed_size = 0;
+            entry.offset = 0;
+            entry.md5 = md5;
+            manifest->entries.push_back(entry);
+        }
+    }
+    return RP_UP_OK;
+}
@@ -0,0 +1,124 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library updater api
+ *
+ * Streaming zip reader. The archive is fed in order, as it arrives from the network, and every
+ * entry is inflated and checked against its CRC32 on a worker thread while the download goes on.
+ * The central directory at the end of the archive is only used by the delta download, which
+ * fetches it with a range request to find the entries that changed.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __UPDATER_ZIP_API_H
+#define __UPDATER_ZIP_API_H
+
+#include <openssl/evp.h>
+#include <zlib.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rp_updater_common.h"
+
+typedef struct {
+    std::string name;
+    uint32_t crc32;
+    uint64_t size;
+    uint64_t compressed_size;
+    uint64_t offset;  // Local header offset in the archive
+    std::string md5;  // Empty when the entry was not read
+} zip_entry_t;
+
+typedef struct {
+    std::string zip_name;
+    uint64_t zip_size;
+    std::string zip_md5;  // "delta" when the tree was assembled from the installed files
+    std::vector<zip_entry_t> entries;
+} zip_manifest_t;
+
+class CUZipStream {
+   public:
+    // Chunks waiting for the worker, the download blocks when the queue is full
+    static constexpr size_t MAX_QUEUED = 4 * 1024 * 1024;
+
+    CUZipStream();
+    ~CUZipStream();
+
+    CUZipStream(CUZipStream&) = delete;
+    CUZipStream(CUZipStream&&) = delete;
+
+    // Starts the worker. An empty output_dir only verifies the entries.
+    auto start(const std::string& output_dir) -> int;
+    // Queues the next bytes of the archive. Returns false after an error.
+    auto write(const void* data, size_t size) -> bool;
+    // Drops everything and starts again from the first byte, when the server ignored a resume
+    auto restart() -> void;
+    // Waits for the queued bytes. RP_UP_OK when every entry was complete and matched its CRC32.
+    auto finish() -> int;
+    auto abort() -> void;
+
+    // Valid after finish
+    auto getSize() -> uint64_t;
+    auto getMD5() -> std::string;
+    auto getEntries() -> const std::vector<zip_entry_t>&;
+
+   private:
+    enum class state_t { HEADER, STORED, DEFLATE, DESCRIPTOR, TAIL, ERROR };
+
+    auto worker() -> void;
+    auto resetParser() -> void;
+    auto consume(const uint8_t* data, size_t size) -> void;
+    auto parseHeader(const uint8_t** data, size_t* size) -> void;
+    auto openEntry() -> void;
+    auto writeEntry(const uint8_t* data, size_t size) -> bool;
+    auto closeEntry() -> void;
+    auto fail(int error) -> void;
+
+    std::string m_output_dir;
+    std::thread* m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::vector<uint8_t>> m_queue;
+    size_t m_queued;
+    bool m_finish;
+    bool m_restart;
+    int m_error;
+
+    // Parser state, only used by the worker
+    state_t m_state;
+    std::vector<uint8_t> m_head;
+    zip_entry_t m_entry;
+    uint16_t m_flags;
+    uint16_t m_method;
+    bool m_zip64;
+    uint64_t m_left;
+    uint64_t m_read;
+    uint64_t m_written;
+    uint32_t m_crc;
+    FILE* m_file;
+    z_stream m_zs;
+    bool m_zs_init;
+    EVP_MD_CTX* m_entry_md5;
+    EVP_MD_CTX* m_stream_md5;
+    uint64_t m_size;
+    std::string m_md5;
+    std::vector<zip_entry_t> m_entries;
+};
+
+// False for names that would leave the output directory
+auto zipIsSafeName(const std::string& name) -> bool;
+// Finds the central directory in the last bytes of an archive of file_size bytes
+auto zipFindCentralDirectory(const std::vector<uint8_t>& tail, uint64_t file_size, uint64_t* cd_offset, uint64_t* cd_size) -> int;
+auto zipParseCentralDirectory(const std::vector<uint8_t>& cd, std::vector<zip_entry_t>* entries) -> int;
+
+// The manifest is written at the root of an extracted tree and is installed with it
+auto writeManifest(const std::string& path, const zip_manifest_t& manifest) -> int;
+auto readManifest(const std::string& path, zip_manifest_t* manifest) -> int;
+
+#endif  // __UPDATER_ZIP_API_H
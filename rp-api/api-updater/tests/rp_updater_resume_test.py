@@ -0,0 +1,132 @@
+#!/usr/bin/python3
+
+# Resumed and pipelined download against a local HTTP server.
+# The server drops the first connection part way, the download resumes with a range request
+# and the archive is extracted while it downloads.
+
+from rp_updater import *
+import hashlib
+import http.server
+import os
+import re
+import tempfile
+import threading
+import zipfile
+
+FILE_NAME = 'ecosystem-2.06-999-resumetest.zip'
+DOWNLOAD_PATH = '/home/redpitaya/ecosystems/'
+EXTRACT_PATH = '/tmp/'
+DROP_AFTER = 500000
+
+requests = []
+drop = [DROP_AFTER]
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, *args):
+        pass
+
+    def send_file(self, body):
+        path = os.path.join(root, self.path.lstrip('/'))
+        if not os.path.exists(path):
+            self.send_response(404)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+        data = open(path, 'rb').read()
+        rng = self.headers.get('Range')
+        requests.append((self.command, rng))
+        start, end = 0, len(data) - 1
+        if rng:
+            m = re.match(r'bytes=(\d+)-(\d*)', rng)
+            start = int(m.group(1))
+            end = int(m.group(2)) if m.group(2) else end
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, len(data)))
+        else:
+            self.send_response(200)
+        self.send_header('Content-Length', str(end - start + 1))
+        self.end_headers()
+        if not body:
+            return
+        chunk = data[start:end + 1]
+        if drop[0] and len(chunk) > drop[0]:
+            self.wfile.write(chunk[:drop[0]])
+            self.wfile.flush()
+            drop[0] = 0
+            self.connection.shutdown(2)
+            self.close_connection = True
+            return
+        self.wfile.write(chunk)
+
+    def do_GET(self):
+        self.send_file(True)
+
+    def do_HEAD(self):
+        self.send_file(False)
+
+class Callback(CUpdaterCallback):
+    def downloadProgress(self,fileName,now,total,stop):
+        print("Download ", fileName, " progress = ", round(now / total * 100), end='\r')
+
+    def downloadDone(self,fileName,succes):
+        print("")
+        print("Download done ",fileName, " state ",succes)
+
+root = tempfile.mkdtemp()
+files = {'boot.bin': os.urandom(300000), 'u-boot.scr': b'script' * 100, 'uImage': os.urandom(1000000), 'www/index.html': b'<html></html>\n' * 1000}
+md5 = ''.join('%s  %s\n' % (hashlib.md5(files[n]).hexdigest(), n) for n in ['boot.bin', 'u-boot.scr', 'uImage'])
+with zipfile.ZipFile(os.path.join(root, FILE_NAME), 'w', zipfile.ZIP_DEFLATED) as z:
+    for name, data in files.items():
+        z.writestr(name, data)
+    z.writestr('md5.txt', md5)
+
+server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Handler)
+threading.Thread(target=server.serve_forever, daemon=True).start()
+url = 'http://127.0.0.1:%d/%s' % (server.server_address[1], FILE_NAME)
+
+print("rp_UpdaterInit()")
+res = rp_UpdaterInit()
+print(res)
+
+callback = Callback()
+print("rp_UpdaterSetCallback(callback.__disown__())")
+res = rp_UpdaterSetCallback(callback.__disown__())
+print(res)
+
+print("rp_UpdaterDownloadFile('" + url + "')")
+res = rp_UpdaterDownloadFile(url)
+print(res)
+assert res == RP_UP_OK
+
+print("Requests ", requests)
+assert ('GET', 'bytes=%d-' % DROP_AFTER) in requests
+
+downloaded = open(DOWNLOAD_PATH + FILE_NAME, 'rb').read()
+assert downloaded == open(os.path.join(root, FILE_NAME), 'rb').read()
+print("Downloaded file identical")
+
+for name, data in files.items():
+    assert open(EXTRACT_PATH + FILE_NAME + '/' + name, 'rb').read() == data
+print("Extracted during download")
+
+manifest = open(EXTRACT_PATH + FILE_NAME + '/' + ECOSYSTEM_MANIFEST).read().split('\n')
+print(manifest[1])
+assert manifest[1].split()[2] == hashlib.md5(downloaded).hexdigest()
+
+print("rp_UpdaterIsValidDownloadedFile('" + FILE_NAME + "')")
+res = rp_UpdaterIsValidDownloadedFile(FILE_NAME)
+print(res)
+assert res[1]
+
+print("rp_UpdaterRemoveCallback()")
+res = rp_UpdaterRemoveCallback()
+print(res)
+
+os.remove(DOWNLOAD_PATH + FILE_NAME)
+server.shutdown()
+
+print("rp_UpdaterRelease()")
+res = rp_UpdaterRelease()
+print(res)
@@ -17,6 +17,7 @@
 #include "common/rp_log.h"
 #include "rp_acq.h"
 #include "rp_acq_axi.h"
+#include "rp_acq_shm.h"
 #include "rp_asg_axi.h"
 #include "rp_enums.h"
 #include "rp_gen.h"
@@ -94,6 +95,8 @@
 #define RP_EIS 30
 /** Interruptions are disabled in the settings. */
 #define RP_EID 31
+/** Data overwritten before it was read */
+#define RP_EDOW 32
 
 #define SPECTR_OUT_SIG_LEN (2 * 1024)
 
@@ -227,4 +227,137 @@ int rp_AcqAxiGetOffset(rp_channel_t channel, float* value);
 
 ///@}
 
+/** @name Segmented acquisition
+ * The AXI buffer of each channel is sliced into records of equal length. After each trigger the
+ * next record is armed with register writes only, so the dead time does not include any readout.
+ * Every record holds (samples - AXI trigger delay) samples before the trigger. The AXI trigger
+ * delay (rp_AcqAxiSetTriggerDelay) must be the same on all channels of the acquisition.
+ */
+///@{
+
+/**
+ * Sets the number of records and the record length, common to all channels.
+ * @param segments Number of records
+ * @param samples Samples of one record, a multiple of 8
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegSetup(uint32_t segments, uint32_t samples);
+
+/**
+ * Returns the number of records and the record length.
+ * @param segments Number of records
+ * @param samples Samples of one record
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetSetup(uint32_t* segments, uint32_t* samples);
+
+/**
+ * Sets the start of the channel records in the reserved memory. The channel uses segments * samples * 2 bytes.
+ * @param channel Channel index
+ * @param address Address of the first record. 0 removes the channel from the acquisition.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegSetBuffer(rp_channel_t channel, uint32_t address);
+
+/**
+ * Returns the start of the channel records.
+ * @param channel Channel index
+ * @param address Address of the first record, 0 when the channel is not captured
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetBuffer(rp_channel_t channel, uint32_t* address);
+
+/**
+ * Enables AXI on the channels with a buffer and starts the acquisition of the records in the background.
+ * The trigger source is set again for every record.
+ * @param source Trigger source
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegStart(rp_acq_trig_src_t source);
+
+/**
+ * Stops the acquisition. The records taken so far stay readable.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegStop();
+
+/**
+ * Returns the progress of the acquisition.
+ * @param captured Number of records taken
+ * @param running True until all records are taken or the acquisition is stopped
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetState(uint32_t* captured, bool* running);
+
+/**
+ * Returns the position of the trigger sample in every record.
+ * @param pos Samples before the trigger
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetTriggerPos(uint32_t* pos);
+
+/**
+ * Returns the trigger timestamp of a record.
+ * @param channel Channel index
+ * @param segment Record index
+ * @param timestamp Trigger time in ns, same time base as rp_AcqGetTimestamp
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetTimestamp(rp_channel_t channel, uint32_t segment, uint64_t* timestamp);
+
+/**
+ * Returns the trigger timestamps of all records taken.
+ * @param channel Channel index
+ * @param timestamps Trigger times in ns
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetTimestamps(rp_channel_t channel, std::vector<uint64_t>* timestamps);
+
+/**
+ * Returns the records in raw units without copying the data. Each record starts with its oldest sample
+ * and takes one or two memory areas.
+ * @param channel Channel index
+ * @param first First record
+ * @param count Number of records
+ * @param data List of memory areas containing data.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetDataRawDirect(rp_channel_t channel, uint32_t first, uint32_t count, std::vector<std::span<int16_t>>* data);
+
+/**
+ * Returns a record in Volt units, starting with its oldest sample.
+ * @param channel Channel index
+ * @param segment Record index
+ * @param size Length of the output buffer. Returns length of filled buffer.
+ * @param buffer The output buffer gets filled with the record.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetDataV(rp_channel_t channel, uint32_t segment, uint32_t* size, float* buffer);
+
+/**
+ * Returns the time between consecutive records of the last acquisition that no record covers,
+ * from the FPGA trigger timestamps: the trigger interval minus one record length. With a trigger
+ * that comes faster than the records can be taken, the minimum is the re-arm dead time.
+ * @param min_ns Shortest dead time
+ * @param max_ns Longest dead time
+ * @param mean_ns Mean dead time
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSegGetDeadTime(uint64_t* min_ns, uint64_t* max_ns, uint64_t* mean_ns);
+
+///@}
+
 #endif  //__RP_ACQ_AXI_H
\ No newline at end of file
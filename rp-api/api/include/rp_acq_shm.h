@@ -0,0 +1,193 @@
+/**
+ * $Id: $
+ *
+ * @file rp_acq_shm.h
+ * @brief Red Pitaya library API interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __RP_ACQ_SHM_H
+#define __RP_ACQ_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <span>
+#include "rp_enums.h"
+
+/** Default name of the shared memory ring, as used by shm_open */
+#define RP_ACQ_SHM_NAME "/rp_acq"
+
+/** Conversion of the published counts of one channel to volts */
+typedef struct {
+    bool enabled;      //!< The channel holds data
+    uint8_t bits;      //!< Width of the counts, 16 in 16 bit mode
+    bool is_signed;    //!< Signed ADC counts
+    float full_scale;  //!< ADC full scale in volts
+    float gain;        //!< Input gain in volts, see rp_AcqGetGainV
+    float offset;      //!< Offset in volts, see rp_AcqSetOffset
+} rp_acq_shm_channel_t;
+
+/** Metadata of one capture in the shared memory ring */
+typedef struct {
+    uint64_t sequence;           //!< Sequence number of the capture, starts at 1
+    uint64_t time_ns;            //!< CLOCK_MONOTONIC time of the publication
+    uint64_t trigger_ns;         //!< Trigger timestamp, see rp_AcqGetTimestamp
+    uint32_t samples;            //!< Samples per channel
+    uint32_t trigger_index;      //!< Index of the trigger sample in the data
+    uint32_t decimation;         //!< Decimation factor
+    float sampling_rate;         //!< Sampling rate in Hz after decimation
+    int32_t trigger_source;      //!< rp_acq_trig_src_t of the capture
+    uint8_t channels;            //!< Number of ADC channels of the board
+    rp_acq_shm_channel_t channel[4];
+} rp_acq_shm_frame_t;
+
+/** @name Shared acquisition
+ * One process owns the hardware and publishes every completed capture into a ring of slots in
+ * shared memory. The data are calibrated counts, read once from the FPGA buffer. Any number of
+ * local processes map the ring read-only and do not need rp_Init. A frame stays readable until
+ * its slot is reused, which is checked with a sequence number in the slot (seqlock), so readers
+ * never block the publisher.
+ */
+///@{
+
+/**
+ * Creates the shared memory ring for the publisher. The API must be initialized.
+ * @param name Name of the shared memory object, RP_ACQ_SHM_NAME by default
+ * @param slots Number of captures kept in the ring, at least 2
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmCreate(const char* name, uint32_t slots);
+
+/**
+ * Removes the shared memory ring of the publisher. Readers keep their mapping until they close it.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmDestroy();
+
+/**
+ * Publishes the current oscilloscope buffer of all channels. The whole buffer is written, starting
+ * with the oldest sample. Call it when the buffer is filled.
+ * @param sequence Sequence number of the published capture
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmPublish(uint64_t* sequence);
+
+/**
+ * Maps the shared memory ring read-only.
+ * @param name Name of the shared memory object, RP_ACQ_SHM_NAME by default
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmOpen(const char* name);
+
+/**
+ * Unmaps the shared memory ring.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmClose();
+
+/**
+ * Returns the sequence number of the last published capture.
+ * @param sequence Sequence number, 0 when nothing is published yet
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmGetLatest(uint64_t* sequence);
+
+/**
+ * Waits for a capture newer than the given one.
+ * @param after Sequence number of the last capture seen
+ * @param timeout_ms Maximum waiting time
+ * @param sequence Sequence number of the last published capture
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM when nothing was published within the timeout.
+ */
+int rp_AcqShmWait(uint64_t after, uint32_t timeout_ms, uint64_t* sequence);
+
+/**
+ * Copies the metadata of a capture.
+ * @param sequence Sequence number of the capture
+ * @param frame Metadata
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture is no longer in the ring.
+ */
+int rp_AcqShmGetFrame(uint64_t sequence, rp_acq_shm_frame_t* frame);
+
+/**
+ * Returns the data of a channel in the shared memory without a copy.
+ * The data may be overwritten by the publisher at any time, check with rp_AcqShmIsValid after use.
+ * @param sequence Sequence number of the capture
+ * @param channel Channel index
+ * @param data Calibrated counts
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture is no longer in the ring.
+ */
+int rp_AcqShmGetDataRawDirect(uint64_t sequence, rp_channel_t channel, std::span<const int16_t>* data);
+
+/**
+ * Indicates whether a capture is still in the ring, so data taken from it before the call are intact.
+ * @param sequence Sequence number of the capture
+ * @param valid Returns status
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqShmIsValid(uint64_t sequence, bool* valid);
+
+/**
+ * Copies calibrated counts of a channel.
+ * @param sequence Sequence number of the capture
+ * @param channel Channel index
+ * @param pos Index of the first sample
+ * @param size Buffer size. Returns the number of copied samples.
+ * @param buffer Calibrated counts
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture was overwritten before or during the copy.
+ */
+int rp_AcqShmGetDataRaw(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
+
+/**
+ * Copies calibrated counts of a channel into a numpy buffer.
+ * @param sequence Sequence number of the capture
+ * @param channel Channel index
+ * @param pos Index of the first sample
+ * @param np_buffer Calibrated counts
+ * @param size Buffer size
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture was overwritten before or during the copy.
+ */
+int rp_AcqShmGetDataRawNP(uint64_t sequence, rp_channel_t channel, uint32_t pos, int16_t* np_buffer, int size);
+
+/**
+ * Converts samples of a channel to volts, like rp_AcqGetDataV.
+ * @param sequence Sequence number of the capture
+ * @param channel Channel index
+ * @param pos Index of the first sample
+ * @param size Buffer size. Returns the number of converted samples.
+ * @param buffer Samples in volts
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture was overwritten before or during the conversion.
+ */
+int rp_AcqShmGetDataV(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
+
+/**
+ * Converts samples of a channel to volts into a numpy buffer.
+ * @param sequence Sequence number of the capture
+ * @param channel Channel index
+ * @param pos Index of the first sample
+ * @param np_buffer Samples in volts
+ * @param size Buffer size
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EDOW when the capture was overwritten before or during the conversion.
+ */
+int rp_AcqShmGetDataVNP(uint64_t sequence, rp_channel_t channel, uint32_t pos, float* np_buffer, int size);
+
+///@}
+
+#endif  //__RP_ACQ_SHM_H
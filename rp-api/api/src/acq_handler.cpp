@@ -60,6 +60,10 @@ float ch_offset_input[4] = {0, 0, 0, 0};
 float ch_offset_input_axi[4] = {0, 0, 0, 0};
 static bool g_split_mode = false;
 
+/* @brief Sample conversion of the profile ADC format and of the 16 bit mode, see acq_InitConvert */
+static const cmn_convert_t* g_convert = nullptr;
+static const cmn_convert_t* g_convert16 = nullptr;
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Converts time in [ns] to ADC samples
@@ -989,6 +993,41 @@ uint32_t acq_GetNormalizedDataPos(uint32_t pos) {
     return (pos % ADC_BUFFER_SIZE);
 }
 
+int acq_InitConvert() {
+    uint8_t bits = 0;
+    bool is_sign = false;
+    int ret = rp_HPGetFastADCBits(&bits);
+    ret |= rp_HPGetFastADCIsSigned(&is_sign);
+    if (ret != RP_HP_OK) {
+        g_convert = nullptr;
+        g_convert16 = nullptr;
+        return RP_NOTS;
+    }
+    g_convert = cmn_GetConvert(bits, is_sign);
+    g_convert16 = cmn_GetConvert(16, is_sign);
+    return RP_OK;
+}
+
+static const cmn_convert_t* getConvert(uint8_t bits, bool is_sign) {
+    for (auto c : {g_convert, g_convert16}) {
+        if (c && c->bits == bits && c->is_signed == is_sign)
+            return c;
+    }
+    return cmn_GetConvert(bits, is_sign);
+}
+
+/* Calls fn(src, dst, count) for the runs of samples that wrap neither in the ADC buffer nor in the output */
+template <typename F>
+static void forEachRun(uint32_t src, uint32_t dst, uint32_t dst_size, uint32_t size, F fn) {
+    while (size > 0) {
+        uint32_t count = MIN(size, MIN(ADC_BUFFER_SIZE - src, dst_size - dst));
+        fn(src, dst, count);
+        src = (src + count) % ADC_BUFFER_SIZE;
+        dst = (dst + count) % dst_size;
+        size -= count;
+    }
+}
+
 int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer, bool use_calib) {
 
     CHECK_CHANNEL
@@ -1073,15 +1112,12 @@ int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t*
     uint32_t g_base = use_calib ? calib.base : 1;
     int32_t offset = use_calib ? calib.offset : 0;
     bits = is16BitEnable ? 16 : bits;
-    uint32_t mask = ((uint64_t)1 << bits) - 1;
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        uint32_t cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & mask;
-        if (is_sign)
-            buffer[i] = cmn_CalibCntsSigned(cnts, bits, gain, g_base, offset);
-        else
-            buffer[i] = cmn_CalibCntsUnsigned(cnts, bits, gain, g_base, offset);
-    }
+    auto convert = getConvert(bits, is_sign);
+    cmn_calib_cnts_t c = {bits, gain, g_base, offset};
+    forEachRun(pos % ADC_BUFFER_SIZE, 0, *size, *size, [&](uint32_t src, uint32_t dst, uint32_t count) {
+        convert->calibCnts(raw_buffer + src, count, buffer + dst, &c);
+    });
 
     return RP_OK;
 }
@@ -1195,7 +1231,6 @@ int acq_GetDataInBuffer(rp_channel_t channel, uint32_t pos, uint32_t* size, int3
     int32_t offset_volt = out->use_calib_for_volts ? calib.offset : 0;
 
     bits = is16BitEnable ? 16 : bits;
-    uint32_t mask = ((uint64_t)1 << bits) - 1;
 
     int16_t* iPtr = out->ch_i[channel];
     float* fPtr = out->ch_f[channel];
@@ -1203,28 +1238,17 @@ int acq_GetDataInBuffer(rp_channel_t channel, uint32_t pos, uint32_t* size, int3
     if (iPtr == nullptr && fPtr == nullptr && dPtr == nullptr)
         return RP_OK;
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        uint32_t cnts = (raw_buffer[(pos + i + offset) % ADC_BUFFER_SIZE]) & mask;
-        int32_t dataIndex = (i + offset + out->size) % out->size;
-        if (is_need_raw) {
-            if (is_sign)
-                iPtr[dataIndex] = cmn_CalibCntsSigned(cnts, bits, gain_raw, g_base_raw, offset_raw);
-            else
-                iPtr[dataIndex] = cmn_CalibCntsUnsigned(cnts, bits, gain_raw, g_base_raw, offset_raw);
-        }
-
-        if (is_need_vold_d || is_need_vold_f) {
-            float value = 0;
-            if (is_sign)
-                value = cmn_convertToVoltSigned(cnts, bits, fullScale, gain_volt, g_base_volt, offset_volt) * gainValue + offset_value;
-            else
-                value = cmn_convertToVoltUnsigned(cnts, bits, fullScale, gain_volt, g_base_volt, offset_volt) * gainValue + offset_value;
-            if (is_need_vold_f)
-                fPtr[dataIndex] = value;
-            if (is_need_vold_d)
-                dPtr[dataIndex] = value;
-        }
-    }
+    auto convert = getConvert(bits, is_sign);
+    cmn_calib_cnts_t c_raw = {bits, gain_raw, g_base_raw, offset_raw};
+    cmn_calib_cnts_t c_volt = {bits, gain_volt, g_base_volt, offset_volt};
+    forEachRun((pos + offset) % ADC_BUFFER_SIZE, (offset + out->size) % out->size, out->size, *size, [&](uint32_t src, uint32_t dst, uint32_t count) {
+        if (is_need_raw)
+            convert->calibCnts(raw_buffer + src, count, iPtr + dst, &c_raw);
+        if (is_need_vold_f)
+            convert->volts(raw_buffer + src, count, fPtr + dst, fullScale, &c_volt, gainValue, offset_value);
+        if (is_need_vold_d)
+            convert->voltsD(raw_buffer + src, count, dPtr + dst, fullScale, &c_volt, gainValue, offset_value);
+    });
 
     return RP_OK;
 }
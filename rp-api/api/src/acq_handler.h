@@ -92,6 +92,8 @@ int acq_GetTimestamp(rp_channel_t channel, uint64_t* value);
 
 uint32_t acq_GetNormalizedDataPos(uint32_t pos);
 
+int acq_InitConvert();
+
 int acq_GetData(uint32_t pos, buffers_t* out);
 int acq_GetDataWithCorrection(uint32_t pos, uint32_t* size, int32_t offset, buffers_t* out);
 
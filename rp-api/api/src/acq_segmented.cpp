@@ -0,0 +1,359 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library segmented AXI acquisition implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "acq_segmented.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "acq_handler.h"
+#include "common.h"
+#include "oscilloscope.h"
+#include "rp_hw-profiles.h"
+
+// Defined in rp.cpp. The worker takes them only around the re-arm, like the API calls.
+extern std::shared_mutex g_initMutex;
+extern std::mutex g_acqMutex;
+
+// The fill state has no interrupt, the worker polls it at this interval
+#define SEG_POLL_US 10
+
+#define CHECK_SEG_CHANNEL                                         \
+    if (channel >= rp_HPGetFastADCChannelsCountOrDefault()) {     \
+        ERROR_LOG("Channel is larger than allowed");              \
+        return RP_NOTS;                                           \
+    }
+
+namespace {
+
+typedef struct {
+    uint32_t address = 0;  // 0 - channel is not captured
+    std::vector<uint64_t> timestamps;
+    std::vector<uint32_t> trig_pos;  // Write pointer at trigger, relative to the record
+} seg_channel_t;
+
+std::mutex g_segMutex;
+seg_channel_t g_channels[RP_CH_4 + 1];
+uint32_t g_segments = 0;
+uint32_t g_samples = 0;
+uint32_t g_delay = 0;
+rp_acq_trig_src_t g_source = RP_TRIG_SRC_DISABLED;
+double g_record_ns = 0;
+std::atomic<uint32_t> g_captured = 0;
+std::atomic_bool g_run = false;
+std::atomic_bool g_running = false;
+std::thread g_thread;
+rp_channel_t g_ref_channel = RP_CH_1;
+uint64_t g_start_timestamp = 0;
+
+auto setAddress(int channel, uint32_t start, uint32_t end) -> int {
+    switch (channel) {
+        case RP_CH_1:
+            ECHECK(osc_axi_SetAddressStartChA(start))
+            return osc_axi_SetAddressEndChA(end);
+        case RP_CH_2:
+            ECHECK(osc_axi_SetAddressStartChB(start))
+            return osc_axi_SetAddressEndChB(end);
+        case RP_CH_3:
+            ECHECK(osc_axi_SetAddressStartChC(start))
+            return osc_axi_SetAddressEndChC(end);
+        case RP_CH_4:
+            ECHECK(osc_axi_SetAddressStartChD(start))
+            return osc_axi_SetAddressEndChD(end);
+        default:
+            return RP_EIPV;
+    }
+}
+
+auto recordBytes() -> uint32_t {
+    return g_samples * 2;
+}
+
+// Points the AXI writers at the record and starts it. Only register writes, no memory mapping.
+auto arm(uint32_t segment) -> int {
+    for (int ch = RP_CH_1; ch <= RP_CH_4; ch++) {
+        auto address = g_channels[ch].address;
+        if (address) {
+            auto start = address + segment * recordBytes();
+            ECHECK(setAddress(ch, start, start + recordBytes()))
+        }
+    }
+    ECHECK(acq_ResetFpga())
+    ECHECK(acq_Start(RP_CH_1))
+    return acq_SetTriggerSrc(RP_CH_1, g_source);
+}
+
+auto isFilled() -> bool {
+    for (int ch = RP_CH_1; ch <= RP_CH_4; ch++) {
+        if (g_channels[ch].address) {
+            bool filled = false;
+            if (acq_axi_GetBufferFillState((rp_channel_t)ch, &filled) != RP_OK || !filled)
+                return false;
+        }
+    }
+    return true;
+}
+
+auto restoreBuffers() -> void {
+    for (int ch = RP_CH_1; ch <= RP_CH_4; ch++) {
+        auto address = g_channels[ch].address;
+        if (address)
+            setAddress(ch, address, address + g_segments * recordBytes());
+    }
+}
+
+void segThread() {
+    uint32_t segment = 0;
+    uint64_t last_timestamp = g_start_timestamp;
+    while (g_run && segment < g_segments) {
+        // A fill state with the timestamp of the last record is left over from it, the re-arm has not reached the FPGA yet.
+        uint64_t timestamp = 0;
+        if (!isFilled() || (acq_GetTimestamp(g_ref_channel, &timestamp) == RP_OK && timestamp != 0 && timestamp == last_timestamp)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(SEG_POLL_US));
+            continue;
+        }
+        last_timestamp = timestamp;
+        std::shared_lock lock(g_initMutex);
+        std::lock_guard lockACQ(g_acqMutex);
+        {
+            std::lock_guard lockSeg(g_segMutex);
+            for (int ch = RP_CH_1; ch <= RP_CH_4; ch++) {
+                auto& channel = g_channels[ch];
+                if (!channel.address)
+                    continue;
+                uint32_t pos = 0;
+                uint64_t ch_timestamp = 0;
+                acq_axi_GetWritePointerAtTrig((rp_channel_t)ch, &pos);
+                acq_GetTimestamp((rp_channel_t)ch, &ch_timestamp);
+                channel.trig_pos[segment] = pos % g_samples;
+                channel.timestamps[segment] = ch_timestamp;
+            }
+        }
+        segment++;
+        g_captured = segment;
+        if (segment < g_segments && arm(segment) != RP_OK) {
+            ERROR_LOG("Failed to arm segment %d", segment)
+            break;
+        }
+    }
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    acq_Stop(RP_CH_1);
+    acq_SetTriggerSrc(RP_CH_1, RP_TRIG_SRC_DISABLED);
+    restoreBuffers();
+    g_running = false;
+}
+
+// First sample of the record in the channel buffer
+auto recordStart(const seg_channel_t& channel, uint32_t segment) -> uint32_t {
+    return (channel.trig_pos[segment] + g_delay) % g_samples;
+}
+
+}  // namespace
+
+int acq_seg_Setup(uint32_t segments, uint32_t samples) {
+    if (g_running)
+        return RP_EOOR;
+    if (segments == 0 || samples == 0 || samples % 8) {
+        ERROR_LOG("Segments must not be 0 and samples must be a multiple of 8")
+        return RP_EOOR;
+    }
+    std::lock_guard lock(g_segMutex);
+    g_segments = segments;
+    g_samples = samples;
+    g_captured = 0;
+    return RP_OK;
+}
+
+int acq_seg_GetSetup(uint32_t* segments, uint32_t* samples) {
+    std::lock_guard lock(g_segMutex);
+    *segments = g_segments;
+    *samples = g_samples;
+    return RP_OK;
+}
+
+int acq_seg_SetBuffer(rp_channel_t channel, uint32_t address) {
+    CHECK_SEG_CHANNEL
+    if (g_running)
+        return RP_EOOR;
+    std::lock_guard lock(g_segMutex);
+    g_channels[channel].address = address;
+    g_captured = 0;
+    return RP_OK;
+}
+
+int acq_seg_GetBuffer(rp_channel_t channel, uint32_t* address) {
+    CHECK_SEG_CHANNEL
+    std::lock_guard lock(g_segMutex);
+    *address = g_channels[channel].address;
+    return RP_OK;
+}
+
+int acq_seg_Start(rp_acq_trig_src_t source) {
+    if (g_running)
+        return RP_EOOR;
+    if (g_thread.joinable())
+        g_thread.join();
+    if (g_segments == 0) {
+        ERROR_LOG("Segmented acquisition is not set up")
+        return RP_EOOR;
+    }
+
+    bool any = false;
+    uint32_t delay = 0;
+    uint32_t decimation = 1;
+    ECHECK(acq_GetDecimationFactor(RP_CH_1, &decimation))
+    for (int ch = RP_CH_4; ch >= RP_CH_1; ch--) {
+        auto& channel = g_channels[ch];
+        if (!channel.address)
+            continue;
+        g_ref_channel = (rp_channel_t)ch;
+        int32_t ch_delay = 0;
+        ECHECK(acq_axi_GetTriggerDelay((rp_channel_t)ch, &ch_delay))
+        if (ch_delay <= 0 || (uint32_t)ch_delay > g_samples || (any && (uint32_t)ch_delay != delay)) {
+            ERROR_LOG("The AXI trigger delay must be the same on all channels and within the record. Delay %d samples %d", ch_delay, g_samples)
+            return RP_EOOR;
+        }
+        delay = ch_delay;
+        // The whole region is mapped once, the records only move the AXI addresses
+        ECHECK(acq_axi_SetBufferSamples((rp_channel_t)ch, channel.address, g_segments * g_samples))
+        ECHECK(acq_axi_Enable((rp_channel_t)ch, true))
+        any = true;
+    }
+    if (!any) {
+        ERROR_LOG("No channel buffer for segmented acquisition")
+        return RP_EOOR;
+    }
+
+    std::lock_guard lock(g_segMutex);
+    for (auto& channel : g_channels) {
+        channel.timestamps.assign(channel.address ? g_segments : 0, 0);
+        channel.trig_pos.assign(channel.address ? g_segments : 0, 0);
+    }
+    g_record_ns = (double)g_samples * decimation * cmn_GetSampleTimeNS();
+    g_delay = delay;
+    g_source = source;
+    g_captured = 0;
+
+    // The oscilloscope buffer ends with the AXI record, so the acquisition state machine stops with it
+    ECHECK(acq_SetTriggerDelayDirect(RP_CH_1, delay))
+    acq_GetTimestamp(g_ref_channel, &g_start_timestamp);
+    ECHECK(arm(0))
+    g_run = true;
+    g_running = true;
+    g_thread = std::thread(segThread);
+    return RP_OK;
+}
+
+int acq_seg_Stop() {
+    g_run = false;
+    if (g_thread.joinable())
+        g_thread.join();
+    return RP_OK;
+}
+
+int acq_seg_GetState(uint32_t* captured, bool* running) {
+    *captured = g_captured;
+    *running = g_running;
+    return RP_OK;
+}
+
+int acq_seg_GetTriggerPos(uint32_t* pos) {
+    std::lock_guard lock(g_segMutex);
+    *pos = g_samples - g_delay;
+    return RP_OK;
+}
+
+int acq_seg_GetTimestamp(rp_channel_t channel, uint32_t segment, uint64_t* timestamp) {
+    CHECK_SEG_CHANNEL
+    std::lock_guard lock(g_segMutex);
+    if (segment >= g_captured || segment >= g_channels[channel].timestamps.size())
+        return RP_EOOR;
+    *timestamp = g_channels[channel].timestamps[segment];
+    return RP_OK;
+}
+
+int acq_seg_GetTimestamps(rp_channel_t channel, std::vector<uint64_t>* timestamps) {
+    CHECK_SEG_CHANNEL
+    std::lock_guard lock(g_segMutex);
+    auto& ts = g_channels[channel].timestamps;
+    timestamps->assign(ts.begin(), ts.begin() + std::min<size_t>(g_captured, ts.size()));
+    return RP_OK;
+}
+
+int acq_seg_GetDataRawDirect(rp_channel_t channel, uint32_t first, uint32_t count, std::vector<std::span<int16_t>>* data) {
+    CHECK_SEG_CHANNEL
+    if (data == NULL)
+        return RP_EOOR;
+    std::lock_guard lock(g_segMutex);
+    auto& ch = g_channels[channel];
+    if (!ch.address || first + count > g_captured || first + count < first)
+        return RP_EOOR;
+    auto raw_buffer = (int16_t*)osc_axi_GetDataBufferCh(channel);
+    if (!raw_buffer)
+        return RP_EOOR;
+
+    data->clear();
+    for (uint32_t segment = first; segment < first + count; segment++) {
+        auto record = raw_buffer + (size_t)segment * g_samples;
+        auto start = recordStart(ch, segment);
+        data->push_back({record + start, (size_t)(g_samples - start)});
+        if (start)
+            data->push_back({record, (size_t)start});
+    }
+    return RP_OK;
+}
+
+int acq_seg_GetDataV(rp_channel_t channel, uint32_t segment, uint32_t* size, float* buffer) {
+    CHECK_SEG_CHANNEL
+    std::unique_lock lock(g_segMutex);
+    auto& ch = g_channels[channel];
+    if (!ch.address || segment >= g_captured)
+        return RP_EOOR;
+    *size = std::min(*size, g_samples);
+    auto record = segment * g_samples;
+    auto start = recordStart(ch, segment);
+    uint32_t first = std::min(*size, g_samples - start);
+    uint32_t second = *size - first;
+    lock.unlock();
+    ECHECK(acq_axi_GetDataV(channel, record + start, &first, buffer))
+    if (second)
+        ECHECK(acq_axi_GetDataV(channel, record, &second, buffer + first))
+    return RP_OK;
+}
+
+// The FPGA trigger timestamps run on the ADC clock and are not reset by the re-arm. Record k ends
+// (samples - pre-trigger) after its trigger and record k + 1 starts its pre-trigger part before its
+// own, so the time not covered by a record is the trigger interval minus one record length.
+int acq_seg_GetDeadTime(uint64_t* min_ns, uint64_t* max_ns, uint64_t* mean_ns) {
+    std::lock_guard lock(g_segMutex);
+    *min_ns = 0;
+    *max_ns = 0;
+    *mean_ns = 0;
+    auto& ts = g_channels[g_ref_channel].timestamps;
+    uint32_t captured = std::min<size_t>(g_captured, ts.size());
+    if (captured < 2)
+        return RP_OK;
+    uint64_t record = (uint64_t)g_record_ns;
+    uint64_t sum = 0;
+    *min_ns = UINT64_MAX;
+    for (uint32_t i = 1; i < captured; i++) {
+        uint64_t interval = ts[i] > ts[i - 1] ? ts[i] - ts[i - 1] : 0;
+        // A trigger within one record length of the last one has an incomplete pre-trigger part
+        uint64_t dead = interval > record ? interval - record : 0;
+        *min_ns = std::min(*min_ns, dead);
+        *max_ns = std::max(*max_ns, dead);
+        sum += dead;
+    }
+    *mean_ns = sum / (captured - 1);
+    return RP_OK;
+}
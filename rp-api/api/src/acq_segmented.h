@@ -0,0 +1,46 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library segmented AXI acquisition interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef SRC_ACQ_SEGMENTED_H_
+#define SRC_ACQ_SEGMENTED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <span>
+#include <vector>
+#include "rp.h"
+
+/**
+ * Segmented (fast frame) acquisition. The AXI buffer of each channel is sliced into records of
+ * equal length. A worker thread waits for the AXI fill state of the current record, reads its
+ * trigger position and timestamp, and re-arms the next record with register writes only. The
+ * data stays in DDR until all records are taken, so the dead time between records is the re-arm
+ * time and not the readout time. It is computed from the FPGA trigger timestamps of consecutive
+ * records.
+ *
+ * Every record holds (samples - AXI trigger delay) samples before the trigger. They are only
+ * complete when the trigger comes at least that many samples after the re-arm.
+ */
+
+int acq_seg_Setup(uint32_t segments, uint32_t samples);
+int acq_seg_GetSetup(uint32_t* segments, uint32_t* samples);
+int acq_seg_SetBuffer(rp_channel_t channel, uint32_t address);
+int acq_seg_GetBuffer(rp_channel_t channel, uint32_t* address);
+int acq_seg_Start(rp_acq_trig_src_t source);
+int acq_seg_Stop();
+int acq_seg_GetState(uint32_t* captured, bool* running);
+int acq_seg_GetTriggerPos(uint32_t* pos);
+int acq_seg_GetTimestamp(rp_channel_t channel, uint32_t segment, uint64_t* timestamp);
+int acq_seg_GetTimestamps(rp_channel_t channel, std::vector<uint64_t>* timestamps);
+int acq_seg_GetDataRawDirect(rp_channel_t channel, uint32_t first, uint32_t count, std::vector<std::span<int16_t>>* data);
+int acq_seg_GetDataV(rp_channel_t channel, uint32_t segment, uint32_t* size, float* buffer);
+int acq_seg_GetDeadTime(uint64_t* min_ns, uint64_t* max_ns, uint64_t* mean_ns);
+
+#endif /* SRC_ACQ_SEGMENTED_H_ */
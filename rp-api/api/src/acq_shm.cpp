@@ -0,0 +1,381 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library shared acquisition ring implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "acq_shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include "acq_handler.h"
+#include "common.h"
+#include "rp_hw-profiles.h"
+
+#define SHM_MAGIC 0x51415052  // "RPAQ"
+#define SHM_VERSION 1
+
+namespace {
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t samples;    // Per channel
+    uint32_t slot_size;  // Bytes, multiple of 8
+    uint32_t producer;   // pid
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint32_t> futex;
+} shm_header_t;
+
+typedef struct {
+    std::atomic<uint64_t> sequence;  // 0 while the slot is written
+    rp_acq_shm_frame_t frame;
+    // int16_t data[RP_CH_4 + 1][samples] follows
+} shm_slot_t;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The ring needs lock free 64 bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The ring needs lock free 32 bit atomics");
+
+typedef struct {
+    void* mem = NULL;
+    size_t size = 0;
+    std::string name;
+    shm_header_t* header = NULL;
+} shm_map_t;
+
+std::shared_mutex g_shmMutex;
+shm_map_t g_writer;
+shm_map_t g_reader;
+
+auto slotDataOffset() -> size_t {
+    return (sizeof(shm_slot_t) + 7) & ~(size_t)7;
+}
+
+auto headerSize() -> size_t {
+    return (sizeof(shm_header_t) + 63) & ~(size_t)63;
+}
+
+auto getSlot(shm_header_t* header, uint64_t sequence) -> shm_slot_t* {
+    auto base = (char*)header + headerSize();
+    return (shm_slot_t*)(base + (size_t)((sequence - 1) % header->slots) * header->slot_size);
+}
+
+auto getData(shm_header_t* header, shm_slot_t* slot, rp_channel_t channel) -> int16_t* {
+    return (int16_t*)((char*)slot + slotDataOffset()) + (size_t)channel * header->samples;
+}
+
+auto nowNs() -> uint64_t {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+auto unmap(shm_map_t* map) -> int {
+    if (!map->mem)
+        return RP_OK;
+    int ret = munmap(map->mem, map->size) < 0 ? RP_EUMD : RP_OK;
+    *map = shm_map_t();
+    return ret;
+}
+
+// The slot sequence is checked before and after the data are used
+auto findSlot(uint64_t sequence, shm_slot_t** slot) -> int {
+    if (!g_reader.header)
+        return RP_EANI;
+    auto header = g_reader.header;
+    if (sequence == 0 || sequence > header->sequence.load(std::memory_order_acquire))
+        return RP_EOOR;
+    *slot = getSlot(header, sequence);
+    if ((*slot)->sequence.load(std::memory_order_acquire) != sequence)
+        return RP_EDOW;
+    return RP_OK;
+}
+
+auto isIntact(shm_slot_t* slot, uint64_t sequence) -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+// The header decides the ring layout, so it is checked against the mapped size before any slot is touched
+auto isLayoutValid(const shm_header_t* header, size_t mapped) -> bool {
+    if (header->magic != SHM_MAGIC || header->version != SHM_VERSION)
+        return false;
+    if (header->slots < 2 || header->samples == 0 || header->slot_size % 8 != 0)
+        return false;
+    uint64_t needSlot = slotDataOffset() + (uint64_t)(RP_CH_4 + 1) * header->samples * sizeof(int16_t);
+    if (header->slot_size < needSlot)
+        return false;
+    return headerSize() + (uint64_t)header->slots * header->slot_size <= mapped;
+}
+
+// The frame lives in the slot, so its sizes are bounded by the validated header as well
+auto getChannel(shm_slot_t* slot, rp_channel_t channel, uint32_t pos, uint32_t* size) -> int {
+    if (channel > RP_CH_4 || channel >= slot->frame.channels || !slot->frame.channel[channel].enabled)
+        return RP_NOTS;
+    uint32_t samples = std::min(slot->frame.samples, g_reader.header->samples);
+    if (pos >= samples)
+        return RP_EOOR;
+    *size = std::min(*size, samples - pos);
+    return RP_OK;
+}
+
+auto fillChannel(rp_channel_t channel, rp_acq_shm_channel_t* info) -> int {
+    bool is16Bit = false;
+    acq_Get16BitMode(&is16Bit);
+    ECHECK(acq_GetGainV(channel, &info->gain))
+    ECHECK(acq_GetOffset(channel, &info->offset))
+    if (rp_HPGetHWADCFullScale(&info->full_scale) != RP_HP_OK)
+        return RP_EOOR;
+    if (rp_HPGetFastADCBits(&info->bits) != RP_HP_OK || rp_HPGetFastADCIsSigned(&info->is_signed) != RP_HP_OK)
+        return RP_EOOR;
+    info->bits = is16Bit ? 16 : info->bits;
+    info->enabled = true;
+    return RP_OK;
+}
+
+}  // namespace
+
+int acq_shm_Create(const char* name, uint32_t slots) {
+    std::unique_lock lock(g_shmMutex);
+    if (slots < 2 || !name || name[0] != '/')
+        return RP_EIPV;
+    ECHECK(unmap(&g_writer))
+
+    uint32_t samples = ADC_BUFFER_SIZE;
+    uint32_t slot_size = (slotDataOffset() + (size_t)(RP_CH_4 + 1) * samples * sizeof(int16_t) + 63) & ~(size_t)63;
+    size_t size = headerSize() + (size_t)slots * slot_size;
+
+    // A ring left by a publisher that crashed is replaced, readers of the old one keep their mapping
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        ERROR_LOG("Failed to create shared memory %s: %s", name, strerror(errno));
+        return RP_EOMD;
+    }
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return RP_EAM;
+    }
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name);
+        return RP_EMMD;
+    }
+
+    auto header = new (mem) shm_header_t();
+    header->magic = SHM_MAGIC;
+    header->version = SHM_VERSION;
+    header->slots = slots;
+    header->samples = samples;
+    header->slot_size = slot_size;
+    header->producer = getpid();
+    for (uint32_t i = 1; i <= slots; i++) {
+        new (getSlot(header, i)) shm_slot_t();
+    }
+    g_writer.mem = mem;
+    g_writer.size = size;
+    g_writer.name = name;
+    g_writer.header = header;
+    return RP_OK;
+}
+
+int acq_shm_Destroy() {
+    std::unique_lock lock(g_shmMutex);
+    if (!g_writer.mem)
+        return RP_OK;
+    shm_unlink(g_writer.name.c_str());
+    return unmap(&g_writer);
+}
+
+int acq_shm_Publish(uint64_t* sequence) {
+    std::shared_lock lock(g_shmMutex);
+    auto header = g_writer.header;
+    if (!header)
+        return RP_EANI;
+
+    uint64_t next = header->sequence.load(std::memory_order_relaxed) + 1;
+    auto slot = getSlot(header, next);
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto& frame = slot->frame;
+    frame = rp_acq_shm_frame_t();
+    frame.sequence = next;
+    frame.samples = header->samples;
+    frame.channels = rp_HPGetFastADCChannelsCountOrDefault();
+
+    uint32_t pos = 0, trig_pos = 0;
+    rp_acq_trig_src_t source = RP_TRIG_SRC_DISABLED;
+    ECHECK(acq_GetWritePointer(RP_CH_1, &pos))
+    ECHECK(acq_GetWritePointerAtTrig(RP_CH_1, &trig_pos))
+    ECHECK(acq_GetDecimationFactor(RP_CH_1, &frame.decimation))
+    ECHECK(acq_GetSamplingRateHz(RP_CH_1, &frame.sampling_rate))
+    ECHECK(acq_GetTriggerSrc(RP_CH_1, &source))
+    acq_GetTimestamp(RP_CH_1, &frame.trigger_ns);
+    frame.trigger_source = source;
+    // Oldest sample first, like rp_AcqGetOldestDataRaw
+    pos = (pos + 1) % ADC_BUFFER_SIZE;
+    frame.trigger_index = (trig_pos + ADC_BUFFER_SIZE - pos) % ADC_BUFFER_SIZE;
+
+    for (int ch = 0; ch < frame.channels; ch++) {
+        auto channel = (rp_channel_t)ch;
+        uint32_t size = frame.samples;
+        ECHECK(fillChannel(channel, &frame.channel[ch]))
+        // The only read of the FPGA buffer, straight into the slot
+        ECHECK(acq_GetDataRaw(channel, pos, &size, getData(header, slot, channel), true))
+    }
+    frame.time_ns = nowNs();
+
+    slot->sequence.store(next, std::memory_order_release);
+    header->sequence.store(next, std::memory_order_release);
+    header->futex.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, &header->futex, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    *sequence = next;
+    return RP_OK;
+}
+
+int acq_shm_Open(const char* name) {
+    std::unique_lock lock(g_shmMutex);
+    if (!name)
+        return RP_EIPV;
+    ECHECK(unmap(&g_reader))
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return RP_EOMD;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shm_header_t)) {
+        close(fd);
+        return RP_EOMD;
+    }
+    void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return RP_EMMD;
+    auto header = (shm_header_t*)mem;
+    if (!isLayoutValid(header, st.st_size)) {
+        ERROR_LOG("Shared memory %s has an invalid ring layout", name);
+        munmap(mem, st.st_size);
+        return RP_EOMD;
+    }
+    g_reader.mem = mem;
+    g_reader.size = st.st_size;
+    g_reader.name = name;
+    g_reader.header = header;
+    return RP_OK;
+}
+
+int acq_shm_Close() {
+    std::unique_lock lock(g_shmMutex);
+    return unmap(&g_reader);
+}
+
+int acq_shm_GetLatest(uint64_t* sequence) {
+    std::shared_lock lock(g_shmMutex);
+    if (!g_reader.header)
+        return RP_EANI;
+    *sequence = g_reader.header->sequence.load(std::memory_order_acquire);
+    return RP_OK;
+}
+
+int acq_shm_Wait(uint64_t after, uint32_t timeout_ms, uint64_t* sequence) {
+    std::shared_lock lock(g_shmMutex);
+    auto header = g_reader.header;
+    if (!header)
+        return RP_EANI;
+    uint64_t deadline = nowNs() + (uint64_t)timeout_ms * 1000000ull;
+    while (true) {
+        // The futex word is read before the sequence, so a publication in between wakes us
+        uint32_t word = header->futex.load(std::memory_order_acquire);
+        *sequence = header->sequence.load(std::memory_order_acquire);
+        if (*sequence > after)
+            return RP_OK;
+        uint64_t now = nowNs();
+        if (now >= deadline)
+            return RP_ETIM;
+        timespec ts;
+        ts.tv_sec = (deadline - now) / 1000000000ull;
+        ts.tv_nsec = (deadline - now) % 1000000000ull;
+        syscall(SYS_futex, &header->futex, FUTEX_WAIT, word, &ts, NULL, 0);
+    }
+}
+
+int acq_shm_GetFrame(uint64_t sequence, rp_acq_shm_frame_t* frame) {
+    std::shared_lock lock(g_shmMutex);
+    shm_slot_t* slot = NULL;
+    int ret = findSlot(sequence, &slot);
+    if (ret != RP_OK)
+        return ret;
+    *frame = slot->frame;
+    return isIntact(slot, sequence) ? RP_OK : RP_EDOW;
+}
+
+int acq_shm_GetDataRawDirect(uint64_t sequence, rp_channel_t channel, std::span<const int16_t>* data) {
+    std::shared_lock lock(g_shmMutex);
+    shm_slot_t* slot = NULL;
+    int ret = findSlot(sequence, &slot);
+    if (ret != RP_OK)
+        return ret;
+    uint32_t size = g_reader.header->samples;
+    ECHECK(getChannel(slot, channel, 0, &size))
+    *data = std::span<const int16_t>(getData(g_reader.header, slot, channel), size);
+    return isIntact(slot, sequence) ? RP_OK : RP_EDOW;
+}
+
+int acq_shm_IsValid(uint64_t sequence, bool* valid) {
+    std::shared_lock lock(g_shmMutex);
+    shm_slot_t* slot = NULL;
+    int ret = findSlot(sequence, &slot);
+    if (ret != RP_OK && ret != RP_EDOW)
+        return ret;
+    *valid = ret == RP_OK && isIntact(slot, sequence);
+    return RP_OK;
+}
+
+int acq_shm_GetDataRaw(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer) {
+    std::shared_lock lock(g_shmMutex);
+    shm_slot_t* slot = NULL;
+    int ret = findSlot(sequence, &slot);
+    if (ret != RP_OK)
+        return ret;
+    ECHECK(getChannel(slot, channel, pos, size))
+    memcpy(buffer, getData(g_reader.header, slot, channel) + pos, *size * sizeof(int16_t));
+    return isIntact(slot, sequence) ? RP_OK : RP_EDOW;
+}
+
+int acq_shm_GetDataV(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer) {
+    std::shared_lock lock(g_shmMutex);
+    shm_slot_t* slot = NULL;
+    int ret = findSlot(sequence, &slot);
+    if (ret != RP_OK)
+        return ret;
+    ECHECK(getChannel(slot, channel, pos, size))
+    auto info = slot->frame.channel[channel];
+    auto data = getData(g_reader.header, slot, channel) + pos;
+    // Same steps as acq_GetDataV on calibrated counts
+    float range = (float)(1 << (info.bits - (info.is_signed ? 1 : 0)));
+    for (uint32_t i = 0; i < *size; i++) {
+        float cnts = info.is_signed ? (float)data[i] : (float)(uint16_t)data[i];
+        float value = cnts * info.full_scale / range;
+        buffer[i] = value * info.gain + info.offset;
+    }
+    return isIntact(slot, sequence) ? RP_OK : RP_EDOW;
+}
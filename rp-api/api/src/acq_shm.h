@@ -0,0 +1,41 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library shared acquisition ring interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef SRC_ACQ_SHM_H_
+#define SRC_ACQ_SHM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <span>
+#include "rp.h"
+
+/**
+ * Ring layout: a header, then the slots. Every slot holds its sequence number, the frame metadata
+ * and the data of all channels. The publisher clears the slot sequence before it writes the slot
+ * and sets it after, so a reader that sees the same sequence before and after reading has read a
+ * complete capture. The header sequence is the last published capture, a futex word next to it
+ * wakes the waiting readers.
+ */
+
+int acq_shm_Create(const char* name, uint32_t slots);
+int acq_shm_Destroy();
+int acq_shm_Publish(uint64_t* sequence);
+
+int acq_shm_Open(const char* name);
+int acq_shm_Close();
+int acq_shm_GetLatest(uint64_t* sequence);
+int acq_shm_Wait(uint64_t after, uint32_t timeout_ms, uint64_t* sequence);
+int acq_shm_GetFrame(uint64_t sequence, rp_acq_shm_frame_t* frame);
+int acq_shm_GetDataRawDirect(uint64_t sequence, rp_channel_t channel, std::span<const int16_t>* data);
+int acq_shm_IsValid(uint64_t sequence, bool* valid);
+int acq_shm_GetDataRaw(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
+int acq_shm_GetDataV(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
+
+#endif /* SRC_ACQ_SHM_H_ */
@@ -20,6 +20,7 @@
 #include <memory>
 #include <mutex>
 #include <vector>
+#include "emulator.h"
 #include "rp_log.h"
 
 struct block_t;
@@ -65,6 +66,9 @@ int osc_axi_map(size_t size, size_t offset, void** mapped) {
                   offset % sysconf(_SC_PAGESIZE), sysconf(_SC_PAGESIZE), (long int)offset, sysconf(_SC_PAGESIZE));
         return RP_EMMD;
     }
+    if (emu_IsEnabled()) {
+        return emu_Map(size, offset, mapped);
+    }
     *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, g_mem_fd, offset);
     if (*mapped == MAP_FAILED) {
         ERROR_LOG("Error osc_axi_map: %s\n", strerror(errno));
@@ -83,6 +87,11 @@ int osc_axi_unmap(size_t size, void** mapped) {
     if ((*mapped == MAP_FAILED) || (*mapped == NULL)) {
         return RP_EUMD;
     }
+    if (emu_IsEnabled()) {
+        ECHECK(emu_Unmap(size, mapped))
+        *mapped = MAP_FAILED;
+        return RP_OK;
+    }
     if (munmap(*mapped, size) < 0) {
         return RP_EUMD;
     }
@@ -96,7 +105,8 @@ int axi_initManager() {
         ECHECK(axi_getOSReservedRegion(&g_startRegion, &g_sizeRegion))
         g_reserved.clear();
         g_index = 0;
-        g_mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+        // The emulated reserved memory is process memory, /dev/mem is never opened
+        g_mem_fd = open(emu_IsEnabled() ? "/dev/null" : "/dev/mem", O_RDWR | O_SYNC);
         if (g_mem_fd < 0) {
             g_mem_fd = -1;
             return RP_EOMD;
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include "emulator.h"
 #include "rp.h"
 
 #ifdef TRACE_ENABLE
@@ -33,6 +34,9 @@ int fd = -1;
 bool g_DebugReg = false;
 
 int cmn_Init() {
+    if (emu_IsEnabled()) {
+        return emu_Init();
+    }
     if (fd == -1) {
         if ((fd = open("/dev/uio/api@40000000", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
@@ -42,6 +46,9 @@ int cmn_Init() {
 }
 
 int cmn_Release() {
+    if (emu_IsEnabled()) {
+        return emu_Release();
+    }
     if (fd != -1) {
         if (close(fd) < 0) {
             return RP_ECMD;
@@ -52,6 +59,9 @@ int cmn_Release() {
 }
 
 int cmn_Map(size_t size, size_t offset, void** mapped) {
+    if (emu_IsEnabled()) {
+        return emu_Map(size, offset, mapped);
+    }
     if (fd == -1) {
         return RP_EMMD;
     }
@@ -68,6 +78,9 @@ int cmn_Map(size_t size, size_t offset, void** mapped) {
 }
 
 int cmn_Unmap(size_t size, void** mapped) {
+    if (emu_IsEnabled()) {
+        return emu_Unmap(size, mapped);
+    }
     if (fd == -1) {
         return RP_EUMD;
     }
@@ -88,6 +101,10 @@ int cmn_Unmap(size_t size, void** mapped) {
 }
 
 int cmn_InitMap(size_t size, size_t offset, void** mapped, int* fd) {
+    if (emu_IsEnabled()) {
+        *fd = -1;
+        return emu_Map(size, offset, mapped);
+    }
     if ((*fd = open("/dev/uio/api@40000000", O_RDWR | O_SYNC)) == -1) {
         return RP_EOMD;
     }
@@ -107,6 +124,9 @@ int cmn_InitMap(size_t size, size_t offset, void** mapped, int* fd) {
 }
 
 int cmn_ReleaseClose(int fd, size_t size, void** mapped) {
+    if (emu_IsEnabled()) {
+        return emu_Unmap(size, mapped);
+    }
     if (fd == -1) {
         return RP_EUMD;
     }
@@ -163,6 +183,9 @@ int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask) {
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask) {
     VALIDATE_BITS(bits, mask);
     SET_BITS(*field, bits);
+    if (emu_IsEnabled()) {
+        emu_SetBits(field, bits);
+    }
     return RP_OK;
 }
 
@@ -264,6 +287,12 @@ rp_acq_ac_dc_mode_calib_t convertPower(rp_acq_ac_dc_mode_t ch) {
 int cmn_GetReservedMemory(uint32_t* _startAddress, uint32_t* _size) {
     *_startAddress = 0;
     *_size = 0;
+    if (emu_IsEnabled()) {
+        // Nominal DDR region so AXI setup succeeds, the memory itself is not emulated
+        *_startAddress = EMU_RESERVED_MEMORY_ADDR;
+        *_size = EMU_RESERVED_MEMORY_SIZE;
+        return RP_OK;
+    }
     int fd = 0;
     if ((fd = open("/sys/firmware/devicetree/base/reserved-memory/buffer@2000000_b/reg", O_RDONLY)) == -1) {
         fprintf(stderr, "[FATAL ERROR] Error open: /sys/firmware/devicetree/base/reserved-memory/buffer@2000000_b/reg\n");
@@ -112,4 +112,157 @@ inline float cmn_convertToVoltUnsigned(uint32_t cnts, uint8_t bits, float fullSc
     return ret_val;
 }
 
+/**
+ * Block conversions specialized on the sample format. The profile of the board fixes the width and
+ * the signedness of the ADC and DAC samples, so cmn_GetConvert is called once at init and the
+ * per-sample functions above are only kept for single values. The kernels give the same results
+ * as the per-sample functions. The calibration base is a power of two, the division by it is
+ * replaced with a shift that rounds toward zero like the division.
+ */
+
+typedef struct {
+    uint8_t bits;     //!< Sample width, only used by the generic kernels
+    uint32_t gain;    //!< Calibration gain, see uint_gain_calib_t
+    uint32_t base;    //!< Calibration base
+    int32_t offset;   //!< Calibration offset in counts
+} cmn_calib_cnts_t;
+
+typedef struct {
+    uint8_t bits;    //!< Sample width, 0 for the generic kernels
+    bool is_signed;  //!< Signed samples
+    /** ADC samples to calibrated counts */
+    void (*calibCnts)(const volatile uint32_t* src, uint32_t size, int16_t* dst, const cmn_calib_cnts_t* calib);
+    /** ADC samples to volts, value * gain + offset */
+    void (*volts)(const volatile uint32_t* src, uint32_t size, float* dst, float fullScale, const cmn_calib_cnts_t* calib, float gain, float offset);
+    void (*voltsD)(const volatile uint32_t* src, uint32_t size, double* dst, float fullScale, const cmn_calib_cnts_t* calib, float gain, float offset);
+    /** Signal normalized to the DAC full scale to DAC counts, like cmn_convertToCnt(v, bits, 1.0, is_signed, 1, 0) */
+    void (*cnts)(const float* src, uint32_t size, uint8_t bits, uint16_t* dst);
+    void (*cntsV)(const float* src, uint32_t size, uint8_t bits, volatile int32_t* dst);
+} cmn_convert_t;
+
+/**
+ * BITS == 0 reads the width from the arguments, for sample formats without a specialization.
+ */
+template <uint8_t BITS, bool SIGNED>
+struct cmn_Convert {
+    static_assert(BITS <= 16, "Samples are at most 16 bits wide");
+
+    static inline uint8_t width(uint8_t bits) { return BITS ? BITS : bits; }
+
+    static inline uint32_t mask(uint8_t bits) { return ((uint64_t)1 << width(bits)) - 1; }
+
+    // Gain applied before the division, as in cmn_CalibCntsSigned and cmn_CalibCntsUnsigned
+    static inline int32_t scaled(uint32_t cnts, uint8_t bits, uint32_t gain, int32_t offset) {
+        int32_t m;
+        if (SIGNED) {
+            uint8_t shift = 32 - width(bits);
+            m = (int32_t)(cnts << shift) >> shift;
+        } else {
+            m = cnts;
+        }
+        m -= offset;
+        return SIGNED ? (int32_t)gain * m : (int32_t)(gain * (uint32_t)m);
+    }
+
+    // Division by the base, or by 1 << shift when shift >= 0
+    static inline int32_t divide(int32_t m, uint32_t base, int shift) {
+        if (SIGNED) {
+            if (shift >= 0)
+                return (m + ((m >> 31) & ((1 << shift) - 1))) >> shift;
+            return m / (int32_t)base;
+        }
+        if (shift >= 0)
+            return (uint32_t)m >> shift;
+        return (uint32_t)m / base;
+    }
+
+    static inline int baseShift(uint32_t base) {
+        if (base == 0 || (base & (base - 1)) != 0)
+            return -1;
+        return __builtin_ctz(base);
+    }
+
+    static void calibCnts(const volatile uint32_t* src, uint32_t size, int16_t* dst, const cmn_calib_cnts_t* calib) {
+        const uint8_t bits = calib->bits;
+        const uint32_t m = mask(bits);
+        const int shift = baseShift(calib->base);
+        if (shift == 0 && calib->gain == 1) {
+            for (uint32_t i = 0; i < size; i++)
+                dst[i] = scaled(src[i] & m, bits, 1, calib->offset);
+        } else if (shift >= 0) {
+            for (uint32_t i = 0; i < size; i++)
+                dst[i] = divide(scaled(src[i] & m, bits, calib->gain, calib->offset), calib->base, shift);
+        } else {
+            for (uint32_t i = 0; i < size; i++)
+                dst[i] = divide(scaled(src[i] & m, bits, calib->gain, calib->offset), calib->base, -1);
+        }
+    }
+
+    template <typename T>
+    static inline void voltsT(const volatile uint32_t* src, uint32_t size, T* dst, float fullScale, const cmn_calib_cnts_t* calib, float gain, float offset) {
+        const uint8_t bits = calib->bits;
+        const uint32_t m = mask(bits);
+        const int shift = baseShift(calib->base);
+        // Exact, the divisor of cmn_convertToVolt* is a power of two
+        const float lsb = 1.0f / (float)(1 << (width(bits) - (SIGNED ? 1 : 0)));
+        auto toVolt = [&](int32_t c) -> float {
+            float v = SIGNED ? (float)c : (float)(uint32_t)c;
+            return v * fullScale * lsb * gain + offset;
+        };
+        if (shift >= 0) {
+            for (uint32_t i = 0; i < size; i++)
+                dst[i] = toVolt(divide(scaled(src[i] & m, bits, calib->gain, calib->offset), calib->base, shift));
+        } else {
+            for (uint32_t i = 0; i < size; i++)
+                dst[i] = toVolt(divide(scaled(src[i] & m, bits, calib->gain, calib->offset), calib->base, -1));
+        }
+    }
+
+    static void volts(const volatile uint32_t* src, uint32_t size, float* dst, float fullScale, const cmn_calib_cnts_t* calib, float gain, float offset) {
+        voltsT(src, size, dst, fullScale, calib, gain, offset);
+    }
+
+    static void voltsD(const volatile uint32_t* src, uint32_t size, double* dst, float fullScale, const cmn_calib_cnts_t* calib, float gain, float offset) {
+        voltsT(src, size, dst, fullScale, calib, gain, offset);
+    }
+
+    template <typename T>
+    static inline void cntsT(const float* src, uint32_t size, uint8_t bits, T* dst) {
+        const uint8_t valueBits = width(bits) - (SIGNED ? 1 : 0);
+        const float scale = (float)(1 << valueBits);
+        const int32_t max = (1 << valueBits) - 1;
+        const int32_t min = SIGNED ? -(1 << valueBits) : 0;
+        const uint32_t m = mask(bits);
+        for (uint32_t i = 0; i < size; i++) {
+            float v = src[i];
+            v = v > 1.0f ? 1.0f : (v < (SIGNED ? -1.0f : 0.0f) ? (SIGNED ? -1.0f : 0.0f) : v);
+            int32_t c = (int32_t)roundf(v * scale);
+            c = c > max ? max : (c < min ? min : c);
+            dst[i] = (uint32_t)c & m;
+        }
+    }
+
+    static void cnts(const float* src, uint32_t size, uint8_t bits, uint16_t* dst) { cntsT(src, size, bits, dst); }
+
+    static void cntsV(const float* src, uint32_t size, uint8_t bits, volatile int32_t* dst) { cntsT(src, size, bits, dst); }
+
+    static constexpr cmn_convert_t table = {BITS, SIGNED, calibCnts, volts, voltsD, cnts, cntsV};
+};
+
+/**
+ * Returns the kernels of a sample format, the generic ones when the format has no specialization.
+ */
+inline const cmn_convert_t* cmn_GetConvert(uint8_t bits, bool is_signed) {
+    switch (bits) {
+        case 12:
+            return is_signed ? &cmn_Convert<12, true>::table : &cmn_Convert<12, false>::table;
+        case 14:
+            return is_signed ? &cmn_Convert<14, true>::table : &cmn_Convert<14, false>::table;
+        case 16:
+            return is_signed ? &cmn_Convert<16, true>::table : &cmn_Convert<16, false>::table;
+        default:
+            return is_signed ? &cmn_Convert<0, true>::table : &cmn_Convert<0, false>::table;
+    }
+}
+
 #endif
\ No newline at end of file
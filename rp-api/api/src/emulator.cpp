@@ -0,0 +1,649 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library FPGA emulation implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "emulator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "generate.h"
+#include "oscilloscope.h"
+#include "rp_hw-profiles.h"
+
+#define EMU_TICK_US 1000
+#define EMU_MAX_SAMPLES_PER_TICK (2 * ADC_BUFFER_SIZE)
+#define EMU_SINE_FREQ_HZ 10000.0  // Rounded to a whole number of ADC clocks per period
+
+namespace {
+
+typedef struct {
+    void* mem = NULL;
+    size_t size = 0;
+    int refs = 0;
+} emu_region_t;
+
+typedef struct {
+    bool active = false;
+    uint32_t wr = 0;  // Absolute address of the next sample
+    uint32_t post_trigger = 0;
+} emu_axi_state_t;
+
+// AXI registers of one channel. Channels A and B of a register block share the state register.
+typedef struct {
+    volatile uint32_t* addr_low;
+    volatile uint32_t* addr_high;
+    volatile uint32_t* delay;
+    volatile uint32_t* enable;
+    volatile uint32_t* wr_ptr_trigger;
+    volatile uint32_t* wr_ptr_cur;
+    volatile uint32_t* state;
+    uint32_t fill_bit;
+} emu_axi_regs_t;
+
+typedef struct {
+    bool start_write = false;
+    bool triggered = false;
+    uint32_t wr_ptr = 0;
+    uint32_t pre_trigger = 0;
+    uint32_t post_trigger = 0;
+    int32_t last[4] = {0, 0, 0, 0};
+    uint64_t adc_clock = 0;
+    double sample_acc = 0;
+    emu_axi_state_t axi[4];
+} emu_osc_state_t;
+
+typedef struct {
+    bool triggered = false;  // Output follows the buffer or the burst, otherwise the initial value
+    bool finished = false;   // All bursts are done, the last value is held
+    uint16_t selector = 0;   // Trigger selector of the last tick
+    uint64_t counter = 0;    // Read pointer, 16.16 fixed point
+    uint64_t burst_ticks = 0;  // DAC clocks since the start of the burst
+    uint32_t cycles = 0;       // Buffer periods played in the burst
+    uint32_t bursts = 0;       // Bursts done
+} emu_gen_state_t;
+
+std::mutex g_emuMutex;
+std::map<size_t, emu_region_t> g_regions;
+// Regions replaced by a larger mapping. The model thread may still write to them until it stops.
+std::vector<emu_region_t> g_retired;
+std::thread g_modelThread;
+std::atomic_bool g_modelRun = false;
+emu_osc_state_t g_osc;
+emu_gen_state_t g_gen[2];
+double g_genAcc = 0;
+// Bits set in the generator config through cmn_SetBits. Reset and software trigger are pulses the tick would miss.
+std::atomic<uint32_t> g_genPulses = 0;
+// One period of the input sine in ADC clocks, only used by the model thread
+std::vector<float> g_sine;
+
+auto findRegion(size_t offset) -> void* {
+    std::lock_guard lock(g_emuMutex);
+    auto it = g_regions.find(offset);
+    return it != g_regions.end() ? it->second.mem : NULL;
+}
+
+// Reserved DDR memory mapped by the AXI manager, found by its physical address
+auto findMemory(uint32_t address, uint32_t size) -> uint16_t* {
+    std::lock_guard lock(g_emuMutex);
+    for (auto& it : g_regions) {
+        if (it.second.mem && it.first <= address && address + size <= it.first + it.second.size)
+            return (uint16_t*)((char*)it.second.mem + (address - it.first));
+    }
+    return NULL;
+}
+
+auto axiRegs(volatile osc_control_t* osc, int ch) -> emu_axi_regs_t {
+    if (ch % 2 == 0)
+        return {&osc->cha_axi_addr_low, &osc->cha_axi_addr_high, &osc->cha_axi_delay, &osc->cha_axi_enable, &osc->cha_axi_wr_ptr_trigger, &osc->cha_axi_wr_ptr_cur, &osc->axi_state, AXI_CHA_FILL_STATE};
+    return {&osc->chb_axi_addr_low, &osc->chb_axi_addr_high, &osc->chb_axi_delay, &osc->chb_axi_enable, &osc->chb_axi_wr_ptr_trigger, &osc->chb_axi_wr_ptr_cur, &osc->axi_state, AXI_CHB_FILL_STATE};
+}
+
+auto signExtend(uint32_t value, uint8_t bits) -> int32_t {
+    uint32_t sign = 1u << (bits - 1);
+    value &= (sign << 1) - 1;
+    return (int32_t)(value ^ sign) - (int32_t)sign;
+}
+
+/*
+ * The config and trig_source registers are shared with the API thread, which does plain
+ * read-modify-write on them. Only the bits the FPGA owns are touched here, atomically.
+ */
+void setBits(volatile uint32_t* reg, uint32_t bits) {
+    __atomic_fetch_or((uint32_t*)reg, bits, __ATOMIC_SEQ_CST);
+}
+
+void clearBits(volatile uint32_t* reg, uint32_t bits) {
+    __atomic_fetch_and((uint32_t*)reg, ~bits, __ATOMIC_SEQ_CST);
+}
+
+typedef struct {
+    uint32_t step;
+    uint64_t wrap;
+    uint32_t start;
+    uint32_t cycles;       // Buffer periods in one burst, 0 - continuous
+    uint32_t repetitions;  // Bursts - 1, 0xFFFF - infinite
+    uint32_t period;       // DAC clocks from the start of one burst to the next
+    uint32_t amp_scale;
+    uint32_t init_value;
+    uint32_t final_value;
+} emu_gen_regs_t;
+
+auto genRegs(volatile generate_control_t* gen, int ch) -> emu_gen_regs_t {
+    if (ch == 0)
+        return {gen->counterStep_ch1, (uint64_t)gen->counterWrap_ch1 + 1, gen->startOffset_ch1, gen->cyclesInOneBurst_ch1, gen->burstRepetitions_ch1,
+                gen->delayBetweenBurstRepetitions_ch1, gen->ampAndScale_ch1, gen->initGenValue_ch1, gen->BurstFinalValue_ch1};
+    return {gen->counterStep_ch2, (uint64_t)gen->counterWrap_ch2 + 1, gen->startOffset_ch2, gen->cyclesInOneBurst_ch2, gen->burstRepetitions_ch2,
+            gen->delayBetweenBurstRepetitions_ch2, gen->ampAndScale_ch2, gen->initGenValue_ch2, gen->BurstFinalValue_ch2};
+}
+
+auto genStart(emu_gen_state_t* state, const emu_gen_regs_t& regs) -> void {
+    state->triggered = true;
+    state->finished = false;
+    state->counter = regs.start % regs.wrap;
+    state->burst_ticks = 0;
+    state->cycles = 0;
+    state->bursts = 0;
+}
+
+// State machine reset and triggers. Software triggers write the selector bits, other selectors fire once when selected.
+void genEvents(volatile generate_control_t* gen) {
+    uint32_t pulses = g_genPulses.exchange(0);
+    asg_config_control_u_t config;
+    config.reg_full = gen->config;
+    for (int ch = 0; ch < 2; ch++) {
+        auto& state = g_gen[ch];
+        auto& conf = config.reg[ch];
+        uint32_t shift = ch * 16;
+        uint16_t selector = conf.triggerSelector;
+        if (conf.SM_reset || (pulses >> shift) & 0x40) {
+            auto keep = state.selector;
+            state = emu_gen_state_t();
+            state.selector = keep;
+        }
+        bool fire = selector != 0 && (((pulses >> shift) & 0xF) || selector != state.selector);
+        state.selector = selector;
+        if (fire && !conf.SM_reset)
+            genStart(&state, genRegs(gen, ch));
+    }
+}
+
+// Moves the generator on by ticks DAC clocks. Bursts play cycles buffer periods, then hold the last value until the period is over.
+void genAdvance(volatile generate_control_t* gen, int ch, uint64_t ticks) {
+    auto& state = g_gen[ch];
+    auto regs = genRegs(gen, ch);
+    if (!state.triggered || state.finished || regs.step == 0)
+        return;
+    if (regs.cycles == 0) {
+        state.counter = (state.counter + (regs.step % regs.wrap) * (ticks % regs.wrap)) % regs.wrap;
+        return;
+    }
+    while (ticks > 0 && !state.finished) {
+        if (state.cycles < regs.cycles) {
+            uint64_t left = (uint64_t)(regs.cycles - state.cycles) * regs.wrap - state.counter;
+            uint64_t t = std::min<uint64_t>(ticks, (left + regs.step - 1) / regs.step);
+            uint64_t counter = state.counter + regs.step * t;
+            state.cycles += counter / regs.wrap;
+            state.counter = counter % regs.wrap;
+            state.burst_ticks += t;
+            ticks -= t;
+            continue;
+        }
+        if (regs.repetitions != 0xFFFF && state.bursts >= regs.repetitions) {
+            state.finished = true;
+            break;
+        }
+        uint64_t t = std::min<uint64_t>(ticks, regs.period > state.burst_ticks ? regs.period - state.burst_ticks : 0);
+        state.burst_ticks += t;
+        ticks -= t;
+        if (state.burst_ticks >= regs.period) {
+            state.bursts++;
+            state.cycles = 0;
+            state.counter = regs.start % regs.wrap;
+            state.burst_ticks = 0;
+        }
+    }
+}
+
+// DAC output in parts of the full scale, false while the output is switched off
+auto genOutput(volatile generate_control_t* gen, int ch, uint8_t dac_bits, double* value) -> bool {
+    asg_config_control_u_t config;
+    config.reg_full = gen->config;
+    if (config.reg[ch].setOutputTo0)
+        return false;
+    auto& state = g_gen[ch];
+    auto regs = genRegs(gen, ch);
+    int32_t full = 1 << (dac_bits - 1);
+    int32_t code = 0;
+    if (state.triggered && (regs.cycles == 0 || state.cycles < regs.cycles)) {
+        auto data = (volatile uint32_t*)((char*)gen + (ch == 0 ? CHA_DATA_OFFSET : CHB_DATA_OFFSET));
+        asg_ch_amp_scale_u_t amp;
+        amp.reg_full = regs.amp_scale;
+        code = signExtend(data[(uint32_t)(state.counter >> 16) % DAC_BUFFER_SIZE], dac_bits);
+        // Scale 1 << (dac_bits - 1) is unity gain, the offset is in DAC codes
+        code = (int32_t)(((int64_t)code * amp.reg.amplitudeScale) >> (dac_bits - 1)) + signExtend(amp.reg.amplitudeOffset, 14);
+    } else {
+        code = signExtend(state.triggered ? regs.final_value : regs.init_value, dac_bits);
+    }
+    *value = (double)std::clamp(code, -full, full - 1) / full;
+    return true;
+}
+
+// The sine is looked up by the ADC clock, so it stays continuous across ticks and decimations
+auto sineSample(uint64_t adc_clock, int ch, double fs) -> double {
+    size_t period = std::max<size_t>(4, lround(fs / EMU_SINE_FREQ_HZ));
+    if (g_sine.size() != period) {
+        g_sine.resize(period);
+        for (size_t i = 0; i < period; i++) {
+            g_sine[i] = sin(2.0 * M_PI * i / period);
+        }
+    }
+    // Channels are a quarter period apart
+    return g_sine[(adc_clock + ch * period / 4) % period];
+}
+
+auto isLevelTrigger(uint32_t source, int* channel, int* edge) -> bool {
+    switch (source) {
+        case RP_TRIG_SRC_CHA_PE:
+        case RP_TRIG_SRC_CHA_NE:
+        case RP_TRIG_SRC_CHA_AE:
+            *channel = 0;
+            break;
+        case RP_TRIG_SRC_CHB_PE:
+        case RP_TRIG_SRC_CHB_NE:
+        case RP_TRIG_SRC_CHB_AE:
+            *channel = 1;
+            break;
+        case RP_TRIG_SRC_CHC_PE:
+        case RP_TRIG_SRC_CHC_NE:
+        case RP_TRIG_SRC_CHC_AE:
+            *channel = 2;
+            break;
+        case RP_TRIG_SRC_CHD_PE:
+        case RP_TRIG_SRC_CHD_NE:
+        case RP_TRIG_SRC_CHD_AE:
+            *channel = 3;
+            break;
+        default:
+            return false;
+    }
+    // 1 - positive, -1 - negative, 0 - any edge
+    if (source >= RP_TRIG_SRC_CHA_AE) {
+        *edge = 0;
+    } else {
+        *edge = (source % 2 == 0) ? 1 : -1;
+    }
+    return true;
+}
+
+// Returns the DAC clocks the generator was moved on with the samples
+auto oscTick(double elapsed_s, volatile generate_control_t* gen) -> uint64_t {
+    auto osc = (volatile osc_control_t*)findRegion(OSC_BASE_ADDR);
+    if (!osc)
+        return 0;
+    auto channels = rp_HPGetFastADCChannelsCountOrDefault();
+    auto osc_4ch = channels == 4 ? (volatile osc_control_t*)findRegion(OSC_BASE_ADDR_4CH) : NULL;
+    auto adc_bits = rp_HPGetFastADCBitsOrDefault();
+    auto dac_bits = rp_HPGetFastDACBitsOrDefault();
+    double fs = rp_HPGetBaseFastADCSpeedHzOrDefault();
+    uint32_t adc_mask = ((uint64_t)1 << adc_bits) - 1;
+    double adc_scale = (double)((1 << (adc_bits - 1)) - 1);
+
+    volatile uint32_t* buffers[4] = {(uint32_t*)((char*)osc + OSC_CHA_OFFSET), (uint32_t*)((char*)osc + OSC_CHB_OFFSET), NULL, NULL};
+    if (osc_4ch) {
+        buffers[2] = (uint32_t*)((char*)osc_4ch + OSC_CHA_OFFSET);
+        buffers[3] = (uint32_t*)((char*)osc_4ch + OSC_CHB_OFFSET);
+    }
+
+    volatile osc_control_t* axi_blocks[4] = {osc, osc, osc_4ch, osc_4ch};
+    emu_axi_regs_t axi[4];
+    uint16_t* axi_mem[4] = {NULL, NULL, NULL, NULL};
+    for (int ch = 0; ch < 4; ch++) {
+        if (axi_blocks[ch])
+            axi[ch] = axiRegs(axi_blocks[ch], ch);
+    }
+
+    config_u_t config;
+    config.reg_full = osc->config;
+    auto& ctrl = config.reg.config_ch[0];
+
+    if (ctrl.reset_state_machine) {
+        g_osc.start_write = false;
+        g_osc.triggered = false;
+        g_osc.wr_ptr = 0;
+        g_osc.pre_trigger = 0;
+        g_osc.post_trigger = 0;
+        osc->wr_ptr_cur = 0;
+        osc->pre_trigger_counter = 0;
+        for (int ch = 0; ch < 4; ch++) {
+            g_osc.axi[ch].active = false;
+            if (buffers[ch])
+                clearBits(axi[ch].state, axi[ch].fill_bit);
+        }
+        // reset_state_machine, trigger_status, all_data_written
+        clearBits(&osc->config, 0x16);
+        return 0;
+    }
+
+    // Arming starts a new acquisition, also without a reset of the state machine
+    if (ctrl.start_write && !g_osc.start_write) {
+        g_osc.triggered = false;
+        g_osc.pre_trigger = 0;
+        g_osc.post_trigger = 0;
+        // trigger_status, all_data_written
+        clearBits(&osc->config, 0x14);
+        for (int ch = 0; ch < 4; ch++) {
+            if (!buffers[ch])
+                continue;
+            auto& state = g_osc.axi[ch];
+            state.active = *axi[ch].enable & AXI_ENABLE_MASK;
+            state.wr = *axi[ch].addr_low;
+            state.post_trigger = 0;
+            *axi[ch].wr_ptr_cur = state.wr;
+            clearBits(axi[ch].state, axi[ch].fill_bit);
+        }
+        config.reg_full = osc->config;
+    }
+    g_osc.start_write = ctrl.start_write;
+
+    bool axi_active = false;
+    for (int ch = 0; ch < 4; ch++) {
+        auto& state = g_osc.axi[ch];
+        if (!buffers[ch] || !state.active)
+            continue;
+        uint32_t low = *axi[ch].addr_low;
+        uint32_t high = *axi[ch].addr_high;
+        axi_mem[ch] = high > low ? findMemory(low, high - low) : NULL;
+        if (!axi_mem[ch] || state.wr < low || state.wr >= high) {
+            // Not mapped or moved while running, the AXI master stalls
+            state.active = false;
+            continue;
+        }
+        axi_active = true;
+    }
+
+    uint32_t dec = osc->data_dec & 0x1FFFF;
+    if (dec == 0)
+        dec = 1;
+    g_osc.sample_acc += elapsed_s * fs / dec;
+    uint32_t samples = (uint32_t)g_osc.sample_acc;
+    g_osc.sample_acc -= samples;
+    if (samples > EMU_MAX_SAMPLES_PER_TICK)
+        samples = EMU_MAX_SAMPLES_PER_TICK;
+
+    bool osc_done = ctrl.all_data_written;
+    if (!ctrl.start_write || (osc_done && !axi_active)) {
+        g_osc.adc_clock += (uint64_t)samples * dec;
+        return 0;
+    }
+
+    uint64_t dac_step = std::max<uint64_t>(1, llround((double)dec * rp_HPGetBaseFastDACSpeedHzOrDefault() / fs));
+    uint64_t played = 0;
+
+    uint32_t delay = osc->trigger_delay;
+    int32_t thresholds[4] = {signExtend(osc->cha_thr, adc_bits), signExtend(osc->chb_thr, adc_bits), 0, 0};
+    if (osc_4ch) {
+        thresholds[2] = signExtend(osc_4ch->cha_thr, adc_bits);
+        thresholds[3] = signExtend(osc_4ch->chb_thr, adc_bits);
+    }
+
+    for (uint32_t i = 0; i < samples; i++) {
+        int32_t values[4];
+        for (int ch = 0; ch < 4; ch++) {
+            if (!buffers[ch])
+                continue;
+            double v = 0;
+            if (!(ch < 2 && gen && genOutput(gen, ch, dac_bits, &v))) {
+                double amplitude = ch < 2 ? 0.5 : 0.25;
+                v = amplitude * sineSample(g_osc.adc_clock, ch, fs);
+            }
+            values[ch] = (int32_t)lround(v * adc_scale);
+            if (!osc_done)
+                buffers[ch][g_osc.wr_ptr] = (uint32_t)values[ch] & adc_mask;
+            if (axi_mem[ch] && g_osc.axi[ch].active)
+                axi_mem[ch][(g_osc.axi[ch].wr - *axi[ch].addr_low) / 2] = (uint16_t)((uint32_t)values[ch] & adc_mask);
+        }
+        g_osc.adc_clock += dec;
+        if (gen) {
+            genAdvance(gen, 0, dac_step);
+            genAdvance(gen, 1, dac_step);
+            played += dac_step;
+        }
+
+        if (!g_osc.triggered) {
+            g_osc.pre_trigger++;
+            trig_source_u_t source;
+            source.reg_full = osc->trig_source;
+            uint32_t src = source.reg[0].trig_source;
+            int trig_ch = 0;
+            int edge = 0;
+            bool fire = false;
+            if (isLevelTrigger(src, &trig_ch, &edge)) {
+                if (buffers[trig_ch]) {
+                    bool rising = g_osc.last[trig_ch] < thresholds[trig_ch] && values[trig_ch] >= thresholds[trig_ch];
+                    bool falling = g_osc.last[trig_ch] > thresholds[trig_ch] && values[trig_ch] <= thresholds[trig_ch];
+                    fire = (edge >= 0 && rising) || (edge <= 0 && falling);
+                }
+            } else if (src != RP_TRIG_SRC_DISABLED) {
+                // Now, external and generator triggers fire at once
+                fire = true;
+            }
+            if (fire) {
+                g_osc.triggered = true;
+                g_osc.post_trigger = 0;
+                osc->wr_ptr_trigger = g_osc.wr_ptr;
+                if (osc_4ch)
+                    osc_4ch->wr_ptr_trigger = g_osc.wr_ptr;
+                uint32_t ts_lo = (uint32_t)g_osc.adc_clock;
+                uint32_t ts_hi = (uint32_t)(g_osc.adc_clock >> 32);
+                for (auto block : {osc, osc_4ch}) {
+                    if (!block)
+                        continue;
+                    block->trig_timestamp_lo_ch1 = ts_lo;
+                    block->trig_timestamp_hi_ch1 = ts_hi;
+                    block->trig_timestamp_lo_ch2 = ts_lo;
+                    block->trig_timestamp_hi_ch2 = ts_hi;
+                }
+                for (int ch = 0; ch < 4; ch++) {
+                    if (axi_mem[ch] && g_osc.axi[ch].active)
+                        *axi[ch].wr_ptr_trigger = g_osc.axi[ch].wr;
+                }
+                clearBits(&osc->trig_source, 0x1F);
+                // trigger_status
+                setBits(&osc->config, 0x04);
+            }
+        }
+        for (int ch = 0; ch < 4; ch++) {
+            if (buffers[ch])
+                g_osc.last[ch] = values[ch];
+        }
+
+        if (!osc_done)
+            g_osc.wr_ptr = (g_osc.wr_ptr + 1) % ADC_BUFFER_SIZE;
+
+        axi_active = false;
+        for (int ch = 0; ch < 4; ch++) {
+            auto& state = g_osc.axi[ch];
+            if (!axi_mem[ch] || !state.active)
+                continue;
+            state.wr += 2;
+            if (state.wr >= *axi[ch].addr_high)
+                state.wr = *axi[ch].addr_low;
+            if (g_osc.triggered && ++state.post_trigger >= *axi[ch].delay) {
+                // ACQ delay has passed, the record is complete
+                state.active = false;
+                setBits(axi[ch].state, axi[ch].fill_bit);
+                continue;
+            }
+            axi_active = true;
+        }
+
+        if (!osc_done && g_osc.triggered && ++g_osc.post_trigger >= delay) {
+            // all_data_written
+            setBits(&osc->config, 0x10);
+            osc_done = true;
+        }
+        if (osc_done && !axi_active) {
+            // start_write is dropped unless arm_keep is set
+            if (!ctrl.arm_keep) {
+                clearBits(&osc->config, 0x01);
+                g_osc.start_write = false;
+            }
+            break;
+        }
+    }
+
+    for (int ch = 0; ch < 4; ch++) {
+        if (axi_mem[ch])
+            *axi[ch].wr_ptr_cur = g_osc.axi[ch].wr;
+    }
+    osc->wr_ptr_cur = g_osc.wr_ptr;
+    osc->pre_trigger_counter = g_osc.pre_trigger;
+    if (osc_4ch) {
+        osc_4ch->wr_ptr_cur = g_osc.wr_ptr;
+        osc_4ch->pre_trigger_counter = g_osc.pre_trigger;
+    }
+    return played;
+}
+
+void modelTick(double elapsed_s) {
+    auto channels = rp_HPGetFastADCChannelsCountOrDefault();
+    auto gen = channels != 4 && rp_HPIsFastDAC_PresentOrDefault() ? (volatile generate_control_t*)findRegion(GENERATE_BASE_ADDR) : NULL;
+    if (gen)
+        genEvents(gen);
+    uint64_t played = oscTick(elapsed_s, gen);
+    if (!gen)
+        return;
+    g_genAcc += elapsed_s * rp_HPGetBaseFastDACSpeedHzOrDefault();
+    auto ticks = (uint64_t)g_genAcc;
+    g_genAcc -= ticks;
+    // While the oscilloscope samples, the generator follows its samples so the loopback stays coherent
+    if (played == 0) {
+        genAdvance(gen, 0, ticks);
+        genAdvance(gen, 1, ticks);
+    }
+}
+
+void modelThread() {
+    auto last = std::chrono::steady_clock::now();
+    auto next = last;
+    while (g_modelRun) {
+        next += std::chrono::microseconds(EMU_TICK_US);
+        std::this_thread::sleep_until(next);
+        auto now = std::chrono::steady_clock::now();
+        modelTick(std::chrono::duration<double>(now - last).count());
+        last = now;
+    }
+}
+
+}  // namespace
+
+bool emu_IsEnabled() {
+    static const bool enabled = [] {
+        auto env = getenv("RP_EMULATION");
+        return env && *env && strcmp(env, "0") != 0;
+    }();
+    return enabled;
+}
+
+int emu_Init() {
+    std::lock_guard lock(g_emuMutex);
+    if (g_modelRun)
+        return RP_OK;
+    g_osc = emu_osc_state_t();
+    g_gen[0] = emu_gen_state_t();
+    g_gen[1] = emu_gen_state_t();
+    g_genAcc = 0;
+    g_genPulses = 0;
+    g_modelRun = true;
+    g_modelThread = std::thread(modelThread);
+    return RP_OK;
+}
+
+int emu_Release() {
+    {
+        std::lock_guard lock(g_emuMutex);
+        if (!g_modelRun)
+            return RP_OK;
+        g_modelRun = false;
+    }
+    if (g_modelThread.joinable())
+        g_modelThread.join();
+
+    // Register blocks still in use keep their memory until the last unmap
+    std::lock_guard lock(g_emuMutex);
+    for (auto it = g_regions.begin(); it != g_regions.end();) {
+        if (it->second.refs == 0) {
+            munmap(it->second.mem, it->second.size);
+            it = g_regions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& it : g_retired) {
+        munmap(it.mem, it.size);
+    }
+    g_retired.clear();
+    return RP_OK;
+}
+
+int emu_Map(size_t size, size_t offset, void** mapped) {
+    std::lock_guard lock(g_emuMutex);
+    auto& region = g_regions[offset];
+    if (region.mem && size > region.size && region.refs == 0) {
+        // AXI buffers are mapped again with another size
+        g_retired.push_back(region);
+        region = emu_region_t();
+    }
+    if (!region.mem) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        region.size = (size + page - 1) / page * page;
+        region.mem = mmap(NULL, region.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region.mem == MAP_FAILED) {
+            g_regions.erase(offset);
+            *mapped = NULL;
+            return RP_EMMD;
+        }
+    } else if (size > region.size) {
+        return RP_EMMD;
+    }
+    region.refs++;
+    *mapped = region.mem;
+    return RP_OK;
+}
+
+int emu_Unmap(size_t size, void** mapped) {
+    if ((mapped == NULL) || (*mapped == NULL)) {
+        return RP_EUMD;
+    }
+    std::lock_guard lock(g_emuMutex);
+    for (auto& it : g_regions) {
+        if (it.second.mem == *mapped) {
+            if (it.second.refs > 0)
+                it.second.refs--;
+            *mapped = NULL;
+            return RP_OK;
+        }
+    }
+    return RP_EUMD;
+}
+
+void emu_SetBits(volatile uint32_t* field, uint32_t bits) {
+    if (field == (volatile uint32_t*)findRegion(GENERATE_BASE_ADDR))
+        g_genPulses.fetch_or(bits);
+}
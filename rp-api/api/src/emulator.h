@@ -0,0 +1,48 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library FPGA emulation interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __EMULATOR_H
+#define __EMULATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EMU_RESERVED_MEMORY_ADDR 0x2000000
+#define EMU_RESERVED_MEMORY_SIZE 0x800000
+
+/**
+ * The emulation backend replaces the UIO register maps with plain process memory, so the API can
+ * run on a machine without FPGA (e.g. x86 CI). It is enabled by setting RP_EMULATION=1 before the
+ * first rp_Init. The board model is taken from RP_EMULATION_MODEL (default STEM_125-14_v1.1).
+ *
+ * A model thread fills the oscilloscope buffers: generator output is looped back to the inputs
+ * while it is enabled, otherwise a fixed sine is sampled. The generator plays its buffer with
+ * amplitude scale and offset after a trigger, bursts with repetitions and period, and holds the
+ * initial and last values around them. Gated bursts and the AXI generator are not modelled.
+ * Write pointer, pre-trigger counter, level and immediate triggers, trigger delay and arm keep
+ * behave like the FPGA in unified mode. Enabled AXI channels write into the reserved memory mapped
+ * by the AXI manager and report fill state, write pointers and trigger timestamps. Arming again
+ * without a state machine reset starts a new acquisition. All other register blocks only keep the
+ * written values.
+ */
+
+bool emu_IsEnabled();
+
+int emu_Init();
+int emu_Release();
+
+int emu_Map(size_t size, size_t offset, void** mapped);
+int emu_Unmap(size_t size, void** mapped);
+
+// Called by cmn_SetBits. The generator reset and software trigger are pulses shorter than a model tick.
+void emu_SetBits(volatile uint32_t* field, uint32_t bits);
+
+#endif  //__EMULATOR_H
@@ -1471,10 +1471,10 @@ int gen_axi_WriteWaveform(rp_channel_t channel, float* data, uint32_t length) {
                 ERROR_LOG("The signal is greater than acceptable. Min %f Max %f", (is_sign ? -fs : 0), fs);
                 return RP_ENN;
             }
-            buffer[i] = cmn_convertToCnt(data[i], bits, 1.0, is_sign, 1, 0);
-            if (i + 1 == length) {
-                g_channels[channel].axiLastValue = data[i];
-            }
+        }
+        cmn_GetConvert(bits, is_sign)->cnts(data, length, bits, buffer);
+        if (length > 0) {
+            g_channels[channel].axiLastValue = data[length - 1];
         }
         if (g_channels[channel].useLastSample) {
             gen_setBurstLastValue(channel, g_channels[channel].burstLastValue);
@@ -1525,10 +1525,10 @@ int gen_axi_WriteWaveform(rp_channel_t channel, uint32_t offset, float* data, ui
                 ERROR_LOG("The signal is greater than acceptable. Min %f Max %f", (is_sign ? -fs : 0), fs);
                 return RP_ENN;
             }
-            buffer[x + offset] = cmn_convertToCnt(data[x], bits, 1.0, is_sign, 1, 0);
-            if (x + 1 == length) {
-                g_channels[channel].axiLastValue = data[x];
-            }
+        }
+        cmn_GetConvert(bits, is_sign)->cnts(data, length, bits, buffer + offset);
+        if (length > 0) {
+            g_channels[channel].axiLastValue = data[length - 1];
         }
         if (g_channels[channel].useLastSample) {
             gen_setBurstLastValue(channel, g_channels[channel].burstLastValue);
@@ -12,12 +12,14 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "common.h"
 #include "convert.hpp"
 
 static volatile generate_control_t* generate = NULL;
 static volatile int32_t* data_ch[2] = {NULL, NULL};
 static volatile uint64_t asg_axi_mem_reserved_index[4] = {0, 0, 0, 0};
+static const cmn_convert_t* g_convert = nullptr;
 
 int generate_Init() {
     int ret = cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void**)&generate);
@@ -26,6 +28,12 @@ int generate_Init() {
     }
     data_ch[0] = (int32_t*)((char*)generate + (CHA_DATA_OFFSET));
     data_ch[1] = (int32_t*)((char*)generate + (CHB_DATA_OFFSET));
+
+    uint8_t bits = 0;
+    bool is_sign = false;
+    if (rp_HPGetFastDACBits(&bits) == RP_HP_OK && rp_HPGetFastDACIsSigned(&is_sign) == RP_HP_OK) {
+        g_convert = cmn_GetConvert(bits, is_sign);
+    }
     return ret;
 }
 
@@ -469,10 +477,15 @@ int generate_writeData(rp_channel_t channel, float* data, int32_t start, uint32_
 
     if (start < 0)
         start += DAC_BUFFER_SIZE;
-    for (int i = start; i < start + DAC_BUFFER_SIZE; i++) {
-        dataOut[i % DAC_BUFFER_SIZE] = cmn_convertToCnt(data[i - start], bits, 1.0, is_sign, 1, 0);
-        dataInFPGA[i % DAC_BUFFER_SIZE] = data[i - start];
-    }
+    start %= DAC_BUFFER_SIZE;
+
+    auto convert = g_convert && g_convert->bits == bits && g_convert->is_signed == is_sign ? g_convert : cmn_GetConvert(bits, is_sign);
+    // The buffer wraps once, the data start at index start
+    uint32_t first = DAC_BUFFER_SIZE - start;
+    convert->cntsV(data, first, bits, dataOut + start);
+    convert->cntsV(data + first, start, bits, dataOut);
+    memcpy(dataInFPGA + start, data, first * sizeof(float));
+    memcpy(dataInFPGA, data + first, start * sizeof(float));
     return RP_OK;
 }
 
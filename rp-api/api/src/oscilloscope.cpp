@@ -20,6 +20,7 @@
 #include <string>
 #include "axi_manager.h"
 #include "common.h"
+#include "emulator.h"
 #include "oscilloscope.h"
 #include "rp.h"
 
@@ -85,6 +86,11 @@ int osc_Init(int channels) {
         osc_chd = (uint32_t*)((char*)osc_reg_4ch + OSC_CHB_OFFSET);
     }
 
+    // No interrupt devices without FPGA, waiting for events returns RP_EANI
+    if (emu_IsEnabled()) {
+        return RP_OK;
+    }
+
     // Init commont uio device
     if (fd_osc_common == -1) {
         if ((fd_osc_common = open("/dev/uio/osc@05000000", O_RDWR | O_SYNC)) == -1) {
@@ -16,6 +16,8 @@
 #include <shared_mutex>
 
 #include "acq_handler.h"
+#include "acq_segmented.h"
+#include "acq_shm.h"
 #include "analog_mixed_signals.h"
 #include "common.h"
 #include "common/version.h"
@@ -25,6 +27,7 @@
 #include "generate.h"
 #include "housekeeping.h"
 #include "oscilloscope.h"
+#include "rp_hw.h"
 #include "rp_hw_calib.h"
 
 #include "rp-i2c-max7311-c.h"
@@ -95,6 +98,9 @@ int rp_InitAddresses() {
         rp_ReleaseUnsafe();
         return ret;
     }
+
+    // Without a profile the readout selects the conversion on every call
+    ECHECK_NO_RET(acq_InitConvert())
     g_api_state = true;
     return RP_OK;
 }
@@ -150,6 +156,7 @@ int rp_ReleaseUnsafe() {
 }
 
 int rp_Release() {
+    acq_seg_Stop();
     std::unique_lock lock(g_initMutex);
     return rp_ReleaseUnsafe();
 }
@@ -236,6 +243,8 @@ const char* rp_GetError(int errorCode) {
             return "Interrupt does not match interrupt status";
         case RP_EID:
             return "Interruptions are disabled in the settings";
+        case RP_EDOW:
+            return "Data overwritten before it was read";
         default:
             return "Unknown error";
     }
@@ -1226,39 +1235,14 @@ int rp_ApinGetRange(rp_apin_t pin, float* min_val, float* max_val) {
 int rp_AIpinGetValueRaw(unsigned int pin, uint32_t* value) {
     if (value == NULL)
         return RP_EPN;
-
-    const char* path;
-    switch (pin) {
-        case 0:
-            path = "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage9_raw";
-            break;
-        case 1:
-            path = "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage11_raw";
-            break;
-        case 2:
-            path = "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage10_raw";
-            break;
-        case 3:
-            path = "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage8_raw";
-            break;
-        case 4:
-            path = "/sys/devices/soc0/axi/83c00000.xadc_wiz/iio:device1/in_voltage12_raw";
-            break;
-        default:
-            return RP_EPN;
-    }
-
-    FILE* fp = fopen(path, "r");
-    if (fp == NULL)
+    if (pin > 4)
         return RP_EPN;
 
-    int ret = 0;
-
-    if (fscanf(fp, "%" SCNu32, value) != 1)
-        ret = RP_EPN;
-
-    fclose(fp);
-    return ret;
+    // rp-hw keeps the XADC attributes open and re-reads them with pread
+    float volts = 0;
+    if (rp_SensorsRead((rp_sensor_t)(RP_SENS_AIN0 + pin), value, &volts) != RP_HW_OK)
+        return RP_EPN;
+    return RP_OK;
 }
 
 int rp_AIpinGetValue(int unsigned pin, float* value, uint32_t* raw) {
@@ -2069,6 +2053,7 @@ int rp_AcqStopCh(rp_channel_t channel) {
 }
 
 int rp_AcqReset() {
+    acq_seg_Stop();
     std::shared_lock lock(g_initMutex);
     std::lock_guard lockACQ(g_acqMutex);
     ECHECK(acq_SetDefaultAll())
@@ -2611,6 +2596,151 @@ int rp_AcqAxiGetOffset(rp_channel_t channel, float* value) {
     return acq_axi_GetOffset(channel, value);
 }
 
+int rp_AcqAxiSegSetup(uint32_t segments, uint32_t samples) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    return acq_seg_Setup(segments, samples);
+}
+
+int rp_AcqAxiSegGetSetup(uint32_t* segments, uint32_t* samples) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    return acq_seg_GetSetup(segments, samples);
+}
+
+int rp_AcqAxiSegSetBuffer(rp_channel_t channel, uint32_t address) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    return acq_seg_SetBuffer(channel, address);
+}
+
+int rp_AcqAxiSegGetBuffer(rp_channel_t channel, uint32_t* address) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    return acq_seg_GetBuffer(channel, address);
+}
+
+int rp_AcqAxiSegStart(rp_acq_trig_src_t source) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    return acq_seg_Start(source);
+}
+
+int rp_AcqAxiSegStop() {
+    // The worker re-arms under the acquisition lock, so it must not be held while joining
+    return acq_seg_Stop();
+}
+
+int rp_AcqAxiSegGetState(uint32_t* captured, bool* running) {
+    return acq_seg_GetState(captured, running);
+}
+
+int rp_AcqAxiSegGetTriggerPos(uint32_t* pos) {
+    return acq_seg_GetTriggerPos(pos);
+}
+
+int rp_AcqAxiSegGetTimestamp(rp_channel_t channel, uint32_t segment, uint64_t* timestamp) {
+    std::shared_lock lock(g_initMutex);
+    return acq_seg_GetTimestamp(channel, segment, timestamp);
+}
+
+int rp_AcqAxiSegGetTimestamps(rp_channel_t channel, std::vector<uint64_t>* timestamps) {
+    std::shared_lock lock(g_initMutex);
+    return acq_seg_GetTimestamps(channel, timestamps);
+}
+
+int rp_AcqAxiSegGetDataRawDirect(rp_channel_t channel, uint32_t first, uint32_t count, std::vector<std::span<int16_t>>* data) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    std::lock_guard lockACQCh(g_acqMutexCh[channel]);
+    return acq_seg_GetDataRawDirect(channel, first, count, data);
+}
+
+int rp_AcqAxiSegGetDataV(rp_channel_t channel, uint32_t segment, uint32_t* size, float* buffer) {
+    if (!rp_HPGetIsDMAinv0_94OrDefault())
+        return RP_NOTS;
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    std::lock_guard lockACQCh(g_acqMutexCh[channel]);
+    return acq_seg_GetDataV(channel, segment, size, buffer);
+}
+
+int rp_AcqAxiSegGetDeadTime(uint64_t* min_ns, uint64_t* max_ns, uint64_t* mean_ns) {
+    return acq_seg_GetDeadTime(min_ns, max_ns, mean_ns);
+}
+
+int rp_AcqShmCreate(const char* name, uint32_t slots) {
+    std::shared_lock lock(g_initMutex);
+    return acq_shm_Create(name, slots);
+}
+
+int rp_AcqShmDestroy() {
+    return acq_shm_Destroy();
+}
+
+int rp_AcqShmPublish(uint64_t* sequence) {
+    std::shared_lock lock(g_initMutex);
+    std::lock_guard lockACQ(g_acqMutex);
+    return acq_shm_Publish(sequence);
+}
+
+// The readers only use the shared memory, they do not need rp_Init
+int rp_AcqShmOpen(const char* name) {
+    return acq_shm_Open(name);
+}
+
+int rp_AcqShmClose() {
+    return acq_shm_Close();
+}
+
+int rp_AcqShmGetLatest(uint64_t* sequence) {
+    return acq_shm_GetLatest(sequence);
+}
+
+int rp_AcqShmWait(uint64_t after, uint32_t timeout_ms, uint64_t* sequence) {
+    return acq_shm_Wait(after, timeout_ms, sequence);
+}
+
+int rp_AcqShmGetFrame(uint64_t sequence, rp_acq_shm_frame_t* frame) {
+    return acq_shm_GetFrame(sequence, frame);
+}
+
+int rp_AcqShmGetDataRawDirect(uint64_t sequence, rp_channel_t channel, std::span<const int16_t>* data) {
+    return acq_shm_GetDataRawDirect(sequence, channel, data);
+}
+
+int rp_AcqShmIsValid(uint64_t sequence, bool* valid) {
+    return acq_shm_IsValid(sequence, valid);
+}
+
+int rp_AcqShmGetDataRaw(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer) {
+    return acq_shm_GetDataRaw(sequence, channel, pos, size, buffer);
+}
+
+int rp_AcqShmGetDataRawNP(uint64_t sequence, rp_channel_t channel, uint32_t pos, int16_t* np_buffer, int size) {
+    uint32_t usize = size;
+    return acq_shm_GetDataRaw(sequence, channel, pos, &usize, np_buffer);
+}
+
+int rp_AcqShmGetDataV(uint64_t sequence, rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer) {
+    return acq_shm_GetDataV(sequence, channel, pos, size, buffer);
+}
+
+int rp_AcqShmGetDataVNP(uint64_t sequence, rp_channel_t channel, uint32_t pos, float* np_buffer, int size) {
+    uint32_t usize = size;
+    return acq_shm_GetDataV(sequence, channel, pos, &usize, np_buffer);
+}
+
 /**
 * Generate methods
 */
@@ -49,6 +49,8 @@
 %apply bool *OUTPUT { bool * state };
 %apply bool *OUTPUT { bool * enable };
 %apply bool *OUTPUT { bool * value };
+%apply bool *OUTPUT { bool * running };
+%apply bool *OUTPUT { bool * valid };
 
 %apply float *OUTPUT { float *value };
 %apply float *OUTPUT { float *min_val };
@@ -85,6 +87,10 @@
 %apply unsigned int *OUTPUT { uint32_t *_start };
 %apply unsigned int *OUTPUT { uint32_t *_size };
 %apply unsigned int *OUTPUT { uint32_t *size_out };
+%apply unsigned int *OUTPUT { uint32_t *segments };
+%apply unsigned int *OUTPUT { uint32_t *samples };
+%apply unsigned int *OUTPUT { uint32_t *address };
+%apply unsigned int *OUTPUT { uint32_t *captured };
 
 %apply unsigned int *INOUT { uint32_t *size };
 %apply unsigned int *INOUT { uint32_t *buffer_size };
@@ -92,6 +98,11 @@
 %apply unsigned long long *OUTPUT { uint64_t *dna };
 %apply long long *OUTPUT { int64_t *time_ns };
 %apply unsigned long long *OUTPUT { uint64_t *time_ns };
+%apply unsigned long long *OUTPUT { uint64_t *timestamp };
+%apply unsigned long long *OUTPUT { uint64_t *min_ns };
+%apply unsigned long long *OUTPUT { uint64_t *max_ns };
+%apply unsigned long long *OUTPUT { uint64_t *mean_ns };
+%apply unsigned long long *OUTPUT { uint64_t *sequence };
 
 %apply int *OUTPUT { int * num };
 %apply int *OUTPUT { int * repetitions };
@@ -131,6 +142,18 @@
   $result = SWIG_Python_AppendOutput($result, pyList);
 }
 
+%typemap(in, numinputs=0) std::vector<uint64_t>* timestamps (std::vector<uint64_t> temp) {
+  $1 = &temp;
+}
+
+%typemap(argout) std::vector<uint64_t>* timestamps {
+  PyObject* pyList = PyList_New($1->size());
+  for (size_t i = 0; i < $1->size(); ++i) {
+    PyList_SET_ITEM(pyList, i, PyLong_FromUnsignedLongLong((*$1)[i]));
+  }
+  $result = SWIG_Python_AppendOutput($result, pyList);
+}
+
 %include "numpy.i"
 
 %init %{
@@ -151,4 +174,5 @@ import_array();
 %include "rp_gen.h"
 %include "rp_acq.h"
 %include "rp_acq_axi.h"
+%include "rp_acq_shm.h"
 %include "rp_asg_axi.h"
\ No newline at end of file
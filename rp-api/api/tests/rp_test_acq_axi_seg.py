@@ -0,0 +1,62 @@
+#!/usr/bin/python3
+
+# Segmented AXI acquisition: every trigger fills the next record of the buffer.
+# Runs on the board, or on the FPGA emulation backend with RP_EMULATION=1.
+# Usage: rp_test_acq_axi_seg.py [segments] [samples]
+
+import sys
+import time
+import rp
+
+segments = int(sys.argv[1]) if len(sys.argv) > 1 else 16
+samples = int(sys.argv[2]) if len(sys.argv) > 2 else 1024
+
+print("rp.rp_Init()")
+res = rp.rp_Init()
+print(res)
+if res != rp.RP_OK:
+    sys.exit(1)
+
+res = rp.rp_AcqAxiGetMemoryRegion()
+start = res[1]
+
+print("rp.rp_AcqAxiSegSetup(%d, %d)" % (segments, samples))
+print(rp.rp_AcqAxiSegSetup(segments, samples))
+print("rp.rp_AcqAxiSegGetSetup()")
+print(rp.rp_AcqAxiSegGetSetup())
+
+print("rp.rp_AcqAxiSegSetBuffer(rp.RP_CH_1, start)")
+print(rp.rp_AcqAxiSegSetBuffer(rp.RP_CH_1, start))
+print("rp.rp_AcqAxiSetTriggerDelay(rp.RP_CH_1, %d)" % (samples // 2))
+print(rp.rp_AcqAxiSetTriggerDelay(rp.RP_CH_1, samples // 2))
+
+print("rp.rp_AcqAxiSegStart(rp.RP_TRIG_SRC_NOW)")
+print(rp.rp_AcqAxiSegStart(rp.RP_TRIG_SRC_NOW))
+
+deadline = time.monotonic() + 5
+while True:
+    res = rp.rp_AcqAxiSegGetState()
+    if not res[2] or time.monotonic() > deadline:
+        break
+    time.sleep(0.001)
+print("rp.rp_AcqAxiSegGetState()")
+print(res)
+
+print("rp.rp_AcqAxiSegGetTriggerPos()")
+print(rp.rp_AcqAxiSegGetTriggerPos())
+
+res = rp.rp_AcqAxiSegGetTimestamps(rp.RP_CH_1)
+timestamps = res[1]
+print("Timestamps, ns:", timestamps)
+gaps = [b - a for a, b in zip(timestamps, timestamps[1:])]
+print("Timestamps increase:", all(g > 0 for g in gaps))
+
+# Time from the end of one record to the trigger of the next, taken in software around the re-arm
+print("rp.rp_AcqAxiSegGetDeadTime()")
+print(rp.rp_AcqAxiSegGetDeadTime())
+
+print("rp.rp_AcqAxiSegStop()")
+print(rp.rp_AcqAxiSegStop())
+
+print("rp.rp_Release()")
+print(rp.rp_Release())
@@ -0,0 +1,67 @@
+#!/usr/bin/python3
+
+# Publishes captures into the shared memory ring and reads them back like a second process would.
+# Runs on the board without acq_broker, or on the FPGA emulation backend with RP_EMULATION=1.
+# Usage: rp_test_acq_shm.py [captures]
+
+import struct
+import sys
+import numpy as np
+import rp
+
+captures = int(sys.argv[1]) if len(sys.argv) > 1 else 5
+name = "/rp_acq_test"
+
+print("rp.rp_Init()")
+res = rp.rp_Init()
+print(res)
+if res != rp.RP_OK:
+    sys.exit(1)
+
+print("rp.rp_AcqShmCreate(name, 3)")
+print(rp.rp_AcqShmCreate(name, 3))
+print("rp.rp_AcqShmOpen(name)")
+print(rp.rp_AcqShmOpen(name))
+
+volts = np.zeros(16384, dtype=np.float32)
+shm_volts = np.zeros(16384, dtype=np.float32)
+for i in range(captures):
+    rp.rp_AcqReset()
+    rp.rp_AcqSetDecimation(rp.RP_DEC_8)
+    rp.rp_AcqStart()
+    rp.rp_AcqSetTriggerSrc(rp.RP_TRIG_SRC_NOW)
+    while not rp.rp_AcqGetBufferFillState()[1]:
+        pass
+    res = rp.rp_AcqShmPublish()
+    seq = res[1]
+    rp.rp_AcqGetOldestDataVNP(rp.RP_CH_1, volts)
+    res = rp.rp_AcqShmGetDataVNP(seq, rp.RP_CH_1, 0, shm_volts)
+    print("Capture %d: %s, same volts as rp_AcqGetOldestDataV: %s" % (seq, rp.rp_GetError(res), bool(np.array_equal(volts, shm_volts))))
+
+print("rp.rp_AcqShmGetLatest()")
+print(rp.rp_AcqShmGetLatest())
+
+frame = rp.rp_acq_shm_frame_t()
+print("rp.rp_AcqShmGetFrame(seq, frame)")
+print(rp.rp_AcqShmGetFrame(seq, frame))
+print("Samples %d, trigger index %d, decimation %d" % (frame.samples, frame.trigger_index, frame.decimation))
+
+# Three slots, the first capture is overwritten
+print("rp.rp_AcqShmIsValid(1)")
+print(rp.rp_AcqShmIsValid(1))
+
+print("rp.rp_AcqShmClose()")
+print(rp.rp_AcqShmClose())
+
+# Rings with a forged header are refused before any slot is mapped
+forged = "/rp_acq_forged"
+for slots, samples, slot_size in [(0, 16384, 131200), (3, 16384, 64), (3, 16384, 131200)]:
+    with open("/dev/shm" + forged, "wb") as f:
+        f.write(struct.pack("<6I", 0x51415052, 1, slots, samples, slot_size, 0).ljust(64 + 4096, b"\0"))
+    print("Forged ring slots %d, slot size %d: %s" % (slots, slot_size, rp.rp_GetError(rp.rp_AcqShmOpen(forged))))
+rp.rp_AcqShmClose()
+
+print("rp.rp_AcqShmDestroy()")
+print(rp.rp_AcqShmDestroy())
+print("rp.rp_Release()")
+print(rp.rp_Release())
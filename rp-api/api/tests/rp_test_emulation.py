@@ -0,0 +1,55 @@
+#!/usr/bin/python3
+
+# Runs a generator to oscilloscope loopback acquisition on the FPGA emulation backend.
+# Does not need a board, so it can run on a host CI machine.
+# Usage: rp_test_emulation.py [iterations]
+
+import os
+import sys
+import time
+import numpy as np
+
+os.environ["RP_EMULATION"] = "1"
+import rp
+
+iterations = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+
+print("rp.rp_Init()")
+res = rp.rp_Init()
+print(res)
+if res != rp.RP_OK:
+    sys.exit(1)
+
+print("rp.rp_GenWaveform(rp.RP_CH_1, rp.RP_WAVEFORM_SINE)")
+print(rp.rp_GenWaveform(rp.RP_CH_1, rp.RP_WAVEFORM_SINE))
+print(rp.rp_GenFreq(rp.RP_CH_1, 100000))
+print(rp.rp_GenAmp(rp.RP_CH_1, 0.8))
+print(rp.rp_GenOutEnable(rp.RP_CH_1))
+print(rp.rp_GenTriggerOnly(rp.RP_CH_1))
+
+arr_f = np.zeros(16384, dtype=np.float32)
+latency = []
+for i in range(iterations):
+    rp.rp_AcqReset()
+    rp.rp_AcqSetDecimation(rp.RP_DEC_8)
+    rp.rp_AcqSetTriggerLevel(rp.RP_T_CH_1, 0.1)
+    rp.rp_AcqSetTriggerDelay(0)
+    start = time.monotonic()
+    rp.rp_AcqStart()
+    rp.rp_AcqSetTriggerSrc(rp.RP_TRIG_SRC_CHA_PE)
+    while rp.rp_AcqGetTriggerState()[1] != rp.RP_TRIG_STATE_TRIGGERED:
+        pass
+    while not rp.rp_AcqGetBufferFillState()[1]:
+        pass
+    latency.append(time.monotonic() - start)
+    rp.rp_AcqGetOldestDataVNP(rp.RP_CH_1, arr_f)
+
+# Trigger is in the middle of the buffer with zero delay
+mid = len(arr_f) // 2
+print("Samples around trigger:", arr_f[mid - 2:mid + 3])
+print("Rising edge at trigger:", bool(arr_f[mid - 2] < 0.1 <= arr_f[mid + 2]))
+print("Amplitude: %.3f" % (np.max(arr_f) - np.min(arr_f)))
+print("Acquisition latency: avg %.2f ms max %.2f ms" % (np.mean(latency) * 1000, np.max(latency) * 1000))
+
+print("rp.rp_Release()")
+print(rp.rp_Release())
@@ -0,0 +1,46 @@
+#!/usr/bin/python3
+
+# Startup time of rp_Init in a fresh process, with and without the EEPROM snapshot.
+# Each sample is a new interpreter, so nothing survives between runs except the snapshot in /dev/shm.
+
+import subprocess
+import sys
+import rp_hw_profiles
+
+RUNS = 20
+
+CHILD = """
+import time
+import rp
+t = time.perf_counter()
+rp.rp_Init()
+print(time.perf_counter() - t)
+rp.rp_Release()
+"""
+
+def run_child():
+    out = subprocess.run([sys.executable, "-c", CHILD], capture_output=True, text=True, check=True)
+    return float(out.stdout.strip().splitlines()[-1])
+
+def stats(name, values):
+    values = sorted(values)
+    mean = sum(values) / len(values)
+    print(f"{name:8s} min {values[0] * 1000:8.3f} ms  median {values[len(values) // 2] * 1000:8.3f} ms  mean {mean * 1000:8.3f} ms  max {values[-1] * 1000:8.3f} ms")
+
+def test_init_time():
+    cold = []
+    for _ in range(RUNS):
+        rp_hw_profiles.rp_HPResetEEPROMSnapshot()
+        cold.append(run_child())
+
+    warm = []
+    run_child()
+    for _ in range(RUNS):
+        warm.append(run_child())
+
+    print()
+    stats("cold", cold)
+    stats("warm", warm)
+
+if __name__ == "__main__":
+    test_init_time()
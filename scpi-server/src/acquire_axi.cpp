@@ -369,4 +369,257 @@ scpi_result_t RP_AcqAxiSetAddres(scpi_t* context) {
     }
     RP_LOG_INFO("%s", rp_GetError(result))
     return SCPI_RES_OK;
-}
\ No newline at end of file
+}
+scpi_result_t RP_AcqAxiSegSetup(scpi_t* context) {
+    uint32_t segments = 0, samples = 0;
+    /* Parse SEGMENTS parameter */
+    if (!SCPI_ParamUInt32(context, &segments, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing SEGMENTS parameter.");
+        return SCPI_RES_ERR;
+    }
+    /* Parse SAMPLES parameter */
+    if (!SCPI_ParamUInt32(context, &samples, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing SAMPLES parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rp_AcqAxiSegSetup(segments, samples);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set segments: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegSetupQ(scpi_t* context) {
+    uint32_t segments = 0, samples = 0;
+    auto result = rp_AcqAxiSegGetSetup(&segments, &samples);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get segments: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, segments, 10);
+    SCPI_ResultUInt32Base(context, samples, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegBuffer(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        return SCPI_RES_ERR;
+    }
+    uint32_t address = 0;
+    /* Parse ADDRESS parameter */
+    if (!SCPI_ParamUInt32(context, &address, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing ADDRESS parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rp_AcqAxiSegSetBuffer(channel, address);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set segment buffer: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegBufferQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    uint32_t address = 0;
+    auto result = rp_AcqAxiSegGetBuffer(channel, &address);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get segment buffer: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, address, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegStart(scpi_t* context) {
+    int32_t trig_src = 0;
+    /* Read TRIGGER SOURCE parameter */
+    if (!SCPI_ParamChoice(context, scpi_RpTrigSrc, &trig_src, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rp_AcqAxiSegStart((rp_acq_trig_src_t)trig_src);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to start segmented acquisition: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegStop(scpi_t* context) {
+    auto result = rp_AcqAxiSegStop();
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to stop segmented acquisition: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegCountQ(scpi_t* context) {
+    uint32_t captured = 0;
+    bool running = false;
+    auto result = rp_AcqAxiSegGetState(&captured, &running);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get captured segments: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, captured, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegRunQ(scpi_t* context) {
+    uint32_t captured = 0;
+    bool running = false;
+    auto result = rp_AcqAxiSegGetState(&captured, &running);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get segmented acquisition state: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultBool(context, running);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegTriggerPosQ(scpi_t* context) {
+    uint32_t pos = 0;
+    auto result = rp_AcqAxiSegGetTriggerPos(&pos);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get segment trigger position: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, pos, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegTimeStampQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    std::vector<uint64_t> timestamps;
+    auto result = rp_AcqAxiSegGetTimestamps(channel, &timestamps);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get segment timestamps: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    for (auto value : timestamps) {
+        SCPI_ResultUInt64Base(context, value, 10);
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegDeadTimeQ(scpi_t* context) {
+    uint64_t min_ns = 0, max_ns = 0, mean_ns = 0;
+    auto result = rp_AcqAxiSegGetDeadTime(&min_ns, &max_ns, &mean_ns);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get dead time: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt64Base(context, min_ns, 10);
+    SCPI_ResultUInt64Base(context, max_ns, 10);
+    SCPI_ResultUInt64Base(context, mean_ns, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAxiSegDataQ(scpi_t* context) {
+    uint32_t first = 0, count = 0;
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    /* Parse FIRST parameter */
+    if (!SCPI_ParamUInt32(context, &first, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing FIRST parameter.");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    /* Parse COUNT parameter */
+    if (!SCPI_ParamUInt32(context, &count, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing COUNT parameter.");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    auto result = 0;
+    bool error = false;
+    if (axi_unit == RP_SCPI_VOLTS) {
+        uint32_t segments = 0, samples = 0;
+        rp_AcqAxiSegGetSetup(&segments, &samples);
+        std::vector<float> buffer;
+        try {
+            buffer.resize((size_t)count * samples);
+        } catch (const std::bad_alloc&) {
+            SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed allocate buffer");
+            if (getRetOnError())
+                requestSendNewLine(context);
+            return SCPI_RES_ERR;
+        };
+        // The records are sent one after the other in a single block
+        for (uint32_t i = 0; i < count && result == RP_OK; i++) {
+            uint32_t size = samples;
+            result = rp_AcqAxiSegGetDataV(channel, first + i, &size, buffer.data() + (size_t)i * samples);
+        }
+        if (result != RP_OK) {
+            RP_LOG_CRIT("Failed to get data in volts: %s", rp_GetError(result));
+            if (getRetOnError())
+                requestSendNewLine(context);
+            return SCPI_RES_ERR;
+        }
+        SCPI_ResultBufferFloat(context, buffer.data(), buffer.size(), &error);
+    } else {
+        // Raw samples go out of DDR without a copy, a record may be two spans when it wraps
+        std::vector<std::span<int16_t>> buffer;
+        result = rp_AcqAxiSegGetDataRawDirect(channel, first, count, &buffer);
+        if (result != RP_OK) {
+            RP_LOG_CRIT("Failed to get raw data: %s", rp_GetError(result));
+            if (getRetOnError())
+                requestSendNewLine(context);
+            return SCPI_RES_ERR;
+        }
+        SCPI_ResultBufferSpanInt16(context, &buffer, &error);
+    }
+    if (error) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed to send data");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
@@ -35,6 +35,19 @@ scpi_result_t RP_AcqAxiDataQ(scpi_t *context);
 scpi_result_t RP_AcqAxiScpiDataUnits(scpi_t *context);
 scpi_result_t RP_AcqAxiScpiDataUnitsQ(scpi_t *context);
 
+scpi_result_t RP_AcqAxiSegSetup(scpi_t *context);
+scpi_result_t RP_AcqAxiSegSetupQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegBuffer(scpi_t *context);
+scpi_result_t RP_AcqAxiSegBufferQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegStart(scpi_t *context);
+scpi_result_t RP_AcqAxiSegStop(scpi_t *context);
+scpi_result_t RP_AcqAxiSegCountQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegRunQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegTriggerPosQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegTimeStampQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegDeadTimeQ(scpi_t *context);
+scpi_result_t RP_AcqAxiSegDataQ(scpi_t *context);
+
 
 
 #endif /* ACQUIRE_AXI_H_ */
@@ -663,4 +663,138 @@ scpi_result_t RP_CAN_ShowErrorFrames(scpi_t* context) {
 
     RP_LOG_INFO("%s", rp_CanGetError(result))
     return SCPI_RES_OK;
-}
\ No newline at end of file
+}
+
+scpi_result_t RP_CAN_CaptureStart(scpi_t* context) {
+    auto itf = RP_CAN_0;
+    if (!parseInterface(context, &itf)) {
+        return SCPI_RES_ERR;
+    }
+    uint32_t value = 0;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rp_CanCaptureStart(itf, value);
+    if (RP_HW_CAN_OK != result) {
+        RP_LOG_CRIT("%s", rp_CanGetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_CanGetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_CAN_CaptureStop(scpi_t* context) {
+    auto itf = RP_CAN_0;
+    if (!parseInterface(context, &itf)) {
+        return SCPI_RES_ERR;
+    }
+    auto result = rp_CanCaptureStop(itf);
+    if (RP_HW_CAN_OK != result) {
+        RP_LOG_CRIT("%s", rp_CanGetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_CanGetError(result))
+    return SCPI_RES_OK;
+}
+
+/* Returns the number of frames followed by a block of rp_can_capture_frame_t records */
+scpi_result_t RP_CAN_CaptureReadQ(scpi_t* context) {
+    static const uint32_t max_frames = 4096;
+    bool isTimeout = strstr(context->param_list.cmd_raw.data, ":T") != NULL;
+    int paramCount = isTimeout ? 2 : 1;
+    int32_t cmd[2] = {0, 0};
+    bool error = false;
+    if (!SCPI_CommandNumbers(context, cmd, paramCount, -1)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Failed to get parameters.");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    if (cmd[0] == -1) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Failed to get interface number.");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    if (cmd[1] == -1 && isTimeout) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Failed to get timeout.");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    uint32_t count = max_frames;
+    if (!SCPI_ParamUInt32(context, &count, false)) {
+        count = max_frames;
+    }
+    if (count > max_frames) {
+        count = max_frames;
+    }
+    auto interface = (rp_can_interface_t)cmd[0];
+    uint32_t timeout = isTimeout ? cmd[1] : 0;
+    static rp_can_capture_frame_t frames[max_frames];
+    auto result = rp_CanCaptureRead(interface, timeout, frames, &count);
+    if (RP_HW_CAN_OK != result && RP_HW_CAN_ESTE != result) {
+        RP_LOG_CRIT("%s", rp_CanGetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, count, 10);
+    SCPI_ResultBufferUInt8(context, reinterpret_cast<uint8_t*>(frames), count * sizeof(rp_can_capture_frame_t), &error);
+    if (error) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed to send data");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_CanGetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_CAN_CaptureStatsQ(scpi_t* context) {
+    auto itf = RP_CAN_0;
+    if (!parseInterface(context, &itf)) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    rp_can_capture_stats_t stats;
+    auto result = rp_CanCaptureGetStats(itf, &stats);
+    if (RP_HW_CAN_OK != result) {
+        RP_LOG_CRIT("%s", rp_CanGetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt64Base(context, stats.received, 10);
+    SCPI_ResultUInt64Base(context, stats.dropped_ring, 10);
+    SCPI_ResultUInt64Base(context, stats.dropped_socket, 10);
+    SCPI_ResultUInt64Base(context, stats.hw_timestamped, 10);
+    RP_LOG_INFO("%s", rp_CanGetError(result))
+    return SCPI_RES_OK;
+}
+
+/* Takes a block of rp_can_capture_frame_t records. With :Timing frames are sent with their recorded spacing */
+scpi_result_t RP_CAN_SendBurst(scpi_t* context) {
+    static const uint32_t max_frames = 4096;
+    bool keepTiming = strstr(context->param_list.cmd_raw.data, ":T") != NULL;
+    auto itf = RP_CAN_0;
+    if (!parseInterface(context, &itf)) {
+        return SCPI_RES_ERR;
+    }
+    static rp_can_capture_frame_t frames[max_frames];
+    uint32_t buf_size = sizeof(frames);
+    if (!SCPI_ParamBufferUInt8(context, reinterpret_cast<uint8_t*>(frames), &buf_size, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed get data.")
+        return SCPI_RES_ERR;
+    }
+    uint32_t sent = 0;
+    auto result = rp_CanSendBurst(itf, frames, buf_size / sizeof(rp_can_capture_frame_t), keepTiming, 1000, &sent);
+    if (RP_HW_CAN_OK != result) {
+        RP_LOG_CRIT("%s. Sent %d frames", rp_CanGetError(result), sent);
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_CanGetError(result))
+    return SCPI_RES_OK;
+}
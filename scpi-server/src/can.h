@@ -53,5 +53,11 @@ scpi_result_t RP_CAN_SetFilter(scpi_t * context);
 
 scpi_result_t RP_CAN_ShowErrorFrames(scpi_t * context);
 
+scpi_result_t RP_CAN_CaptureStart(scpi_t * context);
+scpi_result_t RP_CAN_CaptureStop(scpi_t * context);
+scpi_result_t RP_CAN_CaptureReadQ(scpi_t * context);
+scpi_result_t RP_CAN_CaptureStatsQ(scpi_t * context);
+scpi_result_t RP_CAN_SendBurst(scpi_t * context);
+
 
 #endif /* SCPI_CAN_H_ */
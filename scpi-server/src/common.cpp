@@ -19,6 +19,8 @@
 #include "common/rp_sweep.h"
 #include "error.h"
 #include "lcr.h"
+#include "spectrogram.h"
+#include "spectrum.h"
 #include "scpi/parser.h"
 #include "scpi/units.h"
 
@@ -402,4 +404,8 @@ void stopAllThreads(scpi_t* context) {
     RP_LOG_INFO("%s", "Stopping the sweep generation service")
     stopLCR();
     RP_LOG_INFO("%s", "Stopping the lcr service")
+    stopSpecGram();
+    RP_LOG_INFO("%s", "Stopping the spectrogram service")
+    stopSpectrum();
+    RP_LOG_INFO("%s", "Stopping the spectrum service")
 }
@@ -382,4 +382,106 @@ scpi_result_t RP_LCRCheckExtensionModuleConnectioQ(scpi_t* context) {
     SCPI_ResultBool(context, state);
     RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
     return SCPI_RES_OK;
-}
\ No newline at end of file
+}
+scpi_result_t RP_LCRLockIn(scpi_t* context) {
+    bool state = false;
+    if (!SCPI_ParamBool(context, &state, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = lcrApp_LcrSetLockIn(state);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to set lock-in mode: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInQ(scpi_t* context) {
+    bool state = false;
+    auto result = lcrApp_LcrGetLockIn(&state);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to get lock-in mode: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultBool(context, state);
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInTimeConstant(scpi_t* context) {
+    scpi_number_t tau;
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &tau, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = lcrApp_LcrSetLockInTimeConstant(tau.content.value);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to set lock-in time constant: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInTimeConstantQ(scpi_t* context) {
+    float tau = 0;
+    auto result = lcrApp_LcrGetLockInTimeConstant(&tau);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to get lock-in time constant: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultFloat(context, tau);
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInRate(scpi_t* context) {
+    scpi_number_t rate;
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &rate, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = lcrApp_LcrSetLockInRate(rate.content.value);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to set lock-in output rate: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInRateQ(scpi_t* context) {
+    float rate = 0;
+    auto result = lcrApp_LcrGetLockInRate(&rate);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to get lock-in output rate: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultFloat(context, rate);
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_LCRLockInStatQ(scpi_t* context) {
+    uint64_t outputs = 0;
+    uint64_t dropped = 0;
+    auto result = lcrApp_LcrGetLockInStat(&outputs, &dropped);
+    if (result != RP_LCR_OK) {
+        RP_LOG_CRIT("Failed to get lock-in statistics: %s", lcrApp_LcrGetError((lcr_error_t)result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt64Base(context, outputs, 10);
+    SCPI_ResultUInt64Base(context, dropped, 10);
+    RP_LOG_INFO("%s", lcrApp_LcrGetError((lcr_error_t)result))
+    return SCPI_RES_OK;
+}
@@ -48,4 +48,12 @@ scpi_result_t RP_LCRMeasSeriesQ(scpi_t * context);
 
 scpi_result_t RP_LCRCheckExtensionModuleConnectioQ(scpi_t * context);
 
+scpi_result_t RP_LCRLockIn(scpi_t * context);
+scpi_result_t RP_LCRLockInQ(scpi_t * context);
+scpi_result_t RP_LCRLockInTimeConstant(scpi_t * context);
+scpi_result_t RP_LCRLockInTimeConstantQ(scpi_t * context);
+scpi_result_t RP_LCRLockInRate(scpi_t * context);
+scpi_result_t RP_LCRLockInRateQ(scpi_t * context);
+scpi_result_t RP_LCRLockInStatQ(scpi_t * context);
+
 #endif /* LCR_H */
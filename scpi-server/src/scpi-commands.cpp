@@ -27,6 +27,8 @@
 #include "i2c.h"
 #include "lcr.h"
 #include "led.h"
+#include "spectrogram.h"
+#include "spectrum.h"
 #include "spi.h"
 #include "sweep.h"
 #include "uart.h"
@@ -246,6 +248,18 @@ static const scpi_command_t scpi_commands[] = {
     SCPI_CMD("ACQ:AXI:SOUR#:DATA:Start:N?", RP_AcqAxiDataQ),
     SCPI_CMD("ACQ:AXI:SOUR#:DATA:STArt:N?", RP_AcqAxiDataQ),
     SCPI_CMD("ACQ:AXI:SOUR#:SET:Buffer", RP_AcqAxiSetAddres),
+    SCPI_CMD("ACQ:AXI:SEG:SETup", RP_AcqAxiSegSetup),
+    SCPI_CMD("ACQ:AXI:SEG:SETup?", RP_AcqAxiSegSetupQ),
+    SCPI_CMD("ACQ:AXI:SEG:STARt", RP_AcqAxiSegStart),
+    SCPI_CMD("ACQ:AXI:SEG:STOP", RP_AcqAxiSegStop),
+    SCPI_CMD("ACQ:AXI:SEG:COUNT?", RP_AcqAxiSegCountQ),
+    SCPI_CMD("ACQ:AXI:SEG:RUN?", RP_AcqAxiSegRunQ),
+    SCPI_CMD("ACQ:AXI:SEG:Trig:Pos?", RP_AcqAxiSegTriggerPosQ),
+    SCPI_CMD("ACQ:AXI:SEG:DEADtime?", RP_AcqAxiSegDeadTimeQ),
+    SCPI_CMD("ACQ:AXI:SOUR#:SEG:Buffer", RP_AcqAxiSegBuffer),
+    SCPI_CMD("ACQ:AXI:SOUR#:SEG:Buffer?", RP_AcqAxiSegBufferQ),
+    SCPI_CMD("ACQ:AXI:SOUR#:SEG:TS?", RP_AcqAxiSegTimeStampQ),
+    SCPI_CMD("ACQ:AXI:SOUR#:SEG:DATA?", RP_AcqAxiSegDataQ),
 
     SCPI_CMD("ACQ:SOUR#:COUP", RP_AcqAC_DC),
     SCPI_CMD("ACQ:SOUR#:COUP?", RP_AcqAC_DCQ),
@@ -454,6 +468,13 @@ static const scpi_command_t scpi_commands[] = {
     SCPI_CMD("CAN#:Filter:Clear", RP_CAN_ClearFilter),
     SCPI_CMD("CAN#:Filter:Set", RP_CAN_SetFilter),
     SCPI_CMD("CAN#:SHOW:ERROR", RP_CAN_ShowErrorFrames),
+    SCPI_CMD("CAN#:CAPture:START", RP_CAN_CaptureStart),
+    SCPI_CMD("CAN#:CAPture:STOP", RP_CAN_CaptureStop),
+    SCPI_CMD("CAN#:CAPture:Read?", RP_CAN_CaptureReadQ),
+    SCPI_CMD("CAN#:CAPture:Read:Timeout#?", RP_CAN_CaptureReadQ),
+    SCPI_CMD("CAN#:CAPture:STATS?", RP_CAN_CaptureStatsQ),
+    SCPI_CMD("CAN#:Send:BURST", RP_CAN_SendBurst),
+    SCPI_CMD("CAN#:Send:BURST:Timing", RP_CAN_SendBurst),
 
     /* LCR */
     SCPI_CMD("LCR:START", RP_LCRStart),
@@ -477,6 +498,43 @@ static const scpi_command_t scpi_commands[] = {
     SCPI_CMD("LCR:CIRCUIT", RP_LCRMeasSeries),
     SCPI_CMD("LCR:CIRCUIT?", RP_LCRMeasSeriesQ),
     SCPI_CMD("LCR:EXT:MODULE?", RP_LCRCheckExtensionModuleConnectioQ),
+    SCPI_CMD("LCR:LOCKIN", RP_LCRLockIn),
+    SCPI_CMD("LCR:LOCKIN?", RP_LCRLockInQ),
+    SCPI_CMD("LCR:LOCKIN:TC", RP_LCRLockInTimeConstant),
+    SCPI_CMD("LCR:LOCKIN:TC?", RP_LCRLockInTimeConstantQ),
+    SCPI_CMD("LCR:LOCKIN:RATE", RP_LCRLockInRate),
+    SCPI_CMD("LCR:LOCKIN:RATE?", RP_LCRLockInRateQ),
+    SCPI_CMD("LCR:LOCKIN:STAT?", RP_LCRLockInStatQ),
+
+    /* Spectrogram */
+    SCPI_CMD("SPECGRAM:START", RP_SpecGramStart),
+    SCPI_CMD("SPECGRAM:STOP", RP_SpecGramStop),
+    SCPI_CMD("SPECGRAM:STATE?", RP_SpecGramStateQ),
+    SCPI_CMD("SPECGRAM:CH#:STATE", RP_SpecGramChState),
+    SCPI_CMD("SPECGRAM:CH#:STATE?", RP_SpecGramChStateQ),
+    SCPI_CMD("SPECGRAM:FFT:SIZE", RP_SpecGramFFTSize),
+    SCPI_CMD("SPECGRAM:FFT:SIZE?", RP_SpecGramFFTSizeQ),
+    SCPI_CMD("SPECGRAM:OVERLAP", RP_SpecGramOverlap),
+    SCPI_CMD("SPECGRAM:OVERLAP?", RP_SpecGramOverlapQ),
+    SCPI_CMD("SPECGRAM:DEC", RP_SpecGramDecimation),
+    SCPI_CMD("SPECGRAM:DEC?", RP_SpecGramDecimationQ),
+    SCPI_CMD("SPECGRAM:WINDOW", RP_SpecGramWindow),
+    SCPI_CMD("SPECGRAM:WINDOW?", RP_SpecGramWindowQ),
+    SCPI_CMD("SPECGRAM:HISTORY:DEPTH", RP_SpecGramHistoryDepth),
+    SCPI_CMD("SPECGRAM:HISTORY:DEPTH?", RP_SpecGramHistoryDepthQ),
+    SCPI_CMD("SPECGRAM:BINS?", RP_SpecGramBinsQ),
+    SCPI_CMD("SPECGRAM:DATA:CH#?", RP_SpecGramDataQ),
+    SCPI_CMD("SPECGRAM:DATA:FRAMES:CH#?", RP_SpecGramDataFramesQ),
+    SCPI_CMD("SPECGRAM:STATS?", RP_SpecGramStatsQ),
+
+    /* Zoom spectrum */
+    SCPI_CMD("SPEC:ZOOM", RP_SpecZoom),
+    SCPI_CMD("SPEC:ZOOM?", RP_SpecZoomQ),
+    SCPI_CMD("SPEC:ZOOM:START", RP_SpecZoomStart),
+    SCPI_CMD("SPEC:ZOOM:STOP", RP_SpecZoomStop),
+    SCPI_CMD("SPEC:ZOOM:FREQ?", RP_SpecZoomFreqQ),
+    SCPI_CMD("SPEC:ZOOM:DATA:CH#?", RP_SpecZoomDataQ),
+    SCPI_CMD("SPEC:ZOOM:PEAK:CH#?", RP_SpecZoomPeakQ),
 
     SCPI_CMD_LIST_END};
 
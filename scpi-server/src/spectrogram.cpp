@@ -0,0 +1,359 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server continuous spectrogram SCPI commands implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "spectrogram.h"
+
+#include "apiApp/rpApp.h"
+#include "common.h"
+#include "rp.h"
+#include "scpi-parser-ext.h"
+#include "scpi/parser.h"
+#include "scpi/units.h"
+
+const scpi_choice_def_t scpi_specgram_window[] = {{"RECTANGULAR", rp_dsp_api::RECTANGULAR},
+                                                  {"HANNING", rp_dsp_api::HANNING},
+                                                  {"HAMMING", rp_dsp_api::HAMMING},
+                                                  {"BLACKMAN_HARRIS", rp_dsp_api::BLACKMAN_HARRIS},
+                                                  {"FLAT_TOP", rp_dsp_api::FLAT_TOP},
+                                                  {"KAISER_4", rp_dsp_api::KAISER_4},
+                                                  {"KAISER_8", rp_dsp_api::KAISER_8},
+                                                  SCPI_CHOICE_LIST_END};
+
+const scpi_choice_def_t scpi_specgram_Bool[] = {{"OFF", 0}, {"ON", 1}, SCPI_CHOICE_LIST_END};
+
+// Frame numbers of the rows sent by the last SPECGRAM:DATA query of every channel
+std::vector<uint64_t> g_specgram_frames[4];
+
+void stopSpecGram() {
+    rpApp_SpecGramStop();
+}
+
+scpi_result_t RP_SpecGramStart(scpi_t* context) {
+    stopAllThreads(context);
+    auto result = rpApp_SpecGramRun();
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to start spectrogram: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramStop(scpi_t* context) {
+    auto result = rpApp_SpecGramStop();
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to stop spectrogram: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramStateQ(scpi_t* context) {
+    const char* _name = nullptr;
+    if (!SCPI_ChoiceToName(scpi_specgram_Bool, (int32_t)(rpApp_SpecGramRunning() != 0), &_name)) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed to parse state.")
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, _name);
+    RP_LOG_INFO("%s", rp_GetError(RP_OK))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramChState(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    bool state_c = false;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        return SCPI_RES_ERR;
+    }
+    /* Parse first, STATE argument */
+    if (!SCPI_ParamBool(context, &state_c, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetEnable(channel, state_c);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set channel state: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramChStateQ(scpi_t* context) {
+    const char* _name = nullptr;
+    bool enabled = false;
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramGetEnable(channel, &enabled);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get channel state: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ChoiceToName(scpi_specgram_Bool, (int32_t)enabled, &_name)) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed to parse state.")
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, _name);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramFFTSize(scpi_t* context) {
+    uint32_t value = 0;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetFFTSize(value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set FFT size: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramFFTSizeQ(scpi_t* context) {
+    uint32_t value = 0;
+    auto result = rpApp_SpecGramGetFFTSize(&value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get FFT size: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, value, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramOverlap(scpi_t* context) {
+    float value = 0;
+    if (!SCPI_ParamFloat(context, &value, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetOverlap(value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set overlap: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramOverlapQ(scpi_t* context) {
+    float value = 0;
+    auto result = rpApp_SpecGramGetOverlap(&value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get overlap: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultFloat(context, value);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramDecimation(scpi_t* context) {
+    uint32_t value = 0;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetDecimation(value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set decimation: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramDecimationQ(scpi_t* context) {
+    uint32_t value = 0;
+    auto result = rpApp_SpecGramGetDecimation(&value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get decimation: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, value, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramWindow(scpi_t* context) {
+    int32_t choice = 0;
+    if (!SCPI_ParamChoice(context, scpi_specgram_window, &choice, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetWindow((rp_dsp_api::window_mode_t)choice);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set window: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramWindowQ(scpi_t* context) {
+    const char* _name = nullptr;
+    rp_dsp_api::window_mode_t mode = rp_dsp_api::HANNING;
+    auto result = rpApp_SpecGramGetWindow(&mode);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get window: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ChoiceToName(scpi_specgram_window, (int32_t)mode, &_name)) {
+        SCPI_LOG_ERR(SCPI_ERROR_EXECUTION_ERROR, "Failed to parse window.")
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, _name);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramHistoryDepth(scpi_t* context) {
+    uint32_t value = 0;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecGramSetHistoryDepth(value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set history depth: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramHistoryDepthQ(scpi_t* context) {
+    uint32_t value = 0;
+    auto result = rpApp_SpecGramGetHistoryDepth(&value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get history depth: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, value, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramBinsQ(scpi_t* context) {
+    uint32_t value = 0;
+    auto result = rpApp_SpecGramGetBins(&value);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get bins: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32Base(context, value, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramDataQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    uint64_t from = 0;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    /* Optional first frame. Without it the whole history is sent. */
+    SCPI_ParamUInt64(context, &from, false);
+
+    std::vector<float> data;
+    auto& frames = g_specgram_frames[channel];
+    auto result = rpApp_SpecGramGetHistory(channel, from, &data, &frames);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get spectrogram data: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    bool error = false;
+    SCPI_ResultBufferFloat(context, data.data(), data.size(), &error);
+    if (error) {
+        RP_LOG_CRIT("Failed to send data");
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramDataFramesQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    std::string ret = "{";
+    for (size_t i = 0; i < g_specgram_frames[channel].size(); i++) {
+        if (i)
+            ret += ",";
+        ret += std::to_string(g_specgram_frames[channel][i]);
+    }
+    ret += "}";
+    SCPI_ResultMnemonic(context, ret.c_str());
+    RP_LOG_INFO("%s", rp_GetError(RP_OK))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecGramStatsQ(scpi_t* context) {
+    rpApp_specgram_stats_t stats;
+    auto result = rpApp_SpecGramGetStats(&stats);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get spectrogram stats: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    std::string ret_json = "{";
+    ret_json += "\"frames\":" + std::to_string(stats.frames);
+    ret_json += ",\"dropped\":" + std::to_string(stats.dropped);
+    ret_json += ",\"last_frame\":" + std::to_string(stats.last_frame);
+    ret_json += ",\"frame_rate\":" + std::to_string(stats.frame_rate);
+    ret_json += ",\"realtime_bw\":" + std::to_string(stats.realtime_bw);
+    ret_json += ",\"bin_width\":" + std::to_string(stats.bin_width);
+    ret_json += "}";
+    SCPI_ResultMnemonic(context, ret_json.c_str());
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
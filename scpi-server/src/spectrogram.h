@@ -0,0 +1,39 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server continuous spectrogram commands interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ */
+
+#ifndef SPECTROGRAM_H_
+#define SPECTROGRAM_H_
+
+#include "scpi/types.h"
+
+void stopSpecGram();
+
+scpi_result_t RP_SpecGramStart(scpi_t* context);
+scpi_result_t RP_SpecGramStop(scpi_t* context);
+scpi_result_t RP_SpecGramStateQ(scpi_t* context);
+scpi_result_t RP_SpecGramChState(scpi_t* context);
+scpi_result_t RP_SpecGramChStateQ(scpi_t* context);
+scpi_result_t RP_SpecGramFFTSize(scpi_t* context);
+scpi_result_t RP_SpecGramFFTSizeQ(scpi_t* context);
+scpi_result_t RP_SpecGramOverlap(scpi_t* context);
+scpi_result_t RP_SpecGramOverlapQ(scpi_t* context);
+scpi_result_t RP_SpecGramDecimation(scpi_t* context);
+scpi_result_t RP_SpecGramDecimationQ(scpi_t* context);
+scpi_result_t RP_SpecGramWindow(scpi_t* context);
+scpi_result_t RP_SpecGramWindowQ(scpi_t* context);
+scpi_result_t RP_SpecGramHistoryDepth(scpi_t* context);
+scpi_result_t RP_SpecGramHistoryDepthQ(scpi_t* context);
+scpi_result_t RP_SpecGramBinsQ(scpi_t* context);
+scpi_result_t RP_SpecGramDataQ(scpi_t* context);
+scpi_result_t RP_SpecGramDataFramesQ(scpi_t* context);
+scpi_result_t RP_SpecGramStatsQ(scpi_t* context);
+
+#endif /* SPECTROGRAM_H_ */
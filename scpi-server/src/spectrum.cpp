@@ -0,0 +1,175 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server zoom spectrum SCPI commands implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "spectrum.h"
+
+#include "apiApp/rpApp.h"
+#include "common.h"
+#include "rp.h"
+#include "scpi-parser-ext.h"
+#include "scpi/parser.h"
+#include "scpi/units.h"
+
+void stopSpectrum() {
+    if (rpApp_SpecRunning())
+        rpApp_SpecStop();
+}
+
+scpi_result_t RP_SpecZoomStart(scpi_t* context) {
+    stopAllThreads(context);
+    auto result = rpApp_SpecSetZoomEnable(true);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to enable zoom, set the band first: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    if (rpApp_SpecRun() != 0) {
+        rpApp_SpecSetZoomEnable(false);
+        RP_LOG_CRIT("Failed to start the spectrum worker");
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoomStop(scpi_t* context) {
+    stopSpectrum();
+    auto result = rpApp_SpecSetZoomEnable(false);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to disable zoom: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoom(scpi_t* context) {
+    double center = 0;
+    uint32_t decimation = 0;
+    if (!SCPI_ParamDouble(context, &center, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamUInt32(context, &decimation, true)) {
+        SCPI_LOG_ERR(SCPI_ERROR_MISSING_PARAMETER, "Missing second parameter.");
+        return SCPI_RES_ERR;
+    }
+    auto result = rpApp_SpecSetZoom(center, decimation);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to set zoom band: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoomQ(scpi_t* context) {
+    double center = 0;
+    uint32_t decimation = 0;
+    auto result = rpApp_SpecGetZoom(&center, &decimation);
+    if (result != RP_OK) {
+        RP_LOG_CRIT("Failed to get zoom band: %s", rp_GetError(result));
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultDouble(context, center);
+    SCPI_ResultUInt32Base(context, decimation, 10);
+    RP_LOG_INFO("%s", rp_GetError(result))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoomFreqQ(scpi_t* context) {
+    const rp_dsp_api::rp_dsp_result_t* view = nullptr;
+    size_t size = 0;
+    std::vector<float> freq;
+    rpApp_SpecLockData();
+    if (rpApp_SpecGetViewData(&view) == 0 && rpApp_SpecGetViewSize(&size) == 0) {
+        freq.assign(view->m_freq_vector.begin(), view->m_freq_vector.begin() + size);
+    }
+    rpApp_SpecUnlockData();
+    if (!view) {
+        RP_LOG_CRIT("The spectrum worker is not running");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    bool error = false;
+    SCPI_ResultBufferFloat(context, freq.data(), freq.size(), &error);
+    if (error) {
+        RP_LOG_CRIT("Failed to send data");
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(RP_OK))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoomDataQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    const rp_dsp_api::rp_dsp_result_t* view = nullptr;
+    size_t size = 0;
+    std::vector<float> data;
+    rpApp_SpecLockData();
+    if (rpApp_SpecGetViewData(&view) == 0 && rpApp_SpecGetViewSize(&size) == 0) {
+        auto& volt = view->m_result[rp_dsp_api::VOLT][channel];
+        data.assign(volt.begin(), volt.begin() + size);
+    }
+    rpApp_SpecUnlockData();
+    if (!view) {
+        RP_LOG_CRIT("The spectrum worker is not running");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    bool error = false;
+    SCPI_ResultBufferFloat(context, data.data(), data.size(), &error);
+    if (error) {
+        RP_LOG_CRIT("Failed to send data");
+        return SCPI_RES_ERR;
+    }
+    RP_LOG_INFO("%s", rp_GetError(RP_OK))
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SpecZoomPeakQ(scpi_t* context) {
+    rp_channel_t channel = RP_CH_1;
+    if (RP_ParseChArgvADC(context, &channel) != RP_OK) {
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    const rp_dsp_api::rp_dsp_result_t* view = nullptr;
+    float freq = 0;
+    float power = 0;
+    rpApp_SpecLockData();
+    if (rpApp_SpecGetViewData(&view) == 0) {
+        freq = view->m_peak_freq[rp_dsp_api::DBM][channel];
+        power = view->m_peak_power[rp_dsp_api::DBM][channel];
+    }
+    rpApp_SpecUnlockData();
+    if (!view) {
+        RP_LOG_CRIT("The spectrum worker is not running");
+        if (getRetOnError())
+            requestSendNewLine(context);
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultFloat(context, freq);
+    SCPI_ResultFloat(context, power);
+    RP_LOG_INFO("%s", rp_GetError(RP_OK))
+    return SCPI_RES_OK;
+}
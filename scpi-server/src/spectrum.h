@@ -0,0 +1,27 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server zoom spectrum commands interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ */
+
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+#include "scpi/types.h"
+
+void stopSpectrum();
+
+scpi_result_t RP_SpecZoomStart(scpi_t* context);
+scpi_result_t RP_SpecZoomStop(scpi_t* context);
+scpi_result_t RP_SpecZoom(scpi_t* context);
+scpi_result_t RP_SpecZoomQ(scpi_t* context);
+scpi_result_t RP_SpecZoomFreqQ(scpi_t* context);
+scpi_result_t RP_SpecZoomDataQ(scpi_t* context);
+scpi_result_t RP_SpecZoomPeakQ(scpi_t* context);
+
+#endif /* SPECTRUM_H_ */
@@ -0,0 +1,224 @@
+/**
+ *
+ * @brief Red Pitaya acquisition broker. Owns the oscilloscope and publishes every capture
+ * into a shared memory ring for any number of local readers.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+
+#include "common/version.h"
+#include "rp.h"
+
+namespace {
+
+std::atomic_bool g_stop = false;
+
+typedef struct {
+    const char* name;
+    rp_acq_trig_src_t source;
+} trig_name_t;
+
+const trig_name_t g_trigNames[] = {{"NOW", RP_TRIG_SRC_NOW},       {"CH1_PE", RP_TRIG_SRC_CHA_PE}, {"CH1_NE", RP_TRIG_SRC_CHA_NE},
+                                   {"CH2_PE", RP_TRIG_SRC_CHB_PE}, {"CH2_NE", RP_TRIG_SRC_CHB_NE}, {"CH3_PE", RP_TRIG_SRC_CHC_PE},
+                                   {"CH3_NE", RP_TRIG_SRC_CHC_NE}, {"CH4_PE", RP_TRIG_SRC_CHD_PE}, {"CH4_NE", RP_TRIG_SRC_CHD_NE},
+                                   {"EXT_PE", RP_TRIG_SRC_EXT_PE}, {"EXT_NE", RP_TRIG_SRC_EXT_NE}};
+
+struct Options {
+    const char* name = RP_ACQ_SHM_NAME;
+    uint32_t slots = 8;
+    uint32_t decimation = 1;
+    rp_acq_trig_src_t trigger = RP_TRIG_SRC_NOW;
+    float level = 0;
+    int32_t delay = 0;
+    uint32_t interval_ms = 0;
+    uint64_t count = 0;
+    bool verbose = false;
+};
+
+auto usage(const char* progName) -> void {
+    fprintf(stderr,
+            "Red Pitaya acquisition broker\n"
+            "Version: %s-%s\n"
+            "\n"
+            "Usage: %s [options]\n"
+            "\n"
+            "  --name=NAME      -n NAME  Shared memory name (default %s).\n"
+            "  --slots=N        -s N     Captures kept in the ring, at least 2 (default 8).\n"
+            "  --dec=N          -d N     Decimation factor (default 1).\n"
+            "  --trig=SOURCE    -t SRC   Trigger source: NOW, CH1_PE, CH1_NE, ... CH4_NE, EXT_PE, EXT_NE (default NOW).\n"
+            "  --level=V        -l V     Trigger level in volts (default 0).\n"
+            "  --delay=N        -D N     Trigger delay in samples (default 0).\n"
+            "  --interval=MS    -i MS    Minimum time between captures (default 0).\n"
+            "  --count=N        -c N     Stop after N captures, 0 runs until interrupted (default 0).\n"
+            "  --verbose        -v       Print every published capture.\n"
+            "  --help           -h       Print this message.\n"
+            "\n"
+            "Readers call rp_AcqShmOpen and do not need rp_Init. The broker must be the only\n"
+            "process that drives the oscilloscope.\n",
+            VERSION_STR, REVISION_STR, progName, RP_ACQ_SHM_NAME);
+}
+
+auto parseTrigger(const char* value, rp_acq_trig_src_t* source) -> bool {
+    for (auto& t : g_trigNames) {
+        if (strcasecmp(value, t.name) == 0) {
+            *source = t.source;
+            return true;
+        }
+    }
+    return false;
+}
+
+auto parse(int argc, char* argv[], Options* options) -> bool {
+    static struct option long_options[] = {{"name", required_argument, 0, 'n'},  {"slots", required_argument, 0, 's'},    {"dec", required_argument, 0, 'd'},
+                                           {"trig", required_argument, 0, 't'},  {"level", required_argument, 0, 'l'},    {"delay", required_argument, 0, 'D'},
+                                           {"interval", required_argument, 0, 'i'}, {"count", required_argument, 0, 'c'}, {"verbose", no_argument, 0, 'v'},
+                                           {"help", no_argument, 0, 'h'},        {0, 0, 0, 0}};
+    int ch = -1;
+    int option_index = 0;
+    while ((ch = getopt_long(argc, argv, "n:s:d:t:l:D:i:c:vh", long_options, &option_index)) != -1) {
+        switch (ch) {
+            case 'n':
+                options->name = optarg;
+                break;
+            case 's':
+                options->slots = strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                options->decimation = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                if (!parseTrigger(optarg, &options->trigger)) {
+                    fprintf(stderr, "Unknown trigger source: %s\n", optarg);
+                    return false;
+                }
+                break;
+            case 'l':
+                options->level = strtof(optarg, NULL);
+                break;
+            case 'D':
+                options->delay = strtol(optarg, NULL, 10);
+                break;
+            case 'i':
+                options->interval_ms = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                options->count = strtoull(optarg, NULL, 10);
+                break;
+            case 'v':
+                options->verbose = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    return options->slots >= 2;
+}
+
+auto triggerChannel(rp_acq_trig_src_t source) -> rp_channel_trigger_t {
+    switch (source) {
+        case RP_TRIG_SRC_CHB_PE:
+        case RP_TRIG_SRC_CHB_NE:
+            return RP_T_CH_2;
+        case RP_TRIG_SRC_CHC_PE:
+        case RP_TRIG_SRC_CHC_NE:
+            return RP_T_CH_3;
+        case RP_TRIG_SRC_CHD_PE:
+        case RP_TRIG_SRC_CHD_NE:
+            return RP_T_CH_4;
+        case RP_TRIG_SRC_EXT_PE:
+        case RP_TRIG_SRC_EXT_NE:
+            return RP_T_CH_EXT;
+        default:
+            return RP_T_CH_1;
+    }
+}
+
+// Returns false when stopped before the buffer was filled
+auto capture(const Options& options) -> bool {
+    if (rp_AcqStart() != RP_OK)
+        return false;
+    if (rp_AcqSetTriggerSrc(options.trigger) != RP_OK)
+        return false;
+    bool filled = false;
+    while (!filled && !g_stop) {
+        rp_AcqGetBufferFillState(&filled);
+        if (!filled)
+            usleep(100);
+    }
+    rp_AcqStop();
+    return filled;
+}
+
+auto onSignal(int) -> void {
+    g_stop = true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse(argc, argv, &options)) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Error init rp api\n");
+        return -1;
+    }
+
+    int ret = rp_AcqReset();
+    ret |= rp_AcqSetDecimationFactor(options.decimation);
+    ret |= rp_AcqSetTriggerLevel(triggerChannel(options.trigger), options.level);
+    ret |= rp_AcqSetTriggerDelay(options.delay);
+    if (ret != RP_OK) {
+        fprintf(stderr, "Error setting up the acquisition\n");
+        rp_Release();
+        return -1;
+    }
+
+    ret = rp_AcqShmCreate(options.name, options.slots);
+    if (ret != RP_OK) {
+        fprintf(stderr, "Error creating shared memory %s: %s\n", options.name, rp_GetError(ret));
+        rp_Release();
+        return -1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    uint64_t published = 0;
+    auto last = std::chrono::steady_clock::now() - std::chrono::milliseconds(options.interval_ms);
+    while (!g_stop && (options.count == 0 || published < options.count)) {
+        auto next = last + std::chrono::milliseconds(options.interval_ms);
+        auto now = std::chrono::steady_clock::now();
+        if (now < next)
+            usleep(std::chrono::duration_cast<std::chrono::microseconds>(next - now).count());
+        last = std::chrono::steady_clock::now();
+
+        if (!capture(options))
+            continue;
+        uint64_t sequence = 0;
+        ret = rp_AcqShmPublish(&sequence);
+        if (ret != RP_OK) {
+            fprintf(stderr, "Error publishing capture: %s\n", rp_GetError(ret));
+            break;
+        }
+        published++;
+        if (options.verbose)
+            printf("%llu\n", (unsigned long long)sequence);
+    }
+
+    rp_AcqShmDestroy();
+    rp_Release();
+    return ret == RP_OK ? 0 : -1;
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/python3
+
+# Compares two rp_bench result files and reports regressions.
+# Usage: rp_bench_compare.py BASELINE.json CURRENT.json [--threshold PERCENT]
+# Exit code is 1 if a benchmark got slower than the threshold or disappeared.
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data, {(b["group"], b["name"]): b for b in data["benchmarks"]}
+
+
+parser = argparse.ArgumentParser(description="Compare rp_bench results against a baseline")
+parser.add_argument("baseline")
+parser.add_argument("current")
+parser.add_argument("--threshold", type=float, default=10.0, help="Allowed slowdown in percent (default: 10)")
+parser.add_argument("--allow-missing", action="store_true", help="Do not fail on benchmarks missing from the current run")
+args = parser.parse_args()
+
+base_info, base = load(args.baseline)
+cur_info, cur = load(args.current)
+
+print("Baseline: %s (%s)" % (base_info.get("version"), base_info.get("machine")))
+print("Current:  %s (%s)" % (cur_info.get("version"), cur_info.get("machine")))
+print()
+print("%-12s %-40s %14s %14s %9s" % ("group", "name", "base ns", "current ns", "change"))
+
+regressions = 0
+for key in sorted(set(base) | set(cur)):
+    b = base.get(key)
+    c = cur.get(key)
+    status = ""
+    if b is None:
+        line = ("-", "%.0f" % c["ns_per_iter"] if not c.get("skipped") else "skipped", "")
+        status = "new"
+    elif c is None:
+        line = ("%.0f" % b["ns_per_iter"] if not b.get("skipped") else "skipped", "-", "")
+        status = "MISSING"
+        regressions += not b.get("skipped") and not args.allow_missing
+    elif b.get("skipped") or c.get("skipped"):
+        line = ("skipped" if b.get("skipped") else "%.0f" % b["ns_per_iter"],
+                "skipped" if c.get("skipped") else "%.0f" % c["ns_per_iter"], "")
+        if c.get("skipped") and not b.get("skipped"):
+            status = "MISSING"
+            regressions += not args.allow_missing
+    else:
+        change = (c["ns_per_iter"] / b["ns_per_iter"] - 1) * 100 if b["ns_per_iter"] > 0 else 0
+        line = ("%.0f" % b["ns_per_iter"], "%.0f" % c["ns_per_iter"], "%+.1f%%" % change)
+        if change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            status = "faster"
+    print("%-12s %-40s %14s %14s %9s  %s" % (key[0], key[1], line[0], line[1], line[2], status))
+
+print()
+if regressions:
+    print("%d regression(s) above %.1f%%" % (regressions, args.threshold))
+    sys.exit(1)
+print("No regressions above %.1f%%" % args.threshold)
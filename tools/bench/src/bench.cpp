@@ -0,0 +1,174 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Timing harness shared by all benchmark groups.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+#include "common/version.h"
+
+namespace {
+
+auto nowNs() -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+auto escape(const std::string& _str) -> std::string {
+    std::string out;
+    for (char c : _str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+auto syntheticSignal(float* _out, size_t _size, uint32_t _seed) -> void {
+    uint32_t lcg = _seed * 2654435761u + 1;
+    for (size_t i = 0; i < _size; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        float noise = ((float)(lcg >> 8) / (float)(1 << 24) - 0.5f) * 0.01f;
+        _out[i] = 0.5f * sinf(2.0f * (float)M_PI * i / 64.0f) + 0.1f * sinf(2.0f * (float)M_PI * i / 7.3f) + noise;
+    }
+}
+
+CBench::CBench(const BenchOptions& _options) : m_options(_options) {}
+
+auto CBench::isSelected(const std::string& _group, const std::string& _name) const -> bool {
+    if (m_options.filter.empty())
+        return true;
+    return (_group + "/" + _name).find(m_options.filter) != std::string::npos;
+}
+
+auto CBench::isListOnly() const -> bool {
+    return m_options.list_only;
+}
+
+auto CBench::run(const std::string& _group, const std::string& _name, uint64_t _size, const std::function<void()>& _fn) -> void {
+    m_last_ran = false;
+    if (!isSelected(_group, _name))
+        return;
+    if (m_options.list_only) {
+        printf("%s/%s\n", _group.c_str(), _name.c_str());
+        return;
+    }
+
+    // Warm up caches and estimate the cost of one call
+    uint64_t batch = 1;
+    uint64_t target_ns = (uint64_t)(m_options.min_time_ms * 1e6 / std::max(1u, m_options.runs));
+    while (true) {
+        auto start = nowNs();
+        for (uint64_t i = 0; i < batch; i++)
+            _fn();
+        auto elapsed = nowNs() - start;
+        if (elapsed >= target_ns / 10 || batch >= (1ull << 30)) {
+            batch = std::max<uint64_t>(1, (uint64_t)((double)batch * target_ns / std::max<uint64_t>(elapsed, 1)));
+            break;
+        }
+        batch *= 10;
+    }
+
+    std::vector<double> samples;
+    for (uint32_t r = 0; r < std::max(1u, m_options.runs); r++) {
+        auto start = nowNs();
+        for (uint64_t i = 0; i < batch; i++)
+            _fn();
+        samples.push_back((double)(nowNs() - start) / batch);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult res;
+    res.group = _group;
+    res.name = _name;
+    res.size = _size;
+    res.iterations = batch * samples.size();
+    res.ns_per_iter = samples[samples.size() / 2];
+    res.ns_per_iter_min = samples.front();
+    res.items_per_sec = res.ns_per_iter > 0 ? _size * 1e9 / res.ns_per_iter : 0;
+    m_results.push_back(res);
+    m_last_ran = true;
+
+    fprintf(stderr, "%-12s %-40s %10.0f ns/iter %12.3f Mitems/s\n", _group.c_str(), _name.c_str(), res.ns_per_iter, res.items_per_sec / 1e6);
+}
+
+auto CBench::setMemory(uint64_t _bytes) -> void {
+    if (!m_last_ran)
+        return;
+    auto& res = m_results.back();
+    res.memory_bytes = _bytes;
+    fprintf(stderr, "%-12s %-40s %10.1f KiB working memory\n", res.group.c_str(), res.name.c_str(), _bytes / 1024.0);
+}
+
+auto CBench::skip(const std::string& _group, const std::string& _name, const std::string& _reason) -> void {
+    m_last_ran = false;
+    if (!isSelected(_group, _name) || m_options.list_only)
+        return;
+    BenchResult res;
+    res.group = _group;
+    res.name = _name;
+    res.skipped = true;
+    res.note = _reason;
+    m_results.push_back(res);
+    fprintf(stderr, "%-12s %-40s skipped: %s\n", _group.c_str(), _name.c_str(), _reason.c_str());
+}
+
+auto CBench::getResults() const -> const std::vector<BenchResult>& {
+    return m_results;
+}
+
+auto CBench::writeJSON(const std::string& _path) const -> bool {
+    FILE* f = _path.empty() || _path == "-" ? stdout : fopen(_path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Can't open %s\n", _path.c_str());
+        return false;
+    }
+
+    struct utsname un;
+    uname(&un);
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s-%s\",\n", VERSION_STR, REVISION_STR);
+    fprintf(f, "  \"machine\": \"%s\",\n", escape(un.machine).c_str());
+    fprintf(f, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+    fprintf(f, "  \"min_time_ms\": %g,\n", m_options.min_time_ms);
+    fprintf(f, "  \"runs\": %u,\n", m_options.runs);
+    fprintf(f, "  \"benchmarks\": [");
+    for (size_t i = 0; i < m_results.size(); i++) {
+        auto& r = m_results[i];
+        fprintf(f, "%s\n    {\"group\": \"%s\", \"name\": \"%s\", ", i ? "," : "", escape(r.group).c_str(), escape(r.name).c_str());
+        if (r.skipped) {
+            fprintf(f, "\"skipped\": true, \"note\": \"%s\"}", escape(r.note).c_str());
+        } else {
+            fprintf(f,
+                    "\"size\": %llu, \"iterations\": %llu, \"ns_per_iter\": %.3f, \"ns_per_iter_min\": %.3f, \"items_per_sec\": %.3f",
+                    (unsigned long long)r.size,
+                    (unsigned long long)r.iterations,
+                    r.ns_per_iter,
+                    r.ns_per_iter_min,
+                    r.items_per_sec);
+            if (r.memory_bytes)
+                fprintf(f, ", \"memory_bytes\": %llu", (unsigned long long)r.memory_bytes);
+            fprintf(f, "}");
+        }
+    }
+    fprintf(f, "\n  ]\n}\n");
+    if (f != stdout)
+        fclose(f);
+    return true;
+}
@@ -0,0 +1,78 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Timing harness shared by all benchmark groups.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    uint64_t size = 0;           // Input size of one iteration in items (samples, bytes, frames)
+    uint64_t iterations = 0;     // Total timed iterations
+    double ns_per_iter = 0;      // Median over runs
+    double ns_per_iter_min = 0;  // Fastest run
+    double items_per_sec = 0;    // size / median time
+    uint64_t memory_bytes = 0;   // Working memory of the benchmarked code, 0 when not reported
+    bool skipped = false;
+    std::string note;
+};
+
+struct BenchOptions {
+    std::string filter;         // Only benchmarks whose "group/name" contains this string
+    double min_time_ms = 200;   // Timed duration of all runs of one benchmark
+    uint32_t runs = 5;          // Number of runs, the median is reported
+    bool list_only = false;
+};
+
+class CBench {
+   public:
+    explicit CBench(const BenchOptions& _options);
+
+    // Times _fn, which processes _size items per call. Calls are batched so that one run
+    // lasts about min_time_ms / runs. The function must be deterministic and self-contained.
+    auto run(const std::string& _group, const std::string& _name, uint64_t _size, const std::function<void()>& _fn) -> void;
+
+    // Reports the working memory of the last benchmark, ignored when it was filtered out or skipped
+    auto setMemory(uint64_t _bytes) -> void;
+
+    // Records a benchmark that cannot run here (missing hardware, emulation disabled, ...)
+    auto skip(const std::string& _group, const std::string& _name, const std::string& _reason) -> void;
+
+    auto isSelected(const std::string& _group, const std::string& _name) const -> bool;
+    auto isListOnly() const -> bool;
+    auto getResults() const -> const std::vector<BenchResult>&;
+    auto writeJSON(const std::string& _path) const -> bool;
+
+   private:
+    BenchOptions m_options;
+    std::vector<BenchResult> m_results;
+    bool m_last_ran = false;
+};
+
+// Fixed synthetic input: two tones plus pseudo random noise, identical on every run and platform
+auto syntheticSignal(float* _out, size_t _size, uint32_t _seed) -> void;
+
+// Keeps the compiler from removing computations whose result is not used
+template <typename T>
+inline void doNotOptimize(T const& _value) {
+    asm volatile("" : : "r,m"(_value) : "memory");
+}
+
+// Benchmark groups, one per subsystem
+auto benchDSP(CBench& _bench) -> void;
+auto benchMath(CBench& _bench) -> void;
+auto benchAcq(CBench& _bench) -> void;
+auto benchLA(CBench& _bench) -> void;
+auto benchFormatter(CBench& _bench) -> void;
+auto benchConvert(CBench& _bench) -> void;
+
+#endif
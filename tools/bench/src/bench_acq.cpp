@@ -0,0 +1,127 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Oscilloscope buffer readout and conversion.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "rp.h"
+
+namespace {
+
+// One acquisition with an immediate trigger, so the buffer holds a defined capture
+auto acquireOnce() -> bool {
+    if (rp_AcqReset() != RP_OK || rp_AcqSetDecimation(RP_DEC_1) != RP_OK || rp_AcqSetTriggerDelay(0) != RP_OK)
+        return false;
+    if (rp_AcqStart() != RP_OK)
+        return false;
+    usleep(1000);
+    if (rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW) != RP_OK)
+        return false;
+    bool filled = false;
+    for (int i = 0; i < 1000 && !filled; i++) {
+        rp_AcqGetBufferFillState(&filled);
+        if (!filled)
+            usleep(1000);
+    }
+    rp_AcqStop();
+    return filled;
+}
+
+}  // namespace
+
+auto benchAcq(CBench& _bench) -> void {
+    const auto names = {"read_volts", "read_raw", "read_oldest_volts", "seg_rearm", "seg_read_raw"};
+    bool any = false;
+    for (auto name : names)
+        any |= _bench.isSelected("acq", name);
+    if (!any)
+        return;
+    if (_bench.isListOnly()) {
+        for (auto name : names)
+            _bench.run("acq", name, 0, []() {});
+        return;
+    }
+
+    // Reading the buffers needs the FPGA, or the emulation backend (RP_EMULATION=1) on a host
+#ifndef ARCH_ARM
+    if (!getenv("RP_EMULATION")) {
+        for (auto name : names)
+            _bench.skip("acq", name, "No FPGA. Set RP_EMULATION=1 to run on the emulation backend");
+        return;
+    }
+#endif
+
+    if (rp_Init() != RP_OK || !acquireOnce()) {
+        for (auto name : names)
+            _bench.skip("acq", name, "Acquisition failed");
+        rp_Release();
+        return;
+    }
+
+    uint32_t buf_size = 0;
+    rp_AcqGetBufSize(&buf_size);
+    std::vector<float> volts(buf_size);
+    std::vector<int16_t> raw(buf_size);
+    uint32_t pos = 0;
+    rp_AcqGetWritePointerAtTrig(&pos);
+
+    _bench.run("acq", "read_volts", buf_size, [&]() {
+        uint32_t size = buf_size;
+        rp_AcqGetDataV(RP_CH_1, pos, &size, volts.data());
+        doNotOptimize(volts[0]);
+    });
+    _bench.run("acq", "read_raw", buf_size, [&]() {
+        uint32_t size = buf_size;
+        rp_AcqGetDataRaw(RP_CH_1, pos, &size, raw.data());
+        doNotOptimize(raw[0]);
+    });
+    _bench.run("acq", "read_oldest_volts", buf_size, [&]() {
+        uint32_t size = buf_size;
+        rp_AcqGetOldestDataV(RP_CH_1, &size, volts.data());
+        doNotOptimize(volts[0]);
+    });
+
+    // Segmented capture with an immediate trigger: the time per record is the record length plus
+    // the re-arm dead time. The emulation backend steps in 1 ms ticks, its numbers only show the
+    // software overhead and say nothing about the FPGA.
+    const uint32_t segments = 16;
+    const uint32_t samples = 1024;
+    uint32_t start = 0, size = 0;
+    if (rp_AcqAxiGetMemoryRegion(&start, &size) != RP_OK || rp_AcqAxiSegSetup(segments, samples) != RP_OK ||
+        rp_AcqAxiSegSetBuffer(RP_CH_1, start) != RP_OK || rp_AcqAxiSetTriggerDelay(RP_CH_1, samples / 2) != RP_OK) {
+        _bench.skip("acq", "seg_rearm", "No AXI acquisition");
+        _bench.skip("acq", "seg_read_raw", "No AXI acquisition");
+        rp_Release();
+        return;
+    }
+    _bench.run("acq", "seg_rearm", segments, [&]() {
+        uint32_t captured = 0;
+        bool running = rp_AcqAxiSegStart(RP_TRIG_SRC_NOW) == RP_OK;
+        while (running) {
+            std::this_thread::yield();
+            rp_AcqAxiSegGetState(&captured, &running);
+        }
+        doNotOptimize(captured);
+    });
+    _bench.setMemory((uint64_t)segments * samples * sizeof(int16_t));
+    _bench.run("acq", "seg_read_raw", segments * samples, [&]() {
+        std::vector<std::span<int16_t>> spans;
+        rp_AcqAxiSegGetDataRawDirect(RP_CH_1, 0, segments, &spans);
+        int64_t sum = 0;
+        for (auto& span : spans)
+            for (auto value : span)
+                sum += value;
+        doNotOptimize(sum);
+    });
+    _bench.setMemory((uint64_t)segments * samples * sizeof(int16_t));
+    rp_AcqAxiSegStop();
+    rp_Release();
+}
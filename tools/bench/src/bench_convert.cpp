@@ -0,0 +1,98 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Sample conversion of every board family, the profile
+ * specialized kernels against the per-sample conversion with runtime format arguments.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <vector>
+
+#include "bench.h"
+#include "common/convert.hpp"
+#include "rp.h"
+
+namespace {
+
+struct Family {
+    const char* name;
+    uint8_t adc_bits;
+    uint8_t dac_bits;
+};
+
+// ADC and DAC sample formats of the profiles in rp-api/api-hw-profiles, all signed. The 16 bit
+// family also covers the 16 bit mode of the other boards.
+const Family g_families[] = {{"250_12", 12, 14}, {"125_14", 14, 14}, {"122_16", 16, 14}};
+
+}  // namespace
+
+auto benchConvert(CBench& _bench) -> void {
+    const uint32_t size = ADC_BUFFER_SIZE;
+    std::vector<float> signal(size);
+    syntheticSignal(signal.data(), size, 1);
+
+    // A typical calibration, 2^24 base
+    const uint32_t base = 1 << 24;
+    const uint32_t gain = base + base / 50;
+    const int32_t offset = -12;
+    const float fullScale = 1.0f;
+    const uint32_t pos = size / 3;  // The readout wraps in the ring buffer
+
+    for (auto& family : g_families) {
+        auto suffix = std::string("/") + family.name;
+        const uint8_t bits = family.adc_bits;
+        const bool is_sign = true;
+        const uint32_t mask = ((uint64_t)1 << bits) - 1;
+
+        std::vector<uint32_t> ring(size);
+        for (uint32_t i = 0; i < size; i++)
+            ring[i] = cmn_convertToCnt(signal[i] * 0.9f, bits, fullScale, is_sign, 1, 0);
+        const volatile uint32_t* src = ring.data();
+        std::vector<int16_t> raw(size);
+        std::vector<float> volts(size);
+        std::vector<uint16_t> dac(size);
+
+        _bench.run("convert", "adc_raw_runtime" + suffix, size, [&]() {
+            for (uint32_t i = 0; i < size; i++) {
+                uint32_t cnts = src[(pos + i) % size] & mask;
+                raw[i] = is_sign ? cmn_CalibCntsSigned(cnts, bits, gain, base, offset) : cmn_CalibCntsUnsigned(cnts, bits, gain, base, offset);
+            }
+            doNotOptimize(raw[0]);
+        });
+
+        auto convert = cmn_GetConvert(bits, is_sign);
+        cmn_calib_cnts_t calib = {bits, gain, base, offset};
+        _bench.run("convert", "adc_raw_kernel" + suffix, size, [&]() {
+            convert->calibCnts(src + pos, size - pos, raw.data(), &calib);
+            convert->calibCnts(src, pos, raw.data() + size - pos, &calib);
+            doNotOptimize(raw[0]);
+        });
+
+        _bench.run("convert", "adc_volts_runtime" + suffix, size, [&]() {
+            for (uint32_t i = 0; i < size; i++) {
+                uint32_t cnts = src[(pos + i) % size] & mask;
+                volts[i] = (is_sign ? cmn_convertToVoltSigned(cnts, bits, fullScale, gain, base, offset) : cmn_convertToVoltUnsigned(cnts, bits, fullScale, gain, base, offset)) * 20.0f + 0.01f;
+            }
+            doNotOptimize(volts[0]);
+        });
+
+        _bench.run("convert", "adc_volts_kernel" + suffix, size, [&]() {
+            convert->volts(src + pos, size - pos, volts.data(), fullScale, &calib, 20.0f, 0.01f);
+            convert->volts(src, pos, volts.data() + size - pos, fullScale, &calib, 20.0f, 0.01f);
+            doNotOptimize(volts[0]);
+        });
+
+        const uint8_t dac_bits = family.dac_bits;
+        _bench.run("convert", "dac_cnts_runtime" + suffix, size, [&]() {
+            for (uint32_t i = 0; i < size; i++)
+                dac[i] = cmn_convertToCnt(signal[i], dac_bits, 1.0, is_sign, 1, 0);
+            doNotOptimize(dac[0]);
+        });
+
+        auto dac_convert = cmn_GetConvert(dac_bits, is_sign);
+        _bench.run("convert", "dac_cnts_kernel" + suffix, size, [&]() {
+            dac_convert->cnts(signal.data(), size, dac_bits, dac.data());
+            doNotOptimize(dac[0]);
+        });
+    }
+}
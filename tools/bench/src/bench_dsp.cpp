@@ -0,0 +1,186 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Spectrum analyzer DSP chain (window, FFT, conversion), FFT backends,
+ * channel threads and zoom FFT.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include "bench.h"
+#include "math/rp_dsp.h"
+#include "math/rp_zoom_fft.h"
+
+#define ADC_RATE 125000000
+
+namespace {
+
+// Buffers CDSP and createData() hold for one channel of _size samples, without the kiss_fftr plan
+auto fullFFTMemory(uint64_t _size) -> uint64_t {
+    uint64_t in = _size * sizeof(float) * 4;                 // window, input, filtered, magnitudes
+    uint64_t fft = _size * sizeof(float) * 2;                // complex FFT output
+    uint64_t out = _size / 2 * sizeof(float) * (3 + 7 + 1);  // decimated, 7 modes, frequency vector
+    return in + fft + out;
+}
+
+// Both FFT backends on two channels, size = samples per channel
+auto benchFFTBackends(CBench& _bench) -> void {
+    for (uint32_t size : {1024, 4096, 16384, 65536}) {
+        auto suffix = "/" + std::to_string(size);
+        rp_dsp_api::CDSP dsp(2, size, ADC_RATE);
+        if (dsp.setSignalLength(size) || dsp.window_init(rp_dsp_api::HANNING)) {
+            _bench.skip("dsp", "fft_backend" + suffix, "CDSP initialization failed");
+            continue;
+        }
+        auto data = dsp.createData();
+        if (!data) {
+            _bench.skip("dsp", "fft_backend" + suffix, "Can't allocate data");
+            continue;
+        }
+        for (size_t ch = 0; ch < data->m_in.size(); ch++) {
+            syntheticSignal(data->m_in[ch].data(), size, ch);
+        }
+        data->reset();
+        dsp.windowFilter(data);
+        for (auto [backend, name] : {std::pair{rp_dsp_api::FFT_KISS, "fft_kiss"}, std::pair{rp_dsp_api::FFT_NEON, "fft_neon"}}) {
+            if (dsp.setFFTBackend(backend) || dsp.getFFTBackend() != backend) {
+                _bench.skip("dsp", name + suffix, "Backend not available for this size");
+                continue;
+            }
+            _bench.run("dsp", name + suffix, size * 2, [&]() {
+                dsp.fft(data);
+                doNotOptimize(data->m_fft[0][0]);
+            });
+        }
+        delete data;
+    }
+}
+
+// Full chain on 2 and 4 channels with the channels processed on 1 and 2 threads
+auto benchThreads(CBench& _bench) -> void {
+    const uint32_t size = 16384;
+    for (uint8_t channels : {2, 4}) {
+        for (uint8_t threads : {1, 2}) {
+            auto name = "full_chain_" + std::to_string(channels) + "ch_" + std::to_string(threads) + "t/" + std::to_string(size);
+            rp_dsp_api::CDSP dsp(channels, size, ADC_RATE);
+            if (dsp.setSignalLength(size) || dsp.window_init(rp_dsp_api::HANNING) || dsp.setThreads(threads)) {
+                _bench.skip("dsp", name, "CDSP initialization failed");
+                continue;
+            }
+            auto data = dsp.createData();
+            if (!data) {
+                _bench.skip("dsp", name, "Can't allocate data");
+                continue;
+            }
+            for (size_t ch = 0; ch < data->m_in.size(); ch++) {
+                syntheticSignal(data->m_in[ch].data(), size, ch);
+            }
+            _bench.run("dsp", name, size * channels, [&]() {
+                data->reset();
+                dsp.windowFilter(data);
+                dsp.fft(data);
+                dsp.decimate(data, dsp.getOutSignalLength(), dsp.getOutSignalLength());
+                dsp.prepareFreqVector(data, 1);
+                dsp.cnvToMetric(data, 1);
+                doNotOptimize(data->m_converted.m_result[0]);
+            });
+            delete data;
+        }
+    }
+}
+
+// Zoom FFT against a full band FFT with the same bin width, ADC_RATE / (bins * decimation)
+auto benchZoom(CBench& _bench) -> void {
+    for (auto [bins, decimation] : {std::pair{1024u, 64u}, std::pair{4096u, 64u}}) {
+        auto suffix = "/" + std::to_string(bins) + "x" + std::to_string(decimation);
+        rp_dsp_api::CZoomFFT zoom(bins, ADC_RATE);
+        if (zoom.setZoom(ADC_RATE / 8.0, decimation)) {
+            _bench.skip("dsp", "zoom_fft" + suffix, "CZoomFFT initialization failed");
+            continue;
+        }
+        std::vector<float> input(zoom.getInputLength());
+        syntheticSignal(input.data(), input.size(), 0);
+        std::vector<float> amplitude(bins);
+        _bench.run("dsp", "zoom_fft" + suffix, input.size(), [&]() {
+            zoom.reset();
+            zoom.process(input.data(), input.size());
+            zoom.getAmplitude(amplitude.data());
+            doNotOptimize(amplitude[0]);
+        });
+        _bench.setMemory(zoom.getMemoryUsage());
+
+        uint32_t full = bins * decimation;
+        rp_dsp_api::CDSP dsp(1, full, ADC_RATE);
+        if (dsp.setSignalLength(full) || dsp.window_init(rp_dsp_api::HANNING) || dsp.fftInit()) {
+            _bench.skip("dsp", "zoom_equal_full_fft" + suffix, "CDSP initialization failed");
+            continue;
+        }
+        auto data = dsp.createData();
+        if (!data) {
+            _bench.skip("dsp", "zoom_equal_full_fft" + suffix, "Can't allocate data");
+            continue;
+        }
+        syntheticSignal(data->m_in[0].data(), full, 0);
+        _bench.run("dsp", "zoom_equal_full_fft" + suffix, full, [&]() {
+            data->reset();
+            dsp.windowFilter(data);
+            dsp.fft(data);
+            doNotOptimize(data->m_fft[0][0]);
+        });
+        _bench.setMemory(fullFFTMemory(full));
+        delete data;
+    }
+}
+
+}  // namespace
+
+auto benchDSP(CBench& _bench) -> void {
+    for (uint32_t size : {1024, 4096, 16384}) {
+        auto suffix = "/" + std::to_string(size);
+        rp_dsp_api::CDSP dsp(2, size, ADC_RATE);
+        if (dsp.setSignalLength(size) || dsp.window_init(rp_dsp_api::HANNING) || dsp.fftInit()) {
+            _bench.skip("dsp", "init" + suffix, "CDSP initialization failed");
+            continue;
+        }
+        auto data = dsp.createData();
+        if (!data) {
+            _bench.skip("dsp", "init" + suffix, "Can't allocate data");
+            continue;
+        }
+        for (size_t ch = 0; ch < data->m_in.size(); ch++) {
+            syntheticSignal(data->m_in[ch].data(), size, ch);
+        }
+
+        _bench.run("dsp", "window_hanning" + suffix, size, [&]() {
+            data->reset();
+            dsp.windowFilter(data);
+            doNotOptimize(data->m_filtred[0][0]);
+        });
+
+        data->reset();
+        dsp.windowFilter(data);
+        _bench.run("dsp", "fft" + suffix, size, [&]() {
+            dsp.fft(data);
+            doNotOptimize(data->m_fft[0][0]);
+        });
+
+        dsp.fft(data);
+        _bench.run("dsp", "convert_metric" + suffix, size, [&]() {
+            dsp.prepareFreqVector(data, 1);
+            dsp.cnvToMetric(data, 1);
+            doNotOptimize(data->m_converted.m_result[0]);
+        });
+
+        _bench.run("dsp", "full_chain" + suffix, size, [&]() {
+            data->reset();
+            dsp.windowFilter(data);
+            dsp.fft(data);
+            dsp.prepareFreqVector(data, 1);
+            dsp.cnvToMetric(data, 1);
+            doNotOptimize(data->m_converted.m_result[0]);
+        });
+        delete data;
+    }
+    benchFFTBackends(_bench);
+    benchThreads(_bench);
+    benchZoom(_bench);
+}
@@ -0,0 +1,37 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Capture serialization to WAV, TDMS and CSV.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <sstream>
+#include <vector>
+
+#include "bench.h"
+#include "common/rp_formatter.h"
+
+#define FORMATTER_SAMPLES 16384
+#define FORMATTER_RATE 125000000
+
+auto benchFormatter(CBench& _bench) -> void {
+    using namespace rp_formatter_api;
+
+    std::vector<float> ch1(FORMATTER_SAMPLES), ch2(FORMATTER_SAMPLES);
+    syntheticSignal(ch1.data(), FORMATTER_SAMPLES, 1);
+    syntheticSignal(ch2.data(), FORMATTER_SAMPLES, 2);
+
+    const std::pair<rp_mode_t, const char*> modes[] = {{RP_F_WAV, "wav"}, {RP_F_TDMS, "tdms"}, {RP_F_CSV, "csv"}};
+    for (auto& [mode, name] : modes) {
+        CFormatter formatter(mode, FORMATTER_RATE);
+        _bench.run("formatter", std::string(name) + "_2ch_float", 2 * FORMATTER_SAMPLES, [&]() {
+            std::stringstream memory;
+            formatter.resetWriter();
+            formatter.setChannel(RP_F_CH1, ch1.data(), FORMATTER_SAMPLES);
+            formatter.setChannel(RP_F_CH2, ch2.data(), FORMATTER_SAMPLES);
+            formatter.writeToStream(&memory);
+            formatter.clearBuffer();
+            doNotOptimize(memory.tellp());
+        });
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Logic analyzer protocol decoding of RLE captures.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <vector>
+
+#include "bench.h"
+#include "la/rp_la.h"
+
+#define LA_ACQ_SPEED 1000000
+#define LA_UART_BAUDRATE 115200
+
+namespace {
+
+// RLE capture as produced by the LA: pairs of [sample count - 1, line state], runs up to 256 samples
+auto appendRun(std::vector<uint8_t>& _rle, uint8_t _state, uint32_t _samples) -> void {
+    while (_samples) {
+        uint32_t n = _samples > 256 ? 256 : _samples;
+        _rle.push_back(n - 1);
+        _rle.push_back(_state);
+        _samples -= n;
+    }
+}
+
+// UART 8N1 frames on line 1 (bit 0), idle high, one byte time of idle between frames
+auto makeUARTCapture(size_t _bytes) -> std::vector<uint8_t> {
+    std::vector<uint8_t> rle;
+    double samples_per_bit = (double)LA_ACQ_SPEED / LA_UART_BAUDRATE;
+    double t = 0;
+    uint64_t emitted = 0;
+    auto line = [&](uint8_t _state, uint32_t _bits) {
+        t += samples_per_bit * _bits;
+        auto end = (uint64_t)(t + 0.5);
+        appendRun(rle, _state, end - emitted);
+        emitted = end;
+    };
+    uint32_t lcg = 12345;
+    line(1, 10);
+    for (size_t i = 0; i < _bytes; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        uint8_t byte = lcg >> 24;
+        line(0, 1);
+        for (int b = 0; b < 8; b++)
+            line((byte >> b) & 1, 1);
+        line(1, 2 + 10);
+    }
+    return rle;
+}
+
+}  // namespace
+
+auto benchLA(CBench& _bench) -> void {
+    const std::string settings =
+        "{\"acq_speed\":1000000,\"baudrate\":115200,\"bitOrder\":0,\"invert\":0,\"num_data_bits\":8,\"num_stop_bits\":2,\"parity\":0,\"rx\":1,\"tx\":0}";
+    for (size_t bytes : {64, 1024}) {
+        auto rle = makeUARTCapture(bytes);
+        rp_la::CLAController la;
+        _bench.run("la", "decode_uart_" + std::to_string(bytes) + "B", rle.size() / 2, [&]() {
+            auto packets = la.decodeNP(rp_la::LA_DECODER_UART, settings, rle.data(), rle.size());
+            doNotOptimize(packets.size());
+        });
+    }
+}
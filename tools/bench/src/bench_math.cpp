@@ -0,0 +1,84 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite. Vector kernels from rp_math against plain C loops.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <float.h>
+#include <vector>
+
+#include "bench.h"
+#include "math/rp_math.h"
+
+auto benchMath(CBench& _bench) -> void {
+    for (size_t size : {1024, 16384, 262144}) {
+        auto suffix = "/" + std::to_string(size);
+        std::vector<float> a(size), b(size), dst(size);
+        syntheticSignal(a.data(), size, 1);
+        syntheticSignal(b.data(), size, 2);
+        for (auto& v : b)
+            v += 2.0f;  // Keep divisors away from zero
+
+        _bench.run("math", "multiply_float_neon" + suffix, size, [&]() {
+            multiply_arrays_float_neon(dst.data(), a.data(), b.data(), size);
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "multiply_float_scalar" + suffix, size, [&]() {
+            for (size_t i = 0; i < size; i++)
+                dst[i] = a[i] * b[i];
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "add_float_neon" + suffix, size, [&]() {
+            add_arrays_float_neon(dst.data(), a.data(), b.data(), size);
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "divide_float_neon" + suffix, size, [&]() {
+            divide_arrays_float_neon(dst.data(), a.data(), b.data(), size);
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "divide_float_scalar" + suffix, size, [&]() {
+            for (size_t i = 0; i < size; i++)
+                dst[i] = a[i] / b[i];
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "scale_float_neon" + suffix, size, [&]() {
+            multiply_array_by_scalar_float_neon(dst.data(), a.data(), 1.5f, size);
+            doNotOptimize(dst[0]);
+        });
+        _bench.run("math", "memcpy_neon" + suffix, size * sizeof(float), [&]() {
+            memcpy_neon(dst.data(), a.data(), size * sizeof(float));
+            doNotOptimize(dst[0]);
+        });
+
+        _bench.run("math", "minmax_sum_neon" + suffix, size, [&]() {
+            float min, max;
+            double sum;
+            minmax_sum_float_neon(a.data(), size, &min, &max, &sum);
+            doNotOptimize(sum);
+        });
+        _bench.run("math", "minmax_sum_scalar" + suffix, size, [&]() {
+            float min = FLT_MAX, max = -FLT_MAX;
+            double sum = 0;
+            for (size_t i = 0; i < size; i++) {
+                min = a[i] < min ? a[i] : min;
+                max = a[i] > max ? a[i] : max;
+                sum += a[i];
+            }
+            doNotOptimize(min);
+            doNotOptimize(max);
+            doNotOptimize(sum);
+        });
+
+        // Decimation to 1024 points, the typical screen width
+        size_t block = size / 1024;
+        std::vector<float> pmin(1024), pmax(1024);
+        _bench.run("math", "peak_detect_neon" + suffix, size, [&]() {
+            double sum = 0;
+            for (size_t i = 0; i < 1024; i++) {
+                minmax_sum_float_neon(a.data() + i * block, block, &pmin[i], &pmax[i], &sum);
+            }
+            doNotOptimize(pmin[0]);
+        });
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ *
+ * @brief Red Pitaya benchmark suite.
+ *
+ * Runs micro and macro benchmarks of the DSP, math, acquisition, logic analyzer and formatter
+ * code paths and writes the results as JSON. Two result files can be compared with compare.py.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "bench.h"
+#include "common/version.h"
+
+static struct option long_options[] = {{"filter", required_argument, 0, 'f'},
+                                       {"out", required_argument, 0, 'o'},
+                                       {"min-time", required_argument, 0, 't'},
+                                       {"runs", required_argument, 0, 'r'},
+                                       {"list", no_argument, 0, 'l'},
+                                       {"version", no_argument, 0, 'v'},
+                                       {"help", no_argument, 0, 'h'},
+                                       {0, 0, 0, 0}};
+
+static constexpr char g_format[] =
+    "\n"
+    "Usage: %s [OPTION]...\n"
+    "\n"
+    "  --filter=s      -f s  Run only benchmarks whose \"group/name\" contains s.\n"
+    "  --out=file      -o f  Write JSON results to file (default: stdout).\n"
+    "  --min-time=ms   -t ms Timed duration of one benchmark over all runs (default: 200).\n"
+    "  --runs=n        -r n  Number of runs, the median is reported (default: 5).\n"
+    "  --list          -l    List benchmarks without running them.\n"
+    "  --version       -v    Print version info.\n"
+    "  --help          -h    Print this message.\n"
+    "\n"
+    "Groups: dsp, math, acq, la, formatter.\n"
+    "Acquisition benchmarks need a board, or RP_EMULATION=1 on a host machine.\n"
+    "\n";
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string out;
+    int ch;
+    while ((ch = getopt_long(argc, argv, "f:o:t:r:lvh", long_options, NULL)) != -1) {
+        switch (ch) {
+            case 'f':
+                options.filter = optarg;
+                break;
+            case 'o':
+                out = optarg;
+                break;
+            case 't':
+                options.min_time_ms = atof(optarg);
+                if (options.min_time_ms <= 0) {
+                    fprintf(stderr, "Invalid minimum time: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                options.runs = atoi(optarg);
+                if (options.runs == 0) {
+                    fprintf(stderr, "Invalid number of runs: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'l':
+                options.list_only = true;
+                break;
+            case 'v':
+                fprintf(stdout, "%s version %s-%s\n", argv[0], VERSION_STR, REVISION_STR);
+                return EXIT_SUCCESS;
+            case 'h':
+                fprintf(stdout, g_format, argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                fprintf(stderr, g_format, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    CBench bench(options);
+    benchMath(bench);
+    benchDSP(bench);
+    benchFormatter(bench);
+    benchLA(bench);
+    benchAcq(bench);
+    benchConvert(bench);
+
+    if (options.list_only)
+        return EXIT_SUCCESS;
+    return bench.writeJSON(out) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
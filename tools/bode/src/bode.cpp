@@ -66,7 +66,8 @@ void usage() {
         "\tprobe              Probe value [1-1000].\n"
         "\t-calib             Starts calibration mode. The calibration values will be saved in:" BA_CALIB_FILENAME
         "\n"
-        "Output:\tfrequency [Hz], phase [deg], amplitude [dB]\n";
+        "Output:\tfrequency [Hz], phase [deg], amplitude [dB]\n"
+        "\tThe sweep rate in points/s is printed to stderr at the end.\n";
 
     fprintf(stderr, format, VERSION_STR, __TIMESTAMP__, g_argv0, g_argv0);
 }
@@ -201,12 +202,8 @@ int main(int argc, char* argv[]) {
     }
 
     /** Parameters initialization and calculation */
-    //double frequency_step;
-    double a, b, c;
     uint32_t periods_number = 8;  // max 20
 
-    rp_ba_buffer_t buffer(ADC_BUFFER_SIZE);
-
     /* We try to open a data file */
     FILE* try_open = fopen("/tmp/bode_data/data_frequency", "w");
 
@@ -251,68 +248,45 @@ int main(int argc, char* argv[]) {
         rpApp_BaReadCalibration();
     }
 
-    int cur_step = 0;
-    float freq_step = 0;
-
-    if (scale_type) {
-        b = log10f(end_frequency);
-        a = log10f(start_frequency);
-        c = (b - a) / (steps - 1);
-    } else {
-        freq_step = (static_cast<float>(end_frequency) - static_cast<float>(start_frequency)) / (steps - 1);
-    }
+    rp_ba_sweep_settings_t settings;
+    settings.mode = RP_BA_LOGIC_TRAP;
+    settings.amplitude = ampl;
+    settings.dc_bias = DC_bias;
+    settings.periods = periods_number;
+    settings.averaging = averaging_num;
+    settings.probe = probe;
+    settings.input_threshold = 0;
 
-    // fprintf(stderr, "a %f b %f c %f\n", a, b, c);
+    auto freqs = rpApp_BaSweepFrequencies(start_frequency, end_frequency, steps, scale_type);
+    float points_per_sec = 0;
 
-    float old_freq = start_frequency;
-    //float old_steps = steps;
     rp_Init();
     rpApp_BaInit();
-    rpApp_BaSafeThreadAcqPrepare();
     printf("Frequency [Hz]         Amplitude [dB]        Phase [deg]\n");
-    while (steps > 0) {
-
-        float amplitude = 0, phase_out = 0;
-        float current_freq = 0.;
-        //float next_freq = 0.;
-
-        if (scale_type) {
-            // Log
-            current_freq = pow(10.f, c * cur_step + a);
-            //   next_freq = pow(10.f, c * (cur_step + 1) + a);
-        } else {
-            // Linear
-            current_freq = static_cast<float>(old_freq) + freq_step * cur_step;
-            //  next_freq = static_cast<float>(old_freq) + freq_step * (cur_step + 1);
-        }
-
-        for (unsigned int i = 0; i < averaging_num; ++i) {
-            float ampl_out = 0;
-
-            if (rpApp_BaGetAmplPhase(RP_BA_LOGIC_TRAP, ampl, DC_bias, periods_number, buffer, &ampl_out, &phase_out, current_freq, probe, 0) == RP_EOOR)  // isnan && isinf
+    auto ret = rpApp_BaSweep(
+        settings, freqs,
+        [&](const rp_ba_sweep_point_t& point) {
+            if (point.status == RP_EOOR)  // isnan && isinf
+                return true;
+            float calib_ampl = rpApp_BaCalibGain(point.freq, point.amplitude);
+            float calib_phase = rpApp_BaCalibPhase(point.freq, point.phase);
+            fprintf(file_frequency, "%.2f\n", point.freq);
+            fprintf(file_amplitude, "%.10f\n", calib_ampl);
+            fprintf(file_phase, "%.10f\n", calib_phase);
+
+            if (calibMode)  // save data in calibration mode
             {
-                --steps;
-                continue;
+                rpApp_BaWriteCalib(point.freq, point.amplitude, point.phase);
             }
-            amplitude += ampl_out;
-        }
-        amplitude /= averaging_num;
-
-        --steps;
-        cur_step++;
-        float calib_ampl = rpApp_BaCalibGain(current_freq, amplitude);
-        float calib_phase = rpApp_BaCalibPhase(current_freq, phase_out);
-        fprintf(file_frequency, "%.2f\n", current_freq);
-        fprintf(file_amplitude, "%.10f\n", calib_ampl);
-        fprintf(file_phase, "%.10f\n", calib_phase);
-
-        if (calibMode)  // save data in calibration mode
-        {
-            rpApp_BaWriteCalib(current_freq, amplitude, phase_out);
-        }
 
-        printf("%.2f    %.10f    %.10f\n", current_freq, calib_ampl, calib_phase);
+            printf("%.2f    %.10f    %.10f\n", point.freq, calib_ampl, calib_phase);
+            return true;
+        },
+        &points_per_sec);
+    if (ret != RP_OK) {
+        fprintf(stderr, "Sweep failed: %d\n", ret);
     }
+    fprintf(stderr, "%zu points, %.1f points/s\n", freqs.size(), points_per_sec);
 
     rp_Release();
     rpApp_BaRelease();
@@ -56,11 +56,14 @@ void usage() {
     const char* format =
         "LCR meter version %s, compiled at %s\n"
         "\n"
-        "Usage:\t%s freq r_shunt [-v]\n"
+        "Usage:\t%s freq r_shunt [-v] [-l tau] [-r rate] [-n count]\n"
         "\n"
         "\tfreq               Signal frequency used for measurement in Hz.\n"
         "\tr_shunt            Shunt resistor value in Ohms Ω [ 10, 100, 1000, 10000, 100000, 1000000 ]. If set to 0, Automatic ranging is used.\n"
         "\t-v                 Verbose mode\n"
+        "\t-l tau             Continuous lock-in mode with a time constant of tau seconds [0 - 100].\n"
+        "\t-r rate            Lock-in readings per second [0.1 - 1000]. Default 10.\n"
+        "\t-n count           Number of lock-in readings, 0 runs until interrupted. Default 10.\n"
         "\n"
         "Output:\tFrequency [Hz], |Z|, Ohm [Ω], P [deg], Ls [H], Cs [F], Rs [Ω], Lp [H], Cp [F], Rp [Ω], Q, D, Xs [H], Gp [S], Bp [S], |Y| [S], -P [deg]\n";
 
@@ -95,11 +98,76 @@ char GetPrefix(float value, float* new_value) {
     return 0;
 }
 
+void printData(lcr_main_data_t* data, int freq, bool verb_mode) {
+    char pref = 0;
+    float modify_value = 0;
+    /*printf(" %.1f    %.3f    %.1f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f\n",*/
+    if (!verb_mode) {
+        printf(" %.1f    %.3e    %.2f    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.2f\n",
+
+               /*"Output:\tFrequency [Hz], |Z| [Ohm], P [deg], Ls [H], Cs [F], Rs [Ohm], Lp [H], Cp [F], Rp [Ohm], Q, D, Xs [H], Gp [S], Bp [S], |Y| [S], -P [deg]\n";*/
+
+               (float)freq,
+               data->lcr_amplitude,
+               data->lcr_phase,
+               data->lcr_L_s,     // L_s[ i ],
+               data->lcr_C_s,     // C_s[ i ],
+               data->lcr_R_s,     // R_s[ i ],
+               data->lcr_L_p,     // L_p[ i ],
+               data->lcr_C_p,     // C_p[ i ],
+               data->lcr_R_p,     // R_p[ i ],
+               data->lcr_Q_s,     // Q[ i ],
+               data->lcr_D_s,     // D[ i ],
+               data->lcr_X_s,     // X_s[ i ],
+               data->lcr_G_p,     // G_p[ i ],
+               data->lcr_B_p,     // B_p[ i ],
+               data->lcr_Y_abs,   // Y_abs[ i ],
+               data->lcr_Phase_Y  // PhaseY[ i ]
+        );
+    } else {
+        printf("Frequency\t%d Hz\n", freq);
+        pref = GetPrefix(data->lcr_amplitude, &modify_value);
+        printf("Z\t%lf %cOhm Ω\n", modify_value, pref);
+
+        printf("Phase\t%lf deg\n", data->lcr_phase);
+
+        pref = GetPrefix(data->lcr_L_s, &modify_value);
+        printf("L(s)\t%lf %cH\n", modify_value, pref);
+
+        pref = GetPrefix(data->lcr_C_s, &modify_value);
+        printf("C(s)\t%lf %cF\n", modify_value, pref);
+
+        pref = GetPrefix(data->lcr_R_s, &modify_value);
+        printf("R(s)\t%lf %cOmh Ω\n", modify_value, pref);
+
+        pref = GetPrefix(data->lcr_L_p, &modify_value);
+        printf("L(p)\t%lf %cH\n", modify_value, pref);
+
+        pref = GetPrefix(data->lcr_C_p, &modify_value);
+        printf("C(p)\t%lf %cF\n", modify_value, pref);
+
+        pref = GetPrefix(data->lcr_R_p, &modify_value);
+        printf("R(p)\t%lf %cOmh Ω\n", modify_value, pref);
+
+        printf("Q\t%lf\n", data->lcr_Q_s);
+        printf("D\t%lf\n", data->lcr_D_s);
+        printf("X_s\t%lf\n", data->lcr_X_s);
+        printf("G_p\t%lf\n", data->lcr_G_p);
+        printf("B_p\t%lf\n", data->lcr_B_p);
+        printf("|Y|\t%lf\n", data->lcr_Y_abs);
+        printf("-P_Y\t%lf deg\n", data->lcr_Phase_Y);
+    }
+}
+
 int main(int argc, char* argv[]) {
 
     int freq = 0;
     int r_shunt = 0;
     bool verb_mode = false;
+    bool lock_in = false;
+    float lock_in_tau = 0.1;
+    float lock_in_rate = 10;
+    int lock_in_count = 10;
     /** Set program name */
     g_argv0 = argv[0];
 
@@ -129,12 +197,29 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
-    if (argc >= 4) {
-        if (strcmp(argv[3], "-v") == 0) {
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
             verb_mode = true;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lock_in = true;
+            lock_in_tau = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            lock_in_rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            lock_in_count = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Invalid argument %s!\n\n", argv[i]);
+            usage();
+            return -1;
         }
     }
 
+    if (lock_in && (lcrApp_LcrSetLockInTimeConstant(lock_in_tau) != RP_LCR_OK || lcrApp_LcrSetLockInRate(lock_in_rate) != RP_LCR_OK || lock_in_count < 0)) {
+        fprintf(stderr, "Invalid lock-in settings!\n\n");
+        usage();
+        return -1;
+    }
+
     lcrApp_lcrInit();
     auto Connected = lcrApp_LcrCheckExtensionModuleConnection(true) == RP_OK;
 
@@ -148,6 +233,7 @@ int main(int argc, char* argv[]) {
         lcrApp_LcrSetShuntIsAuto(false);
         r_shunt == RP_LCR_S_NOT_INIT ? lcrApp_LcrSetShuntIsAuto(true) : lcrApp_LcrSetShunt((lcr_shunt_t)r_shunt);
         lcrApp_LcrSetFrequency(freq);
+        lcrApp_LcrSetLockIn(lock_in);
         lcrApp_GenRun();
         lcrApp_LcrRun();
         lcr_shunt_t old_shunt = RP_LCR_S_NOT_INIT;
@@ -161,65 +247,27 @@ int main(int argc, char* argv[]) {
         if (r_shunt >= 0)
             usleep(500000);
         lcrApp_LcrGetShunt(&cur_shunt);
-        lcrApp_LcrCopyParams(data);
-        /// Output
-        char pref = 0;
-        float modify_value = 0;
-        /*printf(" %.1f    %.3f    %.1f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f\n",*/
-        if (!verb_mode) {
-            printf(" %.1f    %.3e    %.2f    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.3e    %.2f\n",
-
-                   /*"Output:\tFrequency [Hz], |Z| [Ohm], P [deg], Ls [H], Cs [F], Rs [Ohm], Lp [H], Cp [F], Rp [Ohm], Q, D, Xs [H], Gp [S], Bp [S], |Y| [S], -P [deg]\n";*/
-
-                   (float)freq,
-                   data->lcr_amplitude,
-                   data->lcr_phase,
-                   data->lcr_L_s,     // L_s[ i ],
-                   data->lcr_C_s,     // C_s[ i ],
-                   data->lcr_R_s,     // R_s[ i ],
-                   data->lcr_L_p,     // L_p[ i ],
-                   data->lcr_C_p,     // C_p[ i ],
-                   data->lcr_R_p,     // R_p[ i ],
-                   data->lcr_Q_s,     // Q[ i ],
-                   data->lcr_D_s,     // D[ i ],
-                   data->lcr_X_s,     // X_s[ i ],
-                   data->lcr_G_p,     // G_p[ i ],
-                   data->lcr_B_p,     // B_p[ i ],
-                   data->lcr_Y_abs,   // Y_abs[ i ],
-                   data->lcr_Phase_Y  // PhaseY[ i ]
-            );
+        if (!lock_in) {
+            lcrApp_LcrCopyParams(data);
+            printData(data, freq, verb_mode);
         } else {
-            printf("Frequency\t%d Hz\n", freq);
-            pref = GetPrefix(data->lcr_amplitude, &modify_value);
-            printf("Z\t%lf %cOhm Ω\n", modify_value, pref);
-
-            printf("Phase\t%lf deg\n", data->lcr_phase);
-
-            pref = GetPrefix(data->lcr_L_s, &modify_value);
-            printf("L(s)\t%lf %cH\n", modify_value, pref);
-
-            pref = GetPrefix(data->lcr_C_s, &modify_value);
-            printf("C(s)\t%lf %cF\n", modify_value, pref);
-
-            pref = GetPrefix(data->lcr_R_s, &modify_value);
-            printf("R(s)\t%lf %cOmh Ω\n", modify_value, pref);
-
-            pref = GetPrefix(data->lcr_L_p, &modify_value);
-            printf("L(p)\t%lf %cH\n", modify_value, pref);
-
-            pref = GetPrefix(data->lcr_C_p, &modify_value);
-            printf("C(p)\t%lf %cF\n", modify_value, pref);
-
-            pref = GetPrefix(data->lcr_R_p, &modify_value);
-            printf("R(p)\t%lf %cOmh Ω\n", modify_value, pref);
-
-            printf("Q\t%lf\n", data->lcr_Q_s);
-            printf("D\t%lf\n", data->lcr_D_s);
-            printf("X_s\t%lf\n", data->lcr_X_s);
-            printf("G_p\t%lf\n", data->lcr_G_p);
-            printf("B_p\t%lf\n", data->lcr_B_p);
-            printf("|Y|\t%lf\n", data->lcr_Y_abs);
-            printf("-P_Y\t%lf deg\n", data->lcr_Phase_Y);
+            // One line per lock-in reading
+            uint64_t last = 0;
+            uint64_t dropped = 0;
+            lcrApp_LcrGetLockInStat(&last, &dropped);
+            for (int i = 0; lock_in_count == 0 || i < lock_in_count;) {
+                uint64_t outputs = 0;
+                lcrApp_LcrGetLockInStat(&outputs, &dropped);
+                if (outputs != last && lcrApp_LcrCopyParams(data) == RP_LCR_OK) {
+                    last = outputs;
+                    printData(data, freq, verb_mode);
+                    fflush(stdout);
+                    i++;
+                }
+                usleep(1000);
+            }
+            if (verb_mode)
+                fprintf(stderr, "Readings %llu dropped blocks %llu\n", (unsigned long long)last, (unsigned long long)dropped);
         }
 
         free(data);
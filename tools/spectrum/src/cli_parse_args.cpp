@@ -17,6 +17,8 @@ std::string cli_help_string() {
            "-C, --csv: print values by columns Frequency (Hz), ch0 (dB), ch1 (dB)\n"
            "-L, --csv-limit: print values by columns Frequency (Hz), ch0 min (dB), ch0 max (dB), ch1 min (dB), ch1 max (dB)\n"
            "-W, --window: window function. Available options: [rect, hanning, hamming, blackman_harris, flat_top, kaiser_4, kaiser_8] (default: hanning)\n"
+           "-z, --zoom-center: zoom mode centre frequency in Hz, needs --zoom-dec\n"
+           "-Z, --zoom-dec: zoom mode decimation, power of two from 2 to 16384. The span is the ADC rate / decimation around the centre\n"
            "-t, --test: test mode avoids the initiating/resetting/releasing FPGA\n";
 }
 
@@ -31,6 +33,8 @@ const struct option long_opt[] = {{"help", no_argument, 0, 'h'},
                                   {"values", no_argument, 0, 'v'},
                                   {"csv-limit", no_argument, 0, 'L'},
                                   {"test", no_argument, 0, 't'},
+                                  {"zoom-center", required_argument, 0, 'z'},
+                                  {"zoom-dec", required_argument, 0, 'Z'},
                                   {0, 0, 0, 0}};
 
 uint32_t getMaxFreqRate() {
@@ -48,7 +52,7 @@ bool cli_parse_args(int argc, char* const argv[], cli_args_t& out_args) {
     try {
         int short_opt;
         int option_index = 0;
-        while ((short_opt = getopt_long(argc, argv, "hm:M:c:anCLtW:v", long_opt, &option_index)) != -1) {
+        while ((short_opt = getopt_long(argc, argv, "hm:M:c:anCLtW:vz:Z:", long_opt, &option_index)) != -1) {
             switch (short_opt) {
                 case 'h':
                     args.help = true;
@@ -131,6 +135,19 @@ bool cli_parse_args(int argc, char* const argv[], cli_args_t& out_args) {
                     args.test = true;
                     break;
 
+                case 'z':
+                    args.zoom_center = std::stod(optarg);
+
+                    if (args.zoom_center <= 0. || args.zoom_center > F_MAX) {
+                        throw std::out_of_range("zoom_center");
+                    }
+
+                    break;
+
+                case 'Z':
+                    args.zoom_decimation = std::stoul(optarg);
+                    break;
+
                 // case '?':
                 default:
                     throw std::logic_error("");
@@ -146,6 +163,10 @@ bool cli_parse_args(int argc, char* const argv[], cli_args_t& out_args) {
             throw std::logic_error("--csv and --csv-limit: only one can be used");
         }
 
+        if ((args.zoom_center > 0) != (args.zoom_decimation > 0)) {
+            throw std::logic_error("--zoom-center and --zoom-dec must be used together");
+        }
+
         if (args.csv && (args.count != 1)) {
             throw std::logic_error("--count can not be used with --csv");
         }
@@ -19,6 +19,8 @@ struct cli_args_t {
     bool test = false;
     bool all_values = false;
     rp_dsp_api::window_mode_t wm = rp_dsp_api::HANNING;
+    double zoom_center = 0;    // Zoom mode when zoom_decimation is set
+    uint32_t zoom_decimation = 0;
 };
 
 std::string cli_help_string();
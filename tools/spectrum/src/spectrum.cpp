@@ -11,6 +11,8 @@
 #include "common/profiler.h"
 #include "common/version.h"
 #include "math/rp_dsp.h"
+#include "math/rp_math.h"
+#include "math/rp_zoom_fft.h"
 #include "rp.h"
 #include "rp_hw-profiles.h"
 #include "rp_hw_calib.h"
@@ -18,6 +20,7 @@
 #include "cli_parse_args.h"
 
 #define NUM_SIGNAL_PERIODS 16
+#define ZOOM_READ_CHUNK 65536
 
 uint8_t getADCChannels() {
     uint8_t c = 0;
@@ -47,6 +50,70 @@ static void quit_handler(int) {
     g_quit_requested = 1;
 }
 
+// Zoom mode: one AXI capture at full rate per channel, mixed down and decimated into m_fft
+static bool zoom_acquire(rp_dsp_api::CZoomFFT& zoom, rp_dsp_api::data_t* data) {
+    uint32_t axi_start = 0;
+    uint32_t axi_size = 0;
+    if (rp_AcqAxiGetMemoryRegion(&axi_start, &axi_size) != RP_OK) {
+        fprintf(stderr, "Error: can't get the AXI memory region\n");
+        return false;
+    }
+    uint32_t ch_bytes = (axi_size / MAX_CHANNELS) & ~0xFu;
+    uint32_t ch_samples = ch_bytes / sizeof(int16_t);
+    uint64_t need = zoom.getInputLength();
+    if (need >= ch_samples) {
+        fprintf(stderr, "Error: zoom needs %llu samples per channel, the AXI buffer holds %u. Use a smaller decimation.\n", (unsigned long long)need, ch_samples);
+        return false;
+    }
+
+    rp_AcqStop();
+    rp_AcqAxiSetDecimationFactor(1);
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        rp_AcqAxiSetTriggerDelay((rp_channel_t)ch, need);
+        rp_AcqAxiSetBufferSamples((rp_channel_t)ch, axi_start + ch_bytes * ch, ch_samples);
+        rp_AcqAxiEnable((rp_channel_t)ch, true);
+    }
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        bool fillState = false;
+        while (!fillState && !g_quit_requested) {
+            if (rp_AcqAxiGetBufferFillState((rp_channel_t)ch, &fillState))
+                exit(1);
+        }
+    }
+    rp_AcqStop();
+
+    std::vector<float> chunk(ZOOM_READ_CHUNK);
+    auto size = zoom.getFFTSize();
+    bool ok = !g_quit_requested;
+    for (int ch = 0; ch < MAX_CHANNELS && ok; ch++) {
+        uint32_t trig_pos = 0;
+        rp_AcqAxiGetWritePointerAtTrig((rp_channel_t)ch, &trig_pos);
+        zoom.reset();
+        uint64_t read = 0;
+        while (!zoom.isReady() && read < need) {
+            uint32_t n = std::min<uint64_t>(ZOOM_READ_CHUNK, need - read);
+            if (rp_AcqAxiGetDataV((rp_channel_t)ch, trig_pos + read, &n, chunk.data()) != RP_OK || n == 0)
+                break;
+            zoom.process(chunk.data(), n);
+            read += n;
+        }
+        ok = zoom.getAmplitude(data->m_fft[ch].data()) == 0;
+        // decimate() scales by 2 / window sum of the full band window
+        multiply_array_by_scalar_float_neon(data->m_fft[ch].data(), data->m_fft[ch].data(), g_dsp.getWindowSum() / 2, size);
+    }
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        rp_AcqAxiEnable((rp_channel_t)ch, false);
+    }
+
+    zoom.getFreqVector(data->m_converted.m_freq_vector.data());
+    data->m_converted.m_data_size = size;
+    data->m_converted.m_maxFreq = 0;
+    return ok;
+}
+
 static void spectrum_worker(cli_args_t args) {
 
     int decimation = ADC_SAMPLE_RATE / (args.freq_max * 2 * NUM_SIGNAL_PERIODS);
@@ -63,6 +130,18 @@ static void spectrum_worker(cli_args_t args) {
     }
     auto data = g_dsp.createData();
 
+    rp_dsp_api::CZoomFFT zoom(g_dsp.getOutSignalMaxLength(), ADC_SAMPLE_RATE);
+    bool zoom_mode = args.zoom_decimation > 0;
+    if (zoom_mode) {
+        if (zoom.setZoom(args.zoom_center, args.zoom_decimation) != 0 || zoom.setWindow(args.wm) != 0) {
+            fprintf(stderr, "Error: wrong zoom band %.0f Hz, decimation %u\n", args.zoom_center, args.zoom_decimation);
+            delete data;
+            return;
+        }
+        // The first bins are the bottom of the zoom band, not DC
+        g_dsp.setRemoveDC(false);
+    }
+
     rp_dsp_api::cdsp_data_ch_t max_signals;
     rp_dsp_api::cdsp_data_ch_t min_signals;
     rp_dsp_api::cdsp_data_ch_t measure_signals;
@@ -108,62 +187,71 @@ static void spectrum_worker(cli_args_t args) {
     while (!g_quit_requested && ((count > 0) || is_infinity)) {
         int avg_count = args.average_for_10 ? 10 : 1;
         while (avg_count) {
-            rp_AcqSetDecimationFactor(decimation);
-            rp_AcqSetTriggerDelay(buffer_size - ADC_BUFFER_SIZE / 2.0);
-            rp_AcqStart();
-            usleep(10);
-            rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-
-            rp_acq_trig_state_t stateTrig = RP_TRIG_STATE_WAITING;
-            /* polling until data is ready */
-            while (1) {
-                if (rp_AcqGetTriggerState(&stateTrig))
-                    exit(1);
-                if (stateTrig == RP_TRIG_STATE_TRIGGERED)
+            if (zoom_mode) {
+                if (!zoom_acquire(zoom, data)) {
+                    g_quit_requested = 1;
                     break;
-            }
+                }
+                g_dsp.decimate(data, g_dsp.getOutSignalMaxLength(), g_dsp.getOutSignalMaxLength());
+                g_dsp.cnvToMetric(data, 1, args.freq_min, args.freq_max);
+            } else {
+                rp_AcqSetDecimationFactor(decimation);
+                rp_AcqSetTriggerDelay(buffer_size - ADC_BUFFER_SIZE / 2.0);
+                rp_AcqStart();
+                usleep(10);
+                rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+                rp_acq_trig_state_t stateTrig = RP_TRIG_STATE_WAITING;
+                /* polling until data is ready */
+                while (1) {
+                    if (rp_AcqGetTriggerState(&stateTrig))
+                        exit(1);
+                    if (stateTrig == RP_TRIG_STATE_TRIGGERED)
+                        break;
+                }
 
-            bool fillState = false;
-            while (!fillState) {
-                if (rp_AcqGetBufferFillState(&fillState))
-                    exit(1);
-            }
-            rp_AcqStop();
-
-            // Retrieve data and process it
-            uint32_t trig_pos;
-            rp_AcqGetWritePointerAtTrig(&trig_pos);
-            buffers_t buff;
-            buff.size = buffer_size;
-            buff.use_calib_for_volts = true;
-            for (int i = 0; i < MAX_CHANNELS; i++) {
-                buff.ch_f[i] = data->m_in[i].data();
-                buff.ch_i[i] = NULL;
-                buff.ch_d[i] = NULL;
-            }
+                bool fillState = false;
+                while (!fillState) {
+                    if (rp_AcqGetBufferFillState(&fillState))
+                        exit(1);
+                }
+                rp_AcqStop();
+
+                // Retrieve data and process it
+                uint32_t trig_pos;
+                rp_AcqGetWritePointerAtTrig(&trig_pos);
+                buffers_t buff;
+                buff.size = buffer_size;
+                buff.use_calib_for_volts = true;
+                for (int i = 0; i < MAX_CHANNELS; i++) {
+                    buff.ch_f[i] = data->m_in[i].data();
+                    buff.ch_i[i] = NULL;
+                    buff.ch_d[i] = NULL;
+                }
 
-            rp_AcqGetData(trig_pos, &buff);
+                rp_AcqGetData(trig_pos, &buff);
 
-            // float min = 1000;
-            // float max = -1000;
-            // for (int i = 0; i < buff.size; i++) {
-            //     auto z = data->m_in[0].data()[i];
-            //     if (min > z)
-            //         min = z;
-            //     if (max < z)
-            //         max = z;
-            // }
-            // WARNING("min %f max %f", min, max)
+                // float min = 1000;
+                // float max = -1000;
+                // for (int i = 0; i < buff.size; i++) {
+                //     auto z = data->m_in[0].data()[i];
+                //     if (min > z)
+                //         min = z;
+                //     if (max < z)
+                //         max = z;
+                // }
+                // WARNING("min %f max %f", min, max)
 
-            g_dsp.windowFilter(data);
+                g_dsp.windowFilter(data);
 
-            if (g_dsp.fft(data)) {
-                fprintf(stderr, "Error in g_dsp.fft\n");
-                return;
+                if (g_dsp.fft(data)) {
+                    fprintf(stderr, "Error in g_dsp.fft\n");
+                    return;
+                }
+                g_dsp.prepareFreqVector(data, decimation);
+                g_dsp.decimate(data, g_dsp.getOutSignalMaxLength(), g_dsp.getOutSignalMaxLength());
+                g_dsp.cnvToMetric(data, decimation, args.freq_min, args.freq_max);
             }
-            g_dsp.prepareFreqVector(data, decimation);
-            g_dsp.decimate(data, g_dsp.getOutSignalMaxLength(), g_dsp.getOutSignalMaxLength());
-            g_dsp.cnvToMetric(data, decimation, args.freq_min, args.freq_max);
             // Summary peak calculation
             if (peak_set) {
                 if (args.csv_limit) {